@@ -422,6 +422,9 @@ function ShowPage(WebAdmin, TemplateRequest)
 	]])
 
 	
+	Output("<li>Server</li>")
+	Output("<li><a href='" .. BaseURL .. "tickprofile'>Tick profile</a></li>")
+	
 	local AllPlugins = WebAdmin:GetPlugins()
 	for key,value in pairs(AllPlugins) do
 		local PluginWebTitle = value:GetWebTitle()
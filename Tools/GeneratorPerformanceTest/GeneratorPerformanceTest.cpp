@@ -1,7 +1,169 @@
 
+// GeneratorPerformanceTest.cpp
+
+// Measures the speed of the chunk generator, with the neighbour terrain and structure cache disabled and enabled
+
+/*
+Usage: GeneratorPerformanceTest [<radius> [<numthreads> [<seed>]]]
+Generates a square of (2 * radius + 1)^2 chunks around the origin twice, each time with a fresh generator,
+first with all the cFinishGenCache sizes set to 0, then with the default sizes, and reports the chunks per second
+of both runs. The generator itself logs the cache hit rates during the second run. The cache must not change the
+generated terrain, so a checksum of the chunks' blocks of both runs is compared, too.
+*/
+
 #include "Globals.h"
 #include "ChunkGenerator.h"
+#include "ChunkDesc.h"
+#include "inifile/iniFile.h"
+
+
+
+
+
+/** Doesn't call any plugins */
+class cNoPlugins :
+	public cChunkGenerator::cPluginInterface
+{
+	virtual void CallHookChunkGenerating(cChunkDesc & a_ChunkDesc) override {}
+	virtual void CallHookChunkGenerated (cChunkDesc & a_ChunkDesc) override {}
+} ;
+
+
+
+
+
+/** Counts the generated chunks and their checksum, then throws them away */
+class cCountingSink :
+	public cChunkGenerator::cChunkSink
+{
+public:
+	cCountingSink(void) :
+		m_NumChunks(0),
+		m_Checksum(0)
+	{
+	}
+
+	int GetNumChunks(void)
+	{
+		cCSLock Lock(m_CS);
+		return m_NumChunks;
+	}
+
+	UInt32 GetChecksum(void)
+	{
+		cCSLock Lock(m_CS);
+		return m_Checksum;
+	}
+
+protected:
+	cCriticalSection m_CS;
+	int m_NumChunks;
+
+	/** Sum of the checksums of all the chunks, so that it doesn't depend on the order in which they are generated */
+	UInt32 m_Checksum;
+
+	virtual void OnChunkGenerated(cChunkDesc & a_ChunkDesc) override
+	{
+		// FNV-1a over the chunk coords, blocktypes and metas:
+		UInt32 Hash = 2166136261u;
+		Hash = (Hash ^ (UInt32)a_ChunkDesc.GetChunkX()) * 16777619u;
+		Hash = (Hash ^ (UInt32)a_ChunkDesc.GetChunkZ()) * 16777619u;
+		for (int i = 0; i < cChunkDef::NumBlocks; i++)
+		{
+			Hash = (Hash ^ a_ChunkDesc.GetBlockTypes()[i]) * 16777619u;
+			Hash = (Hash ^ a_ChunkDesc.GetBlockMetasUncompressed()[i]) * 16777619u;
+		}
+
+		cCSLock Lock(m_CS);
+		m_NumChunks += 1;
+		m_Checksum += Hash;
+	}
+
+	virtual bool IsChunkValid(int a_ChunkX, int a_ChunkZ) override { return false; }
+	virtual bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) override { return true; }
+	virtual void GetPlayerChunks(cChunkCoordsVector & a_Coords) override {}
+} ;
 
-int main(int argc, char * argv[]) {
-	cChunkGenerator Generator = cChunkGenerator();
+
+
+
+
+/** Generates all the chunks within the radius using the specified settings; returns the chunks per second and the checksum */
+static double RunTest(int a_Radius, int a_NumThreads, int a_Seed, bool a_UseCache, UInt32 & a_Checksum)
+{
+	a_Checksum = 0;
+	cIniFile Ini;
+	Ini.SetValueI("Seed", "Seed", a_Seed);
+	Ini.SetValue("Generator", "Generator", "Composable");
+	Ini.SetValueI("Generator", "NumThreads", a_NumThreads);
+	if (!a_UseCache)
+	{
+		Ini.SetValueI("Generator", "NeighborTerrainCacheSize", 0);
+		Ini.SetValueI("Generator", "TreeOverflowCacheSize", 0);
+		Ini.SetValueI("Generator", "WormNestCavesCacheSize", 0);
+		Ini.SetValueI("Generator", "MineShaftsCacheSize", 0);
+	}
+
+	cNoPlugins Plugins;
+	cCountingSink Sink;
+	cChunkGenerator Generator;
+	if (!Generator.Start(Plugins, Sink, Ini))
+	{
+		LOGERROR("Cannot start the generator");
+		return 0;
+	}
+
+	cTimer Timer;
+	Int64 Start = Timer.GetNowTime();
+	for (int x = -a_Radius; x <= a_Radius; x++)
+	{
+		for (int z = -a_Radius; z <= a_Radius; z++)
+		{
+			Generator.QueueGenerateChunk(x, 0, z);
+		}
+	}
+	while (Generator.GetQueueLength() > 0)
+	{
+		cSleep::MilliSleep(10);
+	}
+	Int64 Duration = std::max<Int64>(1, Timer.GetNowTime() - Start);
+	Generator.Stop();
+
+	double ChunksPerSec = (double)Sink.GetNumChunks() * 1000 / Duration;
+	a_Checksum = Sink.GetChecksum();
+	LOG("Cache %s: %d chunks in %d msec, %.2f ch/s, checksum %08x",
+		a_UseCache ? "enabled" : "disabled", Sink.GetNumChunks(), (int)Duration, ChunksPerSec, a_Checksum
+	);
+	return ChunksPerSec;
 }
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	cMCLogger Logger;
+
+	int Radius     = (argc > 1) ? atoi(argv[1]) : 10;
+	int NumThreads = (argc > 2) ? atoi(argv[2]) : 4;
+	int Seed       = (argc > 3) ? atoi(argv[3]) : 1234;
+
+	UInt32 UncachedChecksum, CachedChecksum;
+	double Uncached = RunTest(Radius, NumThreads, Seed, false, UncachedChecksum);
+	double Cached   = RunTest(Radius, NumThreads, Seed, true,  CachedChecksum);
+	if (Uncached > 0)
+	{
+		LOG("Speedup with the cache: %.2fx", Cached / Uncached);
+	}
+	if (UncachedChecksum != CachedChecksum)
+	{
+		LOGERROR("The cache changes the generated chunks!");
+		return 1;
+	}
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,806 @@
+
+// Pregenerator.cpp
+
+// Implements the main app entrypoint and the cPregenerator class representing the entire app
+
+/*
+Usage: Pregenerator <WorldFolder> -radius <Radius> [-center <ChunkX> <ChunkZ>] [-threads <NumThreads>]
+   or: Pregenerator <WorldFolder> -rect <MinChunkX> <MinChunkZ> <MaxChunkX> <MaxChunkZ> [-threads <NumThreads>]
+The radius and the coords are in chunks, the rectangle is inclusive. The world folder is relative to the current
+folder, same as in the server, so the pregenerator is to be run from the server's folder.
+The number of threads, used both for generating and for loading / lighting / saving, defaults to the number of
+hardware threads.
+*/
+
+#include "Globals.h"
+#include "Pregenerator.h"
+#include "Generating/ChunkDesc.h"
+#include "BlockEntities/BlockEntity.h"
+#include "Entities/Entity.h"
+#include "inifile/iniFile.h"
+
+#ifndef _WIN32
+	#include <unistd.h>
+#endif
+
+
+
+
+
+// The server sources linked into the pregenerator expect these globals, normally defined in the server's main.cpp:
+bool g_TERMINATE_EVENT_RAISED = false;
+bool g_ShouldLogCommIn = false;
+bool g_ShouldLogCommOut = false;
+
+
+
+
+
+/** Returns the number of the hardware threads available, or 1 if it cannot be determined */
+static int GetNumHardwareThreads(void)
+{
+	#ifdef _WIN32
+		SYSTEM_INFO Info;
+		GetSystemInfo(&Info);
+		int NumThreads = (int)Info.dwNumberOfProcessors;
+	#else
+		int NumThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	#endif
+	return std::max(1, NumThreads);
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	cMCLogger Logger;
+	cPregenerator Pregenerator;
+	if (!Pregenerator.Init(argc, argv))
+	{
+		return 1;
+	}
+
+	return Pregenerator.Run() ? 0 : 1;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cPregenerator::sChunk:
+
+cPregenerator::sChunk::sChunk(void) :
+	m_Light(NULL),
+	m_IsLightValid(false),
+	m_IsStored(false)
+{
+}
+
+
+
+
+
+cPregenerator::sChunk::~sChunk()
+{
+	delete m_Light;
+	for (cEntityList::iterator itr = m_Entities.begin(), end = m_Entities.end(); itr != end; ++itr)
+	{
+		delete *itr;
+	}
+	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(), end = m_BlockEntities.end(); itr != end; ++itr)
+	{
+		delete *itr;
+	}
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cPregenerator:
+
+cPregenerator::cPregenerator(void) :
+	m_MinChunkX(0),
+	m_MinChunkZ(0),
+	m_MaxChunkX(0),
+	m_MaxChunkZ(0),
+	m_IsRadial(false),
+	m_CenterX(0),
+	m_CenterZ(0),
+	m_Radius(0),
+	m_NumThreads(GetNumHardwareThreads()),
+	m_Storage(NULL),
+	m_NumFailed(0),
+	m_NumLoaded(0),
+	m_NumGenerated(0),
+	m_NumLighted(0),
+	m_NumSaved(0),
+	m_LoadTime(0),
+	m_GenerateTime(0),
+	m_LightTime(0),
+	m_SaveTime(0),
+	m_NumSkipped(0)
+{
+}
+
+
+
+
+
+cPregenerator::~cPregenerator()
+{
+	m_Generator.Stop();
+	FreeChunks();
+	delete m_Storage;
+}
+
+
+
+
+
+bool cPregenerator::Init(int argc, char ** argv)
+{
+	bool HasArea = false;
+	bool HasRect = false;
+	for (int i = 1; i < argc; i++)
+	{
+		AString Arg(argv[i]);
+		if ((NoCaseCompare(Arg, "-radius") == 0) && (i + 1 < argc))
+		{
+			m_IsRadial = true;
+			m_Radius = atoi(argv[++i]);
+			HasArea = true;
+		}
+		else if ((NoCaseCompare(Arg, "-center") == 0) && (i + 2 < argc))
+		{
+			m_CenterX = atoi(argv[++i]);
+			m_CenterZ = atoi(argv[++i]);
+		}
+		else if ((NoCaseCompare(Arg, "-rect") == 0) && (i + 4 < argc))
+		{
+			m_MinChunkX = atoi(argv[++i]);
+			m_MinChunkZ = atoi(argv[++i]);
+			m_MaxChunkX = atoi(argv[++i]);
+			m_MaxChunkZ = atoi(argv[++i]);
+			HasArea = true;
+			HasRect = true;
+		}
+		else if ((NoCaseCompare(Arg, "-threads") == 0) && (i + 1 < argc))
+		{
+			m_NumThreads = std::max(1, atoi(argv[++i]));
+		}
+		else if (m_WorldFolder.empty() && (Arg[0] != '-'))
+		{
+			m_WorldFolder = Arg;
+		}
+		else
+		{
+			LOGERROR("Unknown or incomplete parameter: \"%s\"", Arg.c_str());
+			return false;
+		}
+	}
+
+	if (m_WorldFolder.empty() || !HasArea || (m_IsRadial && HasRect) || (m_Radius < 0))
+	{
+		LOGERROR(
+			"Usage: Pregenerator <WorldFolder> -radius <Radius> [-center <ChunkX> <ChunkZ>] [-threads <NumThreads>]\n"
+			"   or: Pregenerator <WorldFolder> -rect <MinChunkX> <MinChunkZ> <MaxChunkX> <MaxChunkZ> [-threads <NumThreads>]"
+		);
+		return false;
+	}
+
+	if (m_IsRadial)
+	{
+		m_MinChunkX = m_CenterX - m_Radius;
+		m_MinChunkZ = m_CenterZ - m_Radius;
+		m_MaxChunkX = m_CenterX + m_Radius;
+		m_MaxChunkZ = m_CenterZ + m_Radius;
+	}
+	else
+	{
+		if (m_MinChunkX > m_MaxChunkX)
+		{
+			std::swap(m_MinChunkX, m_MaxChunkX);
+		}
+		if (m_MinChunkZ > m_MaxChunkZ)
+		{
+			std::swap(m_MinChunkZ, m_MaxChunkZ);
+		}
+	}
+	return true;
+}
+
+
+
+
+
+bool cPregenerator::Run(void)
+{
+	// Read the world's settings, the same way the server does:
+	AString IniFileName = m_WorldFolder + "/world.ini";
+	cIniFile IniFile;
+	if (!IniFile.ReadFile(IniFileName))
+	{
+		LOGWARNING("Cannot read world settings from \"%s\", defaults will be used.", IniFileName.c_str());
+	}
+	AString Schema = IniFile.GetValueSet("Storage", "Schema", "Default");
+	if ((NoCaseCompare(Schema, "Default") != 0) && (NoCaseCompare(Schema, "Anvil") != 0))
+	{
+		LOGERROR("The world \"%s\" uses the \"%s\" storage schema, only Anvil is supported.", m_WorldFolder.c_str(), Schema.c_str());
+		return false;
+	}
+	int CompressionFactor = IniFile.GetValueSetI("Storage", "CompressionFactor", 6);
+
+	cFile::CreateFolder(FILE_IO_PREFIX + m_WorldFolder);
+	m_Storage = new cWSSAnvil(m_WorldFolder, CompressionFactor);
+
+	// Generate using our number of threads, but don't store it in the ini file, the server has its own setting:
+	int GeneratorKeyID = IniFile.FindKey("Generator");
+	bool HasNumGenThreads = (GeneratorKeyID != cIniFile::noID) && (IniFile.FindValue(GeneratorKeyID, "NumThreads") != cIniFile::noID);
+	AString NumGenThreads = IniFile.GetValue("Generator", "NumThreads");
+	IniFile.SetValueI("Generator", "NumThreads", m_NumThreads);
+	if (!m_Generator.Start(*this, *this, IniFile))
+	{
+		LOGERROR("Cannot start the chunk generator.");
+		return false;
+	}
+	if (HasNumGenThreads)
+	{
+		IniFile.SetValue("Generator", "NumThreads", NumGenThreads);
+	}
+	else
+	{
+		IniFile.DeleteValue("Generator", "NumThreads");
+	}
+
+	// Save any changes that the defaults may have done to the ini file, so that the server uses the same seed and generator:
+	if (!IniFile.WriteFile(IniFileName))
+	{
+		LOGWARNING("Could not write world config to %s", IniFileName.c_str());
+	}
+
+	LoadProgress();
+
+	int MinRegionX = FAST_FLOOR_DIV(m_MinChunkX, REGION_SIZE);
+	int MinRegionZ = FAST_FLOOR_DIV(m_MinChunkZ, REGION_SIZE);
+	int MaxRegionX = FAST_FLOOR_DIV(m_MaxChunkX, REGION_SIZE);
+	int MaxRegionZ = FAST_FLOOR_DIV(m_MaxChunkZ, REGION_SIZE);
+	int NumRegions = (MaxRegionX - MinRegionX + 1) * (MaxRegionZ - MinRegionZ + 1);
+	LOG("Pregenerating %s in world \"%s\": %d regions, using %d generator threads and %d loading / lighting / saving threads",
+		GetAreaDescription().c_str(), m_WorldFolder.c_str(), NumRegions, m_Generator.GetNumThreads(), m_NumThreads
+	);
+
+	Int64 Start = m_Timer.GetNowTime();
+	int NumRegionsDone = 0;
+	bool res = true;
+	for (int RegionZ = MinRegionZ; RegionZ <= MaxRegionZ; RegionZ++)
+	{
+		for (int RegionX = MinRegionX; RegionX <= MaxRegionX; RegionX++)
+		{
+			NumRegionsDone += 1;
+			if (m_FinishedRegions.find(std::make_pair(RegionX, RegionZ)) != m_FinishedRegions.end())
+			{
+				LOG("Region [%d, %d] (%d of %d) already finished, skipping", RegionX, RegionZ, NumRegionsDone, NumRegions);
+				continue;
+			}
+			if (!ProcessRegion(RegionX, RegionZ))
+			{
+				// Keep going, the region is not recorded as finished, so it will be retried on the next run
+				LOGWARNING("Region [%d, %d] failed, it will be retried on the next run", RegionX, RegionZ);
+				res = false;
+				continue;
+			}
+			m_FinishedRegions.insert(std::make_pair(RegionX, RegionZ));
+			SaveProgress();
+			LOG("Region [%d, %d] (%d of %d) finished", RegionX, RegionZ, NumRegionsDone, NumRegions);
+		}  // for RegionX
+	}  // for RegionZ
+	Int64 Duration = std::max<Int64>(1, m_Timer.GetNowTime() - Start);
+
+	m_Generator.Stop();
+
+	LOG("Pregenerated %d chunks in %.1f sec, %.2f ch/s overall; %d chunks were already stored and have been kept",
+		m_NumSaved, (double)Duration / 1000, (double)m_NumSaved * 1000 / Duration, m_NumSkipped
+	);
+	LogStageSpeed("Reading the stored neighbors", m_NumLoaded, m_LoadTime);
+	LogStageSpeed("Generating (including the neighbors needed for lighting)", m_NumGenerated, m_GenerateTime);
+	LogStageSpeed("Lighting", m_NumLighted, m_LightTime);
+	LogStageSpeed("Saving",   m_NumSaved,   m_SaveTime);
+	return res;
+}
+
+
+
+
+
+bool cPregenerator::IsChunkInArea(int a_ChunkX, int a_ChunkZ) const
+{
+	if ((a_ChunkX < m_MinChunkX) || (a_ChunkX > m_MaxChunkX) || (a_ChunkZ < m_MinChunkZ) || (a_ChunkZ > m_MaxChunkZ))
+	{
+		return false;
+	}
+	if (!m_IsRadial)
+	{
+		return true;
+	}
+	int DiffX = a_ChunkX - m_CenterX;
+	int DiffZ = a_ChunkZ - m_CenterZ;
+	return (DiffX * DiffX + DiffZ * DiffZ <= m_Radius * m_Radius);
+}
+
+
+
+
+
+AString cPregenerator::GetAreaDescription(void) const
+{
+	if (m_IsRadial)
+	{
+		return Printf("radius %d around chunk [%d, %d]", m_Radius, m_CenterX, m_CenterZ);
+	}
+	return Printf("rectangle from chunk [%d, %d] to chunk [%d, %d]", m_MinChunkX, m_MinChunkZ, m_MaxChunkX, m_MaxChunkZ);
+}
+
+
+
+
+
+AString cPregenerator::GetProgressFileName(void) const
+{
+	return m_WorldFolder + "/pregenerator.progress";
+}
+
+
+
+
+
+void cPregenerator::LoadProgress(void)
+{
+	// The first line is the area description, each following line has the coords of a single finished region:
+	AString FileName = GetProgressFileName();
+	if (!cFile::Exists(FileName))
+	{
+		return;
+	}
+	AStringVector Lines = StringSplitAndTrim(cFile::ReadWholeFile(FileName), "\n");
+	if (Lines.empty() || (Lines[0] != GetAreaDescription()))
+	{
+		LOG("The progress file %s is for a different area, starting anew", FileName.c_str());
+		return;
+	}
+	for (AStringVector::const_iterator itr = Lines.begin() + 1, end = Lines.end(); itr != end; ++itr)
+	{
+		AStringVector Coords = StringSplit(*itr, " ");
+		if (Coords.size() != 2)
+		{
+			continue;
+		}
+		m_FinishedRegions.insert(std::make_pair(atoi(Coords[0].c_str()), atoi(Coords[1].c_str())));
+	}
+	LOG("Resuming, %u regions already finished", (unsigned)m_FinishedRegions.size());
+}
+
+
+
+
+
+void cPregenerator::SaveProgress(void)
+{
+	AString Data = GetAreaDescription() + "\n";
+	for (std::set<std::pair<int, int> >::const_iterator itr = m_FinishedRegions.begin(), end = m_FinishedRegions.end(); itr != end; ++itr)
+	{
+		AppendPrintf(Data, "%d %d\n", itr->first, itr->second);
+	}
+
+	cFile f;
+	if (!f.Open(GetProgressFileName(), cFile::fmWrite) || (f.Write(Data.data(), (int)Data.size()) != (int)Data.size()))
+	{
+		LOGWARNING("Cannot write the progress file %s", GetProgressFileName().c_str());
+	}
+}
+
+
+
+
+
+bool cPregenerator::ProcessRegion(int a_RegionX, int a_RegionZ)
+{
+	// Collect the chunks of the area in this region that are not stored yet, and all their neighbors for the lighting:
+	cChunkCoordsVector RegionChunks;
+	cChunkCoordsSet Neighbors;
+	int NumStored = 0;
+	int BaseX = a_RegionX * REGION_SIZE;
+	int BaseZ = a_RegionZ * REGION_SIZE;
+	for (int z = BaseZ; z < BaseZ + REGION_SIZE; z++)
+	{
+		for (int x = BaseX; x < BaseX + REGION_SIZE; x++)
+		{
+			if (!IsChunkInArea(x, z))
+			{
+				continue;
+			}
+			if (m_Storage->HasChunk(cChunkCoords(x, 0, z)))
+			{
+				// Already stored by the server or by an earlier run, it must not be overwritten
+				NumStored += 1;
+				continue;
+			}
+			RegionChunks.push_back(cChunkCoords(x, 0, z));
+			for (int NeighborZ = z - 1; NeighborZ <= z + 1; NeighborZ++)
+			{
+				for (int NeighborX = x - 1; NeighborX <= x + 1; NeighborX++)
+				{
+					Neighbors.insert(cChunkCoords(NeighborX, 0, NeighborZ));
+				}
+			}
+		}  // for x
+	}  // for z
+	m_NumSkipped += NumStored;
+	if (RegionChunks.empty())
+	{
+		return true;
+	}
+
+	// The neighbors that are stored are read from the storage:
+	cChunkCoordsVector ToLoad;
+	for (cChunkCoordsSet::const_iterator itr = Neighbors.begin(), end = Neighbors.end(); itr != end; ++itr)
+	{
+		if (m_Storage->HasChunk(*itr))
+		{
+			ToLoad.push_back(*itr);
+		}
+	}
+	Int64 Start = m_Timer.GetNowTime();
+	RunStage(stLoad, ToLoad);
+	Int64 Loaded = m_Timer.GetNowTime();
+
+	// Generate the rest, including the stored neighbors that couldn't be read:
+	cChunkCoordsSet ToGenerate;
+	for (cChunkCoordsSet::const_iterator itr = Neighbors.begin(), end = Neighbors.end(); itr != end; ++itr)
+	{
+		if (GetChunk(itr->m_ChunkX, itr->m_ChunkZ) == NULL)
+		{
+			ToGenerate.insert(*itr);
+		}
+	}
+	GenerateChunks(ToGenerate);
+	Int64 Generated = m_Timer.GetNowTime();
+	for (cChunkCoordsSet::const_iterator itr = ToGenerate.begin(), end = ToGenerate.end(); itr != end; ++itr)
+	{
+		if (GetChunk(itr->m_ChunkX, itr->m_ChunkZ) == NULL)
+		{
+			LOGWARNING("Chunk [%d, %d] has not been generated", itr->m_ChunkX, itr->m_ChunkZ);
+			FreeChunks();
+			return false;
+		}
+	}
+
+	RunStage(stLight, RegionChunks);
+	Int64 Lighted = m_Timer.GetNowTime();
+	bool res = (m_NumFailed == 0);
+	if (res)
+	{
+		RunStage(stSave, RegionChunks);
+		res = (m_NumFailed == 0);
+	}
+	Int64 Saved = m_Timer.GetNowTime();
+	FreeChunks();
+
+	m_NumLoaded    += (int)(Neighbors.size() - ToGenerate.size());
+	m_NumGenerated += (int)ToGenerate.size();
+	m_LoadTime     += Loaded - Start;
+	m_GenerateTime += Generated - Loaded;
+	if (res)
+	{
+		m_NumLighted += (int)RegionChunks.size();
+		m_NumSaved   += (int)RegionChunks.size();
+		m_LightTime  += Lighted - Generated;
+		m_SaveTime   += Saved - Lighted;
+	}
+	LOGD("Region [%d, %d]: %d chunks already stored; read %u and generated %u chunks in %d + %d msec, lighted and saved %u chunks in %d + %d msec",
+		a_RegionX, a_RegionZ, NumStored,
+		(unsigned)(Neighbors.size() - ToGenerate.size()), (unsigned)ToGenerate.size(), (int)(Loaded - Start), (int)(Generated - Loaded),
+		(unsigned)RegionChunks.size(), (int)(Lighted - Generated), (int)(Saved - Lighted)
+	);
+	return res;
+}
+
+
+
+
+
+void cPregenerator::GenerateChunks(const cChunkCoordsSet & a_Chunks)
+{
+	for (cChunkCoordsSet::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		while (m_Generator.GetQueueLength() >= MAX_GENERATOR_QUEUE)
+		{
+			cSleep::MilliSleep(1);
+		}
+		m_Generator.QueueGenerateChunk(itr->m_ChunkX, 0, itr->m_ChunkZ);
+	}
+	m_Generator.WaitForQueueEmpty();
+}
+
+
+
+
+
+void cPregenerator::RunStage(eStage a_Stage, const cChunkCoordsVector & a_Chunks)
+{
+	{
+		cCSLock Lock(m_CS);
+		m_Queue = a_Chunks;
+		m_NumFailed = 0;
+	}
+
+	// Start the processing threads:
+	cThreads Threads;
+	for (int i = 0; i < m_NumThreads; i++)
+	{
+		cThread * Thread = new cThread(*this, a_Stage);
+		Threads.push_back(Thread);
+		Thread->Start();
+	}
+
+	// Wait for all the threads to finish:
+	while (!Threads.empty())
+	{
+		Threads.front()->Wait();
+		delete Threads.front();
+		Threads.pop_front();
+	}
+}
+
+
+
+
+
+cPregenerator::sChunk * cPregenerator::GetChunk(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CS);
+	cChunks::iterator itr = m_Chunks.find(cChunkCoords(a_ChunkX, 0, a_ChunkZ));
+	return (itr == m_Chunks.end()) ? NULL : itr->second;
+}
+
+
+
+
+
+bool cPregenerator::GetNextChunk(cChunkCoords & a_Coords)
+{
+	cCSLock Lock(m_CS);
+	if (m_Queue.empty())
+	{
+		return false;
+	}
+	a_Coords = m_Queue.back();
+	m_Queue.pop_back();
+	return true;
+}
+
+
+
+
+
+void cPregenerator::FreeChunks(void)
+{
+	cCSLock Lock(m_CS);
+	for (cChunks::iterator itr = m_Chunks.begin(), end = m_Chunks.end(); itr != end; ++itr)
+	{
+		delete itr->second;
+	}
+	m_Chunks.clear();
+}
+
+
+
+
+
+void cPregenerator::LogStageSpeed(const char * a_StageName, int a_NumChunks, Int64 a_Time)
+{
+	LOG("  %s: %d chunks in %.1f sec, %.2f ch/s",
+		a_StageName, a_NumChunks, (double)a_Time / 1000, (double)a_NumChunks * 1000 / std::max<Int64>(1, a_Time)
+	);
+}
+
+
+
+
+
+void cPregenerator::OnChunkGenerated(cChunkDesc & a_ChunkDesc)
+{
+	sChunk * Chunk = new sChunk;
+	cChunkDef::BlockNibbles BlockMetas;
+	a_ChunkDesc.CompressBlockMetas(BlockMetas);
+	Chunk->m_Data.SetBlockTypes(a_ChunkDesc.GetBlockTypes());
+	Chunk->m_Data.SetMetas(BlockMetas);
+	memcpy(Chunk->m_HeightMap, a_ChunkDesc.GetHeightMap(), sizeof(Chunk->m_HeightMap));
+	memcpy(Chunk->m_BiomeMap,  a_ChunkDesc.GetBiomeMap(),  sizeof(Chunk->m_BiomeMap));
+
+	// Take over the entities, the chunk desc doesn't own them:
+	std::swap(Chunk->m_Entities,      a_ChunkDesc.GetEntities());
+	std::swap(Chunk->m_BlockEntities, a_ChunkDesc.GetBlockEntities());
+
+	cCSLock Lock(m_CS);
+	sChunk *& Dest = m_Chunks[cChunkCoords(a_ChunkDesc.GetChunkX(), 0, a_ChunkDesc.GetChunkZ())];
+	delete Dest;
+	Dest = Chunk;
+}
+
+
+
+
+
+bool cPregenerator::IsChunkValid(int a_ChunkX, int a_ChunkZ)
+{
+	return (GetChunk(a_ChunkX, a_ChunkZ) != NULL);
+}
+
+
+
+
+
+bool cPregenerator::GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback)
+{
+	// The chunks are neither added nor removed while a stage runs, so the chunk can be used without the lock:
+	sChunk * Chunk = GetChunk(a_ChunkX, a_ChunkZ);
+	if (Chunk == NULL)
+	{
+		return false;
+	}
+
+	// Provide the data in the same order as cChunk::GetAllData() does:
+	a_Callback.HeightMap(&Chunk->m_HeightMap);
+	a_Callback.BiomeData(&Chunk->m_BiomeMap);
+	a_Callback.LightIsValid(Chunk->m_IsLightValid);
+	a_Callback.ChunkData(Chunk->m_Data);
+	for (cEntityList::iterator itr = Chunk->m_Entities.begin(), end = Chunk->m_Entities.end(); itr != end; ++itr)
+	{
+		a_Callback.Entity(*itr);
+	}
+	for (cBlockEntityList::iterator itr = Chunk->m_BlockEntities.begin(), end = Chunk->m_BlockEntities.end(); itr != end; ++itr)
+	{
+		a_Callback.BlockEntity(*itr);
+	}
+	return true;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cPregenerator::cThread:
+
+cPregenerator::cThread::cThread(cPregenerator & a_Parent, eStage a_Stage) :
+	super("Pregenerator thread"),
+	m_Parent(a_Parent),
+	m_Stage(a_Stage),
+	m_Lighter((a_Stage == stLight) ? new cChunkLighter : NULL)
+{
+}
+
+
+
+
+
+cPregenerator::cThread::~cThread()
+{
+	delete m_Lighter;
+}
+
+
+
+
+
+void cPregenerator::cThread::Execute(void)
+{
+	cChunkCoords Coords(0, 0, 0);
+	while (m_Parent.GetNextChunk(Coords))
+	{
+		bool res = false;
+		switch (m_Stage)
+		{
+			case stLoad:  res = LoadChunk(Coords);  break;
+			case stLight: res = LightChunk(Coords); break;
+			case stSave:  res = SaveChunk(Coords);  break;
+		}
+		if (!res)
+		{
+			cCSLock Lock(m_Parent.m_CS);
+			m_Parent.m_NumFailed += 1;
+		}
+	}
+}
+
+
+
+
+
+bool cPregenerator::cThread::LoadChunk(const cChunkCoords & a_Coords)
+{
+	cChunkDef::BlockTypes BlockTypes;
+	cChunkDef::BlockNibbles BlockMetas;
+	if (!m_Parent.m_Storage->LoadChunkBlocks(a_Coords, BlockTypes, BlockMetas))
+	{
+		LOGWARNING("Cannot read the stored chunk [%d, %d], it will be generated for the lighting instead", a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+		return false;
+	}
+
+	sChunk * Chunk = new sChunk;
+	Chunk->m_IsStored = true;
+	Chunk->m_Data.SetBlockTypes(BlockTypes);
+	Chunk->m_Data.SetMetas(BlockMetas);
+	memset(Chunk->m_BiomeMap, 0, sizeof(Chunk->m_BiomeMap));
+
+	// The height map is not stored, calculate it the same way as cChunk does on loading:
+	for (int z = 0; z < cChunkDef::Width; z++)
+	{
+		for (int x = 0; x < cChunkDef::Width; x++)
+		{
+			int y = cChunkDef::Height - 1;
+			while ((y > 0) && (BlockTypes[cChunkDef::MakeIndexNoCheck(x, y, z)] == E_BLOCK_AIR))
+			{
+				y--;
+			}
+			cChunkDef::SetHeight(Chunk->m_HeightMap, x, z, (HEIGHTTYPE)y);
+		}
+	}
+
+	cCSLock Lock(m_Parent.m_CS);
+	sChunk *& Dest = m_Parent.m_Chunks[a_Coords];
+	delete Dest;
+	Dest = Chunk;
+	return true;
+}
+
+
+
+
+
+bool cPregenerator::cThread::LightChunk(const cChunkCoords & a_Coords)
+{
+	sChunk * Chunk = m_Parent.GetChunk(a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+	ASSERT(Chunk != NULL);  // All the chunks have been checked after generating
+	ASSERT(Chunk->m_Light == NULL);
+
+	sChunk::sLight * Light = new sChunk::sLight;
+	if (!m_Lighter->LightChunk(m_Parent, a_Coords.m_ChunkX, a_Coords.m_ChunkZ, Light->m_BlockLight, Light->m_SkyLight))
+	{
+		LOGWARNING("Cannot light chunk [%d, %d]", a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+		delete Light;
+		return false;
+	}
+	Chunk->m_Light = Light;
+	return true;
+}
+
+
+
+
+
+bool cPregenerator::cThread::SaveChunk(const cChunkCoords & a_Coords)
+{
+	sChunk * Chunk = m_Parent.GetChunk(a_Coords.m_ChunkX, a_Coords.m_ChunkZ);
+	ASSERT(Chunk != NULL);  // All the chunks have been checked after generating
+	ASSERT(Chunk->m_Light != NULL);  // All the chunks have been lighted
+
+	// Nobody reads the neighbors anymore, so the light can be moved into the chunk's data:
+	Chunk->m_Data.SetBlockLight(Chunk->m_Light->m_BlockLight);
+	Chunk->m_Data.SetSkyLight(Chunk->m_Light->m_SkyLight);
+	delete Chunk->m_Light;
+	Chunk->m_Light = NULL;
+	Chunk->m_IsLightValid = true;
+
+	return m_Parent.m_Storage->SaveChunkFromSource(a_Coords, m_Parent);
+}
+
+
+
+
+
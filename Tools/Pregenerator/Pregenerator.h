@@ -0,0 +1,239 @@
+
+// Pregenerator.h
+
+// Interfaces to the cPregenerator class encapsulating the entire headless world pregenerator app
+
+/*
+The pregenerator fills an area of a world with generated, lighted chunks, stored in the Anvil format, without running
+the server: there are no players, no plugins, no simulators and no tick thread, the generator, lighting and storage
+code is driven directly. The world's settings (seed, generator) are read from the world.ini in the world folder, so
+that the server continues generating the same world later on.
+The chunks that are already stored (generated by the server or by an earlier run) are never overwritten, only the
+missing chunks of the area are pregenerated. The area is processed by regions (32 x 32 chunks, the same as an MCA file),
+each region in four stages:
+	1. The neighbors needed for lighting the missing chunks (the chunks around them, including a ring of one chunk around
+	the region) that are already stored are read from the storage, in parallel by the worker threads
+	2. The missing chunks, and the neighbors not read from the storage, are generated by the chunk generator threads
+	3. The missing chunks are lighted in parallel by the worker threads, each with its own cChunkLighter
+	4. The missing chunks are saved in parallel by the worker threads, using the world-less cWSSAnvil
+The neighbors are not lighted nor saved, they only provide the blocks for lighting. The chunks are then freed, so the
+memory used doesn't depend on the size of the area.
+Once a region is saved, it is recorded in the progress file in the world folder; an interrupted run can be resumed
+by running the pregenerator again with the same area, the regions already recorded are skipped.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+#include "ChunkData.h"
+#include "LightingThread.h"
+#include "Generating/ChunkGenerator.h"
+#include "WorldStorage/WSSAnvil.h"
+
+
+
+
+
+class cPregenerator :
+	public cChunkGenerator::cPluginInterface,
+	public cChunkGenerator::cChunkSink,
+	public cChunkDataSource
+{
+public:
+	/** Number of the chunks on each side of a region */
+	static const int REGION_SIZE = 32;
+
+	/** The chunk generator queue is filled with at most this many chunks at a time, so that it doesn't warn about its size */
+	static const int MAX_GENERATOR_QUEUE = 256;
+
+
+	cPregenerator(void);
+	~cPregenerator();
+
+	/** Reads the cmdline params and initializes the app.
+	Returns true if the app should continue, false if not. */
+	bool Init(int argc, char ** argv);
+
+	/** Runs the entire app. Returns true if all the regions have been finished. */
+	bool Run(void);
+
+protected:
+	/** The stages of processing a single region */
+	enum eStage
+	{
+		stLoad,
+		stLight,
+		stSave,
+	} ;
+
+
+	/** A single generated chunk waiting to be lighted and saved, or a stored neighbor read from the storage */
+	struct sChunk
+	{
+		cChunkData m_Data;
+		cChunkDef::HeightMap m_HeightMap;
+		cChunkDef::BiomeMap m_BiomeMap;
+		cEntityList m_Entities;            // Owned by this object
+		cBlockEntityList m_BlockEntities;  // Owned by this object
+
+		/** The light calculated in the lighting stage, moved into m_Data in the saving stage; NULL before and after that.
+		The lighting of the neighbors reads m_Data concurrently, so the light cannot be stored there right away. */
+		struct sLight
+		{
+			cChunkDef::BlockNibbles m_BlockLight;
+			cChunkDef::BlockNibbles m_SkyLight;
+		} * m_Light;
+
+		/** Set once the light has been moved into m_Data */
+		bool m_IsLightValid;
+
+		/** Set if the chunk has been read from the storage, to provide the blocks for lighting its neighbors only */
+		bool m_IsStored;
+
+		sChunk(void);
+		~sChunk();
+	} ;
+
+	typedef std::map<cChunkCoords, sChunk *> cChunks;
+
+
+	/** A single thread processing the chunks of the current stage from the queue */
+	class cThread :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cThread(cPregenerator & a_Parent, eStage a_Stage);
+		virtual ~cThread();
+
+	protected:
+		cPregenerator & m_Parent;
+
+		eStage m_Stage;
+
+		/** The lighting calculation and its buffers; only allocated for the lighting stage */
+		cChunkLighter * m_Lighter;
+
+		/** Reads the stored chunk's blocks from the storage into a new sChunk. Returns true if successful. */
+		bool LoadChunk(const cChunkCoords & a_Coords);
+
+		/** Lights the chunk, storing the light into its sChunk. Returns true if successful. */
+		bool LightChunk(const cChunkCoords & a_Coords);
+
+		/** Moves the light into the chunk's data and saves the chunk. Returns true if successful. */
+		bool SaveChunk(const cChunkCoords & a_Coords);
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	} ;
+
+	typedef std::list<cThread *> cThreads;
+
+
+	/** The folder of the world to be pregenerated */
+	AString m_WorldFolder;
+
+	/** The bounding box of the area, in chunk coords, inclusive */
+	int m_MinChunkX, m_MinChunkZ, m_MaxChunkX, m_MaxChunkZ;
+
+	/** If set, the area is a circle around m_CenterX, m_CenterZ (in chunks) with m_Radius; otherwise it is the whole bounding box */
+	bool m_IsRadial;
+	int m_CenterX, m_CenterZ, m_Radius;
+
+	/** The number of the generator threads and of the loading, lighting and saving threads.
+	Configurable on the command line, defaults to the number of hardware threads. Overrides the generator's
+	NumThreads from the world.ini for this run only, the server keeps using its own setting. */
+	int m_NumThreads;
+
+	cChunkGenerator m_Generator;
+
+	/** The storage; created once the world's settings are read */
+	cWSSAnvil * m_Storage;
+
+	/** Protects m_Chunks and m_Queue */
+	cCriticalSection m_CS;
+
+	/** The chunks of the current region being pregenerated, and their neighbors. Protected by m_CS. */
+	cChunks m_Chunks;
+
+	/** The chunks to be processed in the current stage by the threads. Protected by m_CS. */
+	cChunkCoordsVector m_Queue;
+
+	/** Number of the chunks that have failed in the current stage. Protected by m_CS. */
+	int m_NumFailed;
+
+	/** The regions (X, Z) finished by this or a previous run */
+	std::set<std::pair<int, int> > m_FinishedRegions;
+
+	/** Number of the chunks processed, and the total time (msec) spent in each of the stages */
+	int   m_NumLoaded, m_NumGenerated, m_NumLighted, m_NumSaved;
+	Int64 m_LoadTime, m_GenerateTime, m_LightTime, m_SaveTime;
+
+	/** Number of the chunks of the area that were skipped because they were already stored */
+	int m_NumSkipped;
+
+	/** Provides the time for the statistics above */
+	cTimer m_Timer;
+
+
+	/** Returns true if the chunk is in the area to be pregenerated */
+	bool IsChunkInArea(int a_ChunkX, int a_ChunkZ) const;
+
+	/** Returns the description of the area, used to check that the progress file belongs to the same area */
+	AString GetAreaDescription(void) const;
+
+	/** Returns the name of the progress file */
+	AString GetProgressFileName(void) const;
+
+	/** Loads the regions finished in a previous run from the progress file, if it belongs to the same area */
+	void LoadProgress(void);
+
+	/** Writes the area and all the finished regions into the progress file */
+	void SaveProgress(void);
+
+	/** Generates, lights and saves all the chunks of the area within the specified region that are not stored yet.
+	Returns true if successful. */
+	bool ProcessRegion(int a_RegionX, int a_RegionZ);
+
+	/** Generates all the specified chunks, waits for the generator to finish them */
+	void GenerateChunks(const cChunkCoordsSet & a_Chunks);
+
+	/** Processes all the specified chunks in the specified stage, using m_NumThreads threads */
+	void RunStage(eStage a_Stage, const cChunkCoordsVector & a_Chunks);
+
+	/** Returns the sChunk of the specified chunk; NULL if neither generated nor read from the storage */
+	sChunk * GetChunk(int a_ChunkX, int a_ChunkZ);
+
+	/** Retrieves one chunk from the queue (and removes it from the queue).
+	Returns false when the queue is empty. */
+	bool GetNextChunk(cChunkCoords & a_Coords);
+
+	/** Frees all the chunks */
+	void FreeChunks(void);
+
+	/** Logs the speed of a single stage */
+	void LogStageSpeed(const char * a_StageName, int a_NumChunks, Int64 a_Time);
+
+	// cChunkGenerator::cPluginInterface overrides:
+	virtual void CallHookChunkGenerating(cChunkDesc & a_ChunkDesc) override {}
+	virtual void CallHookChunkGenerated (cChunkDesc & a_ChunkDesc) override {}
+
+	// cChunkGenerator::cChunkSink overrides:
+	virtual void OnChunkGenerated  (cChunkDesc & a_ChunkDesc) override;
+	virtual bool IsChunkValid      (int a_ChunkX, int a_ChunkZ) override;
+	virtual bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) override { return true; }
+	virtual void GetPlayerChunks   (cChunkCoordsVector & a_Coords) override {}
+
+	// cChunkDataSource overrides:
+	virtual bool GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback) override;
+} ;
+
+
+
+
+
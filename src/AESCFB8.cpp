@@ -0,0 +1,531 @@
+
+// AESCFB8.cpp
+
+// Implements the cAESCFB8 class implementing the AES-128 / CFB8 cipher, with an AES-NI implementation selected at runtime
+
+#include "Globals.h"
+#include "AESCFB8.h"
+
+// AES-NI needs an x86 / x64 compiler with per-function target ISA (gcc, clang) or with the intrinsics available without special flags (MSVC 2010+):
+#if (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)) && \
+	((defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))) || defined(__clang__) || (defined(_MSC_VER) && (_MSC_VER >= 1600)))
+	#define AESCFB8_AESNI
+	#include <emmintrin.h>
+	#include <wmmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define AESCFB8_TARGET_AESNI
+	#else
+		#include <cpuid.h>
+		#define AESCFB8_TARGET_AESNI __attribute__((target("aes,sse2")))
+	#endif
+#endif
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Tables for the portable implementation:
+
+static const Byte g_SBox[256] =
+{
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+} ;
+
+
+
+
+
+/** The combined SubBytes + MixColumns tables, g_T0[x] = S[x] * (02, 01, 01, 03); g_T1 .. g_T3 are g_T0 rotated by 8, 16 and 24 bits */
+static UInt32 g_T0[256];
+static UInt32 g_T1[256];
+static UInt32 g_T2[256];
+static UInt32 g_T3[256];
+
+
+
+
+
+/** Multiplies by 2 in GF(2^8) */
+static inline Byte XTime(Byte a_Value)
+{
+	return (Byte)((a_Value << 1) ^ (((a_Value & 0x80) != 0) ? 0x1b : 0));
+}
+
+
+
+
+
+static inline UInt32 RotateRight(UInt32 a_Value, int a_NumBits)
+{
+	return (a_Value >> a_NumBits) | (a_Value << (32 - a_NumBits));
+}
+
+
+
+
+
+static inline UInt32 GetBE32(const Byte * a_Data)
+{
+	return ((UInt32)a_Data[0] << 24) | ((UInt32)a_Data[1] << 16) | ((UInt32)a_Data[2] << 8) | (UInt32)a_Data[3];
+}
+
+
+
+
+
+static inline void PutBE32(UInt32 a_Value, Byte * a_Data)
+{
+	a_Data[0] = (Byte)(a_Value >> 24);
+	a_Data[1] = (Byte)(a_Value >> 16);
+	a_Data[2] = (Byte)(a_Value >> 8);
+	a_Data[3] = (Byte)a_Value;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPU detection:
+
+#ifdef AESCFB8_AESNI
+
+/** Returns true if the CPU supports the AES-NI instructions */
+static bool HasCPUAESNI(void)
+{
+	const int AESNI = 1 << 25;
+	#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 1);
+		return ((Info[2] & AESNI) != 0);
+	#else
+		unsigned int eax, ebx, ecx, edx;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+		{
+			return false;
+		}
+		return ((ecx & AESNI) != 0);
+	#endif
+}
+
+#endif  // AESCFB8_AESNI
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cAESCFB8:
+
+cAESCFB8::eImpl cAESCFB8::s_Impl = cAESCFB8::implPortable;
+
+
+
+
+
+/** Builds the tables and selects the best implementation on startup */
+static class cAESCFB8Initializer
+{
+public:
+	cAESCFB8Initializer(void)
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			Byte s = g_SBox[i];
+			Byte s2 = XTime(s);
+			Byte s3 = s2 ^ s;
+			g_T0[i] = ((UInt32)s2 << 24) | ((UInt32)s << 16) | ((UInt32)s << 8) | (UInt32)s3;
+			g_T1[i] = RotateRight(g_T0[i], 8);
+			g_T2[i] = RotateRight(g_T0[i], 16);
+			g_T3[i] = RotateRight(g_T0[i], 24);
+		}
+		cAESCFB8::SetImpl(cAESCFB8::implAESNI);
+	}
+} g_AESCFB8Initializer;
+
+
+
+
+
+const char * cAESCFB8::GetImplName(eImpl a_Impl)
+{
+	switch (a_Impl)
+	{
+		case implPortable: return "portable";
+		case implAESNI:    return "AES-NI";
+	}
+	return "unknown";
+}
+
+
+
+
+
+bool cAESCFB8::IsImplSupported(eImpl a_Impl)
+{
+	switch (a_Impl)
+	{
+		case implPortable: return true;
+		case implAESNI:
+		{
+			#ifdef AESCFB8_AESNI
+				return HasCPUAESNI();
+			#else
+				return false;
+			#endif
+		}
+	}
+	return false;
+}
+
+
+
+
+
+bool cAESCFB8::SetImpl(eImpl a_Impl)
+{
+	if (!IsImplSupported(a_Impl))
+	{
+		return false;
+	}
+	s_Impl = a_Impl;
+	return true;
+}
+
+
+
+
+
+cAESCFB8::cAESCFB8(void)
+{
+	memset(m_RoundKeys, 0, sizeof(m_RoundKeys));
+	memset(m_RoundKeyBytes, 0, sizeof(m_RoundKeyBytes));
+	memset(m_IV, 0, sizeof(m_IV));
+}
+
+
+
+
+
+cAESCFB8::~cAESCFB8()
+{
+	// Clear the leftover in-memory data, so that they can't be accessed by a backdoor
+	memset(m_RoundKeys, 0, sizeof(m_RoundKeys));
+	memset(m_RoundKeyBytes, 0, sizeof(m_RoundKeyBytes));
+}
+
+
+
+
+
+void cAESCFB8::Init(const Byte a_Key[16], const Byte a_IV[16])
+{
+	// Standard AES-128 key expansion:
+	static const UInt32 RCon[10] =
+	{
+		0x01000000, 0x02000000, 0x04000000, 0x08000000, 0x10000000,
+		0x20000000, 0x40000000, 0x80000000, 0x1b000000, 0x36000000,
+	} ;
+	UInt32 * RK = m_RoundKeys;
+	for (int i = 0; i < 4; i++)
+	{
+		RK[i] = GetBE32(a_Key + 4 * i);
+	}
+	for (int i = 0; i < 10; i++, RK += 4)
+	{
+		UInt32 Temp = RK[3];
+		RK[4] = RK[0] ^ RCon[i] ^
+			((UInt32)g_SBox[(Temp >> 16) & 0xff] << 24) ^
+			((UInt32)g_SBox[(Temp >>  8) & 0xff] << 16) ^
+			((UInt32)g_SBox[ Temp        & 0xff] <<  8) ^
+			((UInt32)g_SBox[ Temp >> 24        ]);
+		RK[5] = RK[1] ^ RK[4];
+		RK[6] = RK[2] ^ RK[5];
+		RK[7] = RK[3] ^ RK[6];
+	}
+	for (int i = 0; i < 44; i++)
+	{
+		PutBE32(m_RoundKeys[i], m_RoundKeyBytes + 4 * i);
+	}
+	memcpy(m_IV, a_IV, sizeof(m_IV));
+}
+
+
+
+
+
+void cAESCFB8::Encrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
+{
+	#ifdef AESCFB8_AESNI
+		if (s_Impl == implAESNI)
+		{
+			AESNIEncrypt(a_EncryptedOut, a_PlainIn, a_Length);
+			return;
+		}
+	#endif
+	PortableEncrypt(a_EncryptedOut, a_PlainIn, a_Length);
+}
+
+
+
+
+
+void cAESCFB8::Decrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length)
+{
+	#ifdef AESCFB8_AESNI
+		if (s_Impl == implAESNI)
+		{
+			AESNIDecrypt(a_DecryptedOut, a_EncryptedIn, a_Length);
+			return;
+		}
+	#endif
+	PortableDecrypt(a_DecryptedOut, a_EncryptedIn, a_Length);
+}
+
+
+
+
+
+Byte cAESCFB8::PortableEncryptFirstByte(const Byte * a_Block) const
+{
+	const UInt32 * RK = m_RoundKeys;
+	UInt32 s0 = GetBE32(a_Block)      ^ RK[0];
+	UInt32 s1 = GetBE32(a_Block + 4)  ^ RK[1];
+	UInt32 s2 = GetBE32(a_Block + 8)  ^ RK[2];
+	UInt32 s3 = GetBE32(a_Block + 12) ^ RK[3];
+	for (int Round = 1; Round < 10; Round++)
+	{
+		RK += 4;
+		UInt32 t0 = g_T0[s0 >> 24] ^ g_T1[(s1 >> 16) & 0xff] ^ g_T2[(s2 >> 8) & 0xff] ^ g_T3[s3 & 0xff] ^ RK[0];
+		UInt32 t1 = g_T0[s1 >> 24] ^ g_T1[(s2 >> 16) & 0xff] ^ g_T2[(s3 >> 8) & 0xff] ^ g_T3[s0 & 0xff] ^ RK[1];
+		UInt32 t2 = g_T0[s2 >> 24] ^ g_T1[(s3 >> 16) & 0xff] ^ g_T2[(s0 >> 8) & 0xff] ^ g_T3[s1 & 0xff] ^ RK[2];
+		UInt32 t3 = g_T0[s3 >> 24] ^ g_T1[(s0 >> 16) & 0xff] ^ g_T2[(s1 >> 8) & 0xff] ^ g_T3[s2 & 0xff] ^ RK[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	// The last round has no MixColumns; CFB8 needs only the first byte of the output:
+	return (Byte)(g_SBox[s0 >> 24] ^ (m_RoundKeys[40] >> 24));
+}
+
+
+
+
+
+void cAESCFB8::PortableEncrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
+{
+	// The blocks are read from a sliding window over IV + ciphertext; the ciphertext is a_EncryptedOut itself,
+	// only the blocks overlapping the IV need a temporary buffer:
+	Byte Window[32];
+	memcpy(Window, m_IV, 16);
+	size_t NumFirst = std::min(a_Length, (size_t)16);
+	for (size_t i = 0; i < NumFirst; i++)
+	{
+		Byte c = a_PlainIn[i] ^ PortableEncryptFirstByte(Window + i);
+		a_EncryptedOut[i] = c;
+		Window[16 + i] = c;
+	}
+	for (size_t i = 16; i < a_Length; i++)
+	{
+		a_EncryptedOut[i] = a_PlainIn[i] ^ PortableEncryptFirstByte(a_EncryptedOut + i - 16);
+	}
+
+	// The new IV is the last 16 bytes of IV + ciphertext:
+	if (a_Length >= 16)
+	{
+		memcpy(m_IV, a_EncryptedOut + a_Length - 16, 16);
+	}
+	else
+	{
+		memcpy(m_IV, Window + a_Length, 16);
+	}
+}
+
+
+
+
+
+void cAESCFB8::PortableDecrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length)
+{
+	// Same as encryption, except the window slides over the input:
+	Byte Window[32];
+	memcpy(Window, m_IV, 16);
+	size_t NumFirst = std::min(a_Length, (size_t)16);
+	memcpy(Window + 16, a_EncryptedIn, NumFirst);
+	for (size_t i = 0; i < NumFirst; i++)
+	{
+		a_DecryptedOut[i] = a_EncryptedIn[i] ^ PortableEncryptFirstByte(Window + i);
+	}
+	for (size_t i = 16; i < a_Length; i++)
+	{
+		a_DecryptedOut[i] = a_EncryptedIn[i] ^ PortableEncryptFirstByte(a_EncryptedIn + i - 16);
+	}
+
+	if (a_Length >= 16)
+	{
+		memcpy(m_IV, a_EncryptedIn + a_Length - 16, 16);
+	}
+	else
+	{
+		memcpy(m_IV, Window + a_Length, 16);
+	}
+}
+
+
+
+
+
+#ifdef AESCFB8_AESNI
+
+/** Encrypts a single block with the round keys in registers */
+#define AESNI_ENCRYPT_BLOCK(Block) \
+	Block = _mm_xor_si128(Block, K0); \
+	Block = _mm_aesenc_si128(Block, K1); \
+	Block = _mm_aesenc_si128(Block, K2); \
+	Block = _mm_aesenc_si128(Block, K3); \
+	Block = _mm_aesenc_si128(Block, K4); \
+	Block = _mm_aesenc_si128(Block, K5); \
+	Block = _mm_aesenc_si128(Block, K6); \
+	Block = _mm_aesenc_si128(Block, K7); \
+	Block = _mm_aesenc_si128(Block, K8); \
+	Block = _mm_aesenc_si128(Block, K9); \
+	Block = _mm_aesenclast_si128(Block, K10);
+
+#define AESNI_LOAD_KEYS \
+	const __m128i K0  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes)); \
+	const __m128i K1  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 16)); \
+	const __m128i K2  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 32)); \
+	const __m128i K3  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 48)); \
+	const __m128i K4  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 64)); \
+	const __m128i K5  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 80)); \
+	const __m128i K6  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 96)); \
+	const __m128i K7  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 112)); \
+	const __m128i K8  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 128)); \
+	const __m128i K9  = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 144)); \
+	const __m128i K10 = _mm_loadu_si128((const __m128i *)(m_RoundKeyBytes + 160));
+
+
+
+
+
+AESCFB8_TARGET_AESNI void cAESCFB8::AESNIEncrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
+{
+	AESNI_LOAD_KEYS
+	__m128i IV = _mm_loadu_si128((const __m128i *)m_IV);
+	for (size_t i = 0; i < a_Length; i++)
+	{
+		__m128i Block = IV;
+		AESNI_ENCRYPT_BLOCK(Block)
+		Byte c = a_PlainIn[i] ^ (Byte)_mm_cvtsi128_si32(Block);
+		a_EncryptedOut[i] = c;
+
+		// Shift the IV by one byte and append the ciphertext byte, without leaving the register:
+		IV = _mm_or_si128(_mm_srli_si128(IV, 1), _mm_slli_si128(_mm_cvtsi32_si128(c), 15));
+	}
+	_mm_storeu_si128((__m128i *)m_IV, IV);
+}
+
+
+
+
+
+AESCFB8_TARGET_AESNI void cAESCFB8::AESNIDecrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length)
+{
+	AESNI_LOAD_KEYS
+
+	// All the blocks are known upfront (IV + ciphertext), encrypt four of them at a time to keep the AES unit busy:
+	Byte Window[32];
+	memcpy(Window, m_IV, 16);
+	size_t NumFirst = std::min(a_Length, (size_t)16);
+	memcpy(Window + 16, a_EncryptedIn, NumFirst);
+	#define BLOCK_AT(Idx) _mm_loadu_si128((const __m128i *)(((Idx) < 16) ? (Window + (Idx)) : (a_EncryptedIn + (Idx) - 16)))
+	size_t i = 0;
+	for (; i + 4 <= a_Length; i += 4)
+	{
+		__m128i B0 = BLOCK_AT(i);
+		__m128i B1 = BLOCK_AT(i + 1);
+		__m128i B2 = BLOCK_AT(i + 2);
+		__m128i B3 = BLOCK_AT(i + 3);
+		B0 = _mm_xor_si128(B0, K0);
+		B1 = _mm_xor_si128(B1, K0);
+		B2 = _mm_xor_si128(B2, K0);
+		B3 = _mm_xor_si128(B3, K0);
+		#define ROUND4(Key) \
+			B0 = _mm_aesenc_si128(B0, Key); \
+			B1 = _mm_aesenc_si128(B1, Key); \
+			B2 = _mm_aesenc_si128(B2, Key); \
+			B3 = _mm_aesenc_si128(B3, Key);
+		ROUND4(K1)
+		ROUND4(K2)
+		ROUND4(K3)
+		ROUND4(K4)
+		ROUND4(K5)
+		ROUND4(K6)
+		ROUND4(K7)
+		ROUND4(K8)
+		ROUND4(K9)
+		#undef ROUND4
+		B0 = _mm_aesenclast_si128(B0, K10);
+		B1 = _mm_aesenclast_si128(B1, K10);
+		B2 = _mm_aesenclast_si128(B2, K10);
+		B3 = _mm_aesenclast_si128(B3, K10);
+		a_DecryptedOut[i]     = a_EncryptedIn[i]     ^ (Byte)_mm_cvtsi128_si32(B0);
+		a_DecryptedOut[i + 1] = a_EncryptedIn[i + 1] ^ (Byte)_mm_cvtsi128_si32(B1);
+		a_DecryptedOut[i + 2] = a_EncryptedIn[i + 2] ^ (Byte)_mm_cvtsi128_si32(B2);
+		a_DecryptedOut[i + 3] = a_EncryptedIn[i + 3] ^ (Byte)_mm_cvtsi128_si32(B3);
+	}
+	for (; i < a_Length; i++)
+	{
+		__m128i Block = BLOCK_AT(i);
+		AESNI_ENCRYPT_BLOCK(Block)
+		a_DecryptedOut[i] = a_EncryptedIn[i] ^ (Byte)_mm_cvtsi128_si32(Block);
+	}
+	#undef BLOCK_AT
+
+	if (a_Length >= 16)
+	{
+		memcpy(m_IV, a_EncryptedIn + a_Length - 16, 16);
+	}
+	else
+	{
+		memcpy(m_IV, Window + a_Length, 16);
+	}
+}
+
+#else  // AESCFB8_AESNI
+
+// Never called, SetImpl() refuses implAESNI:
+void cAESCFB8::AESNIEncrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
+{
+	PortableEncrypt(a_EncryptedOut, a_PlainIn, a_Length);
+}
+
+void cAESCFB8::AESNIDecrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length)
+{
+	PortableDecrypt(a_DecryptedOut, a_EncryptedIn, a_Length);
+}
+
+#endif  // else AESCFB8_AESNI
+
+
+
+
@@ -0,0 +1,89 @@
+
+// AESCFB8.h
+
+// Declares the cAESCFB8 class implementing the AES-128 / CFB8 cipher used by the protocol encryption
+
+/*
+CFB8 needs a whole AES block encryption for every single byte of data: the block is the last 16 bytes of the
+ciphertext (the IV at first), and the first byte of its encryption is XOR-ed with the next byte of the data.
+PolarSSL has no CFB8, so the data used to be processed by a call to aes_crypt_ecb() per byte, followed by shifting
+the IV. This class expands the key once and processes whole buffers at a time:
+	- portable, a table-based AES that computes only the single output byte that CFB8 uses in the last round,
+	and reads the blocks from a sliding window over the ciphertext instead of shifting the IV
+	- AES-NI, with the round keys kept in the SSE registers for the whole buffer; decryption has all the
+	blocks known upfront (they are the ciphertext), so it encrypts several of them in parallel
+The AES-NI implementation is compiled in only for x86 / x64 compilers that support it, and is used only if the CPU
+reports support for it; it is selected on startup. Both implementations produce identical output, tests/AESBenchmark
+verifies them against the original PolarSSL-based code and compares their speed.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cAESCFB8
+{
+public:
+	enum eImpl
+	{
+		implPortable = 0,
+		implAESNI    = 1,
+	} ;
+
+
+	/** Returns the implementation that is currently used */
+	static eImpl GetImpl(void) { return s_Impl; }
+
+	/** Returns the name of the specified implementation, for logging */
+	static const char * GetImplName(eImpl a_Impl);
+
+	/** Returns true if the specified implementation is compiled in and supported by the CPU */
+	static bool IsImplSupported(eImpl a_Impl);
+
+	/** Switches to the specified implementation, if supported; returns true if successful.
+	Used mainly by tests for comparing the implementations. Not thread-safe, call only when nothing is being encrypted. */
+	static bool SetImpl(eImpl a_Impl);
+
+
+	cAESCFB8(void);
+	~cAESCFB8();
+
+	/** Expands the key and sets the initial IV */
+	void Init(const Byte a_Key[16], const Byte a_IV[16]);
+
+	/** Encrypts a_Length bytes of the plain data; produces a_Length output bytes. The buffers must not overlap. */
+	void Encrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length);
+
+	/** Decrypts a_Length bytes of the encrypted data; produces a_Length output bytes. The buffers must not overlap. */
+	void Decrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length);
+
+protected:
+	/** The expanded key, as big-endian words, used by the portable implementation */
+	UInt32 m_RoundKeys[44];
+
+	/** The expanded key, as bytes, loaded directly into the SSE registers by the AES-NI implementation */
+	Byte m_RoundKeyBytes[176];
+
+	/** The last 16 bytes of the ciphertext, i. e. the next block to be encrypted */
+	Byte m_IV[16];
+
+	static eImpl s_Impl;
+
+	void PortableEncrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length);
+	void PortableDecrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length);
+	void AESNIEncrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length);
+	void AESNIDecrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length);
+
+	/** Returns the first byte of the encryption of the 16-byte block, using the portable implementation */
+	Byte PortableEncryptFirstByte(const Byte * a_Block) const;
+} ;
+
+
+
+
@@ -4,7 +4,6 @@
 #include "Authenticator.h"
 #include "OSSupport/BlockingTCPLink.h"
 #include "Root.h"
-#include "Server.h"
 
 #include "inifile/iniFile.h"
 
@@ -17,16 +16,18 @@
 #define DEFAULT_AUTH_SERVER "session.minecraft.net"
 #define DEFAULT_AUTH_ADDRESS "/game/checkserver.jsp?user=%USERNAME%&serverId=%SERVERID%"
 #define MAX_REDIRECTS 10
+#define DEFAULT_NUM_THREADS 8
 
 
 
 
 
 cAuthenticator::cAuthenticator(void) :
-	super("cAuthenticator"),
+	m_ShouldTerminate(false),
 	m_Server(DEFAULT_AUTH_SERVER),
 	m_Address(DEFAULT_AUTH_ADDRESS),
-	m_ShouldAuthenticate(true)
+	m_ShouldAuthenticate(true),
+	m_NumThreads(DEFAULT_NUM_THREADS)
 {
 }
 
@@ -48,6 +49,7 @@ void cAuthenticator::ReadINI(cIniFile & IniFile)
 	m_Server  = IniFile.GetValueSet("Authentication", "Server", DEFAULT_AUTH_SERVER);
 	m_Address = IniFile.GetValueSet("Authentication", "Address", DEFAULT_AUTH_ADDRESS);
 	m_ShouldAuthenticate = IniFile.GetValueSetB("Authentication", "Authenticate", true);
+	m_NumThreads = std::max(1, IniFile.GetValueSetI("Authentication", "NumThreads", DEFAULT_NUM_THREADS));
 }
 
 
@@ -58,12 +60,14 @@ void cAuthenticator::Authenticate(int a_ClientID, const AString & a_UserName, co
 {
 	if (!m_ShouldAuthenticate)
 	{
-		cRoot::Get()->AuthenticateUser(a_ClientID);
+		OnAuthSucceeded(a_ClientID);
 		return;
 	}
 
-	cCSLock Lock(m_CS);
-	m_Queue.push_back(cUser(a_ClientID, a_UserName, a_ServerHash));
+	{
+		cCSLock Lock(m_CS);
+		m_Queue.push_back(cUser(a_ClientID, a_UserName, a_ServerHash));
+	}
 	m_QueueNonempty.Set();
 }
 
@@ -75,7 +79,17 @@ void cAuthenticator::Start(cIniFile & IniFile)
 {
 	ReadINI(IniFile);
 	m_ShouldTerminate = false;
-	super::Start();
+	for (int i = 0; i < m_NumThreads; i++)
+	{
+		cWorker * Worker = new cWorker(*this);
+		if (!Worker->Start())
+		{
+			LOGWARNING("cAuthenticator: cannot start worker thread #%d", i);
+			delete Worker;
+			break;
+		}
+		m_Workers.push_back(Worker);
+	}
 }
 
 
@@ -84,48 +98,72 @@ void cAuthenticator::Start(cIniFile & IniFile)
 
 void cAuthenticator::Stop(void)
 {
-	m_ShouldTerminate = true;
+	{
+		cCSLock Lock(m_CS);
+		m_ShouldTerminate = true;
+	}
 	m_QueueNonempty.Set();
-	Wait();
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->Wait();
+		delete *itr;
+	}
+	m_Workers.clear();
+
+	// Drop the requests that haven't been processed, the clients are being disconnected anyway:
+	cCSLock Lock(m_CS);
+	m_Queue.clear();
 }
 
 
 
 
 
-void cAuthenticator::Execute(void)
+void cAuthenticator::OnAuthSucceeded(int a_ClientID)
 {
+	cRoot::Get()->AuthenticateUser(a_ClientID);
+}
+
+
+
+
+
+void cAuthenticator::OnAuthFailed(int a_ClientID)
+{
+	cRoot::Get()->KickUser(a_ClientID, "Failed to authenticate account!");
+}
+
+
+
+
+
+bool cAuthenticator::GetNextUser(int & a_ClientID, AString & a_UserName, AString & a_ServerHash)
+{
+	cCSLock Lock(m_CS);
 	for (;;)
 	{
-		cCSLock Lock(m_CS);
-		while (!m_ShouldTerminate && (m_Queue.size() == 0))
-		{
-			cCSUnlock Unlock(Lock);
-			m_QueueNonempty.Wait();
-		}
 		if (m_ShouldTerminate)
 		{
-			return;
-		}
-		ASSERT(!m_Queue.empty());
-		
-		int ClientID = m_Queue.front().m_ClientID;
-		AString UserName = m_Queue.front().m_Name;
-		AString ActualAddress = m_Address;
-		ReplaceString(ActualAddress, "%USERNAME%", UserName);
-		ReplaceString(ActualAddress, "%SERVERID%", m_Queue.front().m_ServerID);
-		m_Queue.pop_front();
-		Lock.Unlock();
-
-		if (!AuthFromAddress(m_Server, ActualAddress, UserName))
-		{
-			cRoot::Get()->KickUser(ClientID, "Failed to authenticate account!");
+			// Pass the termination request on to the next worker:
+			m_QueueNonempty.Set();
+			return false;
 		}
-		else
+		if (!m_Queue.empty())
 		{
-			cRoot::Get()->AuthenticateUser(ClientID);
+			a_ClientID = m_Queue.front().m_ClientID;
+			a_UserName = m_Queue.front().m_Name;
+			a_ServerHash = m_Queue.front().m_ServerID;
+			m_Queue.pop_front();
+			if (!m_Queue.empty())
+			{
+				// There are more users, wake up another worker to take them:
+				m_QueueNonempty.Set();
+			}
+			return true;
 		}
-	}  // for (-ever)
+		cCSUnlock Unlock(Lock);
+		m_QueueNonempty.Wait();
+	}
 }
 
 
@@ -136,8 +174,18 @@ bool cAuthenticator::AuthFromAddress(const AString & a_Server, const AString & a
 {
 	// Returns true if the user authenticated okay, false on error; iLevel is the recursion deptht (bails out if too deep)
 
+	// The server may specify a port, "host:port"; this is used mainly for testing against a local stand-in server:
+	AString Host = a_Server;
+	unsigned int Port = 80;
+	size_t idxColon = a_Server.find(':');
+	if (idxColon != AString::npos)
+	{
+		Host = a_Server.substr(0, idxColon);
+		Port = (unsigned int)atoi(a_Server.c_str() + idxColon + 1);
+	}
+
 	cBlockingTCPLink Link;
-	if (!Link.Connect(a_Server.c_str(), 80))
+	if (!Link.Connect(Host.c_str(), Port))
 	{
 		LOGWARNING("%s: cannot connect to auth server \"%s\", kicking user \"%s\"",
 			__FUNCTION__, a_Server.c_str(), a_UserName.c_str()
@@ -265,3 +313,40 @@ bool cAuthenticator::AuthFromAddress(const AString & a_Server, const AString & a
 
 
 
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cAuthenticator::cWorker:
+
+cAuthenticator::cWorker::cWorker(cAuthenticator & a_Parent) :
+	super("cAuthenticator::cWorker"),
+	m_Parent(a_Parent)
+{
+}
+
+
+
+
+
+void cAuthenticator::cWorker::Execute(void)
+{
+	int ClientID;
+	AString UserName, ServerHash;
+	while (m_Parent.GetNextUser(ClientID, UserName, ServerHash))
+	{
+		AString ActualAddress = m_Parent.m_Address;
+		ReplaceString(ActualAddress, "%USERNAME%", UserName);
+		ReplaceString(ActualAddress, "%SERVERID%", ServerHash);
+		if (m_Parent.AuthFromAddress(m_Parent.m_Server, ActualAddress, UserName))
+		{
+			m_Parent.OnAuthSucceeded(ClientID);
+		}
+		else
+		{
+			m_Parent.OnAuthFailed(ClientID);
+		}
+	}
+}
+
+
+
+
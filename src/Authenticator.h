@@ -1,10 +1,12 @@
-
 // cAuthenticator.h
 
-// Interfaces to the cAuthenticator class representing the thread that authenticates users against the official MC server
+// Interfaces to the cAuthenticator class representing the thread pool that authenticates users against the official MC server
 // Authentication prevents "hackers" from joining with an arbitrary username (possibly impersonating the server admins)
 // For more info, see http://wiki.vg/Session#Server_operation
-// In MCS, authentication is implemented as a single thread that receives queued auth requests and dispatches them one by one.
+// In MCS, authentication is implemented as a pool of threads that take queued auth requests and dispatch them concurrently,
+// so that a slow reply from the auth server for one user doesn't hold up the logins of the others.
+// Each login is verified by its own request; a result is never reused for another client, because the server hash
+// (constant for the 1.2.5 protocol) isn't a proof that the client is the one that has been verified.
 
 
 
@@ -27,14 +29,11 @@ class cRoot;
 
 
 
-class cAuthenticator :
-	public cIsThread
+class cAuthenticator
 {
-	typedef cIsThread super;
-	
 public:
 	cAuthenticator(void);
-	~cAuthenticator();
+	virtual ~cAuthenticator();
 
 	/// (Re-)read server and address from INI:
 	void ReadINI(cIniFile & IniFile);
@@ -42,21 +41,30 @@ public:
 	/// Queues a request for authenticating a user. If the auth fails, the user is kicked
 	void Authenticate(int a_ClientID, const AString & a_UserName, const AString & a_ServerHash);
 
-	/// Starts the authenticator thread. The thread may be started and stopped repeatedly
+	/// Starts the authenticator threads. The threads may be started and stopped repeatedly
 	void Start(cIniFile & IniFile);
-	
-	/// Stops the authenticator thread. The thread may be started and stopped repeatedly
+
+	/// Stops the authenticator threads. The threads may be started and stopped repeatedly
 	void Stop(void);
-	
+
+protected:
+
+	/// Called from a worker thread when the user has passed the authentication. Authenticates the client in cRoot.
+	virtual void OnAuthSucceeded(int a_ClientID);
+
+	/// Called from a worker thread when the user has failed the authentication. Kicks the client through cRoot.
+	virtual void OnAuthFailed(int a_ClientID);
+
 private:
 
+	/// A queued verification of a single client
 	class cUser
 	{
 	public:
 		int     m_ClientID;
 		AString m_Name;
 		AString m_ServerID;
-		
+
 		cUser(int a_ClientID, const AString & a_Name, const AString & a_ServerID) :
 			m_ClientID(a_ClientID),
 			m_Name(a_Name),
@@ -64,20 +72,47 @@ private:
 		{
 		}
 	} ;
-	
+
 	typedef std::deque<cUser> cUserList;
-	
+
+
+	/// A single worker thread; takes users from the parent's m_Queue and authenticates them
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cWorker(cAuthenticator & a_Parent);
+
+	protected:
+		cAuthenticator & m_Parent;
+
+		// cIsThread override:
+		virtual void Execute(void) override;
+	} ;
+
+	typedef std::vector<cWorker *> cWorkers;
+
+
+	/// Protects all the member variables below except for the settings, which are only changed while stopped
 	cCriticalSection m_CS;
 	cUserList        m_Queue;
 	cEvent           m_QueueNonempty;
-	
+	bool             m_ShouldTerminate;
+	cWorkers         m_Workers;
+
 	AString m_Server;
 	AString m_Address;
 	bool    m_ShouldAuthenticate;
-	
-	// cIsThread override:
-	virtual void Execute(void) override;
-	
+
+	/// Number of worker threads, i. e. the max number of concurrent requests to the auth server
+	int m_NumThreads;
+
+
+	/// Waits for a user in m_Queue and removes it. Returns false if the workers are to terminate. Called from the worker threads.
+	bool GetNextUser(int & a_ClientID, AString & a_UserName, AString & a_ServerHash);
+
 	// Returns true if the user authenticated okay, false on error; iLevel is the recursion deptht (bails out if too deep)
 	bool AuthFromAddress(const AString & a_Server, const AString & a_Address, const AString & a_UserName, int a_Level = 1);
 };
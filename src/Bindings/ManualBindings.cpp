@@ -27,6 +27,7 @@
 #include "../BlockEntities/FlowerPotEntity.h"
 #include "md5/md5.h"
 #include "../LineBlockTracer.h"
+#include "../BoundingBox.h"
 #include "../WorldStorage/SchematicFileSerializer.h"
 #include "../CompositeChat.h"
 
@@ -743,6 +744,167 @@ static int tolua_ForEach(lua_State * tolua_S)
 
 
 
+/** Calls a Lua function for each entity, passing it the entity and the optional table; used by the cWorld:ForEachEntityInBox() / InRadius() bindings */
+class cLuaEntityCallback :
+	public cEntityCallback
+{
+public:
+	cLuaEntityCallback(lua_State * a_LuaState, int a_FuncRef, int a_TableRef) :
+		m_LuaState(a_LuaState),
+		m_FuncRef(a_FuncRef),
+		m_TableRef(a_TableRef)
+	{
+	}
+
+protected:
+	lua_State * m_LuaState;
+	int m_FuncRef;
+	int m_TableRef;
+
+	virtual bool Item(cEntity * a_Entity) override
+	{
+		lua_rawgeti(m_LuaState, LUA_REGISTRYINDEX, m_FuncRef);  // Push function reference
+		tolua_pushusertype(m_LuaState, a_Entity, cEntity::GetClassStatic());
+		if (m_TableRef != LUA_REFNIL)
+		{
+			lua_rawgeti(m_LuaState, LUA_REGISTRYINDEX, m_TableRef);  // Push table reference
+		}
+
+		int s = lua_pcall(m_LuaState, (m_TableRef == LUA_REFNIL ? 1 : 2), 1, 0);
+		if (cLuaState::ReportErrors(m_LuaState, s))
+		{
+			return true;  // Abort enumeration
+		}
+
+		if (lua_isboolean(m_LuaState, -1))
+		{
+			return (tolua_toboolean(m_LuaState, -1, 0) > 0);
+		}
+		return false;  // Continue enumeration
+	}
+} ;
+
+
+
+
+
+/** Takes the references to the callback function and the optional table, which are the last params on the Lua stack.
+a_FuncParam is the index of the function param, as seen by the plugin (not counting self).
+Returns true on success, false (and raises a Lua error) on failure. */
+static bool GetEntityCallbackRefs(lua_State * tolua_S, int a_FuncParam, int & a_FuncRef, int & a_TableRef)
+{
+	int NumArgs = lua_gettop(tolua_S) - 1;  // This includes 'self'
+	if ((NumArgs != a_FuncParam) && (NumArgs != a_FuncParam + 1))
+	{
+		lua_do_error(tolua_S, "Error in function call '#funcname#': Requires %d or %d arguments, got %d", a_FuncParam, a_FuncParam + 1, NumArgs);
+		return false;
+	}
+	if (!lua_isfunction(tolua_S, a_FuncParam + 1))
+	{
+		lua_do_error(tolua_S, "Error in function call '#funcname#': Expected a function for parameter #%d", a_FuncParam);
+		return false;
+	}
+
+	// luaL_ref gets reference to value on top of the stack, the table is the last argument and therefore on the top
+	a_TableRef = LUA_REFNIL;
+	if (NumArgs == a_FuncParam + 1)
+	{
+		a_TableRef = luaL_ref(tolua_S, LUA_REGISTRYINDEX);
+		if (a_TableRef == LUA_REFNIL)
+		{
+			lua_do_error(tolua_S, "Error in function call '#funcname#': Could not get value reference of parameter #%d", a_FuncParam + 1);
+			return false;
+		}
+	}
+
+	// The table value is popped, and now the function is on top of the stack
+	a_FuncRef = luaL_ref(tolua_S, LUA_REGISTRYINDEX);
+	if (a_FuncRef == LUA_REFNIL)
+	{
+		luaL_unref(tolua_S, LUA_REGISTRYINDEX, a_TableRef);
+		lua_do_error(tolua_S, "Error in function call '#funcname#': Could not get function reference of parameter #%d", a_FuncParam);
+		return false;
+	}
+	return true;
+}
+
+
+
+
+
+static int tolua_cWorld_ForEachEntityInBox(lua_State * tolua_S)
+{
+	// Binding for cWorld::ForEachEntityInBox
+	// Params: cBoundingBox, function, [table]
+	
+	cWorld * self = (cWorld *)tolua_tousertype(tolua_S, 1, NULL);
+	if (self == NULL)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+	cBoundingBox * Box = (cBoundingBox *)tolua_tousertype(tolua_S, 2, NULL);
+	if (Box == NULL)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Expected a cBoundingBox for parameter #1");
+	}
+	int FuncRef, TableRef;
+	if (!GetEntityCallbackRefs(tolua_S, 2, FuncRef, TableRef))
+	{
+		return 0;
+	}
+
+	cLuaEntityCallback Callback(tolua_S, FuncRef, TableRef);
+	bool res = self->ForEachEntityInBox(*Box, Callback);
+
+	// Unreference the values again, so the LUA_REGISTRYINDEX can make place for other references
+	luaL_unref(tolua_S, LUA_REGISTRYINDEX, TableRef);
+	luaL_unref(tolua_S, LUA_REGISTRYINDEX, FuncRef);
+
+	tolua_pushboolean(tolua_S, res);
+	return 1;
+}
+
+
+
+
+
+static int tolua_cWorld_ForEachEntityInRadius(lua_State * tolua_S)
+{
+	// Binding for cWorld::ForEachEntityInRadius
+	// Params: Vector3d, number, function, [table]
+	
+	cWorld * self = (cWorld *)tolua_tousertype(tolua_S, 1, NULL);
+	if (self == NULL)
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Not called on an object instance");
+	}
+	Vector3d * Center = (Vector3d *)tolua_tousertype(tolua_S, 2, NULL);
+	if ((Center == NULL) || !lua_isnumber(tolua_S, 3))
+	{
+		return lua_do_error(tolua_S, "Error in function call '#funcname#': Expected a Vector3d and a number for parameters #1 and #2");
+	}
+	double Radius = tolua_tonumber(tolua_S, 3, 0);
+	int FuncRef, TableRef;
+	if (!GetEntityCallbackRefs(tolua_S, 3, FuncRef, TableRef))
+	{
+		return 0;
+	}
+
+	cLuaEntityCallback Callback(tolua_S, FuncRef, TableRef);
+	bool res = self->ForEachEntityInRadius(*Center, Radius, Callback);
+
+	// Unreference the values again, so the LUA_REGISTRYINDEX can make place for other references
+	luaL_unref(tolua_S, LUA_REGISTRYINDEX, TableRef);
+	luaL_unref(tolua_S, LUA_REGISTRYINDEX, FuncRef);
+
+	tolua_pushboolean(tolua_S, res);
+	return 1;
+}
+
+
+
+
+
 static int tolua_cWorld_GetBlockInfo(lua_State * tolua_S)
 {
 	// Exported manually, because tolua would generate useless additional parameters (a_BlockType .. a_BlockSkyLight)
@@ -2975,7 +3137,9 @@ void ManualBindings::Bind(lua_State * tolua_S)
 			tolua_function(tolua_S, "ForEachBlockEntityInChunk", tolua_ForEachInChunk<cWorld, cBlockEntity,   &cWorld::ForEachBlockEntityInChunk>);
 			tolua_function(tolua_S, "ForEachChestInChunk",       tolua_ForEachInChunk<cWorld, cChestEntity,   &cWorld::ForEachChestInChunk>);
 			tolua_function(tolua_S, "ForEachEntity",             tolua_ForEach<       cWorld, cEntity,        &cWorld::ForEachEntity>);
+			tolua_function(tolua_S, "ForEachEntityInBox",        tolua_cWorld_ForEachEntityInBox);
 			tolua_function(tolua_S, "ForEachEntityInChunk",      tolua_ForEachInChunk<cWorld, cEntity,        &cWorld::ForEachEntityInChunk>);
+			tolua_function(tolua_S, "ForEachEntityInRadius",     tolua_cWorld_ForEachEntityInRadius);
 			tolua_function(tolua_S, "ForEachFurnaceInChunk",     tolua_ForEachInChunk<cWorld, cFurnaceEntity, &cWorld::ForEachFurnaceInChunk>);
 			tolua_function(tolua_S, "ForEachPlayer",             tolua_ForEach<       cWorld, cPlayer,        &cWorld::ForEachPlayer>);
 			tolua_function(tolua_S, "GetBlockInfo",              tolua_cWorld_GetBlockInfo);
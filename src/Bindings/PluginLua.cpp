@@ -74,6 +74,95 @@ void cPluginLua::Close(void)
 
 
 
+void cPluginLua::AddHookTime(int a_HookType, Int64 a_StartUsec, Int64 a_EndUsec)
+{
+	Int64 Usec = a_EndUsec - a_StartUsec;
+	sHookStats & Stats = m_HookStats[a_HookType];
+	Stats.m_NumCalls += 1;
+	Stats.m_TotalUsec += Usec;
+	Stats.m_MaxUsec = std::max(Stats.m_MaxUsec, Usec);
+	
+	Int64 Budget = cPluginManager::Get()->GetHookBudgetUsec(a_HookType);
+	if ((Budget <= 0) || (Usec <= Budget))
+	{
+		return;
+	}
+	Stats.m_NumOverBudget += 1;
+	Stats.m_NumOverBudgetUnreported += 1;
+	
+	// Don't flood the log with a handler that is slow on every call:
+	if ((Stats.m_LastWarningUsec != 0) && (a_EndUsec - Stats.m_LastWarningUsec < BUDGET_WARNING_INTERVAL_USEC))
+	{
+		return;
+	}
+	const char * FnName = GetHookFnName(a_HookType);
+	LOGWARNING("Plugin %s: the %s handler took %.2f msec, the budget is %.2f msec (%d calls over the budget since the last warning)",
+		GetName().c_str(), (FnName != NULL) ? FnName : "<unknown>",
+		(double)Usec / 1000, (double)Budget / 1000,
+		Stats.m_NumOverBudgetUnreported
+	);
+	Stats.m_LastWarningUsec = a_EndUsec;
+	Stats.m_NumOverBudgetUnreported = 0;
+}
+
+
+
+
+
+int cPluginLua::GetLuaMemoryUsage(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	if (!m_LuaState.IsValid())
+	{
+		return 0;
+	}
+	return lua_gc(m_LuaState, LUA_GCCOUNT, 0) * 1024 + lua_gc(m_LuaState, LUA_GCCOUNTB, 0);
+}
+
+
+
+
+
+void cPluginLua::WriteHookStats(cCommandOutputCallback & a_Output)
+{
+	int LuaMem = GetLuaMemoryUsage();
+	cCSLock Lock(m_CriticalSection);
+	a_Output.Out("Plugin %s: Lua memory %d KiB", GetName().c_str(), (LuaMem + 1023) / 1024);
+	if (m_HookStats.empty())
+	{
+		a_Output.Out("  No hooks called yet");
+		return;
+	}
+	a_Output.Out("  %-32s %10s %10s %8s %8s %8s", "Hook", "calls", "total", "avg", "max", "over");
+	for (cHookStatsMap::const_iterator itr = m_HookStats.begin(), end = m_HookStats.end(); itr != end; ++itr)
+	{
+		const char * FnName = GetHookFnName(itr->first);
+		const sHookStats & Stats = itr->second;
+		a_Output.Out("  %-32s %10lld %10.1f %8.3f %8.2f %8lld",
+			(FnName != NULL) ? FnName : "<unknown>",
+			Stats.m_NumCalls,
+			(double)Stats.m_TotalUsec / 1000,
+			(double)Stats.m_TotalUsec / 1000 / std::max(Stats.m_NumCalls, (Int64)1),
+			(double)Stats.m_MaxUsec / 1000,
+			Stats.m_NumOverBudget
+		);
+	}
+}
+
+
+
+
+
+void cPluginLua::ResetHookStats(void)
+{
+	cCSLock Lock(m_CriticalSection);
+	m_HookStats.clear();
+}
+
+
+
+
+
 bool cPluginLua::Initialize(void)
 {
 	cCSLock Lock(m_CriticalSection);
@@ -190,6 +279,7 @@ void cPluginLua::Tick(float a_Dt)
 {
 	cCSLock Lock(m_CriticalSection);
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_TICK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_TICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Dt);
@@ -205,6 +295,7 @@ bool cPluginLua::OnBlockSpread(cWorld * a_World, int a_BlockX, int a_BlockY, int
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_BLOCK_SPREAD];
+	cHookTimer Timer(*this, cPluginManager::HOOK_BLOCK_SPREAD);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_BlockX, a_BlockY, a_BlockZ, a_Source, cLuaState::Return, res);
@@ -225,6 +316,7 @@ bool cPluginLua::OnBlockToPickups(cWorld * a_World, cEntity * a_Digger, int a_Bl
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_BLOCK_TO_PICKUPS];
+	cHookTimer Timer(*this, cPluginManager::HOOK_BLOCK_TO_PICKUPS);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_Digger, a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta, &a_Pickups, cLuaState::Return, res);
@@ -245,6 +337,7 @@ bool cPluginLua::OnChat(cPlayer * a_Player, AString & a_Message)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHAT];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHAT);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Message, cLuaState::Return, res, a_Message);
@@ -265,6 +358,7 @@ bool cPluginLua::OnChunkAvailable(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_AVAILABLE];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHUNK_AVAILABLE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -285,6 +379,7 @@ bool cPluginLua::OnChunkGenerated(cWorld * a_World, int a_ChunkX, int a_ChunkZ,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_GENERATED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHUNK_GENERATED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc, cLuaState::Return, res);
@@ -305,6 +400,7 @@ bool cPluginLua::OnChunkGenerating(cWorld * a_World, int a_ChunkX, int a_ChunkZ,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_GENERATING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHUNK_GENERATING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc, cLuaState::Return, res);
@@ -325,6 +421,7 @@ bool cPluginLua::OnChunkUnloaded(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_UNLOADED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHUNK_UNLOADED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -345,6 +442,7 @@ bool cPluginLua::OnChunkUnloading(cWorld * a_World, int a_ChunkX, int a_ChunkZ)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CHUNK_UNLOADING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CHUNK_UNLOADING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_ChunkX, a_ChunkZ, cLuaState::Return, res);
@@ -365,6 +463,7 @@ bool cPluginLua::OnCollectingPickup(cPlayer * a_Player, cPickup * a_Pickup)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_COLLECTING_PICKUP];
+	cHookTimer Timer(*this, cPluginManager::HOOK_COLLECTING_PICKUP);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Pickup, cLuaState::Return, res);
@@ -385,6 +484,7 @@ bool cPluginLua::OnCraftingNoRecipe(const cPlayer * a_Player, const cCraftingGri
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_CRAFTING_NO_RECIPE];
+	cHookTimer Timer(*this, cPluginManager::HOOK_CRAFTING_NO_RECIPE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), (cPlayer *)a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -405,6 +505,7 @@ bool cPluginLua::OnDisconnect(cPlayer * a_Player, const AString & a_Reason)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_DISCONNECT];
+	cHookTimer Timer(*this, cPluginManager::HOOK_DISCONNECT);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Reason, cLuaState::Return, res);
@@ -425,6 +526,7 @@ bool cPluginLua::OnExecuteCommand(cPlayer * a_Player, const AStringVector & a_Sp
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXECUTE_COMMAND];
+	cHookTimer Timer(*this, cPluginManager::HOOK_EXECUTE_COMMAND);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Split, cLuaState::Return, res);
@@ -445,6 +547,7 @@ bool cPluginLua::OnExploded(cWorld & a_World, double a_ExplosionSize, bool a_Can
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXPLODED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_EXPLODED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		switch (a_Source)
@@ -482,6 +585,7 @@ bool cPluginLua::OnExploding(cWorld & a_World, double & a_ExplosionSize, bool &
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_EXPLODING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_EXPLODING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		switch (a_Source)
@@ -519,6 +623,7 @@ bool cPluginLua::OnHandshake(cClientHandle * a_Client, const AString & a_Usernam
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HANDSHAKE];
+	cHookTimer Timer(*this, cPluginManager::HOOK_HANDSHAKE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Client, a_Username, cLuaState::Return, res);
@@ -540,6 +645,7 @@ bool cPluginLua::OnHopperPullingItem(cWorld & a_World, cHopperEntity & a_Hopper,
 	bool res = false;
 
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HOPPER_PULLING_ITEM];
+	cHookTimer Timer(*this, cPluginManager::HOOK_HOPPER_PULLING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Hopper, a_DstSlotNum, &a_SrcEntity, a_SrcSlotNum, cLuaState::Return, res);
@@ -560,6 +666,7 @@ bool cPluginLua::OnHopperPushingItem(cWorld & a_World, cHopperEntity & a_Hopper,
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_HOPPER_PUSHING_ITEM];
+	cHookTimer Timer(*this, cPluginManager::HOOK_HOPPER_PUSHING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Hopper, a_SrcSlotNum, &a_DstEntity, a_DstSlotNum, cLuaState::Return, res);
@@ -580,6 +687,7 @@ bool cPluginLua::OnKilling(cEntity & a_Victim, cEntity * a_Killer)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_KILLING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_KILLING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Victim, a_Killer, cLuaState::Return, res);
@@ -600,6 +708,7 @@ bool cPluginLua::OnLogin(cClientHandle * a_Client, int a_ProtocolVersion, const
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_LOGIN];
+	cHookTimer Timer(*this, cPluginManager::HOOK_LOGIN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Client, a_ProtocolVersion, a_Username, cLuaState::Return, res);
@@ -620,6 +729,7 @@ bool cPluginLua::OnPlayerAnimation(cPlayer & a_Player, int a_Animation)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_ANIMATION];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_ANIMATION);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_Animation, cLuaState::Return, res);
@@ -640,6 +750,7 @@ bool cPluginLua::OnPlayerBreakingBlock(cPlayer & a_Player, int a_BlockX, int a_B
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_BREAKING_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_BREAKING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -660,6 +771,7 @@ bool cPluginLua::OnPlayerBrokenBlock(cPlayer & a_Player, int a_BlockX, int a_Blo
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_BROKEN_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_BROKEN_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -680,6 +792,7 @@ bool cPluginLua::OnPlayerDestroyed(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_DESTROYED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_DESTROYED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -700,6 +813,7 @@ bool cPluginLua::OnPlayerEating(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_EATING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_EATING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -720,6 +834,7 @@ bool cPluginLua::OnPlayerFished(cPlayer & a_Player, const cItems & a_Reward)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_FISHED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_FISHED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_Reward, cLuaState::Return, res);
@@ -740,6 +855,7 @@ bool cPluginLua::OnPlayerFishing(cPlayer & a_Player, cItems & a_Reward)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_FISHING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_FISHING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_Reward, cLuaState::Return, res);
@@ -760,6 +876,7 @@ bool cPluginLua::OnPlayerJoined(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_JOINED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_JOINED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -780,6 +897,7 @@ bool cPluginLua::OnPlayerLeftClick(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_LEFT_CLICK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_LEFT_CLICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_Status, cLuaState::Return, res);
@@ -800,6 +918,7 @@ bool cPluginLua::OnPlayerMoved(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_MOVING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_MOVING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -820,6 +939,7 @@ bool cPluginLua::OnPlayerPlacedBlock(cPlayer & a_Player, int a_BlockX, int a_Blo
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_PLACED_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_PLACED_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -840,6 +960,7 @@ bool cPluginLua::OnPlayerPlacingBlock(cPlayer & a_Player, int a_BlockX, int a_Bl
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_PLACING_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_PLACING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -860,6 +981,7 @@ bool cPluginLua::OnPlayerRightClick(cPlayer & a_Player, int a_BlockX, int a_Bloc
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_RIGHT_CLICK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_RIGHT_CLICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -880,6 +1002,7 @@ bool cPluginLua::OnPlayerRightClickingEntity(cPlayer & a_Player, cEntity & a_Ent
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_RIGHT_CLICKING_ENTITY];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_RIGHT_CLICKING_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, &a_Entity, cLuaState::Return, res);
@@ -900,6 +1023,7 @@ bool cPluginLua::OnPlayerShooting(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_SHOOTING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_SHOOTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -920,6 +1044,7 @@ bool cPluginLua::OnPlayerSpawned(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_SPAWNED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_SPAWNED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -940,6 +1065,7 @@ bool cPluginLua::OnPlayerTossingItem(cPlayer & a_Player)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_TOSSING_ITEM];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_TOSSING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, cLuaState::Return, res);
@@ -960,6 +1086,7 @@ bool cPluginLua::OnPlayerUsedBlock(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USED_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_USED_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -980,6 +1107,7 @@ bool cPluginLua::OnPlayerUsedItem(cPlayer & a_Player, int a_BlockX, int a_BlockY
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USED_ITEM];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_USED_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -1000,6 +1128,7 @@ bool cPluginLua::OnPlayerUsingBlock(cPlayer & a_Player, int a_BlockX, int a_Bloc
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USING_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_USING_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta, cLuaState::Return, res);
@@ -1020,6 +1149,7 @@ bool cPluginLua::OnPlayerUsingItem(cPlayer & a_Player, int a_BlockX, int a_Block
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLAYER_USING_ITEM];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLAYER_USING_ITEM);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, cLuaState::Return, res);
@@ -1040,6 +1170,7 @@ bool cPluginLua::OnPluginMessage(cClientHandle & a_Client, const AString & a_Cha
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLUGIN_MESSAGE];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLUGIN_MESSAGE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Client, a_Channel, a_Message);
@@ -1060,6 +1191,7 @@ bool cPluginLua::OnPluginsLoaded(void)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PLUGINS_LOADED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PLUGINS_LOADED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		bool ret = false;
@@ -1078,6 +1210,7 @@ bool cPluginLua::OnPostCrafting(const cPlayer * a_Player, const cCraftingGrid *
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_POST_CRAFTING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_POST_CRAFTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -1098,6 +1231,7 @@ bool cPluginLua::OnPreCrafting(const cPlayer * a_Player, const cCraftingGrid * a
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PRE_CRAFTING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PRE_CRAFTING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_Player, a_Grid, a_Recipe, cLuaState::Return, res);
@@ -1118,6 +1252,7 @@ bool cPluginLua::OnProjectileHitBlock(cProjectileEntity & a_Projectile)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PROJECTILE_HIT_BLOCK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PROJECTILE_HIT_BLOCK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Projectile, cLuaState::Return, res);
@@ -1138,6 +1273,7 @@ bool cPluginLua::OnProjectileHitEntity(cProjectileEntity & a_Projectile, cEntity
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_PROJECTILE_HIT_ENTITY];
+	cHookTimer Timer(*this, cPluginManager::HOOK_PROJECTILE_HIT_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Projectile, &a_HitEntity, cLuaState::Return, res);
@@ -1158,6 +1294,7 @@ bool cPluginLua::OnSpawnedEntity(cWorld & a_World, cEntity & a_Entity)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNED_ENTITY];
+	cHookTimer Timer(*this, cPluginManager::HOOK_SPAWNED_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Entity, cLuaState::Return, res);
@@ -1178,6 +1315,7 @@ bool cPluginLua::OnSpawnedMonster(cWorld & a_World, cMonster & a_Monster)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNED_MONSTER];
+	cHookTimer Timer(*this, cPluginManager::HOOK_SPAWNED_MONSTER);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Monster, cLuaState::Return, res);
@@ -1198,6 +1336,7 @@ bool cPluginLua::OnSpawningEntity(cWorld & a_World, cEntity & a_Entity)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNING_ENTITY];
+	cHookTimer Timer(*this, cPluginManager::HOOK_SPAWNING_ENTITY);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Entity, cLuaState::Return, res);
@@ -1218,6 +1357,7 @@ bool cPluginLua::OnSpawningMonster(cWorld & a_World, cMonster & a_Monster)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_SPAWNING_MONSTER];
+	cHookTimer Timer(*this, cPluginManager::HOOK_SPAWNING_MONSTER);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, &a_Monster, cLuaState::Return, res);
@@ -1238,6 +1378,7 @@ bool cPluginLua::OnTakeDamage(cEntity & a_Receiver, TakeDamageInfo & a_TDI)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_TAKE_DAMAGE];
+	cHookTimer Timer(*this, cPluginManager::HOOK_TAKE_DAMAGE);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_Receiver, &a_TDI, cLuaState::Return, res);
@@ -1263,6 +1404,7 @@ bool cPluginLua::OnUpdatedSign(
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_UPDATED_SIGN];
+	cHookTimer Timer(*this, cPluginManager::HOOK_UPDATED_SIGN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player, cLuaState::Return, res);
@@ -1288,6 +1430,7 @@ bool cPluginLua::OnUpdatingSign(
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_UPDATING_SIGN];
+	cHookTimer Timer(*this, cPluginManager::HOOK_UPDATING_SIGN);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player, cLuaState::Return, res, a_Line1, a_Line2, a_Line3, a_Line4);
@@ -1308,6 +1451,7 @@ bool cPluginLua::OnWeatherChanged(cWorld & a_World)
 	cCSLock Lock(m_CriticalSection);
 	bool res = false;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WEATHER_CHANGED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_WEATHER_CHANGED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, cLuaState::Return, res);
@@ -1329,6 +1473,7 @@ bool cPluginLua::OnWeatherChanging(cWorld & a_World, eWeather & a_NewWeather)
 	bool res = false;
 	int NewWeather = a_NewWeather;
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WEATHER_CHANGING];
+	cHookTimer Timer(*this, cPluginManager::HOOK_WEATHER_CHANGING);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, NewWeather, cLuaState::Return, res, NewWeather);
@@ -1350,6 +1495,7 @@ bool cPluginLua::OnWorldStarted(cWorld & a_World)
 {
 	cCSLock Lock(m_CriticalSection);
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WORLD_STARTED];
+	cHookTimer Timer(*this, cPluginManager::HOOK_WORLD_STARTED);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World);
@@ -1365,6 +1511,7 @@ bool cPluginLua::OnWorldTick(cWorld & a_World, float a_Dt, int a_LastTickDuratio
 {
 	cCSLock Lock(m_CriticalSection);
 	cLuaRefs & Refs = m_HookMap[cPluginManager::HOOK_WORLD_TICK];
+	cHookTimer Timer(*this, cPluginManager::HOOK_WORLD_TICK);
 	for (cLuaRefs::iterator itr = Refs.begin(), end = Refs.end(); itr != end; ++itr)
 	{
 		m_LuaState.Call((int)(**itr), &a_World, a_Dt, a_LastTickDurationMSec);
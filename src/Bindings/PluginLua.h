@@ -12,6 +12,7 @@
 #include "Plugin.h"
 #include "WebPlugin.h"
 #include "LuaState.h"
+#include "../OSSupport/Timer.h"
 
 // Names for the global variables through which the plugin is identified in its LuaState
 #define LUA_PLUGIN_NAME_VAR_NAME     "_MCServerInternal_PluginName"
@@ -173,6 +174,15 @@ public:
 	*/
 	bool AddHookRef(int a_HookType, int a_FnRefIdx);
 	
+	/** Returns the number of bytes allocated by the plugin's LuaState */
+	int GetLuaMemoryUsage(void);
+	
+	/** Outputs the per-hook call counts and times of this plugin, and its Lua memory usage */
+	void WriteHookStats(cCommandOutputCallback & a_Output);
+	
+	/** Clears the per-hook statistics */
+	void ResetHookStats(void);
+	
 	/** Calls a function in this plugin's LuaState with parameters copied over from a_ForeignState.
 	The values that the function returns are placed onto a_ForeignState.
 	Returns the number of values returned, if successful, or negative number on failure. */
@@ -230,6 +240,61 @@ protected:
 	/** Maps hook types into arrays of Lua function references to call for each hook type */
 	typedef std::map<int, cLuaRefs> cHookMap;
 	
+	/** The cost of a single hook type in this plugin, since the last reset */
+	struct sHookStats
+	{
+		Int64 m_NumCalls;
+		Int64 m_TotalUsec;
+		Int64 m_MaxUsec;
+		
+		/** Number of calls that took longer than the hook's budget */
+		Int64 m_NumOverBudget;
+		
+		/** Number of calls over the budget since the last warning was logged */
+		int m_NumOverBudgetUnreported;
+		
+		/** The time when the last over-budget warning was logged, 0 if none yet */
+		Int64 m_LastWarningUsec;
+		
+		sHookStats(void) :
+			m_NumCalls(0),
+			m_TotalUsec(0),
+			m_MaxUsec(0),
+			m_NumOverBudget(0),
+			m_NumOverBudgetUnreported(0),
+			m_LastWarningUsec(0)
+		{
+		}
+	} ;
+	
+	typedef std::map<int, sHookStats> cHookStatsMap;
+	
+	/** Measures the time spent in the Lua handlers of a hook, from its creation to its destruction.
+	Must be created while m_CriticalSection is held, and destroyed before releasing it. */
+	class cHookTimer
+	{
+	public:
+		cHookTimer(cPluginLua & a_Plugin, int a_HookType) :
+			m_Plugin(a_Plugin),
+			m_HookType(a_HookType),
+			m_Start(a_Plugin.m_Timer.GetNowTimeUsec())
+		{
+		}
+		
+		~cHookTimer()
+		{
+			m_Plugin.AddHookTime(m_HookType, m_Start, m_Plugin.m_Timer.GetNowTimeUsec());
+		}
+		
+	protected:
+		cPluginLua & m_Plugin;
+		int m_HookType;
+		Int64 m_Start;
+	} ;
+	
+	/** Minimum time between two over-budget warnings for the same hook, in microseconds */
+	static const Int64 BUDGET_WARNING_INTERVAL_USEC = 10 * 1000 * 1000;
+	
 	cCriticalSection m_CriticalSection;
 	cLuaState m_LuaState;
 	
@@ -238,8 +303,18 @@ protected:
 	
 	cHookMap m_HookMap;
 	
+	/** The cost of each hook type that has been called; protected by m_CriticalSection */
+	cHookStatsMap m_HookStats;
+	
+	/** The time source for cHookTimer */
+	cTimer m_Timer;
+	
 	/** Releases all Lua references and closes the LuaState */
 	void Close(void);
+	
+	/** Adds a measured hook call into m_HookStats and logs a warning if it exceeded the hook's budget.
+	Assumes m_CriticalSection is held. */
+	void AddHookTime(int a_HookType, Int64 a_StartUsec, Int64 a_EndUsec);
 } ;  // tolua_export
 
 
@@ -10,6 +10,7 @@
 #include "../Server.h"
 #include "../CommandOutput.h"
 #include "../ChatColor.h"
+#include "../TickProfiler.h"
 
 #include "inifile/iniFile.h"
 #include "../Entities/Player.h"
@@ -28,8 +29,15 @@ cPluginManager * cPluginManager::Get(void)
 
 
 cPluginManager::cPluginManager(void) :
-	m_bReloadPlugins(false)
+	m_bReloadPlugins(false),
+	m_TickProfiler(&(cRoot::Get()->GetServer()->GetTickProfiler()))
 {
+	for (int i = 0; i < HOOK_NUM_HOOKS; i++)
+	{
+		const char * FnName = cPluginLua::GetHookFnName(i);
+		m_HookProfilerSections[i] = m_TickProfiler->RegisterSection(Printf("Plugin hook: %s", (FnName != NULL) ? FnName : "<unknown>"));
+		m_HookBudgetUsec[i] = 0;
+	}
 }
 
 
@@ -113,6 +121,7 @@ void cPluginManager::ReloadPluginsNow(cIniFile & a_SettingsIni)
 	FindPlugins();
 
 	cServer::BindBuiltInConsoleCommands();
+	LoadHookBudgets(a_SettingsIni);
 
 	// Check if the Plugins section exists.
 	int KeyNum = a_SettingsIni.FindKey("Plugins");
@@ -162,6 +171,56 @@ void cPluginManager::ReloadPluginsNow(cIniFile & a_SettingsIni)
 
 
 
+void cPluginManager::LoadHookBudgets(cIniFile & a_SettingsIni)
+{
+	// The default applies to all hooks, individual hooks can be overridden by their handler's name, such as "OnPlayerMoving=2":
+	double DefaultMSec = a_SettingsIni.GetValueSetF("PluginBudgets", "DefaultMSec", 20);
+	for (int i = 0; i < HOOK_NUM_HOOKS; i++)
+	{
+		double MSec = DefaultMSec;
+		const char * FnName = cPluginLua::GetHookFnName(i);
+		if (FnName != NULL)
+		{
+			MSec = a_SettingsIni.GetValueF("PluginBudgets", FnName, DefaultMSec);
+		}
+		m_HookBudgetUsec[i] = (MSec > 0) ? (Int64)(MSec * 1000) : 0;
+	}
+}
+
+
+
+
+
+void cPluginManager::LogPluginStats(cCommandOutputCallback & a_Output, bool a_ShouldReset)
+{
+	if (m_Plugins.empty())
+	{
+		a_Output.Out("No plugins loaded");
+		return;
+	}
+	for (PluginMap::iterator itr = m_Plugins.begin(), end = m_Plugins.end(); itr != end; ++itr)
+	{
+		if (itr->second == NULL)
+		{
+			continue;
+		}
+		cPluginLua * Plugin = (cPluginLua *)itr->second;
+		Plugin->WriteHookStats(a_Output);
+		if (a_ShouldReset)
+		{
+			Plugin->ResetHookStats();
+		}
+	}
+	if (a_ShouldReset)
+	{
+		a_Output.Out("Plugin statistics have been reset.");
+	}
+}
+
+
+
+
+
 void cPluginManager::InsertDefaultPlugins(cIniFile & a_SettingsIni)
 {
 	a_SettingsIni.AddKeyName("Plugins");
@@ -194,6 +253,7 @@ void cPluginManager::Tick(float a_Dt)
 	HookMap::iterator Plugins = m_Hooks.find(HOOK_TICK);
 	if (Plugins != m_Hooks.end())
 	{
+		cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_TICK]);
 		for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 		{
 			(*itr)->Tick(a_Dt);
@@ -212,6 +272,7 @@ bool cPluginManager::CallHookBlockSpread(cWorld * a_World, int a_BlockX, int a_B
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_BLOCK_SPREAD]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnBlockSpread(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Source))
@@ -237,6 +298,7 @@ bool cPluginManager::CallHookBlockToPickups(
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_BLOCK_TO_PICKUPS]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnBlockToPickups(a_World, a_Digger, a_BlockX, a_BlockY, a_BlockZ, a_BlockType, a_BlockMeta, a_Pickups))
@@ -279,6 +341,7 @@ bool cPluginManager::CallHookChat(cPlayer * a_Player, AString & a_Message)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHAT]);
 
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
@@ -302,6 +365,7 @@ bool cPluginManager::CallHookChunkAvailable(cWorld * a_World, int a_ChunkX, int
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHUNK_AVAILABLE]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnChunkAvailable(a_World, a_ChunkX, a_ChunkZ))
@@ -323,6 +387,7 @@ bool cPluginManager::CallHookChunkGenerated(cWorld * a_World, int a_ChunkX, int
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHUNK_GENERATED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnChunkGenerated(a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc))
@@ -344,6 +409,7 @@ bool cPluginManager::CallHookChunkGenerating(cWorld * a_World, int a_ChunkX, int
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHUNK_GENERATING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnChunkGenerating(a_World, a_ChunkX, a_ChunkZ, a_ChunkDesc))
@@ -365,6 +431,7 @@ bool cPluginManager::CallHookChunkUnloaded(cWorld * a_World, int a_ChunkX, int a
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHUNK_UNLOADED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnChunkUnloaded(a_World, a_ChunkX, a_ChunkZ))
@@ -386,6 +453,7 @@ bool cPluginManager::CallHookChunkUnloading(cWorld * a_World, int a_ChunkX, int
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CHUNK_UNLOADING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnChunkUnloading(a_World, a_ChunkX, a_ChunkZ))
@@ -407,6 +475,7 @@ bool cPluginManager::CallHookCollectingPickup(cPlayer * a_Player, cPickup & a_Pi
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_COLLECTING_PICKUP]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnCollectingPickup(a_Player, &a_Pickup))
@@ -428,6 +497,7 @@ bool cPluginManager::CallHookCraftingNoRecipe(const cPlayer * a_Player, const cC
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_CRAFTING_NO_RECIPE]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnCraftingNoRecipe(a_Player, a_Grid, a_Recipe))
@@ -449,6 +519,7 @@ bool cPluginManager::CallHookDisconnect(cPlayer * a_Player, const AString & a_Re
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_DISCONNECT]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnDisconnect(a_Player, a_Reason))
@@ -470,6 +541,7 @@ bool cPluginManager::CallHookExecuteCommand(cPlayer * a_Player, const AStringVec
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_EXECUTE_COMMAND]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnExecuteCommand(a_Player, a_Split))
@@ -491,6 +563,7 @@ bool cPluginManager::CallHookExploded(cWorld & a_World, double a_ExplosionSize,
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_EXPLODED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnExploded(a_World, a_ExplosionSize, a_CanCauseFire, a_X, a_Y, a_Z, a_Source, a_SourceData))
@@ -512,6 +585,7 @@ bool cPluginManager::CallHookExploding(cWorld & a_World, double & a_ExplosionSiz
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_EXPLODING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnExploding(a_World, a_ExplosionSize, a_CanCauseFire, a_X, a_Y, a_Z, a_Source, a_SourceData))
@@ -533,6 +607,7 @@ bool cPluginManager::CallHookHandshake(cClientHandle * a_ClientHandle, const ASt
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_HANDSHAKE]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnHandshake(a_ClientHandle, a_Username))
@@ -554,6 +629,7 @@ bool cPluginManager::CallHookHopperPullingItem(cWorld & a_World, cHopperEntity &
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_HOPPER_PULLING_ITEM]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnHopperPullingItem(a_World, a_Hopper, a_DstSlotNum, a_SrcEntity, a_SrcSlotNum))
@@ -575,6 +651,7 @@ bool cPluginManager::CallHookHopperPushingItem(cWorld & a_World, cHopperEntity &
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_HOPPER_PUSHING_ITEM]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnHopperPushingItem(a_World, a_Hopper, a_SrcSlotNum, a_DstEntity, a_DstSlotNum))
@@ -596,6 +673,7 @@ bool cPluginManager::CallHookKilling(cEntity & a_Victim, cEntity * a_Killer)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_KILLING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnKilling(a_Victim, a_Killer))
@@ -617,6 +695,7 @@ bool cPluginManager::CallHookLogin(cClientHandle * a_Client, int a_ProtocolVersi
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_LOGIN]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnLogin(a_Client, a_ProtocolVersion, a_Username))
@@ -638,6 +717,7 @@ bool cPluginManager::CallHookPlayerAnimation(cPlayer & a_Player, int a_Animation
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_ANIMATION]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerAnimation(a_Player, a_Animation))
@@ -659,6 +739,7 @@ bool cPluginManager::CallHookPlayerBreakingBlock(cPlayer & a_Player, int a_Block
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_BREAKING_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerBreakingBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta))
@@ -680,6 +761,7 @@ bool cPluginManager::CallHookPlayerBrokenBlock(cPlayer & a_Player, int a_BlockX,
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_BROKEN_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerBrokenBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_BlockType, a_BlockMeta))
@@ -701,6 +783,7 @@ bool cPluginManager::CallHookPlayerDestroyed(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_DESTROYED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerDestroyed(a_Player))
@@ -722,6 +805,7 @@ bool cPluginManager::CallHookPlayerEating(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_EATING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerEating(a_Player))
@@ -743,6 +827,7 @@ bool cPluginManager::CallHookPlayerFished(cPlayer & a_Player, const cItems a_Rew
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_FISHED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerFished(a_Player, a_Reward))
@@ -764,6 +849,7 @@ bool cPluginManager::CallHookPlayerFishing(cPlayer & a_Player, cItems a_Reward)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_FISHING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerFishing(a_Player, a_Reward))
@@ -785,6 +871,7 @@ bool cPluginManager::CallHookPlayerJoined(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_JOINED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerJoined(a_Player))
@@ -806,6 +893,7 @@ bool cPluginManager::CallHookPlayerLeftClick(cPlayer & a_Player, int a_BlockX, i
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_LEFT_CLICK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerLeftClick(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_Status))
@@ -827,6 +915,7 @@ bool cPluginManager::CallHookPlayerMoving(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_MOVING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerMoved(a_Player))
@@ -848,6 +937,7 @@ bool cPluginManager::CallHookPlayerPlacedBlock(cPlayer & a_Player, int a_BlockX,
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_PLACED_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerPlacedBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
@@ -869,6 +959,7 @@ bool cPluginManager::CallHookPlayerPlacingBlock(cPlayer & a_Player, int a_BlockX
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_PLACING_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerPlacingBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
@@ -890,6 +981,7 @@ bool cPluginManager::CallHookPlayerRightClick(cPlayer & a_Player, int a_BlockX,
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_RIGHT_CLICK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerRightClick(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
@@ -911,6 +1003,7 @@ bool cPluginManager::CallHookPlayerRightClickingEntity(cPlayer & a_Player, cEnti
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_RIGHT_CLICKING_ENTITY]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerRightClickingEntity(a_Player, a_Entity))
@@ -932,6 +1025,7 @@ bool cPluginManager::CallHookPlayerShooting(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_SHOOTING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerShooting(a_Player))
@@ -953,6 +1047,7 @@ bool cPluginManager::CallHookPlayerSpawned(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_SPAWNED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerSpawned(a_Player))
@@ -974,6 +1069,7 @@ bool cPluginManager::CallHookPlayerTossingItem(cPlayer & a_Player)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_TOSSING_ITEM]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerTossingItem(a_Player))
@@ -995,6 +1091,7 @@ bool cPluginManager::CallHookPlayerUsedBlock(cPlayer & a_Player, int a_BlockX, i
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_USED_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsedBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
@@ -1016,6 +1113,7 @@ bool cPluginManager::CallHookPlayerUsedItem(cPlayer & a_Player, int a_BlockX, in
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_USED_ITEM]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsedItem(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
@@ -1037,6 +1135,7 @@ bool cPluginManager::CallHookPlayerUsingBlock(cPlayer & a_Player, int a_BlockX,
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_USING_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsingBlock(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ, a_BlockType, a_BlockMeta))
@@ -1058,6 +1157,7 @@ bool cPluginManager::CallHookPlayerUsingItem(cPlayer & a_Player, int a_BlockX, i
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLAYER_USING_ITEM]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPlayerUsingItem(a_Player, a_BlockX, a_BlockY, a_BlockZ, a_BlockFace, a_CursorX, a_CursorY, a_CursorZ))
@@ -1079,6 +1179,7 @@ bool cPluginManager::CallHookPluginMessage(cClientHandle & a_Client, const AStri
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLUGIN_MESSAGE]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPluginMessage(a_Client, a_Channel, a_Message))
@@ -1100,6 +1201,7 @@ bool cPluginManager::CallHookPluginsLoaded(void)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PLUGINS_LOADED]);
 	bool res = false;
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
@@ -1119,6 +1221,7 @@ bool cPluginManager::CallHookPostCrafting(const cPlayer * a_Player, const cCraft
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_POST_CRAFTING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPostCrafting(a_Player, a_Grid, a_Recipe))
@@ -1140,6 +1243,7 @@ bool cPluginManager::CallHookPreCrafting(const cPlayer * a_Player, const cCrafti
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PRE_CRAFTING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnPreCrafting(a_Player, a_Grid, a_Recipe))
@@ -1161,6 +1265,7 @@ bool cPluginManager::CallHookProjectileHitBlock(cProjectileEntity & a_Projectile
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PROJECTILE_HIT_BLOCK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnProjectileHitBlock(a_Projectile))
@@ -1182,6 +1287,7 @@ bool cPluginManager::CallHookProjectileHitEntity(cProjectileEntity & a_Projectil
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_PROJECTILE_HIT_ENTITY]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnProjectileHitEntity(a_Projectile, a_HitEntity))
@@ -1203,6 +1309,7 @@ bool cPluginManager::CallHookSpawnedEntity(cWorld & a_World, cEntity & a_Entity)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_SPAWNED_ENTITY]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnSpawnedEntity(a_World, a_Entity))
@@ -1223,6 +1330,7 @@ bool cPluginManager::CallHookSpawnedMonster(cWorld & a_World, cMonster & a_Monst
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_SPAWNED_MONSTER]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnSpawnedMonster(a_World, a_Monster))
@@ -1243,6 +1351,7 @@ bool cPluginManager::CallHookSpawningEntity(cWorld & a_World, cEntity & a_Entity
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_SPAWNING_ENTITY]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnSpawningEntity(a_World, a_Entity))
@@ -1264,6 +1373,7 @@ bool cPluginManager::CallHookSpawningMonster(cWorld & a_World, cMonster & a_Mons
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_SPAWNING_MONSTER]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnSpawningMonster(a_World, a_Monster))
@@ -1285,6 +1395,7 @@ bool cPluginManager::CallHookTakeDamage(cEntity & a_Receiver, TakeDamageInfo & a
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_TAKE_DAMAGE]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnTakeDamage(a_Receiver, a_TDI))
@@ -1306,6 +1417,7 @@ bool cPluginManager::CallHookUpdatingSign(cWorld * a_World, int a_BlockX, int a_
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_UPDATING_SIGN]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnUpdatingSign(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player))
@@ -1327,6 +1439,7 @@ bool cPluginManager::CallHookUpdatedSign(cWorld * a_World, int a_BlockX, int a_B
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_UPDATED_SIGN]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnUpdatedSign(a_World, a_BlockX, a_BlockY, a_BlockZ, a_Line1, a_Line2, a_Line3, a_Line4, a_Player))
@@ -1348,6 +1461,7 @@ bool cPluginManager::CallHookWeatherChanged(cWorld & a_World)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_WEATHER_CHANGED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnWeatherChanged(a_World))
@@ -1369,6 +1483,7 @@ bool cPluginManager::CallHookWeatherChanging(cWorld & a_World, eWeather & a_NewW
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_WEATHER_CHANGING]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnWeatherChanging(a_World, a_NewWeather))
@@ -1390,6 +1505,7 @@ bool cPluginManager::CallHookWorldStarted(cWorld & a_World)
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_WORLD_STARTED]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnWorldStarted(a_World))
@@ -1411,6 +1527,7 @@ bool cPluginManager::CallHookWorldTick(cWorld & a_World, float a_Dt, int a_LastT
 	{
 		return false;
 	}
+	cTickProfiler::cScope ProfilerScope(*m_TickProfiler, m_HookProfilerSections[HOOK_WORLD_TICK]);
 	for (PluginList::iterator itr = Plugins->second.begin(); itr != Plugins->second.end(); ++itr)
 	{
 		if ((*itr)->OnWorldTick(a_World, a_Dt, a_LastTickDurationMSec))
@@ -47,6 +47,9 @@ class cHopperEntity;
 // fwd: BlockEntities/BlockEntityWithItems.h
 class cBlockEntityWithItems;
 
+// fwd: TickProfiler.h
+class cTickProfiler;
+
 
 
 
@@ -277,6 +280,16 @@ public:																	// tolua_export
 	Returns false if plugin not found, and the value that the callback has returned otherwise. */
 	bool DoWithPlugin(const AString & a_PluginName, cPluginCallback & a_Callback);
 	
+	/** Returns the soft time budget of a single call of the specified hook in a plugin, in microseconds; 0 if unlimited.
+	Plugins whose handlers take longer are reported in the log. */
+	Int64 GetHookBudgetUsec(int a_HookType) const
+	{
+		return IsValidHookType(a_HookType) ? m_HookBudgetUsec[a_HookType] : 0;
+	}
+	
+	/** Outputs the per-hook call counts and times of each plugin, optionally resetting them afterwards */
+	void LogPluginStats(cCommandOutputCallback & a_Output, bool a_ShouldReset);
+	
 	/** Returns the path where individual plugins' folders are expected.
 	The path doesn't end in a slash. */
 	static AString GetPluginsPath(void) { return FILE_IO_PREFIX + AString("Plugins"); }  // tolua_export
@@ -302,6 +315,19 @@ private:
 	CommandMap m_ConsoleCommands;
 
 	bool m_bReloadPlugins;
+	
+	/** The server's tick profiler, the hook calls are measured into it */
+	cTickProfiler * m_TickProfiler;
+	
+	/** The tick profiler section of each hook type */
+	int m_HookProfilerSections[HOOK_NUM_HOOKS];
+	
+	/** The soft budget of a single call of each hook type in a plugin, in microseconds; 0 if unlimited.
+	Read from the [PluginBudgets] section of settings.ini. */
+	Int64 m_HookBudgetUsec[HOOK_NUM_HOOKS];
+	
+	/** Reads the hook budgets from the settings */
+	void LoadHookBudgets(cIniFile & a_SettingsIni);
 
 	cPluginManager();
 	virtual ~cPluginManager();
@@ -9,6 +9,7 @@
 #include "OSSupport/GZipFile.h"
 #include "Blocks/BlockHandler.h"
 #include "Cuboid.h"
+#include "ChunkData.h"
 
 
 
@@ -1832,72 +1833,6 @@ cBlockArea::cChunkReader::cChunkReader(cBlockArea & a_Area) :
 
 
 
-void cBlockArea::cChunkReader::CopyNibbles(NIBBLETYPE * a_AreaDst, const NIBBLETYPE * a_ChunkSrc)
-{
-	int SizeY = m_Area.m_Size.y;
-	int MinY = m_Origin.y;
-	
-	// SizeX, SizeZ are the dmensions of the block data to copy from the current chunk (size of the geometric union)
-	// OffX, OffZ are the offsets of the current chunk data from the area origin
-	// BaseX, BaseZ are the offsets of the area data within the current chunk from the chunk borders
-	int SizeX = cChunkDef::Width;
-	int SizeZ = cChunkDef::Width;
-	int OffX, OffZ;
-	int BaseX, BaseZ;
-	OffX = m_CurrentChunkX * cChunkDef::Width - m_Origin.x;
-	if (OffX < 0)
-	{
-		BaseX = -OffX;
-		SizeX += OffX;  // SizeX is decreased, OffX is negative
-		OffX = 0;
-	}
-	else
-	{
-		BaseX = 0;
-	}
-	OffZ = m_CurrentChunkZ * cChunkDef::Width - m_Origin.z;
-	if (OffZ < 0)
-	{
-		BaseZ = -OffZ;
-		SizeZ += OffZ;  // SizeZ is decreased, OffZ is negative
-		OffZ = 0;
-	}
-	else
-	{
-		BaseZ = 0;
-	}
-	// If the chunk extends beyond the area in the X or Z axis, cut off the Size:
-	if ((m_CurrentChunkX + 1) * cChunkDef::Width > m_Origin.x + m_Area.m_Size.x)
-	{
-		SizeX -= (m_CurrentChunkX + 1) * cChunkDef::Width - (m_Origin.x + m_Area.m_Size.x);
-	}
-	if ((m_CurrentChunkZ + 1) * cChunkDef::Width > m_Origin.z + m_Area.m_Size.z)
-	{
-		SizeZ -= (m_CurrentChunkZ + 1) * cChunkDef::Width - (m_Origin.z + m_Area.m_Size.z);
-	}
-
-	for (int y = 0; y < SizeY; y++)
-	{
-		int ChunkY = MinY + y;
-		int AreaY = y;
-		for (int z = 0; z < SizeZ; z++)
-		{
-			int ChunkZ = BaseZ + z;
-			int AreaZ = OffZ + z;
-			for (int x = 0; x < SizeX; x++)
-			{
-				int ChunkX = BaseX + x;
-				int AreaX = OffX + x;
-				a_AreaDst[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = cChunkDef::GetNibble(a_ChunkSrc, ChunkX, ChunkY, ChunkZ);
-			}  // for x
-		}  // for z
-	}  // for y
-}
-
-
-
-
-
 bool cBlockArea::cChunkReader::Coords(int a_ChunkX, int a_ChunkZ)
 {
 	m_CurrentChunkX = a_ChunkX;
@@ -1909,14 +1844,8 @@ bool cBlockArea::cChunkReader::Coords(int a_ChunkX, int a_ChunkZ)
 
 
 
-void cBlockArea::cChunkReader::BlockTypes(const BLOCKTYPE * a_BlockTypes)
+void cBlockArea::cChunkReader::ChunkData(const cChunkData & a_ChunkData)
 {
-	if (m_Area.m_BlockTypes == NULL)
-	{
-		// Don't want BlockTypes
-		return;
-	}
-	
 	int SizeY = m_Area.m_Size.y;
 	int MinY = m_Origin.y;
 	
@@ -1959,6 +1888,7 @@ void cBlockArea::cChunkReader::BlockTypes(const BLOCKTYPE * a_BlockTypes)
 		SizeZ -= (m_CurrentChunkZ + 1) * cChunkDef::Width - (m_Origin.z + m_Area.m_Size.z);
 	}
 
+	// Copy whichever datatypes the area has allocated:
 	for (int y = 0; y < SizeY; y++)
 	{
 		int ChunkY = MinY + y;
@@ -1971,7 +1901,24 @@ void cBlockArea::cChunkReader::BlockTypes(const BLOCKTYPE * a_BlockTypes)
 			{
 				int ChunkX = BaseX + x;
 				int AreaX = OffX + x;
-				m_Area.m_BlockTypes[m_Area.MakeIndex(AreaX, AreaY, AreaZ)] = cChunkDef::GetBlock(a_BlockTypes, ChunkX, ChunkY, ChunkZ);
+				int AreaIdx = m_Area.MakeIndex(AreaX, AreaY, AreaZ);
+				int ChunkIdx = cChunkDef::MakeIndexNoCheck(ChunkX, ChunkY, ChunkZ);
+				if (m_Area.m_BlockTypes != NULL)
+				{
+					m_Area.m_BlockTypes[AreaIdx] = a_ChunkData.GetBlock(ChunkIdx);
+				}
+				if (m_Area.m_BlockMetas != NULL)
+				{
+					m_Area.m_BlockMetas[AreaIdx] = a_ChunkData.GetMeta(ChunkIdx);
+				}
+				if (m_Area.m_BlockLight != NULL)
+				{
+					m_Area.m_BlockLight[AreaIdx] = a_ChunkData.GetBlockLight(ChunkIdx);
+				}
+				if (m_Area.m_BlockSkyLight != NULL)
+				{
+					m_Area.m_BlockSkyLight[AreaIdx] = a_ChunkData.GetSkyLight(ChunkIdx);
+				}
 			}  // for x
 		}  // for z
 	}  // for y
@@ -1981,48 +1928,6 @@ void cBlockArea::cChunkReader::BlockTypes(const BLOCKTYPE * a_BlockTypes)
 
 
 
-void cBlockArea::cChunkReader::BlockMeta(const NIBBLETYPE * a_BlockMetas)
-{
-	if (m_Area.m_BlockMetas == NULL)
-	{
-		// Don't want metas
-		return;
-	}
-	CopyNibbles(m_Area.m_BlockMetas, a_BlockMetas);
-}
-
-
-
-
-
-void cBlockArea::cChunkReader::BlockLight(const NIBBLETYPE * a_BlockLight)
-{
-	if (m_Area.m_BlockLight == NULL)
-	{
-		// Don't want light
-		return;
-	}
-	CopyNibbles(m_Area.m_BlockLight, a_BlockLight);
-}
-
-
-
-
-
-void cBlockArea::cChunkReader::BlockSkyLight(const NIBBLETYPE * a_BlockSkyLight)
-{
-	if (m_Area.m_BlockSkyLight == NULL)
-	{
-		// Don't want skylight
-		return;
-	}
-	CopyNibbles(m_Area.m_BlockSkyLight, a_BlockSkyLight);
-}
-
-
-
-
-
 void cBlockArea::CropBlockTypes(int a_AddMinX, int a_SubMaxX, int a_AddMinY, int a_SubMaxY, int a_AddMinZ, int a_SubMaxZ)
 {
 	int NewSizeX = GetSizeX() - a_AddMinX - a_SubMaxX;
@@ -313,14 +313,9 @@ protected:
 		int m_CurrentChunkX;
 		int m_CurrentChunkZ;
 		
-		void CopyNibbles(NIBBLETYPE * a_AreaDst, const NIBBLETYPE * a_ChunkSrc);
-		
 		// cChunkDataCallback overrides:
-		virtual bool Coords       (int a_ChunkX, int a_ChunkZ) override;
-		virtual void BlockTypes   (const BLOCKTYPE *  a_BlockTypes)    override;
-		virtual void BlockMeta    (const NIBBLETYPE * a_BlockMetas)    override;
-		virtual void BlockLight   (const NIBBLETYPE * a_BlockLight)    override;
-		virtual void BlockSkyLight(const NIBBLETYPE * a_BlockSkyLight) override;
+		virtual bool Coords   (int a_ChunkX, int a_ChunkZ) override;
+		virtual void ChunkData(const cChunkData & a_ChunkData) override;
 	} ;
 	
 	typedef NIBBLETYPE * NIBBLEARRAY;
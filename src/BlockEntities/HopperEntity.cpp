@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "HopperEntity.h"
 #include "../Chunk.h"
+#include "../World.h"
 #include "../Entities/Player.h"
 #include "../Entities/Pickup.h"
 #include "../Bindings/PluginManager.h"
@@ -273,7 +274,7 @@ bool cHopperEntity::MovePickupsIn(cChunk & a_Chunk, Int64 a_CurrentTick)
 	};
 
 	cHopperPickupSearchCallback HopperPickupSearchCallback(Vector3i(GetPosX(), GetPosY(), GetPosZ()), m_Contents);
-	a_Chunk.ForEachEntity(HopperPickupSearchCallback);
+	m_World->ForEachEntityInRadius(Vector3d(GetPosX() + 0.5, GetPosY() + 1, GetPosZ() + 0.5), 0.5, HopperPickupSearchCallback);
 
 	return HopperPickupSearchCallback.FoundPickupsAbove();
 }
@@ -24,6 +24,7 @@ public:
 		NIBBLETYPE Meta = a_ChunkInterface.GetBlockMeta(a_BlockX, a_BlockY, a_BlockZ);
 		Meta ^= 0x04; // Toggle 3rd (addition/subtraction) bit with XOR
 		a_ChunkInterface.SetBlockMeta(a_BlockX, a_BlockY, a_BlockZ, Meta);
+		a_WorldInterface.WakeUpSimulators(a_BlockX, a_BlockY, a_BlockZ);
 	}
 
 
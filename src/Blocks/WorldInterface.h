@@ -37,4 +37,7 @@ public:
 
 	virtual void SetTimeOfDay(Int64 a_TimeOfDay) = 0;
 
+	/** Wakes up the simulators for the specified block; needed after changes that don't go through SetBlock(), such as SetBlockMeta() */
+	virtual void WakeUpSimulators(int a_BlockX, int a_BlockY, int a_BlockZ) = 0;
+
 };
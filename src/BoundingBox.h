@@ -77,6 +77,9 @@ public:
 	
 	// tolua_end
 	
+	const Vector3d & GetMin(void) const { return m_Min; }
+	const Vector3d & GetMax(void) const { return m_Max; }
+	
 	/// Calculates the intersection of the two bounding boxes; returns true if nonempty
 	bool Intersect(const cBoundingBox & a_Other, cBoundingBox & a_Intersection);
 	
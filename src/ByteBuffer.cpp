@@ -802,6 +802,29 @@ void cByteBuffer::ReadAll(AString & a_Data)
 
 
 
+void cByteBuffer::GetReadableParts(const char *& a_Part1, size_t & a_Size1, const char *& a_Part2, size_t & a_Size2) const
+{
+	CHECK_THREAD;
+	CheckValid();
+	a_Part1 = m_Buffer + m_ReadPos;
+	a_Part2 = m_Buffer;
+	if (m_ReadPos > m_WritePos)
+	{
+		// Wrap around the buffer end:
+		a_Size1 = m_BufferSize - m_ReadPos;
+		a_Size2 = m_WritePos;
+	}
+	else
+	{
+		a_Size1 = m_WritePos - m_ReadPos;
+		a_Size2 = 0;
+	}
+}
+
+
+
+
+
 bool cByteBuffer::ReadToByteBuffer(cByteBuffer & a_Dst, size_t a_NumBytes)
 {
 	if (!a_Dst.CanWriteBytes(a_NumBytes) || !CanReadBytes(a_NumBytes))
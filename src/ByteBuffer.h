@@ -109,6 +109,9 @@ public:
 	/// Reads all available data into a_Data
 	void ReadAll(AString & a_Data);
 	
+	/// Returns the readable data in place, as two parts (the second one is non-empty only if the data wraps around the ringbuffer end); doesn't read it
+	void GetReadableParts(const char *& a_Part1, size_t & a_Size1, const char *& a_Part2, size_t & a_Size2) const;
+	
 	/// Reads the specified number of bytes and writes it into the destinatio bytebuffer. Returns true on success.
 	bool ReadToByteBuffer(cByteBuffer & a_Dst, size_t a_NumBytes);
 	
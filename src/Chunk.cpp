@@ -31,9 +31,12 @@
 #include "Bindings/PluginManager.h"
 #include "Blocks/BlockHandler.h"
 #include "Simulator/FluidSimulator.h"
+#include "Simulator/RedstoneSimulator.h"
 #include "MobCensus.h"
 #include "MobSpawner.h"
 #include "BlockInServerPluginInterface.h"
+#include "Protocol/PacketBroadcaster.h"
+#include "Protocol/EntityPackets.h"
 
 #include "json/json.h"
 
@@ -71,6 +74,8 @@ cChunk::cChunk(
 	m_IsDirty(false),
 	m_IsSaving(false),
 	m_HasLoadFailed(false),
+	m_IsSpawnEligible(false),
+	m_ChangeCounter((UInt64)a_ChunkMap->NextChunkGeneration() << 32),
 	m_StayCount(0),
 	m_PosX(a_ChunkX),
 	m_PosY(a_ChunkY),
@@ -126,12 +131,21 @@ cChunk::~cChunk()
 	std::swap(Entities, m_Entities);  // Need another list because cEntity destructors check if they've been removed from chunk
 	for (cEntityList::const_iterator itr = Entities.begin(); itr != Entities.end(); ++itr)
 	{
+		m_ChunkMap->GetEntityIndex().Remove(*itr);
+		if ((*itr)->IsMob())
+		{
+			m_ChunkMap->GetMobCensus().MobRemoved(*(cMonster *)(*itr));
+		}
 		if (!(*itr)->IsPlayer())
 		{
 			(*itr)->Destroy(false);
 			delete *itr;
 		}
 	}
+	if (m_IsSpawnEligible)
+	{
+		m_ChunkMap->GetMobCensus().ChunkEligibilityChanged(*this, std::vector<cMonster *>(), false);
+	}
 	
 	if (m_NeighborXM != NULL)
 	{
@@ -149,6 +163,10 @@ cChunk::~cChunk()
 	{
 		m_NeighborZP->m_NeighborZM = NULL;
 	}
+	if (m_World->GetRedstoneSimulator() != NULL)
+	{
+		m_World->GetRedstoneSimulator()->DropChunk(m_PosX, m_PosZ);
+	}
 	delete m_WaterSimulatorData;
 	delete m_LavaSimulatorData;
 }
@@ -160,6 +178,7 @@ cChunk::~cChunk()
 void cChunk::SetValid(void)
 {
 	m_IsValid = true;
+	UpdateSpawnEligibility();
 	
 	m_World->GetChunkMap()->ChunkValidated();
 }
@@ -206,6 +225,9 @@ void cChunk::MarkSaved(void)
 		return;
 	}
 	m_IsDirty = false;
+	
+	// Blocks may have been dug out or exploded since the chunk was loaded, release the sections that have become empty:
+	m_ChunkData.FreeEmptySections();
 }
 
 
@@ -240,11 +262,9 @@ void cChunk::GetAllData(cChunkDataCallback & a_Callback)
 {
 	a_Callback.HeightMap    (&m_HeightMap);
 	a_Callback.BiomeData    (&m_BiomeMap);
-	a_Callback.BlockTypes   (m_BlockTypes);
-	a_Callback.BlockMeta    (m_BlockMeta);
 	a_Callback.LightIsValid (m_IsLightValid);
-	a_Callback.BlockLight   (m_BlockLight);
-	a_Callback.BlockSkyLight(m_BlockSkyLight);
+	a_Callback.ChangeCounter(m_ChangeCounter);
+	a_Callback.ChunkData    (m_ChunkData);
 	
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 	{
@@ -278,18 +298,15 @@ void cChunk::SetAllData(
 		memcpy(m_HeightMap, a_HeightMap, sizeof(m_HeightMap));
 	}
 	
-	memcpy(m_BlockTypes, a_BlockTypes, sizeof(m_BlockTypes));
-	memcpy(m_BlockMeta,  a_BlockMeta,  sizeof(m_BlockMeta));
-	if (a_BlockLight != NULL)
-	{
-		memcpy(m_BlockLight, a_BlockLight, sizeof(m_BlockLight));
-	}
-	if (a_BlockSkyLight != NULL)
-	{
-		memcpy(m_BlockSkyLight, a_BlockSkyLight, sizeof(m_BlockSkyLight));
-	}
+	// Only the sections that contain non-default data get allocated:
+	m_ChunkData.Clear();
+	m_ChunkData.SetBlockTypes(a_BlockTypes);
+	m_ChunkData.SetMetas(a_BlockMeta);
+	m_ChunkData.SetBlockLight(a_BlockLight);
+	m_ChunkData.SetSkyLight(a_BlockSkyLight);
 	
 	m_IsLightValid = (a_BlockLight != NULL) && (a_BlockSkyLight != NULL);
+	m_ChangeCounter += 1;
 	
 	if (a_HeightMap == NULL)
 	{
@@ -315,7 +332,11 @@ void cChunk::SetAllData(
 	// Set the chunk data as valid. This may be needed for some simulators that perform actions upon block adding (Vaporize)
 	SetValid();
 	
-	// Wake up all simulators for their respective blocks:
+	// Wake up all simulators for their respective blocks, the redstone simulator needs to forget the old data first:
+	if (m_World->GetRedstoneSimulator() != NULL)
+	{
+		m_World->GetRedstoneSimulator()->DropChunk(m_PosX, m_PosZ);
+	}
 	WakeUpSimulators();
 
 	m_HasLoadFailed = false;
@@ -332,9 +353,10 @@ void cChunk::SetLight(
 {
 	// TODO: We might get cases of wrong lighting when a chunk changes in the middle of a lighting calculation.
 	// Postponing until we see how bad it is :)
-	memcpy(m_BlockLight,    a_BlockLight, sizeof(m_BlockLight));
-	memcpy(m_BlockSkyLight, a_SkyLight,   sizeof(m_BlockSkyLight));
+	m_ChunkData.SetBlockLight(a_BlockLight);
+	m_ChunkData.SetSkyLight(a_SkyLight);
 	m_IsLightValid = true;
+	m_ChangeCounter += 1;
 }
 
 
@@ -343,7 +365,7 @@ void cChunk::SetLight(
 
 void cChunk::GetBlockTypes(BLOCKTYPE * a_BlockTypes)
 {
-	memcpy(a_BlockTypes, m_BlockTypes, NumBlocks);
+	m_ChunkData.CopyBlockTypes(a_BlockTypes);
 }
 
 
@@ -433,36 +455,53 @@ void cChunk::Stay(bool a_Stay)
 
 
 
-void cChunk::CollectMobCensus(cMobCensus& toFill)
+double cChunk::GetSqrDistanceToClosestPlayer(const Vector3d & a_Pos)
 {
-	toFill.CollectSpawnableChunk(*this);
-	std::list<const Vector3d*> playerPositions;
-	cPlayer* currentPlayer;
-	for (cClientHandleList::iterator itr = m_LoadedByClient.begin(), end = m_LoadedByClient.end(); itr != end; ++itr)
+	double Closest = -1;
+	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(), end = m_LoadedByClient.end(); itr != end; ++itr)
 	{
-		currentPlayer = (*itr)->GetPlayer();
-		playerPositions.push_back(&(currentPlayer->GetPosition()));
-	} 
+		cPlayer * Player = (*itr)->GetPlayer();
+		if (Player == NULL)
+		{
+			continue;
+		}
+		double SqrDist = (Player->GetPosition() - a_Pos).SqrLength();
+		if ((Closest < 0) || (SqrDist < Closest))
+		{
+			Closest = SqrDist;
+		}
+	}
+	return Closest;
+}
 
-	Vector3d currentPosition;
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+
+
+
+
+void cChunk::UpdateSpawnEligibility(void)
+{
+	bool IsEligible = m_IsValid && !m_LoadedByClient.empty();
+	if (IsEligible == m_IsSpawnEligible)
+	{
+		return;
+	}
+	m_IsSpawnEligible = IsEligible;
+	
+	std::vector<cMonster *> Monsters;
+	for (cEntityList::const_iterator itr = m_Entities.begin(), end = m_Entities.end(); itr != end; ++itr)
 	{
-		//LOGD("Counting entity #%i (%s)", (*itr)->GetUniqueID(), (*itr)->GetClass());
 		if ((*itr)->IsMob())
 		{
-			cMonster& Monster = (cMonster&)(**itr);
-			currentPosition = Monster.GetPosition();
-			for (std::list<const Vector3d*>::const_iterator itr2 = playerPositions.begin(); itr2 != playerPositions.end(); itr2 ++)
-			{
-				toFill.CollectMob(Monster,*this,(currentPosition-**itr2).SqrLength());
-			}
+			Monsters.push_back((cMonster *)(*itr));
 		}
-	}  // for itr - m_Entitites[]
+	}
+	m_ChunkMap->GetMobCensus().ChunkEligibilityChanged(*this, Monsters, IsEligible);
 }
 
 
 
 
+
 void cChunk::getThreeRandomNumber(int& a_X, int& a_Y, int& a_Z,int a_MaxX, int a_MaxY, int a_MaxZ)
 {
 	ASSERT(a_MaxX * a_MaxY * a_MaxZ * 8 < 0x00ffffff);
@@ -566,30 +605,49 @@ void cChunk::Tick(float a_Dt)
 	// Set all blocks that have been queued for setting later:
 	ProcessQueuedSetBlocks();
 
-	CheckBlocks();
+	cTickProfiler & Profiler = m_World->GetTickProfiler();
+	{
+		cTickProfiler::cScope Scope(Profiler, cTickProfiler::psChunkBlocks);
+		CheckBlocks();
+	}
 	
-	// Tick simulators:
-	m_World->GetSimulatorManager()->SimulateChunk(a_Dt, m_PosX, m_PosZ, this);
+	// Tick simulators; the simulators are shared by all the chunks and not thread-safe, so the tick workers leave them for the merge phase:
+	if (!m_ChunkMap->IsTickWorkerThread())
+	{
+		TickSimulators(a_Dt);
+	}
 	
-	TickBlocks();
+	{
+		cTickProfiler::cScope Scope(Profiler, cTickProfiler::psChunkBlocks);
+		TickBlocks();
+	}
 
 	// Tick all block entities in this chunk:
-	for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
+	if (!m_BlockEntities.empty())
 	{
-		m_IsDirty = (*itr)->Tick(a_Dt, *this) | m_IsDirty;
+		cTickProfiler::cScope Scope(Profiler, cTickProfiler::psChunkBlockEntities);
+		for (cBlockEntityList::iterator itr = m_BlockEntities.begin(); itr != m_BlockEntities.end(); ++itr)
+		{
+			m_IsDirty = (*itr)->Tick(a_Dt, *this) | m_IsDirty;
+		}
 	}
 	
 	// Tick all entities in this chunk (except mobs):
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
+	if (!m_Entities.empty())
 	{
-		// Mobs are tickes inside MobTick (as we don't have to tick them if they are far away from players)
-		if (!((*itr)->IsMob()))
+		cTickProfiler::cScope Scope(Profiler, cTickProfiler::psChunkEntities);
+		for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
 		{
-			(*itr)->Tick(a_Dt, *this);
-		}
-	}  // for itr - m_Entitites[]
+			// Mobs are tickes inside MobTick (as we don't have to tick them if they are far away from players)
+			if (!((*itr)->IsMob()))
+			{
+				(*itr)->Tick(a_Dt, *this);
+			}
+		}  // for itr - m_Entitites[]
+	}
 	
-	// Remove all entities that were scheduled for removal:
+	// Remove all entities that were scheduled for removal, update the positions of the rest in the spatial index:
+	cEntitySpatialIndex & EntityIndex = m_ChunkMap->GetEntityIndex();
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end();)
 	{
 			if ((*itr)->IsDestroyed())
@@ -597,9 +655,15 @@ void cChunk::Tick(float a_Dt)
 				LOGD("Destroying entity #%i (%s)", (*itr)->GetUniqueID(), (*itr)->GetClass());
 				cEntity * ToDelete = *itr;
 				itr = m_Entities.erase(itr);
+				EntityIndex.Remove(ToDelete);
+				if (ToDelete->IsMob())
+				{
+					m_ChunkMap->GetMobCensus().MobRemoved(*(cMonster *)ToDelete);
+				}
 				delete ToDelete;
 				continue;
 			}
+			EntityIndex.Update(*itr);
 			itr++;
 	}  // for itr - m_Entitites[]
 	
@@ -627,10 +691,20 @@ void cChunk::Tick(float a_Dt)
 
 
 
+void cChunk::TickSimulators(float a_Dt)
+{
+	cTickProfiler::cScope Scope(m_World->GetTickProfiler(), cTickProfiler::psChunkSimulators);
+	m_World->GetSimulatorManager()->SimulateChunk(a_Dt, m_PosX, m_PosZ, this);
+}
+
+
+
+
+
 void cChunk::TickBlock(int a_RelX, int a_RelY, int a_RelZ)
 {
 	unsigned Index = MakeIndex(a_RelX, a_RelY, a_RelZ);
-	cBlockHandler * Handler = BlockHandler(m_BlockTypes[Index]);
+	cBlockHandler * Handler = BlockHandler(m_ChunkData.GetBlock(Index));
 	ASSERT(Handler != NULL);  // Happenned on server restart, FS #243
 	cChunkInterface ChunkInterface(this->GetWorld()->GetChunkMap());
 	cBlockInServerPluginInterface PluginInterface(*this->GetWorld());
@@ -643,6 +717,13 @@ void cChunk::TickBlock(int a_RelX, int a_RelY, int a_RelZ)
 
 void cChunk::MoveEntityToNewChunk(cEntity * a_Entity)
 {
+	// When ticking in parallel, neither the neighbors nor the chunkmap may be touched, the destination may be in another
+	// worker's island; leave the whole move for the merge phase:
+	if (m_ChunkMap->DeferEntityMove(this, a_Entity))
+	{
+		return;
+	}
+
 	cChunk * Neighbor = GetNeighborChunk(a_Entity->GetChunkX() * cChunkDef::Width, a_Entity->GetChunkZ() * cChunkDef::Width);
 	if (Neighbor == NULL)
 	{
@@ -651,6 +732,11 @@ void cChunk::MoveEntityToNewChunk(cEntity * a_Entity)
 		{
 			// TODO: What to do with this?
 			LOGWARNING("%s: Failed to move entity, destination chunk unreachable. Entity lost", __FUNCTION__);
+			m_ChunkMap->GetEntityIndex().Remove(a_Entity);
+			if (a_Entity->IsMob())
+			{
+				m_ChunkMap->GetMobCensus().MobRemoved(*(cMonster *)a_Entity);
+			}
 			return;
 		}
 	}
@@ -731,6 +817,27 @@ void cChunk::ProcessQueuedSetBlocks(void)
 
 
 
+void cChunk::BroadcastEntityUpdate(cBroadcastPacket & a_Packet, const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ, const cClientHandle * a_Exclude)
+{
+	cPacketBroadcaster Broadcaster(a_Packet);
+	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr)
+	{
+		if (*itr == a_Exclude)
+		{
+			continue;
+		}
+		cInterestManager & Interest = (*itr)->GetInterestManager();
+		if (Interest.ShouldSendNow(a_Entity, a_Flags, a_RelX, a_RelY, a_RelZ))
+		{
+			Interest.AddSentBytes(Broadcaster.SendTo(**itr));
+		}
+	}  // for itr - LoadedByClient[]
+}
+
+
+
+
+
 void cChunk::BroadcastPendingBlockChanges(void)
 {
 	if (m_PendingSendBlocks.empty())
@@ -811,7 +918,7 @@ void cChunk::TickBlocks(void)
 		}
 
 		unsigned int Index = MakeIndexNoCheck(m_BlockTickX, m_BlockTickY, m_BlockTickZ);
-		cBlockHandler * Handler = BlockHandler(m_BlockTypes[Index]);
+		cBlockHandler * Handler = BlockHandler(m_ChunkData.GetBlock(Index));
 		ASSERT(Handler != NULL);  // Happenned on server restart, FS #243
 		Handler->OnUpdate(ChunkInterface, *this->GetWorld(), PluginInterface, *this, m_BlockTickX, m_BlockTickY, m_BlockTickZ);
 	}  // for i - tickblocks
@@ -1296,7 +1403,7 @@ void cChunk::CreateBlockEntities(void)
 		{
 			for (int y = 0; y < Height; y++)
 			{
-				BLOCKTYPE BlockType = cChunkDef::GetBlock(m_BlockTypes, x, y, z);
+				BLOCKTYPE BlockType = m_ChunkData.GetBlock(x, y, z);
 				switch (BlockType)
 				{
 					case E_BLOCK_CHEST:
@@ -1348,7 +1455,7 @@ void cChunk::WakeUpSimulators(void)
 			int BlockZ = z + BaseZ;
 			for (int y = GetHeight(x, z); y >= 0; y--)
 			{
-				BLOCKTYPE Block = cChunkDef::GetBlock(m_BlockTypes, x, y, z);
+				BLOCKTYPE Block = m_ChunkData.GetBlock(x, y, z);
 
 				// The redstone sim takes multiple blocks, use the inbuilt checker
 				if (RedstoneSimulator->IsAllowedBlock(Block))
@@ -1391,8 +1498,7 @@ void cChunk::CalculateHeightmap()
 		{
 			for (int y = Height - 1; y > -1; y--)
 			{
-				int index = MakeIndex( x, y, z );
-				if (m_BlockTypes[index] != E_BLOCK_AIR)
+				if (m_ChunkData.GetBlock(x, y, z) != E_BLOCK_AIR)
 				{
 					m_HeightMap[x + z * Width] = (unsigned char)y;
 					break;
@@ -1515,8 +1621,8 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 	ASSERT(IsValid());
 	
 	const int index = MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	const BLOCKTYPE OldBlockType = cChunkDef::GetBlock(m_BlockTypes, index);
-	const BLOCKTYPE OldBlockMeta = GetNibble(m_BlockMeta, index);
+	const BLOCKTYPE OldBlockType = m_ChunkData.GetBlock(index);
+	const BLOCKTYPE OldBlockMeta = m_ChunkData.GetMeta(index);
 	if ((OldBlockType == a_BlockType) && (OldBlockMeta == a_BlockMeta))
 	{
 		return;
@@ -1524,7 +1630,7 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 
 	MarkDirty();
 	
-	m_BlockTypes[index] = a_BlockType;
+	m_ChunkData.SetBlock(index, a_BlockType);
 
 	// The client doesn't need to distinguish between stationary and nonstationary fluids:
 	if (
@@ -1540,7 +1646,7 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 		m_PendingSendBlocks.push_back(sSetBlock(m_PosX, m_PosZ, a_RelX, a_RelY, a_RelZ, a_BlockType, a_BlockMeta));
 	}
 	
-	SetNibble(m_BlockMeta, index, a_BlockMeta);
+	m_ChunkData.SetMeta(index, a_BlockMeta);
 
 	// ONLY recalculate lighting if it's necessary!
 	if (
@@ -1563,7 +1669,7 @@ void cChunk::FastSetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockT
 		{
 			for (int y = a_RelY - 1; y > 0; --y)
 			{
-				if (m_BlockTypes[MakeIndexNoCheck(a_RelX, y, a_RelZ)] != E_BLOCK_AIR)
+				if (m_ChunkData.GetBlock(a_RelX, y, a_RelZ) != E_BLOCK_AIR)
 				{
 					m_HeightMap[a_RelX + a_RelZ * Width] = (unsigned char)y;
 					break;
@@ -1683,54 +1789,6 @@ void cChunk::SetAreaBiome(int a_MinRelX, int a_MaxRelX, int a_MinRelZ, int a_Max
 
 
 
-void cChunk::CollectPickupsByPlayer(cPlayer * a_Player)
-{
-	double PosX = a_Player->GetPosX();
-	double PosY = a_Player->GetPosY();
-	double PosZ = a_Player->GetPosZ();
-	
-	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr)
-	{
-		if ((!(*itr)->IsPickup()) && (!(*itr)->IsProjectile()))
-		{
-			continue; // Only pickups and projectiles
-		}
-		float DiffX = (float)((*itr)->GetPosX() - PosX );
-		float DiffY = (float)((*itr)->GetPosY() - PosY );
-		float DiffZ = (float)((*itr)->GetPosZ() - PosZ );
-		float SqrDist = DiffX * DiffX + DiffY * DiffY + DiffZ * DiffZ;
-		if (SqrDist < 1.5f * 1.5f)  // 1.5 block
-		{
-			/*
-			LOG("Pickup %d being collected by player \"%s\", distance %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
-			);
-			*/
-			MarkDirty();
-			if ((*itr)->IsPickup())
-			{
-				(reinterpret_cast<cPickup *>(*itr))->CollectedBy(a_Player);
-			}
-			else
-			{
-				(reinterpret_cast<cProjectileEntity *>(*itr))->CollectedBy(a_Player);
-			}
-		}
-		else if (SqrDist < 5 * 5)
-		{
-			/*
-			LOG("Pickup %d close to player \"%s\", but still too far to collect: %f",
-				(*itr)->GetUniqueID(), a_Player->GetName().c_str(), SqrDist
-			);
-			*/
-		}
-	}
-}
-
-
-
-
-
 bool cChunk::SetSignLines(int a_PosX, int a_PosY, int a_PosZ, const AString & a_Line1, const AString & a_Line2, const AString & a_Line3, const AString & a_Line4)
 {
 	// Also sends update packets to all clients in the chunk
@@ -1780,6 +1838,7 @@ bool cChunk::AddClient(cClientHandle* a_Client)
 		}
 	}
 	m_LoadedByClient.push_back( a_Client );
+	UpdateSpawnEligibility();
 
 	for (cEntityList::iterator itr = m_Entities.begin(); itr != m_Entities.end(); ++itr )
 	{
@@ -1810,6 +1869,7 @@ void cChunk::RemoveClient( cClientHandle* a_Client )
 		}
 		
 		m_LoadedByClient.erase(itr);
+		UpdateSpawnEligibility();
 
 		if (!a_Client->IsDestroyed())
 		{
@@ -1868,6 +1928,11 @@ void cChunk::AddEntity(cEntity * a_Entity)
 	ASSERT(std::find(m_Entities.begin(), m_Entities.end(), a_Entity) == m_Entities.end());  // Not there already
 	
 	m_Entities.push_back(a_Entity);
+	m_ChunkMap->GetEntityIndex().Update(a_Entity);
+	if (a_Entity->IsMob())
+	{
+		m_ChunkMap->GetMobCensus().MobAdded(*(cMonster *)a_Entity, *this, m_IsSpawnEligible);
+	}
 }
 
 
@@ -1882,6 +1947,12 @@ void cChunk::RemoveEntity(cEntity * a_Entity)
 	
 	if (SizeBefore != SizeAfter)
 	{
+		m_ChunkMap->GetEntityIndex().Remove(a_Entity);
+		if (a_Entity->IsMob())
+		{
+			m_ChunkMap->GetMobCensus().MobRemoved(*(cMonster *)a_Entity);
+		}
+		
 		// Mark as dirty if it was a server-generated entity:
 		if (!a_Entity->IsPlayer())
 		{
@@ -2450,7 +2521,7 @@ BLOCKTYPE cChunk::GetBlock(int a_RelX, int a_RelY, int a_RelZ) const
 		return 0; // Clip
 	}
 
-	return m_BlockTypes[MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ)];
+	return m_ChunkData.GetBlock(a_RelX, a_RelY, a_RelZ);
 }
 
 
@@ -2465,7 +2536,7 @@ BLOCKTYPE cChunk::GetBlock(int a_BlockIdx) const
 		return 0;
 	}
 	
-	return m_BlockTypes[ a_BlockIdx ];
+	return m_ChunkData.GetBlock(a_BlockIdx);
 }
 
 
@@ -2475,8 +2546,8 @@ BLOCKTYPE cChunk::GetBlock(int a_BlockIdx) const
 void cChunk::GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
 {
 	int Idx = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	a_BlockType = cChunkDef::GetBlock (m_BlockTypes, Idx);
-	a_BlockMeta = cChunkDef::GetNibble(m_BlockMeta,  Idx);
+	a_BlockType = m_ChunkData.GetBlock(Idx);
+	a_BlockMeta = m_ChunkData.GetMeta(Idx);
 }
 
 
@@ -2486,10 +2557,10 @@ void cChunk::GetBlockTypeMeta(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_
 void cChunk::GetBlockInfo(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_Meta, NIBBLETYPE & a_SkyLight, NIBBLETYPE & a_BlockLight)
 {
 	int Idx = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	a_BlockType  = cChunkDef::GetBlock (m_BlockTypes,    Idx);
-	a_Meta       = cChunkDef::GetNibble(m_BlockMeta,     Idx);
-	a_SkyLight   = cChunkDef::GetNibble(m_BlockSkyLight, Idx);
-	a_BlockLight = cChunkDef::GetNibble(m_BlockLight,    Idx);
+	a_BlockType  = m_ChunkData.GetBlock(Idx);
+	a_Meta       = m_ChunkData.GetMeta(Idx);
+	a_SkyLight   = m_ChunkData.GetSkyLight(Idx);
+	a_BlockLight = m_ChunkData.GetBlockLight(Idx);
 }
 
 
@@ -2781,14 +2852,8 @@ void cChunk::BroadcastEntityEquipment(const cEntity & a_Entity, short a_SlotNum,
 
 void cChunk::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr )
-	{
-		if (*itr == a_Exclude)
-		{
-			continue;
-		}
-		(*itr)->SendEntityHeadLook(a_Entity);
-	}  // for itr - LoadedByClient[]
+	cEntityHeadLookPacket Packet(a_Entity);
+	BroadcastEntityUpdate(Packet, a_Entity, cInterestManager::ufHeadLook, 0, 0, 0, a_Exclude);
 }
 
 
@@ -2797,14 +2862,8 @@ void cChunk::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHand
 
 void cChunk::BroadcastEntityLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr )
-	{
-		if (*itr == a_Exclude)
-		{
-			continue;
-		}
-		(*itr)->SendEntityLook(a_Entity);
-	}  // for itr - LoadedByClient[]
+	cEntityLookPacket Packet(a_Entity);
+	BroadcastEntityUpdate(Packet, a_Entity, cInterestManager::ufLook, 0, 0, 0, a_Exclude);
 }
 
 
@@ -2829,14 +2888,8 @@ void cChunk::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHand
 
 void cChunk::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
-	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr )
-	{
-		if (*itr == a_Exclude)
-		{
-			continue;
-		}
-		(*itr)->SendEntityRelMove(a_Entity, a_RelX, a_RelY, a_RelZ);
-	}  // for itr - LoadedByClient[]
+	cEntityRelMovePacket Packet(a_Entity, a_RelX, a_RelY, a_RelZ);
+	BroadcastEntityUpdate(Packet, a_Entity, cInterestManager::ufRelMove, a_RelX, a_RelY, a_RelZ, a_Exclude);
 }
 
 
@@ -2845,14 +2898,8 @@ void cChunk::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char
 
 void cChunk::BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
-	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr )
-	{
-		if (*itr == a_Exclude)
-		{
-			continue;
-		}
-		(*itr)->SendEntityRelMoveLook(a_Entity, a_RelX, a_RelY, a_RelZ);
-	}  // for itr - LoadedByClient[]
+	cEntityRelMoveLookPacket Packet(a_Entity, a_RelX, a_RelY, a_RelZ);
+	BroadcastEntityUpdate(Packet, a_Entity, cInterestManager::ufRelMove | cInterestManager::ufLook, a_RelX, a_RelY, a_RelZ, a_Exclude);
 }
 
 
@@ -2877,14 +2924,8 @@ void cChunk::BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, cons
 
 void cChunk::BroadcastEntityVelocity(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	for (cClientHandleList::const_iterator itr = m_LoadedByClient.begin(); itr != m_LoadedByClient.end(); ++itr )
-	{
-		if (*itr == a_Exclude)
-		{
-			continue;
-		}
-		(*itr)->SendEntityVelocity(a_Entity);
-	}  // for itr - LoadedByClient[]
+	cEntityVelocityPacket Packet(a_Entity);
+	BroadcastEntityUpdate(Packet, a_Entity, cInterestManager::ufVelocity, 0, 0, 0, a_Exclude);
 }
 
 
@@ -3,6 +3,7 @@
 
 #include "Entities/Entity.h"
 #include "ChunkDef.h"
+#include "ChunkData.h"
 
 #include "Simulator/FireSimulator.h"
 #include "Simulator/SandSimulator.h"
@@ -39,8 +40,8 @@ class cPickup;
 class cChunkDataSerializer;
 class cBlockArea;
 class cFluidSimulatorData;
-class cMobCensus;
 class cMobSpawner;
+class cBroadcastPacket;
 
 typedef std::list<cClientHandle *>         cClientHandleList;
 typedef cItemCallback<cEntity>             cEntityCallback;
@@ -122,14 +123,18 @@ public:
 	before the chunk is unloadable again. */
 	void Stay(bool a_Stay = true);
 	
-	/** Recence all mobs proximities to players in order to know what to do with them */
-	void CollectMobCensus(cMobCensus& toFill);
+	/** Returns the squared distance from the specified point to the closest player that has this chunk loaded,
+	or -1 if no client has this chunk loaded */
+	double GetSqrDistanceToClosestPlayer(const Vector3d & a_Pos);
 
 	/** Try to Spawn Monsters inside chunk */
 	void SpawnMobs(cMobSpawner& a_MobSpawner);
 
 	void Tick(float a_Dt);
 	
+	/** Runs the per-chunk step of the simulators. Called from Tick(), or, when ticking in parallel, from the merge phase */
+	void TickSimulators(float a_Dt);
+	
 	/** Ticks a single block. Used by cWorld::TickQueuedBlocks() to tick the queued blocks */
 	void TickBlock(int a_RelX, int a_RelY, int a_RelZ);
 
@@ -187,8 +192,6 @@ public:
 	Sends the chunk to all relevant clients. */
 	void SetAreaBiome(int a_MinRelX, int a_MaxRelX, int a_MinRelZ, int a_MaxRelZ, EMCSBiome a_Biome);
 	
-	void CollectPickupsByPlayer(cPlayer * a_Player);
-	
 	/** Sets the sign text. Returns true if successful. Also sends update packets to all clients in the chunk */
 	bool SetSignLines(int a_RelX, int a_RelY, int a_RelZ, const AString & a_Line1, const AString & a_Line2, const AString & a_Line3, const AString & a_Line4);
 
@@ -310,6 +313,7 @@ public:
 	{
 		m_IsDirty = true;
 		m_IsSaving = false;
+		m_ChangeCounter += 1;
 	}
 	
 	/** Sets the blockticking to start at the specified block. Only one blocktick may be set, second call overwrites the first call */
@@ -320,15 +324,15 @@ public:
 		m_BlockTickZ = a_RelZ;
 	}
 	
-	inline NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const              {return cChunkDef::GetNibble(m_BlockMeta, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetMeta(int a_BlockIdx) const                                  {return cChunkDef::GetNibble(m_BlockMeta, a_BlockIdx); }
-	inline void       SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta) {       cChunkDef::SetNibble(m_BlockMeta, a_RelX, a_RelY, a_RelZ, a_Meta); }
-	inline void       SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta)                     {       cChunkDef::SetNibble(m_BlockMeta, a_BlockIdx, a_Meta); }
+	inline NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const              {return m_ChunkData.GetMeta(a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetMeta(int a_BlockIdx) const                                  {return m_ChunkData.GetMeta(a_BlockIdx); }
+	inline void       SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta) {       m_ChunkData.SetMeta(a_RelX, a_RelY, a_RelZ, a_Meta); }
+	inline void       SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta)                     {       m_ChunkData.SetMeta(a_BlockIdx, a_Meta); }
 
-	inline NIBBLETYPE GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_BlockLight, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const {return cChunkDef::GetNibble(m_BlockSkyLight, a_RelX, a_RelY, a_RelZ); }
-	inline NIBBLETYPE GetBlockLight(int a_Idx) const {return cChunkDef::GetNibble(m_BlockLight, a_Idx); }
-	inline NIBBLETYPE GetSkyLight  (int a_Idx) const {return cChunkDef::GetNibble(m_BlockSkyLight, a_Idx); }
+	inline NIBBLETYPE GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const {return m_ChunkData.GetBlockLight(a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const {return m_ChunkData.GetSkyLight(a_RelX, a_RelY, a_RelZ); }
+	inline NIBBLETYPE GetBlockLight(int a_Idx) const {return m_ChunkData.GetBlockLight(a_Idx); }
+	inline NIBBLETYPE GetSkyLight  (int a_Idx) const {return m_ChunkData.GetSkyLight(a_Idx); }
 	
 	/** Same as GetBlock(), but relative coords needn't be in this chunk (uses m_Neighbor-s or m_ChunkMap in such a case); returns true on success */
 	bool UnboundedRelGetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta) const;
@@ -402,6 +406,12 @@ private:
 	bool m_IsDirty;        // True if the chunk has changed since it was last saved
 	bool m_IsSaving;       // True if the chunk is being saved
 	bool m_HasLoadFailed;  // True if chunk failed to load and hasn't been generated yet since then
+	bool m_IsSpawnEligible;  // True if the chunk is counted by the world's mob census as eligible for spawning (valid and loaded by a client)
+	
+	/** Incremented whenever the block data, lighting or biomes change; identifies the chunk data in the world's chunk packet cache.
+	The upper 32 bits are the chunk's generation (see cChunkMap::NextChunkGeneration()), so that the counter doesn't repeat
+	when the chunk is unloaded and loaded again. */
+	UInt64 m_ChangeCounter;
 	
 	std::vector<unsigned int> m_ToTickBlocks;
 	sSetBlockVector           m_PendingSendBlocks;  ///< Blocks that have changed and need to be sent to all clients
@@ -420,11 +430,8 @@ private:
 	cWorld *    m_World;
 	cChunkMap * m_ChunkMap;
 
-	// TODO: Make these pointers and don't allocate what isn't needed
-	BLOCKTYPE  m_BlockTypes   [cChunkDef::NumBlocks];
-	NIBBLETYPE m_BlockMeta    [cChunkDef::NumBlocks / 2];
-	NIBBLETYPE m_BlockLight   [cChunkDef::NumBlocks / 2];
-	NIBBLETYPE m_BlockSkyLight[cChunkDef::NumBlocks / 2];
+	/** The block types, metas and lighting, stored in sections that are allocated only when non-empty */
+	cChunkData m_ChunkData;
 
 	cChunkDef::HeightMap m_HeightMap;
 	cChunkDef::BiomeMap  m_BiomeMap;
@@ -462,12 +469,19 @@ private:
 	/** Wakes up each simulator for its specific blocks; through all the blocks in the chunk */
 	void WakeUpSimulators(void);
 	
+	/** Updates m_IsSpawnEligible after a change in validity or clients, and notifies the mob census if it changed */
+	void UpdateSpawnEligibility(void);
+	
 	// Makes a copy of the list
 	cClientHandleList GetAllClients(void) const {return m_LoadedByClient; }
 
 	/** Sends m_PendingSendBlocks to all clients */
 	void BroadcastPendingBlockChanges(void);
 	
+	/** Sends the entity update packet to the clients of this chunk except a_Exclude, serializing it only once per protocol version.
+	Each client's interest manager decides whether it gets the packet now or a coalesced update later (see cInterestManager). */
+	void BroadcastEntityUpdate(cBroadcastPacket & a_Packet, const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ, const cClientHandle * a_Exclude);
+	
 	/** Checks the block scheduled for checking in m_ToTickBlocks[] */
 	void CheckBlocks();
 	
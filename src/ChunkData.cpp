@@ -0,0 +1,646 @@
+// ChunkData.cpp
+
+// Implements the cChunkData class that stores the block data of a single chunk in 16-block-tall sections
+
+#include "Globals.h"
+#include "ChunkData.h"
+
+
+
+
+
+/** Number of bytes in a section-sized nibble array */
+static const size_t SectionNibbleBytes = cChunkData::SectionBlockCount / 2;
+
+
+
+
+
+cChunkData::cChunkData(void)
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		m_Sections[i] = NULL;
+	}
+}
+
+
+
+
+
+cChunkData::~cChunkData()
+{
+	Clear();
+}
+
+
+
+
+
+cChunkData::cChunkData(const cChunkData & a_Other)
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		m_Sections[i] = (a_Other.m_Sections[i] == NULL) ? NULL : new sChunkSection(*a_Other.m_Sections[i]);
+	}
+}
+
+
+
+
+
+cChunkData & cChunkData::operator =(const cChunkData & a_Other)
+{
+	if (&a_Other == this)
+	{
+		return *this;
+	}
+	for (int i = 0; i < NumSections; i++)
+	{
+		if (a_Other.m_Sections[i] == NULL)
+		{
+			delete m_Sections[i];
+			m_Sections[i] = NULL;
+		}
+		else if (m_Sections[i] == NULL)
+		{
+			m_Sections[i] = new sChunkSection(*a_Other.m_Sections[i]);
+		}
+		else
+		{
+			*m_Sections[i] = *a_Other.m_Sections[i];
+		}
+	}
+	return *this;
+}
+
+
+
+
+
+BLOCKTYPE cChunkData::GetBlock(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	ASSERT((a_RelX >= 0) && (a_RelX < cChunkDef::Width));
+	ASSERT((a_RelY >= 0) && (a_RelY < cChunkDef::Height));
+	ASSERT((a_RelZ >= 0) && (a_RelZ < cChunkDef::Width));
+	return GetBlock(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+}
+
+
+
+
+
+BLOCKTYPE cChunkData::GetBlock(int a_BlockIdx) const
+{
+	ASSERT((a_BlockIdx >= 0) && (a_BlockIdx < cChunkDef::NumBlocks));
+	const sChunkSection * Section = m_Sections[a_BlockIdx / SectionBlockCount];
+	if (Section == NULL)
+	{
+		return E_BLOCK_AIR;
+	}
+	return Section->m_BlockTypes[a_BlockIdx % SectionBlockCount];
+}
+
+
+
+
+
+void cChunkData::SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_Block)
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::SetBlock(): coords out of range!");
+		return;
+	}
+	SetBlock(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ), a_Block);
+}
+
+
+
+
+
+void cChunkData::SetBlock(int a_BlockIdx, BLOCKTYPE a_Block)
+{
+	ASSERT((a_BlockIdx >= 0) && (a_BlockIdx < cChunkDef::NumBlocks));
+	int SectionNum = a_BlockIdx / SectionBlockCount;
+	if ((m_Sections[SectionNum] == NULL) && (a_Block == E_BLOCK_AIR))
+	{
+		// Setting air into an unallocated section doesn't change anything
+		return;
+	}
+	GetOrAllocateSection(SectionNum)->m_BlockTypes[a_BlockIdx % SectionBlockCount] = a_Block;
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetMeta(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::GetMeta(): coords out of chunk range!");
+		return 0;
+	}
+	return GetMeta(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetMeta(int a_BlockIdx) const
+{
+	if ((a_BlockIdx < 0) || (a_BlockIdx >= cChunkDef::NumBlocks))
+	{
+		ASSERT(!"cChunkData::GetMeta(): index out of chunk range!");
+		return 0;
+	}
+	const sChunkSection * Section = m_Sections[a_BlockIdx / SectionBlockCount];
+	if (Section == NULL)
+	{
+		return 0;
+	}
+	return cChunkDef::GetNibble(Section->m_BlockMetas, a_BlockIdx % SectionBlockCount);
+}
+
+
+
+
+
+void cChunkData::SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta)
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::SetMeta(): coords out of chunk range!");
+		return;
+	}
+	SetMeta(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ), a_Meta);
+}
+
+
+
+
+
+void cChunkData::SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta)
+{
+	if ((a_BlockIdx < 0) || (a_BlockIdx >= cChunkDef::NumBlocks))
+	{
+		ASSERT(!"cChunkData::SetMeta(): index out of chunk range!");
+		return;
+	}
+	int SectionNum = a_BlockIdx / SectionBlockCount;
+	if ((m_Sections[SectionNum] == NULL) && ((a_Meta & 0x0f) == 0))
+	{
+		// Setting a zero meta into an unallocated section doesn't change anything
+		return;
+	}
+	cChunkDef::SetNibble(GetOrAllocateSection(SectionNum)->m_BlockMetas, a_BlockIdx % SectionBlockCount, a_Meta);
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::GetBlockLight(): coords out of chunk range!");
+		return 0;
+	}
+	return GetBlockLight(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetBlockLight(int a_BlockIdx) const
+{
+	if ((a_BlockIdx < 0) || (a_BlockIdx >= cChunkDef::NumBlocks))
+	{
+		ASSERT(!"cChunkData::GetBlockLight(): index out of chunk range!");
+		return 0;
+	}
+	const sChunkSection * Section = m_Sections[a_BlockIdx / SectionBlockCount];
+	if (Section == NULL)
+	{
+		return 0;
+	}
+	return cChunkDef::GetNibble(Section->m_BlockLight, a_BlockIdx % SectionBlockCount);
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetSkyLight(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	if (
+		(a_RelX >= cChunkDef::Width)  || (a_RelX < 0) ||
+		(a_RelY >= cChunkDef::Height) || (a_RelY < 0) ||
+		(a_RelZ >= cChunkDef::Width)  || (a_RelZ < 0)
+	)
+	{
+		ASSERT(!"cChunkData::GetSkyLight(): coords out of chunk range!");
+		return 0;
+	}
+	return GetSkyLight(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+}
+
+
+
+
+
+NIBBLETYPE cChunkData::GetSkyLight(int a_BlockIdx) const
+{
+	if ((a_BlockIdx < 0) || (a_BlockIdx >= cChunkDef::NumBlocks))
+	{
+		ASSERT(!"cChunkData::GetSkyLight(): index out of chunk range!");
+		return 0;
+	}
+	const sChunkSection * Section = m_Sections[a_BlockIdx / SectionBlockCount];
+	if (Section == NULL)
+	{
+		return 0x0f;
+	}
+	return cChunkDef::GetNibble(Section->m_BlockSkyLight, a_BlockIdx % SectionBlockCount);
+}
+
+
+
+
+
+const cChunkData::sChunkSection * cChunkData::GetSection(int a_SectionNum) const
+{
+	ASSERT((a_SectionNum >= 0) && (a_SectionNum < NumSections));
+	return m_Sections[a_SectionNum];
+}
+
+
+
+
+
+UInt16 cChunkData::GetSectionBitmask(void) const
+{
+	UInt16 Res = 0;
+	for (int i = 0; i < NumSections; i++)
+	{
+		if (m_Sections[i] != NULL)
+		{
+			Res |= static_cast<UInt16>(1 << i);
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+int cChunkData::GetNumSectionsAllocated(void) const
+{
+	int Res = 0;
+	for (int i = 0; i < NumSections; i++)
+	{
+		if (m_Sections[i] != NULL)
+		{
+			Res++;
+		}
+	}
+	return Res;
+}
+
+
+
+
+
+void cChunkData::CopyBlockTypes(BLOCKTYPE * a_Dest) const
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		BLOCKTYPE * Dest = a_Dest + i * SectionBlockCount;
+		if (m_Sections[i] == NULL)
+		{
+			memset(Dest, E_BLOCK_AIR, SectionBlockCount);
+		}
+		else
+		{
+			memcpy(Dest, m_Sections[i]->m_BlockTypes, sizeof(m_Sections[i]->m_BlockTypes));
+		}
+	}
+}
+
+
+
+
+
+void cChunkData::CopyMetas(NIBBLETYPE * a_Dest) const
+{
+	CopyNibbles(a_Dest, offsetof(sChunkSection, m_BlockMetas), 0);
+}
+
+
+
+
+
+void cChunkData::CopyBlockLight(NIBBLETYPE * a_Dest) const
+{
+	CopyNibbles(a_Dest, offsetof(sChunkSection, m_BlockLight), 0);
+}
+
+
+
+
+
+void cChunkData::CopySkyLight(NIBBLETYPE * a_Dest) const
+{
+	CopyNibbles(a_Dest, offsetof(sChunkSection, m_BlockSkyLight), DefaultSkyLightPacked);
+}
+
+
+
+
+
+void cChunkData::SetBlockTypes(const BLOCKTYPE * a_Src)
+{
+	ASSERT(a_Src != NULL);
+	for (int i = 0; i < NumSections; i++)
+	{
+		const BLOCKTYPE * Src = a_Src + i * SectionBlockCount;
+		if (m_Sections[i] != NULL)
+		{
+			memcpy(m_Sections[i]->m_BlockTypes, Src, sizeof(m_Sections[i]->m_BlockTypes));
+		}
+		else if (!IsAllValue(Src, SectionBlockCount, E_BLOCK_AIR))
+		{
+			memcpy(GetOrAllocateSection(i)->m_BlockTypes, Src, SectionBlockCount);
+		}
+	}
+}
+
+
+
+
+
+void cChunkData::SetMetas(const NIBBLETYPE * a_Src)
+{
+	ASSERT(a_Src != NULL);
+	SetNibbles(a_Src, offsetof(sChunkSection, m_BlockMetas), 0);
+}
+
+
+
+
+
+void cChunkData::SetBlockLight(const NIBBLETYPE * a_Src)
+{
+	SetNibbles(a_Src, offsetof(sChunkSection, m_BlockLight), 0);
+}
+
+
+
+
+
+void cChunkData::SetSkyLight(const NIBBLETYPE * a_Src)
+{
+	SetNibbles(a_Src, offsetof(sChunkSection, m_BlockSkyLight), DefaultSkyLightPacked);
+}
+
+
+
+
+
+void cChunkData::SetSection(
+	int a_SectionNum,
+	const BLOCKTYPE *  a_BlockTypes,
+	const NIBBLETYPE * a_BlockMetas,
+	const NIBBLETYPE * a_BlockLight,
+	const NIBBLETYPE * a_BlockSkyLight
+)
+{
+	ASSERT((a_SectionNum >= 0) && (a_SectionNum < NumSections));
+	sChunkSection * Section = GetOrAllocateSection(a_SectionNum);
+	if (a_BlockTypes != NULL)
+	{
+		memcpy(Section->m_BlockTypes, a_BlockTypes, sizeof(Section->m_BlockTypes));
+	}
+	else
+	{
+		memset(Section->m_BlockTypes, E_BLOCK_AIR, sizeof(Section->m_BlockTypes));
+	}
+	if (a_BlockMetas != NULL)
+	{
+		memcpy(Section->m_BlockMetas, a_BlockMetas, sizeof(Section->m_BlockMetas));
+	}
+	else
+	{
+		memset(Section->m_BlockMetas, 0, sizeof(Section->m_BlockMetas));
+	}
+	if (a_BlockLight != NULL)
+	{
+		memcpy(Section->m_BlockLight, a_BlockLight, sizeof(Section->m_BlockLight));
+	}
+	else
+	{
+		memset(Section->m_BlockLight, 0, sizeof(Section->m_BlockLight));
+	}
+	if (a_BlockSkyLight != NULL)
+	{
+		memcpy(Section->m_BlockSkyLight, a_BlockSkyLight, sizeof(Section->m_BlockSkyLight));
+	}
+	else
+	{
+		memset(Section->m_BlockSkyLight, DefaultSkyLightPacked, sizeof(Section->m_BlockSkyLight));
+	}
+
+	// Don't keep the section if it ended up with default data only:
+	if (IsSectionEmpty(*Section))
+	{
+		delete Section;
+		m_Sections[a_SectionNum] = NULL;
+	}
+}
+
+
+
+
+
+void cChunkData::Clear(void)
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		delete m_Sections[i];
+		m_Sections[i] = NULL;
+	}
+}
+
+
+
+
+
+void cChunkData::FreeEmptySections(void)
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		if ((m_Sections[i] != NULL) && IsSectionEmpty(*m_Sections[i]))
+		{
+			delete m_Sections[i];
+			m_Sections[i] = NULL;
+		}
+	}
+}
+
+
+
+
+
+cChunkData::sChunkSection * cChunkData::AllocateSection(void)
+{
+	sChunkSection * Section = new sChunkSection;
+	memset(Section->m_BlockTypes,    E_BLOCK_AIR,           sizeof(Section->m_BlockTypes));
+	memset(Section->m_BlockMetas,    0,                     sizeof(Section->m_BlockMetas));
+	memset(Section->m_BlockLight,    0,                     sizeof(Section->m_BlockLight));
+	memset(Section->m_BlockSkyLight, DefaultSkyLightPacked, sizeof(Section->m_BlockSkyLight));
+	return Section;
+}
+
+
+
+
+
+cChunkData::sChunkSection * cChunkData::GetOrAllocateSection(int a_SectionNum)
+{
+	if (m_Sections[a_SectionNum] == NULL)
+	{
+		m_Sections[a_SectionNum] = AllocateSection();
+	}
+	return m_Sections[a_SectionNum];
+}
+
+
+
+
+
+bool cChunkData::IsSectionEmpty(const sChunkSection & a_Section)
+{
+	return (
+		IsAllValue(a_Section.m_BlockTypes,    sizeof(a_Section.m_BlockTypes),    E_BLOCK_AIR) &&
+		IsAllValue(a_Section.m_BlockMetas,    sizeof(a_Section.m_BlockMetas),    0) &&
+		IsAllValue(a_Section.m_BlockLight,    sizeof(a_Section.m_BlockLight),    0) &&
+		IsAllValue(a_Section.m_BlockSkyLight, sizeof(a_Section.m_BlockSkyLight), DefaultSkyLightPacked)
+	);
+}
+
+
+
+
+
+bool cChunkData::IsAllValue(const void * a_Data, size_t a_Count, Byte a_Value)
+{
+	const Byte * Data = static_cast<const Byte *>(a_Data);
+	for (size_t i = 0; i < a_Count; i++)
+	{
+		if (Data[i] != a_Value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+void cChunkData::CopyNibbles(NIBBLETYPE * a_Dest, size_t a_Offset, NIBBLETYPE a_Default) const
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		NIBBLETYPE * Dest = a_Dest + i * SectionNibbleBytes;
+		if (m_Sections[i] == NULL)
+		{
+			memset(Dest, a_Default, SectionNibbleBytes);
+		}
+		else
+		{
+			memcpy(Dest, reinterpret_cast<const Byte *>(m_Sections[i]) + a_Offset, SectionNibbleBytes);
+		}
+	}
+}
+
+
+
+
+
+void cChunkData::SetNibbles(const NIBBLETYPE * a_Src, size_t a_Offset, NIBBLETYPE a_Default)
+{
+	for (int i = 0; i < NumSections; i++)
+	{
+		if (a_Src == NULL)
+		{
+			// Reset to defaults; unallocated sections already have them
+			if (m_Sections[i] != NULL)
+			{
+				memset(reinterpret_cast<Byte *>(m_Sections[i]) + a_Offset, a_Default, SectionNibbleBytes);
+			}
+			continue;
+		}
+		const NIBBLETYPE * Src = a_Src + i * SectionNibbleBytes;
+		if ((m_Sections[i] == NULL) && IsAllValue(Src, SectionNibbleBytes, a_Default))
+		{
+			continue;
+		}
+		memcpy(reinterpret_cast<Byte *>(GetOrAllocateSection(i)) + a_Offset, Src, SectionNibbleBytes);
+	}
+}
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkDataCollector:
+
+void cChunkDataCollector::ChunkData(const cChunkData & a_ChunkData)
+{
+	a_ChunkData.CopyBlockTypes(m_BlockData);
+	a_ChunkData.CopyMetas     (m_BlockData + cChunkDef::NumBlocks);
+	a_ChunkData.CopyBlockLight(m_BlockData + 3 * cChunkDef::NumBlocks / 2);
+	a_ChunkData.CopySkyLight  (m_BlockData + 2 * cChunkDef::NumBlocks);
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkDataSeparateCollector:
+
+void cChunkDataSeparateCollector::ChunkData(const cChunkData & a_ChunkData)
+{
+	a_ChunkData.CopyBlockTypes(m_BlockTypes);
+	a_ChunkData.CopyMetas     (m_BlockMetas);
+	a_ChunkData.CopyBlockLight(m_BlockLight);
+	a_ChunkData.CopySkyLight  (m_BlockSkyLight);
+}
+
+
+
+
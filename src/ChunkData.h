@@ -0,0 +1,156 @@
+// ChunkData.h
+
+// Declares the cChunkData class that stores the block data of a single chunk in 16-block-tall sections
+
+/*
+Most of a chunk's 256-block column is air above the surface, and such air has full skylight and no blocklight.
+Instead of storing the full arrays for the whole chunk, the data is split into sections 16 blocks tall,
+and a section is only allocated once any of its data differs from these defaults (air, meta 0, blocklight 0, skylight 15).
+Reading from an unallocated section returns the default values.
+*/
+
+
+
+
+
+#pragma once
+
+#include "ChunkDef.h"
+
+
+
+
+
+class cChunkData
+{
+public:
+
+	/** Height of a single section, in blocks */
+	static const int SectionHeight = 16;
+
+	/** Number of sections in a chunk */
+	static const int NumSections = cChunkDef::Height / SectionHeight;
+
+	/** Number of blocks in a single section */
+	static const int SectionBlockCount = SectionHeight * cChunkDef::Width * cChunkDef::Width;
+
+	/** The skylight value that unallocated sections report, two nibbles packed into a byte */
+	static const NIBBLETYPE DefaultSkyLightPacked = 0xff;
+
+	/** A single section, holding all the block data for SectionHeight block layers, in AXIS_ORDER ordering */
+	struct sChunkSection
+	{
+		BLOCKTYPE  m_BlockTypes   [SectionBlockCount];
+		NIBBLETYPE m_BlockMetas   [SectionBlockCount / 2];
+		NIBBLETYPE m_BlockLight   [SectionBlockCount / 2];
+		NIBBLETYPE m_BlockSkyLight[SectionBlockCount / 2];
+	} ;
+
+	cChunkData(void);
+	~cChunkData();
+
+	/** Deep-copies the allocated sections of a_Other */
+	cChunkData(const cChunkData & a_Other);
+
+	/** Deep-copies the allocated sections of a_Other, freeing any sections held by this object */
+	cChunkData & operator =(const cChunkData & a_Other);
+
+	BLOCKTYPE GetBlock(int a_RelX, int a_RelY, int a_RelZ) const;
+	BLOCKTYPE GetBlock(int a_BlockIdx) const;
+	void SetBlock(int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_Block);
+	void SetBlock(int a_BlockIdx, BLOCKTYPE a_Block);
+
+	NIBBLETYPE GetMeta(int a_RelX, int a_RelY, int a_RelZ) const;
+	NIBBLETYPE GetMeta(int a_BlockIdx) const;
+	void SetMeta(int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_Meta);
+	void SetMeta(int a_BlockIdx, NIBBLETYPE a_Meta);
+
+	NIBBLETYPE GetBlockLight(int a_RelX, int a_RelY, int a_RelZ) const;
+	NIBBLETYPE GetBlockLight(int a_BlockIdx) const;
+	NIBBLETYPE GetSkyLight  (int a_RelX, int a_RelY, int a_RelZ) const;
+	NIBBLETYPE GetSkyLight  (int a_BlockIdx) const;
+
+	/** Returns the specified section, or NULL if the section is not allocated (has all-default data) */
+	const sChunkSection * GetSection(int a_SectionNum) const;
+
+	/** Returns a bitmask of the allocated sections, bit N is set if section N is allocated */
+	UInt16 GetSectionBitmask(void) const;
+
+	/** Returns the number of sections that are currently allocated */
+	int GetNumSectionsAllocated(void) const;
+
+	/** Returns the number of bytes currently allocated for the section data */
+	size_t GetMemoryUsed(void) const { return static_cast<size_t>(GetNumSectionsAllocated()) * sizeof(sChunkSection); }
+
+	/** Copies the block types into a_Dest, which must be at least cChunkDef::NumBlocks bytes large */
+	void CopyBlockTypes(BLOCKTYPE * a_Dest) const;
+
+	/** Copies the block metas into a_Dest, which must be at least cChunkDef::NumBlocks / 2 bytes large */
+	void CopyMetas(NIBBLETYPE * a_Dest) const;
+
+	/** Copies the blocklight into a_Dest, which must be at least cChunkDef::NumBlocks / 2 bytes large */
+	void CopyBlockLight(NIBBLETYPE * a_Dest) const;
+
+	/** Copies the skylight into a_Dest, which must be at least cChunkDef::NumBlocks / 2 bytes large */
+	void CopySkyLight(NIBBLETYPE * a_Dest) const;
+
+	/** Sets all the block types from a_Src, a full chunk-sized array.
+	Sections that would contain only default data are not allocated. */
+	void SetBlockTypes(const BLOCKTYPE * a_Src);
+
+	/** Sets all the block metas from a_Src, a full chunk-sized nibble array.
+	Sections that would contain only default data are not allocated. */
+	void SetMetas(const NIBBLETYPE * a_Src);
+
+	/** Sets all the blocklight from a_Src, a full chunk-sized nibble array.
+	If a_Src is NULL, the blocklight is reset to the default value (0).
+	Sections that would contain only default data are not allocated. */
+	void SetBlockLight(const NIBBLETYPE * a_Src);
+
+	/** Sets all the skylight from a_Src, a full chunk-sized nibble array.
+	If a_Src is NULL, the skylight is reset to the default value (15).
+	Sections that would contain only default data are not allocated. */
+	void SetSkyLight(const NIBBLETYPE * a_Src);
+
+	/** Sets the data of a single section from the specified arrays; the arrays are section-sized.
+	Any of the arrays may be NULL, in which case the default value is used for that data. */
+	void SetSection(
+		int a_SectionNum,
+		const BLOCKTYPE *  a_BlockTypes,
+		const NIBBLETYPE * a_BlockMetas,
+		const NIBBLETYPE * a_BlockLight,
+		const NIBBLETYPE * a_BlockSkyLight
+	);
+
+	/** Frees all the sections, resetting the data to the defaults */
+	void Clear(void);
+
+	/** Frees the sections that contain only default data */
+	void FreeEmptySections(void);
+
+protected:
+
+	sChunkSection * m_Sections[NumSections];
+
+	/** Allocates a new section with all-default data */
+	static sChunkSection * AllocateSection(void);
+
+	/** Returns the section for the specified section number, allocating it if needed */
+	sChunkSection * GetOrAllocateSection(int a_SectionNum);
+
+	/** Returns true if the section contains only default data */
+	static bool IsSectionEmpty(const sChunkSection & a_Section);
+
+	/** Returns true if all a_Count bytes of a_Data are equal to a_Value */
+	static bool IsAllValue(const void * a_Data, size_t a_Count, Byte a_Value);
+
+	/** Copies a nibble array section-by-section into a_Dest, filling unallocated sections with a_Default */
+	void CopyNibbles(NIBBLETYPE * a_Dest, size_t a_Offset, NIBBLETYPE a_Default) const;
+
+	/** Sets a nibble array section-by-section from a_Src; NULL means a_Default everywhere */
+	void SetNibbles(const NIBBLETYPE * a_Src, size_t a_Offset, NIBBLETYPE a_Default);
+} ;
+
+
+
+
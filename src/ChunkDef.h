@@ -35,6 +35,7 @@ class cBlockEntity;
 class cEntity;
 class cClientHandle;
 class cBlockEntity;
+class cChunkData;
 
 typedef std::list<cEntity *>        cEntityList;
 typedef std::list<cBlockEntity *>   cBlockEntityList;
@@ -317,20 +318,16 @@ public:
 	/// Called once to provide biome data
 	virtual void BiomeData    (const cChunkDef::BiomeMap * a_BiomeMap) {UNUSED(a_BiomeMap); };
 	
-	/// Called once to export block types
-	virtual void BlockTypes   (const BLOCKTYPE * a_Type) {UNUSED(a_Type); };
-	
-	/// Called once to export block meta
-	virtual void BlockMeta    (const NIBBLETYPE * a_Meta) {UNUSED(a_Meta); };
-	
-	/// Called once to let know if the chunk lighting is valid. Return value is used to control if BlockLight() and BlockSkyLight() are called next (if true)
+	/** Called once to let know if the chunk lighting is valid. Return value is ignored */
 	virtual bool LightIsValid(bool a_IsLightValid) {UNUSED(a_IsLightValid); return true; };
 
-	/// Called once to export block light
-	virtual void BlockLight   (const NIBBLETYPE * a_BlockLight) {UNUSED(a_BlockLight); };
+	/** Called once to provide the chunk's change counter. The counter is unique within the world for each loaded instance
+	of a chunk and incremented whenever its block data, lighting or biomes change, so two queries reporting the same counter
+	have returned the same data, even if the chunk has been unloaded and reloaded in between. */
+	virtual void ChangeCounter(UInt64 a_ChangeCounter) {UNUSED(a_ChangeCounter); };
 	
-	/// Called once to export sky light
-	virtual void BlockSkyLight(const NIBBLETYPE * a_SkyLight) {UNUSED(a_SkyLight); };
+	/** Called once to export the block data (types, metas, blocklight, skylight), stored in sections */
+	virtual void ChunkData(const cChunkData & a_ChunkData) {UNUSED(a_ChunkData); };
 	
 	/// Called for each entity in the chunk
 	virtual void Entity(cEntity * a_Entity) {UNUSED(a_Entity); };
@@ -343,6 +340,23 @@ public:
 
 
 
+/** Anything that can provide the chunk data through the cChunkDataCallback interface.
+Implemented by cChunkMap for the chunks of a world; tools working without a world, such as the pregenerator,
+implement it over their own chunk storage, so that the lighting and storage code can be used with it. */
+class cChunkDataSource abstract
+{
+public:
+
+	virtual ~cChunkDataSource() {}
+
+	/** Calls the callbacks of a_Callback with the data of the chunk; returns false if the chunk is not available */
+	virtual bool GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback) = 0;
+} ;
+
+
+
+
+
 /** A simple implementation of the cChunkDataCallback interface that collects all block data into a single buffer
 */
 class cChunkDataCollector :
@@ -355,28 +369,8 @@ public:
 
 protected:
 
-	virtual void BlockTypes(const BLOCKTYPE * a_BlockTypes) override
-	{
-		memcpy(m_BlockData, a_BlockTypes, sizeof(cChunkDef::BlockTypes));
-	}
-
-
-	virtual void BlockMeta(const NIBBLETYPE * a_BlockMeta) override
-	{
-		memcpy(m_BlockData + cChunkDef::NumBlocks, a_BlockMeta, cChunkDef::NumBlocks / 2);
-	}
-
-
-	virtual void BlockLight(const NIBBLETYPE * a_BlockLight) override
-	{
-		memcpy(m_BlockData + 3 * cChunkDef::NumBlocks / 2, a_BlockLight, cChunkDef::NumBlocks / 2);
-	}
-
-
-	virtual void BlockSkyLight(const NIBBLETYPE * a_BlockSkyLight) override
-	{
-		memcpy(m_BlockData + 2 * cChunkDef::NumBlocks, a_BlockSkyLight, cChunkDef::NumBlocks / 2);
-	}
+	// cChunkDataCallback overrides (implemented in ChunkData.cpp):
+	virtual void ChunkData(const cChunkData & a_ChunkData) override;
 } ;
 
 
@@ -397,28 +391,8 @@ public:
 
 protected:
 
-	virtual void BlockTypes(const BLOCKTYPE * a_BlockTypes) override
-	{
-		memcpy(m_BlockTypes, a_BlockTypes, sizeof(m_BlockTypes));
-	}
-
-
-	virtual void BlockMeta(const NIBBLETYPE * a_BlockMeta) override
-	{
-		memcpy(m_BlockMetas, a_BlockMeta, sizeof(m_BlockMetas));
-	}
-
-
-	virtual void BlockLight(const NIBBLETYPE * a_BlockLight) override
-	{
-		memcpy(m_BlockLight, a_BlockLight, sizeof(m_BlockLight));
-	}
-
-
-	virtual void BlockSkyLight(const NIBBLETYPE * a_BlockSkyLight) override
-	{
-		memcpy(m_BlockSkyLight, a_BlockSkyLight, sizeof(m_BlockSkyLight));
-	}
+	// cChunkDataCallback overrides (implemented in ChunkData.cpp):
+	virtual void ChunkData(const cChunkData & a_ChunkData) override;
 } ;
 
 
@@ -481,10 +455,25 @@ public:
 	{
 		return ((m_ChunkX == a_Other.m_ChunkX) && (m_ChunkY == a_Other.m_ChunkY) && (m_ChunkZ == a_Other.m_ChunkZ));
 	}
+	
+	/** Provides an arbitrary strict ordering, so that the coords can be used in std::set and as std::map keys */
+	bool operator < (const cChunkCoords & a_Other) const
+	{
+		if (m_ChunkX != a_Other.m_ChunkX)
+		{
+			return (m_ChunkX < a_Other.m_ChunkX);
+		}
+		if (m_ChunkZ != a_Other.m_ChunkZ)
+		{
+			return (m_ChunkZ < a_Other.m_ChunkZ);
+		}
+		return (m_ChunkY < a_Other.m_ChunkY);
+	}
 } ;
 
 typedef std::list<cChunkCoords> cChunkCoordsList;
 typedef std::vector<cChunkCoords> cChunkCoordsVector;
+typedef std::set<cChunkCoords> cChunkCoordsSet;
 
 
 
@@ -12,10 +12,12 @@
 #include "BlockArea.h"
 #include "Bindings/PluginManager.h"
 #include "Entities/TNTEntity.h"
+#include "Entities/ProjectileEntity.h"
 #include "Blocks/BlockHandler.h"
 #include "MobCensus.h"
 #include "MobSpawner.h"
 #include "BoundingBox.h"
+#include "ChunkTickPool.h"
 
 #include "Entities/Pickup.h"
 
@@ -30,11 +32,45 @@
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+// cChunkMap::cTickIsland:
+
+/** Ticks all the layers of a single island; run by one of the tick workers */
+class cChunkMap::cTickIsland :
+	public cChunkTickPool::cTask
+{
+public:
+	cTickIsland(cChunkLayerPtrs & a_Layers, float a_Dt) :
+		m_Layers(&a_Layers),
+		m_Dt(a_Dt)
+	{
+	}
+	
+	virtual void Run(void) override
+	{
+		for (cChunkLayerPtrs::iterator itr = m_Layers->begin(), end = m_Layers->end(); itr != end; ++itr)
+		{
+			(*itr)->Tick(m_Dt);
+		}
+	}
+	
+protected:
+	cChunkLayerPtrs * m_Layers;
+	float m_Dt;
+} ;
+
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // cChunkMap:
 
 cChunkMap::cChunkMap(cWorld * a_World )
-	: m_World( a_World )
+	: m_NumChunksCreated(0)
+	, m_TickPool(NULL)
+	, m_MobCensus(new cMobCensus)
+	, m_World( a_World )
 {
 }
 
@@ -44,12 +80,19 @@ cChunkMap::cChunkMap(cWorld * a_World )
 
 cChunkMap::~cChunkMap()
 {
+	delete m_TickPool;
+	m_TickPool = NULL;
+	
 	cCSLock Lock(m_CSLayers);
 	while (!m_Layers.empty())
 	{
 		delete m_Layers.back();
 		m_Layers.pop_back();  // Must pop, because further chunk deletions query the chunkmap for entities and that would touch deleted data
 	}
+	
+	// The chunks remove their mobs from the census when deleted, so it must outlive them:
+	delete m_MobCensus;
+	m_MobCensus = NULL;
 }
 
 
@@ -58,7 +101,7 @@ cChunkMap::~cChunkMap()
 
 void cChunkMap::RemoveLayer( cChunkLayer* a_Layer )
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	m_Layers.remove(a_Layer);
 }
 
@@ -68,7 +111,7 @@ void cChunkMap::RemoveLayer( cChunkLayer* a_Layer )
 
 cChunkMap::cChunkLayer * cChunkMap::GetLayer(int a_LayerX, int a_LayerZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
 		if (((*itr)->GetX() == a_LayerX) && ((*itr)->GetZ() == a_LayerZ))
@@ -105,7 +148,7 @@ cChunkMap::cChunkLayer * cChunkMap::FindLayerForChunk(int a_ChunkX, int a_ChunkZ
 
 cChunkMap::cChunkLayer * cChunkMap::FindLayer(int a_LayerX, int a_LayerZ)
 {
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
@@ -137,7 +180,7 @@ cChunkMap::cChunkLayer * cChunkMap::GetLayerForChunk(int a_ChunkX, int a_ChunkZ)
 cChunkPtr cChunkMap::GetChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
 	// No need to lock m_CSLayers, since it's already locked by the operation that called us
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 
 	cChunkLayer * Layer = GetLayerForChunk( a_ChunkX, a_ChunkZ );
 	if (Layer == NULL)
@@ -209,7 +252,7 @@ cChunkPtr cChunkMap::GetChunkNoLoad( int a_ChunkX, int a_ChunkY, int a_ChunkZ )
 bool cChunkMap::LockedGetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
 {
 	// We already have m_CSLayers locked since this can be called only from within the tick thread
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
@@ -232,7 +275,7 @@ bool cChunkMap::LockedGetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTY
 bool cChunkMap::LockedGetBlockType(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE & a_BlockType)
 {
 	// We already have m_CSLayers locked since this can be called only from within the tick thread
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
@@ -254,7 +297,7 @@ bool cChunkMap::LockedGetBlockType(int a_BlockX, int a_BlockY, int a_BlockZ, BLO
 bool cChunkMap::LockedGetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE & a_BlockMeta)
 {
 	// We already have m_CSLayers locked since this can be called only from within the tick thread
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 	
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
@@ -313,7 +356,7 @@ bool cChunkMap::LockedFastSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLO
 
 cChunk * cChunkMap::FindChunk(int a_ChunkX, int a_ChunkZ)
 {
-	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	ASSERT(GetCS().IsLockedByCurrentThread());
 	
 	cChunkLayer * Layer = FindLayerForChunk(a_ChunkX, a_ChunkZ);
 	if (Layer == NULL)
@@ -329,7 +372,7 @@ cChunk * cChunkMap::FindChunk(int a_ChunkX, int a_ChunkZ)
 
 void cChunkMap::BroadcastAttachEntity(const cEntity & a_Entity, const cEntity * a_Vehicle)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -345,7 +388,7 @@ void cChunkMap::BroadcastAttachEntity(const cEntity & a_Entity, const cEntity *
 
 void cChunkMap::BroadcastBlockAction(int a_BlockX, int a_BlockY, int a_BlockZ, char a_Byte1, char a_Byte2, BLOCKTYPE a_BlockType, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int x, y, z, ChunkX, ChunkZ;
 	x = a_BlockX;
 	y = a_BlockY;
@@ -366,7 +409,7 @@ void cChunkMap::BroadcastBlockAction(int a_BlockX, int a_BlockY, int a_BlockZ, c
 
 void cChunkMap::BroadcastBlockBreakAnimation(int a_entityID, int a_blockX, int a_blockY, int a_blockZ, char a_stage, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 
 	cChunkDef::BlockToChunk(a_blockX, a_blockZ, ChunkX, ChunkZ);
@@ -385,7 +428,7 @@ void cChunkMap::BroadcastBlockBreakAnimation(int a_entityID, int a_blockX, int a
 
 void cChunkMap::BroadcastBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, 0, ChunkZ);
@@ -402,7 +445,7 @@ void cChunkMap::BroadcastBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, c
 
 void cChunkMap::BroadcastChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataSerializer & a_Serializer, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, 0, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -418,7 +461,7 @@ void cChunkMap::BroadcastChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataSeriali
 
 void cChunkMap::BroadcastCollectPickup(const cPickup & a_Pickup, const cPlayer & a_Player, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Pickup.GetChunkX(), ZERO_CHUNK_Y, a_Pickup.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -434,7 +477,7 @@ void cChunkMap::BroadcastCollectPickup(const cPickup & a_Pickup, const cPlayer &
 
 void cChunkMap::BroadcastDestroyEntity(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -450,7 +493,7 @@ void cChunkMap::BroadcastDestroyEntity(const cEntity & a_Entity, const cClientHa
 
 void cChunkMap::BroadcastEntityEffect(const cEntity & a_Entity, int a_EffectID, int a_Amplifier, short a_Duration, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -466,7 +509,7 @@ void cChunkMap::BroadcastEntityEffect(const cEntity & a_Entity, int a_EffectID,
 
 void cChunkMap::BroadcastEntityEquipment(const cEntity & a_Entity, short a_SlotNum, const cItem & a_Item, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -482,7 +525,7 @@ void cChunkMap::BroadcastEntityEquipment(const cEntity & a_Entity, short a_SlotN
 
 void cChunkMap::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -498,7 +541,7 @@ void cChunkMap::BroadcastEntityHeadLook(const cEntity & a_Entity, const cClientH
 
 void cChunkMap::BroadcastEntityLook(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -514,7 +557,7 @@ void cChunkMap::BroadcastEntityLook(const cEntity & a_Entity, const cClientHandl
 
 void cChunkMap::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -530,7 +573,7 @@ void cChunkMap::BroadcastEntityMetadata(const cEntity & a_Entity, const cClientH
 
 void cChunkMap::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -546,7 +589,7 @@ void cChunkMap::BroadcastEntityRelMove(const cEntity & a_Entity, char a_RelX, ch
 
 void cChunkMap::BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -562,7 +605,7 @@ void cChunkMap::BroadcastEntityRelMoveLook(const cEntity & a_Entity, char a_RelX
 
 void cChunkMap::BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -578,7 +621,7 @@ void cChunkMap::BroadcastEntityStatus(const cEntity & a_Entity, char a_Status, c
 
 void cChunkMap::BroadcastEntityVelocity(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -594,7 +637,7 @@ void cChunkMap::BroadcastEntityVelocity(const cEntity & a_Entity, const cClientH
 
 void cChunkMap::BroadcastEntityAnimation(const cEntity & a_Entity, char a_Animation, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -610,7 +653,7 @@ void cChunkMap::BroadcastEntityAnimation(const cEntity & a_Entity, char a_Animat
 
 void cChunkMap::BroadcastParticleEffect(const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmmount, cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 
 	cChunkDef::BlockToChunk((int) a_SrcX, (int) a_SrcZ, ChunkX, ChunkZ);
@@ -629,7 +672,7 @@ void cChunkMap::BroadcastParticleEffect(const AString & a_ParticleName, float a_
 
 void cChunkMap::BroadcastRemoveEntityEffect(const cEntity & a_Entity, int a_EffectID, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
@@ -646,7 +689,7 @@ void cChunkMap::BroadcastRemoveEntityEffect(const cEntity & a_Entity, int a_Effe
 
 void cChunkMap::BroadcastSoundEffect(const AString & a_SoundName, int a_SrcX, int a_SrcY, int a_SrcZ, float a_Volume, float a_Pitch, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 
 	cChunkDef::BlockToChunk(a_SrcX / 8, a_SrcZ / 8, ChunkX, ChunkZ);
@@ -665,7 +708,7 @@ void cChunkMap::BroadcastSoundEffect(const AString & a_SoundName, int a_SrcX, in
 
 void cChunkMap::BroadcastSoundParticleEffect(int a_EffectID, int a_SrcX, int a_SrcY, int a_SrcZ, int a_Data, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 
 	cChunkDef::BlockToChunk(a_SrcX, a_SrcZ, ChunkX, ChunkZ);
@@ -684,7 +727,7 @@ void cChunkMap::BroadcastSoundParticleEffect(int a_EffectID, int a_SrcX, int a_S
 
 void cChunkMap::BroadcastSpawnEntity(cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity.GetChunkX(), ZERO_CHUNK_Y, a_Entity.GetChunkZ());
 	if (Chunk == NULL)
 	{
@@ -700,7 +743,7 @@ void cChunkMap::BroadcastSpawnEntity(cEntity & a_Entity, const cClientHandle * a
 
 void cChunkMap::BroadcastThunderbolt(int a_BlockX, int a_BlockY, int a_BlockZ, const cClientHandle * a_Exclude)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, 0, ChunkZ);
@@ -718,7 +761,7 @@ void cChunkMap::BroadcastThunderbolt(int a_BlockX, int a_BlockY, int a_BlockZ, c
 
 void cChunkMap::BroadcastUseBed(const cEntity & a_Entity, int a_BlockX, int a_BlockY, int a_BlockZ )
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
@@ -737,7 +780,7 @@ void cChunkMap::BroadcastUseBed(const cEntity & a_Entity, int a_BlockX, int a_Bl
 
 void cChunkMap::SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClientHandle & a_Client)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, 0, ChunkZ);
@@ -755,7 +798,7 @@ void cChunkMap::SendBlockEntity(int a_BlockX, int a_BlockY, int a_BlockZ, cClien
 void cChunkMap::UseBlockEntity(cPlayer * a_Player, int a_BlockX, int a_BlockY, int a_BlockZ)
 {
 	// a_Player rclked block entity at the coords specified, handle it
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, 0, ChunkZ);
@@ -772,7 +815,7 @@ void cChunkMap::UseBlockEntity(cPlayer * a_Player, int a_BlockX, int a_BlockY, i
 
 bool cChunkMap::DoWithChunk(int a_ChunkX, int a_ChunkZ, cChunkCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -787,7 +830,7 @@ bool cChunkMap::DoWithChunk(int a_ChunkX, int a_ChunkZ, cChunkCallback & a_Callb
 
 void cChunkMap::WakeUpSimulators(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, 0, ChunkZ);
@@ -846,7 +889,7 @@ void cChunkMap::WakeUpSimulatorsInArea(int a_MinBlockX, int a_MaxBlockX, int a_M
 
 void cChunkMap::MarkChunkDirty (int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
@@ -861,7 +904,7 @@ void cChunkMap::MarkChunkDirty (int a_ChunkX, int a_ChunkZ)
 
 void cChunkMap::MarkChunkSaving(int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
@@ -876,7 +919,7 @@ void cChunkMap::MarkChunkSaving(int a_ChunkX, int a_ChunkZ)
 
 void cChunkMap::MarkChunkSaved (int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
@@ -902,7 +945,7 @@ void cChunkMap::SetChunkData(
 )
 {
 	{
-		cCSLock Lock(m_CSLayers);
+		cCSLock Lock(GetCS());
 		cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 		if (Chunk == NULL)
 		{
@@ -947,7 +990,7 @@ void cChunkMap::ChunkLighted(
 	const cChunkDef::BlockNibbles & a_SkyLight
 )
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -963,7 +1006,7 @@ void cChunkMap::ChunkLighted(
 
 bool cChunkMap::GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
@@ -979,7 +1022,7 @@ bool cChunkMap::GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_
 
 bool cChunkMap::GetChunkBlockTypes(int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_BlockTypes)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) || !Chunk->IsValid())
 	{
@@ -995,7 +1038,7 @@ bool cChunkMap::GetChunkBlockTypes(int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_Blo
 
 bool cChunkMap::IsChunkValid(int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	return (Chunk != NULL) && Chunk->IsValid();
 }
@@ -1006,7 +1049,7 @@ bool cChunkMap::IsChunkValid(int a_ChunkX, int a_ChunkZ)
 
 bool cChunkMap::HasChunkAnyClients(int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	return (Chunk != NULL) && Chunk->HasAnyClients();
 }
@@ -1019,7 +1062,7 @@ int  cChunkMap::GetHeight(int a_BlockX, int a_BlockZ)
 {
 	for (;;)
 	{
-		cCSLock Lock(m_CSLayers);
+		cCSLock Lock(GetCS());
 		int ChunkX, ChunkZ, BlockY = 0;
 		cChunkDef::AbsoluteToRelative(a_BlockX, BlockY, a_BlockZ, ChunkX, ChunkZ);
 		cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
@@ -1046,7 +1089,7 @@ int  cChunkMap::GetHeight(int a_BlockX, int a_BlockZ)
 bool cChunkMap::TryGetHeight(int a_BlockX, int a_BlockZ, int & a_Height)
 {
 	// Returns false if chunk not loaded / generated
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ, BlockY = 0;
 	cChunkDef::AbsoluteToRelative(a_BlockX, BlockY, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
@@ -1071,7 +1114,7 @@ void cChunkMap::FastSetBlocks(sSetBlockList & a_BlockList)
 	{
 		int ChunkX = a_BlockList.front().ChunkX;
 		int ChunkZ = a_BlockList.front().ChunkZ;
-		cCSLock Lock(m_CSLayers);
+		cCSLock Lock(GetCS());
 		cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 		if ((Chunk != NULL) && Chunk->IsValid())
 		{
@@ -1116,25 +1159,32 @@ void cChunkMap::FastSetBlocks(sSetBlockList & a_BlockList)
 
 void cChunkMap::CollectPickupsByPlayer(cPlayer * a_Player)
 {
-	int BlockX = (int)(a_Player->GetPosX());  // Truncating doesn't matter much; we're scanning entire chunks anyway
-	int BlockY = (int)(a_Player->GetPosY());
-	int BlockZ = (int)(a_Player->GetPosZ());
-	int ChunkX, ChunkZ, ChunkY = ZERO_CHUNK_Y;
-	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	int OtherChunkX = ChunkX + ((BlockX > 8) ? 1 : -1);
-	int OtherChunkZ = ChunkZ + ((BlockZ > 8) ? 1 : -1);
-	
 	// We suppose that each player keeps their chunks in memory, therefore it makes little sense to try to re-load or even generate them.
 	// The only time the chunks are not valid is when the player is downloading the initial world and they should not call this at that moment
 	
-	cCSLock Lock(m_CSLayers);
-	GetChunkNoLoad(ChunkX, ChunkY, ChunkZ)->CollectPickupsByPlayer(a_Player);
-
-	// Check the neighboring chunks as well:
-	GetChunkNoLoad(OtherChunkX, ChunkY, ChunkZ     )->CollectPickupsByPlayer(a_Player);
-	GetChunkNoLoad(OtherChunkX, ChunkY, OtherChunkZ)->CollectPickupsByPlayer(a_Player);
-	GetChunkNoLoad(ChunkX,      ChunkY, ChunkZ     )->CollectPickupsByPlayer(a_Player);
-	GetChunkNoLoad(ChunkX,      ChunkY, OtherChunkZ)->CollectPickupsByPlayer(a_Player);
+	cCSLock Lock(GetCS());
+	cEntityVector Entities;
+	m_EntityIndex.QueryRadius(a_Player->GetPosition(), 1.5, Entities);  // 1.5 block
+	for (cEntityVector::const_iterator itr = Entities.begin(), end = Entities.end(); itr != end; ++itr)
+	{
+		if ((!(*itr)->IsPickup()) && (!(*itr)->IsProjectile()))
+		{
+			continue;  // Only pickups and projectiles
+		}
+		cChunkPtr Chunk = GetChunkNoLoad((*itr)->GetChunkX(), ZERO_CHUNK_Y, (*itr)->GetChunkZ());
+		if (Chunk != NULL)
+		{
+			Chunk->MarkDirty();
+		}
+		if ((*itr)->IsPickup())
+		{
+			(reinterpret_cast<cPickup *>(*itr))->CollectedBy(a_Player);
+		}
+		else
+		{
+			(reinterpret_cast<cProjectileEntity *>(*itr))->CollectedBy(a_Player);
+		}
+	}
 }
 
 
@@ -1161,7 +1211,7 @@ BLOCKTYPE cChunkMap::GetBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ );
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1190,7 +1240,7 @@ NIBBLETYPE cChunkMap::GetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ)
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ );
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid() )
 	{
@@ -1208,7 +1258,7 @@ NIBBLETYPE cChunkMap::GetBlockSkyLight(int a_BlockX, int a_BlockY, int a_BlockZ)
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ );
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid() )
 	{
@@ -1226,7 +1276,7 @@ NIBBLETYPE cChunkMap::GetBlockBlockLight(int a_BlockX, int a_BlockY, int a_Block
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ );
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid() )
 	{
@@ -1245,7 +1295,7 @@ void cChunkMap::SetBlockMeta(int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYP
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	// a_BlockXYZ now contains relative coords!
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1270,7 +1320,7 @@ void cChunkMap::SetBlock(cWorldInterface & a_WorldInterface, int a_BlockX, int a
 	int ChunkX, ChunkZ, X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative( X, Y, Z, ChunkX, ChunkZ );
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1289,7 +1339,7 @@ void cChunkMap::QueueSetBlock(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYP
 	int ChunkX, ChunkZ, X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1306,7 +1356,7 @@ bool cChunkMap::GetBlockTypeMeta(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCK
 	int ChunkX, ChunkZ, X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative( X, Y, Z, ChunkX, ChunkZ );
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1325,7 +1375,7 @@ bool cChunkMap::GetBlockInfo(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE
 	int ChunkX, ChunkZ, X = a_BlockX, Y = a_BlockY, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative( X, Y, Z, ChunkX, ChunkZ );
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1341,7 +1391,7 @@ bool cChunkMap::GetBlockInfo(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE
 
 void cChunkMap::ReplaceBlocks(const sSetBlockVector & a_Blocks, BLOCKTYPE a_FilterBlockType)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (sSetBlockVector::const_iterator itr = a_Blocks.begin(); itr != a_Blocks.end(); ++itr)
 	{
 		cChunkPtr Chunk = GetChunk(itr->ChunkX, ZERO_CHUNK_Y, itr->ChunkZ );
@@ -1362,7 +1412,7 @@ void cChunkMap::ReplaceBlocks(const sSetBlockVector & a_Blocks, BLOCKTYPE a_Filt
 
 void cChunkMap::ReplaceTreeBlocks(const sSetBlockVector & a_Blocks)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (sSetBlockVector::const_iterator itr = a_Blocks.begin(); itr != a_Blocks.end(); ++itr)
 	{
 		cChunkPtr Chunk = GetChunk(itr->ChunkX, ZERO_CHUNK_Y, itr->ChunkZ );
@@ -1399,7 +1449,7 @@ EMCSBiome cChunkMap::GetBiomeAt (int a_BlockX, int a_BlockZ)
 	int ChunkX, ChunkZ, X = a_BlockX, Y = 0, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1420,7 +1470,7 @@ bool cChunkMap::SetBiomeAt(int a_BlockX, int a_BlockZ, EMCSBiome a_Biome)
 	int ChunkX, ChunkZ, X = a_BlockX, Y = 0, Z = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(X, Y, Z, ChunkX, ChunkZ);
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk != NULL) && Chunk->IsValid())
 	{
@@ -1445,7 +1495,7 @@ bool cChunkMap::SetAreaBiome(int a_MinX, int a_MaxX, int a_MinZ, int a_MaxZ, EMC
 	
 	// Go through all chunks, set:
 	bool res = true;
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (int x = MinChunkX; x <= MaxChunkX; x++)
 	{
 		int MinRelX = (x == MinChunkX) ? MinX : 0;
@@ -1475,7 +1525,7 @@ bool cChunkMap::SetAreaBiome(int a_MinX, int a_MaxX, int a_MinZ, int a_MaxZ, EMC
 bool cChunkMap::GetBlocks(sSetBlockVector & a_Blocks, bool a_ContinueOnFailure)
 {
 	bool res = true;
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (sSetBlockVector::iterator itr = a_Blocks.begin(); itr != a_Blocks.end(); ++itr)
 	{
 		cChunkPtr Chunk = GetChunk(itr->ChunkX, ZERO_CHUNK_Y, itr->ChunkZ );
@@ -1506,7 +1556,7 @@ bool cChunkMap::DigBlock(int a_X, int a_Y, int a_Z)
 	cChunkDef::AbsoluteToRelative( PosX, PosY, PosZ, ChunkX, ChunkZ );
 
 	{
-		cCSLock Lock(m_CSLayers);
+		cCSLock Lock(GetCS());
 		cChunkPtr DestChunk = GetChunk( ChunkX, ZERO_CHUNK_Y, ChunkZ );
 		if ((DestChunk == NULL) || !DestChunk->IsValid())
 		{
@@ -1529,7 +1579,7 @@ void cChunkMap::SendBlockTo(int a_X, int a_Y, int a_Z, cPlayer * a_Player)
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_X, a_Y, a_Z, ChunkX, ChunkZ);
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk->IsValid())
 	{
@@ -1543,7 +1593,7 @@ void cChunkMap::SendBlockTo(int a_X, int a_Y, int a_Z, cPlayer * a_Player)
 
 void cChunkMap::CompareChunkClients(int a_ChunkX1, int a_ChunkZ1, int a_ChunkX2, int a_ChunkZ2, cClientDiffCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk1 = GetChunkNoGen(a_ChunkX1, ZERO_CHUNK_Y, a_ChunkZ1);
 	if (Chunk1 == NULL)
 	{
@@ -1610,7 +1660,7 @@ void cChunkMap::CompareChunkClients(cChunk * a_Chunk1, cChunk * a_Chunk2, cClien
 
 bool cChunkMap::AddChunkClient(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunk(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -1625,7 +1675,7 @@ bool cChunkMap::AddChunkClient(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Cli
 
 void cChunkMap::RemoveChunkClient(int a_ChunkX, int a_ChunkZ, cClientHandle * a_Client)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -1640,7 +1690,7 @@ void cChunkMap::RemoveChunkClient(int a_ChunkX, int a_ChunkZ, cClientHandle * a_
 
 void cChunkMap::RemoveClientFromChunks(cClientHandle * a_Client)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
@@ -1654,7 +1704,7 @@ void cChunkMap::RemoveClientFromChunks(cClientHandle * a_Client)
 
 void cChunkMap::AddEntity(cEntity * a_Entity)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity->GetChunkX(), ZERO_CHUNK_Y, a_Entity->GetChunkZ());
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -1672,7 +1722,7 @@ void cChunkMap::AddEntity(cEntity * a_Entity)
 
 bool cChunkMap::HasEntity(int a_UniqueID)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
 		if ((*itr)->HasEntity(a_UniqueID))
@@ -1689,7 +1739,7 @@ bool cChunkMap::HasEntity(int a_UniqueID)
 
 void cChunkMap::RemoveEntity(cEntity * a_Entity)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_Entity->GetChunkX(), ZERO_CHUNK_Y, a_Entity->GetChunkZ());
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -1704,7 +1754,7 @@ void cChunkMap::RemoveEntity(cEntity * a_Entity)
 
 bool cChunkMap::ForEachEntity(cEntityCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
 		if (!(*itr)->ForEachEntity(a_Callback))
@@ -1721,7 +1771,7 @@ bool cChunkMap::ForEachEntity(cEntityCallback & a_Callback)
 
 bool cChunkMap::ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -1734,6 +1784,46 @@ bool cChunkMap::ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback
 
 
 
+
+bool cChunkMap::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback)
+{
+	// The destroyed entities are deleted only in their chunk's tick, so the pointers stay valid while the CS is held
+	cCSLock Lock(GetCS());
+	cEntityVector Entities;
+	m_EntityIndex.QueryBox(a_Box, Entities);
+	for (cEntityVector::const_iterator itr = Entities.begin(), end = Entities.end(); itr != end; ++itr)
+	{
+		if (a_Callback.Item(*itr))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
+bool cChunkMap::ForEachEntityInRadius(const Vector3d & a_Center, double a_Radius, cEntityCallback & a_Callback)
+{
+	cCSLock Lock(GetCS());
+	cEntityVector Entities;
+	m_EntityIndex.QueryRadius(a_Center, a_Radius, Entities);
+	for (cEntityVector::const_iterator itr = Entities.begin(), end = Entities.end(); itr != end; ++itr)
+	{
+		if (a_Callback.Item(*itr))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+
+
 void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlocksAffected)
 {
 	// Don't explode if outside of Y range (prevents the following test running into unallocated memory):
@@ -1937,7 +2027,7 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 
 
 	cTNTDamageCallback TNTDamageCallback(bbTNT, Vector3d(a_BlockX, a_BlockY, a_BlockZ), ExplosionSizeInt);
-	ForEachEntity(TNTDamageCallback);
+	ForEachEntityInBox(bbTNT, TNTDamageCallback);
 
 	// Wake up all simulators for the area, so that water and lava flows and sand falls into the blasted holes (FS #391):
 	WakeUpSimulatorsInArea(
@@ -1953,7 +2043,7 @@ void cChunkMap::DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_
 
 bool cChunkMap::DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	bool res = false;
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
@@ -1969,9 +2059,25 @@ bool cChunkMap::DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback)
 
 
 
+bool cChunkMap::DoWithEntityByIDInChunk(int a_ChunkX, int a_ChunkZ, int a_UniqueID, cEntityCallback & a_Callback)
+{
+	cCSLock Lock(GetCS());
+	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
+	if ((Chunk == NULL) || !Chunk->IsValid())
+	{
+		return false;
+	}
+	bool res = false;
+	return Chunk->DoWithEntityByID(a_UniqueID, a_Callback, res) && res;
+}
+
+
+
+
+
 bool cChunkMap::ForEachBlockEntityInChunk(int a_ChunkX, int a_ChunkZ, cBlockEntityCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -1986,7 +2092,7 @@ bool cChunkMap::ForEachBlockEntityInChunk(int a_ChunkX, int a_ChunkZ, cBlockEnti
 
 bool cChunkMap::ForEachChestInChunk(int a_ChunkX, int a_ChunkZ, cChestCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2001,7 +2107,7 @@ bool cChunkMap::ForEachChestInChunk(int a_ChunkX, int a_ChunkZ, cChestCallback &
 
 bool cChunkMap::ForEachDispenserInChunk(int a_ChunkX, int a_ChunkZ, cDispenserCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2016,7 +2122,7 @@ bool cChunkMap::ForEachDispenserInChunk(int a_ChunkX, int a_ChunkZ, cDispenserCa
 
 bool cChunkMap::ForEachDropperInChunk(int a_ChunkX, int a_ChunkZ, cDropperCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2031,7 +2137,7 @@ bool cChunkMap::ForEachDropperInChunk(int a_ChunkX, int a_ChunkZ, cDropperCallba
 
 bool cChunkMap::ForEachDropSpenserInChunk(int a_ChunkX, int a_ChunkZ, cDropSpenserCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2046,7 +2152,7 @@ bool cChunkMap::ForEachDropSpenserInChunk(int a_ChunkX, int a_ChunkZ, cDropSpens
 
 bool cChunkMap::ForEachFurnaceInChunk(int a_ChunkX, int a_ChunkZ, cFurnaceCallback & a_Callback)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2064,7 +2170,7 @@ bool cChunkMap::DoWithBlockEntityAt(int a_BlockX, int a_BlockY, int a_BlockZ, cB
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2082,7 +2188,7 @@ bool cChunkMap::DoWithChestAt(int a_BlockX, int a_BlockY, int a_BlockZ, cChestCa
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2100,7 +2206,7 @@ bool cChunkMap::DoWithDispenserAt(int a_BlockX, int a_BlockY, int a_BlockZ, cDis
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2118,7 +2224,7 @@ bool cChunkMap::DoWithDropperAt(int a_BlockX, int a_BlockY, int a_BlockZ, cDropp
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2136,7 +2242,7 @@ bool cChunkMap::DoWithDropSpenserAt(int a_BlockX, int a_BlockY, int a_BlockZ, cD
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2154,7 +2260,7 @@ bool cChunkMap::DoWithFurnaceAt(int a_BlockX, int a_BlockY, int a_BlockZ, cFurna
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2171,7 +2277,7 @@ bool cChunkMap::DoWithNoteBlockAt(int a_BlockX, int a_BlockY, int a_BlockZ, cNot
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2188,7 +2294,7 @@ bool cChunkMap::DoWithCommandBlockAt(int a_BlockX, int a_BlockY, int a_BlockZ, c
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2206,7 +2312,7 @@ bool cChunkMap::DoWithMobHeadAt(int a_BlockX, int a_BlockY, int a_BlockZ, cMobHe
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2224,7 +2330,7 @@ bool cChunkMap::DoWithFlowerPotAt(int a_BlockX, int a_BlockY, int a_BlockZ, cFlo
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2242,7 +2348,7 @@ bool cChunkMap::GetSignLines(int a_BlockX, int a_BlockY, int a_BlockZ, AString &
 	int ChunkX, ChunkZ;
 	int BlockX = a_BlockX, BlockY = a_BlockY, BlockZ = a_BlockZ;
 	cChunkDef::AbsoluteToRelative(BlockX, BlockY, BlockZ, ChunkX, ChunkZ);
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if ((Chunk == NULL) && !Chunk->IsValid())
 	{
@@ -2257,7 +2363,7 @@ bool cChunkMap::GetSignLines(int a_BlockX, int a_BlockY, int a_BlockZ, AString &
 
 void cChunkMap::TouchChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	GetChunk(a_ChunkX, a_ChunkY, a_ChunkZ);
 }
 
@@ -2269,7 +2375,7 @@ void cChunkMap::TouchChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 bool cChunkMap::LoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
 	{
-		cCSLock Lock(m_CSLayers);
+		cCSLock Lock(GetCS());
 		cChunkPtr Chunk = GetChunkNoGen(a_ChunkX, a_ChunkY, a_ChunkZ);
 		if (Chunk == NULL)
 		{
@@ -2309,7 +2415,7 @@ void cChunkMap::LoadChunks(const cChunkCoordsList & a_Chunks)
 
 void cChunkMap::ChunkLoadFailed(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, a_ChunkY, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -2324,7 +2430,7 @@ void cChunkMap::ChunkLoadFailed(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 
 bool cChunkMap::SetSignLines(int a_BlockX, int a_BlockY, int a_BlockZ, const AString & a_Line1, const AString & a_Line2, const AString & a_Line3, const AString & a_Line4)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::BlockToChunk(a_BlockX, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoGen(ChunkX, ZERO_CHUNK_Y, ChunkZ);
@@ -2341,7 +2447,7 @@ bool cChunkMap::SetSignLines(int a_BlockX, int a_BlockY, int a_BlockZ, const ASt
 
 void cChunkMap::MarkChunkRegenerating(int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -2357,7 +2463,7 @@ void cChunkMap::MarkChunkRegenerating(int a_ChunkX, int a_ChunkZ)
 
 bool cChunkMap::IsChunkLighted(int a_ChunkX, int a_ChunkZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(a_ChunkX, ZERO_CHUNK_Y, a_ChunkZ);
 	if (Chunk == NULL)
 	{
@@ -2374,7 +2480,7 @@ bool cChunkMap::IsChunkLighted(int a_ChunkX, int a_ChunkZ)
 bool cChunkMap::ForEachChunkInRect(int a_MinChunkX, int a_MaxChunkX, int a_MinChunkZ, int a_MaxChunkZ, cChunkDataCallback & a_Callback)
 {
 	bool Result = true;
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (int z = a_MinChunkZ; z <= a_MaxChunkZ; z++)
 	{
 		for (int x = a_MinChunkX; x <= a_MaxChunkX; x++)
@@ -2416,7 +2522,7 @@ bool cChunkMap::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBl
 	
 	// Iterate over chunks, write data into each:
 	bool Result = true;
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (int z = MinChunkZ; z <= MaxChunkZ; z++)
 	{
 		for (int x = MinChunkX; x <= MaxChunkX; x++)
@@ -2438,17 +2544,19 @@ bool cChunkMap::WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBl
 
 
 
-void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty)
+void cChunkMap::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty, int & a_NumSections)
 {
 	a_NumChunksValid = 0;
 	a_NumChunksDirty = 0;
-	cCSLock Lock(m_CSLayers);
+	a_NumSections = 0;
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::const_iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
-		int NumValid = 0, NumDirty = 0;
-		(*itr)->GetChunkStats(NumValid, NumDirty);
+		int NumValid = 0, NumDirty = 0, NumSections = 0;
+		(*itr)->GetChunkStats(NumValid, NumDirty, NumSections);
 		a_NumChunksValid += NumValid;
 		a_NumChunksDirty += NumDirty;
+		a_NumSections += NumSections;
 	}  // for itr - m_Layers[]
 }
 
@@ -2461,7 +2569,7 @@ void cChunkMap::GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCK
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk != NULL)
 	{
@@ -2478,7 +2586,7 @@ void cChunkMap::GrowSugarcane(int a_BlockX, int a_BlockY, int a_BlockZ, int a_Nu
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk != NULL)
 	{
@@ -2495,7 +2603,7 @@ void cChunkMap::GrowCactus(int a_BlockX, int a_BlockY, int a_BlockZ, int a_NumBl
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk != NULL)
 	{
@@ -2512,7 +2620,7 @@ void cChunkMap::SetNextBlockTick(int a_BlockX, int a_BlockY, int a_BlockZ)
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk != NULL)
 	{
@@ -2523,12 +2631,12 @@ void cChunkMap::SetNextBlockTick(int a_BlockX, int a_BlockY, int a_BlockZ)
 
 
 
-void cChunkMap::CollectMobCensus(cMobCensus& a_ToFill)
+void cChunkMap::SpawnMobs(cMobSpawner& a_MobSpawner)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
-		(*itr)->CollectMobCensus(a_ToFill);
+		(*itr)->SpawnMobs(a_MobSpawner);
 	}  // for itr - m_Layers
 }
 
@@ -2536,13 +2644,25 @@ void cChunkMap::CollectMobCensus(cMobCensus& a_ToFill)
 
 
 
-
-void cChunkMap::SpawnMobs(cMobSpawner& a_MobSpawner)
+void cChunkMap::Tick(float a_Dt)
 {
 	cCSLock Lock(m_CSLayers);
+	
+	if (m_TickPool != NULL)
+	{
+		std::vector<cChunkLayerPtrs> Islands;
+		BuildTickIslands(Islands);
+		if (Islands.size() > 1)
+		{
+			TickInParallel(a_Dt, Islands);
+			return;
+		}
+		// Only a single island, not worth handing it over to a worker thread
+	}
+	
 	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
-		(*itr)->SpawnMobs(a_MobSpawner);
+		(*itr)->Tick(a_Dt);
 	}  // for itr - m_Layers
 }
 
@@ -2550,13 +2670,137 @@ void cChunkMap::SpawnMobs(cMobSpawner& a_MobSpawner)
 
 
 
-void cChunkMap::Tick(float a_Dt)
+void cChunkMap::BuildTickIslands(std::vector<cChunkLayerPtrs> & a_Islands)
+{
+	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	
+	// Flood-fill the layers through their 8 neighbors; each fill produces one island:
+	typedef std::map<std::pair<int, int>, cChunkLayer *> cLayerCoordMap;
+	cLayerCoordMap Unassigned;
+	for (cChunkLayerList::iterator itr = m_Layers.begin(), end = m_Layers.end(); itr != end; ++itr)
+	{
+		Unassigned[std::make_pair((*itr)->GetX(), (*itr)->GetZ())] = *itr;
+	}
+	
+	while (!Unassigned.empty())
+	{
+		a_Islands.push_back(cChunkLayerPtrs());
+		cChunkLayerPtrs & Island = a_Islands.back();
+		Island.push_back(Unassigned.begin()->second);
+		Unassigned.erase(Unassigned.begin());
+		for (size_t i = 0; i < Island.size(); i++)  // Island grows while iterating
+		{
+			int LayerX = Island[i]->GetX();
+			int LayerZ = Island[i]->GetZ();
+			for (int x = LayerX - 1; x <= LayerX + 1; x++)
+			{
+				for (int z = LayerZ - 1; z <= LayerZ + 1; z++)
+				{
+					cLayerCoordMap::iterator Neighbor = Unassigned.find(std::make_pair(x, z));
+					if (Neighbor != Unassigned.end())
+					{
+						Island.push_back(Neighbor->second);
+						Unassigned.erase(Neighbor);
+					}
+				}  // for z
+			}  // for x
+		}  // for i - Island[]
+	}  // while (Unassigned)
+}
+
+
+
+
+
+void cChunkMap::TickInParallel(float a_Dt, std::vector<cChunkLayerPtrs> & a_Islands)
+{
+	ASSERT(m_CSLayers.IsLockedByCurrentThread());
+	
+	// The islands must not be reallocated while the workers use them, hence the reserve():
+	std::vector<cTickIsland> Islands;
+	Islands.reserve(a_Islands.size());
+	cChunkTickPool::cTasks Tasks;
+	for (std::vector<cChunkLayerPtrs>::iterator itr = a_Islands.begin(), end = a_Islands.end(); itr != end; ++itr)
+	{
+		Islands.push_back(cTickIsland(*itr, a_Dt));
+		Tasks.push_back(&Islands.back());
+	}
+	m_TickPool->RunTasks(Tasks);
+	
+	// Merge phase: move the entities that couldn't reach their new chunk, now that no worker is touching the chunks:
+	sDeferredEntityMoves Moves;
+	std::swap(Moves, m_DeferredEntityMoves);
+	for (sDeferredEntityMoves::iterator itr = Moves.begin(), end = Moves.end(); itr != end; ++itr)
+	{
+		itr->m_SrcChunk->MoveEntityToNewChunk(itr->m_Entity);
+	}
+	
+	// The simulators keep their per-call state in members shared by all the chunks, so they run serially here:
+	for (cChunkLayerList::iterator itr = m_Layers.begin(), end = m_Layers.end(); itr != end; ++itr)
+	{
+		(*itr)->TickSimulators(a_Dt);
+	}
+}
+
+
+
+
+
+bool cChunkMap::DeferEntityMove(cChunk * a_SrcChunk, cEntity * a_Entity)
+{
+	if ((m_TickPool == NULL) || !m_TickPool->IsWorkerThread())
+	{
+		return false;
+	}
+	cCSLock Lock(m_CSTickWorkers);
+	m_DeferredEntityMoves.push_back(sDeferredEntityMove(a_SrcChunk, a_Entity));
+	return true;
+}
+
+
+
+
+
+bool cChunkMap::IsTickWorkerThread(void) const
+{
+	return ((m_TickPool != NULL) && m_TickPool->IsWorkerThread());
+}
+
+
+
+
+
+cCriticalSection & cChunkMap::GetCS(void)
+{
+	if ((m_TickPool != NULL) && m_TickPool->IsWorkerThread())
+	{
+		return m_CSTickWorkers;
+	}
+	return m_CSLayers;
+}
+
+
+
+
+
+void cChunkMap::SetNumTickThreads(int a_NumThreads)
 {
 	cCSLock Lock(m_CSLayers);
-	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
+	delete m_TickPool;
+	m_TickPool = (a_NumThreads > 0) ? new cChunkTickPool(a_NumThreads) : NULL;
+}
+
+
+
+
+
+MTRand * cChunkMap::GetTickWorkerRand(void)
+{
+	if (m_TickPool == NULL)
 	{
-		(*itr)->Tick(a_Dt);
-	}  // for itr - m_Layers
+		return NULL;
+	}
+	return m_TickPool->GetWorkerRand();
 }
 
 
@@ -2565,7 +2809,7 @@ void cChunkMap::Tick(float a_Dt)
 
 void cChunkMap::TickBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int ChunkX, ChunkZ;
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
@@ -2582,7 +2826,7 @@ void cChunkMap::TickBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
 
 void cChunkMap::UnloadUnusedChunks(void)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
 		(*itr)->UnloadUnusedChunks();
@@ -2595,7 +2839,7 @@ void cChunkMap::UnloadUnusedChunks(void)
 
 void cChunkMap::SaveAllChunks(void)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
 		(*itr)->Save();
@@ -2608,7 +2852,7 @@ void cChunkMap::SaveAllChunks(void)
 
 int cChunkMap::GetNumChunks(void)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	int NumChunks = 0;
 	for (cChunkLayerList::iterator itr = m_Layers.begin(); itr != m_Layers.end(); ++itr)
 	{
@@ -2636,7 +2880,7 @@ void cChunkMap::QueueTickBlock(int a_BlockX, int a_BlockY, int a_BlockZ)
 	cChunkDef::AbsoluteToRelative(a_BlockX, a_BlockY, a_BlockZ, ChunkX, ChunkZ);
 	// a_BlockXYZ now contains relative coords!
 
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	cChunkPtr Chunk = GetChunkNoLoad(ChunkX, ZERO_CHUNK_Y, ChunkZ);
 	if (Chunk != NULL)
 	{
@@ -2724,47 +2968,44 @@ cChunk * cChunkMap::cChunkLayer::FindChunk(int a_ChunkX, int a_ChunkZ)
 
 
 
-void cChunkMap::cChunkLayer::CollectMobCensus(cMobCensus& a_ToFill)
+void cChunkMap::cChunkLayer::SpawnMobs(cMobSpawner& a_MobSpawner)
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); i++)
 	{
-		// We do count every Mobs in the world. But we are assuming that every chunk not loaded by any client
-		// doesn't affect us. Normally they should not have mobs because every "too far" mobs despawn
-		// If they have (f.i. when player disconnect) we assume we don't have to make them live or despawn
+		// We only spawn close to players
 		if ((m_Chunks[i] != NULL) && m_Chunks[i]->IsValid() && m_Chunks[i]->HasAnyClients())
 		{
-			m_Chunks[i]->CollectMobCensus(a_ToFill);
+			m_Chunks[i]->SpawnMobs(a_MobSpawner);
 		}
 	}  // for i - m_Chunks[]
 }
 
 
 
-
-
-
-void cChunkMap::cChunkLayer::SpawnMobs(cMobSpawner& a_MobSpawner)
+void cChunkMap::cChunkLayer::Tick(float a_Dt)
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); i++)
 	{
-		// We only spawn close to players
+		// Only tick chunks that are valid and have clients:
 		if ((m_Chunks[i] != NULL) && m_Chunks[i]->IsValid() && m_Chunks[i]->HasAnyClients())
 		{
-			m_Chunks[i]->SpawnMobs(a_MobSpawner);
+			m_Chunks[i]->Tick(a_Dt);
 		}
 	}  // for i - m_Chunks[]
 }
 
 
 
-void cChunkMap::cChunkLayer::Tick(float a_Dt)
+
+
+void cChunkMap::cChunkLayer::TickSimulators(float a_Dt)
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); i++)
 	{
-		// Only tick chunks that are valid and have clients:
+		// The same chunks as in Tick():
 		if ((m_Chunks[i] != NULL) && m_Chunks[i]->IsValid() && m_Chunks[i]->HasAnyClients())
 		{
-			m_Chunks[i]->Tick(a_Dt);
+			m_Chunks[i]->TickSimulators(a_Dt);
 		}
 	}  // for i - m_Chunks[]
 }
@@ -2864,10 +3105,11 @@ int cChunkMap::cChunkLayer::GetNumChunksLoaded(void) const
 
 
 
-void cChunkMap::cChunkLayer::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const
+void cChunkMap::cChunkLayer::GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty, int & a_NumSections) const
 {
 	int NumValid = 0;
 	int NumDirty = 0;
+	int NumSections = 0;
 	for (size_t i = 0; i < ARRAYCOUNT(m_Chunks); ++i)
 	{
 		if (m_Chunks[i] == NULL)
@@ -2879,9 +3121,11 @@ void cChunkMap::cChunkLayer::GetChunkStats(int & a_NumChunksValid, int & a_NumCh
 		{
 			NumDirty++;
 		}
+		NumSections += m_Chunks[i]->m_ChunkData.GetNumSectionsAllocated();
 	}  // for i - m_Chunks[]
 	a_NumChunksValid = NumValid;
 	a_NumChunksDirty = NumDirty;
+	a_NumSections = NumSections;
 }
 
 
@@ -2914,6 +3158,9 @@ void cChunkMap::cChunkLayer::UnloadUnusedChunks(void)
 			!cPluginManager::Get()->CallHookChunkUnloading(m_Parent->GetWorld(), m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ())  // Plugins agree
 		)
 		{
+			// The chunk's cached packets will never be used again, the reloaded chunk gets a new change counter:
+			m_Parent->GetWorld()->GetChunkPacketCache().RemoveChunk(m_Chunks[i]->GetPosX(), m_Chunks[i]->GetPosZ());
+			
 			// The cChunk destructor calls our GetChunk() while removing its entities
 			// so we still need to be able to return the chunk. Therefore we first delete, then NULLify
 			// Doing otherwise results in bug http://forum.mc-server.org/showthread.php?tid=355
@@ -2958,7 +3205,7 @@ void cChunkMap::FastSetQueuedBlocks()
 
 void cChunkMap::AddChunkStay(cChunkStay & a_ChunkStay)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	
 	// Add it to the list:
 	ASSERT(std::find(m_ChunkStays.begin(), m_ChunkStays.end(), &a_ChunkStay) == m_ChunkStays.end());  // Has not yet been added
@@ -2993,7 +3240,7 @@ void cChunkMap::AddChunkStay(cChunkStay & a_ChunkStay)
 /** Removes the specified cChunkStay descendant from the internal list of ChunkStays. */
 void cChunkMap::DelChunkStay(cChunkStay & a_ChunkStay)
 {
-	cCSLock Lock(m_CSLayers);
+	cCSLock Lock(GetCS());
 	
 	// Remove from the list of active chunkstays:
 	bool HasFound = false;
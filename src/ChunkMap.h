@@ -6,6 +6,7 @@
 #pragma once
 
 #include "ChunkDef.h"
+#include "EntitySpatialIndex.h"
 
 
 
@@ -33,6 +34,8 @@ class cChunkDataSerializer;
 class cBlockArea;
 class cMobCensus;
 class cMobSpawner;
+class cChunkTickPool;
+class cBoundingBox;
 
 typedef std::list<cClientHandle *>  cClientHandleList;
 typedef cChunk * cChunkPtr;
@@ -53,7 +56,8 @@ typedef cItemCallback<cChunk>              cChunkCallback;
 
 
 
-class cChunkMap
+class cChunkMap :
+	public cChunkDataSource
 {
 public:
 
@@ -132,7 +136,7 @@ public:
 		const cChunkDef::BlockNibbles & a_SkyLight
 	);
 	
-	bool GetChunkData       (int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback);
+	virtual bool GetChunkData(int a_ChunkX, int a_ChunkZ, cChunkDataCallback & a_Callback) override;
 	
 	/** Copies the chunk's blocktypes into a_Blocks; returns true if successful */
 	bool GetChunkBlockTypes (int a_ChunkX, int a_ChunkZ, BLOCKTYPE * a_Blocks);
@@ -209,6 +213,18 @@ public:
 
 	/** Calls the callback for each entity in the specified chunk; returns true if all entities processed, false if the callback aborted by returning true */
 	bool ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback & a_Callback);  // Lua-accessible
+	
+	/** Calls the callback for each entity whose position is inside the specified box; returns true if all entities processed, false if the callback aborted by returning true */
+	bool ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback);  // Lua-accessible
+	
+	/** Calls the callback for each entity whose position is closer than a_Radius to a_Center; returns true if all entities processed, false if the callback aborted by returning true */
+	bool ForEachEntityInRadius(const Vector3d & a_Center, double a_Radius, cEntityCallback & a_Callback);  // Lua-accessible
+	
+	/** Returns the spatial index of all the entities in the chunks; the chunks keep it updated */
+	cEntitySpatialIndex & GetEntityIndex(void) { return m_EntityIndex; }
+	
+	/** Returns the census of all the mobs in the chunks; the chunks keep it updated */
+	cMobCensus & GetMobCensus(void) { return *m_MobCensus; }
 
 	/** Destroys and returns a list of blocks destroyed in the explosion at the specified coordinates */
 	void DoExplosionAt(double a_ExplosionSize, double a_BlockX, double a_BlockY, double a_BlockZ, cVector3iArray & a_BlockAffected);
@@ -216,6 +232,9 @@ public:
 	/** Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found and callback returned false. */
 	bool DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback);  // Lua-accessible
 
+	/** Same as DoWithEntityByID(), but only searches the specified chunk, rather than all the loaded chunks. Doesn't load the chunk. */
+	bool DoWithEntityByIDInChunk(int a_ChunkX, int a_ChunkZ, int a_UniqueID, cEntityCallback & a_Callback);
+
 	/** Calls the callback for each block entity in the specified chunk; returns true if all block entities processed, false if the callback aborted by returning true */
 	bool ForEachBlockEntityInChunk(int a_ChunkX, int a_ChunkZ, cBlockEntityCallback & a_Callback);  // Lua-accessible
 
@@ -293,8 +312,8 @@ public:
 	/** Writes the block area into the specified coords. Returns true if all chunks have been processed. Prefer cBlockArea::Write() instead. */
 	bool WriteBlockArea(cBlockArea & a_Area, int a_MinBlockX, int a_MinBlockY, int a_MinBlockZ, int a_DataTypes);
 
-	/** Returns the number of valid chunks and the number of dirty chunks */
-	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty);
+	/** Returns the number of valid and dirty chunks, and the number of block data sections allocated in all the chunks */
+	void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty, int & a_NumSections);
 	
 	/** Grows a melon or a pumpkin next to the block specified (assumed to be the stem) */
 	void GrowMelonPumpkin(int a_BlockX, int a_BlockY, int a_BlockZ, BLOCKTYPE a_BlockType, MTRand & a_Rand);
@@ -308,9 +327,6 @@ public:
 	/** Sets the blockticking to start at the specified block. Only one blocktick per chunk may be set, second call overwrites the first call */
 	void SetNextBlockTick(int a_BlockX, int a_BlockY, int a_BlockZ);
 
-	/** Make a Mob census, of all mobs, their family, their chunk and theyr distance to closest player */
-	void CollectMobCensus(cMobCensus& a_ToFill);
-
 	/** Try to Spawn Monsters inside all Chunks */
 	void SpawnMobs(cMobSpawner& a_MobSpawner);
 
@@ -331,8 +347,17 @@ public:
 	/** Queues the specified block for ticking (block update) */
 	void QueueTickBlock(int a_BlockX, int a_BlockY, int a_BlockZ);
 	
-	/** Returns the CS for locking the chunkmap; only cWorld::cLock may use this function! */
-	cCriticalSection & GetCS(void) { return m_CSLayers; }
+	/** Returns the CS for locking the chunkmap; only cWorld::cLock may use this function!
+	While the chunks are being ticked in parallel, the tick workers get a separate CS, see m_CSTickWorkers. */
+	cCriticalSection & GetCS(void);
+	
+	/** Starts ticking independent groups of regions in parallel, using the specified number of worker threads.
+	0 threads means ticking everything serially in the world's tick thread (the default). */
+	void SetNumTickThreads(int a_NumThreads);
+	
+	/** Returns the random generator of the calling tick worker thread, or NULL if not called from a tick worker.
+	Used by cWorld::GetTickRandomNumber(), since cWorld's tick random generator is not thread-safe. */
+	MTRand * GetTickWorkerRand(void);
 
 private:
 
@@ -360,18 +385,19 @@ private:
 		
 		int GetNumChunksLoaded(void) const ;
 		
-		void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty) const;
+		void GetChunkStats(int & a_NumChunksValid, int & a_NumChunksDirty, int & a_NumSections) const;
 		
 		void Save(void);
 		void UnloadUnusedChunks(void);
 		
-		/** Collect a mob census, of all mobs, their megatype, their chunk and their distance o closest player */
-		void CollectMobCensus(cMobCensus& a_ToFill);		
 		/** Try to Spawn Monsters inside all Chunks */
 		void SpawnMobs(cMobSpawner& a_MobSpawner);
 
 		void Tick(float a_Dt);
 		
+		/** Runs the per-chunk simulator step of the chunks that Tick() ticks; used in the merge phase of the parallel tick */
+		void TickSimulators(float a_Dt);
+		
 		void RemoveClient(cClientHandle * a_Client);
 		
 		/** Calls the callback for each entity in the entire world; returns true if all entities processed, false if the callback aborted by returning true */
@@ -393,6 +419,25 @@ private:
 	};
 	
 	typedef std::list<cChunkLayer *> cChunkLayerList;
+	typedef std::vector<cChunkLayer *> cChunkLayerPtrs;
+	
+	/** A group of layers that is ticked by a single tick worker, defined in ChunkMap.cpp */
+	class cTickIsland;
+	
+	/** An entity that has left its chunk while ticking in parallel and will be moved in the merge phase */
+	struct sDeferredEntityMove
+	{
+		cChunk *  m_SrcChunk;
+		cEntity * m_Entity;
+		
+		sDeferredEntityMove(cChunk * a_SrcChunk, cEntity * a_Entity) :
+			m_SrcChunk(a_SrcChunk),
+			m_Entity(a_Entity)
+		{
+		}
+	} ;
+	
+	typedef std::vector<sDeferredEntityMove> sDeferredEntityMoves;
 	
 	typedef std::list<cChunkStay *> cChunkStays;
 
@@ -409,10 +454,50 @@ private:
 	cChunkLayer * GetLayer(int a_LayerX, int a_LayerZ);
 	
 	void RemoveLayer(cChunkLayer * a_Layer);
+	
+	/** Splits the layers into islands of neighboring layers; layers in different islands are at least a whole layer apart,
+	so the chunks in one island never touch the chunks of another one. Assumes m_CSLayers is locked. */
+	void BuildTickIslands(std::vector<cChunkLayerPtrs> & a_Islands);
+	
+	/** Ticks the islands in parallel on m_TickPool, then moves the entities that crossed the islands and runs the per-chunk
+	simulator step serially. Assumes m_CSLayers is locked. */
+	void TickInParallel(float a_Dt, std::vector<cChunkLayerPtrs> & a_Islands);
+	
+	/** If called from a tick worker, queues the entity to be moved out of a_SrcChunk in the merge phase and returns true.
+	Returns false when not ticking in parallel, the caller is expected to move the entity directly then. */
+	bool DeferEntityMove(cChunk * a_SrcChunk, cEntity * a_Entity);
+	
+	/** Returns true if called from one of the tick workers, while ticking in parallel */
+	bool IsTickWorkerThread(void) const;
+	
+	/** Returns a number unique for each cChunk instance created in this chunkmap, increasing with each call.
+	Called from the cChunk constructor, assumes the chunkmap is locked. */
+	UInt32 NextChunkGeneration(void) { return ++m_NumChunksCreated; }
 
 	cCriticalSection m_CSLayers;
 	cChunkLayerList  m_Layers;
+	
+	/** Number of the cChunk instances created so far, the last generation returned by NextChunkGeneration() */
+	UInt32 m_NumChunksCreated;
+	
+	/** The worker threads for ticking the regions in parallel; NULL when ticking serially */
+	cChunkTickPool * m_TickPool;
+	
+	/** Used instead of m_CSLayers by the tick workers while ticking in parallel.
+	The tick thread holds m_CSLayers for the whole parallel tick, so no other thread can access the chunkmap,
+	and the workers serialize their own chunkmap accesses on this CS. */
+	cCriticalSection m_CSTickWorkers;
+	
+	/** Entities that have crossed into a chunk that is not reachable through the neighbors while ticking in parallel.
+	Protected by m_CSTickWorkers, processed in the merge phase after all the workers have finished. */
+	sDeferredEntityMoves m_DeferredEntityMoves;
 	cEvent           m_evtChunkValid;  // Set whenever any chunk becomes valid, via ChunkValidated()
+	
+	/** Grid of all the entities in the chunks, for the area queries. Has its own CS, so that the tick workers can update it. */
+	cEntitySpatialIndex m_EntityIndex;
+	
+	/** Census of the mobs in the chunks, for the spawning caps and the mob ticking. Has its own CS, so that the tick workers can update it. */
+	cMobCensus * m_MobCensus;
 
 	cWorld * m_World;
 	
@@ -36,7 +36,8 @@ cChunkSender::cChunkSender(void) :
 	super("ChunkSender"),
 	m_World(NULL),
 	m_RemoveCount(0),
-	m_Notify(NULL)
+	m_Notify(NULL),
+	m_ChangeCounter(0)
 {
 	m_Notify.SetChunkSender(this);
 }
@@ -223,7 +224,8 @@ void cChunkSender::SendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, cClientHa
 	{
 		return;
 	}
-	cChunkDataSerializer Data(m_BlockTypes, m_BlockMetas, m_BlockLight, m_BlockSkyLight, m_BiomeMap);
+	cChunkDataSerializer Data(m_Data, m_BiomeMap);
+	Data.SetCache(m_World->GetChunkPacketCache(), a_ChunkX, a_ChunkZ, m_ChangeCounter);
 	
 	// Send:
 	if (a_Client == NULL)
@@ -273,6 +275,25 @@ void cChunkSender::Entity(cEntity *)
 
 
 
+void cChunkSender::ChunkData(const cChunkData & a_ChunkData)
+{
+	// Reuses the sections already allocated in m_Data from the previous chunk:
+	m_Data = a_ChunkData;
+}
+
+
+
+
+
+void cChunkSender::ChangeCounter(UInt64 a_ChangeCounter)
+{
+	m_ChangeCounter = a_ChangeCounter;
+}
+
+
+
+
+
 void cChunkSender::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
 {
 	for (size_t i = 0; i < ARRAYCOUNT(m_BiomeMap); i++)
@@ -27,6 +27,7 @@ Note that it may be called by world's BroadcastToChunk() if the client is still
 
 #include "OSSupport/IsThread.h"
 #include "ChunkDef.h"
+#include "ChunkData.h"
 
 
 
@@ -68,7 +69,7 @@ public:
 
 class cChunkSender:
 	public cIsThread,
-	public cChunkDataSeparateCollector
+	public cChunkDataCallback
 {
 	typedef cIsThread super;
 public:
@@ -146,17 +147,20 @@ protected:
 	cNotifyChunkSender m_Notify;  // Used for chunks that don't have a valid lighting - they will be re-queued after lightcalc
 	
 	// Data about the chunk that is being sent:
-	// NOTE that m_BlockData[] is inherited from the cChunkDataCollector
+	cChunkData    m_Data;  // Copy of the chunk's sections; only the non-empty sections are copied
 	unsigned char m_BiomeMap[cChunkDef::Width * cChunkDef::Width];
+	UInt64        m_ChangeCounter;  // The chunk's change counter, identifies the data in the world's chunk packet cache
 	sBlockCoords  m_BlockEntities;  // Coords of the block entities to send
 	// TODO: sEntityIDs    m_Entities;       // Entity-IDs of the entities to send
 	
 	// cIsThread override:
 	virtual void Execute(void) override;
 	
-	// cChunkDataCollector overrides:
+	// cChunkDataCallback overrides:
 	// (Note that they are called while the ChunkMap's CS is locked - don't do heavy calculations here!)
+	virtual void ChunkData    (const cChunkData & a_ChunkData) override;
 	virtual void BiomeData    (const cChunkDef::BiomeMap * a_BiomeMap) override;
+	virtual void ChangeCounter(UInt64 a_ChangeCounter) override;
 	virtual void Entity       (cEntity *      a_Entity) override;
 	virtual void BlockEntity  (cBlockEntity * a_Entity) override;
 
@@ -0,0 +1,191 @@
+// ChunkTickPool.cpp
+
+// Implements the cChunkTickPool class representing a pool of worker threads that tick independent groups of chunks in parallel
+
+#include "Globals.h"
+#include "ChunkTickPool.h"
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkTickPool:
+
+cChunkTickPool::cChunkTickPool(int a_NumThreads) :
+	m_Tasks(NULL),
+	m_NextTask(0),
+	m_NumBusyWorkers(0)
+{
+	ASSERT(a_NumThreads > 0);
+	for (int i = 0; i < a_NumThreads; i++)
+	{
+		cWorker * Worker = new cWorker(*this);
+		Worker->StartAndWait();
+		m_Workers.push_back(Worker);
+	}
+}
+
+
+
+
+
+cChunkTickPool::~cChunkTickPool()
+{
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->Stop();
+		delete *itr;
+	}
+	m_Workers.clear();
+}
+
+
+
+
+
+void cChunkTickPool::RunTasks(cTasks & a_Tasks)
+{
+	if (a_Tasks.empty())
+	{
+		return;
+	}
+
+	{
+		cCSLock Lock(m_CS);
+		ASSERT(m_Tasks == NULL);  // Not re-entrant
+		m_Tasks = &a_Tasks;
+		m_NextTask = 0;
+		m_NumBusyWorkers = (int)m_Workers.size();
+	}
+
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->WakeUp();
+	}
+	m_evtAllFinished.Wait();
+
+	cCSLock Lock(m_CS);
+	m_Tasks = NULL;
+}
+
+
+
+
+
+bool cChunkTickPool::IsWorkerThread(void) const
+{
+	unsigned long ThisThreadID = cIsThread::GetCurrentID();
+	for (cWorkers::const_iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		if ((*itr)->GetThreadID() == ThisThreadID)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+MTRand * cChunkTickPool::GetWorkerRand(void)
+{
+	unsigned long ThisThreadID = cIsThread::GetCurrentID();
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		if ((*itr)->GetThreadID() == ThisThreadID)
+		{
+			return &((*itr)->GetRand());
+		}
+	}
+	return NULL;
+}
+
+
+
+
+
+void cChunkTickPool::ProcessTasks(void)
+{
+	for (;;)
+	{
+		cTask * Task;
+		{
+			cCSLock Lock(m_CS);
+			if ((m_Tasks == NULL) || (m_NextTask >= m_Tasks->size()))
+			{
+				// No more tasks, if this was the last busy worker, let RunTasks() return:
+				m_NumBusyWorkers -= 1;
+				if (m_NumBusyWorkers == 0)
+				{
+					m_evtAllFinished.Set();
+				}
+				return;
+			}
+			Task = (*m_Tasks)[m_NextTask];
+			m_NextTask += 1;
+		}
+		Task->Run();
+	}
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// cChunkTickPool::cWorker:
+
+cChunkTickPool::cWorker::cWorker(cChunkTickPool & a_Pool) :
+	super("cChunkTickPool::cWorker"),
+	m_Pool(a_Pool),
+	m_ThreadID(0)
+{
+}
+
+
+
+
+
+void cChunkTickPool::cWorker::StartAndWait(void)
+{
+	Start();
+	m_evtStarted.Wait();
+}
+
+
+
+
+
+void cChunkTickPool::cWorker::Stop(void)
+{
+	m_ShouldTerminate = true;
+	m_evtWakeUp.Set();
+	Wait();
+}
+
+
+
+
+
+void cChunkTickPool::cWorker::Execute(void)
+{
+	m_ThreadID = cIsThread::GetCurrentID();
+	m_evtStarted.Set();
+
+	for (;;)
+	{
+		m_evtWakeUp.Wait();
+		if (m_ShouldTerminate)
+		{
+			return;
+		}
+		m_Pool.ProcessTasks();
+	}
+}
+
+
+
+
@@ -0,0 +1,128 @@
+// ChunkTickPool.h
+
+// Declares the cChunkTickPool class representing a pool of worker threads that tick independent groups of chunks in parallel
+
+/*
+The pool is owned by a cChunkMap and is used only from within cChunkMap::Tick(), which runs in the world's tick thread.
+The tick thread hands a list of tasks to RunTasks(), the workers take the tasks one by one until there are none left,
+and RunTasks() returns once all the tasks have finished. The tick thread holds the chunkmap's lock during the whole time,
+on behalf of the workers, so that no other thread may touch the chunks while they are being ticked.
+
+Each worker has its own random generator, since cWorld's tick random generator may only be used from a single thread.
+*/
+
+
+
+
+
+#pragma once
+
+#include "OSSupport/IsThread.h"
+#include "MersenneTwister.h"
+
+
+
+
+
+class cChunkTickPool
+{
+public:
+
+	/** A single unit of work to be processed by one of the workers */
+	class cTask
+	{
+	public:
+		virtual ~cTask() {}
+
+		/** Called from within a worker thread to process the task */
+		virtual void Run(void) = 0;
+	} ;
+
+	typedef std::vector<cTask *> cTasks;
+
+
+	/** Creates the pool and starts the specified number of worker threads */
+	cChunkTickPool(int a_NumThreads);
+
+	/** Stops all the worker threads */
+	~cChunkTickPool();
+
+	/** Processes all the tasks on the worker threads; returns once all of them have finished.
+	The tasks are not deleted, the caller still owns them. */
+	void RunTasks(cTasks & a_Tasks);
+
+	/** Returns true if the calling thread is one of this pool's workers */
+	bool IsWorkerThread(void) const;
+
+	/** Returns the random generator belonging to the calling worker thread, or NULL if not called from a worker thread */
+	MTRand * GetWorkerRand(void);
+
+	int GetNumThreads(void) const { return (int)m_Workers.size(); }
+
+protected:
+
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+
+	public:
+		cWorker(cChunkTickPool & a_Pool);
+
+		/** Starts the thread and waits until it has stored its thread ID */
+		void StartAndWait(void);
+
+		/** Signals the thread to terminate and waits for it to finish */
+		void Stop(void);
+
+		/** Wakes the worker up to process the tasks in the pool */
+		void WakeUp(void) { m_evtWakeUp.Set(); }
+
+		unsigned long GetThreadID(void) const { return m_ThreadID; }
+
+		MTRand & GetRand(void) { return m_Rand; }
+
+	protected:
+		cChunkTickPool & m_Pool;
+
+		/** The OS thread ID of this worker, used for recognizing the worker in IsWorkerThread() */
+		unsigned long m_ThreadID;
+
+		/** The random generator to be used by the code running in this worker, instead of cWorld's m_TickRand */
+		MTRand m_Rand;
+
+		cEvent m_evtWakeUp;
+		cEvent m_evtStarted;
+
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	} ;
+
+	typedef std::vector<cWorker *> cWorkers;
+
+
+	cWorkers m_Workers;
+
+	/** Protects m_Tasks, m_NextTask and m_NumBusyWorkers */
+	cCriticalSection m_CS;
+
+	/** The tasks currently being processed; NULL when not inside RunTasks() */
+	cTasks * m_Tasks;
+
+	/** Index into m_Tasks of the next task to be taken by a worker */
+	size_t m_NextTask;
+
+	/** Number of workers that haven't yet run out of tasks in the current RunTasks() call */
+	int m_NumBusyWorkers;
+
+	/** Set by the last worker to run out of tasks */
+	cEvent m_evtAllFinished;
+
+
+	/** Processes tasks from m_Tasks until there are none left. Called from within the worker threads. */
+	void ProcessTasks(void);
+} ;
+
+
+
+
@@ -68,7 +68,8 @@ int cClientHandle::s_ClientCount = 0;
 cClientHandle::cClientHandle(const cSocket * a_Socket, int a_ViewDistance) :
 	m_ViewDistance(a_ViewDistance),
 	m_IPString(a_Socket->GetIPString()),
-	m_OutgoingData(64 KiB),
+	m_NumOutgoingBytes(0),
+	m_NumOutgoingBytesCopied(0),
 	m_Player(NULL),
 	m_HasSentDC(false),
 	m_LastStreamedChunkX(0x7fffffff),  // bogus chunk coords to force streaming upon login
@@ -84,7 +85,8 @@ cClientHandle::cClientHandle(const cSocket * a_Socket, int a_ViewDistance) :
 	m_NumExplosionsThisTick(0),
 	m_UniqueID(0),
 	m_HasSentPlayerChunk(false),
-	m_Locale("en_GB")
+	m_Locale("en_GB"),
+	m_InterestManager(*this)
 {
 	m_Protocol = new cProtocolRecognizer(this);
 	
@@ -1532,7 +1534,7 @@ void cClientHandle::HandleTabCompletion(const AString & a_Text)
 
 
 
-void cClientHandle::SendData(const char * a_Data, size_t a_Size)
+void cClientHandle::SendData(const char * a_Data, size_t a_Size, cBufferChain::cTransform * a_Transform)
 {
 	if (m_HasSentDC)
 	{
@@ -1543,37 +1545,10 @@ void cClientHandle::SendData(const char * a_Data, size_t a_Size)
 	{
 		cCSLock Lock(m_CSOutgoingData);
 		
-		// _X 2012_09_06: We need an overflow buffer, usually when streaming the initial chunks
-		if (m_OutgoingDataOverflow.empty())
-		{
-			// No queued overflow data; if this packet fits into the ringbuffer, put it in, otherwise put it in the overflow buffer:
-			size_t CanFit = m_OutgoingData.GetFreeSpace();
-			if (CanFit > a_Size)
-			{
-				CanFit = a_Size;
-			}
-			if (CanFit > 0)
-			{
-				m_OutgoingData.Write(a_Data, CanFit);
-			}
-			if (a_Size > CanFit)
-			{
-				m_OutgoingDataOverflow.append(a_Data + CanFit, a_Size - CanFit);
-			}
-		}
-		else
-		{
-			// There is a queued overflow. Append to it, then send as much from its front as possible
-			m_OutgoingDataOverflow.append(a_Data, a_Size);
-			int CanFit = m_OutgoingData.GetFreeSpace();
-			if (CanFit > 128)
-			{
-				// No point in moving the data over if it's not large enough - too much effort for too little an effect
-				m_OutgoingData.Write(m_OutgoingDataOverflow.data(), CanFit);
-				m_OutgoingDataOverflow.erase(0, CanFit);
-			}
-		}
-	}  // Lock(m_CSOutgoingData)
+		// The single copy of the data, fused with the encryption; from now on the blocks are only handed over:
+		m_OutgoingData.Append(a_Data, a_Size, a_Transform);
+		m_NumOutgoingBytes += a_Size;
+	}
 	
 	// Notify SocketThreads that we have something to write:
 	cRoot::Get()->GetServer()->NotifyClientWrite(this);
@@ -1583,6 +1558,54 @@ void cClientHandle::SendData(const char * a_Data, size_t a_Size)
 
 
 
+void cClientHandle::AddOutgoingBytesCopied(size_t a_Size)
+{
+	cCSLock Lock(m_CSOutgoingData);
+	m_NumOutgoingBytesCopied += a_Size;
+}
+
+
+
+
+
+void cClientHandle::GetOutgoingStats(Int64 & a_NumBytesSent, Int64 & a_NumBytesCopied)
+{
+	cCSLock Lock(m_CSOutgoingData);
+	a_NumBytesSent = m_NumOutgoingBytes;
+	a_NumBytesCopied = m_NumOutgoingBytesCopied + m_OutgoingData.GetNumBytesCopied();
+}
+
+
+
+
+
+int cClientHandle::GetBroadcastFormat(void)
+{
+	return m_Protocol->GetBroadcastFormat();
+}
+
+
+
+
+
+void cClientHandle::SerializeBroadcast(cBroadcastPacket & a_Packet, AString & a_Data)
+{
+	m_Protocol->SerializeBroadcast(a_Packet, a_Data);
+}
+
+
+
+
+
+void cClientHandle::SendSerialized(const AString & a_Data)
+{
+	m_Protocol->SendSerialized(a_Data);
+}
+
+
+
+
+
 void cClientHandle::MoveToWorld(cWorld & a_World, bool a_SendRespawnPacket)
 {
 	UNUSED(a_World);
@@ -1613,6 +1636,9 @@ void cClientHandle::MoveToWorld(cWorld & a_World, bool a_SendRespawnPacket)
 	m_LastStreamedChunkX = 0x7fffffff;
 	m_LastStreamedChunkZ = 0x7fffffff;
 	m_HasSentPlayerChunk = false;
+	
+	// The entities in the old world are gone, so are their queued updates:
+	m_InterestManager.Clear();
 }
 
 
@@ -1675,6 +1701,12 @@ void cClientHandle::Tick(float a_Dt)
 		m_Protocol->SendPlayerMoveLook();
 		m_State = csPlaying;
 	}
+	
+	// Send the entity movement updates that have been queued and are due now:
+	if (m_State == csPlaying)
+	{
+		m_InterestManager.Tick(*m_Player->GetWorld());
+	}
 
 	// Send a ping packet:
 	cTimer t1;
@@ -1973,6 +2005,7 @@ void cClientHandle::SendCollectPickup(const cPickup & a_Pickup, const cPlayer &
 
 void cClientHandle::SendDestroyEntity(const cEntity & a_Entity)
 {
+	m_InterestManager.EntityDestroyed(a_Entity.GetUniqueID());
 	m_Protocol->SendDestroyEntity(a_Entity);
 }
 
@@ -2645,19 +2678,18 @@ void cClientHandle::DataReceived(const char * a_Data, size_t a_Size)
 
 
 
-void cClientHandle::GetOutgoingData(AString & a_Data)
+void cClientHandle::GetOutgoingData(cBufferChain & a_Data)
 {
-	// Data can be sent to client
+	// Data can be sent to client; hand the blocks over to the socket thread, without copying:
+	bool HasData;
 	{
 		cCSLock Lock(m_CSOutgoingData);
-		m_OutgoingData.ReadAll(a_Data);
-		m_OutgoingData.CommitRead();
-		a_Data.append(m_OutgoingDataOverflow);
-		m_OutgoingDataOverflow.clear();
+		HasData = !m_OutgoingData.IsEmpty();
+		a_Data.Splice(m_OutgoingData);
 	}
 
 	// Disconnect player after all packets have been sent
-	if (m_HasSentDC && a_Data.empty())
+	if (m_HasSentDC && !HasData)
 	{
 		Destroy();
 	}
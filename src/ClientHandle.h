@@ -18,6 +18,7 @@
 #include "ByteBuffer.h"
 #include "Scoreboard.h"
 #include "Map.h"
+#include "InterestManager.h"
 
 
 
@@ -32,6 +33,7 @@ class cPainting;
 class cPickup;
 class cPlayer;
 class cProtocol;
+class cBroadcastPacket;
 class cWindow;
 class cFallingBlock;
 class cItemHandler;
@@ -171,6 +173,9 @@ public:
 	
 	// tolua_end
 	
+	/** Returns the manager deciding which entity movement updates are sent to this client and when */
+	cInterestManager & GetInterestManager(void) { return m_InterestManager; }
+	
 	/** Returns true if the client wants the chunk specified to be sent (in m_ChunksToSend) */
 	bool WantsSendChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ);
 	
@@ -225,7 +230,24 @@ public:
 	*/
 	bool HandleLogin(int a_ProtocolVersion, const AString & a_Username);
 	
-	void SendData(const char * a_Data, size_t a_Size);
+	/** Queues the data for sending to the client. If a_Transform is given, the data is transformed (encrypted)
+	while being copied into the outgoing chain; the chain counts this copy. */
+	void SendData(const char * a_Data, size_t a_Size, cBufferChain::cTransform * a_Transform = NULL);
+	
+	/** Adds to the outgoing copy statistics the bytes that the protocol copied before calling SendData(), such as into a staging buffer */
+	void AddOutgoingBytesCopied(size_t a_Size);
+	
+	/** Returns the number of bytes queued for sending to this client so far, and the number of bytes copied on their way to the socket */
+	void GetOutgoingStats(Int64 & a_NumBytesSent, Int64 & a_NumBytesCopied);
+	
+	/** Returns the broadcast format of the client's protocol, see cProtocol::GetBroadcastFormat() */
+	int GetBroadcastFormat(void);
+	
+	/** Serializes the packet in the format of the client's protocol into a_Data, without sending it */
+	void SerializeBroadcast(cBroadcastPacket & a_Packet, AString & a_Data);
+	
+	/** Sends packet data serialized by SerializeBroadcast() of a client with the same broadcast format */
+	void SendSerialized(const AString & a_Data);
 	
 	/** Called when the player moves into a different world; queues sreaming the new chunks */
 	void MoveToWorld(cWorld & a_World, bool a_SendRespawnPacket);
@@ -257,8 +279,9 @@ private:
 	AString          m_IncomingData;
 	
 	cCriticalSection m_CSOutgoingData;
-	cByteBuffer      m_OutgoingData;
-	AString          m_OutgoingDataOverflow;  ///< For data that didn't fit into the m_OutgoingData ringbuffer temporarily
+	cBufferChain     m_OutgoingData;  ///< Data queued for sending, handed over to the socket thread by GetOutgoingData()
+	Int64            m_NumOutgoingBytes;  ///< Total number of bytes queued in m_OutgoingData
+	Int64            m_NumOutgoingBytesCopied;  ///< Total number of bytes copied by the protocol before queueing; the copies into m_OutgoingData are counted by the chain itself
 
 	Vector3d m_ConfirmPosition;
 
@@ -336,6 +359,9 @@ private:
 	/** The plugin channels that the client has registered. */
 	cChannels m_PluginChannels;
 
+	/** Throttles and coalesces the entity movement updates sent to this client */
+	cInterestManager m_InterestManager;
+
 
 	/** Returns true if the rate block interactions is within a reasonable limit (bot protection) */
 	bool CheckBlockInteractionsRate(void);
@@ -363,7 +389,7 @@ private:
 	
 	// cSocketThreads::cCallback overrides:
 	virtual void DataReceived   (const char * a_Data, size_t a_Size) override;  // Data is received from the client
-	virtual void GetOutgoingData(AString & a_Data) override;  // Data can be sent to client
+	virtual void GetOutgoingData(cBufferChain & a_Data) override;  // Data can be sent to client
 	virtual void SocketClosed   (void) override;  // The socket has been closed for any reason
 };										// tolua_export
 
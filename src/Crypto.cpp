@@ -308,7 +308,6 @@ void cPublicKey::InitRnd(void)
 // cAESCFBDecryptor:
 
 cAESCFBDecryptor::cAESCFBDecryptor(void) :
-	m_IVOffset(0),
 	m_IsValid(false)
 {
 }
@@ -319,8 +318,7 @@ cAESCFBDecryptor::cAESCFBDecryptor(void) :
 
 cAESCFBDecryptor::~cAESCFBDecryptor()
 {
-	// Clear the leftover in-memory data, so that they can't be accessed by a backdoor
-	memset(&m_Aes, 0, sizeof(m_Aes));
+	// The cipher clears its key on destruction
 }
 
 
@@ -331,8 +329,7 @@ void cAESCFBDecryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 {
 	ASSERT(!IsValid());  // Cannot Init twice
 	
-	memcpy(m_IV, a_IV, 16);
-	aes_setkey_enc(&m_Aes, a_Key, 128);
+	m_Cipher.Init(a_Key, a_IV);
 	m_IsValid = true;
 }
 
@@ -344,18 +341,8 @@ void cAESCFBDecryptor::ProcessData(Byte * a_DecryptedOut, const Byte * a_Encrypt
 {
 	ASSERT(IsValid());  // Must Init() first
 	
-	// PolarSSL doesn't support AES-CFB8, need to implement it manually:
-	for (size_t i = 0; i < a_Length; i++)
-	{
-		Byte Buffer[sizeof(m_IV)];
-		aes_crypt_ecb(&m_Aes, AES_ENCRYPT, m_IV, Buffer);
-		for (size_t idx = 0; idx < sizeof(m_IV) - 1; idx++)
-		{
-			m_IV[idx] = m_IV[idx + 1];
-		}
-		m_IV[sizeof(m_IV) - 1] = a_EncryptedIn[i];
-		a_DecryptedOut[i] = a_EncryptedIn[i] ^ Buffer[0];
-	}
+	// PolarSSL doesn't support AES-CFB8, it is implemented by cAESCFB8, processing the whole buffer at once:
+	m_Cipher.Decrypt(a_DecryptedOut, a_EncryptedIn, a_Length);
 }
 
 
@@ -366,7 +353,6 @@ void cAESCFBDecryptor::ProcessData(Byte * a_DecryptedOut, const Byte * a_Encrypt
 // cAESCFBEncryptor:
 
 cAESCFBEncryptor::cAESCFBEncryptor(void) :
-	m_IVOffset(0),
 	m_IsValid(false)
 {
 }
@@ -377,8 +363,7 @@ cAESCFBEncryptor::cAESCFBEncryptor(void) :
 
 cAESCFBEncryptor::~cAESCFBEncryptor()
 {
-	// Clear the leftover in-memory data, so that they can't be accessed by a backdoor
-	memset(&m_Aes, 0, sizeof(m_Aes));
+	// The cipher clears its key on destruction
 }
 
 
@@ -388,10 +373,8 @@ cAESCFBEncryptor::~cAESCFBEncryptor()
 void cAESCFBEncryptor::Init(const Byte a_Key[16], const Byte a_IV[16])
 {
 	ASSERT(!IsValid());  // Cannot Init twice
-	ASSERT(m_IVOffset == 0);
 	
-	memcpy(m_IV, a_IV, 16);
-	aes_setkey_enc(&m_Aes, a_Key, 128);
+	m_Cipher.Init(a_Key, a_IV);
 	m_IsValid = true;
 }
 
@@ -403,18 +386,8 @@ void cAESCFBEncryptor::ProcessData(Byte * a_EncryptedOut, const Byte * a_PlainIn
 {
 	ASSERT(IsValid());  // Must Init() first
 	
-	// PolarSSL doesn't do AES-CFB8, so we need to implement it ourselves:
-	for (size_t i = 0; i < a_Length; i++)
-	{
-		Byte Buffer[sizeof(m_IV)];
-		aes_crypt_ecb(&m_Aes, AES_ENCRYPT, m_IV, Buffer);
-		for (size_t idx = 0; idx < sizeof(m_IV) - 1; idx++)
-		{
-			m_IV[idx] = m_IV[idx + 1];
-		}
-		a_EncryptedOut[i] = a_PlainIn[i] ^ Buffer[0];
-		m_IV[sizeof(m_IV) - 1] = a_EncryptedOut[i];
-	}
+	// PolarSSL doesn't do AES-CFB8, it is implemented by cAESCFB8, processing the whole buffer at once:
+	m_Cipher.Encrypt(a_EncryptedOut, a_PlainIn, a_Length);
 }
 
 
@@ -10,11 +10,12 @@
 #pragma once
 
 #include "polarssl/rsa.h"
-#include "polarssl/aes.h"
 #include "polarssl/entropy.h"
 #include "polarssl/ctr_drbg.h"
 #include "polarssl/sha1.h"
 #include "polarssl/pk.h"
+#include "AESCFB8.h"
+#include "OSSupport/BufferChain.h"
 
 
 
@@ -93,7 +94,7 @@ protected:
 
 
 
-/** Decrypts data using the AES / CFB (128) algorithm */
+/** Decrypts data using the AES / CFB8 (128-bit key) algorithm */
 class cAESCFBDecryptor
 {
 public:
@@ -112,13 +113,8 @@ public:
 	bool IsValid(void) const { return m_IsValid; }
 	
 protected:
-	aes_context m_Aes;
-	
-	/** The InitialVector, used by the CFB mode decryption */
-	Byte m_IV[16];
-	
-	/** Current offset in the m_IV, used by the CFB mode decryption */
-	size_t m_IVOffset;
+	/** The AES-128 / CFB8 cipher, with the expanded key and the current IV */
+	cAESCFB8 m_Cipher;
 	
 	/** Indicates whether the object has been initialized with the Key / IV */
 	bool m_IsValid;
@@ -128,8 +124,10 @@ protected:
 
 
 
-/** Encrypts data using the AES / CFB (128) algorithm */
-class cAESCFBEncryptor
+/** Encrypts data using the AES / CFB8 (128-bit key) algorithm.
+Serves as the transform for the outgoing data chain, so that the data is encrypted while being queued for sending. */
+class cAESCFBEncryptor :
+	public cBufferChain::cTransform
 {
 public:
 	cAESCFBEncryptor(void);
@@ -144,14 +142,15 @@ public:
 	/** Returns true if the object has been initialized with the Key / IV */
 	bool IsValid(void) const { return m_IsValid; }
 	
-protected:
-	aes_context m_Aes;
+	// cBufferChain::cTransform override:
+	virtual void Transform(Byte * a_Out, const Byte * a_In, size_t a_Size) override
+	{
+		ProcessData(a_Out, a_In, a_Size);
+	}
 	
-	/** The InitialVector, used by the CFB mode encryption */
-	Byte m_IV[16];
-	
-	/** Current offset in the m_IV, used by the CFB mode encryption */
-	size_t m_IVOffset;
+protected:
+	/** The AES-128 / CFB8 cipher, with the expanded key and the current IV */
+	cAESCFB8 m_Cipher;
 	
 	/** Indicates whether the object has been initialized with the Key / IV */
 	bool m_IsValid;
@@ -132,7 +132,7 @@ void cPickup::Tick(float a_Dt, cChunk & a_Chunk)
 				if (!IsDestroyed()) // Don't try to combine if someone has tried to combine me
 				{
 					cPickupCombiningCallback PickupCombiningCallback(GetPosition(), this);
-					m_World->ForEachEntity(PickupCombiningCallback); // Not ForEachEntityInChunk, otherwise pickups don't combine across chunk boundaries
+					m_World->ForEachEntityInRadius(GetPosition(), 1.2, PickupCombiningCallback);  // Not ForEachEntityInChunk, otherwise pickups don't combine across chunk boundaries
 					if (PickupCombiningCallback.FoundMatchingPickup())
 					{
 						m_World->BroadcastEntityMetadata(*this);
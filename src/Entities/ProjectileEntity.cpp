@@ -12,6 +12,7 @@
 #include "../BoundingBox.h"
 #include "../ChunkMap.h"
 #include "../Chunk.h"
+#include "../World.h"
 
 
 
@@ -20,6 +21,9 @@
 /// Converts an angle in radians into a byte representation used by the network protocol
 #define ANGLE_TO_PROTO(X) (Byte)(X * 255 / 360)
 
+/// How far (in blocks) from the traced line an entity's position may be for its bounding box to still touch the line. Covers all but the largest mobs.
+#define MAX_ENTITY_COLLISION_SIZE 4
+
 
 
 
@@ -339,9 +343,12 @@ void cProjectileEntity::HandlePhysics(float a_Dt, cChunk & a_Chunk)
 	}
 	// The tracer also checks the blocks for slowdown blocks - water and lava - and stores it for later in its SlowdownCoeff
 	
-	// Test for entity collisions:
+	// Test for entity collisions, in all the entities whose bounding box may touch the traced line:
 	cProjectileEntityCollisionCallback EntityCollisionCallback(this, Pos, NextPos);
-	a_Chunk.ForEachEntity(EntityCollisionCallback);
+	cBoundingBox TraceBox(Pos, Pos);
+	TraceBox = TraceBox.Union(cBoundingBox(NextPos, NextPos));
+	TraceBox.Expand(MAX_ENTITY_COLLISION_SIZE, MAX_ENTITY_COLLISION_SIZE, MAX_ENTITY_COLLISION_SIZE);
+	m_World->ForEachEntityInBox(TraceBox, EntityCollisionCallback);
 	if (EntityCollisionCallback.HasHit())
 	{
 		// An entity was hit:
@@ -358,7 +365,6 @@ void cProjectileEntity::HandlePhysics(float a_Dt, cChunk & a_Chunk)
 		
 		OnHitEntity(*(EntityCollisionCallback.GetHitEntity()), HitPos);
 	}
-	// TODO: Test the entities in the neighboring chunks, too
 
 	// Update the position:
 	SetPosition(NextPos);
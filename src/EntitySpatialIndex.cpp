@@ -0,0 +1,196 @@
+// EntitySpatialIndex.cpp
+
+// Implements the cEntitySpatialIndex class representing a uniform grid of all the entities in a world, for fast area queries
+
+#include "Globals.h"
+#include "EntitySpatialIndex.h"
+#include "BoundingBox.h"
+#include "Entities/Entity.h"
+
+
+
+
+
+void cEntitySpatialIndex::Update(cEntity * a_Entity)
+{
+	sCellCoords Cell = PosToCell(a_Entity->GetPosition());
+	
+	cCSLock Lock(m_CS);
+	cEntityCells::iterator itr = m_EntityCells.find(a_Entity);
+	if (itr != m_EntityCells.end())
+	{
+		if (itr->second == Cell)
+		{
+			// Still in the same cell, nothing to do
+			return;
+		}
+		RemoveFromCell(a_Entity, itr->second);
+		itr->second = Cell;
+	}
+	else
+	{
+		m_EntityCells.insert(std::make_pair(a_Entity, Cell));
+	}
+	m_Cells[Cell].push_back(a_Entity);
+}
+
+
+
+
+
+void cEntitySpatialIndex::Remove(cEntity * a_Entity)
+{
+	cCSLock Lock(m_CS);
+	cEntityCells::iterator itr = m_EntityCells.find(a_Entity);
+	if (itr == m_EntityCells.end())
+	{
+		return;
+	}
+	RemoveFromCell(a_Entity, itr->second);
+	m_EntityCells.erase(itr);
+}
+
+
+
+
+
+void cEntitySpatialIndex::QueryBox(const cBoundingBox & a_Box, cEntityVector & a_Entities)
+{
+	QueryMinMax(a_Box.GetMin(), a_Box.GetMax(), a_Entities);
+}
+
+
+
+
+
+void cEntitySpatialIndex::QueryRadius(const Vector3d & a_Center, double a_Radius, cEntityVector & a_Entities)
+{
+	// Query the bounding box first, then filter out the corners:
+	Vector3d Radius(a_Radius, a_Radius, a_Radius);
+	size_t First = a_Entities.size();
+	QueryMinMax(a_Center - Radius, a_Center + Radius, a_Entities);
+	
+	double RadiusSq = a_Radius * a_Radius;
+	size_t Last = First;
+	for (size_t i = First, NumEntities = a_Entities.size(); i < NumEntities; i++)
+	{
+		if ((a_Entities[i]->GetPosition() - a_Center).SqrLength() < RadiusSq)
+		{
+			a_Entities[Last++] = a_Entities[i];
+		}
+	}
+	a_Entities.resize(Last);
+}
+
+
+
+
+
+size_t cEntitySpatialIndex::GetNumEntities(void)
+{
+	cCSLock Lock(m_CS);
+	return m_EntityCells.size();
+}
+
+
+
+
+
+size_t cEntitySpatialIndex::GetNumCells(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Cells.size();
+}
+
+
+
+
+
+cEntitySpatialIndex::sCellCoords cEntitySpatialIndex::PosToCell(const Vector3d & a_Pos)
+{
+	return sCellCoords(
+		FAST_FLOOR_DIV((int)floor(a_Pos.x), CELL_SIZE),
+		FAST_FLOOR_DIV((int)floor(a_Pos.y), CELL_SIZE),
+		FAST_FLOOR_DIV((int)floor(a_Pos.z), CELL_SIZE)
+	);
+}
+
+
+
+
+
+void cEntitySpatialIndex::RemoveFromCell(cEntity * a_Entity, const sCellCoords & a_Cell)
+{
+	ASSERT(m_CS.IsLocked());
+	
+	cCells::iterator itr = m_Cells.find(a_Cell);
+	if (itr == m_Cells.end())
+	{
+		ASSERT(!"Entity's cell not found in the spatial index");
+		return;
+	}
+	cEntityVector & Entities = itr->second;
+	cEntityVector::iterator Entity = std::find(Entities.begin(), Entities.end(), a_Entity);
+	ASSERT(Entity != Entities.end());
+	if (Entity != Entities.end())
+	{
+		// The order doesn't matter, replace with the last one instead of shifting all:
+		*Entity = Entities.back();
+		Entities.pop_back();
+	}
+	if (Entities.empty())
+	{
+		m_Cells.erase(itr);
+	}
+}
+
+
+
+
+
+void cEntitySpatialIndex::QueryMinMax(const Vector3d & a_Min, const Vector3d & a_Max, cEntityVector & a_Entities)
+{
+	Vector3d Margin(MOVEMENT_MARGIN, MOVEMENT_MARGIN, MOVEMENT_MARGIN);
+	sCellCoords MinCell = PosToCell(a_Min - Margin);
+	sCellCoords MaxCell = PosToCell(a_Max + Margin);
+	
+	cCSLock Lock(m_CS);
+	
+	// Huge queries (such as a whole world) would visit lots of empty cells, walk the existing cells instead:
+	Int64 NumQueryCells = (Int64)(MaxCell.m_X - MinCell.m_X + 1) * (MaxCell.m_Y - MinCell.m_Y + 1) * (MaxCell.m_Z - MinCell.m_Z + 1);
+	if (NumQueryCells > (Int64)m_Cells.size())
+	{
+		for (cEntityCells::const_iterator itr = m_EntityCells.begin(), end = m_EntityCells.end(); itr != end; ++itr)
+		{
+			if (cBoundingBox::IsInside(a_Min, a_Max, itr->first->GetPosition()))
+			{
+				a_Entities.push_back(itr->first);
+			}
+		}
+		return;
+	}
+	
+	for (int x = MinCell.m_X; x <= MaxCell.m_X; x++)
+	{
+		for (int z = MinCell.m_Z; z <= MaxCell.m_Z; z++)
+		{
+			// The cells are sorted by X, then Z, then Y, so a whole column can be walked at once:
+			cCells::const_iterator itr = m_Cells.lower_bound(sCellCoords(x, MinCell.m_Y, z));
+			cCells::const_iterator end = m_Cells.end();
+			for (; (itr != end) && (itr->first.m_X == x) && (itr->first.m_Z == z) && (itr->first.m_Y <= MaxCell.m_Y); ++itr)
+			{
+				for (cEntityVector::const_iterator Entity = itr->second.begin(), EntityEnd = itr->second.end(); Entity != EntityEnd; ++Entity)
+				{
+					if (cBoundingBox::IsInside(a_Min, a_Max, (*Entity)->GetPosition()))
+					{
+						a_Entities.push_back(*Entity);
+					}
+				}
+			}  // for itr - m_Cells[]
+		}  // for z
+	}  // for x
+}
+
+
+
+
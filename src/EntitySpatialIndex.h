@@ -0,0 +1,117 @@
+// EntitySpatialIndex.h
+
+// Declares the cEntitySpatialIndex class representing a uniform grid of all the entities in a world, for fast area queries
+
+/*
+The world is divided into cubic cells of CELL_SIZE blocks; each cell lists the entities whose position is inside it.
+The entity's cell is updated whenever its chunk ticks (and when it is added to a chunk), so the positions stored in
+the index may be up to one tick old. The queries account for that by searching the cells with a margin and then
+filtering the candidates by their actual current position.
+The index has its own lock, so that it can be updated by the parallel tick workers. The entity pointers returned by
+the queries are safe to use only while the chunkmap is locked, same as with the other entity enumerations.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Vector3.h"
+
+
+
+
+
+// fwd:
+class cEntity;
+class cBoundingBox;
+
+typedef std::vector<cEntity *> cEntityVector;
+
+
+
+
+
+class cEntitySpatialIndex
+{
+public:
+	/** Size of a single grid cell, in blocks */
+	static const int CELL_SIZE = 8;
+	
+	/** How far (in blocks) an entity may move between two index updates and still be found by the queries */
+	static const int MOVEMENT_MARGIN = 4;
+	
+	
+	/** Adds the entity into the index, or updates its position if it already is indexed */
+	void Update(cEntity * a_Entity);
+	
+	/** Removes the entity from the index; ignored if not indexed */
+	void Remove(cEntity * a_Entity);
+	
+	/** Appends all the entities whose position is inside the specified box to a_Entities */
+	void QueryBox(const cBoundingBox & a_Box, cEntityVector & a_Entities);
+	
+	/** Appends all the entities whose position is closer than a_Radius to a_Center to a_Entities */
+	void QueryRadius(const Vector3d & a_Center, double a_Radius, cEntityVector & a_Entities);
+	
+	/** Returns the number of entities indexed */
+	size_t GetNumEntities(void);
+	
+	/** Returns the number of non-empty cells */
+	size_t GetNumCells(void);
+	
+protected:
+
+	struct sCellCoords
+	{
+		int m_X;
+		int m_Y;
+		int m_Z;
+		
+		sCellCoords(int a_X, int a_Y, int a_Z) : m_X(a_X), m_Y(a_Y), m_Z(a_Z) {}
+		
+		bool operator ==(const sCellCoords & a_Other) const
+		{
+			return ((m_X == a_Other.m_X) && (m_Y == a_Other.m_Y) && (m_Z == a_Other.m_Z));
+		}
+		
+		bool operator <(const sCellCoords & a_Other) const
+		{
+			if (m_X != a_Other.m_X)
+			{
+				return (m_X < a_Other.m_X);
+			}
+			if (m_Z != a_Other.m_Z)
+			{
+				return (m_Z < a_Other.m_Z);
+			}
+			return (m_Y < a_Other.m_Y);
+		}
+	} ;
+	
+	typedef std::map<sCellCoords, cEntityVector> cCells;
+	typedef std::map<cEntity *, sCellCoords> cEntityCells;
+	
+	cCriticalSection m_CS;
+	
+	/** The entities in each cell */
+	cCells m_Cells;
+	
+	/** The cell of each indexed entity */
+	cEntityCells m_EntityCells;
+	
+	
+	/** Returns the cell containing the specified position */
+	static sCellCoords PosToCell(const Vector3d & a_Pos);
+	
+	/** Removes the entity from the specified cell's list, removing the cell if it becomes empty. Assumes m_CS is locked. */
+	void RemoveFromCell(cEntity * a_Entity, const sCellCoords & a_Cell);
+	
+	/** Appends the entities from all the cells intersecting the box (expanded by MOVEMENT_MARGIN) whose position is inside the box */
+	void QueryMinMax(const Vector3d & a_Min, const Vector3d & a_Max, cEntityVector & a_Entities);
+} ;
+
+
+
+
@@ -15,6 +15,7 @@ Interfaces to the various biome generators:
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "ChunkCacheIndex.h"
 #include "../Noise.h"
 #include "../VoronoiMap.h"
 
@@ -41,7 +42,7 @@ protected:
 
 
 
-/// A simple cache that stores N most recently generated chunks' biomes; N being settable upon creation
+/// A cache that stores the biomes of up to N recently generated chunks; N being settable upon creation
 class cBioGenCache :
 	public cBiomeGen
 {
@@ -57,20 +58,17 @@ protected:
 	
 	struct sCacheData
 	{
-		int m_ChunkX;
-		int m_ChunkZ;
 		cChunkDef::BiomeMap m_BiomeMap;
 	} ;
 	
-	// To avoid moving large amounts of data for the MRU behavior, we MRU-ize indices to an array of the actual data
-	int          m_CacheSize;
-	int *        m_CacheOrder;  // MRU-ized order, indices into m_CacheData array
-	sCacheData * m_CacheData;   // m_CacheData[m_CacheOrder[0]] is the most recently used
+	/** Protects m_Index and m_CacheData, the cache may be queried from multiple generator threads */
+	cCriticalSection m_CS;
 	
-	// Cache statistics
-	int m_NumHits;
-	int m_NumMisses;
-	int m_TotalChain;  // Number of cache items walked to get to a hit (only added for hits)
+	/** Decides which item of m_CacheData holds which chunk; the lookups cost the same regardless of the cache size */
+	cChunkCacheIndex m_Index;
+	
+	/** The cached data, m_Index.GetSize() items, indexed by the slot numbers returned by m_Index */
+	sCacheData * m_CacheData;
 	
 	virtual void GenBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap) override;
 	virtual void InitializeBiomeGen(cIniFile & a_IniFile) override;
@@ -121,8 +121,9 @@ typedef std::vector<cCaveTunnel *> cCaveTunnels;
 
 
 
-/// A collection of connected tunnels, possibly branching.
-class cStructGenWormNestCaves::cCaveSystem
+/// A collection of connected tunnels, possibly branching. Shared through the cFinishGenCache, read-only once created.
+class cStructGenWormNestCaves::cCaveSystem :
+	public cFinishGenCache::cStructure
 {
 public:
 	// The generating block position; is read directly in cStructGenWormNestCaves::GetCavesForChunk()
@@ -740,28 +741,6 @@ int cStructGenWormNestCaves::cCaveSystem::GetRadius(cNoise & a_Noise, int a_Orig
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cStructGenWormNestCaves:
 
-cStructGenWormNestCaves::~cStructGenWormNestCaves()
-{
-	ClearCache();
-}
-
-
-
-
-
-void cStructGenWormNestCaves::ClearCache(void)
-{
-	for (cCaveSystems::const_iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end; ++itr)
-	{
-		delete *itr;
-	}  // for itr - m_Cache[]
-	m_Cache.clear();
-}
-
-
-
-
-
 void cStructGenWormNestCaves::GenFinish(cChunkDesc & a_ChunkDesc)
 {
 	int ChunkX = a_ChunkDesc.GetChunkX();
@@ -771,6 +750,7 @@ void cStructGenWormNestCaves::GenFinish(cChunkDesc & a_ChunkDesc)
 	for (cCaveSystems::const_iterator itr = Caves.begin(); itr != Caves.end(); ++itr)
 	{
 		(*itr)->ProcessChunk(ChunkX, ChunkZ, a_ChunkDesc.GetBlockTypes(), a_ChunkDesc.GetHeightMap());
+		m_Cache.Release(*itr);
 	}  // for itr - Caves[]
 }
 
@@ -793,69 +773,21 @@ void cStructGenWormNestCaves::GetCavesForChunk(int a_ChunkX, int a_ChunkZ, cStru
 	BaseX -= NEIGHBORHOOD_SIZE / 2;
 	BaseZ -= NEIGHBORHOOD_SIZE / 2;
 
-	// Walk the cache, move each cave system that we want into a_Caves:
-	int StartX = BaseX * m_Grid;
-	int EndX = (BaseX + NEIGHBORHOOD_SIZE + 1) * m_Grid;
-	int StartZ = BaseZ * m_Grid;
-	int EndZ = (BaseZ + NEIGHBORHOOD_SIZE + 1) * m_Grid;
-	for (cCaveSystems::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end;)
-	{
-		if (
-			((*itr)->m_BlockX >= StartX) && ((*itr)->m_BlockX < EndX) &&
-			((*itr)->m_BlockZ >= StartZ) && ((*itr)->m_BlockZ < EndZ)
-		)
-		{
-			// want
-			a_Caves.push_back(*itr);
-			itr = m_Cache.erase(itr);
-		}
-		else
-		{
-			// don't want
-			++itr;
-		}
-	}  // for itr - m_Cache[]
-
 	for (int x = 0; x < NEIGHBORHOOD_SIZE; x++)
 	{
 		int RealX = (BaseX + x) * m_Grid;
 		for (int z = 0; z < NEIGHBORHOOD_SIZE; z++)
 		{
 			int RealZ = (BaseZ + z) * m_Grid;
-			bool Found = false;
-			for (cCaveSystems::const_iterator itr = a_Caves.begin(), end = a_Caves.end(); itr != end; ++itr)
-			{
-				if (((*itr)->m_BlockX == RealX) && ((*itr)->m_BlockZ == RealZ))
-				{
-					Found = true;
-					break;
-				}
-			}
-			if (!Found)
+			cFinishGenCache::cStructure * Cave = m_Cache.Get(cFinishGenCache::kindWormNestCaves, RealX, RealZ);
+			if (Cave == NULL)
 			{
-				a_Caves.push_back(new cCaveSystem(RealX, RealZ, m_MaxOffset, m_Size, m_Noise));
+				Cave = m_Cache.Put(cFinishGenCache::kindWormNestCaves, RealX, RealZ, new cCaveSystem(RealX, RealZ, m_MaxOffset, m_Size, m_Noise));
 			}
+			a_Caves.push_back(static_cast<cCaveSystem *>(Cave));
 		}
 	}
 
-	// Copy a_Caves into m_Cache to the beginning:
-	cCaveSystems CavesCopy(a_Caves);
-	m_Cache.splice(m_Cache.begin(), CavesCopy, CavesCopy.begin(), CavesCopy.end());
-
-	// Trim the cache if it's too long:
-	if (m_Cache.size() > 100)
-	{
-		cCaveSystems::iterator itr = m_Cache.begin();
-		std::advance(itr, 100);
-		for (cCaveSystems::iterator end = m_Cache.end(); itr != end; ++itr)
-		{
-			delete *itr;
-		}
-		itr = m_Cache.begin();
-		std::advance(itr, 100);
-		m_Cache.erase(itr, m_Cache.end());
-	}
-
 	/*
 	// Uncomment this block for debugging the caves' shapes in 2D using an SVG export
 	#ifdef _DEBUG
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "FinishGenCache.h"
 #include "../Noise.h"
 
 
@@ -67,16 +68,15 @@ class cStructGenWormNestCaves :
 	public cFinishGen
 {
 public:
-	cStructGenWormNestCaves(int a_Seed, int a_Size = 64, int a_Grid = 96, int a_MaxOffset = 128) :
+	cStructGenWormNestCaves(int a_Seed, cFinishGenCache & a_Cache, int a_Size = 64, int a_Grid = 96, int a_MaxOffset = 128) :
 		m_Noise(a_Seed),
 		m_Size(a_Size),
 		m_MaxOffset(a_MaxOffset),
-		m_Grid(a_Grid)
+		m_Grid(a_Grid),
+		m_Cache(a_Cache)
 	{
 	}
 	
-	~cStructGenWormNestCaves();
-	
 protected:
 	class cCaveSystem;  // fwd: Caves.cpp
 	typedef std::list<cCaveSystem *> cCaveSystems;
@@ -85,12 +85,9 @@ protected:
 	int          m_Size;  // relative size of the cave systems' caves. Average number of blocks of each initial tunnel
 	int          m_MaxOffset;  // maximum offset of the cave nest origin from the grid cell the nest belongs to
 	int          m_Grid;  // average spacing of the nests
-	cCaveSystems m_Cache;
-	
-	/// Clears everything from the cache
-	void ClearCache(void);
+	cFinishGenCache & m_Cache;  // The cave systems are shared with the other generator threads
 	
-	/// Returns all caves that *may* intersect the given chunk. All the caves are valid until the next call to this function.
+	/// Returns all caves that *may* intersect the given chunk. The caller must release all the caves through m_Cache.
 	void GetCavesForChunk(int a_ChunkX, int a_ChunkZ, cCaveSystems & a_Caves);
 	
 	// cStructGen override:
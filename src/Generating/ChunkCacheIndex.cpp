@@ -0,0 +1,122 @@
+
+// ChunkCacheIndex.cpp
+
+// Implements the cChunkCacheIndex class that maps chunk coords to slots of a fixed-size set-associative cache
+
+#include "Globals.h"
+#include "ChunkCacheIndex.h"
+
+
+
+
+
+cChunkCacheIndex::cChunkCacheIndex(int a_MinSize) :
+	m_NumSets(1),
+	m_UseCounter(0),
+	m_NumHits(0),
+	m_NumMisses(0)
+{
+	while (m_NumSets * NUM_WAYS < a_MinSize)
+	{
+		m_NumSets *= 2;
+	}
+	m_SetMask = (unsigned)m_NumSets - 1;
+	m_Slots = new sSlot[m_NumSets * NUM_WAYS];
+	for (int i = m_NumSets * NUM_WAYS - 1; i >= 0; i--)
+	{
+		m_Slots[i].m_ChunkX = 0;
+		m_Slots[i].m_ChunkZ = 0;
+		m_Slots[i].m_IsUsed = false;
+		m_Slots[i].m_LastUsed = 0;
+	}
+}
+
+
+
+
+
+cChunkCacheIndex::~cChunkCacheIndex()
+{
+	delete[] m_Slots;
+}
+
+
+
+
+
+int cChunkCacheIndex::Find(int a_ChunkX, int a_ChunkZ)
+{
+	int Slot = FindInSet(GetSetStart(a_ChunkX, a_ChunkZ), a_ChunkX, a_ChunkZ);
+	if (Slot < 0)
+	{
+		m_NumMisses++;
+		return -1;
+	}
+	m_NumHits++;
+	m_Slots[Slot].m_LastUsed = ++m_UseCounter;
+	return Slot;
+}
+
+
+
+
+
+int cChunkCacheIndex::Assign(int a_ChunkX, int a_ChunkZ)
+{
+	int SetStart = GetSetStart(a_ChunkX, a_ChunkZ);
+	int Slot = FindInSet(SetStart, a_ChunkX, a_ChunkZ);
+	if (Slot < 0)
+	{
+		// Pick an empty slot, or the least recently used one:
+		Slot = SetStart;
+		for (int i = SetStart; i < SetStart + NUM_WAYS; i++)
+		{
+			if (!m_Slots[i].m_IsUsed)
+			{
+				Slot = i;
+				break;
+			}
+			if (m_Slots[i].m_LastUsed < m_Slots[Slot].m_LastUsed)
+			{
+				Slot = i;
+			}
+		}
+		m_Slots[Slot].m_ChunkX = a_ChunkX;
+		m_Slots[Slot].m_ChunkZ = a_ChunkZ;
+		m_Slots[Slot].m_IsUsed = true;
+	}
+	m_Slots[Slot].m_LastUsed = ++m_UseCounter;
+	return Slot;
+}
+
+
+
+
+
+int cChunkCacheIndex::GetSetStart(int a_ChunkX, int a_ChunkZ) const
+{
+	// Multiplicative hashing, so that both the neighbouring chunks and the chunks in a line spread over the sets:
+	unsigned Hash = (unsigned)a_ChunkX * 0x9e3779b1u + (unsigned)a_ChunkZ * 0x85ebca6bu;
+	Hash ^= Hash >> 16;
+	return (int)(Hash & m_SetMask) * NUM_WAYS;
+}
+
+
+
+
+
+int cChunkCacheIndex::FindInSet(int a_SetStart, int a_ChunkX, int a_ChunkZ) const
+{
+	for (int i = a_SetStart; i < a_SetStart + NUM_WAYS; i++)
+	{
+		if (m_Slots[i].m_IsUsed && (m_Slots[i].m_ChunkX == a_ChunkX) && (m_Slots[i].m_ChunkZ == a_ChunkZ))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+
+
+
@@ -0,0 +1,86 @@
+
+// ChunkCacheIndex.h
+
+// Declares the cChunkCacheIndex class that maps chunk coords to slots of a fixed-size set-associative cache
+
+/*
+The generator caches (cBioGenCache, cHeiGenCache, cCompoGenCache) store per-chunk data in an array of slots;
+this class decides which slot holds which chunk. The chunk coords are hashed into a set of NUM_WAYS slots, only that
+set is searched on lookup and the least recently used slot of that set is replaced on insertion, so the cost of both
+is constant, regardless of the cache size. The number of slots is the requested size rounded up to a power of 2 sets.
+The index itself is not thread-safe, the owner locks its own CS around both the index operations and the accesses
+to the slot data, so that a slot isn't reassigned while its data is being copied.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cChunkCacheIndex
+{
+public:
+	/** Number of the slots in each set */
+	static const int NUM_WAYS = 4;
+
+
+	/** Creates an index of at least a_MinSize slots, all of them empty */
+	cChunkCacheIndex(int a_MinSize);
+
+	~cChunkCacheIndex();
+
+	/** Returns the number of the slots; the data array of the owner must be this large */
+	int GetSize(void) const { return m_NumSets * NUM_WAYS; }
+
+	/** Returns the slot holding the chunk, marking it as the most recently used in its set; returns -1 if not cached.
+	Counts the hit or miss for the stats. */
+	int Find(int a_ChunkX, int a_ChunkZ);
+
+	/** Returns the slot into which the chunk's data is to be stored, marking it as the most recently used in its set.
+	If the chunk is already cached (inserted by another thread in the meantime), returns its slot;
+	otherwise the least recently used slot of the set is assigned to the chunk. */
+	int Assign(int a_ChunkX, int a_ChunkZ);
+
+	int GetNumHits  (void) const { return m_NumHits; }
+	int GetNumMisses(void) const { return m_NumMisses; }
+
+protected:
+	/** The chunk held by a single slot */
+	struct sSlot
+	{
+		int m_ChunkX;
+		int m_ChunkZ;
+		bool m_IsUsed;
+		Int64 m_LastUsed;  ///< Value of m_UseCounter when the slot was last used, for picking the LRU slot of a set
+	} ;
+
+	int m_NumSets;
+
+	/** m_NumSets - 1; m_NumSets is a power of 2, so this masks the hash into a set number */
+	unsigned m_SetMask;
+
+	/** m_NumSets * NUM_WAYS slots, the sets are consecutive */
+	sSlot * m_Slots;
+
+	/** Incremented on each use of a slot */
+	Int64 m_UseCounter;
+
+	int m_NumHits;
+	int m_NumMisses;
+
+
+	/** Returns the index of the first slot of the set into which the chunk coords hash */
+	int GetSetStart(int a_ChunkX, int a_ChunkZ) const;
+
+	/** Returns the slot in the set that holds the chunk, or -1 if none */
+	int FindInSet(int a_SetStart, int a_ChunkX, int a_ChunkZ) const;
+} ;
+
+
+
+
@@ -5,6 +5,7 @@
 #include "inifile/iniFile.h"
 #include "ChunkDesc.h"
 #include "ComposableGenerator.h"
+#include "FinishGenCache.h"
 #include "Noise3DGenerator.h"
 #include "../MersenneTwister.h"
 
@@ -26,8 +27,14 @@ const unsigned int QUEUE_SKIP_LIMIT = 500;
 // cChunkGenerator:
 
 cChunkGenerator::cChunkGenerator(void) :
-	super("cChunkGenerator"),
+	m_Seed(0),
+	m_LastPlayerChunksUpdate(0),
+	m_ShouldTerminate(false),
+	m_NumChunksGenerated(0),
+	m_GenerationStart(0),
+	m_LastReportTime(0),
 	m_Generator(NULL),
+	m_FinishGenCache(new cFinishGenCache),
 	m_PluginInterface(NULL),
 	m_ChunkSink(NULL)
 {
@@ -40,6 +47,7 @@ cChunkGenerator::cChunkGenerator(void) :
 cChunkGenerator::~cChunkGenerator()
 {
 	Stop();
+	delete m_FinishGenCache;
 }
 
 
@@ -50,33 +58,44 @@ bool cChunkGenerator::Start(cPluginInterface & a_PluginInterface, cChunkSink & a
 {
 	m_PluginInterface = &a_PluginInterface;
 	m_ChunkSink = &a_ChunkSink;
+	m_ShouldTerminate = false;
 
 	MTRand rnd;
 	m_Seed = a_IniFile.GetValueSetI("Seed", "Seed", rnd.randInt());
 	AString GeneratorName = a_IniFile.GetValueSet("Generator", "Generator", "Composable");
-
-	if (NoCaseCompare(GeneratorName, "Noise3D") == 0)
+	if ((NoCaseCompare(GeneratorName, "Noise3D") != 0) && (NoCaseCompare(GeneratorName, "composable") != 0))
 	{
-		m_Generator = new cNoise3DGenerator(*this);
-	}
-	else
-	{
-		if (NoCaseCompare(GeneratorName, "composable") != 0)
-		{
-			LOGWARN("[Generator]::Generator value \"%s\" not recognized, using \"Composable\".", GeneratorName.c_str());
-		}
-		m_Generator = new cComposableGenerator(*this);
+		LOGWARN("[Generator]::Generator value \"%s\" not recognized, using \"Composable\".", GeneratorName.c_str());
+		GeneratorName = "Composable";
 	}
 
+	m_FinishGenCache->Initialize(a_IniFile);
+	m_Generator = CreateGenerator(GeneratorName, a_IniFile);
 	if (m_Generator == NULL)
 	{
 		LOGERROR("Generator could not start, aborting the server");
 		return false;
 	}
 
-	m_Generator->Initialize(a_IniFile);
-
-	return super::Start();
+	// Each worker gets its own generator engine, so that they don't share the per-engine caches:
+	int NumThreads = std::max(1, a_IniFile.GetValueSetI("Generator", "NumThreads", 2));
+	for (int i = 0; i < NumThreads; i++)
+	{
+		cGenerator * Generator = CreateGenerator(GeneratorName, a_IniFile);
+		if (Generator == NULL)
+		{
+			LOGERROR("Generator could not start, aborting the server");
+			return false;
+		}
+		cWorker * Worker = new cWorker(*this, Generator);
+		m_Workers.push_back(Worker);
+		if (!Worker->Start())
+		{
+			LOGERROR("Generator thread could not start, aborting the server");
+			return false;
+		}
+	}
+	return true;
 }
 
 
@@ -85,10 +104,18 @@ bool cChunkGenerator::Start(cPluginInterface & a_PluginInterface, cChunkSink & a
 
 void cChunkGenerator::Stop(void)
 {
-	m_ShouldTerminate = true;
+	{
+		cCSLock Lock(m_CS);
+		m_ShouldTerminate = true;
+	}
 	m_Event.Set();
 	m_evtRemoved.Set();  // Wake up anybody waiting for empty queue
-	Wait();
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->Wait();
+		delete *itr;
+	}
+	m_Workers.clear();
 
 	delete m_Generator;
 	m_Generator = NULL;
@@ -103,22 +130,28 @@ void cChunkGenerator::QueueGenerateChunk(int a_ChunkX, int a_ChunkY, int a_Chunk
 	{
 		cCSLock Lock(m_CS);
 
-		// Check if it is already in the queue:
-		for (cChunkCoordsList::iterator itr = m_Queue.begin(); itr != m_Queue.end(); ++itr)
+		// Check if it is already in the queue or being generated:
+		cChunkCoords Coords(a_ChunkX, a_ChunkY, a_ChunkZ);
+		if (!m_QueuedCoords.insert(Coords).second)
 		{
-			if ((itr->m_ChunkX == a_ChunkX) && (itr->m_ChunkY == a_ChunkY) && (itr->m_ChunkZ == a_ChunkZ))
-			{
-				// Already in the queue, bail out
-				return;
-			}
-		}  // for itr - m_Queue[]
+			// Already in the queue, bail out
+			return;
+		}
+		
+		if (m_QueuedCoords.size() == 1)
+		{
+			// The queue has been empty, restart the perf counters so that waiting for the queue is not counted into the total time:
+			m_NumChunksGenerated = 0;
+			m_GenerationStart = m_Timer.GetNowTime();
+			m_LastReportTime = m_GenerationStart;
+		}
 
 		// Add to queue, issue a warning if too many:
 		if (m_Queue.size() >= QUEUE_WARNING_LIMIT)
 		{
 			LOGWARN("WARNING: Adding chunk [%i, %i] to generation queue; Queue is too big! (" SIZE_T_FMT ")", a_ChunkX, a_ChunkZ, m_Queue.size());
 		}
-		m_Queue.push_back(cChunkCoords(a_ChunkX, a_ChunkY, a_ChunkZ));
+		m_Queue.push_back(Coords);
 	}
 
 	m_Event.Set();
@@ -130,6 +163,7 @@ void cChunkGenerator::QueueGenerateChunk(int a_ChunkX, int a_ChunkY, int a_Chunk
 
 void cChunkGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::BiomeMap & a_BiomeMap)
 {
+	cCSLock Lock(m_CSGenerator);
 	if (m_Generator != NULL)
 	{
 		m_Generator->GenerateBiomes(a_ChunkX, a_ChunkZ, a_BiomeMap);
@@ -143,7 +177,7 @@ void cChunkGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef::Biom
 void cChunkGenerator::WaitForQueueEmpty(void)
 {
 	cCSLock Lock(m_CS);
-	while (!m_ShouldTerminate && !m_Queue.empty())
+	while (!m_ShouldTerminate && !m_QueuedCoords.empty())
 	{
 		cCSUnlock Unlock(Lock);
 		m_evtRemoved.Wait();
@@ -157,7 +191,7 @@ void cChunkGenerator::WaitForQueueEmpty(void)
 int cChunkGenerator::GetQueueLength(void)
 {
 	cCSLock Lock(m_CS);
-	return (int)m_Queue.size();
+	return (int)m_QueuedCoords.size();
 }
 
 
@@ -166,6 +200,7 @@ int cChunkGenerator::GetQueueLength(void)
 
 EMCSBiome cChunkGenerator::GetBiomeAt(int a_BlockX, int a_BlockZ)
 {
+	cCSLock Lock(m_CSGenerator);
 	ASSERT(m_Generator != NULL);
 	return m_Generator->GetBiomeAt(a_BlockX, a_BlockZ);
 }
@@ -190,92 +225,138 @@ BLOCKTYPE cChunkGenerator::GetIniBlock(cIniFile & a_IniFile, const AString & a_S
 
 
 
-void cChunkGenerator::Execute(void)
+cChunkGenerator::cGenerator * cChunkGenerator::CreateGenerator(const AString & a_GeneratorName, cIniFile & a_IniFile)
+{
+	cGenerator * Generator;
+	if (NoCaseCompare(a_GeneratorName, "Noise3D") == 0)
+	{
+		Generator = new cNoise3DGenerator(*this);
+	}
+	else
+	{
+		Generator = new cComposableGenerator(*this);
+	}
+	Generator->Initialize(a_IniFile);
+	return Generator;
+}
+
+
+
+
+
+bool cChunkGenerator::GetNextChunk(cChunkCoords & a_Coords, bool & a_SkipEnabled)
 {
-	// To be able to display performance information, the generator counts the chunks generated.
-	// When the queue gets empty, the count is reset, so that waiting for the queue is not counted into the total time.
-	int NumChunksGenerated = 0;  // Number of chunks generated since the queue was last empty
-	clock_t GenerationStart = clock();  // Clock tick when the queue started to fill
-	clock_t LastReportTick = clock();  // Clock tick of the last report made (so that performance isn't reported too often)
+	UpdatePlayerChunks();
 
-	while (!m_ShouldTerminate)
+	cCSLock Lock(m_CS);
+	while (m_Queue.empty() && !m_ShouldTerminate)
 	{
-		cCSLock Lock(m_CS);
-		while (m_Queue.empty())
+		cCSUnlock Unlock(Lock);
+		m_Event.Wait();
+	}
+	if (m_ShouldTerminate)
+	{
+		// Pass the termination request on to the next worker:
+		m_Event.Set();
+		return false;
+	}
+
+	// Pick the queued chunk closest to any player; if there are no players, keep the queue order:
+	cChunkCoordsList::iterator Best = m_Queue.begin();
+	if (!m_PlayerChunks.empty())
+	{
+		int BestDistance = std::numeric_limits<int>::max();
+		for (cChunkCoordsList::iterator itr = m_Queue.begin(), end = m_Queue.end(); itr != end; ++itr)
 		{
-			if ((NumChunksGenerated > 16) && (clock() - LastReportTick > CLOCKS_PER_SEC))
-			{
-				LOG("Chunk generator performance: %.2f ch/s (%d ch total)",
-					(double)NumChunksGenerated * CLOCKS_PER_SEC/ (clock() - GenerationStart),
-					NumChunksGenerated
-				);
-			}
-			cCSUnlock Unlock(Lock);
-			m_Event.Wait();
-			if (m_ShouldTerminate)
+			for (cChunkCoordsVector::const_iterator itrP = m_PlayerChunks.begin(), endP = m_PlayerChunks.end(); itrP != endP; ++itrP)
 			{
-				return;
+				int DiffX = itr->m_ChunkX - itrP->m_ChunkX;
+				int DiffZ = itr->m_ChunkZ - itrP->m_ChunkZ;
+				int Distance = DiffX * DiffX + DiffZ * DiffZ;
+				if (Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					Best = itr;
+				}
 			}
-			NumChunksGenerated = 0;
-			GenerationStart = clock();
-			LastReportTick = clock();
 		}
+	}
+	a_Coords = *Best;
+	m_Queue.erase(Best);
+	a_SkipEnabled = (m_Queue.size() > QUEUE_SKIP_LIMIT);
+	if (!m_Queue.empty())
+	{
+		// More work available, make sure another worker wakes up for it:
+		m_Event.Set();
+	}
+	return true;
+}
+
+
+
 
-		if (m_Queue.empty())
+
+void cChunkGenerator::ChunkFinished(const cChunkCoords & a_Coords, bool a_HasGenerated)
+{
+	{
+		cCSLock Lock(m_CS);
+		m_QueuedCoords.erase(a_Coords);
+		if (a_HasGenerated)
 		{
-			// Sometimes the queue remains empty
-			// If so, we can't do any front() operations on it!
-			continue;
+			m_NumChunksGenerated += 1;
 		}
 
-		cChunkCoords coords = m_Queue.front();		// Get next coord from queue
-		m_Queue.erase( m_Queue.begin() );	// Remove coordinate from queue
-		bool SkipEnabled = (m_Queue.size() > QUEUE_SKIP_LIMIT);
-		Lock.Unlock();			// Unlock ASAP
-		m_evtRemoved.Set();
-
-		// Display perf info once in a while:
-		if ((NumChunksGenerated > 16) && (clock() - LastReportTick > 2 * CLOCKS_PER_SEC))
+		// Display perf info once in a while, and when the queue gets empty:
+		Int64 Now = m_Timer.GetNowTime();
+		if ((m_NumChunksGenerated > 16) && (m_QueuedCoords.empty() || (Now - m_LastReportTime > 2000)))
 		{
+			Int64 Duration = std::max<Int64>(1, Now - m_GenerationStart);
 			LOG("Chunk generator performance: %.2f ch/s (%d ch total)",
-				(double)NumChunksGenerated * CLOCKS_PER_SEC / (clock() - GenerationStart),
-				NumChunksGenerated
+				(double)m_NumChunksGenerated * 1000 / Duration,
+				m_NumChunksGenerated
 			);
-			LastReportTick = clock();
+			m_FinishGenCache->LogStats();
+			m_LastReportTime = Now;
 		}
+	}
+	m_evtRemoved.Set();
+}
+
 
-		// Hack for regenerating chunks: if Y != 0, the chunk is considered invalid, even if it has its data set
-		if ((coords.m_ChunkY == 0) && m_ChunkSink->IsChunkValid(coords.m_ChunkX, coords.m_ChunkZ))
-		{
-			LOGD("Chunk [%d, %d] already generated, skipping generation", coords.m_ChunkX, coords.m_ChunkZ);
-			// Already generated, ignore request
-			continue;
-		}
 
-		if (SkipEnabled && !m_ChunkSink->HasChunkAnyClients(coords.m_ChunkX, coords.m_ChunkZ))
+
+
+void cChunkGenerator::UpdatePlayerChunks(void)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (m_Timer.GetNowTime() - m_LastPlayerChunksUpdate < 1000)
 		{
-			LOGWARNING("Chunk generator overloaded, skipping chunk [%d, %d]", coords.m_ChunkX, coords.m_ChunkZ);
-			continue;
+			return;
 		}
+		m_LastPlayerChunksUpdate = m_Timer.GetNowTime();
+	}
 
-		LOGD("Generating chunk [%d, %d, %d]", coords.m_ChunkX, coords.m_ChunkY, coords.m_ChunkZ);
-		DoGenerate(coords.m_ChunkX, coords.m_ChunkY, coords.m_ChunkZ);
+	// Query the sink without holding m_CS, the sink may need to lock the world, which may in turn be queueing chunks here:
+	cChunkCoordsVector PlayerChunks;
+	m_ChunkSink->GetPlayerChunks(PlayerChunks);
 
-		NumChunksGenerated++;
-	}  // while (!bStop)
+	cCSLock Lock(m_CS);
+	std::swap(m_PlayerChunks, PlayerChunks);
 }
 
 
 
 
-void cChunkGenerator::DoGenerate(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
+
+void cChunkGenerator::DoGenerate(cGenerator & a_Generator, int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
 	ASSERT(m_PluginInterface != NULL);
 	ASSERT(m_ChunkSink != NULL);
 	
 	cChunkDesc ChunkDesc(a_ChunkX, a_ChunkZ);
 	m_PluginInterface->CallHookChunkGenerating(ChunkDesc);
-	m_Generator->DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
+	a_Generator.DoGenerate(a_ChunkX, a_ChunkZ, ChunkDesc);
 	m_PluginInterface->CallHookChunkGenerated(ChunkDesc);
 
 	#ifdef _DEBUG
@@ -290,6 +371,61 @@ void cChunkGenerator::DoGenerate(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkGenerator::cWorker:
+
+cChunkGenerator::cWorker::cWorker(cChunkGenerator & a_Parent, cGenerator * a_Generator) :
+	super("cChunkGenerator::cWorker"),
+	m_Parent(a_Parent),
+	m_Generator(a_Generator)
+{
+}
+
+
+
+
+
+cChunkGenerator::cWorker::~cWorker()
+{
+	delete m_Generator;
+}
+
+
+
+
+
+void cChunkGenerator::cWorker::Execute(void)
+{
+	cChunkCoords Coords(0, 0, 0);
+	bool SkipEnabled;
+	while (m_Parent.GetNextChunk(Coords, SkipEnabled))
+	{
+		// Hack for regenerating chunks: if Y != 0, the chunk is considered invalid, even if it has its data set
+		if ((Coords.m_ChunkY == 0) && m_Parent.m_ChunkSink->IsChunkValid(Coords.m_ChunkX, Coords.m_ChunkZ))
+		{
+			LOGD("Chunk [%d, %d] already generated, skipping generation", Coords.m_ChunkX, Coords.m_ChunkZ);
+			// Already generated, ignore request
+			m_Parent.ChunkFinished(Coords, false);
+			continue;
+		}
+
+		if (SkipEnabled && !m_Parent.m_ChunkSink->HasChunkAnyClients(Coords.m_ChunkX, Coords.m_ChunkZ))
+		{
+			LOGWARNING("Chunk generator overloaded, skipping chunk [%d, %d]", Coords.m_ChunkX, Coords.m_ChunkZ);
+			m_Parent.ChunkFinished(Coords, false);
+			continue;
+		}
+
+		LOGD("Generating chunk [%d, %d, %d]", Coords.m_ChunkX, Coords.m_ChunkY, Coords.m_ChunkZ);
+		m_Parent.DoGenerate(*m_Generator, Coords.m_ChunkX, Coords.m_ChunkY, Coords.m_ChunkZ);
+		m_Parent.ChunkFinished(Coords, true);
+	}
+}
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cChunkGenerator::cGenerator:
 
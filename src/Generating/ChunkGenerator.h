@@ -4,11 +4,13 @@
 // Interfaces to the cChunkGenerator class representing the thread that generates chunks
 
 /*
-The object takes requests for generating chunks and processes them in a separate thread one by one.
-The requests are not added to the queue if there is already a request with the same coords
-Before generating, the thread checks if the chunk hasn't been already generated.
-It is theoretically possible to have multiple generator threads by having multiple instances of this object,
-but then it MAY happen that the chunk is generated twice.
+The object takes requests for generating chunks and processes them in a pool of worker threads.
+Each worker has its own instance of the generator engine, so that the workers don't need to share the per-engine caches;
+the data that the finishers compute about the neighbouring chunks is shared by all the engines through cFinishGenCache.
+The requests are not added to the queue if there is already a request with the same coords queued or being generated,
+this is checked using a set of the coords (m_QueuedCoords) instead of walking the queue.
+The workers take the queued chunk closest to any player first, so that the players see the terrain around them ASAP.
+Before generating, the worker checks if the chunk hasn't been already generated.
 If the generator queue is overloaded, the generator skips chunks with no clients in them
 */
 
@@ -20,6 +22,7 @@ If the generator queue is overloaded, the generator skips chunks with no clients
 
 #include "../OSSupport/IsThread.h"
 #include "../ChunkDef.h"
+#include "../OSSupport/Timer.h"
 
 
 
@@ -28,16 +31,14 @@ If the generator queue is overloaded, the generator skips chunks with no clients
 // fwd:
 class cIniFile;
 class cChunkDesc;
+class cFinishGenCache;
 
 
 
 
 
-class cChunkGenerator :
-	cIsThread
+class cChunkGenerator
 {
-	typedef cIsThread super;
-	
 public:
 	/** The interface that a class has to implement to become a generator */
 	class cGenerator
@@ -106,6 +107,11 @@ public:
 		If this callback returns false, the chunk is not generated.
 		*/
 		virtual bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) = 0;
+		
+		/** Called periodically to fill a_Coords with the coords of the chunks where the players are.
+		The generator then generates the queued chunks closest to the players first.
+		*/
+		virtual void GetPlayerChunks(cChunkCoordsVector & a_Coords) = 0;
 	} ;
 	
 
@@ -123,10 +129,17 @@ public:
 	
 	void WaitForQueueEmpty(void);
 	
+	/** Returns the number of chunks queued for generation, including those being generated right now */
 	int GetQueueLength(void);
 	
+	/** Returns the number of the worker threads */
+	int GetNumThreads(void) const { return (int)m_Workers.size(); }
+	
 	int GetSeed(void) const { return m_Seed; }
 	
+	/** Returns the cache of the neighbour terrain and structures, shared by the generator engines of all the workers */
+	cFinishGenCache & GetFinishGenCache(void) { return *m_FinishGenCache; }
+	
 	/// Returns the biome at the specified coords. Used by ChunkMap if an invalid chunk is queried for biome
 	EMCSBiome GetBiomeAt(int a_BlockX, int a_BlockZ);
 
@@ -135,14 +148,71 @@ public:
 	
 private:
 
+	/** A single worker thread, generating the chunks from the parent's queue using its own generator engine */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+		
+	public:
+		/** Creates the worker; takes ownership of a_Generator */
+		cWorker(cChunkGenerator & a_Parent, cGenerator * a_Generator);
+		virtual ~cWorker();
+		
+	protected:
+		cChunkGenerator & m_Parent;
+		
+		/** The generator engine used by this worker; owned */
+		cGenerator * m_Generator;
+		
+		// cIsThread override:
+		virtual void Execute(void) override;
+	} ;
+	
+	typedef std::vector<cWorker *> cWorkers;
+	
+	
 	int m_Seed;
 
 	cCriticalSection m_CS;
 	cChunkCoordsList m_Queue;
-	cEvent           m_Event;       ///< Set when an item is added to the queue or the thread should terminate
+	cEvent           m_Event;       ///< Set when an item is added to the queue or the workers should terminate
 	cEvent           m_evtRemoved;  ///< Set when an item is removed from the queue
 	
-	cGenerator * m_Generator;  ///< The actual generator engine used to generate chunks
+	/** Coords of all the chunks that are either in m_Queue or being generated right now, for fast duplicate checks. Protected by m_CS */
+	cChunkCoordsSet m_QueuedCoords;
+	
+	/** Coords of the chunks where the players were, when last queried through the chunk sink. Protected by m_CS */
+	cChunkCoordsVector m_PlayerChunks;
+	
+	/** Time (cTimer msec) when m_PlayerChunks was last updated. Protected by m_CS */
+	Int64 m_LastPlayerChunksUpdate;
+	
+	/** Set when the workers should terminate. Protected by m_CS */
+	bool m_ShouldTerminate;
+	
+	/** Number of chunks generated since the queue was last empty, for the performance reports. Protected by m_CS */
+	int m_NumChunksGenerated;
+	
+	/** Time (cTimer msec) when the queue started to fill, for the performance reports. Protected by m_CS */
+	Int64 m_GenerationStart;
+	
+	/** Time (cTimer msec) of the last performance report made, so that performance isn't reported too often. Protected by m_CS */
+	Int64 m_LastReportTime;
+	
+	/** Provides the current time for all the above timestamps */
+	cTimer m_Timer;
+	
+	cWorkers m_Workers;
+	
+	/** The generator engine used for the GenerateBiomes() and GetBiomeAt() requests coming from outside the workers */
+	cGenerator * m_Generator;
+	
+	/** Protects m_Generator, since the requests for it come from multiple threads */
+	cCriticalSection m_CSGenerator;
+	
+	/** The cache shared by the finishers of all the generator engines; thread-safe on its own */
+	cFinishGenCache * m_FinishGenCache;
 	
 	/** The plugin interface that may modify the generated chunks */
 	cPluginInterface * m_PluginInterface;
@@ -150,13 +220,20 @@ private:
 	/** The destination where the generated chunks are sent */
 	cChunkSink * m_ChunkSink;
 	
-
-	// cIsThread override:
-	virtual void Execute(void) override;
-
-	void DoGenerate(int a_ChunkX, int a_ChunkY, int a_ChunkZ);
+	
+	/** Creates and initializes a new generator engine of the specified name. */
+	cGenerator * CreateGenerator(const AString & a_GeneratorName, cIniFile & a_IniFile);
+	
+	/** Waits for the next chunk to generate and returns its coords in a_Coords.
+	Returns false if the workers should terminate. Called from within the worker threads. */
+	bool GetNextChunk(cChunkCoords & a_Coords, bool & a_SkipEnabled);
+	
+	/** Removes the chunk from m_QueuedCoords once it has been generated or skipped, and updates the perf counters. Called from within the worker threads. */
+	void ChunkFinished(const cChunkCoords & a_Coords, bool a_HasGenerated);
+	
+	/** Updates m_PlayerChunks through the chunk sink, if they haven't been updated for a while. Called from within the worker threads. */
+	void UpdatePlayerChunks(void);
+	
+	/** Generates the specified chunk using the specified generator engine and hands it over to the chunk sink */
+	void DoGenerate(cGenerator & a_Generator, int a_ChunkX, int a_ChunkY, int a_ChunkZ);
 };
-
-
-
-
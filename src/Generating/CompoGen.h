@@ -17,6 +17,7 @@
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "ChunkCacheIndex.h"
 #include "../Noise.h"
 
 
@@ -144,7 +145,7 @@ protected:
 
 
 
-/// Caches most-recently-used chunk composition of another composition generator. Caches only the types and metas
+/// Caches recently used chunk composition of another composition generator. Caches only the types and metas
 class cCompoGenCache :
 	public cTerrainCompositionGen
 {
@@ -162,21 +163,18 @@ protected:
 	
 	struct sCacheData
 	{
-		int m_ChunkX;
-		int m_ChunkZ;
 		cChunkDef::BlockTypes        m_BlockTypes;
 		cChunkDesc::BlockNibbleBytes m_BlockMetas;  // The metas are uncompressed, 1 meta per byte
 	} ;
 	
-	// To avoid moving large amounts of data for the MRU behavior, we MRU-ize indices to an array of the actual data
-	int          m_CacheSize;
-	int *        m_CacheOrder;  // MRU-ized order, indices into m_CacheData array
-	sCacheData * m_CacheData;   // m_CacheData[m_CacheOrder[0]] is the most recently used
+	/** Protects m_Index and m_CacheData, the cache may be queried from multiple generator threads */
+	cCriticalSection m_CS;
 	
-	// Cache statistics
-	int m_NumHits;
-	int m_NumMisses;
-	int m_TotalChain;  // Number of cache items walked to get to a hit (only added for hits)
+	/** Decides which item of m_CacheData holds which chunk; the lookups cost the same regardless of the cache size */
+	cChunkCacheIndex m_Index;
+	
+	/** The cached data, m_Index.GetSize() items, indexed by the slot numbers returned by m_Index */
+	sCacheData * m_CacheData;
 } ;
 
 
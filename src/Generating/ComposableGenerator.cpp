@@ -16,6 +16,7 @@
 #include "CompoGen.h"
 #include "StructGen.h"
 #include "FinishGen.h"
+#include "FinishGenCache.h"
 
 #include "Caves.h"
 #include "DistortedHeightmap.h"
@@ -182,22 +183,42 @@ void cComposableGenerator::GenerateBiomes(int a_ChunkX, int a_ChunkZ, cChunkDef:
 
 void cComposableGenerator::DoGenerate(int a_ChunkX, int a_ChunkZ, cChunkDesc & a_ChunkDesc)
 {
-	if (a_ChunkDesc.IsUsingDefaultBiomes())
-	{
-		m_BiomeGen->GenBiomes(a_ChunkX, a_ChunkZ, a_ChunkDesc.GetBiomeMap());
-	}
-	
-	if (a_ChunkDesc.IsUsingDefaultHeight())
-	{
-		m_HeightGen->GenHeightMap(a_ChunkX, a_ChunkZ, a_ChunkDesc.GetHeightMap());
-	}
+	// If the terrain is fully up to us, it may have been composed already for a neighbour's finisher, possibly in another thread:
+	bool IsDefaultTerrain = (
+		a_ChunkDesc.IsUsingDefaultBiomes() &&
+		a_ChunkDesc.IsUsingDefaultHeight() &&
+		a_ChunkDesc.IsUsingDefaultComposition()
+	);
+	cFinishGenCache & Cache = m_ChunkGenerator.GetFinishGenCache();
 	
 	bool ShouldUpdateHeightmap = false;
-	if (a_ChunkDesc.IsUsingDefaultComposition())
+	if (IsDefaultTerrain && Cache.GetTerrain(a_ChunkX, a_ChunkZ, a_ChunkDesc))
 	{
-		m_CompositionGen->ComposeTerrain(a_ChunkDesc);
 		ShouldUpdateHeightmap = true;
 	}
+	else
+	{
+		if (a_ChunkDesc.IsUsingDefaultBiomes())
+		{
+			m_BiomeGen->GenBiomes(a_ChunkX, a_ChunkZ, a_ChunkDesc.GetBiomeMap());
+		}
+		
+		if (a_ChunkDesc.IsUsingDefaultHeight())
+		{
+			m_HeightGen->GenHeightMap(a_ChunkX, a_ChunkZ, a_ChunkDesc.GetHeightMap());
+		}
+		
+		if (a_ChunkDesc.IsUsingDefaultComposition())
+		{
+			m_CompositionGen->ComposeTerrain(a_ChunkDesc);
+			ShouldUpdateHeightmap = true;
+		}
+		
+		if (IsDefaultTerrain)
+		{
+			Cache.PutTerrain(a_ChunkDesc);
+		}
+	}
 
 	if (a_ChunkDesc.IsUsingDefaultFinish())
 	{
@@ -274,11 +295,11 @@ void cComposableGenerator::InitCompositionGen(cIniFile & a_IniFile)
 {
 	m_CompositionGen = cTerrainCompositionGen::CreateCompositionGen(a_IniFile, *m_BiomeGen, *m_HeightGen, m_ChunkGenerator.GetSeed());
 	
-	int CompoGenCacheSize = a_IniFile.GetValueSetI("Generator", "CompositionGenCacheSize", 64);
+	int CompoGenCacheSize = a_IniFile.GetValueSetI("Generator", "CompositionGenCacheSize", 32);
 	if (CompoGenCacheSize > 1)
 	{
 		m_UnderlyingCompositionGen = m_CompositionGen;
-		m_CompositionGen = new cCompoGenCache(*m_UnderlyingCompositionGen, 32);
+		m_CompositionGen = new cCompoGenCache(*m_UnderlyingCompositionGen, CompoGenCacheSize);
 	}
 }
 
@@ -359,7 +380,8 @@ void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 			int ChanceStaircase = a_IniFile.GetValueSetI("Generator", "MineShaftsChanceStaircase", 200);
 			m_FinishGens.push_back(new cStructGenMineShafts(
 				Seed, GridSize, MaxSystemSize,
-				ChanceCorridor, ChanceCrossing, ChanceStaircase
+				ChanceCorridor, ChanceCrossing, ChanceStaircase,
+				m_ChunkGenerator.GetFinishGenCache()
 			));
 		}
 		else if (NoCaseCompare(*itr, "Lilypads") == 0)
@@ -402,7 +424,7 @@ void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 		}
 		else if (NoCaseCompare(*itr, "Trees") == 0)
 		{
-			m_FinishGens.push_back(new cStructGenTrees(Seed, m_BiomeGen, m_HeightGen, m_CompositionGen));
+			m_FinishGens.push_back(new cStructGenTrees(Seed, m_BiomeGen, m_HeightGen, m_CompositionGen, m_ChunkGenerator.GetFinishGenCache()));
 		}
 		else if (NoCaseCompare(*itr, "WaterLakes") == 0)
 		{
@@ -415,7 +437,7 @@ void cComposableGenerator::InitFinishGens(cIniFile & a_IniFile)
 		}
 		else if (NoCaseCompare(*itr, "WormNestCaves") == 0)
 		{
-			m_FinishGens.push_back(new cStructGenWormNestCaves(Seed));
+			m_FinishGens.push_back(new cStructGenWormNestCaves(Seed, m_ChunkGenerator.GetFinishGenCache()));
 		}
 		else
 		{
@@ -0,0 +1,278 @@
+
+// FinishGenCache.cpp
+
+// Implements the cFinishGenCache class representing the cache of neighbour terrain and structures, shared by the finishers of all generator threads
+
+#include "Globals.h"
+#include "FinishGenCache.h"
+#include "ChunkDesc.h"
+#include "inifile/iniFile.h"
+
+
+
+
+
+/** The composed terrain of a single chunk, as stored in the cache */
+class cFinishGenCache::cTerrain :
+	public cFinishGenCache::cStructure
+{
+public:
+	cChunkDef::BiomeMap          m_BiomeMap;
+	cChunkDef::HeightMap         m_HeightMap;
+	cChunkDef::BlockTypes        m_BlockTypes;
+	cChunkDesc::BlockNibbleBytes m_BlockMetas;  // The metas are uncompressed, 1 meta per byte
+} ;
+
+
+
+
+
+cFinishGenCache::cFinishGenCache(void)
+{
+	for (int i = 0; i < kindMax; i++)
+	{
+		m_Kinds[i].m_MaxSize = 0;
+		m_Kinds[i].m_NumHits = 0;
+		m_Kinds[i].m_NumMisses = 0;
+	}
+}
+
+
+
+
+
+cFinishGenCache::~cFinishGenCache()
+{
+	cCSLock Lock(m_CS);
+	for (int i = 0; i < kindMax; i++)
+	{
+		m_Kinds[i].m_MaxSize = 0;
+		Trim(m_Kinds[i]);
+	}
+}
+
+
+
+
+
+void cFinishGenCache::Initialize(cIniFile & a_IniFile)
+{
+	// A composed terrain takes about 130 KiB, the structures are much smaller:
+	cCSLock Lock(m_CS);
+	m_Kinds[kindTerrain].m_MaxSize       = std::max(0, a_IniFile.GetValueSetI("Generator", "NeighborTerrainCacheSize", 64));
+	m_Kinds[kindTreeOverflow].m_MaxSize  = std::max(0, a_IniFile.GetValueSetI("Generator", "TreeOverflowCacheSize",    1024));
+	m_Kinds[kindWormNestCaves].m_MaxSize = std::max(0, a_IniFile.GetValueSetI("Generator", "WormNestCavesCacheSize",   256));
+	m_Kinds[kindMineShafts].m_MaxSize    = std::max(0, a_IniFile.GetValueSetI("Generator", "MineShaftsCacheSize",      256));
+	for (int i = 0; i < kindMax; i++)
+	{
+		Trim(m_Kinds[i]);
+	}
+}
+
+
+
+
+
+bool cFinishGenCache::GetTerrain(int a_ChunkX, int a_ChunkZ, cChunkDesc & a_ChunkDesc)
+{
+	cStructure * Item = Get(kindTerrain, a_ChunkX, a_ChunkZ);
+	if (Item == NULL)
+	{
+		return false;
+	}
+	
+	// The item is immutable and we hold a reference, so it can be copied outside the lock:
+	const cTerrain * Terrain = static_cast<const cTerrain *>(Item);
+	memcpy(a_ChunkDesc.GetBiomeMap(),               Terrain->m_BiomeMap,   sizeof(Terrain->m_BiomeMap));
+	memcpy(a_ChunkDesc.GetHeightMap(),              Terrain->m_HeightMap,  sizeof(Terrain->m_HeightMap));
+	memcpy(a_ChunkDesc.GetBlockTypes(),             Terrain->m_BlockTypes, sizeof(Terrain->m_BlockTypes));
+	memcpy(a_ChunkDesc.GetBlockMetasUncompressed(), Terrain->m_BlockMetas, sizeof(Terrain->m_BlockMetas));
+	Release(Item);
+	return true;
+}
+
+
+
+
+
+void cFinishGenCache::PutTerrain(cChunkDesc & a_ChunkDesc)
+{
+	{
+		cCSLock Lock(m_CS);
+		if (m_Kinds[kindTerrain].m_MaxSize == 0)
+		{
+			// Disabled, don't bother copying the data
+			return;
+		}
+	}
+	cTerrain * Terrain = new cTerrain;
+	memcpy(Terrain->m_BiomeMap,   a_ChunkDesc.GetBiomeMap(),               sizeof(Terrain->m_BiomeMap));
+	memcpy(Terrain->m_HeightMap,  a_ChunkDesc.GetHeightMap(),              sizeof(Terrain->m_HeightMap));
+	memcpy(Terrain->m_BlockTypes, a_ChunkDesc.GetBlockTypes(),             sizeof(Terrain->m_BlockTypes));
+	memcpy(Terrain->m_BlockMetas, a_ChunkDesc.GetBlockMetasUncompressed(), sizeof(Terrain->m_BlockMetas));
+	Release(Put(kindTerrain, a_ChunkDesc.GetChunkX(), a_ChunkDesc.GetChunkZ(), Terrain));
+}
+
+
+
+
+
+cFinishGenCache::cStructure * cFinishGenCache::Get(eKind a_Kind, int a_X, int a_Z)
+{
+	ASSERT((a_Kind >= 0) && (a_Kind < kindMax));
+	cCSLock Lock(m_CS);
+	sKind & Kind = m_Kinds[a_Kind];
+	cEntryMap::iterator itr = Kind.m_Entries.find(cCoords(a_X, a_Z));
+	if (itr == Kind.m_Entries.end())
+	{
+		Kind.m_NumMisses += 1;
+		return NULL;
+	}
+	Kind.m_NumHits += 1;
+	
+	// Move to the front of the LRU list:
+	Kind.m_LRU.splice(Kind.m_LRU.begin(), Kind.m_LRU, itr->second.m_LRUPos);
+	
+	itr->second.m_Item->m_RefCount += 1;
+	return itr->second.m_Item;
+}
+
+
+
+
+
+cFinishGenCache::cStructure * cFinishGenCache::Put(eKind a_Kind, int a_X, int a_Z, cStructure * a_Item)
+{
+	ASSERT((a_Kind >= 0) && (a_Kind < kindMax));
+	ASSERT(a_Item != NULL);
+	cCSLock Lock(m_CS);
+	sKind & Kind = m_Kinds[a_Kind];
+	if (Kind.m_MaxSize == 0)
+	{
+		// Caching this kind is disabled, the caller keeps the only reference
+		return a_Item;
+	}
+	
+	cCoords Coords(a_X, a_Z);
+	cEntryMap::iterator itr = Kind.m_Entries.find(Coords);
+	if (itr != Kind.m_Entries.end())
+	{
+		// Another thread has been faster, use its item so that all the threads share the same one:
+		ReleaseLocked(a_Item);
+		itr->second.m_Item->m_RefCount += 1;
+		return itr->second.m_Item;
+	}
+	
+	// Store the item, with a reference for the cache:
+	Kind.m_LRU.push_front(Coords);
+	sEntry Entry;
+	Entry.m_Item = a_Item;
+	Entry.m_LRUPos = Kind.m_LRU.begin();
+	Kind.m_Entries[Coords] = Entry;
+	a_Item->m_RefCount += 1;
+	Trim(Kind);
+	return a_Item;
+}
+
+
+
+
+
+void cFinishGenCache::Release(cStructure * a_Item)
+{
+	cCSLock Lock(m_CS);
+	ReleaseLocked(a_Item);
+}
+
+
+
+
+
+void cFinishGenCache::LogStats(void)
+{
+	AString Stats;
+	cCSLock Lock(m_CS);
+	for (int i = 0; i < kindMax; i++)
+	{
+		sKind & Kind = m_Kinds[i];
+		int NumLookups = Kind.m_NumHits + Kind.m_NumMisses;
+		if ((Kind.m_MaxSize == 0) || (NumLookups == 0))
+		{
+			continue;
+		}
+		AppendPrintf(Stats, "%s%s %.1f %% of %d",
+			Stats.empty() ? "" : ", ",
+			GetKindName((eKind)i), 100.0 * Kind.m_NumHits / NumLookups, NumLookups
+		);
+		Kind.m_NumHits = 0;
+		Kind.m_NumMisses = 0;
+	}
+	if (!Stats.empty())
+	{
+		LOG("Generator cache hit rates: %s", Stats.c_str());
+	}
+}
+
+
+
+
+
+void cFinishGenCache::GetStats(eKind a_Kind, int & a_NumHits, int & a_NumMisses)
+{
+	ASSERT((a_Kind >= 0) && (a_Kind < kindMax));
+	cCSLock Lock(m_CS);
+	a_NumHits = m_Kinds[a_Kind].m_NumHits;
+	a_NumMisses = m_Kinds[a_Kind].m_NumMisses;
+}
+
+
+
+
+
+const char * cFinishGenCache::GetKindName(eKind a_Kind)
+{
+	switch (a_Kind)
+	{
+		case kindTerrain:       return "terrain";
+		case kindTreeOverflow:  return "trees";
+		case kindWormNestCaves: return "caves";
+		case kindMineShafts:    return "mineshafts";
+		case kindMax:           break;
+	}
+	ASSERT(!"Unknown cache kind");
+	return "<unknown>";
+}
+
+
+
+
+
+void cFinishGenCache::Trim(sKind & a_Kind)
+{
+	while ((int)a_Kind.m_Entries.size() > a_Kind.m_MaxSize)
+	{
+		cEntryMap::iterator itr = a_Kind.m_Entries.find(a_Kind.m_LRU.back());
+		ASSERT(itr != a_Kind.m_Entries.end());
+		ReleaseLocked(itr->second.m_Item);
+		a_Kind.m_Entries.erase(itr);
+		a_Kind.m_LRU.pop_back();
+	}
+}
+
+
+
+
+
+void cFinishGenCache::ReleaseLocked(cStructure * a_Item)
+{
+	ASSERT(a_Item->m_RefCount > 0);
+	a_Item->m_RefCount -= 1;
+	if (a_Item->m_RefCount == 0)
+	{
+		delete a_Item;
+	}
+}
+
+
+
+
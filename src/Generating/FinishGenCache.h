@@ -0,0 +1,142 @@
+
+// FinishGenCache.h
+
+// Declares the cFinishGenCache class representing the cache of neighbour terrain and structures, shared by the finishers of all generator threads
+
+/*
+Several finishers need data about the chunks around the one being generated: the trees need the composed terrain
+of all 8 neighbours to know which of their trees reach into the chunk; the worm nest caves and the mineshafts need the
+systems generated on a grid around the chunk. Computing all that for each chunk is expensive (the trees used to
+compose 9 chunks for every chunk generated), and it is the very same data for the neighbouring chunks, which may be
+generated by different generator threads.
+This cache keeps the data for all the generator engines (one per generator thread) of a single cChunkGenerator.
+Each item belongs to a kind and is keyed by coords within that kind (chunk coords, or the grid coords of the structure):
+	- the composed terrain of a chunk (biomes, heightmap, blocktypes and metas), before any finisher has been applied
+	- the structures created by the finishers, descendants of cStructure
+The items are reference-counted, so that an item may be evicted while another thread is still using it. An item must
+not be modified once it has been put into the cache. Each kind is evicted in the LRU order when it exceeds its size,
+the sizes are read from the [Generator] section; a size of 0 disables caching of that kind.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cChunkDesc;
+class cIniFile;
+
+
+
+
+
+class cFinishGenCache
+{
+public:
+	/** The kinds of the cached items */
+	enum eKind
+	{
+		kindTerrain = 0,   ///< The composed terrain of a chunk, before finishing
+		kindTreeOverflow,  ///< The parts of a chunk's trees that reach into the neighbouring chunks
+		kindWormNestCaves, ///< A single worm nest cave system
+		kindMineShafts,    ///< A single mineshaft system
+		kindMax,           ///< The number of the kinds, not a kind itself
+	} ;
+
+	/** An item that can be stored in the cache */
+	class cStructure
+	{
+	public:
+		cStructure(void) : m_RefCount(1) {}
+
+		// Force a virtual destructor in all descendants:
+		virtual ~cStructure() {}
+
+	protected:
+		friend class cFinishGenCache;
+
+		/** The number of the references: one for the cache, if stored, plus one for each user. Protected by the cache's m_CS. */
+		int m_RefCount;
+	} ;
+
+
+	cFinishGenCache(void);
+	~cFinishGenCache();
+
+	/** Reads the sizes of the kinds from the [Generator] section of the ini file */
+	void Initialize(cIniFile & a_IniFile);
+
+	/** If the composed terrain of the chunk is cached, copies it into a_ChunkDesc (biomes, heightmap, blocktypes and metas) and returns true */
+	bool GetTerrain(int a_ChunkX, int a_ChunkZ, cChunkDesc & a_ChunkDesc);
+
+	/** Stores the composed terrain of the chunk; to be called before any finisher is applied to a_ChunkDesc */
+	void PutTerrain(cChunkDesc & a_ChunkDesc);
+
+	/** Returns the item of the specified kind at the specified coords, with a reference added for the caller; NULL if not cached.
+	The caller must Release() the item when no longer needed. */
+	cStructure * Get(eKind a_Kind, int a_X, int a_Z);
+
+	/** Stores the item of the specified kind at the specified coords; takes over the caller's reference.
+	Returns the item now stored at the coords, with a reference added for the caller. If another thread has stored an item
+	there in the meantime, a_Item is released and the other item is returned, so that all the threads use the same one. */
+	cStructure * Put(eKind a_Kind, int a_X, int a_Z, cStructure * a_Item);
+
+	/** Releases the reference to the item returned by Get() or Put() */
+	void Release(cStructure * a_Item);
+
+	/** Logs the hit rates of all the enabled kinds, then resets the counters */
+	void LogStats(void);
+
+	/** Returns the number of the hits and misses of the specified kind since the last LogStats() */
+	void GetStats(eKind a_Kind, int & a_NumHits, int & a_NumMisses);
+
+	/** Returns the name of the kind, for logging */
+	static const char * GetKindName(eKind a_Kind);
+
+protected:
+	class cTerrain;  // fwd: FinishGenCache.cpp
+
+	typedef std::pair<int, int> cCoords;
+	typedef std::list<cCoords> cLRUList;
+
+	/** A single item stored in the cache */
+	struct sEntry
+	{
+		cStructure * m_Item;
+		cLRUList::iterator m_LRUPos;  ///< Position of the item's coords in the LRU list of its kind
+	} ;
+
+	typedef std::map<cCoords, sEntry> cEntryMap;
+
+	/** The items of a single kind */
+	struct sKind
+	{
+		cEntryMap m_Entries;
+		cLRUList m_LRU;  ///< The coords of the items, most recently used first
+		int m_MaxSize;
+		int m_NumHits;
+		int m_NumMisses;
+	} ;
+
+	/** Protects everything, including the refcounts of the items */
+	cCriticalSection m_CS;
+
+	sKind m_Kinds[kindMax];
+
+
+	/** Drops the least recently used items of the kind until there are at most its m_MaxSize left. Assumes m_CS is locked. */
+	void Trim(sKind & a_Kind);
+
+	/** Releases a reference to the item, deleting it once unused. Assumes m_CS is locked. */
+	void ReleaseLocked(cStructure * a_Item);
+} ;
+
+
+
+
@@ -116,19 +116,9 @@ void cHeiGenFlat::InitializeHeightGen(cIniFile & a_IniFile)
 
 cHeiGenCache::cHeiGenCache(cTerrainHeightGen & a_HeiGenToCache, int a_CacheSize) :
 	m_HeiGenToCache(a_HeiGenToCache),
-	m_CacheSize(a_CacheSize),
-	m_CacheOrder(new int[a_CacheSize]),
-	m_CacheData(new sCacheData[a_CacheSize]),
-	m_NumHits(0),
-	m_NumMisses(0),
-	m_TotalChain(0)
+	m_Index(a_CacheSize),
+	m_CacheData(new sCacheData[m_Index.GetSize()])
 {
-	for (int i = 0; i < m_CacheSize; i++)
-	{
-		m_CacheOrder[i] = i;
-		m_CacheData[i].m_ChunkX = 0x7fffffff;
-		m_CacheData[i].m_ChunkZ = 0x7fffffff;
-	}
 }
 
 
@@ -138,7 +128,6 @@ cHeiGenCache::cHeiGenCache(cTerrainHeightGen & a_HeiGenToCache, int a_CacheSize)
 cHeiGenCache::~cHeiGenCache()
 {
 	delete[] m_CacheData;
-	delete[] m_CacheOrder;
 }
 
 
@@ -147,55 +136,31 @@ cHeiGenCache::~cHeiGenCache()
 
 void cHeiGenCache::GenHeightMap(int a_ChunkX, int a_ChunkZ, cChunkDef::HeightMap & a_HeightMap)
 {
-	/*
-	if (((m_NumHits + m_NumMisses) % 1024) == 10)
-	{
-		LOGD("HeiGenCache: %d hits, %d misses, saved %.2f %%", m_NumHits, m_NumMisses, 100.0 * m_NumHits / (m_NumHits + m_NumMisses));
-		LOGD("HeiGenCache: Avg cache chain length: %.2f", (float)m_TotalChain / m_NumHits);
-	}
-	//*/
-	
-	for (int i = 0; i < m_CacheSize; i++)
 	{
-		if (
-			(m_CacheData[m_CacheOrder[i]].m_ChunkX != a_ChunkX) ||
-			(m_CacheData[m_CacheOrder[i]].m_ChunkZ != a_ChunkZ)
-		)
+		cCSLock Lock(m_CS);
+		/*
+		int NumQueries = m_Index.GetNumHits() + m_Index.GetNumMisses();
+		if ((NumQueries % 1024) == 10)
 		{
-			continue;
+			LOGD("HeiGenCache: %d hits, %d misses, saved %.2f %%", m_Index.GetNumHits(), m_Index.GetNumMisses(), 100.0 * m_Index.GetNumHits() / NumQueries);
 		}
-		// Found it in the cache
-		int Idx = m_CacheOrder[i];
+		//*/
 		
-		// Move to front:
-		for (int j = i; j > 0; j--)
+		int Idx = m_Index.Find(a_ChunkX, a_ChunkZ);
+		if (Idx >= 0)
 		{
-			m_CacheOrder[j] = m_CacheOrder[j - 1];
+			// Use the cached data:
+			memcpy(a_HeightMap, m_CacheData[Idx].m_HeightMap, sizeof(a_HeightMap));
+			return;
 		}
-		m_CacheOrder[0] = Idx;
-		
-		// Use the cached data:
-		memcpy(a_HeightMap, m_CacheData[Idx].m_HeightMap, sizeof(a_HeightMap));
-		
-		m_NumHits++;
-		m_TotalChain += i;
-		return;
-	}  // for i - cache
+	}
 	
-	// Not in the cache:
-	m_NumMisses++;
+	// Not in the cache, generate without holding the lock:
 	m_HeiGenToCache.GenHeightMap(a_ChunkX, a_ChunkZ, a_HeightMap);
 	
-	// Insert it as the first item in the MRU order:
-	int Idx = m_CacheOrder[m_CacheSize - 1];
-	for (int i = m_CacheSize - 1; i > 0; i--)
-	{
-		m_CacheOrder[i] = m_CacheOrder[i - 1];
-	}  // for i - m_CacheOrder[]
-	m_CacheOrder[0] = Idx;
+	cCSLock Lock(m_CS);
+	int Idx = m_Index.Assign(a_ChunkX, a_ChunkZ);
 	memcpy(m_CacheData[Idx].m_HeightMap, a_HeightMap, sizeof(a_HeightMap));
-	m_CacheData[Idx].m_ChunkX = a_ChunkX;
-	m_CacheData[Idx].m_ChunkZ = a_ChunkZ;
 }
 
 
@@ -213,15 +178,14 @@ void cHeiGenCache::InitializeHeightGen(cIniFile & a_IniFile)
 
 bool cHeiGenCache::GetHeightAt(int a_ChunkX, int a_ChunkZ, int a_RelX, int a_RelZ, HEIGHTTYPE & a_Height)
 {
-	for (int i = 0; i < m_CacheSize; i++)
+	cCSLock Lock(m_CS);
+	int Idx = m_Index.Find(a_ChunkX, a_ChunkZ);
+	if (Idx < 0)
 	{
-		if ((m_CacheData[i].m_ChunkX == a_ChunkX) && (m_CacheData[i].m_ChunkZ == a_ChunkZ))
-		{
-			a_Height = cChunkDef::GetHeight(m_CacheData[i].m_HeightMap, a_RelX, a_RelZ);
-			return true;
-		}
-	}  // for i - m_CacheData[]
-	return false;
+		return false;
+	}
+	a_Height = cChunkDef::GetHeight(m_CacheData[Idx].m_HeightMap, a_RelX, a_RelZ);
+	return true;
 }
 
 
@@ -234,7 +234,9 @@ protected:
 
 
 
-class cStructGenMineShafts::cMineShaftSystem
+/** A single mineshaft system; shared through the cFinishGenCache, read-only once created */
+class cStructGenMineShafts::cMineShaftSystem :
+	public cFinishGenCache::cStructure
 {
 public:
 	int         m_BlockX, m_BlockZ;    ///< The pivot point on which the system is generated
@@ -1285,14 +1287,16 @@ void cMineShaftStaircase::ProcessChunk(cChunkDesc & a_ChunkDesc)
 
 cStructGenMineShafts::cStructGenMineShafts(
 	int a_Seed, int a_GridSize, int a_MaxSystemSize,
-	int a_ChanceCorridor, int a_ChanceCrossing, int a_ChanceStaircase
+	int a_ChanceCorridor, int a_ChanceCrossing, int a_ChanceStaircase,
+	cFinishGenCache & a_Cache
 ) :
 	m_Noise(a_Seed),
 	m_GridSize(a_GridSize),
 	m_MaxSystemSize(a_MaxSystemSize),
 	m_ProbLevelCorridor(std::max(0, a_ChanceCorridor)),
 	m_ProbLevelCrossing(std::max(0, a_ChanceCorridor + a_ChanceCrossing)),
-	m_ProbLevelStaircase(std::max(0, a_ChanceCorridor + a_ChanceCrossing + a_ChanceStaircase))
+	m_ProbLevelStaircase(std::max(0, a_ChanceCorridor + a_ChanceCrossing + a_ChanceStaircase)),
+	m_Cache(a_Cache)
 {
 }
 
@@ -1300,28 +1304,6 @@ cStructGenMineShafts::cStructGenMineShafts(
 
 
 
-cStructGenMineShafts::~cStructGenMineShafts()
-{
-	ClearCache();
-}
-
-
-
-
-
-void cStructGenMineShafts::ClearCache(void)
-{
-	for (cMineShaftSystems::const_iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end; ++itr)
-	{
-		delete *itr;
-	}  // for itr - m_Cache[]
-	m_Cache.clear();
-}
-
-
-
-
-
 void cStructGenMineShafts::GetMineShaftSystemsForChunk(
 	int a_ChunkX, int a_ChunkZ,
 	cStructGenMineShafts::cMineShaftSystems & a_MineShafts
@@ -1340,68 +1322,23 @@ void cStructGenMineShafts::GetMineShaftSystemsForChunk(
 	BaseX -= NEIGHBORHOOD_SIZE / 2;
 	BaseZ -= NEIGHBORHOOD_SIZE / 2;
 
-	// Walk the cache, move each cave system that we want into a_Mineshafts:
-	int StartX = BaseX * m_GridSize;
-	int EndX = (BaseX + NEIGHBORHOOD_SIZE + 1) * m_GridSize;
-	int StartZ = BaseZ * m_GridSize;
-	int EndZ = (BaseZ + NEIGHBORHOOD_SIZE + 1) * m_GridSize;
-	for (cMineShaftSystems::iterator itr = m_Cache.begin(), end = m_Cache.end(); itr != end;)
-	{
-		if (
-			((*itr)->m_BlockX >= StartX) && ((*itr)->m_BlockX < EndX) &&
-			((*itr)->m_BlockZ >= StartZ) && ((*itr)->m_BlockZ < EndZ)
-		)
-		{
-			// want
-			a_MineShafts.push_back(*itr);
-			itr = m_Cache.erase(itr);
-		}
-		else
-		{
-			// don't want
-			++itr;
-		}
-	}  // for itr - m_Cache[]
-
 	for (int x = 0; x < NEIGHBORHOOD_SIZE; x++)
 	{
 		int RealX = (BaseX + x) * m_GridSize;
 		for (int z = 0; z < NEIGHBORHOOD_SIZE; z++)
 		{
 			int RealZ = (BaseZ + z) * m_GridSize;
-			bool Found = false;
-			for (cMineShaftSystems::const_iterator itr = a_MineShafts.begin(), end = a_MineShafts.end(); itr != end; ++itr)
+			cFinishGenCache::cStructure * MineShaft = m_Cache.Get(cFinishGenCache::kindMineShafts, RealX, RealZ);
+			if (MineShaft == NULL)
 			{
-				if (((*itr)->m_BlockX == RealX) && ((*itr)->m_BlockZ == RealZ))
-				{
-					Found = true;
-					break;
-				}
-			}  // for itr - a_Mineshafts
-			if (!Found)
-			{
-				a_MineShafts.push_back(new cMineShaftSystem(RealX, RealZ, m_GridSize, m_MaxSystemSize, m_Noise, m_ProbLevelCorridor, m_ProbLevelCrossing, m_ProbLevelStaircase));
+				MineShaft = m_Cache.Put(
+					cFinishGenCache::kindMineShafts, RealX, RealZ,
+					new cMineShaftSystem(RealX, RealZ, m_GridSize, m_MaxSystemSize, m_Noise, m_ProbLevelCorridor, m_ProbLevelCrossing, m_ProbLevelStaircase)
+				);
 			}
+			a_MineShafts.push_back(static_cast<cMineShaftSystem *>(MineShaft));
 		}  // for z
 	}  // for x
-
-	// Copy a_MineShafts into m_Cache to the beginning:
-	cMineShaftSystems MineShaftsCopy(a_MineShafts);
-	m_Cache.splice(m_Cache.begin(), MineShaftsCopy, MineShaftsCopy.begin(), MineShaftsCopy.end());
-
-	// Trim the cache if it's too long:
-	if (m_Cache.size() > 100)
-	{
-		cMineShaftSystems::iterator itr = m_Cache.begin();
-		std::advance(itr, 100);
-		for (cMineShaftSystems::iterator end = m_Cache.end(); itr != end; ++itr)
-		{
-			delete *itr;
-		}
-		itr = m_Cache.begin();
-		std::advance(itr, 100);
-		m_Cache.erase(itr, m_Cache.end());
-	}
 }
 
 
@@ -1418,6 +1355,7 @@ void cStructGenMineShafts::GenFinish(cChunkDesc & a_ChunkDesc)
 	for (cMineShaftSystems::const_iterator itr = MineShafts.begin(); itr != MineShafts.end(); ++itr)
 	{
 		(*itr)->ProcessChunk(a_ChunkDesc);
+		m_Cache.Release(*itr);
 	}  // for itr - MineShafts[]
 }
 
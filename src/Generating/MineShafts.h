@@ -10,6 +10,7 @@
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "FinishGenCache.h"
 #include "../Noise.h"
 
 
@@ -22,11 +23,10 @@ class cStructGenMineShafts :
 public:
 	cStructGenMineShafts(
 		int a_Seed, int a_GridSize, int a_MaxSystemSize,
-		int a_ChanceCorridor, int a_ChanceCrossing, int a_ChanceStaircase
+		int a_ChanceCorridor, int a_ChanceCrossing, int a_ChanceStaircase,
+		cFinishGenCache & a_Cache
 	);
 	
-	virtual ~cStructGenMineShafts();
-	
 protected:
 	friend class cMineShaft;
 	friend class cMineShaftDirtRoom;
@@ -42,13 +42,10 @@ protected:
 	int               m_ProbLevelCorridor;   ///< Probability level of a branch object being the corridor
 	int               m_ProbLevelCrossing;   ///< Probability level of a branch object being the crossing, minus Corridor
 	int               m_ProbLevelStaircase;  ///< Probability level of a branch object being the staircase, minus Crossing
-	cMineShaftSystems m_Cache;               ///< Cache of the most recently used systems. MoveToFront used.
-	
-	/// Clears everything from the cache
-	void ClearCache(void);
+	cFinishGenCache & m_Cache;               ///< The systems are shared with the other generator threads
 	
 	/** Returns all systems that *may* intersect the given chunk.
-	All the systems are valid until the next call to this function (which may delete some of the pointers).
+	The caller must release all the systems through m_Cache.
 	*/
 	void GetMineShaftSystemsForChunk(int a_ChunkX, int a_ChunkZ, cMineShaftSystems & a_MineShaftSystems);
 
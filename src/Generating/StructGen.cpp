@@ -59,8 +59,6 @@ void cStructGenTrees::GenFinish(cChunkDesc & a_ChunkDesc)
 	int ChunkX = a_ChunkDesc.GetChunkX();
 	int ChunkZ = a_ChunkDesc.GetChunkZ();
 	
-	cChunkDesc WorkerDesc(ChunkX, ChunkZ);
-	
 	// Generate trees:
 	for (int x = 0; x <= 2; x++)
 	{
@@ -69,37 +67,27 @@ void cStructGenTrees::GenFinish(cChunkDesc & a_ChunkDesc)
 		{
 			int BaseZ = ChunkZ + z - 1;
 			
-			cChunkDesc * Dest;
-
-			if ((x != 1) || (z != 1))
+			if ((x == 1) && (z == 1))
 			{
-				Dest = &WorkerDesc;
-				WorkerDesc.SetChunkCoords(BaseX, BaseZ);
-				
-				m_BiomeGen->GenBiomes           (BaseX, BaseZ, WorkerDesc.GetBiomeMap());
-				m_HeightGen->GenHeightMap       (BaseX, BaseZ, WorkerDesc.GetHeightMap());
-				m_CompositionGen->ComposeTerrain(WorkerDesc);
-				// TODO: Free the entity lists
-			}
-			else
-			{
-				Dest = &a_ChunkDesc;
-			}
-
-			int NumTrees = GetNumTrees(BaseX, BaseZ, Dest->GetBiomeMap());
-
-			sSetBlockVector OutsideLogs, OutsideOther;
-			for (int i = 0; i < NumTrees; i++)
-			{
-				GenerateSingleTree(BaseX, BaseZ, i, *Dest, OutsideLogs, OutsideOther);
+				// This chunk; the parts of its trees reaching out of it are not needed here:
+				int NumTrees = GetNumTrees(BaseX, BaseZ, a_ChunkDesc.GetBiomeMap());
+				sSetBlockVector OutsideLogs, OutsideOther;
+				for (int i = 0; i < NumTrees; i++)
+				{
+					GenerateSingleTree(BaseX, BaseZ, i, a_ChunkDesc, OutsideLogs, OutsideOther);
+				}
+				continue;
 			}
 
+			// A neighbour, apply the parts of its trees that reach into this chunk:
+			cTreeOverflow * Overflow = GetTreeOverflow(BaseX, BaseZ);
 			sSetBlockVector IgnoredOverflow;
-			IgnoredOverflow.reserve(OutsideOther.size());
-			ApplyTreeImage(ChunkX, ChunkZ, a_ChunkDesc, OutsideOther, IgnoredOverflow);
+			IgnoredOverflow.reserve(Overflow->m_Other.size());
+			ApplyTreeImage(ChunkX, ChunkZ, a_ChunkDesc, Overflow->m_Other, IgnoredOverflow);
 			IgnoredOverflow.clear();
-			IgnoredOverflow.reserve(OutsideLogs.size());
-			ApplyTreeImage(ChunkX, ChunkZ, a_ChunkDesc, OutsideLogs, IgnoredOverflow);
+			IgnoredOverflow.reserve(Overflow->m_Logs.size());
+			ApplyTreeImage(ChunkX, ChunkZ, a_ChunkDesc, Overflow->m_Logs, IgnoredOverflow);
+			m_Cache.Release(Overflow);
 		}  // for z
 	}  // for x
 	
@@ -124,6 +112,36 @@ void cStructGenTrees::GenFinish(cChunkDesc & a_ChunkDesc)
 
 
 
+cStructGenTrees::cTreeOverflow * cStructGenTrees::GetTreeOverflow(int a_ChunkX, int a_ChunkZ)
+{
+	cFinishGenCache::cStructure * Cached = m_Cache.Get(cFinishGenCache::kindTreeOverflow, a_ChunkX, a_ChunkZ);
+	if (Cached != NULL)
+	{
+		return static_cast<cTreeOverflow *>(Cached);
+	}
+	
+	// Grow the trees on the chunk's unfinished terrain; the terrain itself may be cached, too:
+	cChunkDesc WorkerDesc(a_ChunkX, a_ChunkZ);
+	if (!m_Cache.GetTerrain(a_ChunkX, a_ChunkZ, WorkerDesc))
+	{
+		m_BiomeGen->GenBiomes           (a_ChunkX, a_ChunkZ, WorkerDesc.GetBiomeMap());
+		m_HeightGen->GenHeightMap       (a_ChunkX, a_ChunkZ, WorkerDesc.GetHeightMap());
+		m_CompositionGen->ComposeTerrain(WorkerDesc);
+		m_Cache.PutTerrain(WorkerDesc);
+	}
+	cTreeOverflow * Overflow = new cTreeOverflow;
+	int NumTrees = GetNumTrees(a_ChunkX, a_ChunkZ, WorkerDesc.GetBiomeMap());
+	for (int i = 0; i < NumTrees; i++)
+	{
+		GenerateSingleTree(a_ChunkX, a_ChunkZ, i, WorkerDesc, Overflow->m_Logs, Overflow->m_Other);
+	}
+	return static_cast<cTreeOverflow *>(m_Cache.Put(cFinishGenCache::kindTreeOverflow, a_ChunkX, a_ChunkZ, Overflow));
+}
+
+
+
+
+
 void cStructGenTrees::GenerateSingleTree(
 	int a_ChunkX, int a_ChunkZ, int a_Seq,
 	cChunkDesc & a_ChunkDesc,
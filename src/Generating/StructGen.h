@@ -14,6 +14,7 @@
 #pragma once
 
 #include "ComposableGenerator.h"
+#include "FinishGenCache.h"
 #include "../Noise.h"
 
 
@@ -24,21 +25,37 @@ class cStructGenTrees :
 	public cFinishGen
 {
 public:
-	cStructGenTrees(int a_Seed, cBiomeGen * a_BiomeGen, cTerrainHeightGen * a_HeightGen, cTerrainCompositionGen * a_CompositionGen) :
+	cStructGenTrees(int a_Seed, cBiomeGen * a_BiomeGen, cTerrainHeightGen * a_HeightGen, cTerrainCompositionGen * a_CompositionGen, cFinishGenCache & a_Cache) :
 		m_Seed(a_Seed),
 		m_Noise(a_Seed),
 		m_BiomeGen(a_BiomeGen),
 		m_HeightGen(a_HeightGen),
-		m_CompositionGen(a_CompositionGen)
+		m_CompositionGen(a_CompositionGen),
+		m_Cache(a_Cache)
 	{}
 	
 protected:
 
+	/** The parts of a chunk's trees that reach into the neighbouring chunks, grown on the chunk's unfinished terrain.
+	Each chunk's overflow is needed by all 8 of its neighbours, so it is cached. */
+	class cTreeOverflow :
+		public cFinishGenCache::cStructure
+	{
+	public:
+		sSetBlockVector m_Logs;
+		sSetBlockVector m_Other;
+	} ;
+
 	int m_Seed;
 	cNoise m_Noise;
 	cBiomeGen *              m_BiomeGen;
 	cTerrainHeightGen *      m_HeightGen;
 	cTerrainCompositionGen * m_CompositionGen;
+	cFinishGenCache &        m_Cache;
+	
+	/** Returns the overflow of the trees of the specified chunk, from the cache or newly generated.
+	The caller must release the returned object through m_Cache. */
+	cTreeOverflow * GetTreeOverflow(int a_ChunkX, int a_ChunkZ);
 	
 	/** Generates and applies an image of a single tree.
 	Parts of the tree inside the chunk are applied to a_BlockX.
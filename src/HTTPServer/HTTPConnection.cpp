@@ -229,9 +229,10 @@ void cHTTPConnection::DataReceived(const char * a_Data, size_t a_Size)
 
 
 
-void cHTTPConnection::GetOutgoingData(AString & a_Data)
+void cHTTPConnection::GetOutgoingData(cBufferChain & a_Data)
 {
-	std::swap(a_Data, m_OutgoingData);
+	a_Data.Append(m_OutgoingData);
+	m_OutgoingData.clear();
 }
 
 
@@ -0,0 +1,338 @@
+
+// InterestManager.cpp
+
+// Implements the cInterestManager class that decides which entity movement updates a client receives and when
+
+#include "Globals.h"
+
+#include "InterestManager.h"
+#include "ClientHandle.h"
+#include "World.h"
+#include "Entities/Player.h"
+#include "Protocol/EntityPackets.h"
+#include "inifile/iniFile.h"
+
+
+
+
+
+double cInterestManager::s_NearDistanceSq = 24 * 24;
+double cInterestManager::s_MidDistanceSq = 64 * 64;
+int cInterestManager::s_MidInterval = 4;
+int cInterestManager::s_FarInterval = 10;
+int cInterestManager::s_MaxDelay = 40;
+int cInterestManager::s_MaxBytesPerTick = 8192;
+
+
+
+
+
+/** Sends the queued updates of the entity found by ID, or drops them if the entity doesn't exist anymore */
+class cInterestManager::cSendCallback :
+	public cEntityCallback
+{
+public:
+	cSendCallback(cInterestManager & a_Manager) :
+		m_Manager(a_Manager)
+	{
+	}
+
+protected:
+	cInterestManager & m_Manager;
+
+	virtual bool Item(cEntity * a_Entity) override
+	{
+		sPendingUpdate Update;
+		{
+			cCSLock Lock(m_Manager.m_CS);
+			cPendingUpdates::iterator itr = m_Manager.m_Pending.find(a_Entity->GetUniqueID());
+			if (itr == m_Manager.m_Pending.end())
+			{
+				// Already sent or dropped in the meantime
+				return true;
+			}
+			Update = itr->second;
+			m_Manager.m_Pending.erase(itr);
+		}
+		m_Manager.SendPending(*a_Entity, Update);
+		return true;
+	}
+} ;
+
+
+
+
+
+cInterestManager::cInterestManager(cClientHandle & a_Client) :
+	m_Client(a_Client),
+	m_NumBytesThisTick(0)
+{
+}
+
+
+
+
+
+void cInterestManager::ReadSettings(cIniFile & a_SettingsIni)
+{
+	int NearDistance = a_SettingsIni.GetValueSetI("EntityUpdates", "NearDistance", 24);
+	int MidDistance = std::max(NearDistance, a_SettingsIni.GetValueSetI("EntityUpdates", "MidDistance", 64));
+	s_NearDistanceSq = (double)NearDistance * NearDistance;
+	s_MidDistanceSq = (double)MidDistance * MidDistance;
+	s_MidInterval = std::max(1, a_SettingsIni.GetValueSetI("EntityUpdates", "MidIntervalTicks", 4));
+	s_FarInterval = std::max(s_MidInterval, a_SettingsIni.GetValueSetI("EntityUpdates", "FarIntervalTicks", 10));
+	s_MaxDelay = std::max(s_FarInterval, a_SettingsIni.GetValueSetI("EntityUpdates", "MaxDelayTicks", 40));
+	s_MaxBytesPerTick = std::max(256, a_SettingsIni.GetValueSetI("EntityUpdates", "MaxBytesPerTick", 8192));
+}
+
+
+
+
+
+bool cInterestManager::ShouldSendNow(const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ)
+{
+	cPlayer * Player = m_Client.GetPlayer();
+	if (Player == NULL)
+	{
+		return true;
+	}
+	double DistanceSq = (a_Entity.GetPosition() - Player->GetPosition()).SqrLength();
+	Int64 Now = a_Entity.GetWorld()->GetWorldAge();
+
+	cCSLock Lock(m_CS);
+	if (m_Pending.find(a_Entity.GetUniqueID()) != m_Pending.end())
+	{
+		// There are older updates waiting; this one must not overtake them, coalesce:
+		Enqueue(a_Entity, a_Flags, a_RelX, a_RelY, a_RelZ, Now + GetInterval(DistanceSq), Now, DistanceSq);
+		return false;
+	}
+	int Interval = GetInterval(DistanceSq);
+	if ((Interval == 0) && (m_NumBytesThisTick < s_MaxBytesPerTick))
+	{
+		return true;
+	}
+
+	// Further away, or over the budget; the near updates over the budget are due right in the next tick:
+	Enqueue(a_Entity, a_Flags, a_RelX, a_RelY, a_RelZ, Now + Interval, Now, DistanceSq);
+	return false;
+}
+
+
+
+
+
+void cInterestManager::AddSentBytes(size_t a_NumBytes)
+{
+	cCSLock Lock(m_CS);
+	m_NumBytesThisTick += (int)a_NumBytes;
+}
+
+
+
+
+
+void cInterestManager::Tick(cWorld & a_World)
+{
+	Int64 Now = a_World.GetWorldAge();
+
+	// Pick the updates that are due, the ones waiting for too long first, then the nearest ones:
+	std::vector<std::pair<double, int> > Due;
+	{
+		cCSLock Lock(m_CS);
+		m_NumBytesThisTick = 0;
+		for (cPendingUpdates::const_iterator itr = m_Pending.begin(), end = m_Pending.end(); itr != end; ++itr)
+		{
+			if (itr->second.m_DueTick > Now)
+			{
+				continue;
+			}
+			double Priority = (Now - itr->second.m_QueuedTick >= s_MaxDelay) ? -1 : itr->second.m_DistanceSq;
+			Due.push_back(std::make_pair(Priority, itr->first));
+		}
+	}
+	if (Due.empty())
+	{
+		return;
+	}
+	std::sort(Due.begin(), Due.end());
+
+	// Send them while the budget allows; the entities are looked up without holding m_CS, to keep the lock order with the chunkmap.
+	// Each entity is searched for in the chunk where it was when last queued, only if it has moved since is the whole world searched:
+	cSendCallback Callback(*this);
+	for (std::vector<std::pair<double, int> >::const_iterator itr = Due.begin(), end = Due.end(); itr != end; ++itr)
+	{
+		int ChunkX, ChunkZ;
+		{
+			cCSLock Lock(m_CS);
+			if (m_NumBytesThisTick >= s_MaxBytesPerTick)
+			{
+				break;
+			}
+			cPendingUpdates::const_iterator Pending = m_Pending.find(itr->second);
+			if (Pending == m_Pending.end())
+			{
+				// Dropped in the meantime
+				continue;
+			}
+			ChunkX = Pending->second.m_ChunkX;
+			ChunkZ = Pending->second.m_ChunkZ;
+		}
+		if (
+			!a_World.DoWithEntityByIDInChunk(ChunkX, ChunkZ, itr->second, Callback) &&
+			!a_World.DoWithEntityByID(itr->second, Callback)
+		)
+		{
+			// The entity is gone, its destroy packet has been sent already
+			EntityDestroyed(itr->second);
+		}
+	}
+}
+
+
+
+
+
+void cInterestManager::EntityDestroyed(int a_EntityID)
+{
+	cCSLock Lock(m_CS);
+	m_Pending.erase(a_EntityID);
+}
+
+
+
+
+
+void cInterestManager::Clear(void)
+{
+	cCSLock Lock(m_CS);
+	m_Pending.clear();
+}
+
+
+
+
+
+int cInterestManager::GetInterval(double a_DistanceSq)
+{
+	if (a_DistanceSq <= s_NearDistanceSq)
+	{
+		return 0;
+	}
+	return (a_DistanceSq <= s_MidDistanceSq) ? s_MidInterval : s_FarInterval;
+}
+
+
+
+
+
+void cInterestManager::Enqueue(const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ, Int64 a_DueTick, Int64 a_Now, double a_DistanceSq)
+{
+	cPendingUpdates::iterator itr = m_Pending.find(a_Entity.GetUniqueID());
+	if (itr == m_Pending.end())
+	{
+		sPendingUpdate Update;
+		Update.m_Flags = 0;
+		Update.m_RelX = 0;
+		Update.m_RelY = 0;
+		Update.m_RelZ = 0;
+		Update.m_QueuedTick = a_Now;
+		Update.m_DueTick = a_DueTick;
+		itr = m_Pending.insert(std::make_pair(a_Entity.GetUniqueID(), Update)).first;
+	}
+	sPendingUpdate & Update = itr->second;
+	Update.m_DistanceSq = a_DistanceSq;
+	Update.m_ChunkX = a_Entity.GetChunkX();
+	Update.m_ChunkZ = a_Entity.GetChunkZ();
+
+	// When the entity comes closer, its updates become due sooner:
+	Update.m_DueTick = std::min(Update.m_DueTick, a_DueTick);
+
+	if ((a_Flags & ufTeleport) != 0)
+	{
+		// The teleport sends the current position and look, all the relative moves before it are superseded:
+		Update.m_Flags = (Update.m_Flags & ~(ufRelMove | ufLook)) | ufTeleport;
+		Update.m_RelX = 0;
+		Update.m_RelY = 0;
+		Update.m_RelZ = 0;
+		a_Flags &= ~(ufTeleport | ufRelMove | ufLook);
+	}
+	if ((Update.m_Flags & ufTeleport) != 0)
+	{
+		// A teleport is already queued, it will carry the current position and look
+		a_Flags &= ~(ufRelMove | ufLook);
+	}
+	if ((a_Flags & ufRelMove) != 0)
+	{
+		Update.m_RelX += a_RelX;
+		Update.m_RelY += a_RelY;
+		Update.m_RelZ += a_RelZ;
+		if (
+			(Update.m_RelX < -128) || (Update.m_RelX > 127) ||
+			(Update.m_RelY < -128) || (Update.m_RelY > 127) ||
+			(Update.m_RelZ < -128) || (Update.m_RelZ > 127)
+		)
+		{
+			// The sum doesn't fit a relative move anymore, send the absolute position instead:
+			Update.m_Flags = (Update.m_Flags & ~(ufRelMove | ufLook)) | ufTeleport;
+			a_Flags &= ~(ufRelMove | ufLook);
+		}
+	}
+	Update.m_Flags |= a_Flags;
+}
+
+
+
+
+
+void cInterestManager::SendPending(const cEntity & a_Entity, const sPendingUpdate & a_Update)
+{
+	if ((a_Update.m_Flags & ufTeleport) != 0)
+	{
+		cEntityTeleportPacket Packet(a_Entity);
+		SendPacket(Packet);
+	}
+	else if ((a_Update.m_Flags & ufRelMove) != 0)
+	{
+		if ((a_Update.m_Flags & ufLook) != 0)
+		{
+			cEntityRelMoveLookPacket Packet(a_Entity, (char)a_Update.m_RelX, (char)a_Update.m_RelY, (char)a_Update.m_RelZ);
+			SendPacket(Packet);
+		}
+		else
+		{
+			cEntityRelMovePacket Packet(a_Entity, (char)a_Update.m_RelX, (char)a_Update.m_RelY, (char)a_Update.m_RelZ);
+			SendPacket(Packet);
+		}
+	}
+	else if ((a_Update.m_Flags & ufLook) != 0)
+	{
+		cEntityLookPacket Packet(a_Entity);
+		SendPacket(Packet);
+	}
+	if ((a_Update.m_Flags & ufHeadLook) != 0)
+	{
+		cEntityHeadLookPacket Packet(a_Entity);
+		SendPacket(Packet);
+	}
+	if ((a_Update.m_Flags & ufVelocity) != 0)
+	{
+		cEntityVelocityPacket Packet(a_Entity);
+		SendPacket(Packet);
+	}
+}
+
+
+
+
+
+void cInterestManager::SendPacket(cBroadcastPacket & a_Packet)
+{
+	AString Data;
+	m_Client.SerializeBroadcast(a_Packet, Data);
+	m_Client.SendSerialized(Data);
+	AddSentBytes(Data.size());
+}
+
+
+
+
@@ -0,0 +1,120 @@
+
+// InterestManager.h
+
+// Declares the cInterestManager class that decides which entity movement updates a client receives and when
+
+
+
+
+
+#pragma once
+
+
+
+
+
+// fwd:
+class cClientHandle;
+class cEntity;
+class cWorld;
+class cIniFile;
+class cBroadcastPacket;
+
+
+
+
+
+/** Each client has one interest manager that throttles the entity movement updates (relative moves, looks,
+teleports, velocity) sent to it. The updates of entities near the client's player are sent right away; the updates
+of entities further away are queued and sent at a lower rate, the queued updates of the same entity are coalesced
+into one (relative moves are summed up, the rest use the entity's current state at the time of sending).
+The bytes sent per tick are bounded; once the budget is used up, even the near updates are queued, and the queue
+is drained nearest-first in the following ticks. Updates that have been waiting for too long go first, regardless
+of the distance, so that far entities don't starve in a crowded area.
+The updates come mostly from the world's tick thread; the CS guards against broadcasts from the other threads (commands, webadmin). */
+class cInterestManager
+{
+public:
+	/** What an entity update consists of; the queued updates of an entity combine these */
+	enum eUpdateFlags
+	{
+		ufRelMove  = 0x01,
+		ufLook     = 0x02,
+		ufHeadLook = 0x04,
+		ufVelocity = 0x08,
+		ufTeleport = 0x10,  // Supersedes ufRelMove and ufLook
+	} ;
+
+	cInterestManager(cClientHandle & a_Client);
+
+	/** Reads the distances, rates and the budget, common to all clients, from the [EntityUpdates] section */
+	static void ReadSettings(cIniFile & a_SettingsIni);
+
+	/** Decides whether the entity update should be sent to the client right away.
+	Returns true if the caller is to send it now, and report the bytes sent through AddSentBytes().
+	Returns false if the update has been queued (coalesced with the already queued updates of the entity); Tick() sends it later.
+	a_RelX, a_RelY and a_RelZ are the relative move, in 1/32 blocks, valid only with ufRelMove. */
+	bool ShouldSendNow(const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ);
+
+	/** Accounts for bytes sent to the client by the caller of ShouldSendNow() */
+	void AddSentBytes(size_t a_NumBytes);
+
+	/** Starts a new budget period and sends the queued updates that are due, as many as the budget allows */
+	void Tick(cWorld & a_World);
+
+	/** Drops the queued updates of the entity; called when the entity is destroyed on the client */
+	void EntityDestroyed(int a_EntityID);
+
+	/** Drops all the queued updates; called when the client changes worlds */
+	void Clear(void);
+
+protected:
+	/** The updates of a single entity waiting to be sent */
+	struct sPendingUpdate
+	{
+		int m_Flags;  // Combination of eUpdateFlags
+		int m_RelX, m_RelY, m_RelZ;  // Summed relative moves, in 1/32 blocks
+		Int64 m_QueuedTick;  // World age when the first of the coalesced updates was queued
+		Int64 m_DueTick;     // World age when the update is to be sent
+		double m_DistanceSq;  // Squared distance from the player when last queued, for prioritizing
+		int m_ChunkX, m_ChunkZ;  // The entity's chunk when last queued, so that Tick() searches only that chunk for the entity
+	} ;
+
+	/** Maps entity ID -> its queued updates */
+	typedef std::map<int, sPendingUpdate> cPendingUpdates;
+
+	class cSendCallback;
+
+	cClientHandle & m_Client;
+
+	cCriticalSection m_CS;
+
+	cPendingUpdates m_Pending;
+
+	/** Bytes of entity updates sent since the last Tick() */
+	int m_NumBytesThisTick;
+
+	// The settings, see ReadSettings():
+	static double s_NearDistanceSq;
+	static double s_MidDistanceSq;
+	static int s_MidInterval;
+	static int s_FarInterval;
+	static int s_MaxDelay;
+	static int s_MaxBytesPerTick;
+
+	/** Returns the number of ticks that the updates of an entity at the specified distance are delayed by; 0 for near entities */
+	static int GetInterval(double a_DistanceSq);
+
+	/** Adds the update to the queued updates of the entity. Assumes m_CS is locked. */
+	void Enqueue(const cEntity & a_Entity, int a_Flags, int a_RelX, int a_RelY, int a_RelZ, Int64 a_DueTick, Int64 a_Now, double a_DistanceSq);
+
+	/** Sends the queued updates of the entity to the client */
+	void SendPending(const cEntity & a_Entity, const sPendingUpdate & a_Update);
+
+	/** Serializes and sends a single packet to the client, accounting for its size */
+	void SendPacket(cBroadcastPacket & a_Packet);
+} ;
+
+
+
+
@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "LightingThread.h"
 #include "ChunkMap.h"
+#include "ChunkData.h"
 #include "ChunkStay.h"
 #include "World.h"
 
@@ -14,31 +15,38 @@
 
 
 
-/// Chunk data callback that takes the chunk data and puts them into cLightingThread's m_BlockTypes[] / m_HeightMap[]:
+/// Chunk data callback that takes the chunk data and puts them into cChunkLighter's m_BlockTypes[] / m_HeightMap[]:
 class cReader :
 	public cChunkDataCallback
 {
-	virtual void BlockTypes(const BLOCKTYPE * a_Type) override
+	virtual void ChunkData(const cChunkData & a_ChunkData) override
 	{
 		// ROW is a block of 16 Blocks, one whole row is copied at a time (hopefully the compiler will optimize that)
 		// C++ doesn't permit copying arrays, but arrays as a part of a struct is ok :)
 		typedef struct {BLOCKTYPE m_Row[16]; } ROW;
-		ROW * InputRows = (ROW *)a_Type;
+		ROW AirRow;
+		memset(&AirRow, E_BLOCK_AIR, sizeof(AirRow));
 		ROW * OutputRows = (ROW *)m_BlockTypes;
-		int InputIdx = 0;
 		int OutputIdx = m_ReadingChunkX + m_ReadingChunkZ * cChunkDef::Width * 3;
-		for (int y = 0; y < cChunkDef::Height; y++)
+		for (int Section = 0; Section < cChunkData::NumSections; Section++)
 		{
-			for (int z = 0; z < cChunkDef::Width; z++)
+			// Unallocated sections are all air:
+			const cChunkData::sChunkSection * SectionData = a_ChunkData.GetSection(Section);
+			const ROW * InputRows = (SectionData == NULL) ? NULL : (const ROW *)(SectionData->m_BlockTypes);
+			int InputIdx = 0;
+			for (int y = 0; y < cChunkData::SectionHeight; y++)
 			{
-				OutputRows[OutputIdx] = InputRows[InputIdx++];
-				OutputIdx += 3;
-			}  // for z
-			// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
-			// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
-			OutputIdx += cChunkDef::Width * 6;
-		}  // for y
-	}  // BlockTypes()
+				for (int z = 0; z < cChunkDef::Width; z++)
+				{
+					OutputRows[OutputIdx] = (InputRows == NULL) ? AirRow : InputRows[InputIdx++];
+					OutputIdx += 3;
+				}  // for z
+				// Skip into the next y-level in the 3x3 chunk blob; each level has cChunkDef::Width * 9 rows
+				// We've already walked cChunkDef::Width * 3 in the "for z" cycle, that makes cChunkDef::Width * 6 rows left to skip
+				OutputIdx += cChunkDef::Width * 6;
+			}  // for y
+		}  // for Section
+	}  // ChunkData()
 	
 	
 	virtual void HeightMap(const cChunkDef::HeightMap * a_Heightmap) override
@@ -70,8 +78,8 @@ public:
 // cLightingThread:
 
 cLightingThread::cLightingThread(void) :
-	super("cLightingThread"),
-	m_World(NULL)
+	m_World(NULL),
+	m_ShouldTerminate(false)
 {
 }
 
@@ -88,12 +96,28 @@ cLightingThread::~cLightingThread()
 
 
 
-bool cLightingThread::Start(cWorld * a_World)
+bool cLightingThread::Start(cWorld * a_World, int a_NumThreads)
 {
 	ASSERT(m_World == NULL);  // Not started yet
+	ASSERT(m_Workers.empty());
 	m_World = a_World;
+	m_ShouldTerminate = false;
 	
-	return super::Start();
+	if (a_NumThreads < 1)
+	{
+		a_NumThreads = 1;
+	}
+	for (int i = 0; i < a_NumThreads; i++)
+	{
+		cWorker * Worker = new cWorker(*this);
+		if (!Worker->Start())
+		{
+			delete Worker;
+			return !m_Workers.empty();
+		}
+		m_Workers.push_back(Worker);
+	}
+	return true;
 }
 
 
@@ -114,11 +138,16 @@ void cLightingThread::Stop(void)
 			delete *itr;
 		}
 		m_Queue.clear();
+		m_ShouldTerminate = true;
 	}
-	m_ShouldTerminate = true;
 	m_evtItemAdded.Set();
 	
-	Wait();
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->Wait();
+		delete *itr;
+	}
+	m_Workers.clear();
 }
 
 
@@ -146,7 +175,7 @@ void cLightingThread::QueueChunk(int a_ChunkX, int a_ChunkZ, cChunkCoordCallback
 void cLightingThread::WaitForQueueEmpty(void)
 {
 	cCSLock Lock(m_CS);
-	while (!m_ShouldTerminate && (!m_Queue.empty() || !m_PendingQueue.empty()))
+	while (!m_ShouldTerminate && (!m_Queue.empty() || !m_PendingQueue.empty() || !m_InProgress.empty()))
 	{
 		cCSUnlock Unlock(Lock);
 		m_evtQueueEmpty.Wait();
@@ -160,61 +189,201 @@ void cLightingThread::WaitForQueueEmpty(void)
 size_t cLightingThread::GetQueueLength(void)
 {
 	cCSLock Lock(m_CS);
-	return m_Queue.size() + m_PendingQueue.size();
+	return m_Queue.size() + m_PendingQueue.size() + m_InProgress.size();
+}
+
+
+
+
+
+void cLightingThread::GetStats(int & a_NumPending, int & a_NumQueued, int & a_NumInProgress, int & a_NumThreads)
+{
+	cCSLock Lock(m_CS);
+	a_NumPending = (int)m_PendingQueue.size();
+	a_NumQueued = (int)m_Queue.size();
+	a_NumInProgress = (int)m_InProgress.size();
+	a_NumThreads = (int)m_Workers.size();
 }
 
 
 
 
 
-void cLightingThread::Execute(void)
+cLightingThread::cLightingChunkStay * cLightingThread::GetNextChunk(void)
 {
+	cCSLock Lock(m_CS);
 	for (;;)
 	{
-		{
-			cCSLock Lock(m_CS);
-			if (m_Queue.size() == 0)
-			{
-				cCSUnlock Unlock(Lock);
-				m_evtItemAdded.Wait();
-			}
-		}
-		
 		if (m_ShouldTerminate)
 		{
-			return;
+			// Pass the termination request on to the next worker:
+			m_evtItemAdded.Set();
+			return NULL;
 		}
 		
-		// Process one items from the queue:
-		cLightingChunkStay * Item;
+		// Take the first chunk that doesn't conflict with any chunk being lighted by the other workers:
+		for (cChunkStays::iterator itr = m_Queue.begin(), end = m_Queue.end(); itr != end; ++itr)
 		{
-			cCSLock Lock(m_CS);
-			if (m_Queue.empty())
+			cLightingChunkStay * Item = (cLightingChunkStay *)*itr;
+			if (IsNeighborhoodInProgress(Item->m_ChunkX, Item->m_ChunkZ))
 			{
 				continue;
 			}
-			Item = (cLightingChunkStay *)m_Queue.front();
-			m_Queue.pop_front();
-			if (m_Queue.empty())
+			m_Queue.erase(itr);
+			m_InProgress.push_back(cChunkCoords(Item->m_ChunkX, ZERO_CHUNK_Y, Item->m_ChunkZ));
+			if (!m_Queue.empty())
 			{
-				m_evtQueueEmpty.Set();
+				// There are more chunks, wake up another worker to try them:
+				m_evtItemAdded.Set();
 			}
-		}  // CSLock(m_CS)
+			return Item;
+		}
 		
-		LightChunk(*Item);
+		// Nothing that could be lighted now, wait for more chunks or for a conflicting chunk to finish:
+		cCSUnlock Unlock(Lock);
+		m_evtItemAdded.Wait();
+	}
+}
+
+
+
+
+
+void cLightingThread::ChunkFinished(int a_ChunkX, int a_ChunkZ)
+{
+	{
+		cCSLock Lock(m_CS);
+		for (cChunkCoordsVector::iterator itr = m_InProgress.begin(), end = m_InProgress.end(); itr != end; ++itr)
+		{
+			if ((itr->m_ChunkX == a_ChunkX) && (itr->m_ChunkZ == a_ChunkZ))
+			{
+				m_InProgress.erase(itr);
+				break;
+			}
+		}
+		if (m_Queue.empty())
+		{
+			m_evtQueueEmpty.Set();
+			return;
+		}
+	}
+	
+	// Some of the queued chunks may have been waiting for this one to finish:
+	m_evtItemAdded.Set();
+}
+
+
+
+
+
+bool cLightingThread::IsNeighborhoodInProgress(int a_ChunkX, int a_ChunkZ) const
+{
+	// Two 3x3 neighborhoods overlap if their centers are less than 3 chunks apart on both axes
+	for (cChunkCoordsVector::const_iterator itr = m_InProgress.begin(), end = m_InProgress.end(); itr != end; ++itr)
+	{
+		if ((std::abs(itr->m_ChunkX - a_ChunkX) < 3) && (std::abs(itr->m_ChunkZ - a_ChunkZ) < 3))
+		{
+			return true;
+		}
 	}
+	return false;
+}
+
+
+
+
+
+void cLightingThread::QueueChunkStay(cLightingChunkStay & a_ChunkStay)
+{
+	// Move the ChunkStay from the Pending queue to the lighting queue.
+	{
+		cCSLock Lock(m_CS);
+		m_PendingQueue.remove(&a_ChunkStay);
+		m_Queue.push_back(&a_ChunkStay);
+	}
+	m_evtItemAdded.Set();
 }
 
 
 
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cLightingThread::cWorker:
+
+cLightingThread::cWorker::cWorker(cLightingThread & a_Parent) :
+	super("cLightingThread::cWorker"),
+	m_Parent(a_Parent)
+{
+}
+
+
+
+
+
+void cLightingThread::cWorker::Execute(void)
+{
+	for (;;)
+	{
+		cLightingChunkStay * Item = m_Parent.GetNextChunk();
+		if (Item == NULL)
+		{
+			return;
+		}
+		
+		// LightChunk() deletes the item, store its coords first:
+		int ChunkX = Item->m_ChunkX;
+		int ChunkZ = Item->m_ChunkZ;
+		LightChunk(*Item);
+		m_Parent.ChunkFinished(ChunkX, ChunkZ);
+	}
+}
 
-void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
+
+
+
+
+void cLightingThread::cWorker::LightChunk(cLightingChunkStay & a_Item)
 {
 	cChunkDef::BlockNibbles BlockLight, SkyLight;
-	
-	ReadChunks(a_Item.m_ChunkX, a_Item.m_ChunkZ);
+	if (m_Lighter.LightChunk(*m_Parent.m_World->GetChunkMap(), a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight))
+	{
+		m_Parent.m_World->ChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight);
+	}
+
+	if (a_Item.m_CallbackAfter != NULL)
+	{
+		a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ);
+	}
+	a_Item.Disable();
+	delete &a_Item;
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cChunkLighter:
+
+cChunkLighter::cChunkLighter(void) :
+	m_NumSeeds(0)
+{
+}
+
+
+
+
+
+bool cChunkLighter::LightChunk(
+	cChunkDataSource & a_Source, int a_ChunkX, int a_ChunkZ,
+	cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+)
+{
+	if (!ReadChunks(a_Source, a_ChunkX, a_ChunkZ))
+	{
+		return false;
+	}
 	
 	PrepareBlockLight();
 	CalcLight(m_BlockLight);
@@ -225,7 +394,7 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 	// DEBUG: Save chunk data with highlighted seeds for visual inspection:
 	cFile f4;
 	if (
-		f4.Open(Printf("Chunk_%d_%d_seeds.grab", a_Item.x, a_Item.z), cFile::fmWrite)
+		f4.Open(Printf("Chunk_%d_%d_seeds.grab", a_ChunkX, a_ChunkZ), cFile::fmWrite)
 	)
 	{
 		for (int z = 0; z < cChunkDef::Width * 3; z++)
@@ -253,9 +422,9 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 	// DEBUG: Save XY slices of the chunk data and lighting for visual inspection:
 	cFile f1, f2, f3;
 	if (
-		f1.Open(Printf("Chunk_%d_%d_data.grab",  a_Item.x, a_Item.z), cFile::fmWrite) &&
-		f2.Open(Printf("Chunk_%d_%d_sky.grab",   a_Item.x, a_Item.z), cFile::fmWrite) &&
-		f3.Open(Printf("Chunk_%d_%d_glow.grab",  a_Item.x, a_Item.z), cFile::fmWrite)
+		f1.Open(Printf("Chunk_%d_%d_data.grab",  a_ChunkX, a_ChunkZ), cFile::fmWrite) &&
+		f2.Open(Printf("Chunk_%d_%d_sky.grab",   a_ChunkX, a_ChunkZ), cFile::fmWrite) &&
+		f3.Open(Printf("Chunk_%d_%d_glow.grab",  a_ChunkX, a_ChunkZ), cFile::fmWrite)
 	)
 	{
 		for (int z = 0; z < cChunkDef::Width * 3; z++)
@@ -277,24 +446,16 @@ void cLightingThread::LightChunk(cLightingChunkStay & a_Item)
 	}
 	//*/
 	
-	CompressLight(m_BlockLight, BlockLight);
-	CompressLight(m_SkyLight, SkyLight);
-	
-	m_World->ChunkLighted(a_Item.m_ChunkX, a_Item.m_ChunkZ, BlockLight, SkyLight);
-
-	if (a_Item.m_CallbackAfter != NULL)
-	{
-		a_Item.m_CallbackAfter->Call(a_Item.m_ChunkX, a_Item.m_ChunkZ);
-	}
-	a_Item.Disable();
-	delete &a_Item;
+	CompressLight(m_BlockLight, a_BlockLight);
+	CompressLight(m_SkyLight, a_SkyLight);
+	return true;
 }
 
 
 
 
 
-bool cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
+bool cChunkLighter::ReadChunks(cChunkDataSource & a_Source, int a_ChunkX, int a_ChunkZ)
 {
 	cReader Reader;
 	Reader.m_BlockTypes = m_BlockTypes;
@@ -306,7 +467,7 @@ bool cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
 		for (int x = 0; x < 3; x++)
 		{
 			Reader.m_ReadingChunkX = x;
-			if (!m_World->GetChunkData(a_ChunkX + x - 1, a_ChunkZ + z - 1, Reader))
+			if (!a_Source.GetChunkData(a_ChunkX + x - 1, a_ChunkZ + z - 1, Reader))
 			{
 				return false;
 			}
@@ -322,7 +483,7 @@ bool cLightingThread::ReadChunks(int a_ChunkX, int a_ChunkZ)
 
 
 
-void cLightingThread::PrepareSkyLight(void)
+void cChunkLighter::PrepareSkyLight(void)
 {
 	// Clear seeds:
 	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
@@ -370,7 +531,7 @@ void cLightingThread::PrepareSkyLight(void)
 
 
 
-void cLightingThread::PrepareBlockLight(void)
+void cChunkLighter::PrepareBlockLight(void)
 {
 	// Clear seeds:
 	memset(m_IsSeed1, 0, sizeof(m_IsSeed1));
@@ -406,7 +567,7 @@ void cLightingThread::PrepareBlockLight(void)
 
 
 
-void cLightingThread::CalcLight(NIBBLETYPE * a_Light)
+void cChunkLighter::CalcLight(NIBBLETYPE * a_Light)
 {
 	int NumSeeds2 = 0;
 	while (m_NumSeeds > 0)
@@ -431,7 +592,7 @@ void cLightingThread::CalcLight(NIBBLETYPE * a_Light)
 
 
 
-void cLightingThread::CalcLightStep(
+void cChunkLighter::CalcLightStep(
 	NIBBLETYPE * a_Light, 
 	int a_NumSeedsIn,    unsigned char * a_IsSeedIn,  unsigned int * a_SeedIdxIn,
 	int & a_NumSeedsOut, unsigned char * a_IsSeedOut, unsigned int * a_SeedIdxOut
@@ -479,7 +640,7 @@ void cLightingThread::CalcLightStep(
 
 
 
-void cLightingThread::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight)
+void cChunkLighter::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_ChunkLight)
 {
 	int InIdx = cChunkDef::Width * 49;  // Index to the first nibble of the middle chunk in the a_LightArray
 	int OutIdx = 0;
@@ -504,21 +665,6 @@ void cLightingThread::CompressLight(NIBBLETYPE * a_LightArray, NIBBLETYPE * a_Ch
 
 
 
-void cLightingThread::QueueChunkStay(cLightingChunkStay & a_ChunkStay)
-{
-	// Move the ChunkStay from the Pending queue to the lighting queue.
-	{
-		cCSLock Lock(m_CS);
-		m_PendingQueue.remove(&a_ChunkStay);
-		m_Queue.push_back(&a_ChunkStay);
-	}
-	m_evtItemAdded.Set();
-}
-
-
-
-
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cLightingThread::cLightingChunkStay:
 
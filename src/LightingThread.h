@@ -21,10 +21,15 @@ the other is an array of seed coords, encoded as a single int.
 Step 2 needs two separate storages for old seeds and new seeds, so there are two actual storages for that purpose,
 their content is swapped after each full step-2-cycle.
 
-The thread has two queues of chunks that are to be lighted.
-The first queue, m_Queue, is the only one that is publicly visible, chunks get queued there by external requests.
-The second one, m_PostponedQueue, is for chunks that have been taken out of m_Queue and didn't have neighbors ready.
-Chunks from m_PostponedQueue are moved back into m_Queue when their neighbors get valid, using the ChunkReady callback.
+The object has two queues of chunks that are to be lighted.
+The first one, m_PendingQueue, holds the chunks that are waiting for their neighbors to load, using a ChunkStay.
+The second one, m_Queue, holds the chunks that have their whole 3x3 neighborhood loaded and are ready to be lighted.
+
+The calculation itself is implemented in cChunkLighter, which reads the chunks through the cChunkDataSource interface.
+The lighting is done by a configurable number of worker threads. Each worker has its own cChunkLighter with its buffers,
+so the workers can light chunks concurrently. A worker only takes a chunk from m_Queue if its 3x3 neighborhood
+doesn't overlap the neighborhood of any chunk currently being lighted by another worker (m_InProgress); such chunks
+are skipped and left in the queue until the conflicting chunk is finished.
 */
 
 
@@ -46,72 +51,25 @@ class cWorld;
 
 
 
-class cLightingThread :
-	public cIsThread
+/** Calculates the lighting of a single chunk from the block data of its 3x3 neighborhood, as described above.
+The buffers take several MiB, so the objects are meant to be allocated on the heap and reused for many chunks.
+A single object is not thread-safe; cLightingThread has one for each worker thread, so that the workers can light
+chunks concurrently. Tools that work without a cWorld, such as the pregenerator, use the objects directly. */
+class cChunkLighter
 {
-	typedef cIsThread super;
-	
 public:
+	cChunkLighter(void);
 	
-	cLightingThread(void);
-	~cLightingThread();
-	
-	bool Start(cWorld * a_World);
-	
-	void Stop(void);
-	
-	/** Queues the entire chunk for lighting */
-	void QueueChunk(int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_CallbackAfter = NULL);
-	
-	/** Blocks until the queue is empty or the thread is terminated */
-	void WaitForQueueEmpty(void);
-	
-	size_t GetQueueLength(void);
+	/** Reads the 3x3 neighborhood of the chunk from a_Source and calculates the light of the middle chunk.
+	Returns false if any of the chunks is not available from a_Source; the light is not calculated then. */
+	bool LightChunk(
+		cChunkDataSource & a_Source, int a_ChunkX, int a_ChunkZ,
+		cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+	);
 	
 protected:
-
-	class cLightingChunkStay :
-		public cChunkStay
-	{
-	public:
-		cLightingThread & m_LightingThread;
-		int m_ChunkX;
-		int m_ChunkZ;
-		cChunkCoordCallback * m_CallbackAfter;
-		
-		cLightingChunkStay(cLightingThread & a_LightingThread, int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_CallbackAfter);
-		
-	protected:
-		virtual void OnChunkAvailable(int a_ChunkX, int a_ChunkZ) override 
-		{
-			UNUSED(a_ChunkX);
-			UNUSED(a_ChunkZ);
-		}
-		virtual bool OnAllChunksAvailable(void) override;
-		virtual void OnDisabled(void) override;
-	} ;
-	
-	typedef std::list<cChunkStay *> cChunkStays;
-	
-	
-	cWorld * m_World;
-	
-	/** The mutex to protect m_Queue and m_PendingQueue */
-	cCriticalSection m_CS;
-	
-	/** The ChunkStays that are loaded and are waiting to be lit. */
-	cChunkStays m_Queue;
-
-	/** The ChunkStays that are waiting for load. Used for stopping the thread. */
-	cChunkStays m_PendingQueue;
-
-	cEvent m_evtItemAdded;    // Set when queue is appended, or to stop the thread
-	cEvent m_evtQueueEmpty;   // Set when the queue gets empty
-	
-	
 	// Buffers for the 3x3 chunk data
 	// These buffers alone are 1.7 MiB in size, therefore they cannot be located on the stack safely - some architectures may have only 1 MiB for stack, or even less
-	// Placing the buffers into the object means that this object can light chunks only in one thread!
 	// The blobs are XZY organized as a whole, instead of 3x3 XZY-organized subarrays ->
 	//  -> This means data has to be scatterred when reading and gathered when writing!
 	static const int BlocksPerYLayer = cChunkDef::Width * cChunkDef::Width * 3 * 3;
@@ -131,13 +89,8 @@ protected:
 	unsigned int  m_SeedIdx2[BlocksPerYLayer * cChunkDef::Height];
 	int m_NumSeeds;
 
-	virtual void Execute(void) override;
-
-	/** Lights the entire chunk. If neighbor chunks don't exist, touches them and re-queues the chunk */
-	void LightChunk(cLightingChunkStay & a_Item);
-	
-	/** Prepares m_BlockTypes and m_HeightMap data; returns false if any of the chunks fail. Zeroes out the light arrays */
-	bool ReadChunks(int a_ChunkX, int a_ChunkZ);
+	/** Prepares m_BlockTypes and m_HeightMap data from a_Source; returns false if any of the chunks fail. Zeroes out the light arrays */
+	bool ReadChunks(cChunkDataSource & a_Source, int a_ChunkX, int a_ChunkZ);
 	
 	/** Uses m_HeightMap to initialize the m_SkyLight[] data; fills in seeds for the skylight */
 	void PrepareSkyLight(void);
@@ -180,6 +133,123 @@ protected:
 			a_SeedIdxOut[a_NumSeedsOut++] = a_DstIdx;
 		}
 	}
+} ;
+
+
+
+
+
+class cLightingThread
+{
+public:
+	
+	cLightingThread(void);
+	~cLightingThread();
+	
+	/** Starts the specified number of worker threads lighting chunks in the specified world */
+	bool Start(cWorld * a_World, int a_NumThreads);
+	
+	void Stop(void);
+	
+	/** Queues the entire chunk for lighting */
+	void QueueChunk(int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_CallbackAfter = NULL);
+	
+	/** Blocks until the queue is empty or the thread is terminated */
+	void WaitForQueueEmpty(void);
+	
+	/** Returns the total number of chunks waiting for lighting, including those being lighted right now */
+	size_t GetQueueLength(void);
+	
+	/** Returns the number of chunks waiting for their neighbors to load, the number of chunks ready to be lighted,
+	the number of chunks being lighted right now and the number of worker threads */
+	void GetStats(int & a_NumPending, int & a_NumQueued, int & a_NumInProgress, int & a_NumThreads);
+	
+protected:
+
+	class cLightingChunkStay :
+		public cChunkStay
+	{
+	public:
+		cLightingThread & m_LightingThread;
+		int m_ChunkX;
+		int m_ChunkZ;
+		cChunkCoordCallback * m_CallbackAfter;
+		
+		cLightingChunkStay(cLightingThread & a_LightingThread, int a_ChunkX, int a_ChunkZ, cChunkCoordCallback * a_CallbackAfter);
+		
+	protected:
+		virtual void OnChunkAvailable(int a_ChunkX, int a_ChunkZ) override 
+		{
+			UNUSED(a_ChunkX);
+			UNUSED(a_ChunkZ);
+		}
+		virtual bool OnAllChunksAvailable(void) override;
+		virtual void OnDisabled(void) override;
+	} ;
+	
+	typedef std::list<cChunkStay *> cChunkStays;
+	
+	
+	/** A single worker thread; takes chunks from the parent's m_Queue and lights them */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+		
+	public:
+		cWorker(cLightingThread & a_Parent);
+		
+	protected:
+		cLightingThread & m_Parent;
+		
+		/** The lighting calculation, with its buffers */
+		cChunkLighter m_Lighter;
+		
+		/** Lights the entire chunk, stores the light into the world and calls the item's callback; deletes the item */
+		void LightChunk(cLightingChunkStay & a_Item);
+		
+		// cIsThread overrides:
+		virtual void Execute(void) override;
+	} ;
+	
+	typedef std::vector<cWorker *> cWorkers;
+	
+	
+	cWorld * m_World;
+	
+	cWorkers m_Workers;
+	
+	/** The mutex to protect m_Queue, m_PendingQueue, m_InProgress and m_ShouldTerminate */
+	cCriticalSection m_CS;
+	
+	/** The ChunkStays that are loaded and are waiting to be lit. */
+	cChunkStays m_Queue;
+
+	/** The ChunkStays that are waiting for load. Used for stopping the thread. */
+	cChunkStays m_PendingQueue;
+	
+	/** Coords of the chunks that are being lighted by the workers right now */
+	cChunkCoordsVector m_InProgress;
+	
+	/** Set when the workers are to terminate */
+	bool m_ShouldTerminate;
+
+	cEvent m_evtItemAdded;    // Set when queue is appended, when a chunk is finished, or to stop the workers
+	cEvent m_evtQueueEmpty;   // Set when the queue gets empty
+	
+	
+	/** Waits for a chunk in m_Queue that can be lighted concurrently with the chunks in m_InProgress, removes it
+	from the queue and adds it to m_InProgress. Returns NULL if the workers are to terminate.
+	Called from within the worker threads. */
+	cLightingChunkStay * GetNextChunk(void);
+	
+	/** Removes the chunk from m_InProgress and wakes up the workers that may be waiting for it.
+	Called from within the worker threads. */
+	void ChunkFinished(int a_ChunkX, int a_ChunkZ);
+	
+	/** Returns true if the 3x3 neighborhood of the specified chunk overlaps that of any chunk in m_InProgress.
+	Assumes m_CS is locked. */
+	bool IsNeighborhoodInProgress(int a_ChunkX, int a_ChunkZ) const;
 	
 	/** Queues a chunkstay that has all of its chunks loaded.
 	Called by cLightingChunkStay when all of its chunks are loaded. */
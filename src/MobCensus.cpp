@@ -7,10 +7,68 @@
 
 
 
-void cMobCensus::CollectMob(cMonster & a_Monster, cChunk & a_Chunk, double a_Distance)
+cMobCensus::cMobCensus(void) :
+	m_NumEligibleChunks(0)
 {
-	m_ProximityCounter.CollectMob(a_Monster, a_Chunk, a_Distance);
-	m_MobFamilyCollecter.CollectMob(a_Monster);
+	for (size_t i = 0; i < ARRAYCOUNT(m_NumMobs); i++)
+	{
+		m_NumMobs[i] = 0;
+	}
+}
+
+
+
+
+
+void cMobCensus::MobAdded(cMonster & a_Monster, cChunk & a_Chunk, bool a_IsChunkEligible)
+{
+	cCSLock Lock(m_CS);
+	cMobInfos::iterator itr = m_Mobs.find(&a_Monster);
+	if (itr == m_Mobs.end())
+	{
+		sMobInfo Info;
+		Info.m_Chunk = &a_Chunk;
+		Info.m_Family = a_Monster.GetMobFamily();
+		Info.m_IsCounted = false;
+		itr = m_Mobs.insert(cMobInfos::value_type(&a_Monster, Info)).first;
+	}
+	itr->second.m_Chunk = &a_Chunk;
+	SetCounted(itr->second, a_IsChunkEligible);
+}
+
+
+
+
+
+void cMobCensus::MobRemoved(cMonster & a_Monster)
+{
+	cCSLock Lock(m_CS);
+	cMobInfos::iterator itr = m_Mobs.find(&a_Monster);
+	if (itr == m_Mobs.end())
+	{
+		return;
+	}
+	SetCounted(itr->second, false);
+	m_Mobs.erase(itr);
+}
+
+
+
+
+
+void cMobCensus::ChunkEligibilityChanged(cChunk & a_Chunk, const std::vector<cMonster *> & a_Monsters, bool a_IsEligible)
+{
+	cCSLock Lock(m_CS);
+	m_NumEligibleChunks += a_IsEligible ? 1 : -1;
+	ASSERT(m_NumEligibleChunks >= 0);
+	for (std::vector<cMonster *>::const_iterator itr = a_Monsters.begin(), end = a_Monsters.end(); itr != end; ++itr)
+	{
+		cMobInfos::iterator Info = m_Mobs.find(*itr);
+		if ((Info != m_Mobs.end()) && (Info->second.m_Chunk == &a_Chunk))
+		{
+			SetCounted(Info->second, a_IsEligible);
+		}
+	}
 }
 
 
@@ -21,8 +79,9 @@ bool cMobCensus::IsCapped(cMonster::eFamily a_MobFamily)
 {
 	const int ratio = 319; // this should be 256 as we are only supposed to take account from chunks that are in 17x17 from a player
 	// but for now, we use all chunks loaded by players. that means 19 x 19 chunks. That's why we use 256 * (19*19) / (17*17) = 319
-	// MG TODO : code the correct count	
-	if ((GetCapMultiplier(a_MobFamily) * GetNumChunks()) / ratio >= m_MobFamilyCollecter.GetNumberOfCollectedMobs(a_MobFamily))
+	// MG TODO : code the correct count
+	cCSLock Lock(m_CS);
+	if ((GetCapMultiplier(a_MobFamily) * m_NumEligibleChunks) / ratio >= m_NumMobs[a_MobFamily])
 	{
 		return false;
 	}
@@ -33,47 +92,69 @@ bool cMobCensus::IsCapped(cMonster::eFamily a_MobFamily)
 
 
 
-int cMobCensus::GetCapMultiplier(cMonster::eFamily a_MobFamily)
+const cMobCensus::cMobChunkVector & cMobCensus::GetCountedMobs(void)
 {
-	switch (a_MobFamily)
+	cCSLock Lock(m_CS);
+	m_CountedMobs.clear();
+	for (cMobInfos::const_iterator itr = m_Mobs.begin(), end = m_Mobs.end(); itr != end; ++itr)
 	{
-		case cMonster::mfHostile: return 79;
-		case cMonster::mfPassive: return 11;
-		case cMonster::mfAmbient: return 16;
-		case cMonster::mfWater:   return 5;
-		default:
+		if (itr->second.m_IsCounted)
 		{
-			ASSERT(!"Unhandled mob family");
-			return -1;
+			m_CountedMobs.push_back(sMobChunk(itr->first, itr->second.m_Chunk));
 		}
 	}
+	return m_CountedMobs;
 }
 
 
 
 
 
-void cMobCensus::CollectSpawnableChunk(cChunk & a_Chunk)
+cChunk * cMobCensus::GetCountedMobChunk(cMonster * a_Monster)
 {
-	m_EligibleForSpawnChunks.insert(&a_Chunk);
+	cCSLock Lock(m_CS);
+	cMobInfos::const_iterator itr = m_Mobs.find(a_Monster);
+	if ((itr == m_Mobs.end()) || !itr->second.m_IsCounted)
+	{
+		return NULL;
+	}
+	return itr->second.m_Chunk;
 }
 
 
 
 
 
-int cMobCensus::GetNumChunks(void)
+void cMobCensus::SetCounted(sMobInfo & a_Info, bool a_IsCounted)
 {
-	return m_EligibleForSpawnChunks.size();
+	ASSERT(m_CS.IsLocked());
+	if (a_Info.m_IsCounted == a_IsCounted)
+	{
+		return;
+	}
+	a_Info.m_IsCounted = a_IsCounted;
+	m_NumMobs[a_Info.m_Family] += a_IsCounted ? 1 : -1;
+	ASSERT(m_NumMobs[a_Info.m_Family] >= 0);
 }
 
 
 
 
 
-cMobProximityCounter & cMobCensus::GetProximityCounter(void)
+int cMobCensus::GetCapMultiplier(cMonster::eFamily a_MobFamily)
 {
-	return m_ProximityCounter;
+	switch (a_MobFamily)
+	{
+		case cMonster::mfHostile: return 79;
+		case cMonster::mfPassive: return 11;
+		case cMonster::mfAmbient: return 16;
+		case cMonster::mfWater:   return 5;
+		default:
+		{
+			ASSERT(!"Unhandled mob family");
+			return -1;
+		}
+	}
 }
 
 
@@ -82,13 +163,12 @@ cMobProximityCounter & cMobCensus::GetProximityCounter(void)
 
 void cMobCensus::Logd()
 {
-	LOGD("Hostile mobs : %d %s", m_MobFamilyCollecter.GetNumberOfCollectedMobs(cMonster::mfHostile), IsCapped(cMonster::mfHostile) ? "(capped)" : "");
-	LOGD("Ambient mobs : %d %s", m_MobFamilyCollecter.GetNumberOfCollectedMobs(cMonster::mfAmbient), IsCapped(cMonster::mfAmbient) ? "(capped)" : "");
-	LOGD("Water mobs   : %d %s", m_MobFamilyCollecter.GetNumberOfCollectedMobs(cMonster::mfWater),   IsCapped(cMonster::mfWater)   ? "(capped)" : "");
-	LOGD("Passive mobs : %d %s", m_MobFamilyCollecter.GetNumberOfCollectedMobs(cMonster::mfPassive), IsCapped(cMonster::mfPassive) ? "(capped)" : "");
+	LOGD("Hostile mobs : %d %s", m_NumMobs[cMonster::mfHostile], IsCapped(cMonster::mfHostile) ? "(capped)" : "");
+	LOGD("Ambient mobs : %d %s", m_NumMobs[cMonster::mfAmbient], IsCapped(cMonster::mfAmbient) ? "(capped)" : "");
+	LOGD("Water mobs   : %d %s", m_NumMobs[cMonster::mfWater],   IsCapped(cMonster::mfWater)   ? "(capped)" : "");
+	LOGD("Passive mobs : %d %s", m_NumMobs[cMonster::mfPassive], IsCapped(cMonster::mfPassive) ? "(capped)" : "");
 }
 
 
 
 
-
@@ -1,56 +1,94 @@
 
 #pragma once
 
-#include "MobProximityCounter.h"
-#include "MobFamilyCollecter.h"
+#include "Mobs/Monster.h"
 
 
 
 
 // fwd:
 class cChunk;
-class cMonster;
 
 
 
 
 
-/** This class is used to collect information, for each Mob, what is the distance of the closest player
-it was first being designed in order to make mobs spawn / despawn / act
-as the behaviour and even life of mobs depends on the distance to closest player
-
-as side effect : it also collect the chunks that are elligible for spawning
-as side effect 2 : it also know the caps for mobs number and can compare census to this numbers
+/** This class keeps track of all the mobs in a world, for the spawning caps and for deciding which mobs to tick.
+Only the mobs in the chunks that are eligible for spawning (valid chunks loaded by at least one client) are counted.
+The census is persistent and maintained incrementally by cChunk as the mobs are added, removed or move between chunks,
+and as the chunks become eligible or not (clients loading / unloading them). It has its own lock, so that it can be
+updated by the parallel tick workers.
 */
 class cMobCensus
 {
 public:
-	/// Returns the nested proximity counter
-	cMobProximityCounter & GetProximityCounter(void);
-
-	// collect an elligible Chunk for Mob Spawning
-	// MG TODO : code the correct rule (not loaded chunk but short distant from players)
-	void CollectSpawnableChunk(cChunk & a_Chunk);
+	/** A counted mob and the chunk it is in */
+	struct sMobChunk
+	{
+		cMonster * m_Monster;
+		cChunk * m_Chunk;
+		
+		sMobChunk(cMonster * a_Monster, cChunk * a_Chunk) : m_Monster(a_Monster), m_Chunk(a_Chunk) {}
+	} ;
 	
-	/// Collect a mob - it's distance to player, it's family ...
-	void CollectMob(cMonster& a_Monster, cChunk& a_Chunk, double a_Distance);
-
-	/// Returns true if the family is capped (i.e. there are more mobs of this family than max)
+	typedef std::vector<sMobChunk> cMobChunkVector;
+	
+	
+	cMobCensus(void);
+	
+	/** Called when a mob is added to a chunk, either new or moving from another chunk */
+	void MobAdded(cMonster & a_Monster, cChunk & a_Chunk, bool a_IsChunkEligible);
+	
+	/** Called when a mob is removed from its chunk for good (destroyed, unloaded or moved to another world) */
+	void MobRemoved(cMonster & a_Monster);
+	
+	/** Called when a chunk becomes eligible for spawning, or stops being eligible.
+	a_Monsters are all the mobs in the chunk, which are counted or uncounted accordingly. */
+	void ChunkEligibilityChanged(cChunk & a_Chunk, const std::vector<cMonster *> & a_Monsters, bool a_IsEligible);
+	
+	/** Returns true if the family is capped (i.e. there are more mobs of this family than max) */
 	bool IsCapped(cMonster::eFamily a_MobFamily);
 	
-	/// log the results of census to server console
+	/** Returns all the counted mobs, with their chunks.
+	The returned vector is reused by the next call, so it is valid only until then; it is not affected by the mobs added or removed meanwhile.
+	Not thread-safe, only to be called from the world tick thread. */
+	const cMobChunkVector & GetCountedMobs(void);
+	
+	/** Returns the chunk the mob is counted in, or NULL if the mob is not counted (anymore) */
+	cChunk * GetCountedMobChunk(cMonster * a_Monster);
+	
+	/** log the results of census to server console */
 	void Logd(void);
 	
 protected :
-	cMobProximityCounter m_ProximityCounter;
-	cMobFamilyCollecter m_MobFamilyCollecter;
-
-	std::set<cChunk *> m_EligibleForSpawnChunks;
-
-	/// Returns the number of chunks that are elligible for spawning (for now, the loaded, valid chunks)
-	int GetNumChunks();
-
-	/// Returns the cap multiplier value of the given monster family
+	struct sMobInfo
+	{
+		cChunk * m_Chunk;
+		cMonster::eFamily m_Family;
+		bool m_IsCounted;
+	} ;
+	
+	typedef std::map<cMonster *, sMobInfo> cMobInfos;
+	
+	cCriticalSection m_CS;
+	
+	/** All the mobs in the world's chunks, counted or not */
+	cMobInfos m_Mobs;
+	
+	/** The number of counted mobs in each family */
+	int m_NumMobs[cMonster::mfMaxplusone];
+	
+	/** The number of chunks that are eligible for spawning */
+	int m_NumEligibleChunks;
+	
+	/** The buffer returned by GetCountedMobs(), kept to avoid reallocating on each tick */
+	cMobChunkVector m_CountedMobs;
+	
+	
+	/** Counts or uncounts the mob, updating the family numbers. Assumes m_CS is locked. */
+	void SetCounted(sMobInfo & a_Info, bool a_IsCounted);
+	
+	/** Returns the cap multiplier value of the given monster family */
 	static int GetCapMultiplier(cMonster::eFamily a_MobFamily);
 } ;
 
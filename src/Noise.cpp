@@ -2,6 +2,7 @@
 #include "Globals.h"  // NOTE: MSVC stupidness requires this to be the same across all modules
 
 #include "Noise.h"
+#include "NoiseKernels.h"
 
 #define FAST_FLOOR(x) (((x) < 0) ? (((int)x) - 1) : ((int)x))
 
@@ -117,7 +118,7 @@ public:
 	void Move(int a_NewFloorX, int a_NewFloorY);
 
 protected:
-	typedef NOISE_DATATYPE Workspace[4][4];
+	typedef NOISE_DATATYPE Workspace[4][4];  ///< Indexed as [y][x], so that the X-neighbors are contiguous for cNoiseKernels
 	
 	const cNoise & m_Noise;
 	
@@ -166,16 +167,11 @@ void cCubicCell2D::Generate(
 	for (int y = a_FromY; y < a_ToY; y++)
 	{
 		NOISE_DATATYPE Interp[4];
-		NOISE_DATATYPE FracY = m_FracY[y];
-		Interp[0] = cNoise::CubicInterpolate((*m_WorkRnds)[0][0], (*m_WorkRnds)[0][1], (*m_WorkRnds)[0][2], (*m_WorkRnds)[0][3], FracY);
-		Interp[1] = cNoise::CubicInterpolate((*m_WorkRnds)[1][0], (*m_WorkRnds)[1][1], (*m_WorkRnds)[1][2], (*m_WorkRnds)[1][3], FracY);
-		Interp[2] = cNoise::CubicInterpolate((*m_WorkRnds)[2][0], (*m_WorkRnds)[2][1], (*m_WorkRnds)[2][2], (*m_WorkRnds)[2][3], FracY);
-		Interp[3] = cNoise::CubicInterpolate((*m_WorkRnds)[3][0], (*m_WorkRnds)[3][1], (*m_WorkRnds)[3][2], (*m_WorkRnds)[3][3], FracY);
-		int idx = y * m_SizeX + a_FromX;
-		for (int x = a_FromX; x < a_ToX; x++)
-		{
-			m_Array[idx++] = cNoise::CubicInterpolate(Interp[0], Interp[1], Interp[2], Interp[3], m_FracX[x]);
-		}  // for x
+		cNoiseKernels::CubicInterpolateCols((*m_WorkRnds)[0], (*m_WorkRnds)[1], (*m_WorkRnds)[2], (*m_WorkRnds)[3], m_FracY[y], Interp, 4);
+		cNoiseKernels::CubicInterpolateRow(
+			Interp[0], Interp[1], Interp[2], Interp[3],
+			m_FracX + a_FromX, m_Array + y * m_SizeX + a_FromX, a_ToX - a_FromX
+		);
 	}  // for y
 }
 
@@ -187,15 +183,18 @@ void cCubicCell2D::InitWorkRnds(int a_FloorX, int a_FloorY)
 {
 	m_CurFloorX = a_FloorX;
 	m_CurFloorY = a_FloorY;
-	for (int x = 0; x < 4; x++)
+	int CoordsX[16], CoordsY[16];
+	int idx = 0;
+	for (int y = 0; y < 4; y++)
 	{
-		int cx = a_FloorX + x - 1;
-		for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 4; x++)
 		{
-			int cy = a_FloorY + y - 1;
-			(*m_WorkRnds)[x][y] = (NOISE_DATATYPE)m_Noise.IntNoise2D(cx, cy);
+			CoordsX[idx] = a_FloorX + x - 1;
+			CoordsY[idx] = a_FloorY + y - 1;
+			idx++;
 		}
 	}
+	m_Noise.IntNoise2DBatch(CoordsX, CoordsY, &((*m_WorkRnds)[0][0]), 16);
 }
 
 
@@ -210,27 +209,37 @@ void cCubicCell2D::Move(int a_NewFloorX, int a_NewFloorY)
 	Workspace * OldWorkRnds = m_WorkRnds;
 	m_WorkRnds = (m_WorkRnds == &m_Workspace1) ? &m_Workspace2 : &m_Workspace1;
 	
-	// Reuse as much of the old workspace as possible:
+	// Reuse as much of the old workspace as possible, collect the rest to be calculated in a single batch:
 	int DiffX = OldFloorX - a_NewFloorX;
 	int DiffY = OldFloorY - a_NewFloorY;
-	for (int x = 0; x < 4; x++)
+	int CoordsX[16], CoordsY[16], DstIdx[16];
+	int NumNew = 0;
+	for (int y = 0; y < 4; y++)
 	{
-		int cx = a_NewFloorX + x - 1;
-		int OldX = x - DiffX;  // Where would this X be in the old grid?
-		for (int y = 0; y < 4; y++)
+		int OldY = y - DiffY;  // Where would this Y be in the old grid?
+		for (int x = 0; x < 4; x++)
 		{
-			int cy = a_NewFloorY + y - 1;
-			int OldY = y - DiffY;  // Where would this Y be in the old grid?
+			int OldX = x - DiffX;  // Where would this X be in the old grid?
 			if ((OldX >= 0) && (OldX < 4) && (OldY >= 0) && (OldY < 4))
 			{
-				(*m_WorkRnds)[x][y] = (*OldWorkRnds)[OldX][OldY];
+				(*m_WorkRnds)[y][x] = (*OldWorkRnds)[OldY][OldX];
 			}
 			else
 			{
-				(*m_WorkRnds)[x][y] = (NOISE_DATATYPE)m_Noise.IntNoise2D(cx, cy);
+				CoordsX[NumNew] = a_NewFloorX + x - 1;
+				CoordsY[NumNew] = a_NewFloorY + y - 1;
+				DstIdx[NumNew] = y * 4 + x;
+				NumNew++;
 			}
 		}
 	}
+	NOISE_DATATYPE NewRnds[16];
+	m_Noise.IntNoise2DBatch(CoordsX, CoordsY, NewRnds, NumNew);
+	NOISE_DATATYPE * WorkRnds = &((*m_WorkRnds)[0][0]);
+	for (int i = 0; i < NumNew; i++)
+	{
+		WorkRnds[DstIdx[i]] = NewRnds[i];
+	}
 	m_CurFloorX = a_NewFloorX;
 	m_CurFloorY = a_NewFloorY;
 }
@@ -268,7 +277,7 @@ public:
 	void Move(int a_NewFloorX, int a_NewFloorY, int a_NewFloorZ);
 
 protected:
-	typedef NOISE_DATATYPE Workspace[4][4][4];
+	typedef NOISE_DATATYPE Workspace[4][4][4];  ///< Indexed as [z][y][x], so that the XY-neighbors are contiguous for cNoiseKernels
 	
 	const cNoise & m_Noise;
 	
@@ -323,28 +332,19 @@ void cCubicCell3D::Generate(
 	for (int z = a_FromZ; z < a_ToZ; z++)
 	{
 		int idxZ = z * m_SizeX * m_SizeY;
-		NOISE_DATATYPE Interp2[4][4];
-		NOISE_DATATYPE FracZ = m_FracZ[z];
-		for (int x = 0; x < 4; x++)
-		{
-			for (int y = 0; y < 4; y++)
-			{
-				Interp2[x][y] = cNoise::CubicInterpolate((*m_WorkRnds)[x][y][0], (*m_WorkRnds)[x][y][1], (*m_WorkRnds)[x][y][2], (*m_WorkRnds)[x][y][3], FracZ);
-			}
-		}
+		NOISE_DATATYPE Interp2[4][4];  // [y][x]
+		cNoiseKernels::CubicInterpolateCols(
+			&((*m_WorkRnds)[0][0][0]), &((*m_WorkRnds)[1][0][0]), &((*m_WorkRnds)[2][0][0]), &((*m_WorkRnds)[3][0][0]),
+			m_FracZ[z], &(Interp2[0][0]), 16
+		);
 		for (int y = a_FromY; y < a_ToY; y++)
 		{
 			NOISE_DATATYPE Interp[4];
-			NOISE_DATATYPE FracY = m_FracY[y];
-			Interp[0] = cNoise::CubicInterpolate(Interp2[0][0], Interp2[0][1], Interp2[0][2], Interp2[0][3], FracY);
-			Interp[1] = cNoise::CubicInterpolate(Interp2[1][0], Interp2[1][1], Interp2[1][2], Interp2[1][3], FracY);
-			Interp[2] = cNoise::CubicInterpolate(Interp2[2][0], Interp2[2][1], Interp2[2][2], Interp2[2][3], FracY);
-			Interp[3] = cNoise::CubicInterpolate(Interp2[3][0], Interp2[3][1], Interp2[3][2], Interp2[3][3], FracY);
-			int idx = idxZ + y * m_SizeX + a_FromX;
-			for (int x = a_FromX; x < a_ToX; x++)
-			{
-				m_Array[idx++] = cNoise::CubicInterpolate(Interp[0], Interp[1], Interp[2], Interp[3], m_FracX[x]);
-			}  // for x
+			cNoiseKernels::CubicInterpolateCols(Interp2[0], Interp2[1], Interp2[2], Interp2[3], m_FracY[y], Interp, 4);
+			cNoiseKernels::CubicInterpolateRow(
+				Interp[0], Interp[1], Interp[2], Interp[3],
+				m_FracX + a_FromX, m_Array + idxZ + y * m_SizeX + a_FromX, a_ToX - a_FromX
+			);
 		}  // for y
 	}  // for z
 }
@@ -358,19 +358,22 @@ void cCubicCell3D::InitWorkRnds(int a_FloorX, int a_FloorY, int a_FloorZ)
 	m_CurFloorX = a_FloorX;
 	m_CurFloorY = a_FloorY;
 	m_CurFloorZ = a_FloorZ;
-	for (int x = 0; x < 4; x++)
+	int CoordsX[64], CoordsY[64], CoordsZ[64];
+	int idx = 0;
+	for (int z = 0; z < 4; z++)
 	{
-		int cx = a_FloorX + x - 1;
 		for (int y = 0; y < 4; y++)
 		{
-			int cy = a_FloorY + y - 1;
-			for (int z = 0; z < 4; z++)
+			for (int x = 0; x < 4; x++)
 			{
-				int cz = a_FloorZ + z - 1;
-				(*m_WorkRnds)[x][y][z] = (NOISE_DATATYPE)m_Noise.IntNoise3D(cx, cy, cz);
+				CoordsX[idx] = a_FloorX + x - 1;
+				CoordsY[idx] = a_FloorY + y - 1;
+				CoordsZ[idx] = a_FloorZ + z - 1;
+				idx++;
 			}
 		}
 	}
+	m_Noise.IntNoise3DBatch(CoordsX, CoordsY, CoordsZ, &((*m_WorkRnds)[0][0][0]), 64);
 }
 
 
@@ -386,33 +389,43 @@ void cCubicCell3D::Move(int a_NewFloorX, int a_NewFloorY, int a_NewFloorZ)
 	Workspace * OldWorkRnds = m_WorkRnds;
 	m_WorkRnds = (m_WorkRnds == &m_Workspace1) ? &m_Workspace2 : &m_Workspace1;
 	
-	// Reuse as much of the old workspace as possible:
+	// Reuse as much of the old workspace as possible, collect the rest to be calculated in a single batch:
 	int DiffX = OldFloorX - a_NewFloorX;
 	int DiffY = OldFloorY - a_NewFloorY;
 	int DiffZ = OldFloorZ - a_NewFloorZ;
-	for (int x = 0; x < 4; x++)
+	int CoordsX[64], CoordsY[64], CoordsZ[64], DstIdx[64];
+	int NumNew = 0;
+	for (int z = 0; z < 4; z++)
 	{
-		int cx = a_NewFloorX + x - 1;
-		int OldX = x - DiffX;  // Where would this X be in the old grid?
+		int OldZ = z - DiffZ;  // Where would this Z be in the old grid?
 		for (int y = 0; y < 4; y++)
 		{
-			int cy = a_NewFloorY + y - 1;
 			int OldY = y - DiffY;  // Where would this Y be in the old grid?
-			for (int z = 0; z < 4; z++)
+			for (int x = 0; x < 4; x++)
 			{
-				int cz = a_NewFloorZ + z - 1;
-				int OldZ = z - DiffZ;
+				int OldX = x - DiffX;  // Where would this X be in the old grid?
 				if ((OldX >= 0) && (OldX < 4) && (OldY >= 0) && (OldY < 4) && (OldZ >= 0) && (OldZ < 4))
 				{
-					(*m_WorkRnds)[x][y][z] = (*OldWorkRnds)[OldX][OldY][OldZ];
+					(*m_WorkRnds)[z][y][x] = (*OldWorkRnds)[OldZ][OldY][OldX];
 				}
 				else
 				{
-					(*m_WorkRnds)[x][y][z] = (NOISE_DATATYPE)m_Noise.IntNoise3D(cx, cy, cz);
+					CoordsX[NumNew] = a_NewFloorX + x - 1;
+					CoordsY[NumNew] = a_NewFloorY + y - 1;
+					CoordsZ[NumNew] = a_NewFloorZ + z - 1;
+					DstIdx[NumNew] = z * 16 + y * 4 + x;
+					NumNew++;
 				}
-			}  // for z
+			}  // for x
 		}  // for y
-	}  // for x
+	}  // for z
+	NOISE_DATATYPE NewRnds[64];
+	m_Noise.IntNoise3DBatch(CoordsX, CoordsY, CoordsZ, NewRnds, NumNew);
+	NOISE_DATATYPE * WorkRnds = &((*m_WorkRnds)[0][0][0]);
+	for (int i = 0; i < NumNew; i++)
+	{
+		WorkRnds[DstIdx[i]] = NewRnds[i];
+	}
 	m_CurFloorX = a_NewFloorX;
 	m_CurFloorY = a_NewFloorY;
 	m_CurFloorZ = a_NewFloorZ;
@@ -443,6 +456,38 @@ cNoise::cNoise(const cNoise & a_Noise) :
 
 
 
+void cNoise::IntNoise2DBatch(const int * a_X, const int * a_Y, NOISE_DATATYPE * a_Out, int a_Count) const
+{
+	// Mix in the coords and seed the same way IntNoise2D() does, then let the kernel do the rest:
+	int N[64];
+	ASSERT(a_Count <= (int)ARRAYCOUNT(N));
+	for (int i = 0; i < a_Count; i++)
+	{
+		N[i] = a_X[i] + a_Y[i] * 57 + m_Seed * 57 * 57;
+	}
+	cNoiseKernels::IntNoiseFinish(N, a_Out, a_Count);
+}
+
+
+
+
+
+void cNoise::IntNoise3DBatch(const int * a_X, const int * a_Y, const int * a_Z, NOISE_DATATYPE * a_Out, int a_Count) const
+{
+	// Mix in the coords and seed the same way IntNoise3D() does, then let the kernel do the rest:
+	int N[64];
+	ASSERT(a_Count <= (int)ARRAYCOUNT(N));
+	for (int i = 0; i < a_Count; i++)
+	{
+		N[i] = a_X[i] + a_Y[i] * 57 + a_Z[i] * 57 * 57 + m_Seed * 57 * 57 * 57;
+	}
+	cNoiseKernels::IntNoiseFinish(N, a_Out, a_Count);
+}
+
+
+
+
+
 NOISE_DATATYPE cNoise::LinearNoise1D(NOISE_DATATYPE a_X) const
 {
 	int BaseX = FAST_FLOOR(a_X);
@@ -845,11 +890,7 @@ void cPerlinNoise::Generate2D(
 		a_StartX * m_Octaves.front().m_Frequency, a_EndX * m_Octaves.front().m_Frequency,
 		a_StartY * m_Octaves.front().m_Frequency, a_EndY * m_Octaves.front().m_Frequency
 	);
-	NOISE_DATATYPE Amplitude = m_Octaves.front().m_Amplitude;
-	for (int i = 0; i < ArrayCount; i++)
-	{
-		a_Array[i] *= Amplitude;
-	}
+	cNoiseKernels::SetScaled(a_Array, a_Array, m_Octaves.front().m_Amplitude, ArrayCount);
 	
 	// Add each octave:
 	for (cOctaves::const_iterator itr = m_Octaves.begin() + 1, end = m_Octaves.end(); itr != end; ++itr)
@@ -861,11 +902,7 @@ void cPerlinNoise::Generate2D(
 			a_StartY * itr->m_Frequency, a_EndY * itr->m_Frequency
 		);
 		// Add the cubic noise into the output:
-		NOISE_DATATYPE Amplitude = itr->m_Amplitude;
-		for (int i = 0; i < ArrayCount; i++)
-		{
-			a_Array[i] += a_Workspace[i] * Amplitude;
-		}
+		cNoiseKernels::AddScaled(a_Array, a_Workspace, itr->m_Amplitude, ArrayCount);
 	}
 	
 	if (ShouldFreeWorkspace)
@@ -908,11 +945,7 @@ void cPerlinNoise::Generate3D(
 		a_StartY * m_Octaves.front().m_Frequency, a_EndY * m_Octaves.front().m_Frequency,
 		a_StartZ * m_Octaves.front().m_Frequency, a_EndZ * m_Octaves.front().m_Frequency
 	);
-	NOISE_DATATYPE Amplitude = m_Octaves.front().m_Amplitude;
-	for (int i = 0; i < ArrayCount; i++)
-	{
-		a_Array[i] = a_Workspace[i] * Amplitude;
-	}
+	cNoiseKernels::SetScaled(a_Array, a_Workspace, m_Octaves.front().m_Amplitude, ArrayCount);
 	
 	// Add each octave:
 	for (cOctaves::const_iterator itr = m_Octaves.begin() + 1, end = m_Octaves.end(); itr != end; ++itr)
@@ -925,11 +958,7 @@ void cPerlinNoise::Generate3D(
 			a_StartZ * itr->m_Frequency, a_EndZ * itr->m_Frequency
 		);
 		// Add the cubic noise into the output:
-		NOISE_DATATYPE Amplitude = itr->m_Amplitude;
-		for (int i = 0; i < ArrayCount; i++)
-		{
-			a_Array[i] += a_Workspace[i] * Amplitude;
-		}
+		cNoiseKernels::AddScaled(a_Array, a_Workspace, itr->m_Amplitude, ArrayCount);
 	}
 	
 	if (ShouldFreeWorkspace)
@@ -38,6 +38,12 @@ public:
 	INLINE int IntNoise2DInt(int a_X, int a_Y) const;
 	INLINE int IntNoise3DInt(int a_X, int a_Y, int a_Z) const;
 
+	/** Calculates IntNoise2D() for each of the a_Count coords (max 64) in a_X[] and a_Y[] into a_Out[], using SIMD where available */
+	void IntNoise2DBatch(const int * a_X, const int * a_Y, NOISE_DATATYPE * a_Out, int a_Count) const;
+	
+	/** Calculates IntNoise3D() for each of the a_Count coords (max 64) in a_X[], a_Y[] and a_Z[] into a_Out[], using SIMD where available */
+	void IntNoise3DBatch(const int * a_X, const int * a_Y, const int * a_Z, NOISE_DATATYPE * a_Out, int a_Count) const;
+
 	NOISE_DATATYPE LinearNoise1D(NOISE_DATATYPE a_X) const;
 	NOISE_DATATYPE CosineNoise1D(NOISE_DATATYPE a_X) const;
 	NOISE_DATATYPE CubicNoise1D (NOISE_DATATYPE a_X) const;
@@ -0,0 +1,526 @@
+// NoiseKernels.cpp
+
+// Implements the cNoiseKernels class providing batch versions of the noise primitives, with SIMD implementations selected at runtime
+
+#include "Globals.h"
+#include "NoiseKernels.h"
+
+// Use SIMD only where the scalar code uses the SSE unit for float math, otherwise the results wouldn't be bit-identical:
+#if (defined(__GNUC__) && defined(__SSE2__) && defined(__SSE_MATH__)) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define NOISEKERNELS_SSE2
+	#include <emmintrin.h>
+
+	// AVX2 kernels need compiler support for per-function target ISA (gcc, clang) or the intrinsics without special flags (MSVC 2012+):
+	#if (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))) || defined(__clang__) || (defined(_MSC_VER) && (_MSC_VER >= 1700))
+		#define NOISEKERNELS_AVX2
+		#include <immintrin.h>
+		#ifdef _MSC_VER
+			#include <intrin.h>
+			#define NOISEKERNELS_TARGET_AVX2
+		#else
+			#define NOISEKERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+		#endif
+	#endif
+#endif
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scalar kernels:
+
+static void ScalarCubicInterpolateRow(
+	NOISE_DATATYPE a_A, NOISE_DATATYPE a_B, NOISE_DATATYPE a_C, NOISE_DATATYPE a_D,
+	const NOISE_DATATYPE * a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	for (int i = 0; i < a_Count; i++)
+	{
+		a_Out[i] = cNoise::CubicInterpolate(a_A, a_B, a_C, a_D, a_Pct[i]);
+	}
+}
+
+
+
+
+
+static void ScalarCubicInterpolateCols(
+	const NOISE_DATATYPE * a_A, const NOISE_DATATYPE * a_B, const NOISE_DATATYPE * a_C, const NOISE_DATATYPE * a_D,
+	NOISE_DATATYPE a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	for (int i = 0; i < a_Count; i++)
+	{
+		a_Out[i] = cNoise::CubicInterpolate(a_A[i], a_B[i], a_C[i], a_D[i], a_Pct);
+	}
+}
+
+
+
+
+
+static void ScalarIntNoiseFinish(const int * a_N, NOISE_DATATYPE * a_Out, int a_Count)
+{
+	for (int i = 0; i < a_Count; i++)
+	{
+		int n = a_N[i];
+		n = (n << 13) ^ n;
+		a_Out[i] = (1 - (NOISE_DATATYPE)((n * (n * n * 15731 + 789221) + 1376312589) & 0x7fffffff) / 1073741824);
+	}
+}
+
+
+
+
+
+static void ScalarAddScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	for (int i = 0; i < a_Count; i++)
+	{
+		a_Dst[i] += a_Src[i] * a_Amplitude;
+	}
+}
+
+
+
+
+
+static void ScalarSetScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	for (int i = 0; i < a_Count; i++)
+	{
+		a_Dst[i] = a_Src[i] * a_Amplitude;
+	}
+}
+
+
+
+
+
+static const cNoiseKernels::sKernels g_ScalarKernels =
+{
+	ScalarCubicInterpolateRow,
+	ScalarCubicInterpolateCols,
+	ScalarIntNoiseFinish,
+	ScalarAddScaled,
+	ScalarSetScaled,
+} ;
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SSE2 kernels:
+
+#ifdef NOISEKERNELS_SSE2
+
+/** Multiplies the packed 32-bit ints, keeping the low 32 bits of each product (SSE2 has no pmulld) */
+static inline __m128i SSE2MulLo32(__m128i a_A, __m128i a_B)
+{
+	__m128i Even = _mm_mul_epu32(a_A, a_B);
+	__m128i Odd  = _mm_mul_epu32(_mm_srli_epi64(a_A, 32), _mm_srli_epi64(a_B, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(Even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(Odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+
+
+
+
+static void SSE2CubicInterpolateRow(
+	NOISE_DATATYPE a_A, NOISE_DATATYPE a_B, NOISE_DATATYPE a_C, NOISE_DATATYPE a_D,
+	const NOISE_DATATYPE * a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	// The coefficients are the same for the whole row, calculate them the same way cNoise::CubicInterpolate() does:
+	NOISE_DATATYPE P = (a_D - a_C) - (a_A - a_B);
+	NOISE_DATATYPE Q = (a_A - a_B) - P;
+	NOISE_DATATYPE R = a_C - a_A;
+	__m128 vP = _mm_set1_ps(P);
+	__m128 vQ = _mm_set1_ps(Q);
+	__m128 vR = _mm_set1_ps(R);
+	__m128 vS = _mm_set1_ps(a_B);
+	int i = 0;
+	for (; i + 4 <= a_Count; i += 4)
+	{
+		__m128 t = _mm_loadu_ps(a_Pct + i);
+		__m128 res = _mm_add_ps(_mm_mul_ps(vP, t), vQ);
+		res = _mm_add_ps(_mm_mul_ps(res, t), vR);
+		res = _mm_add_ps(_mm_mul_ps(res, t), vS);
+		_mm_storeu_ps(a_Out + i, res);
+	}
+	for (; i < a_Count; i++)
+	{
+		a_Out[i] = cNoise::CubicInterpolate(a_A, a_B, a_C, a_D, a_Pct[i]);
+	}
+}
+
+
+
+
+
+static void SSE2CubicInterpolateCols(
+	const NOISE_DATATYPE * a_A, const NOISE_DATATYPE * a_B, const NOISE_DATATYPE * a_C, const NOISE_DATATYPE * a_D,
+	NOISE_DATATYPE a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	__m128 t = _mm_set1_ps(a_Pct);
+	int i = 0;
+	for (; i + 4 <= a_Count; i += 4)
+	{
+		__m128 A = _mm_loadu_ps(a_A + i);
+		__m128 B = _mm_loadu_ps(a_B + i);
+		__m128 C = _mm_loadu_ps(a_C + i);
+		__m128 D = _mm_loadu_ps(a_D + i);
+		__m128 AB = _mm_sub_ps(A, B);
+		__m128 P = _mm_sub_ps(_mm_sub_ps(D, C), AB);
+		__m128 Q = _mm_sub_ps(AB, P);
+		__m128 R = _mm_sub_ps(C, A);
+		__m128 res = _mm_add_ps(_mm_mul_ps(P, t), Q);
+		res = _mm_add_ps(_mm_mul_ps(res, t), R);
+		res = _mm_add_ps(_mm_mul_ps(res, t), B);
+		_mm_storeu_ps(a_Out + i, res);
+	}
+	for (; i < a_Count; i++)
+	{
+		a_Out[i] = cNoise::CubicInterpolate(a_A[i], a_B[i], a_C[i], a_D[i], a_Pct);
+	}
+}
+
+
+
+
+
+static void SSE2IntNoiseFinish(const int * a_N, NOISE_DATATYPE * a_Out, int a_Count)
+{
+	const __m128i c15731      = _mm_set1_epi32(15731);
+	const __m128i c789221     = _mm_set1_epi32(789221);
+	const __m128i c1376312589 = _mm_set1_epi32(1376312589);
+	const __m128i cMask       = _mm_set1_epi32(0x7fffffff);
+	const __m128  cOne        = _mm_set1_ps(1);
+	const __m128  cScale      = _mm_set1_ps(1.0f / 1073741824);  // Exact power of two, same result as dividing
+	int i = 0;
+	for (; i + 4 <= a_Count; i += 4)
+	{
+		__m128i n = _mm_loadu_si128((const __m128i *)(a_N + i));
+		n = _mm_xor_si128(_mm_slli_epi32(n, 13), n);
+		__m128i Inner = _mm_add_epi32(SSE2MulLo32(SSE2MulLo32(n, n), c15731), c789221);
+		__m128i r = _mm_and_si128(_mm_add_epi32(SSE2MulLo32(n, Inner), c1376312589), cMask);
+		_mm_storeu_ps(a_Out + i, _mm_sub_ps(cOne, _mm_mul_ps(_mm_cvtepi32_ps(r), cScale)));
+	}
+	ScalarIntNoiseFinish(a_N + i, a_Out + i, a_Count - i);
+}
+
+
+
+
+
+static void SSE2AddScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	__m128 Amp = _mm_set1_ps(a_Amplitude);
+	int i = 0;
+	for (; i + 4 <= a_Count; i += 4)
+	{
+		_mm_storeu_ps(a_Dst + i, _mm_add_ps(_mm_loadu_ps(a_Dst + i), _mm_mul_ps(_mm_loadu_ps(a_Src + i), Amp)));
+	}
+	ScalarAddScaled(a_Dst + i, a_Src + i, a_Amplitude, a_Count - i);
+}
+
+
+
+
+
+static void SSE2SetScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	__m128 Amp = _mm_set1_ps(a_Amplitude);
+	int i = 0;
+	for (; i + 4 <= a_Count; i += 4)
+	{
+		_mm_storeu_ps(a_Dst + i, _mm_mul_ps(_mm_loadu_ps(a_Src + i), Amp));
+	}
+	ScalarSetScaled(a_Dst + i, a_Src + i, a_Amplitude, a_Count - i);
+}
+
+
+
+
+
+static const cNoiseKernels::sKernels g_SSE2Kernels =
+{
+	SSE2CubicInterpolateRow,
+	SSE2CubicInterpolateCols,
+	SSE2IntNoiseFinish,
+	SSE2AddScaled,
+	SSE2SetScaled,
+} ;
+
+#endif  // NOISEKERNELS_SSE2
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2 kernels:
+// These process 8 values at a time and leave the remainder to the SSE2 kernels
+// The upper halves of the YMM registers need to be cleared before calling the non-VEX SSE2 code, otherwise
+// there's a huge penalty for the transition; the compiler doesn't do that for tail calls by itself
+
+#ifdef NOISEKERNELS_AVX2
+
+NOISEKERNELS_TARGET_AVX2 static void AVX2CubicInterpolateRow(
+	NOISE_DATATYPE a_A, NOISE_DATATYPE a_B, NOISE_DATATYPE a_C, NOISE_DATATYPE a_D,
+	const NOISE_DATATYPE * a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	NOISE_DATATYPE P = (a_D - a_C) - (a_A - a_B);
+	NOISE_DATATYPE Q = (a_A - a_B) - P;
+	NOISE_DATATYPE R = a_C - a_A;
+	__m256 vP = _mm256_set1_ps(P);
+	__m256 vQ = _mm256_set1_ps(Q);
+	__m256 vR = _mm256_set1_ps(R);
+	__m256 vS = _mm256_set1_ps(a_B);
+	int i = 0;
+	for (; i + 8 <= a_Count; i += 8)
+	{
+		// NOTE: No FMA here, the scalar code does a separate multiply and add
+		__m256 t = _mm256_loadu_ps(a_Pct + i);
+		__m256 res = _mm256_add_ps(_mm256_mul_ps(vP, t), vQ);
+		res = _mm256_add_ps(_mm256_mul_ps(res, t), vR);
+		res = _mm256_add_ps(_mm256_mul_ps(res, t), vS);
+		_mm256_storeu_ps(a_Out + i, res);
+	}
+	_mm256_zeroupper();
+	SSE2CubicInterpolateRow(a_A, a_B, a_C, a_D, a_Pct + i, a_Out + i, a_Count - i);
+}
+
+
+
+
+
+NOISEKERNELS_TARGET_AVX2 static void AVX2CubicInterpolateCols(
+	const NOISE_DATATYPE * a_A, const NOISE_DATATYPE * a_B, const NOISE_DATATYPE * a_C, const NOISE_DATATYPE * a_D,
+	NOISE_DATATYPE a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+)
+{
+	__m256 t = _mm256_set1_ps(a_Pct);
+	int i = 0;
+	for (; i + 8 <= a_Count; i += 8)
+	{
+		__m256 A = _mm256_loadu_ps(a_A + i);
+		__m256 B = _mm256_loadu_ps(a_B + i);
+		__m256 C = _mm256_loadu_ps(a_C + i);
+		__m256 D = _mm256_loadu_ps(a_D + i);
+		__m256 AB = _mm256_sub_ps(A, B);
+		__m256 P = _mm256_sub_ps(_mm256_sub_ps(D, C), AB);
+		__m256 Q = _mm256_sub_ps(AB, P);
+		__m256 R = _mm256_sub_ps(C, A);
+		__m256 res = _mm256_add_ps(_mm256_mul_ps(P, t), Q);
+		res = _mm256_add_ps(_mm256_mul_ps(res, t), R);
+		res = _mm256_add_ps(_mm256_mul_ps(res, t), B);
+		_mm256_storeu_ps(a_Out + i, res);
+	}
+	_mm256_zeroupper();
+	SSE2CubicInterpolateCols(a_A + i, a_B + i, a_C + i, a_D + i, a_Pct, a_Out + i, a_Count - i);
+}
+
+
+
+
+
+NOISEKERNELS_TARGET_AVX2 static void AVX2IntNoiseFinish(const int * a_N, NOISE_DATATYPE * a_Out, int a_Count)
+{
+	const __m256i c15731      = _mm256_set1_epi32(15731);
+	const __m256i c789221     = _mm256_set1_epi32(789221);
+	const __m256i c1376312589 = _mm256_set1_epi32(1376312589);
+	const __m256i cMask       = _mm256_set1_epi32(0x7fffffff);
+	const __m256  cOne        = _mm256_set1_ps(1);
+	const __m256  cScale      = _mm256_set1_ps(1.0f / 1073741824);  // Exact power of two, same result as dividing
+	int i = 0;
+	for (; i + 8 <= a_Count; i += 8)
+	{
+		__m256i n = _mm256_loadu_si256((const __m256i *)(a_N + i));
+		n = _mm256_xor_si256(_mm256_slli_epi32(n, 13), n);
+		__m256i Inner = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(n, n), c15731), c789221);
+		__m256i r = _mm256_and_si256(_mm256_add_epi32(_mm256_mullo_epi32(n, Inner), c1376312589), cMask);
+		_mm256_storeu_ps(a_Out + i, _mm256_sub_ps(cOne, _mm256_mul_ps(_mm256_cvtepi32_ps(r), cScale)));
+	}
+	_mm256_zeroupper();
+	SSE2IntNoiseFinish(a_N + i, a_Out + i, a_Count - i);
+}
+
+
+
+
+
+NOISEKERNELS_TARGET_AVX2 static void AVX2AddScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	__m256 Amp = _mm256_set1_ps(a_Amplitude);
+	int i = 0;
+	for (; i + 8 <= a_Count; i += 8)
+	{
+		_mm256_storeu_ps(a_Dst + i, _mm256_add_ps(_mm256_loadu_ps(a_Dst + i), _mm256_mul_ps(_mm256_loadu_ps(a_Src + i), Amp)));
+	}
+	_mm256_zeroupper();
+	SSE2AddScaled(a_Dst + i, a_Src + i, a_Amplitude, a_Count - i);
+}
+
+
+
+
+
+NOISEKERNELS_TARGET_AVX2 static void AVX2SetScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+{
+	__m256 Amp = _mm256_set1_ps(a_Amplitude);
+	int i = 0;
+	for (; i + 8 <= a_Count; i += 8)
+	{
+		_mm256_storeu_ps(a_Dst + i, _mm256_mul_ps(_mm256_loadu_ps(a_Src + i), Amp));
+	}
+	_mm256_zeroupper();
+	SSE2SetScaled(a_Dst + i, a_Src + i, a_Amplitude, a_Count - i);
+}
+
+
+
+
+
+static const cNoiseKernels::sKernels g_AVX2Kernels =
+{
+	AVX2CubicInterpolateRow,
+	AVX2CubicInterpolateCols,
+	AVX2IntNoiseFinish,
+	AVX2AddScaled,
+	AVX2SetScaled,
+} ;
+
+
+
+
+
+/** Returns true if both the CPU and the OS support AVX2 */
+static bool HasCPUAVX2(void)
+{
+	#ifdef _MSC_VER
+		int Info[4];
+		__cpuid(Info, 0);
+		if (Info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(Info, 1);
+		const int OSXSAVE = 1 << 27;
+		const int AVX = 1 << 28;
+		if ((Info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX))
+		{
+			return false;
+		}
+		if ((_xgetbv(0) & 6) != 6)
+		{
+			// The OS doesn't save the YMM registers on context switches
+			return false;
+		}
+		__cpuidex(Info, 7, 0);
+		return ((Info[1] & (1 << 5)) != 0);
+	#else
+		__builtin_cpu_init();
+		return (__builtin_cpu_supports("avx2") != 0);
+	#endif
+}
+
+#endif  // NOISEKERNELS_AVX2
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cNoiseKernels:
+
+const cNoiseKernels::sKernels * cNoiseKernels::s_Kernels = &g_ScalarKernels;
+cNoiseKernels::eImpl cNoiseKernels::s_Impl = cNoiseKernels::implScalar;
+
+
+
+
+
+/** Selects the best implementation on startup */
+static class cNoiseKernelsInitializer
+{
+public:
+	cNoiseKernelsInitializer(void)
+	{
+		if (!cNoiseKernels::SetImpl(cNoiseKernels::implAVX2))
+		{
+			cNoiseKernels::SetImpl(cNoiseKernels::implSSE2);
+		}
+	}
+} g_NoiseKernelsInitializer;
+
+
+
+
+
+const char * cNoiseKernels::GetImplName(eImpl a_Impl)
+{
+	switch (a_Impl)
+	{
+		case implScalar: return "scalar";
+		case implSSE2:   return "SSE2";
+		case implAVX2:   return "AVX2";
+	}
+	return "unknown";
+}
+
+
+
+
+
+bool cNoiseKernels::IsImplSupported(eImpl a_Impl)
+{
+	switch (a_Impl)
+	{
+		case implScalar: return true;
+		#ifdef NOISEKERNELS_SSE2
+		case implSSE2:   return true;
+		#endif
+		#ifdef NOISEKERNELS_AVX2
+		case implAVX2:
+		{
+			static const bool HasAVX2 = HasCPUAVX2();
+			return HasAVX2;
+		}
+		#endif
+		default: return false;
+	}
+}
+
+
+
+
+
+bool cNoiseKernels::SetImpl(eImpl a_Impl)
+{
+	if (!IsImplSupported(a_Impl))
+	{
+		return false;
+	}
+	switch (a_Impl)
+	{
+		case implScalar: s_Kernels = &g_ScalarKernels; break;
+		#ifdef NOISEKERNELS_SSE2
+		case implSSE2:   s_Kernels = &g_SSE2Kernels;   break;
+		#endif
+		#ifdef NOISEKERNELS_AVX2
+		case implAVX2:   s_Kernels = &g_AVX2Kernels;   break;
+		#endif
+		default: return false;
+	}
+	s_Impl = a_Impl;
+	return true;
+}
+
+
+
+
@@ -0,0 +1,115 @@
+// NoiseKernels.h
+
+// Declares the cNoiseKernels class providing batch versions of the noise primitives, with SIMD implementations selected at runtime
+
+/*
+The noise generators spend most of their time in cNoise::IntNoise*() and cNoise::CubicInterpolate(). The kernels in
+this class evaluate these for whole arrays of values at once. There are three implementations:
+	- scalar, using the very same inline functions as the rest of cNoise
+	- SSE2, always available on x64, and on x86 if the compiler is set to use SSE2 for the floating-point math
+	- AVX2, compiled in only when the compiler supports it, and used only if the CPU reports support for it
+The best available implementation is selected on startup using CPU feature detection.
+
+All the implementations produce bit-identical output: the SIMD code performs exactly the same float operations,
+in the same order, as the scalar code. This relies on the compiler not contracting the scalar multiply-adds into FMA
+instructions (the default for targets without FMA) and not using x87 extended precision (hence no SIMD on x87 builds).
+tests/NoiseTest verifies the equivalence.
+*/
+
+
+
+
+
+#pragma once
+
+#include "Noise.h"
+
+
+
+
+
+class cNoiseKernels
+{
+public:
+	enum eImpl
+	{
+		implScalar = 0,
+		implSSE2   = 1,
+		implAVX2   = 2,
+	} ;
+
+
+	/** Returns the implementation that is currently used */
+	static eImpl GetImpl(void) { return s_Impl; }
+
+	/** Returns the name of the specified implementation, for logging */
+	static const char * GetImplName(eImpl a_Impl);
+
+	/** Returns true if the specified implementation is compiled in and supported by the CPU */
+	static bool IsImplSupported(eImpl a_Impl);
+
+	/** Switches to the specified implementation, if supported; returns true if successful.
+	Used mainly by tests for comparing the implementations. Not thread-safe, call only when no noise is being generated. */
+	static bool SetImpl(eImpl a_Impl);
+
+
+	/** a_Out[i] = cNoise::CubicInterpolate(a_A, a_B, a_C, a_D, a_Pct[i]), for i in [0, a_Count) */
+	static void CubicInterpolateRow(
+		NOISE_DATATYPE a_A, NOISE_DATATYPE a_B, NOISE_DATATYPE a_C, NOISE_DATATYPE a_D,
+		const NOISE_DATATYPE * a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+	)
+	{
+		s_Kernels->m_CubicInterpolateRow(a_A, a_B, a_C, a_D, a_Pct, a_Out, a_Count);
+	}
+
+	/** a_Out[i] = cNoise::CubicInterpolate(a_A[i], a_B[i], a_C[i], a_D[i], a_Pct), for i in [0, a_Count) */
+	static void CubicInterpolateCols(
+		const NOISE_DATATYPE * a_A, const NOISE_DATATYPE * a_B, const NOISE_DATATYPE * a_C, const NOISE_DATATYPE * a_D,
+		NOISE_DATATYPE a_Pct, NOISE_DATATYPE * a_Out, int a_Count
+	)
+	{
+		s_Kernels->m_CubicInterpolateCols(a_A, a_B, a_C, a_D, a_Pct, a_Out, a_Count);
+	}
+
+	/** Finishes the IntNoise calculation for already mixed-in coords and seed:
+	a_Out[i] = the value cNoise::IntNoise2D() / IntNoise3D() returns when their "n" is a_N[i], for i in [0, a_Count) */
+	static void IntNoiseFinish(const int * a_N, NOISE_DATATYPE * a_Out, int a_Count)
+	{
+		s_Kernels->m_IntNoiseFinish(a_N, a_Out, a_Count);
+	}
+
+	/** a_Dst[i] += a_Src[i] * a_Amplitude, for i in [0, a_Count) */
+	static void AddScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+	{
+		s_Kernels->m_AddScaled(a_Dst, a_Src, a_Amplitude, a_Count);
+	}
+
+	/** a_Dst[i] = a_Src[i] * a_Amplitude, for i in [0, a_Count); a_Dst may be the same as a_Src */
+	static void SetScaled(NOISE_DATATYPE * a_Dst, const NOISE_DATATYPE * a_Src, NOISE_DATATYPE a_Amplitude, int a_Count)
+	{
+		s_Kernels->m_SetScaled(a_Dst, a_Src, a_Amplitude, a_Count);
+	}
+
+
+	/** The table of kernel functions of one implementation */
+	struct sKernels
+	{
+		void (*m_CubicInterpolateRow)(NOISE_DATATYPE, NOISE_DATATYPE, NOISE_DATATYPE, NOISE_DATATYPE, const NOISE_DATATYPE *, NOISE_DATATYPE *, int);
+		void (*m_CubicInterpolateCols)(const NOISE_DATATYPE *, const NOISE_DATATYPE *, const NOISE_DATATYPE *, const NOISE_DATATYPE *, NOISE_DATATYPE, NOISE_DATATYPE *, int);
+		void (*m_IntNoiseFinish)(const int *, NOISE_DATATYPE *, int);
+		void (*m_AddScaled)(NOISE_DATATYPE *, const NOISE_DATATYPE *, NOISE_DATATYPE, int);
+		void (*m_SetScaled)(NOISE_DATATYPE *, const NOISE_DATATYPE *, NOISE_DATATYPE, int);
+	} ;
+
+protected:
+
+	/** The kernels currently in use. Statically initialized to the scalar ones, upgraded on startup */
+	static const sKernels * s_Kernels;
+
+	/** The implementation currently in use */
+	static eImpl s_Impl;
+} ;
+
+
+
+
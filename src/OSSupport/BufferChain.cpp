@@ -0,0 +1,290 @@
+
+// BufferChain.cpp
+
+// Implements the cBufferChain class representing a queue of outgoing data stored in pooled, reference-counted blocks
+
+#include "Globals.h"
+#include "BufferChain.h"
+
+
+
+
+
+/** Protects the pool and all the blocks' refcounts */
+static cCriticalSection g_CSPool;
+
+/** The free blocks, ready to be reused */
+static std::vector<void *> g_FreeBlocks;
+
+/** Number of blocks currently allocated from the OS, free or used */
+static int g_NumAllocatedBlocks = 0;
+
+
+
+
+
+cBufferChain::cBufferChain(void) :
+	m_Size(0),
+	m_NumBytesCopied(0),
+	m_CanAppendToLast(false)
+{
+}
+
+
+
+
+
+cBufferChain::cBufferChain(const cBufferChain & a_Other) :
+	m_Blocks(a_Other.m_Blocks),
+	m_Size(a_Other.m_Size),
+	m_NumBytesCopied(0),
+	m_CanAppendToLast(false)
+{
+	AddRefs(m_Blocks);
+	a_Other.m_CanAppendToLast = false;
+}
+
+
+
+
+
+cBufferChain::~cBufferChain()
+{
+	Clear();
+}
+
+
+
+
+
+cBufferChain & cBufferChain::operator =(const cBufferChain & a_Other)
+{
+	if (&a_Other == this)
+	{
+		return *this;
+	}
+	AddRefs(a_Other.m_Blocks);
+	Clear();
+	m_Blocks = a_Other.m_Blocks;
+	m_Size = a_Other.m_Size;
+	m_CanAppendToLast = false;
+	a_Other.m_CanAppendToLast = false;
+	return *this;
+}
+
+
+
+
+
+void cBufferChain::Append(const char * a_Data, size_t a_Size, cTransform * a_Transform)
+{
+	while (a_Size > 0)
+	{
+		if (!m_CanAppendToLast || (m_Blocks.back().m_End >= sizeof(m_Blocks.back().m_Block->m_Data)))
+		{
+			sBlockRef Ref;
+			Ref.m_Block = AllocBlock();
+			Ref.m_Start = 0;
+			Ref.m_End = 0;
+			m_Blocks.push_back(Ref);
+			m_CanAppendToLast = true;
+		}
+		sBlockRef & Last = m_Blocks.back();
+		size_t NumBytes = std::min(a_Size, sizeof(Last.m_Block->m_Data) - Last.m_End);
+		char * Dest = Last.m_Block->m_Data + Last.m_End;
+		if (a_Transform != NULL)
+		{
+			a_Transform->Transform((Byte *)Dest, (const Byte *)a_Data, NumBytes);
+		}
+		else
+		{
+			memcpy(Dest, a_Data, NumBytes);
+		}
+		Last.m_End += NumBytes;
+		m_Size += NumBytes;
+		m_NumBytesCopied += NumBytes;
+		a_Data += NumBytes;
+		a_Size -= NumBytes;
+	}
+}
+
+
+
+
+
+void cBufferChain::Splice(cBufferChain & a_Other)
+{
+	if (a_Other.m_Blocks.empty())
+	{
+		return;
+	}
+	if (m_Blocks.empty())
+	{
+		std::swap(m_Blocks, a_Other.m_Blocks);
+	}
+	else
+	{
+		m_Blocks.insert(m_Blocks.end(), a_Other.m_Blocks.begin(), a_Other.m_Blocks.end());
+		a_Other.m_Blocks.clear();
+	}
+	m_Size += a_Other.m_Size;
+	m_CanAppendToLast = a_Other.m_CanAppendToLast;
+	a_Other.m_Size = 0;
+	a_Other.m_CanAppendToLast = false;
+}
+
+
+
+
+
+int cBufferChain::GetSpans(sSpan * a_Spans, int a_MaxSpans) const
+{
+	int NumSpans = 0;
+	for (cBlockRefs::const_iterator itr = m_Blocks.begin(), end = m_Blocks.end(); (itr != end) && (NumSpans < a_MaxSpans); ++itr)
+	{
+		if (itr->m_End == itr->m_Start)
+		{
+			continue;
+		}
+		a_Spans[NumSpans].m_Data = itr->m_Block->m_Data + itr->m_Start;
+		a_Spans[NumSpans].m_Size = itr->m_End - itr->m_Start;
+		NumSpans++;
+	}
+	return NumSpans;
+}
+
+
+
+
+
+void cBufferChain::Consume(size_t a_Size)
+{
+	ASSERT(a_Size <= m_Size);
+	a_Size = std::min(a_Size, m_Size);
+	m_Size -= a_Size;
+	while (a_Size > 0)
+	{
+		sBlockRef & First = m_Blocks.front();
+		size_t NumBytes = std::min(a_Size, First.m_End - First.m_Start);
+		First.m_Start += NumBytes;
+		a_Size -= NumBytes;
+		if ((First.m_Start == First.m_End) && ((m_Blocks.size() > 1) || !m_CanAppendToLast))
+		{
+			// The block is used up and won't be appended to anymore:
+			ReleaseBlock(First.m_Block);
+			m_Blocks.pop_front();
+		}
+	}
+}
+
+
+
+
+
+void cBufferChain::Clear(void)
+{
+	for (cBlockRefs::iterator itr = m_Blocks.begin(), end = m_Blocks.end(); itr != end; ++itr)
+	{
+		ReleaseBlock(itr->m_Block);
+	}
+	m_Blocks.clear();
+	m_Size = 0;
+	m_CanAppendToLast = false;
+}
+
+
+
+
+
+void cBufferChain::ReadAll(AString & a_Data) const
+{
+	a_Data.clear();
+	a_Data.reserve(m_Size);
+	for (cBlockRefs::const_iterator itr = m_Blocks.begin(), end = m_Blocks.end(); itr != end; ++itr)
+	{
+		a_Data.append(itr->m_Block->m_Data + itr->m_Start, itr->m_End - itr->m_Start);
+	}
+}
+
+
+
+
+
+void cBufferChain::GetPoolStats(int & a_NumAllocated, int & a_NumFree)
+{
+	cCSLock Lock(g_CSPool);
+	a_NumAllocated = g_NumAllocatedBlocks;
+	a_NumFree = (int)g_FreeBlocks.size();
+}
+
+
+
+
+
+cBufferChain::sBlock * cBufferChain::AllocBlock(void)
+{
+	sBlock * Block = NULL;
+	{
+		cCSLock Lock(g_CSPool);
+		if (!g_FreeBlocks.empty())
+		{
+			Block = (sBlock *)g_FreeBlocks.back();
+			g_FreeBlocks.pop_back();
+		}
+		else
+		{
+			g_NumAllocatedBlocks += 1;
+		}
+	}
+	if (Block == NULL)
+	{
+		Block = new sBlock;
+	}
+	Block->m_RefCount = 1;
+	return Block;
+}
+
+
+
+
+
+void cBufferChain::AddRefs(const cBlockRefs & a_Blocks)
+{
+	if (a_Blocks.empty())
+	{
+		return;
+	}
+	cCSLock Lock(g_CSPool);
+	for (cBlockRefs::const_iterator itr = a_Blocks.begin(), end = a_Blocks.end(); itr != end; ++itr)
+	{
+		itr->m_Block->m_RefCount += 1;
+	}
+}
+
+
+
+
+
+void cBufferChain::ReleaseBlock(sBlock * a_Block)
+{
+	{
+		cCSLock Lock(g_CSPool);
+		ASSERT(a_Block->m_RefCount > 0);
+		a_Block->m_RefCount -= 1;
+		if (a_Block->m_RefCount > 0)
+		{
+			return;
+		}
+		if ((int)g_FreeBlocks.size() < MAX_FREE_BLOCKS)
+		{
+			g_FreeBlocks.push_back(a_Block);
+			return;
+		}
+		g_NumAllocatedBlocks -= 1;
+	}
+	delete a_Block;
+}
+
+
+
+
@@ -0,0 +1,139 @@
+
+// BufferChain.h
+
+// Declares the cBufferChain class representing a queue of outgoing data stored in pooled, reference-counted blocks
+
+/*
+The outgoing network data is appended to a chain of fixed-size blocks, taken from a process-wide pool and returned
+to it when consumed. The data is copied only once, when it is appended; it may be transformed (encrypted) during that
+copy. Handing the data over to another chain (from a client to its socket thread) moves the blocks without copying,
+and the socket thread sends the blocks directly, using a single vectored send for multiple blocks.
+The blocks are reference-counted, so a chain can be copied cheaply: both copies refer to the same blocks, and neither
+appends into a shared block anymore (appends continue in a new block). The reference counts are manipulated under the
+pool's lock, so the chains sharing blocks may be used from different threads; a single chain is not thread-safe.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cBufferChain
+{
+public:
+	/** Transforms the data while it is being appended, such as encrypting it */
+	class cTransform
+	{
+	public:
+		// Force a virtual destructor in all descendants:
+		virtual ~cTransform() {}
+
+		/** Transforms a_Size bytes of a_In into a_Out; the buffers don't overlap */
+		virtual void Transform(Byte * a_Out, const Byte * a_In, size_t a_Size) = 0;
+	} ;
+
+	/** A contiguous part of the chain's data, as returned by GetSpans() */
+	struct sSpan
+	{
+		const char * m_Data;
+		size_t m_Size;
+	} ;
+
+	/** Size of a single block, including its header */
+	static const size_t BLOCK_SIZE = 16 KiB;
+
+	/** Maximum number of free blocks kept in the pool, the rest are freed */
+	static const int MAX_FREE_BLOCKS = 1024;
+
+
+	cBufferChain(void);
+
+	/** Shares the blocks of a_Other, no data is copied */
+	cBufferChain(const cBufferChain & a_Other);
+
+	~cBufferChain();
+
+	/** Shares the blocks of a_Other, no data is copied */
+	cBufferChain & operator =(const cBufferChain & a_Other);
+
+	/** Copies the data to the end of the chain, transforming it by a_Transform on the way if not NULL */
+	void Append(const char * a_Data, size_t a_Size, cTransform * a_Transform = NULL);
+
+	/** Copies the data to the end of the chain */
+	void Append(const AString & a_Data) { Append(a_Data.data(), a_Data.size()); }
+
+	/** Moves all the data of a_Other to the end of this chain, without copying; a_Other is left empty */
+	void Splice(cBufferChain & a_Other);
+
+	/** Returns the number of bytes in the chain */
+	size_t GetSize(void) const { return m_Size; }
+
+	/** Returns the total number of bytes copied into this chain by Append(); the blocks moved in by Splice() are not counted */
+	Int64 GetNumBytesCopied(void) const { return m_NumBytesCopied; }
+
+	bool IsEmpty(void) const { return (m_Size == 0); }
+
+	/** Fills a_Spans with the contiguous parts of the data, from the front; returns the number of spans filled (at most a_MaxSpans) */
+	int GetSpans(sSpan * a_Spans, int a_MaxSpans) const;
+
+	/** Removes a_Size bytes from the front of the chain, releasing the blocks that are no longer used */
+	void Consume(size_t a_Size);
+
+	/** Removes all the data */
+	void Clear(void);
+
+	/** Copies all the data into a_Data (overwrites); meant for logging and tests */
+	void ReadAll(AString & a_Data) const;
+
+	/** Returns the number of blocks allocated by the pool in total, and how many of them are free */
+	static void GetPoolStats(int & a_NumAllocated, int & a_NumFree);
+
+protected:
+	/** A single pooled block; the data area follows the header */
+	struct sBlock
+	{
+		int m_RefCount;
+		char m_Data[BLOCK_SIZE - sizeof(int)];
+	} ;
+
+	/** A range of data in a block that belongs to this chain */
+	struct sBlockRef
+	{
+		sBlock * m_Block;
+		size_t m_Start;
+		size_t m_End;
+	} ;
+
+	typedef std::deque<sBlockRef> cBlockRefs;
+
+	cBlockRefs m_Blocks;
+
+	/** Total size of the data in m_Blocks */
+	size_t m_Size;
+
+	/** Total number of bytes copied into this chain by Append(), over the chain's lifetime */
+	Int64 m_NumBytesCopied;
+
+	/** True if the last block belongs to this chain only, so that more data can be appended into it.
+	Mutable, because copying the chain shares the block and so resets this in the source, too. */
+	mutable bool m_CanAppendToLast;
+
+
+	/** Takes a block from the pool, with its refcount set to 1 */
+	static sBlock * AllocBlock(void);
+
+	/** Adds a reference to all the blocks in a_Blocks */
+	static void AddRefs(const cBlockRefs & a_Blocks);
+
+	/** Releases a reference to the block, returning it to the pool when unused */
+	static void ReleaseBlock(sBlock * a_Block);
+} ;
+
+
+
+
@@ -6,6 +6,13 @@
 #include "Globals.h"
 #include "ListenThread.h"
 
+// On Linux, wait for the listening sockets using epoll, same as cSocketThreads does for the client sockets:
+#if defined(__linux__) && !defined(SOCKETTHREADS_USE_SELECT)
+	#define LISTENTHREAD_USE_EPOLL
+	#include <sys/epoll.h>
+	#include <unistd.h>  // close()
+#endif
+
 
 
 
@@ -191,6 +198,58 @@ void cListenThread::Execute(void)
 		return;
 	}
 	
+	#ifdef LISTENTHREAD_USE_EPOLL
+	
+	int EpollFD = epoll_create((int)m_Sockets.size());
+	if (EpollFD < 0)
+	{
+		LOGERROR("Cannot create an epoll instance for cListenThread: \"%s\"", cSocket::GetLastErrorString().c_str());
+		return;
+	}
+	for (size_t i = 0; i < m_Sockets.size(); i++)
+	{
+		epoll_event Event;
+		memset(&Event, 0, sizeof(Event));
+		Event.events = EPOLLIN;  // Level-triggered, a single connection is accepted per notification
+		Event.data.u32 = (UInt32)i;
+		if (epoll_ctl(EpollFD, EPOLL_CTL_ADD, m_Sockets[i].GetSocket(), &Event) != 0)
+		{
+			LOGWARNING("Cannot add listening socket %d to epoll: \"%s\"", m_Sockets[i].GetSocket(), cSocket::GetLastErrorString().c_str());
+		}
+	}  // for i - m_Sockets[]
+	
+	while (!m_ShouldTerminate)
+	{
+		// On Linux, epoll_wait() doesn't wake up when socket is closed, so let's kinda busy-wait:
+		epoll_event Events[16];
+		int NumEvents = epoll_wait(EpollFD, Events, ARRAYCOUNT(Events), 1000);
+		if (NumEvents == -1)
+		{
+			if (errno != EINTR)
+			{
+				LOG("epoll_wait() call failed in cListenThread: \"%s\"", cSocket::GetLastErrorString().c_str());
+			}
+			continue;
+		}
+		for (int i = 0; i < NumEvents; i++)
+		{
+			cSocket & Listener = m_Sockets[Events[i].data.u32];
+			if (!Listener.IsValid() || m_ShouldTerminate)
+			{
+				continue;
+			}
+			cSocket Client = (m_Family == cSocket::IPv4) ? Listener.AcceptIPv4() : Listener.AcceptIPv6();
+			if (Client.IsValid())
+			{
+				m_Callback.OnConnectionAccepted(Client);
+			}
+		}  // for i - Events[]
+	}  // while (!m_ShouldTerminate)
+	
+	close(EpollFD);
+	
+	#else  // LISTENTHREAD_USE_EPOLL
+	
 	// Find the highest socket number:
 	cSocket::xSocket Highest = m_Sockets[0].GetSocket();
 	for (cSockets::iterator itr = m_Sockets.begin(), end = m_Sockets.end(); itr != end; ++itr)
@@ -231,6 +290,8 @@ void cListenThread::Execute(void)
 			}
 		}  // for itr - m_Sockets[]
 	}  // while (!m_ShouldTerminate)
+	
+	#endif  // else LISTENTHREAD_USE_EPOLL
 }
 
 
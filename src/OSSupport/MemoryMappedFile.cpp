@@ -0,0 +1,131 @@
+// MemoryMappedFile.cpp
+
+// Implements the cMemoryMappedFile class providing an OS-independent read-only memory mapping of a file
+
+#include "Globals.h"  // NOTE: MSVC stupidness requires this to be the same across all modules
+
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+
+
+
+
+cMemoryMappedFile::cMemoryMappedFile(void) :
+	m_Data(NULL),
+	m_Size(0)
+	#ifdef _WIN32
+	,
+	m_File(INVALID_HANDLE_VALUE),
+	m_Mapping(NULL)
+	#endif
+{
+}
+
+
+
+
+
+cMemoryMappedFile::~cMemoryMappedFile()
+{
+	Close();
+}
+
+
+
+
+
+bool cMemoryMappedFile::Open(const AString & a_FileName)
+{
+	Close();
+	AString FileName = FILE_IO_PREFIX + a_FileName;
+	
+	#ifdef _WIN32
+		m_File = CreateFileA(FileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (m_File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		LARGE_INTEGER Size;
+		if (!GetFileSizeEx(m_File, &Size) || (Size.QuadPart == 0))
+		{
+			Close();
+			return false;
+		}
+		m_Mapping = CreateFileMapping(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_Mapping == NULL)
+		{
+			Close();
+			return false;
+		}
+		m_Data = (const char *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_Data == NULL)
+		{
+			Close();
+			return false;
+		}
+		m_Size = (size_t)Size.QuadPart;
+	#else
+		int fd = open(FileName.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return false;
+		}
+		struct stat st;
+		if ((fstat(fd, &st) != 0) || (st.st_size <= 0))
+		{
+			close(fd);
+			return false;
+		}
+		void * Data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		
+		// The mapping keeps its own reference to the file, the descriptor is no longer needed:
+		close(fd);
+		if (Data == MAP_FAILED)
+		{
+			return false;
+		}
+		m_Data = (const char *)Data;
+		m_Size = (size_t)st.st_size;
+	#endif
+	return true;
+}
+
+
+
+
+
+void cMemoryMappedFile::Close(void)
+{
+	#ifdef _WIN32
+		if (m_Data != NULL)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_Mapping != NULL)
+		{
+			CloseHandle(m_Mapping);
+			m_Mapping = NULL;
+		}
+		if (m_File != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_File);
+			m_File = INVALID_HANDLE_VALUE;
+		}
+	#else
+		if (m_Data != NULL)
+		{
+			munmap((void *)m_Data, m_Size);
+		}
+	#endif
+	m_Data = NULL;
+	m_Size = 0;
+}
+
+
+
+
@@ -0,0 +1,58 @@
+// MemoryMappedFile.h
+
+// Declares the cMemoryMappedFile class providing an OS-independent read-only memory mapping of a file
+
+/*
+The whole file is mapped at once, as it is at the time of the Open() call. If the file grows afterwards, the new
+data is not accessible through the mapping; call Open() again to re-map the file with its new size.
+Writes done to the file through other means (such as cFile) are visible through the mapping, as long as they are
+flushed to the OS.
+The object has no multithreading locks, don't use from multiple threads!
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cMemoryMappedFile
+{
+public:
+	cMemoryMappedFile(void);
+	
+	/** Unmaps the file, if mapped */
+	~cMemoryMappedFile();
+	
+	/** Maps the specified file; unmaps the previously mapped file first. Returns true if successful.
+	Fails for empty files, since those cannot be mapped. */
+	bool Open(const AString & a_FileName);
+	
+	/** Unmaps the file; does nothing if not mapped */
+	void Close(void);
+	
+	bool IsOpen(void) const { return (m_Data != NULL); }
+	
+	/** Returns the mapped data, or NULL if not mapped */
+	const char * GetData(void) const { return m_Data; }
+	
+	/** Returns the size of the mapped data, in bytes; 0 if not mapped */
+	size_t GetSize(void) const { return m_Size; }
+	
+private:
+	const char * m_Data;
+	size_t m_Size;
+	
+	#ifdef _WIN32
+	HANDLE m_File;
+	HANDLE m_Mapping;
+	#endif
+} ;
+
+
+
+
@@ -8,6 +8,7 @@
 	#include <unistd.h>
 	#include <arpa/inet.h>  // inet_ntoa()
 	#include <sys/ioctl.h>  // ioctl()
+	#include <sys/uio.h>  // iovec
 #else
 	#define socklen_t int
 #endif
@@ -340,6 +341,49 @@ int cSocket::Send(const char * a_Buffer, unsigned int a_Length)
 
 
 
+int cSocket::Send(const cBufferChain & a_Data)
+{
+	// Most sends fit into a few blocks, the rest is sent by the next call:
+	cBufferChain::sSpan Spans[64];
+	int NumSpans = a_Data.GetSpans(Spans, (int)ARRAYCOUNT(Spans));
+	if (NumSpans == 0)
+	{
+		return 0;
+	}
+	
+	#ifdef _WIN32
+		WSABUF Buffers[ARRAYCOUNT(Spans)];
+		for (int i = 0; i < NumSpans; i++)
+		{
+			Buffers[i].buf = const_cast<char *>(Spans[i].m_Data);
+			Buffers[i].len = (ULONG)Spans[i].m_Size;
+		}
+		DWORD NumSent = 0;
+		if (WSASend(m_Socket, Buffers, (DWORD)NumSpans, &NumSent, 0, NULL, NULL) != 0)
+		{
+			return -1;
+		}
+		return (int)NumSent;
+	#else
+		// sendmsg() rather than writev(), so that MSG_NOSIGNAL can be used, same as in send():
+		iovec Buffers[ARRAYCOUNT(Spans)];
+		for (int i = 0; i < NumSpans; i++)
+		{
+			Buffers[i].iov_base = const_cast<char *>(Spans[i].m_Data);
+			Buffers[i].iov_len = Spans[i].m_Size;
+		}
+		msghdr Msg;
+		memset(&Msg, 0, sizeof(Msg));
+		Msg.msg_iov = Buffers;
+		Msg.msg_iovlen = NumSpans;
+		return (int)sendmsg(m_Socket, &Msg, MSG_NOSIGNAL);
+	#endif
+}
+
+
+
+
+
 unsigned short cSocket::GetPort(void) const
 {
 	ASSERT(IsValid());
@@ -15,6 +15,7 @@
 
 
 #include "Errors.h"
+#include "BufferChain.h"
 
 
 class cSocket
@@ -113,6 +114,10 @@ public:
 	int Receive(char * a_Buffer, unsigned int a_Length, unsigned int a_Flags);
 	int Send   (const char * a_Buffer, unsigned int a_Length);
 	
+	/** Sends the data from the front of the chain, as many of its blocks as possible in a single vectored call, without copying them.
+	Doesn't consume the sent data. Returns the number of bytes sent, or -1 on error, same as Send(). */
+	int Send   (const cBufferChain & a_Data);
+	
 	unsigned short GetPort(void) const;  // Returns 0 on failure
 
 	const AString & GetIPString(void) const { return m_IPString; }
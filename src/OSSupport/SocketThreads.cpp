@@ -9,6 +9,10 @@
 #include "SocketThreads.h"
 #include "Errors.h"
 
+#ifdef SOCKETTHREADS_USE_EPOLL
+	#include <unistd.h>  // close()
+#endif
+
 
 
 
@@ -141,7 +145,9 @@ cSocketThreads::cSocketThread::cSocketThread(cSocketThreads * a_Parent) :
 	m_Parent(a_Parent),
 	m_NumSlots(0)
 {
-	// Nothing needed yet
+	#ifdef SOCKETTHREADS_USE_EPOLL
+		m_EpollFD = -1;
+	#endif
 }
 
 
@@ -162,6 +168,13 @@ cSocketThreads::cSocketThread::~cSocketThread()
 	// Close the control sockets:
 	m_ControlSocket1.CloseSocket();
 	m_ControlSocket2.CloseSocket();
+	
+	#ifdef SOCKETTHREADS_USE_EPOLL
+		if (m_EpollFD >= 0)
+		{
+			close(m_EpollFD);
+		}
+	#endif
 }
 
 
@@ -176,8 +189,24 @@ void cSocketThreads::cSocketThread::AddClient(const cSocket & a_Socket, cCallbac
 	m_Slots[m_NumSlots].m_Client = a_Client;
 	m_Slots[m_NumSlots].m_Socket = a_Socket;
 	m_Slots[m_NumSlots].m_Socket.SetNonBlocking();
-	m_Slots[m_NumSlots].m_Outgoing.clear();
+	m_Slots[m_NumSlots].m_Outgoing.Clear();
+	m_Slots[m_NumSlots].m_IsWritable = true;
 	m_Slots[m_NumSlots].m_State = sSlot::ssNormal;
+	
+	#ifdef SOCKETTHREADS_USE_EPOLL
+		// Register the socket with epoll; edge-triggered, so each readiness change is reported only once:
+		cSocket::xSocket Socket = m_Slots[m_NumSlots].m_Socket.GetSocket();
+		epoll_event Event;
+		memset(&Event, 0, sizeof(Event));
+		Event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		Event.data.fd = Socket;
+		if (epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, Socket, &Event) != 0)
+		{
+			LOGWARNING("Cannot add socket %d to epoll: \"%s\"", Socket, cSocket::GetLastErrorString().c_str());
+		}
+		m_SlotIdxBySocket[Socket] = m_NumSlots;
+	#endif  // SOCKETTHREADS_USE_EPOLL
+	
 	m_NumSlots++;
 	
 	// Notify the thread of the change:
@@ -213,15 +242,13 @@ bool cSocketThreads::cSocketThread::RemoveClient(const cCallback * a_Client)
 			{
 				m_Slots[i].m_Socket.CloseSocket();
 			}
-			m_Slots[i] = m_Slots[--m_NumSlots];
+			RemoveSlot(i);
 		}
 		else
 		{
 			// Query and queue the last batch of outgoing data:
-			AString Data;
-			m_Slots[i].m_Client->GetOutgoingData(Data);
-			m_Slots[i].m_Outgoing.append(Data);
-			if (m_Slots[i].m_Outgoing.empty())
+			m_Slots[i].m_Client->GetOutgoingData(m_Slots[i].m_Outgoing);
+			if (m_Slots[i].m_Outgoing.IsEmpty())
 			{
 				// No more outgoing data, shut the socket down immediately:
 				m_Slots[i].m_Socket.ShutdownReadWrite();
@@ -308,7 +335,7 @@ bool cSocketThreads::cSocketThread::Write(const cCallback * a_Client, const AStr
 	{
 		if (m_Slots[i].m_Client == a_Client)
 		{
-			m_Slots[i].m_Outgoing.append(a_Data);
+			m_Slots[i].m_Outgoing.Append(a_Data);
 			
 			// Notify the thread that there's data in the queue:
 			ASSERT(m_ControlSocket2.IsValid());
@@ -351,6 +378,17 @@ bool cSocketThreads::cSocketThread::Start(void)
 		m_ControlSocket2.CloseSocket();
 		return false;
 	}
+	
+	#ifdef SOCKETTHREADS_USE_EPOLL
+		// Create the epoll instance; the sockets are added to it as the clients are added:
+		m_EpollFD = epoll_create(MAX_SLOTS + 1);
+		if (m_EpollFD < 0)
+		{
+			LOGERROR("Cannot create an epoll instance for a cSocketThread (\"%s\"); continuing, but server may be unreachable from now on.", cSocket::GetLastErrorString().c_str());
+			m_ControlSocket2.CloseSocket();
+			return false;
+		}
+	#endif  // SOCKETTHREADS_USE_EPOLL
 
 	// Start the thread
 	if (!super::Start())
@@ -390,6 +428,49 @@ void cSocketThreads::cSocketThread::Execute(void)
 		return;
 	}
 	
+	#ifdef SOCKETTHREADS_USE_EPOLL
+	
+	// Wait for the control socket in level-triggered mode, it is only ever read partially:
+	epoll_event ControlEvent;
+	memset(&ControlEvent, 0, sizeof(ControlEvent));
+	ControlEvent.events = EPOLLIN;
+	ControlEvent.data.fd = m_ControlSocket1.GetSocket();
+	if (epoll_ctl(m_EpollFD, EPOLL_CTL_ADD, m_ControlSocket1.GetSocket(), &ControlEvent) != 0)
+	{
+		LOGERROR("Cannot add the Control socket to epoll for a cSocketThread (\"%s\"); continuing, but the server may be unreachable from now on.", cSocket::GetLastErrorString().c_str());
+		m_ControlSocket2.CloseSocket();
+		return;
+	}
+	
+	// The main thread loop:
+	while (!m_ShouldTerminate)
+	{
+		// Read outgoing data from the clients:
+		QueueOutgoingData();
+		
+		// Write what can be written before waiting, epoll won't report the sockets that stayed writable:
+		WriteToWritableSockets();
+		
+		// Wait for the sockets:
+		epoll_event Events[256];
+		int NumEvents = epoll_wait(m_EpollFD, Events, ARRAYCOUNT(Events), 5000);
+		if (NumEvents == -1)
+		{
+			if (errno != EINTR)
+			{
+				LOG("epoll_wait() call failed in cSocketThread: \"%s\"", cSocket::GetLastErrorString().c_str());
+			}
+			continue;
+		}
+		
+		// Perform the IO:
+		ProcessEpollEvents(Events, NumEvents);
+		WriteToWritableSockets();
+		CleanUpShutSockets();
+	}  // while (!mShouldTerminate)
+	
+	#else  // SOCKETTHREADS_USE_EPOLL
+	
 	// The main thread loop:
 	while (!m_ShouldTerminate)
 	{
@@ -417,12 +498,77 @@ void cSocketThreads::cSocketThread::Execute(void)
 		WriteToSockets(&fdWrite);
 		CleanUpShutSockets();
 	}  // while (!mShouldTerminate)
+	
+	#endif  // else SOCKETTHREADS_USE_EPOLL
 }
 
 
 
 
 
+#ifdef SOCKETTHREADS_USE_EPOLL
+
+void cSocketThreads::cSocketThread::ProcessEpollEvents(const epoll_event * a_Events, int a_NumEvents)
+{
+	cCSLock Lock(m_Parent->m_CS);
+	for (int i = 0; i < a_NumEvents; i++)
+	{
+		cSocket::xSocket Socket = a_Events[i].data.fd;
+		if (Socket == m_ControlSocket1.GetSocket())
+		{
+			// Reset Control socket state:
+			char Dummy[128];
+			m_ControlSocket1.Receive(Dummy, sizeof(Dummy), 0);
+			continue;
+		}
+		
+		// Find the slot; the socket may have been closed and its slot removed by an earlier event in this batch:
+		std::map<cSocket::xSocket, int>::iterator itr = m_SlotIdxBySocket.find(Socket);
+		if (itr == m_SlotIdxBySocket.end())
+		{
+			continue;
+		}
+		int SlotIdx = itr->second;
+		if ((SlotIdx >= m_NumSlots) || (m_Slots[SlotIdx].m_Socket.GetSocket() != Socket))
+		{
+			// A stale entry for an already closed socket
+			m_SlotIdxBySocket.erase(itr);
+			continue;
+		}
+		
+		if ((a_Events[i].events & EPOLLOUT) != 0)
+		{
+			m_Slots[SlotIdx].m_IsWritable = true;
+		}
+		if ((a_Events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0)
+		{
+			ReadFromSlot(SlotIdx);
+		}
+	}  // for i - a_Events[]
+}
+
+
+
+
+
+void cSocketThreads::cSocketThread::WriteToWritableSockets(void)
+{
+	cCSLock Lock(m_Parent->m_CS);
+	for (int i = m_NumSlots - 1; i >= 0; --i)
+	{
+		if (m_Slots[i].m_IsWritable && m_Slots[i].m_Socket.IsValid())
+		{
+			WriteToSlot(i);
+		}
+	}  // for i - m_Slots[]
+}
+
+#else  // SOCKETTHREADS_USE_EPOLL
+
+
+
+
+
 void cSocketThreads::cSocketThread::PrepareSets(fd_set * a_Read, fd_set * a_Write, cSocket::xSocket & a_Highest)
 {
 	FD_ZERO(a_Read);
@@ -447,7 +593,7 @@ void cSocketThreads::cSocketThread::PrepareSets(fd_set * a_Read, fd_set * a_Writ
 		{
 			a_Highest = s;
 		}
-		if (!m_Slots[i].m_Outgoing.empty())
+		if (!m_Slots[i].m_Outgoing.IsEmpty())
 		{
 			// There's outgoing data for the socket, put it in the Write set
 			FD_SET(s, a_Write);
@@ -479,50 +625,7 @@ void cSocketThreads::cSocketThread::ReadFromSockets(fd_set * a_Read)
 		{
 			continue;
 		}
-		char Buffer[1024];
-		int Received = m_Slots[i].m_Socket.Receive(Buffer, ARRAYCOUNT(Buffer), 0);
-		if (Received <= 0)
-		{
-			if (cSocket::GetLastError() != cSocket::ErrWouldBlock)
-			{
-				// The socket has been closed by the remote party
-				switch (m_Slots[i].m_State)
-				{
-					case sSlot::ssNormal:
-					{
-						// Notify the callback that the remote has closed the socket; keep the slot
-						m_Slots[i].m_Client->SocketClosed();
-						m_Slots[i].m_State = sSlot::ssRemoteClosed;
-						m_Slots[i].m_Socket.CloseSocket();
-						break;
-					}
-					case sSlot::ssWritingRestOut:
-					case sSlot::ssShuttingDown:
-					case sSlot::ssShuttingDown2:
-					{
-						// Force-close the socket and remove the slot:
-						m_Slots[i].m_Socket.CloseSocket();
-						m_Slots[i] = m_Slots[--m_NumSlots];
-						break;
-					}
-					default:
-					{
-						LOG("%s: Unexpected socket state: %d (%s)",
-							__FUNCTION__, m_Slots[i].m_Socket.GetSocket(), m_Slots[i].m_Socket.GetIPString().c_str()
-						);
-						ASSERT(!"Unexpected socket state");
-						break;
-					}
-				}  // switch (m_Slots[i].m_State)
-			}
-		}
-		else
-		{
-			if (m_Slots[i].m_Client != NULL)
-			{
-				m_Slots[i].m_Client->DataReceived(Buffer, Received);
-			}
-		}
+		ReadFromSlot(i);
 	}  // for i - m_Slots[]
 }
 
@@ -541,74 +644,176 @@ void cSocketThreads::cSocketThread::WriteToSockets(fd_set * a_Write)
 		{
 			continue;
 		}
-		if (m_Slots[i].m_Outgoing.empty())
+		WriteToSlot(i);
+	}  // for i - m_Slots[i]
+}
+
+#endif  // else SOCKETTHREADS_USE_EPOLL
+
+
+
+
+
+void cSocketThreads::cSocketThread::ReadFromSlot(int a_SlotIdx)
+{
+	ASSERT(m_Parent->m_CS.IsLockedByCurrentThread());
+	
+	sSlot & Slot = m_Slots[a_SlotIdx];
+	for (;;)
+	{
+		char Buffer[1024];
+		int Received = Slot.m_Socket.Receive(Buffer, ARRAYCOUNT(Buffer), 0);
+		if ((Received < 0) && (cSocket::GetLastError() == cSocket::ErrWouldBlock))
 		{
-			// Request another chunk of outgoing data:
-			if (m_Slots[i].m_Client != NULL)
-			{
-				AString Data;
-				m_Slots[i].m_Client->GetOutgoingData(Data);
-				m_Slots[i].m_Outgoing.append(Data);
-			}
-			if (m_Slots[i].m_Outgoing.empty())
+			// No more data available
+			return;
+		}
+		if (Received <= 0)
+		{
+			// The socket has been closed by the remote party
+			switch (Slot.m_State)
 			{
-				// No outgoing data is ready
-				if (m_Slots[i].m_State == sSlot::ssWritingRestOut)
+				case sSlot::ssNormal:
 				{
-					m_Slots[i].m_State = sSlot::ssShuttingDown;
-					m_Slots[i].m_Socket.ShutdownReadWrite();
+					// Notify the callback that the remote has closed the socket; keep the slot
+					Slot.m_Client->SocketClosed();
+					Slot.m_State = sSlot::ssRemoteClosed;
+					Slot.m_Socket.CloseSocket();
+					break;
 				}
-				continue;
-			}
-		}  // if (outgoing data is empty)
+				case sSlot::ssWritingRestOut:
+				case sSlot::ssShuttingDown:
+				case sSlot::ssShuttingDown2:
+				{
+					// Force-close the socket and remove the slot:
+					Slot.m_Socket.CloseSocket();
+					RemoveSlot(a_SlotIdx);
+					break;
+				}
+				default:
+				{
+					LOG("%s: Unexpected socket state: %d (%s)",
+						__FUNCTION__, Slot.m_Socket.GetSocket(), Slot.m_Socket.GetIPString().c_str()
+					);
+					ASSERT(!"Unexpected socket state");
+					break;
+				}
+			}  // switch (Slot.m_State)
+			return;
+		}
 		
-		if (m_Slots[i].m_State == sSlot::ssRemoteClosed)
+		if (Slot.m_Client != NULL)
 		{
-			continue;
+			Slot.m_Client->DataReceived(Buffer, Received);
 		}
 		
-		if (!SendDataThroughSocket(m_Slots[i].m_Socket, m_Slots[i].m_Outgoing))
+		#ifndef SOCKETTHREADS_USE_EPOLL
+			// select() is level-triggered, any data left will be reported in the next loop
+			return;
+		#endif
+	}  // for (;;)
+}
+
+
+
+
+
+void cSocketThreads::cSocketThread::WriteToSlot(int a_SlotIdx)
+{
+	ASSERT(m_Parent->m_CS.IsLockedByCurrentThread());
+	
+	sSlot & Slot = m_Slots[a_SlotIdx];
+	if (Slot.m_Outgoing.IsEmpty())
+	{
+		// Request another chunk of outgoing data:
+		if (Slot.m_Client != NULL)
 		{
-			int Err = cSocket::GetLastError();
-			LOGWARNING("Error %d while writing to client \"%s\", disconnecting. \"%s\"", Err, m_Slots[i].m_Socket.GetIPString().c_str(), GetOSErrorString(Err).c_str());
-			m_Slots[i].m_Socket.CloseSocket();
-			if (m_Slots[i].m_Client != NULL)
+			Slot.m_Client->GetOutgoingData(Slot.m_Outgoing);
+		}
+		if (Slot.m_Outgoing.IsEmpty())
+		{
+			// No outgoing data is ready
+			if (Slot.m_State == sSlot::ssWritingRestOut)
 			{
-				m_Slots[i].m_Client->SocketClosed();
+				Slot.m_State = sSlot::ssShuttingDown;
+				Slot.m_Socket.ShutdownReadWrite();
 			}
-			continue;
+			return;
 		}
-		
-		if (m_Slots[i].m_Outgoing.empty() && (m_Slots[i].m_State == sSlot::ssWritingRestOut))
+	}  // if (outgoing data is empty)
+	
+	if (Slot.m_State == sSlot::ssRemoteClosed)
+	{
+		return;
+	}
+	
+	if (!SendDataThroughSocket(Slot.m_Socket, Slot.m_Outgoing))
+	{
+		int Err = cSocket::GetLastError();
+		LOGWARNING("Error %d while writing to client \"%s\", disconnecting. \"%s\"", Err, Slot.m_Socket.GetIPString().c_str(), GetOSErrorString(Err).c_str());
+		Slot.m_Socket.CloseSocket();
+		if (Slot.m_Client != NULL)
 		{
-			m_Slots[i].m_State = sSlot::ssShuttingDown;
-			m_Slots[i].m_Socket.ShutdownReadWrite();
+			Slot.m_Client->SocketClosed();
 		}
+		return;
+	}
+	
+	if (!Slot.m_Outgoing.IsEmpty())
+	{
+		// The OS send buffer is full; with epoll, wait for the socket to be reported writable again
+		Slot.m_IsWritable = false;
+	}
+	else if (Slot.m_State == sSlot::ssWritingRestOut)
+	{
+		Slot.m_State = sSlot::ssShuttingDown;
+		Slot.m_Socket.ShutdownReadWrite();
+	}
+
+	// _X: If there's data left, it means the client is not reading fast enough, the server would unnecessarily spin in the main loop with zero actions taken; so signalling is disabled
+	// This means that if there's data left, it will be sent only when there's incoming data or someone queues another packet (for any socket handled by this thread)
+	/*
+	// If there's any data left, signalize the Control socket:
+	if (!Slot.m_Outgoing.IsEmpty())
+	{
+		ASSERT(m_ControlSocket2.IsValid());
+		m_ControlSocket2.Send("q", 1);
+	}
+	*/
+}
+
 
-		// _X: If there's data left, it means the client is not reading fast enough, the server would unnecessarily spin in the main loop with zero actions taken; so signalling is disabled
-		// This means that if there's data left, it will be sent only when there's incoming data or someone queues another packet (for any socket handled by this thread)
-		/*
-		// If there's any data left, signalize the Control socket:
-		if (!m_Slots[i].m_Outgoing.empty())
+
+
+
+void cSocketThreads::cSocketThread::RemoveSlot(int a_SlotIdx)
+{
+	ASSERT(m_Parent->m_CS.IsLockedByCurrentThread());
+	ASSERT((a_SlotIdx >= 0) && (a_SlotIdx < m_NumSlots));
+	
+	m_NumSlots -= 1;
+	m_Slots[a_SlotIdx] = m_Slots[m_NumSlots];
+	m_Slots[m_NumSlots].m_Outgoing.Clear();  // Return the blocks shared by the copy to the pool now, rather than when the slot is reused
+	
+	#ifdef SOCKETTHREADS_USE_EPOLL
+		// The last slot has moved, update its index:
+		if ((a_SlotIdx < m_NumSlots) && m_Slots[a_SlotIdx].m_Socket.IsValid())
 		{
-			ASSERT(m_ControlSocket2.IsValid());
-			m_ControlSocket2.Send("q", 1);
+			m_SlotIdxBySocket[m_Slots[a_SlotIdx].m_Socket.GetSocket()] = a_SlotIdx;
 		}
-		*/
-	}  // for i - m_Slots[i]
+	#endif
 }
 
 
 
 
 
-bool cSocketThreads::cSocketThread::SendDataThroughSocket(cSocket & a_Socket, AString & a_Data)
+bool cSocketThreads::cSocketThread::SendDataThroughSocket(cSocket & a_Socket, cBufferChain & a_Data)
 {
-	// Send data in smaller chunks, so that the OS send buffers aren't overflown easily
-	while (!a_Data.empty())
+	// Send the blocks directly, several at once, until the OS send buffer is full:
+	while (!a_Data.IsEmpty())
 	{
-		size_t NumToSend = std::min(a_Data.size(), (size_t)1024);
-		int Sent = a_Socket.Send(a_Data.data(), NumToSend);
+		int Sent = a_Socket.Send(a_Data);
 		if (Sent < 0)
 		{
 			int Err = cSocket::GetLastError();
@@ -625,7 +830,7 @@ bool cSocketThreads::cSocketThread::SendDataThroughSocket(cSocket & a_Socket, AS
 			a_Socket.CloseSocket();
 			return true;
 		}
-		a_Data.erase(0, Sent);
+		a_Data.Consume((size_t)Sent);
 	}
 	return true;
 }
@@ -645,7 +850,7 @@ void cSocketThreads::cSocketThread::CleanUpShutSockets(void)
 			{
 				// The socket has reached the shutdown timeout, close it and clear its slot:
 				m_Slots[i].m_Socket.CloseSocket();
-				m_Slots[i] = m_Slots[--m_NumSlots];
+				RemoveSlot(i);
 				break;
 			}
 			case sSlot::ssShuttingDown:
@@ -669,11 +874,9 @@ void cSocketThreads::cSocketThread::QueueOutgoingData(void)
 	{
 		if (m_Slots[i].m_Client != NULL)
 		{
-			AString Data;
-			m_Slots[i].m_Client->GetOutgoingData(Data);
-			m_Slots[i].m_Outgoing.append(Data);
+			m_Slots[i].m_Client->GetOutgoingData(m_Slots[i].m_Outgoing);
 		}
-		if (m_Slots[i].m_Outgoing.empty())
+		if (m_Slots[i].m_Outgoing.IsEmpty())
 		{
 			// No outgoing data is ready
 			if (m_Slots[i].m_State == sSlot::ssWritingRestOut)
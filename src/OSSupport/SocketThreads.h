@@ -8,20 +8,40 @@
 /*
 Additional details:
 When a client wants to terminate the connection, they call the RemoveClient() function. This calls the
-callback one last time to read all the available outgoing data, putting it in the slot's m_OutgoingData
-buffer. Then it marks the slot as having no callback. The socket is kept alive until its outgoing data
+callback one last time to read all the available outgoing data, putting it in the slot's m_Outgoing
+chain. Then it marks the slot as having no callback. The socket is kept alive until its outgoing data
 queue is empty, then shutdown is called on it and finally the socket is closed after a timeout.
 If at any time within this the remote end closes the socket, then the socket is closed directly.
 As soon as the socket is closed, the slot is finally removed from the SocketThread.
 The graph in $/docs/SocketThreads States.gv shows the state-machine transitions of the slot.
+
+On Linux, the sockets are waited for using epoll in edge-triggered mode instead of select(). epoll has no limit
+on the number of sockets and doesn't need to rebuild the socket sets in each loop, so each thread can handle
+many more clients and a small number of threads serve thousands of connections. Because the notifications are
+edge-triggered, a readable socket is read until it would block, and a socket is written to only after epoll
+has reported it writable, until its OS send buffer fills up again.
+Define SOCKETTHREADS_USE_SELECT to use select() on Linux, too.
+
+The outgoing data is kept in cBufferChain-s. The callbacks hand their data over by splicing their chain into the
+slot's one, which moves the blocks without copying, and the blocks are sent through the socket directly, several
+of them in a single vectored send.
 */
 
 
 
 
 
-/** How many clients should one thread handle? (must be less than FD_SETSIZE for your platform) */
-#define MAX_SLOTS 63
+#if defined(__linux__) && !defined(SOCKETTHREADS_USE_SELECT)
+	#define SOCKETTHREADS_USE_EPOLL
+#endif
+
+#ifdef SOCKETTHREADS_USE_EPOLL
+	/** How many clients should one thread handle? epoll has no limit on the number of sockets */
+	#define MAX_SLOTS 1024
+#else
+	/** How many clients should one thread handle? (must be less than FD_SETSIZE for your platform) */
+	#define MAX_SLOTS 63
+#endif
 
 
 
@@ -36,10 +56,14 @@ The graph in $/docs/SocketThreads States.gv shows the state-machine transitions
 
 
 // Check MAX_SLOTS:
-#if MAX_SLOTS >= FD_SETSIZE
+#if !defined(SOCKETTHREADS_USE_EPOLL) && (MAX_SLOTS >= FD_SETSIZE)
 	#error "MAX_SLOTS must be less than FD_SETSIZE for your platform! (otherwise select() won't work)"
 #endif
 
+#ifdef SOCKETTHREADS_USE_EPOLL
+	#include <sys/epoll.h>
+#endif
+
 
 
 
@@ -67,8 +91,8 @@ public:
 		virtual void DataReceived(const char * a_Data, size_t a_Size) = 0;
 		
 		/** Called when data can be sent to remote party
-		The function is supposed to *set* outgoing data to a_Data (overwrite) */
-		virtual void GetOutgoingData(AString & a_Data) = 0;
+		The function is supposed to *append* its outgoing data to a_Data, preferably using a_Data.Splice() to avoid copying */
+		virtual void GetOutgoingData(cBufferChain & a_Data) = 0;
 		
 		/** Called when the socket has been closed for any reason */
 		virtual void SocketClosed(void) = 0;
@@ -128,6 +152,16 @@ private:
 		cSocket m_ControlSocket1;
 		cSocket m_ControlSocket2;
 		
+		#ifdef SOCKETTHREADS_USE_EPOLL
+			/** The epoll instance waiting for the control socket and all the slots' sockets */
+			int m_EpollFD;
+			
+			/** Maps socket handles to the index of their slot, so that epoll events can be routed to slots.
+			May contain stale entries for already closed sockets, users must check that the slot still holds the socket.
+			Manipulation assumes that the parent's m_CS is locked. */
+			std::map<cSocket::xSocket, int> m_SlotIdxBySocket;
+		#endif  // SOCKETTHREADS_USE_EPOLL
+		
 		// Socket-client-dataqueues-state quadruplets.
 		// Manipulation with these assumes that the parent's m_CS is locked
 		struct sSlot
@@ -138,9 +172,12 @@ private:
 			/** The callback to call for events. May be NULL */
 			cCallback * m_Client;
 			
-			/** If sending writes only partial data, the rest is stored here for another send.
+			/** The data queued for sending; if sending writes only partial data, the rest stays here for another send.
 			Also used when the slot is being removed to store the last batch of outgoing data. */
-			AString m_Outgoing;
+			cBufferChain m_Outgoing;
+			
+			/** Used only with epoll: set when epoll reports the socket writable, reset when a send fills the OS buffer */
+			bool m_IsWritable;
 			
 			enum eState
 			{
@@ -157,6 +194,16 @@ private:
 		
 		virtual void Execute(void) override;
 		
+		#ifdef SOCKETTHREADS_USE_EPOLL
+		
+		/** Routes the events returned by epoll_wait() to their slots, reading from the readable sockets and marking the writable ones */
+		void ProcessEpollEvents(const epoll_event * a_Events, int a_NumEvents);
+		
+		/** Writes to the sockets that have been reported writable and have outgoing data */
+		void WriteToWritableSockets(void);
+		
+		#else  // SOCKETTHREADS_USE_EPOLL
+		
 		/** Prepares the Read and Write socket sets for select()
 		Puts all sockets into the read set, along with m_ControlSocket1.
 		Only sockets that have outgoing data queued on them are put in the write set.*/
@@ -168,10 +215,23 @@ private:
 		/** Writes to sockets indicated in a_Write */
 		void WriteToSockets (fd_set * a_Write);
 		
-		/** Sends data through the specified socket, trying to fill the OS send buffer in chunks.
+		#endif  // else SOCKETTHREADS_USE_EPOLL
+		
+		/** Reads the incoming data from the socket in the specified slot and passes it to the client.
+		With epoll, the socket is read until there's no more data, as required by the edge-triggered notifications.
+		Handles the remote end closing the socket, which may remove the slot. */
+		void ReadFromSlot(int a_SlotIdx);
+		
+		/** Sends the outgoing data of the specified slot, querying the client for more if there's none queued */
+		void WriteToSlot(int a_SlotIdx);
+		
+		/** Removes the specified slot, moving the last slot into its place */
+		void RemoveSlot(int a_SlotIdx);
+		
+		/** Sends data through the specified socket, using vectored sends until the OS send buffer fills up.
 		Returns true if there was no error while sending, false if an error has occured.
-		Modifies a_Data to contain only the unsent data. */
-		bool SendDataThroughSocket(cSocket & a_Socket, AString & a_Data);
+		Consumes the sent data from a_Data, leaving only the unsent data. */
+		bool SendDataThroughSocket(cSocket & a_Socket, cBufferChain & a_Data);
 
 		/** Removes those slots in ssShuttingDown2 state, sets those with ssShuttingDown state to ssShuttingDown2 */
 		void CleanUpShutSockets(void);
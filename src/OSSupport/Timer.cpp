@@ -35,3 +35,21 @@ long long cTimer::GetNowTime(void)
 
 
 
+
+long long cTimer::GetNowTimeUsec(void)
+{
+	#ifdef _WIN32
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		// Split the calculation so that it doesn't overflow:
+		return (now.QuadPart / m_TicksPerSecond.QuadPart) * 1000000 + ((now.QuadPart % m_TicksPerSecond.QuadPart) * 1000000) / m_TicksPerSecond.QuadPart;
+	#else
+		struct timeval  now;
+		gettimeofday(&now, NULL);
+		return (long long)now.tv_sec * 1000000 + (long long)now.tv_usec;
+	#endif
+}
+
+
+
+
@@ -20,6 +20,9 @@ public:
 
 	// Returns the current time expressed in milliseconds
 	long long GetNowTime(void);
+	
+	// Returns the current time expressed in microseconds, for measuring short intervals
+	long long GetNowTimeUsec(void);
 private:
 
 	#ifdef _WIN32
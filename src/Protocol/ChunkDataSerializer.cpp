@@ -8,28 +8,40 @@
 #include "Globals.h"
 #include "ChunkDataSerializer.h"
 #include "zlib/zlib.h"
+#include "../ChunkData.h"
+#include "ChunkPacketCache.h"
 
 
 
 
 cChunkDataSerializer::cChunkDataSerializer(
-	const cChunkDef::BlockTypes   & a_BlockTypes,
-	const cChunkDef::BlockNibbles & a_BlockMetas,
-	const cChunkDef::BlockNibbles & a_BlockLight,
-	const cChunkDef::BlockNibbles & a_BlockSkyLight,
-	const unsigned char *           a_BiomeData
+	const cChunkData &    a_Data,
+	const unsigned char * a_BiomeData
 ) :
-	m_BlockTypes(a_BlockTypes),
-	m_BlockMetas(a_BlockMetas),
-	m_BlockLight(a_BlockLight),
-	m_BlockSkyLight(a_BlockSkyLight),
-	m_BiomeData(a_BiomeData)
+	m_Data(a_Data),
+	m_BiomeData(a_BiomeData),
+	m_Cache(NULL),
+	m_ChunkX(0),
+	m_ChunkZ(0),
+	m_ChangeCounter(0)
 {
 }
 
 
 
 
+
+void cChunkDataSerializer::SetCache(cChunkPacketCache & a_Cache, int a_ChunkX, int a_ChunkZ, UInt64 a_ChangeCounter)
+{
+	m_Cache = &a_Cache;
+	m_ChunkX = a_ChunkX;
+	m_ChunkZ = a_ChunkZ;
+	m_ChangeCounter = a_ChangeCounter;
+}
+
+
+
+
 const AString & cChunkDataSerializer::Serialize(int a_Version)
 {
 	Serializations::const_iterator itr = m_Serializations.find(a_Version);
@@ -39,6 +51,14 @@ const AString & cChunkDataSerializer::Serialize(int a_Version)
 	}
 	
 	AString data;
+	
+	// Another serializer may have already done the work for the same chunk data:
+	if ((m_Cache != NULL) && m_Cache->Get(m_ChunkX, m_ChunkZ, a_Version, m_ChangeCounter, data))
+	{
+		m_Serializations[a_Version] = data;
+		return m_Serializations[a_Version];
+	}
+	
 	switch (a_Version)
 	{
 		case RELEASE_1_2_5: Serialize29(data); break;
@@ -52,6 +72,10 @@ const AString & cChunkDataSerializer::Serialize(int a_Version)
 			break;
 		}
 	}
+	if ((m_Cache != NULL) && !data.empty())
+	{
+		m_Cache->Put(m_ChunkX, m_ChunkZ, a_Version, m_ChangeCounter, data);
+	}
 	m_Serializations[a_Version] = data;
 	return m_Serializations[a_Version];
 }
@@ -60,30 +84,49 @@ const AString & cChunkDataSerializer::Serialize(int a_Version)
 
 
 
-void cChunkDataSerializer::Serialize29(AString & a_Data)
+UInt16 cChunkDataSerializer::CompressSections(AString & a_Compressed)
 {
 	// TODO: Do not copy data and then compress it; rather, compress partial blocks of data (zlib *can* stream)
 
-	const int BiomeDataSize    = cChunkDef::Width * cChunkDef::Width;
-	const int MetadataOffset   = sizeof(m_BlockTypes);
-	const int BlockLightOffset = MetadataOffset   + sizeof(m_BlockMetas);
-	const int SkyLightOffset   = BlockLightOffset + sizeof(m_BlockLight);
-	const int BiomeOffset      = SkyLightOffset   + sizeof(m_BlockSkyLight);
-	const int DataSize         = BiomeOffset      + BiomeDataSize;
+	const int BiomeDataSize     = cChunkDef::Width * cChunkDef::Width;
+	const int SectionBlocksSize = cChunkData::SectionBlockCount;
+	const int SectionNibbleSize = cChunkData::SectionBlockCount / 2;
+	const int MaxDataSize       = cChunkDef::BlockDataSize + BiomeDataSize;
 	
-	// Temporary buffer for the composed data:
-	char AllData [DataSize];
-
-	memcpy(AllData, m_BlockTypes, sizeof(m_BlockTypes));
-	memcpy(AllData + MetadataOffset,   m_BlockMetas,    sizeof(m_BlockMetas));
-	memcpy(AllData + BlockLightOffset, m_BlockLight,    sizeof(m_BlockLight));
-	memcpy(AllData + SkyLightOffset,   m_BlockSkyLight, sizeof(m_BlockSkyLight));
-	memcpy(AllData + BiomeOffset,      m_BiomeData,     BiomeDataSize);
+	// Collect the non-empty sections:
+	const cChunkData::sChunkSection * Sections[cChunkData::NumSections];
+	int NumSections = 0;
+	UInt16 Bitmap = 0;
+	for (int i = 0; i < cChunkData::NumSections; i++)
+	{
+		const cChunkData::sChunkSection * Section = m_Data.GetSection(i);
+		if (Section != NULL)
+		{
+			Sections[NumSections++] = Section;
+			Bitmap |= static_cast<UInt16>(1 << i);
+		}
+	}
+	
+	// Temporary buffer for the composed data; the protocol sends all block types first, then all metas, then lights:
+	char AllData[MaxDataSize];
+	const int MetadataOffset   = NumSections * SectionBlocksSize;
+	const int BlockLightOffset = MetadataOffset   + NumSections * SectionNibbleSize;
+	const int SkyLightOffset   = BlockLightOffset + NumSections * SectionNibbleSize;
+	const int BiomeOffset      = SkyLightOffset   + NumSections * SectionNibbleSize;
+	const int DataSize         = BiomeOffset      + BiomeDataSize;
+	for (int i = 0; i < NumSections; i++)
+	{
+		memcpy(AllData + i * SectionBlocksSize,                   Sections[i]->m_BlockTypes,    SectionBlocksSize);
+		memcpy(AllData + MetadataOffset   + i * SectionNibbleSize, Sections[i]->m_BlockMetas,    SectionNibbleSize);
+		memcpy(AllData + BlockLightOffset + i * SectionNibbleSize, Sections[i]->m_BlockLight,    SectionNibbleSize);
+		memcpy(AllData + SkyLightOffset   + i * SectionNibbleSize, Sections[i]->m_BlockSkyLight, SectionNibbleSize);
+	}
+	memcpy(AllData + BiomeOffset, m_BiomeData, BiomeDataSize);
 
 	// Compress the data:
 	// In order not to use allocation, use a fixed-size buffer, with the size
 	// that uses the same calculation as compressBound():
-	const uLongf CompressedMaxSize = DataSize + (DataSize >> 12) + (DataSize >> 14) + (DataSize >> 25) + 16;
+	const uLongf CompressedMaxSize = MaxDataSize + (MaxDataSize >> 12) + (MaxDataSize >> 14) + (MaxDataSize >> 25) + 16;
 	char CompressedBlockData[CompressedMaxSize];
 
 	uLongf CompressedSize = compressBound(DataSize);
@@ -91,27 +134,38 @@ void cChunkDataSerializer::Serialize29(AString & a_Data)
 	// Run-time check that our compile-time guess about CompressedMaxSize was enough:
 	ASSERT(CompressedSize <= CompressedMaxSize);
 	
-	compress2((Bytef*)CompressedBlockData, &CompressedSize, (const Bytef*)AllData, sizeof(AllData), Z_DEFAULT_COMPRESSION);
+	compress2((Bytef*)CompressedBlockData, &CompressedSize, (const Bytef*)AllData, DataSize, Z_DEFAULT_COMPRESSION);
+	a_Compressed.assign(CompressedBlockData, CompressedSize);
+	return Bitmap;
+}
+
+
+
+
+
+void cChunkDataSerializer::Serialize29(AString & a_Data)
+{
+	AString CompressedBlockData;
+	UInt16 Bitmap = CompressSections(CompressedBlockData);
 
 	// Now put all those data into a_Data:
 	
 	// "Ground-up continuous", or rather, "biome data present" flag:
 	a_Data.push_back('\x01');
 	
-	// Two bitmaps; we're aways sending the full chunk with no additional data, so the bitmaps are 0xffff and 0, respectively
-	// Also, no endian flipping is needed because of the const values
-	unsigned short BitMap1 = 0xffff;
-	unsigned short BitMap2 = 0;
+	// Two bitmaps; the first one says which sections are present, the second one is for the "add" data which we never send
+	UInt16 BitMap1 = htons(Bitmap);
+	UInt16 BitMap2 = 0;
 	a_Data.append((const char *)&BitMap1, sizeof(short));
 	a_Data.append((const char *)&BitMap2, sizeof(short));
 	
-	UInt32 CompressedSizeBE = htonl((UInt32)CompressedSize);
+	UInt32 CompressedSizeBE = htonl((UInt32)CompressedBlockData.size());
 	a_Data.append((const char *)&CompressedSizeBE, sizeof(CompressedSizeBE));
 	
 	Int32 UnusedInt32 = 0;
 	a_Data.append((const char *)&UnusedInt32,      sizeof(UnusedInt32));
 	
-	a_Data.append(CompressedBlockData, CompressedSize);
+	a_Data.append(CompressedBlockData);
 }
 
 
@@ -120,55 +174,26 @@ void cChunkDataSerializer::Serialize29(AString & a_Data)
 
 void cChunkDataSerializer::Serialize39(AString & a_Data)
 {
-	// TODO: Do not copy data and then compress it; rather, compress partial blocks of data (zlib *can* stream)
-
-	const int BiomeDataSize    = cChunkDef::Width * cChunkDef::Width;
-	const int MetadataOffset   = sizeof(m_BlockTypes);
-	const int BlockLightOffset = MetadataOffset   + sizeof(m_BlockMetas);
-	const int SkyLightOffset   = BlockLightOffset + sizeof(m_BlockLight);
-	const int BiomeOffset      = SkyLightOffset   + sizeof(m_BlockSkyLight);
-	const int DataSize         = BiomeOffset      + BiomeDataSize;
-	
-	// Temporary buffer for the composed data:
-	char AllData [DataSize];
-
-	memcpy(AllData, m_BlockTypes, sizeof(m_BlockTypes));
-	memcpy(AllData + MetadataOffset,   m_BlockMetas,    sizeof(m_BlockMetas));
-	memcpy(AllData + BlockLightOffset, m_BlockLight,    sizeof(m_BlockLight));
-	memcpy(AllData + SkyLightOffset,   m_BlockSkyLight, sizeof(m_BlockSkyLight));
-	memcpy(AllData + BiomeOffset,      m_BiomeData,     BiomeDataSize);
-
-	// Compress the data:
-	// In order not to use allocation, use a fixed-size buffer, with the size
-	// that uses the same calculation as compressBound():
-	const uLongf CompressedMaxSize = DataSize + (DataSize >> 12) + (DataSize >> 14) + (DataSize >> 25) + 16;
-	char CompressedBlockData[CompressedMaxSize];
-
-	uLongf CompressedSize = compressBound(DataSize);
-	
-	// Run-time check that our compile-time guess about CompressedMaxSize was enough:
-	ASSERT(CompressedSize <= CompressedMaxSize);
-	
-	compress2((Bytef*)CompressedBlockData, &CompressedSize, (const Bytef*)AllData, sizeof(AllData), Z_DEFAULT_COMPRESSION);
+	AString CompressedBlockData;
+	UInt16 Bitmap = CompressSections(CompressedBlockData);
 
 	// Now put all those data into a_Data:
 	
 	// "Ground-up continuous", or rather, "biome data present" flag:
 	a_Data.push_back('\x01');
 	
-	// Two bitmaps; we're aways sending the full chunk with no additional data, so the bitmaps are 0xffff and 0, respectively
-	// Also, no endian flipping is needed because of the const values
-	unsigned short BitMap1 = 0xffff;
-	unsigned short BitMap2 = 0;
+	// Two bitmaps; the first one says which sections are present, the second one is for the "add" data which we never send
+	UInt16 BitMap1 = htons(Bitmap);
+	UInt16 BitMap2 = 0;
 	a_Data.append((const char *)&BitMap1, sizeof(short));
 	a_Data.append((const char *)&BitMap2, sizeof(short));
 	
-	UInt32 CompressedSizeBE = htonl((UInt32)CompressedSize);
+	UInt32 CompressedSizeBE = htonl((UInt32)CompressedBlockData.size());
 	a_Data.append((const char *)&CompressedSizeBE, sizeof(CompressedSizeBE));
 	
 	// Unlike 29, 39 doesn't have the "unused" int
 	
-	a_Data.append(CompressedBlockData, CompressedSize);
+	a_Data.append(CompressedBlockData);
 }
 
 
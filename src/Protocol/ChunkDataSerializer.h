@@ -9,22 +9,39 @@
 
 
 
+// fwd:
+class cChunkData;
+class cChunkPacketCache;
+
+
+
+
+
 class cChunkDataSerializer
 {
 protected:
-	const cChunkDef::BlockTypes   & m_BlockTypes;
-	const cChunkDef::BlockNibbles & m_BlockMetas;
-	const cChunkDef::BlockNibbles & m_BlockLight;
-	const cChunkDef::BlockNibbles & m_BlockSkyLight;
+	const cChunkData & m_Data;
 	const unsigned char * m_BiomeData;
 	
 	typedef std::map<int, AString> Serializations;
 	
 	Serializations m_Serializations;
 	
+	/** The world-wide cache to share the serializations through; NULL if not caching */
+	cChunkPacketCache * m_Cache;
+	
+	// The identification of the serialized data within m_Cache:
+	int    m_ChunkX;
+	int    m_ChunkZ;
+	UInt64 m_ChangeCounter;
+	
 	void Serialize29(AString & a_Data);  // Release 1.2.4 and 1.2.5
 	void Serialize39(AString & a_Data);  // Release 1.3.1 and 1.3.2
 	
+	/** Composes the data of the non-empty sections plus the biomes, in the protocol layout, and compresses it into a_Compressed.
+	Returns the bitmap of the sections that have been included. Only the allocated sections are sent, the client treats the rest as air. */
+	UInt16 CompressSections(AString & a_Compressed);
+	
 public:
 	enum
 	{
@@ -33,13 +50,14 @@ public:
 	} ;
 	
 	cChunkDataSerializer(
-		const cChunkDef::BlockTypes   & a_BlockTypes,
-		const cChunkDef::BlockNibbles & a_BlockMetas,
-		const cChunkDef::BlockNibbles & a_BlockLight,
-		const cChunkDef::BlockNibbles & a_BlockSkyLight,
-		const unsigned char *           a_BiomeData
+		const cChunkData &    a_Data,
+		const unsigned char * a_BiomeData
 	);
 
+	/** Makes the serializer look up the serializations in the specified cache before serializing, and store them there afterwards.
+	a_ChangeCounter is the change counter of the chunk at the time its data was queried. */
+	void SetCache(cChunkPacketCache & a_Cache, int a_ChunkX, int a_ChunkZ, UInt64 a_ChangeCounter);
+
 	const AString & Serialize(int a_Version);  // Returns one of the internal m_Serializations[]
 } ;
 
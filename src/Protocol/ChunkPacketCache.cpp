@@ -0,0 +1,123 @@
+// ChunkPacketCache.cpp
+
+// Implements the cChunkPacketCache class representing a world-wide cache of serialized and compressed chunk data
+
+#include "Globals.h"
+#include "ChunkPacketCache.h"
+
+
+
+
+
+cChunkPacketCache::cChunkPacketCache(size_t a_MaxEntries, size_t a_MaxDataSize) :
+	m_MaxEntries(a_MaxEntries),
+	m_MaxDataSize(a_MaxDataSize),
+	m_UseCounter(0),
+	m_DataSize(0),
+	m_NumHits(0),
+	m_NumMisses(0)
+{
+}
+
+
+
+
+
+bool cChunkPacketCache::Get(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_ChangeCounter, AString & a_Data)
+{
+	cCSLock Lock(m_CS);
+	cEntries::iterator itr = m_Entries.find(sKey(a_ChunkX, a_ChunkZ, a_Version));
+	if ((itr == m_Entries.end()) || (itr->second.m_ChangeCounter != a_ChangeCounter))
+	{
+		m_NumMisses += 1;
+		return false;
+	}
+	m_NumHits += 1;
+	itr->second.m_LastUsed = ++m_UseCounter;
+	a_Data = itr->second.m_Data;
+	return true;
+}
+
+
+
+
+
+void cChunkPacketCache::Put(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_ChangeCounter, const AString & a_Data)
+{
+	cCSLock Lock(m_CS);
+	sEntry & Entry = m_Entries[sKey(a_ChunkX, a_ChunkZ, a_Version)];
+	m_DataSize -= Entry.m_Data.size();
+	Entry.m_ChangeCounter = a_ChangeCounter;
+	Entry.m_Data = a_Data;
+	Entry.m_LastUsed = ++m_UseCounter;
+	m_DataSize += a_Data.size();
+
+	while (!m_Entries.empty() && ((m_Entries.size() > m_MaxEntries) || (m_DataSize > m_MaxDataSize)))
+	{
+		EvictOldest();
+	}
+}
+
+
+
+
+
+void cChunkPacketCache::RemoveChunk(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CS);
+	cEntries::iterator itr = m_Entries.lower_bound(sKey(a_ChunkX, a_ChunkZ, std::numeric_limits<int>::min()));
+	while ((itr != m_Entries.end()) && (itr->first.m_ChunkX == a_ChunkX) && (itr->first.m_ChunkZ == a_ChunkZ))
+	{
+		m_DataSize -= itr->second.m_Data.size();
+		m_Entries.erase(itr++);
+	}
+}
+
+
+
+
+
+void cChunkPacketCache::GetStats(int & a_NumEntries, size_t & a_DataSize, int & a_NumHits, int & a_NumMisses)
+{
+	cCSLock Lock(m_CS);
+	a_NumEntries = (int)m_Entries.size();
+	a_DataSize = m_DataSize;
+	a_NumHits = m_NumHits;
+	a_NumMisses = m_NumMisses;
+}
+
+
+
+
+
+void cChunkPacketCache::EvictOldest(void)
+{
+	// Find the timestamp of the newest entry in the oldest quarter (the timestamps are unique):
+	std::vector<Int64> LastUsed;
+	LastUsed.reserve(m_Entries.size());
+	for (cEntries::const_iterator itr = m_Entries.begin(), end = m_Entries.end(); itr != end; ++itr)
+	{
+		LastUsed.push_back(itr->second.m_LastUsed);
+	}
+	std::vector<Int64>::iterator Split = LastUsed.begin() + std::max<size_t>(LastUsed.size() / 4, 1) - 1;
+	std::nth_element(LastUsed.begin(), Split, LastUsed.end());
+	Int64 Threshold = *Split;
+
+	// Drop that entry and all the entries older than that:
+	for (cEntries::iterator itr = m_Entries.begin(); itr != m_Entries.end();)
+	{
+		if (itr->second.m_LastUsed <= Threshold)
+		{
+			m_DataSize -= itr->second.m_Data.size();
+			m_Entries.erase(itr++);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,111 @@
+// ChunkPacketCache.h
+
+// Declares the cChunkPacketCache class representing a world-wide cache of serialized and compressed chunk data
+
+/*
+Compressing the chunk data is the most expensive part of sending a chunk to a client. When many clients are in the
+same area (such as the spawn), each of them is sent the same chunks, so the serialized data is cached per world and
+shared across all the clients and all the cChunkDataSerializer instances.
+The cache is keyed by the chunk coords and the protocol version. Each entry remembers the chunk's change counter
+(cChunk increments it whenever its data changes and starts each loaded instance of a chunk with a new generation),
+an entry with a different counter is stale and is replaced.
+The entries are removed when their chunk is unloaded; if there are too many of them or they take up too much memory,
+the least recently used ones are dropped.
+*/
+
+
+
+
+
+#pragma once
+
+
+
+
+
+class cChunkPacketCache
+{
+public:
+
+	cChunkPacketCache(size_t a_MaxEntries = 2048, size_t a_MaxDataSize = 32 * 1024 * 1024);
+
+	/** Retrieves the cached serialization for the specified chunk and protocol version into a_Data.
+	Returns true if found and serialized from the chunk data with the same change counter, false otherwise. */
+	bool Get(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_ChangeCounter, AString & a_Data);
+
+	/** Stores the serialization for the specified chunk and protocol version, replacing any previous one */
+	void Put(int a_ChunkX, int a_ChunkZ, int a_Version, UInt64 a_ChangeCounter, const AString & a_Data);
+
+	/** Removes all the serializations of the specified chunk, in all protocol versions */
+	void RemoveChunk(int a_ChunkX, int a_ChunkZ);
+
+	/** Returns the number of entries, the total size of the cached data, and the number of cache hits and misses so far */
+	void GetStats(int & a_NumEntries, size_t & a_DataSize, int & a_NumHits, int & a_NumMisses);
+
+protected:
+
+	struct sKey
+	{
+		int m_ChunkX;
+		int m_ChunkZ;
+		int m_Version;
+
+		sKey(int a_ChunkX, int a_ChunkZ, int a_Version) :
+			m_ChunkX(a_ChunkX),
+			m_ChunkZ(a_ChunkZ),
+			m_Version(a_Version)
+		{
+		}
+
+		bool operator <(const sKey & a_Other) const
+		{
+			if (m_ChunkX != a_Other.m_ChunkX)
+			{
+				return (m_ChunkX < a_Other.m_ChunkX);
+			}
+			if (m_ChunkZ != a_Other.m_ChunkZ)
+			{
+				return (m_ChunkZ < a_Other.m_ChunkZ);
+			}
+			return (m_Version < a_Other.m_Version);
+		}
+	} ;
+
+	struct sEntry
+	{
+		UInt64  m_ChangeCounter;
+		AString m_Data;
+
+		/** Value of m_UseCounter when the entry was last used, for the LRU eviction */
+		Int64 m_LastUsed;
+	} ;
+
+	typedef std::map<sKey, sEntry> cEntries;
+
+
+	cCriticalSection m_CS;
+	cEntries m_Entries;
+
+	/** Maximum number of entries; when exceeded, the least recently used quarter is dropped */
+	size_t m_MaxEntries;
+	
+	/** Maximum total size of the cached data, in bytes; when exceeded, the least recently used quarter is dropped */
+	size_t m_MaxDataSize;
+
+	/** Incremented on each Get() and Put(), used as the timestamp for the LRU eviction */
+	Int64 m_UseCounter;
+
+	/** Total size of all the cached data, in bytes */
+	size_t m_DataSize;
+
+	int m_NumHits;
+	int m_NumMisses;
+
+
+	/** Drops the least recently used quarter of the entries, at least one entry. Assumes m_CS is locked. */
+	void EvictOldest(void);
+} ;
+
+
+
+
@@ -0,0 +1,105 @@
+
+// EntityPackets.h
+
+// Declares the entity movement packets that are broadcast through cPacketBroadcaster,
+// so that they are serialized only once per protocol version
+
+
+
+
+
+#pragma once
+
+#include "Protocol.h"
+
+
+
+
+
+class cEntityHeadLookPacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityHeadLookPacket(const cEntity & a_Entity) : m_Entity(a_Entity) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendEntityHeadLook(m_Entity); }
+protected:
+	const cEntity & m_Entity;
+} ;
+
+
+
+
+
+class cEntityLookPacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityLookPacket(const cEntity & a_Entity) : m_Entity(a_Entity) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendEntityLook(m_Entity); }
+protected:
+	const cEntity & m_Entity;
+} ;
+
+
+
+
+
+class cEntityRelMovePacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityRelMovePacket(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ) :
+		m_Entity(a_Entity), m_RelX(a_RelX), m_RelY(a_RelY), m_RelZ(a_RelZ) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendEntityRelMove(m_Entity, m_RelX, m_RelY, m_RelZ); }
+protected:
+	const cEntity & m_Entity;
+	char m_RelX, m_RelY, m_RelZ;
+} ;
+
+
+
+
+
+class cEntityRelMoveLookPacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityRelMoveLookPacket(const cEntity & a_Entity, char a_RelX, char a_RelY, char a_RelZ) :
+		m_Entity(a_Entity), m_RelX(a_RelX), m_RelY(a_RelY), m_RelZ(a_RelZ) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendEntityRelMoveLook(m_Entity, m_RelX, m_RelY, m_RelZ); }
+protected:
+	const cEntity & m_Entity;
+	char m_RelX, m_RelY, m_RelZ;
+} ;
+
+
+
+
+
+class cEntityTeleportPacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityTeleportPacket(const cEntity & a_Entity) : m_Entity(a_Entity) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendTeleportEntity(m_Entity); }
+protected:
+	const cEntity & m_Entity;
+} ;
+
+
+
+
+
+class cEntityVelocityPacket :
+	public cBroadcastPacket
+{
+public:
+	cEntityVelocityPacket(const cEntity & a_Entity) : m_Entity(a_Entity) {}
+	virtual void SendTo(cProtocol & a_Protocol) override { a_Protocol.SendEntityVelocity(m_Entity); }
+protected:
+	const cEntity & m_Entity;
+} ;
+
+
+
+
@@ -0,0 +1,109 @@
+
+// PacketBroadcaster.cpp
+
+// Implements the cPacketBroadcaster class representing a helper that sends a single packet to multiple clients,
+// serializing it only once per protocol version
+
+#include "Globals.h"
+#include "PacketBroadcaster.h"
+#include "../ClientHandle.h"
+
+
+
+
+
+cCriticalSection cPacketBroadcaster::s_CSStats;
+Int64 cPacketBroadcaster::s_NumBytesSerialized = 0;
+Int64 cPacketBroadcaster::s_NumBytesSent = 0;
+
+
+
+
+
+cPacketBroadcaster::cPacketBroadcaster(cBroadcastPacket & a_Packet) :
+	m_Packet(a_Packet),
+	m_NumBytesSerialized(0),
+	m_NumBytesSent(0)
+{
+}
+
+
+
+
+
+cPacketBroadcaster::~cPacketBroadcaster()
+{
+	if (m_NumBytesSent == 0)
+	{
+		// Nobody to send to, don't bother locking
+		return;
+	}
+	cCSLock Lock(s_CSStats);
+	s_NumBytesSerialized += m_NumBytesSerialized;
+	s_NumBytesSent += m_NumBytesSent;
+}
+
+
+
+
+
+size_t cPacketBroadcaster::SendTo(cClientHandle & a_Client)
+{
+	int Format = a_Client.GetBroadcastFormat();
+	if (Format == 0)
+	{
+		// The client's protocol isn't known (yet), serialize just for this client:
+		AString Data;
+		a_Client.SerializeBroadcast(m_Packet, Data);
+		a_Client.SendSerialized(Data);
+		m_NumBytesSerialized += Data.size();
+		m_NumBytesSent += Data.size();
+		return Data.size();
+	}
+	
+	for (cSerializations::const_iterator itr = m_Serializations.begin(), end = m_Serializations.end(); itr != end; ++itr)
+	{
+		if (itr->m_Format == Format)
+		{
+			a_Client.SendSerialized(itr->m_Data);
+			m_NumBytesSent += itr->m_Data.size();
+			return itr->m_Data.size();
+		}
+	}
+	
+	// Not serialized for this format yet:
+	m_Serializations.push_back(sSerialization());
+	sSerialization & Serialization = m_Serializations.back();
+	Serialization.m_Format = Format;
+	a_Client.SerializeBroadcast(m_Packet, Serialization.m_Data);
+	a_Client.SendSerialized(Serialization.m_Data);
+	m_NumBytesSerialized += Serialization.m_Data.size();
+	m_NumBytesSent += Serialization.m_Data.size();
+	return Serialization.m_Data.size();
+}
+
+
+
+
+
+void cPacketBroadcaster::GetStats(Int64 & a_NumBytesSerialized, Int64 & a_NumBytesSent)
+{
+	cCSLock Lock(s_CSStats);
+	a_NumBytesSerialized = s_NumBytesSerialized;
+	a_NumBytesSent = s_NumBytesSent;
+}
+
+
+
+
+
+void cPacketBroadcaster::ResetStats(void)
+{
+	cCSLock Lock(s_CSStats);
+	s_NumBytesSerialized = 0;
+	s_NumBytesSent = 0;
+}
+
+
+
+
@@ -0,0 +1,74 @@
+
+// PacketBroadcaster.h
+
+// Interfaces to the cPacketBroadcaster class representing a helper that sends a single packet to multiple clients,
+// serializing it only once per protocol version (broadcast format) instead of once per client
+
+
+
+
+
+#pragma once
+
+#include "Protocol.h"
+
+
+
+
+
+// fwd:
+class cClientHandle;
+
+
+
+
+
+class cPacketBroadcaster
+{
+public:
+	cPacketBroadcaster(cBroadcastPacket & a_Packet);
+	
+	/** Adds the byte counts of this broadcast to the global stats */
+	~cPacketBroadcaster();
+	
+	/** Sends the packet to the specified client, serializing it only if no client of the same format has been sent to yet.
+	Returns the number of bytes sent. */
+	size_t SendTo(cClientHandle & a_Client);
+	
+	/** Returns the total number of bytes serialized and sent by all the broadcasters since the start (or the last reset) */
+	static void GetStats(Int64 & a_NumBytesSerialized, Int64 & a_NumBytesSent);
+	
+	/** Resets the global stats */
+	static void ResetStats(void);
+	
+protected:
+	/** A single serialization of the packet, in the specified broadcast format */
+	struct sSerialization
+	{
+		int m_Format;
+		AString m_Data;
+	} ;
+	
+	/** Serializations are looked up linearly, there are only ever a few protocol versions connected at once */
+	typedef std::vector<sSerialization> cSerializations;
+	
+	cBroadcastPacket & m_Packet;
+	
+	cSerializations m_Serializations;
+	
+	/** Bytes serialized by this broadcaster */
+	Int64 m_NumBytesSerialized;
+	
+	/** Bytes sent to the clients by this broadcaster */
+	Int64 m_NumBytesSent;
+	
+	/** Protects the global stats */
+	static cCriticalSection s_CSStats;
+	
+	static Int64 s_NumBytesSerialized;
+	static Int64 s_NumBytesSent;
+} ;
+
+
+
+
@@ -31,6 +31,7 @@ class cMonster;
 class cChunkDataSerializer;
 class cFallingBlock;
 class cCompositeChat;
+class cProtocol;
 
 
 
@@ -42,15 +43,53 @@ typedef unsigned char Byte;
 
 
 
+/** A packet that is broadcast to many clients. Instead of each client's protocol serializing it separately, it is
+serialized once for each broadcast format and the same bytes are sent to all the clients (cPacketBroadcaster). */
+class cBroadcastPacket
+{
+public:
+	virtual ~cBroadcastPacket() {}
+	
+	/** Sends the packet through the protocol's regular SendXYZ() function */
+	virtual void SendTo(cProtocol & a_Protocol) = 0;
+} ;
+
+
+
+
+
 class cProtocol
 {
 public:
 	cProtocol(cClientHandle * a_Client) :
-		m_Client(a_Client)
+		m_Client(a_Client),
+		m_SerializeInto(NULL)
 	{
 	}
 	virtual ~cProtocol() {}
 	
+	/** Returns the ID of the format in which this protocol serializes the broadcast packets; protocols with the same ID
+	produce identical bytes for the same packet. 0 means that the protocol isn't known yet and its packets mustn't be shared. */
+	virtual int GetBroadcastFormat(void) { return 0; }
+	
+	/** Serializes the packet into a_Data (appends), in this protocol's format, instead of sending it */
+	virtual void SerializeBroadcast(cBroadcastPacket & a_Packet, AString & a_Data)
+	{
+		cCSLock Lock(m_CSPacket);
+		ASSERT(m_SerializeInto == NULL);
+		m_SerializeInto = &a_Data;
+		a_Packet.SendTo(*this);
+		m_SerializeInto = NULL;
+	}
+	
+	/** Sends the packet data serialized by SerializeBroadcast() of a protocol with the same broadcast format */
+	virtual void SendSerialized(const AString & a_Data)
+	{
+		cCSLock Lock(m_CSPacket);
+		SendData(a_Data.data(), a_Data.size());
+		Flush();
+	}
+	
 	/// Called when client sends some data
 	virtual void DataReceived(const char * a_Data, size_t a_Size) = 0;
 	
@@ -131,6 +170,9 @@ protected:
 	cClientHandle * m_Client;
 	cCriticalSection m_CSPacket;  //< Each SendXYZ() function must acquire this CS in order to send the whole packet at once
 	
+	/// If not NULL, SerializeBroadcast() is in progress and SendData() must append the (unencrypted) data here instead of sending it
+	AString * m_SerializeInto;
+	
 	/// A generic data-sending routine, all outgoing packet data needs to be routed through this so that descendants may override it
 	virtual void SendData(const char * a_Data, size_t a_Size) = 0;
 	
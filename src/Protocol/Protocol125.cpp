@@ -12,6 +12,7 @@ Documentation:
 #include "Globals.h"
 
 #include "Protocol125.h"
+#include "ProtocolRecognizer.h"
 
 #include "../ClientHandle.h"
 #include "../World.h"
@@ -139,6 +140,15 @@ cProtocol125::cProtocol125(cClientHandle * a_Client) :
 
 
 
+int cProtocol125::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_2_5;
+}
+
+
+
+
+
 void cProtocol125::SendAttachEntity(const cEntity & a_Entity, const cEntity * a_Vehicle)
 {
 	cCSLock Lock(m_CSPacket);
@@ -1155,6 +1165,11 @@ AString cProtocol125::GetAuthServerID(void)
 
 void cProtocol125::SendData(const char * a_Data, size_t a_Size)
 {
+	if (m_SerializeInto != NULL)
+	{
+		m_SerializeInto->append(a_Data, a_Size);
+		return;
+	}
 	m_Client->SendData(a_Data, a_Size);
 }
 
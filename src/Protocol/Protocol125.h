@@ -24,6 +24,8 @@ class cProtocol125 :
 public:
 	cProtocol125(cClientHandle * a_Client);
 	
+	virtual int GetBroadcastFormat(void) override;
+	
 	/// Called when client sends some data:
 	virtual void DataReceived(const char * a_Data, size_t a_Size) override;
 	
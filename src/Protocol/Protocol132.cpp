@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include "ChunkDataSerializer.h"
 #include "Protocol132.h"
+#include "ProtocolRecognizer.h"
 #include "../Root.h"
 #include "../Server.h"
 #include "../World.h"
@@ -96,6 +97,15 @@ cProtocol132::cProtocol132(cClientHandle * a_Client) :
 
 
 
+int cProtocol132::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_3_2;
+}
+
+
+
+
+
 cProtocol132::~cProtocol132()
 {
 	if (!m_DataToSend.empty())
@@ -616,6 +626,11 @@ int cProtocol132::ParseTabCompletion(void)
 
 void cProtocol132::SendData(const char * a_Data, size_t a_Size)
 {
+	if (m_SerializeInto != NULL)
+	{
+		m_SerializeInto->append(a_Data, a_Size);
+		return;
+	}
 	m_DataToSend.append(a_Data, a_Size);
 }
 
@@ -627,29 +642,20 @@ void cProtocol132::Flush(void)
 {
 	ASSERT(m_CSPacket.IsLockedByCurrentThread());  // Did all packets lock the CS properly?
 	
-	if (m_DataToSend.empty())
+	if (m_SerializeInto != NULL)
 	{
-		LOGD("Flushing empty");
+		// Serializing a broadcast packet, the data went into m_SerializeInto
 		return;
 	}
-	const char * Data = m_DataToSend.data();
-	size_t Size = m_DataToSend.size();
-	if (m_IsEncrypted)
-	{
-		Byte Encrypted[8192];  // Larger buffer, we may be sending lots of data (chunks)
-		while (Size > 0)
-		{
-			size_t NumBytes = (Size > sizeof(Encrypted)) ? sizeof(Encrypted) : Size;
-			m_Encryptor.ProcessData(Encrypted, (Byte *)Data, NumBytes);
-			super::SendData((const char *)Encrypted, NumBytes);
-			Size -= NumBytes;
-			Data += NumBytes;
-		}
-	}
-	else
+	if (m_DataToSend.empty())
 	{
-		super::SendData(Data, Size);
+		LOGD("Flushing empty");
+		return;
 	}
+	
+	// The data has been copied once into the staging buffer, and is encrypted while being copied into the client's outgoing chain:
+	m_Client->AddOutgoingBytesCopied(m_DataToSend.size());
+	m_Client->SendData(m_DataToSend.data(), m_DataToSend.size(), m_IsEncrypted ? &m_Encryptor : NULL);
 	m_DataToSend.clear();
 }
 
@@ -37,6 +37,8 @@ class cProtocol132 :
 public:
 
 	cProtocol132(cClientHandle * a_Client);
+	
+	virtual int GetBroadcastFormat(void) override;
 	virtual ~cProtocol132();
 
 	/// Called when client sends some data:
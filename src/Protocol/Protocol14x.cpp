@@ -13,6 +13,7 @@ Implements the 1.4.x protocol classes representing these protocols:
 
 #include "Globals.h"
 #include "Protocol14x.h"
+#include "ProtocolRecognizer.h"
 #include "../Root.h"
 #include "../Server.h"
 #include "../ClientHandle.h"
@@ -78,6 +79,15 @@ cProtocol142::cProtocol142(cClientHandle * a_Client) :
 
 
 
+int cProtocol142::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_4_2;
+}
+
+
+
+
+
 int cProtocol142::ParseLocaleViewDistance(void)
 {
 	HANDLE_PACKET_READ(ReadBEUTF16String16, AString, Locale);
@@ -156,6 +166,15 @@ cProtocol146::cProtocol146(cClientHandle * a_Client) :
 
 
 
+int cProtocol146::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_4_6;
+}
+
+
+
+
+
 void cProtocol146::SendPickupSpawn(const cPickup & a_Pickup)
 {
 	ASSERT(!a_Pickup.GetItem().IsEmpty());
@@ -30,6 +30,8 @@ class cProtocol142 :
 	
 public:
 	cProtocol142(cClientHandle * a_Client);
+	
+	virtual int GetBroadcastFormat(void) override;
 
 	// Sending commands (alphabetically sorted):
 	virtual void SendPickupSpawn        (const cPickup & a_Pickup) override;
@@ -52,6 +54,8 @@ class cProtocol146 :
 public:
 	cProtocol146(cClientHandle * a_Client);
 	
+	virtual int GetBroadcastFormat(void) override;
+	
 	virtual void SendPickupSpawn      (const cPickup & a_Pickup) override;
 	virtual void SendSpawnFallingBlock(const cFallingBlock & a_FallingBlock) override;
 	virtual void SendSpawnObject      (const cEntity & a_Entity, char a_ObjectType, int a_ObjectData, Byte a_Yaw, Byte a_Pitch) override;
@@ -10,6 +10,7 @@ Implements the 1.5.x protocol classes:
 
 #include "Globals.h"
 #include "Protocol15x.h"
+#include "ProtocolRecognizer.h"
 #include "../ClientHandle.h"
 #include "../Item.h"
 #include "../UI/Window.h"
@@ -59,6 +60,15 @@ cProtocol150::cProtocol150(cClientHandle * a_Client) :
 
 
 
+int cProtocol150::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_5_0;
+}
+
+
+
+
+
 void cProtocol150::SendWindowOpen(const cWindow & a_Window)
 {
 	if (a_Window.GetWindowType() < 0)
@@ -28,6 +28,8 @@ class cProtocol150 :
 public:
 	cProtocol150(cClientHandle * a_Client);
 	
+	virtual int GetBroadcastFormat(void) override;
+	
 	virtual void SendWindowOpen          (const cWindow & a_Window) override;
 	virtual void SendParticleEffect      (const AString & a_ParticleName, float a_SrcX, float a_SrcY, float a_SrcZ, float a_OffsetX, float a_OffsetY, float a_OffsetZ, float a_ParticleData, int a_ParticleAmmount) override;
 	virtual void SendScoreboardObjective (const AString & a_Name, const AString & a_DisplayName, Byte a_Mode) override;
@@ -14,6 +14,7 @@ Implements the 1.6.x protocol classes:
 
 #include "Globals.h"
 #include "Protocol16x.h"
+#include "ProtocolRecognizer.h"
 #include "../ClientHandle.h"
 #include "../Entities/Entity.h"
 #include "../Entities/Player.h"
@@ -67,6 +68,15 @@ cProtocol161::cProtocol161(cClientHandle * a_Client) :
 
 
 
+int cProtocol161::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_6_1;
+}
+
+
+
+
+
 void cProtocol161::SendAttachEntity(const cEntity & a_Entity, const cEntity * a_Vehicle)
 {
 	cCSLock Lock(m_CSPacket);
@@ -273,6 +283,15 @@ cProtocol162::cProtocol162(cClientHandle * a_Client) :
 
 
 
+int cProtocol162::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_6_2;
+}
+
+
+
+
+
 void cProtocol162::SendPlayerMaxSpeed(void)
 {
 	cCSLock Lock(m_CSPacket);
@@ -32,6 +32,8 @@ class cProtocol161 :
 public:
 	cProtocol161(cClientHandle * a_Client);
 	
+	virtual int GetBroadcastFormat(void) override;
+	
 protected:
 
 	// cProtocol150 overrides:
@@ -66,6 +68,8 @@ class cProtocol162 :
 	
 public:
 	cProtocol162(cClientHandle * a_Client);
+	
+	virtual int GetBroadcastFormat(void) override;
 
 protected:
 	// cProtocol161 overrides:
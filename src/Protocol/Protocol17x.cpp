@@ -10,6 +10,7 @@ Implements the 1.7.x protocol classes:
 #include "Globals.h"
 #include "json/json.h"
 #include "Protocol17x.h"
+#include "ProtocolRecognizer.h"
 #include "ChunkDataSerializer.h"
 #include "../ClientHandle.h"
 #include "../Root.h"
@@ -98,6 +99,15 @@ cProtocol172::cProtocol172(cClientHandle * a_Client, const AString & a_ServerAdd
 
 
 
+int cProtocol172::GetBroadcastFormat(void)
+{
+	return cProtocolRecognizer::PROTO_VERSION_1_7_2;
+}
+
+
+
+
+
 void cProtocol172::DataReceived(const char * a_Data, size_t a_Size)
 {
 	if (m_IsEncrypted)
@@ -1990,22 +2000,14 @@ void cProtocol172::WritePacket(cByteBuffer & a_Packet)
 
 void cProtocol172::SendData(const char * a_Data, size_t a_Size)
 {
-	if (m_IsEncrypted)
-	{
-		Byte Encrypted[8192];  // Larger buffer, we may be sending lots of data (chunks)
-		while (a_Size > 0)
-		{
-			size_t NumBytes = (a_Size > sizeof(Encrypted)) ? sizeof(Encrypted) : a_Size;
-			m_Encryptor.ProcessData(Encrypted, (Byte *)a_Data, NumBytes);
-			m_Client->SendData((const char *)Encrypted, NumBytes);
-			a_Size -= NumBytes;
-			a_Data += NumBytes;
-		}
-	}
-	else
+	if (m_SerializeInto != NULL)
 	{
-		m_Client->SendData(a_Data, a_Size);
+		m_SerializeInto->append(a_Data, a_Size);
+		return;
 	}
+	
+	// The data is encrypted while being copied into the client's outgoing chain:
+	m_Client->SendData(a_Data, a_Size, m_IsEncrypted ? &m_Encryptor : NULL);
 }
 
 
@@ -2233,30 +2235,45 @@ void cProtocol172::AddChatPartStyle(Json::Value & a_Value, const AString & a_Par
 
 cProtocol172::cPacketizer::~cPacketizer()
 {
-	AString DataToSend;
-
-	// Send the packet length
-	UInt32 PacketLen = m_Out.GetUsedSpace();
-	m_Protocol.m_OutPacketLenBuffer.WriteVarInt(PacketLen);
-	m_Protocol.m_OutPacketLenBuffer.ReadAll(DataToSend);
-	m_Protocol.SendData(DataToSend.data(), DataToSend.size());
-	m_Protocol.m_OutPacketLenBuffer.CommitRead();
-	
-	// Send the packet data:
-	m_Out.ReadAll(DataToSend);
-	m_Protocol.SendData(DataToSend.data(), DataToSend.size());
-	m_Out.CommitRead();
-	
 	// Log the comm into logfile:
+	UInt32 PacketLen = (UInt32)m_Out.GetUsedSpace();
 	if (g_ShouldLogCommOut)
 	{
-		AString Hex;
-		ASSERT(DataToSend.size() > 0);
-		CreateHexDump(Hex, DataToSend.data() + 1, DataToSend.size() - 1, 16);
+		AString DataToLog, Hex;
+		m_Out.ReadAll(DataToLog);
+		m_Out.ResetRead();
+		ASSERT(DataToLog.size() > 0);
+		CreateHexDump(Hex, DataToLog.data() + 1, DataToLog.size() - 1, 16);
 		m_Protocol.m_CommLogFile.Printf("Outgoing packet: type %d (0x%x), length %u (0x%x), state %d. Payload:\n%s\n",
-			DataToSend[0], DataToSend[0], PacketLen, PacketLen, m_Protocol.m_State, Hex.c_str()
+			DataToLog[0], DataToLog[0], PacketLen, PacketLen, m_Protocol.m_State, Hex.c_str()
 		);
 	}
+	
+	// Send the packet length, then the packet data, directly from the buffers; the client's outgoing chain makes the only copy:
+	m_Protocol.m_OutPacketLenBuffer.WriteVarInt(PacketLen);
+	SendBuffer(m_Protocol.m_OutPacketLenBuffer);
+	SendBuffer(m_Out);
+}
+
+
+
+
+
+void cProtocol172::cPacketizer::SendBuffer(cByteBuffer & a_Buffer)
+{
+	const char * Part1, * Part2;
+	size_t Size1, Size2;
+	a_Buffer.GetReadableParts(Part1, Size1, Part2, Size2);
+	if (Size1 > 0)
+	{
+		m_Protocol.SendData(Part1, Size1);
+	}
+	if (Size2 > 0)
+	{
+		m_Protocol.SendData(Part2, Size2);
+	}
+	a_Buffer.SkipRead(Size1 + Size2);
+	a_Buffer.CommitRead();
 }
 
 
@@ -55,6 +55,8 @@ public:
 
 	cProtocol172(cClientHandle * a_Client, const AString & a_ServerAddress, UInt16 a_ServerPort, UInt32 a_State);
 	
+	virtual int GetBroadcastFormat(void) override;
+	
 	/** Called when client sends some data: */
 	virtual void DataReceived(const char * a_Data, size_t a_Size) override;
 
@@ -213,6 +215,9 @@ protected:
 		cProtocol172 & m_Protocol;
 		cByteBuffer & m_Out;
 		cCSLock m_Lock;
+		
+		/** Sends all the readable data of the buffer through the protocol, without copying it out first, and consumes it */
+		void SendBuffer(cByteBuffer & a_Buffer);
 	} ;
 
 	AString m_ServerAddress;
@@ -794,6 +794,35 @@ AString cProtocolRecognizer::GetAuthServerID(void)
 
 
 
+int cProtocolRecognizer::GetBroadcastFormat(void)
+{
+	return (m_Protocol == NULL) ? 0 : m_Protocol->GetBroadcastFormat();
+}
+
+
+
+
+
+void cProtocolRecognizer::SerializeBroadcast(cBroadcastPacket & a_Packet, AString & a_Data)
+{
+	ASSERT(m_Protocol != NULL);
+	m_Protocol->SerializeBroadcast(a_Packet, a_Data);
+}
+
+
+
+
+
+void cProtocolRecognizer::SendSerialized(const AString & a_Data)
+{
+	ASSERT(m_Protocol != NULL);
+	m_Protocol->SendSerialized(a_Data);
+}
+
+
+
+
+
 void cProtocolRecognizer::SendData(const char * a_Data, size_t a_Size)
 {
 	// This is used only when handling the server ping
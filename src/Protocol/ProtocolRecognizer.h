@@ -133,6 +133,11 @@ public:
 	
 	virtual AString GetAuthServerID(void) override;
 
+	// Broadcast serialization is forwarded to the recognized protocol:
+	virtual int  GetBroadcastFormat(void) override;
+	virtual void SerializeBroadcast(cBroadcastPacket & a_Packet, AString & a_Data) override;
+	virtual void SendSerialized    (const AString & a_Data) override;
+
 	virtual void SendData(const char * a_Data, size_t a_Size) override;
 
 protected:
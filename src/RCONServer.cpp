@@ -212,9 +212,9 @@ void cRCONServer::cConnection::DataReceived(const char * a_Data, size_t a_Size)
 
 
 
-void cRCONServer::cConnection::GetOutgoingData(AString & a_Data)
+void cRCONServer::cConnection::GetOutgoingData(cBufferChain & a_Data)
 {
-	a_Data.assign(m_Outgoing);
+	a_Data.Append(m_Outgoing);
 	m_Outgoing.clear();
 }
 
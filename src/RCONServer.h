@@ -66,7 +66,7 @@ protected:
 
 		// cSocketThreads::cCallback overrides:
 		virtual void DataReceived(const char * a_Data, size_t a_Size) override;
-		virtual void GetOutgoingData(AString & a_Data) override;
+		virtual void GetOutgoingData(cBufferChain & a_Data) override;
 		virtual void SocketClosed(void) override;
 		
 		/// Processes the given packet and sends the response; returns true if successful, false if the connection is to be dropped
@@ -15,6 +15,7 @@
 #include "Items/ItemHandler.h"
 #include "Chunk.h"
 #include "Protocol/ProtocolRecognizer.h"  // for protocol version constants
+#include "Protocol/PacketBroadcaster.h"
 #include "CommandOutput.h"
 #include "DeadlockDetect.h"
 #include "OSSupport/Timer.h"
@@ -44,6 +45,7 @@ cRoot* cRoot::s_Root = NULL;
 
 cRoot::cRoot(void) :
 	m_PrimaryServerVersion(cProtocolRecognizer::PROTO_VERSION_LATEST),
+	m_NumLightingThreads(1),
 	m_pDefaultWorld(NULL),
 	m_InputThread(NULL),
 	m_Server(NULL),
@@ -161,6 +163,8 @@ void cRoot::Start(void)
 		m_CraftingRecipes = new cCraftingRecipes;
 		m_FurnaceRecipe   = new cFurnaceRecipe();
 		
+		m_NumLightingThreads = std::max(1, IniFile.GetValueSetI("Lighting", "NumThreads", 2));
+		
 		LOGD("Loading worlds...");
 		LoadWorlds(IniFile);
 
@@ -754,11 +758,16 @@ int cRoot::GetPhysicalRAMUsage(void)
 
 void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 {
+	// The size of the block data if each chunk stored full arrays for the whole column:
+	const int FullBlockDataSize = sizeof(cChunkDef::BlockTypes) + 3 * sizeof(cChunkDef::BlockNibbles);
+	const int SectionSize = sizeof(cChunkData::sChunkSection);
+	
 	int SumNumValid = 0;
 	int SumNumDirty = 0;
 	int SumNumInLighting = 0;
 	int SumNumInGenerator = 0;
 	int SumMem = 0;
+	int SumSaved = 0;
 	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
 	{
 		cWorld * World = itr->second;
@@ -768,29 +777,46 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 		int NumValid = 0;
 		int NumDirty = 0;
 		int NumInLighting = 0;
-		World->GetChunkStats(NumValid, NumDirty, NumInLighting);
+		int NumSections = 0;
+		World->GetChunkStats(NumValid, NumDirty, NumInLighting, NumSections);
 		a_Output.Out("World %s:", World->GetName().c_str());
 		a_Output.Out("  Num loaded chunks: %d", NumValid);
 		a_Output.Out("  Num dirty chunks: %d", NumDirty);
 		a_Output.Out("  Num chunks in lighting queue: %d", NumInLighting);
+		int NumLightingPending, NumLightingQueued, NumLightingInProgress, NumLightingThreads;
+		World->GetLightingStats(NumLightingPending, NumLightingQueued, NumLightingInProgress, NumLightingThreads);
+		a_Output.Out("    waiting for neighbors: %d, ready: %d, being lighted: %d (%d threads)",
+			NumLightingPending, NumLightingQueued, NumLightingInProgress, NumLightingThreads
+		);
 		a_Output.Out("  Num chunks in generator queue: %d", NumInGenerator);
 		a_Output.Out("  Num chunks in storage load queue: %d", NumInLoadQueue);
 		a_Output.Out("  Num chunks in storage save queue: %d", NumInSaveQueue);
-		int Mem = NumValid * sizeof(cChunk);
+		int NumCachedPackets, NumCacheHits, NumCacheMisses;
+		size_t CachedPacketsSize;
+		World->GetChunkPacketCache().GetStats(NumCachedPackets, CachedPacketsSize, NumCacheHits, NumCacheMisses);
+		a_Output.Out("  Chunk packet cache: %d packets (" SIZE_T_FMT " KiB), %d hits, %d misses",
+			NumCachedPackets, (CachedPacketsSize + 1023) / 1024, NumCacheHits, NumCacheMisses
+		);
+		int BlockDataMem = NumSections * SectionSize;
+		int Mem = NumValid * sizeof(cChunk) + BlockDataMem;
+		int Saved = NumValid * FullBlockDataSize - BlockDataMem;
 		a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (Mem + 1023) / 1024, (Mem + 1024 * 1024 - 1) / (1024 * 1024));
+		a_Output.Out("  Block data sections allocated: %d of %d (%d KiB)", NumSections, NumValid * cChunkData::NumSections, (BlockDataMem + 1023) / 1024);
+		a_Output.Out("  Memory saved by not allocating empty sections: %d KiB (%d MiB)", (Saved + 1023) / 1024, (Saved + 1024 * 1024 - 1) / (1024 * 1024));
 		a_Output.Out("  Per-chunk memory size breakdown:");
-		a_Output.Out("    block types:    " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BlockTypes), (sizeof(cChunkDef::BlockTypes) + 1023) / 1024);
-		a_Output.Out("    block metadata: " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BlockNibbles), (sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
-		a_Output.Out("    block lighting: " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", 2 * sizeof(cChunkDef::BlockNibbles), (2 * sizeof(cChunkDef::BlockNibbles) + 1023) / 1024);
+		a_Output.Out("    block data:     " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB) per allocated section, %d bytes per chunk on average",
+			sizeof(cChunkData::sChunkSection), (sizeof(cChunkData::sChunkSection) + 1023) / 1024, (NumValid > 0) ? (BlockDataMem / NumValid) : 0
+		);
 		a_Output.Out("    heightmap:      " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::HeightMap), (sizeof(cChunkDef::HeightMap) + 1023) / 1024);
 		a_Output.Out("    biomemap:       " SIZE_T_FMT_PRECISION(6)  " bytes (" SIZE_T_FMT_PRECISION(3)  " KiB)", sizeof(cChunkDef::BiomeMap), (sizeof(cChunkDef::BiomeMap) + 1023) / 1024);
-		int Rest = sizeof(cChunk) - sizeof(cChunkDef::BlockTypes) - 3 * sizeof(cChunkDef::BlockNibbles) - sizeof(cChunkDef::HeightMap) - sizeof(cChunkDef::BiomeMap);
+		int Rest = sizeof(cChunk) - sizeof(cChunkDef::HeightMap) - sizeof(cChunkDef::BiomeMap);
 		a_Output.Out("    other:          %6d bytes (%3d KiB)", Rest, (Rest + 1023) / 1024);
 		SumNumValid += NumValid;
 		SumNumDirty += NumDirty;
 		SumNumInLighting += NumInLighting;
 		SumNumInGenerator += NumInGenerator;
 		SumMem += Mem;
+		SumSaved += Saved;
 	}
 	a_Output.Out("Totals:");
 	a_Output.Out("  Num loaded chunks: %d", SumNumValid);
@@ -798,6 +824,48 @@ void cRoot::LogChunkStats(cCommandOutputCallback & a_Output)
 	a_Output.Out("  Num chunks in lighting queue: %d", SumNumInLighting);
 	a_Output.Out("  Num chunks in generator queue: %d", SumNumInGenerator);
 	a_Output.Out("  Memory used by chunks: %d KiB (%d MiB)", (SumMem + 1023) / 1024, (SumMem + 1024 * 1024 - 1) / (1024 * 1024));
+	a_Output.Out("  Memory saved by not allocating empty sections: %d KiB (%d MiB)", (SumSaved + 1023) / 1024, (SumSaved + 1024 * 1024 - 1) / (1024 * 1024));
+}
+
+
+
+
+
+void cRoot::LogTickProfile(cCommandOutputCallback & a_Output, bool a_ShouldReset)
+{
+	m_Server->GetTickProfiler().WriteReport(a_Output);
+	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
+	{
+		itr->second->GetTickProfiler().WriteReport(a_Output);
+	}
+	Int64 NumBytesSerialized, NumBytesSent;
+	cPacketBroadcaster::GetStats(NumBytesSerialized, NumBytesSent);
+	a_Output.Out("Broadcast packets: %lld bytes serialized, %lld bytes sent", (long long)NumBytesSerialized, (long long)NumBytesSent);
+	if (!a_ShouldReset)
+	{
+		return;
+	}
+	m_Server->GetTickProfiler().Reset();
+	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
+	{
+		itr->second->GetTickProfiler().Reset();
+	}
+	cPacketBroadcaster::ResetStats();
+	a_Output.Out("Tick profiles have been reset.");
+}
+
+
+
+
+
+AString cRoot::GetTickProfileHTML(void)
+{
+	AString res = m_Server->GetTickProfiler().GetHTMLReport();
+	for (WorldMap::iterator itr = m_WorldsByName.begin(), end = m_WorldsByName.end(); itr != end; ++itr)
+	{
+		res.append(itr->second->GetTickProfiler().GetHTMLReport());
+	}
+	return res;
 }
 
 
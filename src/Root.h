@@ -52,9 +52,18 @@ public:
 	/// Writes chunkstats, for each world and totals, to the output callback
 	void LogChunkStats(cCommandOutputCallback & a_Output);
 	
+	/** Writes the tick profiler statistics of the server and each world to the output callback; clears them afterwards if a_ShouldReset is true */
+	void LogTickProfile(cCommandOutputCallback & a_Output, bool a_ShouldReset);
+	
+	/** Returns the tick profiler statistics of the server and each world, as HTML for the webadmin */
+	AString GetTickProfileHTML(void);
+	
 	int GetPrimaryServerVersion(void) const { return m_PrimaryServerVersion; }  // tolua_export
 	void SetPrimaryServerVersion(int a_Version) { m_PrimaryServerVersion = a_Version; }  // tolua_export
 	
+	/** Returns the number of lighting worker threads each world should use, as configured in settings.ini */
+	int GetNumLightingThreads(void) const { return m_NumLightingThreads; }
+	
 	cMonsterConfig * GetMonsterConfig(void) { return m_MonsterConfig; }
 
 	cGroupManager *    GetGroupManager   (void) { return m_GroupManager; }     // tolua_export
@@ -153,6 +162,9 @@ private:
 	
 	/// The version of the protocol that is primary for the server (reported in the server list). All versions are still supported.
 	int m_PrimaryServerVersion;
+	
+	/** Number of the lighting worker threads in each world, read from settings.ini */
+	int m_NumLightingThreads;
 
 	cWorld * m_pDefaultWorld;
 	WorldMap m_WorldsByName;
@@ -84,7 +84,11 @@ void cServer::cTickThread::Execute(void)
 	{
 		long long NowTime = Timer.GetNowTime();
 		float DeltaTime = (float)(NowTime-LastTime);
-		m_ShouldTerminate = !m_Server.Tick(DeltaTime);
+		{
+			cTickProfiler::cScope Scope(m_Server.GetTickProfiler(), cTickProfiler::psTick);
+			m_ShouldTerminate = !m_Server.Tick(DeltaTime);
+		}
+		m_Server.GetTickProfiler().EndTick();
 		long long TickTime = Timer.GetNowTime() - NowTime;
 		
 		if (TickTime < msPerTick)
@@ -110,6 +114,7 @@ cServer::cServer(void) :
 	m_bIsConnected(false),
 	m_bRestarting(false),
 	m_RCONServer(*this),
+	m_TickProfiler("Server"),
 	m_TickThread(*this)
 {
 }
@@ -193,6 +198,7 @@ bool cServer::InitServer(cIniFile & a_SettingsIni)
 	m_Description = a_SettingsIni.GetValueSet("Server", "Description", "MCServer - in C++!").c_str();
 	m_MaxPlayers  = a_SettingsIni.GetValueSetI("Server", "MaxPlayers", 100);
 	m_bIsHardcore = a_SettingsIni.GetValueSetB("Server", "HardcoreEnabled", false);
+	cInterestManager::ReadSettings(a_SettingsIni);
 	m_PlayerCount = 0;
 	m_PlayerCountDiff = 0;
 
@@ -345,13 +351,22 @@ bool cServer::Tick(float a_Dt)
 	}
 	
 	// Send the tick to the plugins, as well as let the plugin manager reload, if asked to (issue #102):
-	cPluginManager::Get()->Tick(a_Dt);
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psServerPlugins);
+		cPluginManager::Get()->Tick(a_Dt);
+	}
 	
 	// Let the Root process all the queued commands:
-	cRoot::Get()->TickCommands();
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psServerCommands);
+		cRoot::Get()->TickCommands();
+	}
 	
 	// Tick all clients not yet assigned to a world:
-	TickClients(a_Dt);
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psServerClients);
+		TickClients(a_Dt);
+	}
 
 	if (!m_bRestarting)
 	{
@@ -484,6 +499,24 @@ void cServer::ExecuteConsoleCommand(const AString & a_Cmd, cCommandOutputCallbac
 		a_Output.Finished();
 		return;
 	}
+	if (split[0].compare("tickprofile") == 0)
+	{
+		cRoot::Get()->LogTickProfile(a_Output, ((split.size() > 1) && (split[1] == "reset")));
+		a_Output.Finished();
+		return;
+	}
+	if (split[0].compare("pluginstats") == 0)
+	{
+		cPluginManager::Get()->LogPluginStats(a_Output, ((split.size() > 1) && (split[1] == "reset")));
+		a_Output.Finished();
+		return;
+	}
+	if (split[0].compare("netstats") == 0)
+	{
+		PrintNetStats(a_Output);
+		a_Output.Finished();
+		return;
+	}
 	#if defined(_MSC_VER) && defined(_DEBUG) && defined(ENABLE_LEAK_FINDER)
 	if (split[0].compare("dumpmem") == 0)
 	{
@@ -559,6 +592,55 @@ void cServer::PrintHelp(const AStringVector & a_Split, cCommandOutputCallback &
 
 
 
+void cServer::PrintNetStats(cCommandOutputCallback & a_Output)
+{
+	class cCallback :
+		public cPlayerListCallback
+	{
+	public:
+		cCallback(cCommandOutputCallback & a_Output) :
+			m_Output(a_Output),
+			m_TotalSent(0),
+			m_TotalCopied(0)
+		{
+		}
+		
+		virtual bool Item(cPlayer * a_Player) override
+		{
+			cClientHandle * Client = a_Player->GetClientHandle();
+			if (Client == NULL)
+			{
+				return false;
+			}
+			Int64 Sent, Copied;
+			Client->GetOutgoingStats(Sent, Copied);
+			m_Output.Out("  %s: %lld bytes sent, %lld bytes copied (%.2f copies per byte)",
+				a_Player->GetName().c_str(), (long long)Sent, (long long)Copied, (Sent > 0) ? (double)Copied / Sent : 0.0
+			);
+			m_TotalSent += Sent;
+			m_TotalCopied += Copied;
+			return false;
+		}
+		
+		cCommandOutputCallback & m_Output;
+		Int64 m_TotalSent;
+		Int64 m_TotalCopied;
+	} Callback(a_Output);
+	a_Output.Out("Outgoing data per player:");
+	cRoot::Get()->ForEachPlayer(Callback);
+	a_Output.Out("Total: %lld bytes sent, %lld bytes copied", (long long)Callback.m_TotalSent, (long long)Callback.m_TotalCopied);
+	
+	int NumAllocated, NumFree;
+	cBufferChain::GetPoolStats(NumAllocated, NumFree);
+	a_Output.Out("Outgoing block pool: %d blocks of %u bytes allocated, %d of them free",
+		NumAllocated, (unsigned)cBufferChain::BLOCK_SIZE, NumFree
+	);
+}
+
+
+
+
+
 void cServer::BindBuiltInConsoleCommands(void)
 {
 	cPluginManager * PlgMgr = cPluginManager::Get();
@@ -567,6 +649,9 @@ void cServer::BindBuiltInConsoleCommands(void)
 	PlgMgr->BindConsoleCommand("restart", NULL, " - Restarts the server cleanly");
 	PlgMgr->BindConsoleCommand("stop", NULL, " - Stops the server cleanly");
 	PlgMgr->BindConsoleCommand("chunkstats", NULL, " - Displays detailed chunk memory statistics");
+	PlgMgr->BindConsoleCommand("tickprofile", NULL, " - Displays the tick timings of the server and each world; \"tickprofile reset\" clears them");
+	PlgMgr->BindConsoleCommand("pluginstats", NULL, " - Displays the hook call counts and times and the Lua memory of each plugin; \"pluginstats reset\" clears them");
+	PlgMgr->BindConsoleCommand("netstats", NULL, " - Displays the outgoing bytes sent and copied for each player, and the outgoing block pool usage");
 	#if defined(_MSC_VER) && defined(_DEBUG) && defined(ENABLE_LEAK_FINDER)
 	PlgMgr->BindConsoleCommand("dumpmem", NULL, " - Dumps all used memory blocks together with their callstacks into memdump.xml");
 	#endif
@@ -13,6 +13,7 @@
 #include "OSSupport/ListenThread.h"
 
 #include "RCONServer.h"
+#include "TickProfiler.h"
 
 #ifdef _MSC_VER
 	#pragma warning(push)
@@ -76,6 +77,9 @@ public:												// tolua_export
 	
 	/** Lists all available console commands and their helpstrings */
 	void PrintHelp(const AStringVector & a_Split, cCommandOutputCallback & a_Output);
+	
+	/** Lists the outgoing bytes queued and copied for each player, and the state of the outgoing block pool */
+	void PrintNetStats(cCommandOutputCallback & a_Output);
 
 	/** Binds the built-in console commands with the plugin manager */
 	static void BindBuiltInConsoleCommands(void);
@@ -114,6 +118,9 @@ public:												// tolua_export
 	
 	bool ShouldAuthenticate(void) const { return m_ShouldAuthenticate; }
 	
+	/** Returns the timings of the server tick and of the plugin hooks */
+	cTickProfiler & GetTickProfiler(void) { return m_TickProfiler; }
+	
 private:
 
 	friend class cRoot; // so cRoot can create and destroy cServer
@@ -194,6 +201,9 @@ private:
 	int m_MaxPlayers;
 	bool m_bIsHardcore;
 	
+	/** The timings of the server tick and of the plugin hooks (called from any thread) */
+	cTickProfiler m_TickProfiler;
+	
 	cTickThread m_TickThread;
 	cEvent m_RestartEvent;
 	
@@ -17,23 +17,119 @@
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // cDelayedFluidSimulatorChunkData::cSlot
 
+cDelayedFluidSimulatorChunkData::cSlot::cSlot(void) :
+	m_DirtySections(0),
+	m_AllocatedSections(0)
+{
+	for (size_t i = 0; i < ARRAYCOUNT(m_Scheduled); i++)
+	{
+		m_Scheduled[i] = NULL;
+	}
+}
+
+
+
+
+
+cDelayedFluidSimulatorChunkData::cSlot::~cSlot()
+{
+	for (size_t i = 0; i < ARRAYCOUNT(m_Scheduled); i++)
+	{
+		delete[] m_Scheduled[i];
+	}
+}
+
+
+
+
+
+bool cDelayedFluidSimulatorChunkData::cSlot::HasBlock(int a_RelX, int a_RelY, int a_RelZ) const
+{
+	int Section = a_RelY / cChunkData::SectionHeight;
+	if ((m_DirtySections & (1 << Section)) == 0)
+	{
+		return false;
+	}
+	int Index = MakeSectionIndex(a_RelX, a_RelY, a_RelZ);
+	return ((m_Scheduled[Section][Index / 64] & (static_cast<UInt64>(1) << (Index % 64))) != 0);
+}
+
+
+
+
+
 bool cDelayedFluidSimulatorChunkData::cSlot::Add(int a_RelX, int a_RelY, int a_RelZ)
 {
-	ASSERT(a_RelZ >= 0);
-	ASSERT(a_RelZ < static_cast<int>(ARRAYCOUNT(m_Blocks)));
+	ASSERT((a_RelY >= 0) && (a_RelY < cChunkDef::Height));
+	
+	int Section = a_RelY / cChunkData::SectionHeight;
+	UInt64 * & Scheduled = m_Scheduled[Section];
+	if (Scheduled == NULL)
+	{
+		Scheduled = new UInt64[SECTION_WORDS];
+		memset(Scheduled, 0, SECTION_WORDS * sizeof(UInt64));
+		m_AllocatedSections |= (1 << Section);
+	}
+	
+	int Index = MakeSectionIndex(a_RelX, a_RelY, a_RelZ);
+	UInt64 & Word = Scheduled[Index / 64];
+	UInt64 Bit = static_cast<UInt64>(1) << (Index % 64);
+	if ((Word & Bit) != 0)
+	{
+		// Already present
+		return false;
+	}
+	Word |= Bit;
+	m_DirtySections |= (1 << Section);
+	m_Queue.push_back(cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ));
+	return true;
+}
+
+
+
+
+
+void cDelayedFluidSimulatorChunkData::cSlot::TakeAll(std::vector<int> & a_Blocks)
+{
+	a_Blocks.clear();
+	std::swap(a_Blocks, m_Queue);
 	
-	cCoordWithIntVector & Blocks = m_Blocks[a_RelZ];
-	int Index = cChunkDef::MakeIndexNoCheck(a_RelX, a_RelY, a_RelZ);
-	for (cCoordWithIntVector::const_iterator itr = Blocks.begin(), end = Blocks.end(); itr != end; ++itr)
+	// Reset the flags; a whole section is cheaper to clear than a few hundred single bits.
+	// The sections that had nothing scheduled in this round are likely to stay idle, free them:
+	for (int Section = 0; (m_AllocatedSections >> Section) != 0; Section++)
 	{
-		if (itr->Data == Index)
+		UInt16 Mask = (UInt16)(1 << Section);
+		if ((m_DirtySections & Mask) != 0)
 		{
-			// Already present
-			return false;
+			memset(m_Scheduled[Section], 0, SECTION_WORDS * sizeof(UInt64));
 		}
-	}  // for itr - Blocks[]
-	Blocks.push_back(cCoordWithInt(a_RelX, a_RelY, a_RelZ, Index));
-	return true;
+		else if ((m_AllocatedSections & Mask) != 0)
+		{
+			delete[] m_Scheduled[Section];
+			m_Scheduled[Section] = NULL;
+			m_AllocatedSections &= ~Mask;
+		}
+	}
+	m_DirtySections = 0;
+}
+
+
+
+
+
+void cDelayedFluidSimulatorChunkData::cSlot::FreeScheduled(void)
+{
+	ASSERT(m_Queue.empty());
+	if (m_AllocatedSections == 0)
+	{
+		return;
+	}
+	for (size_t i = 0; i < ARRAYCOUNT(m_Scheduled); i++)
+	{
+		delete[] m_Scheduled[i];
+		m_Scheduled[i] = NULL;
+	}
+	m_AllocatedSections = 0;
 }
 
 
@@ -69,8 +165,7 @@ cDelayedFluidSimulator::cDelayedFluidSimulator(cWorld & a_World, BLOCKTYPE a_Flu
 	super(a_World, a_Fluid, a_StationaryFluid),
 	m_TickDelay(a_TickDelay),
 	m_AddSlotNum(a_TickDelay - 1),
-	m_SimSlotNum(0),
-	m_TotalBlocks(0)
+	m_SimSlotNum(0)
 {
 }
 
@@ -104,12 +199,7 @@ void cDelayedFluidSimulator::AddBlock(int a_BlockX, int a_BlockY, int a_BlockZ,
 	cDelayedFluidSimulatorChunkData::cSlot & Slot = ChunkData->m_Slots[m_AddSlotNum];
 	
 	// Add, if not already present:
-	if (!Slot.Add(RelX, a_BlockY, RelZ))
-	{
-		return;
-	}
-
-	++m_TotalBlocks;
+	Slot.Add(RelX, a_BlockY, RelZ);
 }
 
 
@@ -136,21 +226,25 @@ void cDelayedFluidSimulator::SimulateChunk(float a_Dt, int a_ChunkX, int a_Chunk
 	cDelayedFluidSimulatorChunkData * ChunkData = (cDelayedFluidSimulatorChunkData *)ChunkDataRaw;
 	cDelayedFluidSimulatorChunkData::cSlot & Slot = ChunkData->m_Slots[m_SimSlotNum];
 	
+	if (Slot.IsEmpty())
+	{
+		// Nothing to do in this chunk this tick (most chunks, most of the time)
+		// If the slot has drained since the last simulation, release its bitsets:
+		Slot.FreeScheduled();
+		return;
+	}
+	
+	// Take the blocks out before simulating, the simulation may schedule blocks into other slots of this chunk:
+	std::vector<int> & Blocks = ChunkData->m_SimulatingBlocks;
+	Slot.TakeAll(Blocks);
+	
 	// Simulate all the blocks in the scheduled slot:
-	for (size_t i = 0; i < ARRAYCOUNT(Slot.m_Blocks); i++)
+	for (std::vector<int>::const_iterator itr = Blocks.begin(), end = Blocks.end(); itr != end; ++itr)
 	{
-		cCoordWithIntVector & Blocks = Slot.m_Blocks[i];
-		if (Blocks.empty())
-		{
-			continue;
-		}
-		for (cCoordWithIntVector::iterator itr = Blocks.begin(), end = Blocks.end(); itr != end; ++itr)
-		{
-			SimulateBlock(a_Chunk, itr->x, itr->y, itr->z);
-		}
-		m_TotalBlocks -= Blocks.size();
-		Blocks.clear();
+		Vector3i Rel = cChunkDef::IndexToCoordinate(static_cast<unsigned>(*itr));
+		SimulateBlock(a_Chunk, Rel.x, Rel.y, Rel.z);
 	}
+	Blocks.clear();
 }
 
 
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "FluidSimulator.h"
+#include "../ChunkData.h"
 
 
 
@@ -19,19 +20,56 @@ class cDelayedFluidSimulatorChunkData :
 	public cFluidSimulatorData
 {
 public:
+	/** Blocks scheduled for one delay tick.
+	The blocks are kept in a flat queue of block indices, in the order they were added; duplicates are detected using
+	a bitset per chunk section. The bitsets are allocated only for the sections that have ever had a block scheduled,
+	so a chunk without any fluid activity costs only the empty pointers.
+	*/
 	class cSlot
 	{
 	public:
+		cSlot(void);
+		~cSlot();
+		
 		/// Returns true if the specified block is stored
-		bool HasBlock(int a_RelX, int a_RelY, int a_RelZ);
+		bool HasBlock(int a_RelX, int a_RelY, int a_RelZ) const;
 		
 		/// Adds the specified block unless already present; returns true if added, false if the block was already present
 		bool Add(int a_RelX, int a_RelY, int a_RelZ);
 		
-		/** Array of block containers, each item stores blocks for one Z coord
-		Int param is the block index (for faster duplicate comparison in Add())
-		*/
-		cCoordWithIntVector m_Blocks[16];
+		/** Removes all the blocks from the queue into a_Blocks (which is cleared first), and resets the scheduled flags.
+		Swaps the buffers, so that neither the slot nor the caller allocate in the steady state.
+		The bitsets of the sections that had no blocks scheduled are freed, the others are kept for the next round. */
+		void TakeAll(std::vector<int> & a_Blocks);
+		
+		/** Frees the bitsets of all the sections; to be called once the queue has drained. */
+		void FreeScheduled(void);
+		
+		bool IsEmpty(void) const { return m_Queue.empty(); }
+		
+		size_t GetNumBlocks(void) const { return m_Queue.size(); }
+		
+	protected:
+		/** Number of 64-bit words in a section's bitset */
+		static const int SECTION_WORDS = cChunkData::SectionBlockCount / 64;
+		
+		/** Block indices (cChunkDef::MakeIndexNoCheck()) of the scheduled blocks */
+		std::vector<int> m_Queue;
+		
+		/** Bitsets of the scheduled flags, one per section, indexed by the block index within the section; NULL if not allocated yet */
+		UInt64 * m_Scheduled[cChunkData::NumSections];
+		
+		/** Bitmask of the sections that have any block in m_Queue; used for skipping whole sections in HasBlock() and TakeAll() */
+		UInt16 m_DirtySections;
+		
+		/** Bitmask of the sections that have their bitset allocated in m_Scheduled */
+		UInt16 m_AllocatedSections;
+		
+		/** Returns the index of the block's bit within its section's bitset */
+		static int MakeSectionIndex(int a_RelX, int a_RelY, int a_RelZ)
+		{
+			return a_RelX + a_RelZ * cChunkDef::Width + (a_RelY % cChunkData::SectionHeight) * cChunkDef::Width * cChunkDef::Width;
+		}
 	} ;
 	
 	cDelayedFluidSimulatorChunkData(int a_TickDelay);
@@ -39,6 +77,9 @@ public:
 	
 	/// Slots, one for each delay tick, each containing the blocks to simulate
 	cSlot * m_Slots;
+	
+	/// The blocks taken out of a slot for simulating; kept here so that the buffer is reused between the ticks
+	std::vector<int> m_SimulatingBlocks;
 } ;
 
 
@@ -64,8 +105,6 @@ protected:
 	int m_TickDelay;   // Count of the m_Slots array in each ChunkData
 	int m_AddSlotNum;  // Index into m_Slots[] where to add new blocks in each ChunkData
 	int m_SimSlotNum;  // Index into m_Slots[] where to simulate blocks in each ChunkData
-	
-	int m_TotalBlocks;  // Statistics only: the total number of blocks currently queued
 
 	/*
 	Slots:
@@ -0,0 +1,1372 @@
+
+// EventRedstoneSimulator.cpp
+
+// Implements the cEventRedstoneSimulator class representing an event-driven redstone simulator working on a compiled graph of the redstone components
+
+#include "Globals.h"
+
+#include "EventRedstoneSimulator.h"
+#include "RedstonePowerTable.h"
+#include "../World.h"
+#include "../Chunk.h"
+#include "../BlockInfo.h"
+#include "../BlockEntities/DropSpenserEntity.h"
+#include "../BlockEntities/NoteEntity.h"
+#include "../BlockEntities/CommandBlockEntity.h"
+#include "../Blocks/BlockTorch.h"
+#include "../Blocks/BlockDoor.h"
+#include "../Piston.h"
+
+
+
+
+
+/// Delay of the redstone torches, in ticks
+#define TORCH_DELAY 2
+
+/// Delay of the comparators, in ticks
+#define COMPARATOR_DELAY 2
+
+/// The six neighbors of a block
+static const Vector3i g_Neighbors[] =
+{
+	Vector3i( 1,  0,  0),
+	Vector3i(-1,  0,  0),
+	Vector3i( 0,  0,  1),
+	Vector3i( 0,  0, -1),
+	Vector3i( 0,  1,  0),
+	Vector3i( 0, -1,  0),
+} ;
+
+/// The four horizontal neighbors of a block, the first four of g_Neighbors[]
+static const size_t NUM_HORIZONTAL_NEIGHBORS = 4;
+
+static const Vector3i g_Up(0, 1, 0);
+
+
+
+
+
+/** Returns the output level of a source from its meta */
+static int GetSourceLevel(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_BLOCK_OF_REDSTONE: return 15;
+		case E_BLOCK_LEVER:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:
+		case E_BLOCK_DETECTOR_RAIL:
+		{
+			return ((a_BlockMeta & 0x08) != 0) ? 15 : 0;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+cEventRedstoneSimulator::cEventRedstoneSimulator(cWorld & a_World) :
+	super(a_World),
+	m_Tick(0),
+	m_Chunk(NULL)
+{
+}
+
+
+
+
+
+void cEventRedstoneSimulator::Simulate(float a_Dt)
+{
+	UNUSED(a_Dt);
+
+	// Collect the polled nodes:
+	cPolledStates States;
+	{
+		cCSLock Lock(m_CS);
+		m_Tick += 1;
+		bool ShouldPollDaylight = ((m_Tick % DAYLIGHT_POLL_INTERVAL) == 0);
+		States.reserve(m_PolledNodes.size());
+		for (std::set<UInt64>::const_iterator itr = m_PolledNodes.begin(), end = m_PolledNodes.end(); itr != end; ++itr)
+		{
+			cNodes::const_iterator Node = m_Nodes.find(*itr);
+			if (Node == m_Nodes.end())
+			{
+				continue;
+			}
+			if ((Node->second.m_BlockType == E_BLOCK_DAYLIGHT_SENSOR) && !ShouldPollDaylight)
+			{
+				continue;
+			}
+			sPolledState State;
+			State.m_Key = *itr;
+			State.m_Pos = Node->second.m_Pos;
+			State.m_BlockType = Node->second.m_BlockType;
+			State.m_Level = Node->second.m_Level;
+			States.push_back(State);
+		}
+	}
+
+	// Poll them from the world, without holding the graph lock:
+	for (cPolledStates::iterator itr = States.begin(), end = States.end(); itr != end; ++itr)
+	{
+		itr->m_Level = PollLevel(*itr);
+	}
+
+	// Update the graph:
+	cActions Actions;
+	{
+		cCSLock Lock(m_CS);
+		for (cPolledStates::const_iterator itr = States.begin(), end = States.end(); itr != end; ++itr)
+		{
+			cNodes::iterator Node = m_Nodes.find(itr->m_Key);
+			if ((Node == m_Nodes.end()) || (Node->second.m_BlockType != itr->m_BlockType) || (Node->second.m_Level == itr->m_Level))
+			{
+				continue;
+			}
+			if (itr->m_BlockType != E_BLOCK_DAYLIGHT_SENSOR)
+			{
+				NIBBLETYPE Meta = (itr->m_Level > 0) ? 1 : 0;
+				m_Actions.push_back(sAction(actPressurePlate, Node->second, itr->m_BlockType, Meta, (itr->m_Level > 0)));
+				Node->second.m_BlockMeta = Meta;
+			}
+			Node->second.m_Level = itr->m_Level;
+			MarkOutputsDirty(Node->second);
+		}
+		FireScheduled();
+		ProcessDirty();
+		std::swap(Actions, m_Actions);
+	}
+
+	ApplyActions(Actions);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::WakeUp(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk)
+{
+	// The neighbors needn't be woken up separately, BlockChanged() recompiles everything within reach
+	AddBlock(a_BlockX, a_BlockY, a_BlockZ, a_Chunk);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::AddBlock(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk)
+{
+	if ((a_Chunk == NULL) || !a_Chunk->IsValid() || (a_BlockY < 0) || (a_BlockY >= cChunkDef::Height))
+	{
+		return;
+	}
+
+	cCSLock Lock(m_CS);
+	m_Chunk = a_Chunk;
+	BlockChanged(Vector3i(a_BlockX, a_BlockY, a_BlockZ));
+	m_Chunk = NULL;
+}
+
+
+
+
+
+void cEventRedstoneSimulator::DropChunk(int a_ChunkX, int a_ChunkZ)
+{
+	cCSLock Lock(m_CS);
+	int BaseX = a_ChunkX * cChunkDef::Width;
+	int BaseZ = a_ChunkZ * cChunkDef::Width;
+	for (int x = BaseX; x < BaseX + cChunkDef::Width; x++)
+	{
+		// The keys of one X column of the chunk form a contiguous range:
+		cNodes::iterator itr = m_Nodes.lower_bound(cRedstonePowerTable::MakeKey(x, 0, BaseZ));
+		cNodes::iterator end = m_Nodes.upper_bound(cRedstonePowerTable::MakeKey(x, cChunkDef::Height - 1, BaseZ + cChunkDef::Width - 1));
+		while (itr != end)
+		{
+			// Don't re-evaluate the neighbors, the nodes aren't gone from the world, only from the memory:
+			RemoveNode(itr++, false);
+		}
+	}
+}
+
+
+
+
+
+size_t cEventRedstoneSimulator::GetNumNodes(void)
+{
+	cCSLock Lock(m_CS);
+	return m_Nodes.size();
+}
+
+
+
+
+
+cEventRedstoneSimulator::eNodeKind cEventRedstoneSimulator::GetNodeKind(BLOCKTYPE a_BlockType)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_REDSTONE_WIRE:         return nkWire;
+
+		case E_BLOCK_REDSTONE_TORCH_OFF:
+		case E_BLOCK_REDSTONE_TORCH_ON:     return nkTorch;
+
+		case E_BLOCK_REDSTONE_REPEATER_OFF:
+		case E_BLOCK_REDSTONE_REPEATER_ON:  return nkRepeater;
+
+		case E_BLOCK_ACTIVE_COMPARATOR:
+		case E_BLOCK_INACTIVE_COMPARATOR:   return nkComparator;
+
+		case E_BLOCK_BLOCK_OF_REDSTONE:
+		case E_BLOCK_DETECTOR_RAIL:
+		case E_BLOCK_LEVER:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:         return nkSource;
+
+		case E_BLOCK_DAYLIGHT_SENSOR:
+		case E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_STONE_PRESSURE_PLATE:
+		case E_BLOCK_WOODEN_PRESSURE_PLATE: return nkPolledSource;
+
+		case E_BLOCK_ACTIVATOR_RAIL:
+		case E_BLOCK_COMMAND_BLOCK:
+		case E_BLOCK_DISPENSER:
+		case E_BLOCK_DROPPER:
+		case E_BLOCK_FENCE_GATE:
+		case E_BLOCK_IRON_DOOR:
+		case E_BLOCK_NOTE_BLOCK:
+		case E_BLOCK_PISTON:
+		case E_BLOCK_POWERED_RAIL:
+		case E_BLOCK_REDSTONE_LAMP_OFF:
+		case E_BLOCK_REDSTONE_LAMP_ON:
+		case E_BLOCK_STICKY_PISTON:
+		case E_BLOCK_TNT:
+		case E_BLOCK_TRAPDOOR:
+		case E_BLOCK_WOODEN_DOOR:           return nkMechanism;
+	}
+	return nkNone;
+}
+
+
+
+
+
+NIBBLETYPE cEventRedstoneSimulator::GetStructuralMetaMask(BLOCKTYPE a_BlockType)
+{
+	switch (a_BlockType)
+	{
+		case E_BLOCK_REDSTONE_TORCH_OFF:
+		case E_BLOCK_REDSTONE_TORCH_ON:     return 0x0f;  // Direction
+		case E_BLOCK_REDSTONE_REPEATER_OFF:
+		case E_BLOCK_REDSTONE_REPEATER_ON:
+		case E_BLOCK_ACTIVE_COMPARATOR:
+		case E_BLOCK_INACTIVE_COMPARATOR:   return 0x03;  // Direction; the rest is delay / mode / state
+		case E_BLOCK_LEVER:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:
+		case E_BLOCK_PISTON:
+		case E_BLOCK_STICKY_PISTON:         return 0x07;  // Direction; 0x08 is the state
+	}
+	return 0;
+}
+
+
+
+
+
+void cEventRedstoneSimulator::GetBlock(const Vector3i & a_Pos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta)
+{
+	ASSERT(m_Chunk != NULL);
+	if ((a_Pos.y >= 0) && (a_Pos.y < cChunkDef::Height))
+	{
+		int RelX = a_Pos.x - m_Chunk->GetPosX() * cChunkDef::Width;
+		int RelZ = a_Pos.z - m_Chunk->GetPosZ() * cChunkDef::Width;
+		if (m_Chunk->UnboundedRelGetBlock(RelX, a_Pos.y, RelZ, a_BlockType, a_BlockMeta))
+		{
+			return;
+		}
+	}
+	a_BlockType = E_BLOCK_AIR;
+	a_BlockMeta = 0;
+}
+
+
+
+
+
+cEventRedstoneSimulator::sNode * cEventRedstoneSimulator::FindNode(const Vector3i & a_Pos)
+{
+	cNodes::iterator itr = m_Nodes.find(cRedstonePowerTable::MakeKey(a_Pos));
+	return (itr == m_Nodes.end()) ? NULL : &(itr->second);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::BlockChanged(const Vector3i & a_Pos)
+{
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	GetBlock(a_Pos, BlockType, BlockMeta);
+	eNodeKind Kind = GetNodeKind(BlockType);
+
+	cNodes::iterator itr = m_Nodes.find(cRedstonePowerTable::MakeKey(a_Pos));
+	if (itr != m_Nodes.end())
+	{
+		sNode & Node = itr->second;
+		if ((Node.m_BlockType == BlockType) && (Node.m_BlockMeta == BlockMeta))
+		{
+			// No change, most likely our own change coming back from the world
+			return;
+		}
+		NIBBLETYPE Mask = GetStructuralMetaMask(BlockType);
+		if ((Node.m_Kind == Kind) && ((Node.m_BlockMeta & Mask) == (BlockMeta & Mask)))
+		{
+			// Only the state changed (lever flipped, repeater delay set, ...), the links stay the same:
+			Node.m_BlockType = BlockType;
+			Node.m_BlockMeta = BlockMeta;
+			if (Kind == nkSource)
+			{
+				int Level = GetSourceLevel(BlockType, BlockMeta);
+				if (Level != Node.m_Level)
+				{
+					Node.m_Level = Level;
+					MarkOutputsDirty(Node);
+				}
+			}
+			MarkDirty(Node);
+			return;
+		}
+		RemoveNode(itr, true);
+	}
+
+	if (Kind != nkNone)
+	{
+		MarkDirty(CreateNode(a_Pos, BlockType, BlockMeta));
+	}
+
+	// Recompile all the nodes that may power something through or next to the changed block, including the block itself:
+	for (int x = a_Pos.x - 2; x <= a_Pos.x + 2; x++)
+	{
+		cNodes::iterator Node = m_Nodes.lower_bound(cRedstonePowerTable::MakeKey(x, a_Pos.y - 2, a_Pos.z - 2));
+		cNodes::iterator End = m_Nodes.upper_bound(cRedstonePowerTable::MakeKey(x, a_Pos.y + 2, a_Pos.z + 2));
+		for (; Node != End; ++Node)
+		{
+			if (std::abs(Node->second.m_Pos.y - a_Pos.y) <= 2)
+			{
+				CompileOutputs(Node->second);
+			}
+		}
+	}
+}
+
+
+
+
+
+cEventRedstoneSimulator::sNode & cEventRedstoneSimulator::CreateNode(const Vector3i & a_Pos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	UInt64 Key = cRedstonePowerTable::MakeKey(a_Pos);
+	sNode & Node = m_Nodes[Key];
+	Node.m_Pos = a_Pos;
+	Node.m_BlockType = a_BlockType;
+	Node.m_BlockMeta = a_BlockMeta;
+	Node.m_Kind = GetNodeKind(a_BlockType);
+	Node.m_Level = 0;
+	Node.m_IsPowered = false;
+	Node.m_IsQueued = false;
+	Node.m_ScheduledTick = -1;
+	Node.m_ScheduledLevel = 0;
+
+	// Take the initial state from the block, so that a freshly loaded chunk doesn't flicker:
+	switch (a_BlockType)
+	{
+		case E_BLOCK_REDSTONE_WIRE:        Node.m_Level = a_BlockMeta; break;
+		case E_BLOCK_REDSTONE_TORCH_ON:    Node.m_Level = 15; break;
+		case E_BLOCK_REDSTONE_REPEATER_ON: Node.m_Level = 15; break;
+		case E_BLOCK_ACTIVE_COMPARATOR:    Node.m_Level = 15; break;
+		case E_BLOCK_REDSTONE_LAMP_ON:     Node.m_IsPowered = true; break;
+		case E_BLOCK_ACTIVATOR_RAIL:
+		case E_BLOCK_PISTON:
+		case E_BLOCK_POWERED_RAIL:
+		case E_BLOCK_STICKY_PISTON:
+		{
+			Node.m_IsPowered = ((a_BlockMeta & 0x08) != 0);
+			break;
+		}
+		case E_BLOCK_DAYLIGHT_SENSOR:
+		case E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_STONE_PRESSURE_PLATE:
+		case E_BLOCK_WOODEN_PRESSURE_PLATE:
+		{
+			Node.m_Level = (a_BlockMeta != 0) ? 15 : 0;
+			m_PolledNodes.insert(Key);
+			break;
+		}
+		default:
+		{
+			Node.m_Level = GetSourceLevel(a_BlockType, a_BlockMeta);
+			break;
+		}
+	}
+	return Node;
+}
+
+
+
+
+
+void cEventRedstoneSimulator::RemoveNode(cNodes::iterator a_Node, bool a_NotifyOutputs)
+{
+	UInt64 Key = a_Node->first;
+	sNode & Node = a_Node->second;
+	for (cKeys::const_iterator itr = Node.m_Outputs.begin(), end = Node.m_Outputs.end(); itr != end; ++itr)
+	{
+		cNodes::iterator Target = m_Nodes.find(*itr);
+		if (Target == m_Nodes.end())
+		{
+			continue;
+		}
+		EraseInputsFrom(Target->second.m_Inputs, Key);
+		if (a_NotifyOutputs)
+		{
+			MarkDirty(Target->second);
+		}
+	}
+	for (cInputs::const_iterator itr = Node.m_Inputs.begin(), end = Node.m_Inputs.end(); itr != end; ++itr)
+	{
+		cNodes::iterator Source = m_Nodes.find(itr->m_Source);
+		if (Source != m_Nodes.end())
+		{
+			cKeys & Outputs = Source->second.m_Outputs;
+			Outputs.erase(std::remove(Outputs.begin(), Outputs.end(), Key), Outputs.end());
+		}
+	}
+	m_PolledNodes.erase(Key);
+	m_Nodes.erase(a_Node);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::CompileOutputs(sNode & a_Node)
+{
+	// Unlink the old outputs:
+	UInt64 Key = cRedstonePowerTable::MakeKey(a_Node.m_Pos);
+	for (cKeys::const_iterator itr = a_Node.m_Outputs.begin(), end = a_Node.m_Outputs.end(); itr != end; ++itr)
+	{
+		cNodes::iterator Target = m_Nodes.find(*itr);
+		if (Target != m_Nodes.end())
+		{
+			EraseInputsFrom(Target->second.m_Inputs, Key);
+			MarkDirty(Target->second);
+		}
+	}
+	a_Node.m_Outputs.clear();
+	if (a_Node.m_Kind == nkMechanism)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAYCOUNT(g_Neighbors); i++)
+	{
+		const Vector3i & Dir = g_Neighbors[i];
+		Vector3i Pos = a_Node.m_Pos + Dir;
+
+		// The adjacent node:
+		sNode * Target = FindNode(Pos);
+		if (Target != NULL)
+		{
+			eInputKind Kind;
+			if ((a_Node.m_Kind == nkWire) && (Target->m_Kind == nkWire))
+			{
+				// Wires connect to each other regardless of the direction they point
+				if (Dir.y == 0)
+				{
+					AddLink(a_Node, *Target, ikDirect);
+				}
+			}
+			else if (PowersDirectly(a_Node, Dir) && AcceptsDirect(*Target, a_Node, Dir * -1, Kind))
+			{
+				AddLink(a_Node, *Target, Kind);
+			}
+		}
+
+		// The nodes around the adjacent block, if it conducts power:
+		int Strength = PowersBlock(a_Node, Dir);
+		if (Strength == 0)
+		{
+			continue;
+		}
+		BLOCKTYPE MiddleType;
+		NIBBLETYPE MiddleMeta;
+		GetBlock(Pos, MiddleType, MiddleMeta);
+		if (!cBlockInfo::FullyOccupiesVoxel(MiddleType) || (MiddleType == E_BLOCK_BLOCK_OF_REDSTONE))
+		{
+			continue;
+		}
+		for (size_t j = 0; j < ARRAYCOUNT(g_Neighbors); j++)
+		{
+			Vector3i TargetPos = Pos + g_Neighbors[j];
+			if (TargetPos.Equals(a_Node.m_Pos))
+			{
+				continue;
+			}
+			Target = FindNode(TargetPos);
+			if ((Target != NULL) && AcceptsThroughBlock(*Target, g_Neighbors[j] * -1, Strength))
+			{
+				AddLink(a_Node, *Target, ikThroughBlock);
+			}
+		}
+	}  // for i - g_Neighbors[]
+
+	if (a_Node.m_Kind != nkWire)
+	{
+		return;
+	}
+
+	// Wires also power the wires one block up or down, unless cut off by a solid block:
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	GetBlock(a_Node.m_Pos + g_Up, BlockType, BlockMeta);
+	bool IsCutOffAbove = cBlockInfo::IsSolid(BlockType);
+	for (size_t i = 0; i < NUM_HORIZONTAL_NEIGHBORS; i++)
+	{
+		Vector3i Pos = a_Node.m_Pos + g_Neighbors[i];
+		if (!IsCutOffAbove)
+		{
+			sNode * Target = FindNode(Pos + g_Up);
+			if ((Target != NULL) && (Target->m_Kind == nkWire))
+			{
+				AddLink(a_Node, *Target, ikDirect);
+			}
+		}
+		GetBlock(Pos, BlockType, BlockMeta);
+		if (!cBlockInfo::IsSolid(BlockType))
+		{
+			sNode * Target = FindNode(Pos - g_Up);
+			if ((Target != NULL) && (Target->m_Kind == nkWire))
+			{
+				AddLink(a_Node, *Target, ikDirect);
+			}
+		}
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::AddLink(sNode & a_Source, sNode & a_Target, eInputKind a_Kind)
+{
+	UInt64 SourceKey = cRedstonePowerTable::MakeKey(a_Source.m_Pos);
+	for (cInputs::const_iterator itr = a_Target.m_Inputs.begin(), end = a_Target.m_Inputs.end(); itr != end; ++itr)
+	{
+		if ((itr->m_Source == SourceKey) && (itr->m_Kind == a_Kind))
+		{
+			return;
+		}
+	}
+	a_Target.m_Inputs.push_back(sInput(SourceKey, a_Kind));
+
+	UInt64 TargetKey = cRedstonePowerTable::MakeKey(a_Target.m_Pos);
+	if (std::find(a_Source.m_Outputs.begin(), a_Source.m_Outputs.end(), TargetKey) == a_Source.m_Outputs.end())
+	{
+		a_Source.m_Outputs.push_back(TargetKey);
+	}
+	MarkDirty(a_Target);
+}
+
+
+
+
+
+bool cEventRedstoneSimulator::IsWireConnected(const sNode & a_Wire, const Vector3i & a_Dir)
+{
+	Vector3i Pos = a_Wire.m_Pos + a_Dir;
+	const sNode * Neighbor = FindNode(Pos);
+	if (Neighbor != NULL)
+	{
+		switch (Neighbor->m_Kind)
+		{
+			case nkMechanism: return false;
+			case nkRepeater:
+			{
+				// Repeaters connect only at their front and back:
+				Vector3i Front = GetFrontOffset(Neighbor->m_BlockMeta);
+				return ((Front.x != 0) == (a_Dir.x != 0));
+			}
+			default: return true;
+		}
+	}
+
+	// Wires one block up or down connect, unless cut off by a solid block:
+	BLOCKTYPE BlockType;
+	NIBBLETYPE BlockMeta;
+	GetBlock(a_Wire.m_Pos + g_Up, BlockType, BlockMeta);
+	if (!cBlockInfo::IsSolid(BlockType))
+	{
+		Neighbor = FindNode(Pos + g_Up);
+		if ((Neighbor != NULL) && (Neighbor->m_Kind == nkWire))
+		{
+			return true;
+		}
+	}
+	GetBlock(Pos, BlockType, BlockMeta);
+	if (!cBlockInfo::IsSolid(BlockType))
+	{
+		Neighbor = FindNode(Pos - g_Up);
+		if ((Neighbor != NULL) && (Neighbor->m_Kind == nkWire))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+
+
+bool cEventRedstoneSimulator::IsWirePointing(const sNode & a_Wire, const Vector3i & a_Dir)
+{
+	if (IsWireConnected(a_Wire, a_Dir))
+	{
+		return true;
+	}
+
+	// A wire that connects to nothing, or only along the same axis, points both ways along the axis:
+	Vector3i Perpendicular(a_Dir.z, 0, a_Dir.x);
+	return !IsWireConnected(a_Wire, Perpendicular) && !IsWireConnected(a_Wire, Perpendicular * -1);
+}
+
+
+
+
+
+bool cEventRedstoneSimulator::PowersDirectly(const sNode & a_Source, const Vector3i & a_Dir)
+{
+	switch (a_Source.m_Kind)
+	{
+		case nkWire:
+		{
+			if (a_Dir.y != 0)
+			{
+				return (a_Dir.y < 0);
+			}
+			return IsWirePointing(a_Source, a_Dir);
+		}
+		case nkTorch:        return !a_Dir.Equals(GetTorchBaseOffset(a_Source.m_BlockMeta));
+		case nkRepeater:
+		case nkComparator:   return a_Dir.Equals(GetFrontOffset(a_Source.m_BlockMeta));
+		case nkSource:
+		case nkPolledSource: return true;
+		default:             return false;
+	}
+}
+
+
+
+
+
+int cEventRedstoneSimulator::PowersBlock(const sNode & a_Source, const Vector3i & a_Dir)
+{
+	switch (a_Source.m_BlockType)
+	{
+		case E_BLOCK_REDSTONE_WIRE:
+		{
+			if (a_Dir.y != 0)
+			{
+				return (a_Dir.y < 0) ? 1 : 0;
+			}
+			return IsWirePointing(a_Source, a_Dir) ? 1 : 0;
+		}
+		case E_BLOCK_REDSTONE_TORCH_OFF:
+		case E_BLOCK_REDSTONE_TORCH_ON:
+		{
+			return (a_Dir.y > 0) ? 2 : 0;
+		}
+		case E_BLOCK_REDSTONE_REPEATER_OFF:
+		case E_BLOCK_REDSTONE_REPEATER_ON:
+		case E_BLOCK_ACTIVE_COMPARATOR:
+		case E_BLOCK_INACTIVE_COMPARATOR:
+		{
+			return a_Dir.Equals(GetFrontOffset(a_Source.m_BlockMeta)) ? 2 : 0;
+		}
+		case E_BLOCK_LEVER:
+		case E_BLOCK_STONE_BUTTON:
+		case E_BLOCK_WOODEN_BUTTON:
+		{
+			return a_Dir.Equals(GetAttachmentOffset(a_Source.m_BlockType, a_Source.m_BlockMeta)) ? 2 : 0;
+		}
+		case E_BLOCK_DETECTOR_RAIL:
+		case E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_STONE_PRESSURE_PLATE:
+		case E_BLOCK_WOODEN_PRESSURE_PLATE:
+		{
+			return (a_Dir.y < 0) ? 2 : 0;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+bool cEventRedstoneSimulator::AcceptsDirect(const sNode & a_Target, const sNode & a_Source, const Vector3i & a_Dir, eInputKind & a_Kind)
+{
+	a_Kind = ikDirect;
+	switch (a_Target.m_Kind)
+	{
+		case nkWire:  return true;
+		case nkTorch: return a_Dir.Equals(GetTorchBaseOffset(a_Target.m_BlockMeta));
+		case nkRepeater:
+		case nkComparator:
+		{
+			Vector3i Front = GetFrontOffset(a_Target.m_BlockMeta);
+			if (a_Dir.Equals(Front * -1))
+			{
+				return true;
+			}
+			if ((a_Dir.y != 0) || a_Dir.Equals(Front))
+			{
+				return false;
+			}
+			// Side input: locks repeaters, is subtracted by comparators
+			a_Kind = ikSide;
+			switch (a_Source.m_Kind)
+			{
+				case nkRepeater:
+				case nkComparator: return true;
+				case nkWire:       return (a_Target.m_Kind == nkComparator);
+				default:           return (a_Target.m_Kind == nkComparator) && (a_Source.m_BlockType == E_BLOCK_BLOCK_OF_REDSTONE);
+			}
+		}
+		case nkMechanism:
+		{
+			if ((a_Target.m_BlockType == E_BLOCK_PISTON) || (a_Target.m_BlockType == E_BLOCK_STICKY_PISTON))
+			{
+				return !a_Dir.Equals(GetPistonFrontOffset(a_Target.m_BlockMeta));
+			}
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
+bool cEventRedstoneSimulator::AcceptsThroughBlock(const sNode & a_Target, const Vector3i & a_Dir, int a_Strength)
+{
+	switch (a_Target.m_Kind)
+	{
+		case nkWire:  return (a_Strength >= 2);  // Only strongly powered blocks power wires
+		case nkTorch: return a_Dir.Equals(GetTorchBaseOffset(a_Target.m_BlockMeta));
+		case nkRepeater:
+		case nkComparator:
+		{
+			return a_Dir.Equals(GetFrontOffset(a_Target.m_BlockMeta) * -1);
+		}
+		case nkMechanism:
+		{
+			if ((a_Target.m_BlockType == E_BLOCK_PISTON) || (a_Target.m_BlockType == E_BLOCK_STICKY_PISTON))
+			{
+				return !a_Dir.Equals(GetPistonFrontOffset(a_Target.m_BlockMeta));
+			}
+			return true;
+		}
+		default: return false;
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::MarkDirty(sNode & a_Node)
+{
+	if (!a_Node.m_IsQueued)
+	{
+		a_Node.m_IsQueued = true;
+		m_Dirty.push_back(cRedstonePowerTable::MakeKey(a_Node.m_Pos));
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::MarkOutputsDirty(sNode & a_Node)
+{
+	for (cKeys::const_iterator itr = a_Node.m_Outputs.begin(), end = a_Node.m_Outputs.end(); itr != end; ++itr)
+	{
+		cNodes::iterator Target = m_Nodes.find(*itr);
+		if (Target != m_Nodes.end())
+		{
+			MarkDirty(Target->second);
+		}
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::Evaluate(sNode & a_Node)
+{
+	int Level = 0, SideLevel = 0;
+	for (cInputs::const_iterator itr = a_Node.m_Inputs.begin(), end = a_Node.m_Inputs.end(); itr != end; ++itr)
+	{
+		cNodes::const_iterator Source = m_Nodes.find(itr->m_Source);
+		if (Source == m_Nodes.end())
+		{
+			continue;
+		}
+		int InputLevel = Source->second.m_Level;
+		if ((a_Node.m_Kind == nkWire) && (Source->second.m_Kind == nkWire))
+		{
+			InputLevel -= 1;  // Power decays along the wire
+		}
+		if (itr->m_Kind == ikSide)
+		{
+			SideLevel = std::max(SideLevel, InputLevel);
+		}
+		else
+		{
+			Level = std::max(Level, InputLevel);
+		}
+	}
+
+	switch (a_Node.m_Kind)
+	{
+		case nkWire:
+		{
+			if (Level != a_Node.m_Level)
+			{
+				m_Actions.push_back(sAction(actSetMeta, a_Node, E_BLOCK_REDSTONE_WIRE, (NIBBLETYPE)Level, (Level > 0)));
+				a_Node.m_BlockMeta = (NIBBLETYPE)Level;
+				a_Node.m_Level = Level;
+				MarkOutputsDirty(a_Node);
+			}
+			break;
+		}
+		case nkTorch:
+		{
+			ScheduleOutput(a_Node, TORCH_DELAY, (Level > 0) ? 0 : 15);
+			break;
+		}
+		case nkRepeater:
+		{
+			if (SideLevel > 0)
+			{
+				// Locked by another repeater
+				break;
+			}
+			// The top two bits are the delay, in redstone ticks (2 game ticks each)
+			ScheduleOutput(a_Node, (((a_Node.m_BlockMeta & 0x0c) >> 2) + 1) * 2, (Level > 0) ? 15 : 0);
+			break;
+		}
+		case nkComparator:
+		{
+			int Output;
+			if ((a_Node.m_BlockMeta & 0x04) != 0)
+			{
+				Output = std::max(Level - SideLevel, 0);  // Subtraction mode
+			}
+			else
+			{
+				Output = (Level >= SideLevel) ? Level : 0;  // Comparison mode
+			}
+			ScheduleOutput(a_Node, COMPARATOR_DELAY, Output);
+			break;
+		}
+		case nkSource:
+		{
+			int SourceLevel = GetSourceLevel(a_Node.m_BlockType, a_Node.m_BlockMeta);
+			if (SourceLevel != a_Node.m_Level)
+			{
+				a_Node.m_Level = SourceLevel;
+				MarkOutputsDirty(a_Node);
+			}
+			break;
+		}
+		case nkPolledSource:
+		{
+			// Updated by polling in Simulate()
+			break;
+		}
+		case nkMechanism:
+		{
+			bool IsPowered = (Level > 0);
+			if (IsPowered == a_Node.m_IsPowered)
+			{
+				break;
+			}
+			a_Node.m_IsPowered = IsPowered;
+			switch (a_Node.m_BlockType)
+			{
+				case E_BLOCK_REDSTONE_LAMP_OFF:
+				case E_BLOCK_REDSTONE_LAMP_ON:
+				{
+					BLOCKTYPE NewType = IsPowered ? E_BLOCK_REDSTONE_LAMP_ON : E_BLOCK_REDSTONE_LAMP_OFF;
+					if (NewType != a_Node.m_BlockType)
+					{
+						m_Actions.push_back(sAction(actSetBlock, a_Node, NewType, 0, IsPowered));
+						a_Node.m_BlockType = NewType;
+						a_Node.m_BlockMeta = 0;
+					}
+					break;
+				}
+				case E_BLOCK_ACTIVATOR_RAIL:
+				case E_BLOCK_POWERED_RAIL:
+				{
+					NIBBLETYPE NewMeta = IsPowered ? (a_Node.m_BlockMeta | 0x08) : (a_Node.m_BlockMeta & 0x07);
+					m_Actions.push_back(sAction(actSetMeta, a_Node, a_Node.m_BlockType, NewMeta, IsPowered));
+					a_Node.m_BlockMeta = NewMeta;
+					break;
+				}
+				case E_BLOCK_PISTON:
+				case E_BLOCK_STICKY_PISTON: m_Actions.push_back(sAction(actPiston,       a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_WOODEN_DOOR:
+				case E_BLOCK_IRON_DOOR:     m_Actions.push_back(sAction(actDoor,         a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_TRAPDOOR:      m_Actions.push_back(sAction(actTrapdoor,     a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_FENCE_GATE:    m_Actions.push_back(sAction(actFenceGate,    a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_DISPENSER:
+				case E_BLOCK_DROPPER:       m_Actions.push_back(sAction(actDropSpenser,  a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_COMMAND_BLOCK: m_Actions.push_back(sAction(actCommandBlock, a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered)); break;
+				case E_BLOCK_TNT:
+				{
+					if (IsPowered)
+					{
+						m_Actions.push_back(sAction(actTNT, a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered));
+					}
+					break;
+				}
+				case E_BLOCK_NOTE_BLOCK:
+				{
+					if (IsPowered)
+					{
+						m_Actions.push_back(sAction(actNoteBlock, a_Node, a_Node.m_BlockType, a_Node.m_BlockMeta, IsPowered));
+					}
+					break;
+				}
+			}
+			break;
+		}
+		case nkNone:
+		{
+			ASSERT(!"Node without a kind");
+			break;
+		}
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::ScheduleOutput(sNode & a_Node, int a_Delay, int a_Level)
+{
+	if ((a_Node.m_ScheduledTick >= 0) || (a_Level == a_Node.m_Level))
+	{
+		// Either nothing to change, or a change is already pending; the node is re-evaluated once it is applied
+		return;
+	}
+	ASSERT((a_Delay > 0) && (a_Delay < WHEEL_SIZE));
+	a_Node.m_ScheduledTick = m_Tick + a_Delay;
+	a_Node.m_ScheduledLevel = a_Level;
+	m_Wheel[a_Node.m_ScheduledTick % WHEEL_SIZE].push_back(cRedstonePowerTable::MakeKey(a_Node.m_Pos));
+}
+
+
+
+
+
+void cEventRedstoneSimulator::SetOutput(sNode & a_Node, int a_Level)
+{
+	if (a_Level == a_Node.m_Level)
+	{
+		return;
+	}
+	a_Node.m_Level = a_Level;
+
+	bool IsOn = (a_Level > 0);
+	BLOCKTYPE NewType = a_Node.m_BlockType;
+	NIBBLETYPE NewMeta = a_Node.m_BlockMeta;
+	switch (a_Node.m_Kind)
+	{
+		case nkTorch:    NewType = IsOn ? E_BLOCK_REDSTONE_TORCH_ON : E_BLOCK_REDSTONE_TORCH_OFF; break;
+		case nkRepeater: NewType = IsOn ? E_BLOCK_REDSTONE_REPEATER_ON : E_BLOCK_REDSTONE_REPEATER_OFF; break;
+		case nkComparator:
+		{
+			NewType = IsOn ? E_BLOCK_ACTIVE_COMPARATOR : E_BLOCK_INACTIVE_COMPARATOR;
+			NewMeta = IsOn ? (a_Node.m_BlockMeta | 0x08) : (a_Node.m_BlockMeta & 0x07);
+			break;
+		}
+		default:
+		{
+			ASSERT(!"Output change scheduled for a node without a delay");
+			break;
+		}
+	}
+	if ((NewType != a_Node.m_BlockType) || (NewMeta != a_Node.m_BlockMeta))
+	{
+		m_Actions.push_back(sAction(actSetBlock, a_Node, NewType, NewMeta, IsOn));
+		a_Node.m_BlockType = NewType;
+		a_Node.m_BlockMeta = NewMeta;
+	}
+	MarkOutputsDirty(a_Node);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::FireScheduled(void)
+{
+	cKeys Keys;
+	std::swap(Keys, m_Wheel[m_Tick % WHEEL_SIZE]);
+	for (cKeys::const_iterator itr = Keys.begin(), end = Keys.end(); itr != end; ++itr)
+	{
+		cNodes::iterator Node = m_Nodes.find(*itr);
+		if ((Node == m_Nodes.end()) || (Node->second.m_ScheduledTick != m_Tick))
+		{
+			// The node has been removed or re-created since
+			continue;
+		}
+		Node->second.m_ScheduledTick = -1;
+		SetOutput(Node->second, Node->second.m_ScheduledLevel);
+
+		// The inputs may have changed during the delay:
+		MarkDirty(Node->second);
+	}
+}
+
+
+
+
+
+void cEventRedstoneSimulator::ProcessDirty(void)
+{
+	int NumEvaluations = 0;
+	cKeys Current;
+	while (!m_Dirty.empty())
+	{
+		std::swap(Current, m_Dirty);
+		for (cKeys::const_iterator itr = Current.begin(), end = Current.end(); itr != end; ++itr)
+		{
+			if (NumEvaluations >= MAX_EVALUATIONS_PER_TICK)
+			{
+				// Leave the rest for the next tick; they're still marked as queued:
+				m_Dirty.insert(m_Dirty.end(), itr, end);
+				LOGD("%s: Evaluation limit reached, %u nodes postponed", __FUNCTION__, (unsigned)m_Dirty.size());
+				return;
+			}
+			cNodes::iterator Node = m_Nodes.find(*itr);
+			if (Node == m_Nodes.end())
+			{
+				continue;
+			}
+			Node->second.m_IsQueued = false;
+			Evaluate(Node->second);
+			NumEvaluations += 1;
+		}
+		Current.clear();
+	}
+}
+
+
+
+
+
+int cEventRedstoneSimulator::PollLevel(const sPolledState & a_State)
+{
+	const Vector3i & Pos = a_State.m_Pos;
+	switch (a_State.m_BlockType)
+	{
+		case E_BLOCK_STONE_PRESSURE_PLATE:
+		{
+			// MCS feature - stone pressure plates can only be triggered by players :D
+			return (m_World.FindClosestPlayer(Vector3d(Pos.x + 0.5, Pos.y, Pos.z + 0.5), 0.5f, false) != NULL) ? 15 : 0;
+		}
+		case E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE:
+		case E_BLOCK_WOODEN_PRESSURE_PLATE:
+		{
+			class cFindAnyEntity :
+				public cEntityCallback
+			{
+			public:
+				bool m_HasFound;
+
+				cFindAnyEntity(void) : m_HasFound(false) {}
+
+				virtual bool Item(cEntity * a_Entity) override
+				{
+					UNUSED(a_Entity);
+					m_HasFound = true;
+					return true;
+				}
+			} FindAnyEntity;
+			m_World.ForEachEntityInRadius(Vector3d(Pos.x + 0.5, Pos.y, Pos.z + 0.5), 0.7, FindAnyEntity);
+			return FindAnyEntity.m_HasFound ? 15 : 0;
+		}
+		case E_BLOCK_DAYLIGHT_SENSOR:
+		{
+			int ChunkX, ChunkZ;
+			cChunkDef::BlockToChunk(Pos.x, Pos.z, ChunkX, ChunkZ);
+			if (!m_World.IsChunkLighted(ChunkX, ChunkZ))
+			{
+				m_World.QueueLightChunk(ChunkX, ChunkZ);
+				return a_State.m_Level;
+			}
+			int SkyLight = m_World.GetBlockSkyLight(Pos.x, Pos.y + 1, Pos.z) - m_World.GetSkyDarkness();
+			return (SkyLight > 8) ? 15 : 0;
+		}
+	}
+	return a_State.m_Level;
+}
+
+
+
+
+
+void cEventRedstoneSimulator::ApplyActions(const cActions & a_Actions)
+{
+	for (cActions::const_iterator itr = a_Actions.begin(), end = a_Actions.end(); itr != end; ++itr)
+	{
+		const Vector3i & Pos = itr->m_Pos;
+
+		// The block may have been changed by someone else since the graph was evaluated, don't overwrite it:
+		if (m_World.GetBlock(Pos) != itr->m_PrevBlockType)
+		{
+			continue;
+		}
+
+		switch (itr->m_Type)
+		{
+			case actSetBlock:
+			{
+				m_World.SetBlock(Pos.x, Pos.y, Pos.z, itr->m_BlockType, itr->m_BlockMeta);
+				break;
+			}
+			case actSetMeta:
+			{
+				m_World.SetBlockMeta(Pos.x, Pos.y, Pos.z, itr->m_BlockMeta);
+				break;
+			}
+			case actPressurePlate:
+			{
+				m_World.SetBlockMeta(Pos.x, Pos.y, Pos.z, itr->m_BlockMeta);
+				m_World.BroadcastSoundEffect("random.click", (int)((Pos.x + 0.5) * 8.0), (int)((Pos.y + 0.1) * 8.0), (int)((Pos.z + 0.5) * 8.0), 0.3f, itr->m_IsPowered ? 0.5f : 0.6f);
+				break;
+			}
+			case actPiston:
+			{
+				cPiston Piston(&m_World);
+				if (itr->m_IsPowered)
+				{
+					Piston.ExtendPiston(Pos.x, Pos.y, Pos.z);
+				}
+				else
+				{
+					Piston.RetractPiston(Pos.x, Pos.y, Pos.z);
+				}
+				break;
+			}
+			case actTNT:
+			{
+				m_World.BroadcastSoundEffect("game.tnt.primed", Pos.x * 8, Pos.y * 8, Pos.z * 8, 0.5f, 0.6f);
+				m_World.SetBlock(Pos.x, Pos.y, Pos.z, E_BLOCK_AIR, 0);
+				m_World.SpawnPrimedTNT(Pos.x + 0.5, Pos.y + 0.5, Pos.z + 0.5);  // 80 ticks to boom
+				break;
+			}
+			case actDoor:
+			{
+				// The open bit is in the bottom half of the door:
+				int BottomY = Pos.y;
+				NIBBLETYPE Meta = m_World.GetBlockMeta(Pos);
+				if ((Meta & 0x08) != 0)
+				{
+					BottomY -= 1;
+					Meta = m_World.GetBlockMeta(Pos.x, BottomY, Pos.z);
+				}
+				if (((Meta & 0x04) != 0) != itr->m_IsPowered)
+				{
+					cChunkInterface ChunkInterface(m_World.GetChunkMap());
+					cBlockDoorHandler::ChangeDoor(ChunkInterface, Pos.x, BottomY, Pos.z);
+					m_World.BroadcastSoundParticleEffect(1003, Pos.x, BottomY, Pos.z, 0);
+				}
+				break;
+			}
+			case actTrapdoor:
+			{
+				m_World.SetTrapdoorOpen(Pos.x, Pos.y, Pos.z, itr->m_IsPowered);
+				break;
+			}
+			case actFenceGate:
+			{
+				NIBBLETYPE Meta = m_World.GetBlockMeta(Pos);
+				NIBBLETYPE NewMeta = itr->m_IsPowered ? (Meta | 0x04) : (Meta & 0x0b);
+				if (NewMeta != Meta)
+				{
+					m_World.SetBlockMeta(Pos.x, Pos.y, Pos.z, NewMeta);
+					m_World.BroadcastSoundParticleEffect(1003, Pos.x, Pos.y, Pos.z, 0);
+				}
+				break;
+			}
+			case actNoteBlock:
+			{
+				class cPlayNote :
+					public cNoteBlockCallback
+				{
+					virtual bool Item(cNoteEntity * a_NoteBlock) override
+					{
+						a_NoteBlock->MakeSound();
+						return false;
+					}
+				} PlayNote;
+				m_World.DoWithNoteBlockAt(Pos.x, Pos.y, Pos.z, PlayNote);
+				break;
+			}
+			case actDropSpenser:
+			{
+				class cSetPowerToDropSpenser :
+					public cDropSpenserCallback
+				{
+					bool m_IsPowered;
+				public:
+					cSetPowerToDropSpenser(bool a_IsPowered) : m_IsPowered(a_IsPowered) {}
+
+					virtual bool Item(cDropSpenserEntity * a_DropSpenser) override
+					{
+						a_DropSpenser->SetRedstonePower(m_IsPowered);
+						return false;
+					}
+				} DrSpSP(itr->m_IsPowered);
+				m_World.DoWithDropSpenserAt(Pos.x, Pos.y, Pos.z, DrSpSP);
+				break;
+			}
+			case actCommandBlock:
+			{
+				class cSetPowerToCommandBlock :
+					public cCommandBlockCallback
+				{
+					bool m_IsPowered;
+				public:
+					cSetPowerToCommandBlock(bool a_IsPowered) : m_IsPowered(a_IsPowered) {}
+
+					virtual bool Item(cCommandBlockEntity * a_CommandBlock) override
+					{
+						a_CommandBlock->SetRedstonePower(m_IsPowered);
+						return false;
+					}
+				} CmdBlockSP(itr->m_IsPowered);
+				m_World.DoWithCommandBlockAt(Pos.x, Pos.y, Pos.z, CmdBlockSP);
+				break;
+			}
+		}
+	}
+}
+
+
+
+
+
+Vector3i cEventRedstoneSimulator::GetAttachmentOffset(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta)
+{
+	switch (a_BlockMeta & 0x07)
+	{
+		case 0x1: return Vector3i(-1, 0, 0);
+		case 0x2: return Vector3i( 1, 0, 0);
+		case 0x3: return Vector3i( 0, 0, -1);
+		case 0x4: return Vector3i( 0, 0, 1);
+		case 0x5:
+		{
+			return Vector3i(0, -1, 0);
+		}
+		case 0x6:
+		{
+			// Levers on the ground, buttons don't use this value:
+			return (a_BlockType == E_BLOCK_LEVER) ? Vector3i(0, -1, 0) : Vector3i(0, 1, 0);
+		}
+	}
+	return Vector3i(0, 1, 0);  // On the ceiling
+}
+
+
+
+
+
+Vector3i cEventRedstoneSimulator::GetFrontOffset(NIBBLETYPE a_BlockMeta)
+{
+	switch (a_BlockMeta & 0x03)
+	{
+		case 0x0: return Vector3i( 0, 0, -1);
+		case 0x1: return Vector3i( 1, 0, 0);
+		case 0x2: return Vector3i( 0, 0, 1);
+	}
+	return Vector3i(-1, 0, 0);
+}
+
+
+
+
+
+Vector3i cEventRedstoneSimulator::GetTorchBaseOffset(NIBBLETYPE a_BlockMeta)
+{
+	int x = 0, y = 0, z = 0;
+	AddFaceDirection(x, y, z, cBlockTorchHandler::MetaDataToDirection(a_BlockMeta), true);  // Inverse to get the block the torch is on
+	return Vector3i(x, y, z);
+}
+
+
+
+
+
+Vector3i cEventRedstoneSimulator::GetPistonFrontOffset(NIBBLETYPE a_BlockMeta)
+{
+	if ((a_BlockMeta & 0x07) > 0x05)
+	{
+		return Vector3i(0, 0, 0);  // Invalid meta, doesn't have a front
+	}
+	int x = 0, y = 0, z = 0;
+	AddFaceDirection(x, y, z, cPiston::MetaDataToDirection(a_BlockMeta & 0x07));
+	return Vector3i(x, y, z);
+}
+
+
+
+
+
+void cEventRedstoneSimulator::EraseInputsFrom(cInputs & a_Inputs, UInt64 a_Source)
+{
+	for (cInputs::iterator itr = a_Inputs.begin(); itr != a_Inputs.end();)
+	{
+		if (itr->m_Source == a_Source)
+		{
+			itr = a_Inputs.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+}
+
+
+
+
@@ -0,0 +1,295 @@
+
+// EventRedstoneSimulator.h
+
+// Declares the cEventRedstoneSimulator class representing an event-driven redstone simulator working on a compiled graph of the redstone components
+
+/*
+Instead of re-evaluating every redstone block in every tick, this simulator keeps a graph of all the redstone
+components in the loaded chunks. Each node (wire, torch, repeater, comparator, power source or mechanism) knows the
+nodes it powers, either directly or through a solid block, and the nodes it is powered by. The graph is updated
+locally whenever a block changes: all the nodes within 2 blocks of the change (the furthest a node can power) have
+their outputs recompiled.
+
+A node is re-evaluated only when one of its inputs changes. Wires and mechanisms are evaluated immediately, so a change
+propagates through a whole wire network within the same tick. Torches, repeaters and comparators have a delay; their
+output changes are scheduled on a timing wheel and applied when their tick comes. The only nodes that are polled are
+the ones depending on something other than blocks: pressure plates (entities) and daylight sensors (time of day).
+
+The graph is only accessed while holding m_CS. The changes to the world are collected while evaluating and applied
+after m_CS is released, because the world calls back into WakeUp() with the chunkmap locked.
+
+Not implemented yet: comparators reading containers, weighted pressure plate levels, torch burnout.
+*/
+
+
+
+
+
+#pragma once
+
+#include "RedstoneSimulator.h"
+
+
+
+
+
+class cEventRedstoneSimulator :
+	public cRedstoneSimulator
+{
+	typedef cRedstoneSimulator super;
+
+public:
+
+	cEventRedstoneSimulator(cWorld & a_World);
+
+	virtual void Simulate(float a_Dt) override;
+	virtual bool IsAllowedBlock(BLOCKTYPE a_BlockType) override { return (GetNodeKind(a_BlockType) != nkNone); }
+	virtual void WakeUp(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk) override;
+	virtual void DropChunk(int a_ChunkX, int a_ChunkZ) override;
+
+	/** Returns the number of nodes in the graph */
+	size_t GetNumNodes(void);
+
+protected:
+
+	enum eNodeKind
+	{
+		nkNone,
+		nkWire,
+		nkTorch,
+		nkRepeater,
+		nkComparator,
+		nkSource,        ///< Lever, button, detector rail, block of redstone; the output depends on the block meta
+		nkPolledSource,  ///< Pressure plate, daylight sensor; the output is polled from the world each tick
+		nkMechanism,     ///< Anything that only accepts power
+	} ;
+
+	enum eInputKind
+	{
+		ikDirect,        ///< The source is adjacent and powers this node
+		ikThroughBlock,  ///< The source powers a solid block adjacent to this node
+		ikSide,          ///< Repeater / comparator side input (locking / subtraction)
+	} ;
+
+	struct sInput
+	{
+		UInt64     m_Source;
+		eInputKind m_Kind;
+
+		sInput(UInt64 a_Source, eInputKind a_Kind) :
+			m_Source(a_Source),
+			m_Kind(a_Kind)
+		{
+		}
+	} ;
+
+	typedef std::vector<sInput> cInputs;
+	typedef std::vector<UInt64> cKeys;
+
+	struct sNode
+	{
+		Vector3i   m_Pos;
+		BLOCKTYPE  m_BlockType;  ///< The block type as last seen in or set to the world
+		NIBBLETYPE m_BlockMeta;  ///< The block meta as last seen in or set to the world
+		eNodeKind  m_Kind;
+
+		/** The power level this node outputs, 0 - 15 */
+		int m_Level;
+
+		/** For mechanisms, whether they were powered the last time they were evaluated */
+		bool m_IsPowered;
+
+		/** True if the node is in m_Dirty */
+		bool m_IsQueued;
+
+		/** The tick when the scheduled output change is applied, or -1 if none is scheduled */
+		Int64 m_ScheduledTick;
+
+		/** The output level to be set when m_ScheduledTick comes */
+		int m_ScheduledLevel;
+
+		/** The nodes this node powers */
+		cKeys m_Outputs;
+
+		/** The nodes this node is powered by */
+		cInputs m_Inputs;
+	} ;
+
+	typedef std::map<UInt64, sNode> cNodes;
+
+	enum eActionType
+	{
+		actSetBlock,
+		actSetMeta,
+		actPressurePlate,
+		actPiston,
+		actTNT,
+		actDoor,
+		actTrapdoor,
+		actFenceGate,
+		actNoteBlock,
+		actDropSpenser,
+		actCommandBlock,
+	} ;
+
+	/** A change to the world, collected while evaluating the graph, applied afterwards */
+	struct sAction
+	{
+		eActionType m_Type;
+		Vector3i    m_Pos;
+		BLOCKTYPE   m_PrevBlockType;  ///< The block type expected at m_Pos, the action is skipped if it is different
+		BLOCKTYPE   m_BlockType;
+		NIBBLETYPE  m_BlockMeta;
+		bool        m_IsPowered;
+
+		sAction(eActionType a_Type, const sNode & a_Node, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta, bool a_IsPowered) :
+			m_Type(a_Type),
+			m_Pos(a_Node.m_Pos),
+			m_PrevBlockType(a_Node.m_BlockType),
+			m_BlockType(a_BlockType),
+			m_BlockMeta(a_BlockMeta),
+			m_IsPowered(a_IsPowered)
+		{
+		}
+	} ;
+
+	typedef std::vector<sAction> cActions;
+
+	/** The state of a polled node, as read from the world */
+	struct sPolledState
+	{
+		UInt64    m_Key;
+		Vector3i  m_Pos;
+		BLOCKTYPE m_BlockType;
+		int       m_Level;
+	} ;
+
+	typedef std::vector<sPolledState> cPolledStates;
+
+	/** Number of slots in the timing wheel; must be larger than the longest delay */
+	static const int WHEEL_SIZE = 16;
+
+	/** Maximum number of node evaluations per tick; the rest is left for the next tick (runaway wire loops) */
+	static const int MAX_EVALUATIONS_PER_TICK = 65536;
+
+	/** Number of ticks between the daylight sensor polls */
+	static const int DAYLIGHT_POLL_INTERVAL = 20;
+
+
+	/** Protects all the graph data; never held while calling into the world */
+	cCriticalSection m_CS;
+
+	cNodes m_Nodes;
+
+	/** Nodes that need to be re-evaluated */
+	cKeys m_Dirty;
+
+	/** The timing wheel: nodes with an output change scheduled, in the slot of their tick */
+	cKeys m_Wheel[WHEEL_SIZE];
+
+	/** The current simulator tick */
+	Int64 m_Tick;
+
+	/** Nodes that need to be polled each tick (pressure plates, daylight sensors) */
+	std::set<UInt64> m_PolledNodes;
+
+	/** World changes collected by the evaluation, to be applied once m_CS is released */
+	cActions m_Actions;
+
+	/** The chunk used for reading the world while updating the graph in WakeUp() */
+	cChunk * m_Chunk;
+
+
+	virtual void AddBlock(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk) override;
+
+	/** Returns the kind of node representing the specified block type, nkNone if not redstone */
+	static eNodeKind GetNodeKind(BLOCKTYPE a_BlockType);
+
+	/** Returns the meta bits that determine how the specified block connects to its neighbors */
+	static NIBBLETYPE GetStructuralMetaMask(BLOCKTYPE a_BlockType);
+
+	/** Reads a block from the world around m_Chunk; returns air if the chunk is not available. Assumes m_CS is locked. */
+	void GetBlock(const Vector3i & a_Pos, BLOCKTYPE & a_BlockType, NIBBLETYPE & a_BlockMeta);
+
+	/** Returns the node at the specified coords, or NULL if there is none. Assumes m_CS is locked. */
+	sNode * FindNode(const Vector3i & a_Pos);
+
+	/** Updates the node at the specified coords to match the world, then recompiles all nodes that may be affected. Assumes m_CS is locked. */
+	void BlockChanged(const Vector3i & a_Pos);
+
+	/** Creates a new node for the block, with the state taken from the block. Assumes m_CS is locked. */
+	sNode & CreateNode(const Vector3i & a_Pos, BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
+
+	/** Removes the node and all links to it. If a_NotifyOutputs is true, the nodes it powered are re-evaluated. Assumes m_CS is locked. */
+	void RemoveNode(cNodes::iterator a_Node, bool a_NotifyOutputs);
+
+	/** Rebuilds the list of nodes powered by the specified node, from the current world. Assumes m_CS is locked. */
+	void CompileOutputs(sNode & a_Node);
+
+	/** Adds a link from a_Source to a_Target, unless already present. Assumes m_CS is locked. */
+	void AddLink(sNode & a_Source, sNode & a_Target, eInputKind a_Kind);
+
+	/** Returns true if the wire at the specified position connects in the specified horizontal direction */
+	bool IsWireConnected(const sNode & a_Wire, const Vector3i & a_Dir);
+
+	/** Returns true if the wire is pointing in the specified horizontal direction, i.e. it powers the block there */
+	bool IsWirePointing(const sNode & a_Wire, const Vector3i & a_Dir);
+
+	/** Returns true if a_Source powers the adjacent node in the specified direction */
+	bool PowersDirectly(const sNode & a_Source, const Vector3i & a_Dir);
+
+	/** Returns how a_Source powers the adjacent solid block in the specified direction: 0 = not at all, 1 = weakly, 2 = strongly */
+	int PowersBlock(const sNode & a_Source, const Vector3i & a_Dir);
+
+	/** Returns true and the input kind if a_Target accepts power from an adjacent node in a_Dir (from the target) */
+	static bool AcceptsDirect(const sNode & a_Target, const sNode & a_Source, const Vector3i & a_Dir, eInputKind & a_Kind);
+
+	/** Returns true if a_Target accepts power from an adjacent solid block in a_Dir (from the target) powered with a_Strength */
+	static bool AcceptsThroughBlock(const sNode & a_Target, const Vector3i & a_Dir, int a_Strength);
+
+	/** Queues the node for re-evaluation. Assumes m_CS is locked. */
+	void MarkDirty(sNode & a_Node);
+
+	/** Queues all the nodes powered by the node for re-evaluation. Assumes m_CS is locked. */
+	void MarkOutputsDirty(sNode & a_Node);
+
+	/** Re-evaluates the node from its inputs. Assumes m_CS is locked. */
+	void Evaluate(sNode & a_Node);
+
+	/** Schedules an output change of a delayed node, unless one is already pending. Assumes m_CS is locked. */
+	void ScheduleOutput(sNode & a_Node, int a_Delay, int a_Level);
+
+	/** Sets the output level of a delayed node and queues the world change. Assumes m_CS is locked. */
+	void SetOutput(sNode & a_Node, int a_Level);
+
+	/** Applies the output changes scheduled for the current tick. Assumes m_CS is locked. */
+	void FireScheduled(void);
+
+	/** Evaluates the dirty nodes, until there are none or the per-tick limit is reached. Assumes m_CS is locked. */
+	void ProcessDirty(void);
+
+	/** Reads the current output of a polled node from the world. Must not be called with m_CS locked. */
+	int PollLevel(const sPolledState & a_State);
+
+	/** Applies the world changes. Must not be called with m_CS locked. */
+	void ApplyActions(const cActions & a_Actions);
+
+	/** Returns the offset of the block that the specified lever or button is attached to */
+	static Vector3i GetAttachmentOffset(BLOCKTYPE a_BlockType, NIBBLETYPE a_BlockMeta);
+
+	/** Returns the offset of the block that a repeater or a comparator outputs to */
+	static Vector3i GetFrontOffset(NIBBLETYPE a_BlockMeta);
+
+	/** Returns the offset of the block the torch is standing on */
+	static Vector3i GetTorchBaseOffset(NIBBLETYPE a_BlockMeta);
+
+	/** Removes all the inputs coming from the specified source */
+	static void EraseInputsFrom(cInputs & a_Inputs, UInt64 a_Source);
+
+	/** Returns the offset of the piston's face */
+	static Vector3i GetPistonFrontOffset(NIBBLETYPE a_BlockMeta);
+} ;
+
+
+
+
@@ -64,8 +64,12 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 		return;
 	}
 
+	// Fetch all the neighbors at once; they don't change until this block starts spreading:
+	sNeighbors Neighbors;
+	GetNeighbors(a_Chunk, a_RelX, a_RelY, a_RelZ, Neighbors);
+
 	// When in contact with water, lava should harden
-	if (HardenBlock(a_Chunk, a_RelX, a_RelY, a_RelZ, MyBlock, MyMeta))
+	if (HardenBlock(a_Chunk, a_RelX, a_RelY, a_RelZ, MyBlock, MyMeta, Neighbors))
 	{
 		// Block was changed, bail out
 		return;
@@ -74,7 +78,7 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 	if (MyMeta != 0)
 	{
 		// Source blocks aren't checked for tributaries, others are.
-		if (CheckTributaries(a_Chunk, a_RelX, a_RelY, a_RelZ, MyMeta))
+		if (CheckTributaries(a_Chunk, a_RelX, a_RelY, a_RelZ, MyMeta, Neighbors))
 		{
 			// Has no tributary, has been decreased (in CheckTributaries()),
 			// no more processing needed (neighbors have been scheduled by the decrease)
@@ -88,9 +92,9 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 	// Otherwise it is the current meta plus falloff (may be larger than max height, will be checked later)
 	NIBBLETYPE NewMeta = ((MyMeta == 0) || ((MyMeta & 0x08) != 0)) ? m_Falloff : (MyMeta + m_Falloff);
 	bool SpreadFurther = true;
-	if (a_RelY > 0)
+	if (Neighbors.m_IsValid[nbYM])
 	{
-		BLOCKTYPE Below = a_Chunk->GetBlock(a_RelX, a_RelY - 1, a_RelZ);
+		BLOCKTYPE Below = Neighbors.m_BlockType[nbYM];
 		if (IsPassableForFluid(Below) || IsBlockLava(Below) || IsBlockWater(Below))
 		{
 			// Spread only down, possibly washing away what's there or turning lava to stone / cobble / obsidian:
@@ -107,7 +111,7 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 			(m_NumNeighborsForSource > 0) &&  // Source creation is on
 			(MyMeta == m_Falloff) &&          // Only exactly one block away from a source (fast bail-out)
 			!IsPassableForFluid(Below) &&     // Only exactly 1 block deep
-			CheckNeighborsForSource(a_Chunk, a_RelX, a_RelY, a_RelZ)  // Did we create a source?
+			CheckNeighborsForSource(a_Chunk, a_RelX, a_RelY, a_RelZ, Neighbors)  // Did we create a source?
 		)
 		{
 			// We created a source, no more spreading is to be done now
@@ -130,6 +134,66 @@ void cFloodyFluidSimulator::SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_Re
 
 
 
+void cFloodyFluidSimulator::GetNeighbors(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, sNeighbors & a_Neighbors)
+{
+	static const Vector3i Coords[nbCount] =
+	{
+		Vector3i(-1,  0,  0),  // nbXM
+		Vector3i( 1,  0,  0),  // nbXP
+		Vector3i( 0,  0, -1),  // nbZM
+		Vector3i( 0,  0,  1),  // nbZP
+		Vector3i( 0, -1,  0),  // nbYM
+		Vector3i( 0,  1,  0),  // nbYP
+	} ;
+	
+	// The block itself may be across the chunk border (when hardening a block spread into):
+	if ((a_RelX < 0) || (a_RelX >= cChunkDef::Width) || (a_RelZ < 0) || (a_RelZ >= cChunkDef::Width))
+	{
+		a_Chunk = a_Chunk->GetRelNeighborChunkAdjustCoords(a_RelX, a_RelZ);
+		if ((a_Chunk == NULL) || !a_Chunk->IsValid())
+		{
+			for (int i = 0; i < nbCount; i++)
+			{
+				a_Neighbors.m_IsValid[i] = false;
+			}
+			return;
+		}
+	}
+	
+	// Vertical neighbors are always in the same chunk, if in the world at all:
+	a_Neighbors.m_IsValid[nbYM] = (a_RelY > 0);
+	if (a_Neighbors.m_IsValid[nbYM])
+	{
+		a_Chunk->GetBlockTypeMeta(a_RelX, a_RelY - 1, a_RelZ, a_Neighbors.m_BlockType[nbYM], a_Neighbors.m_BlockMeta[nbYM]);
+	}
+	a_Neighbors.m_IsValid[nbYP] = (a_RelY < cChunkDef::Height - 1);
+	if (a_Neighbors.m_IsValid[nbYP])
+	{
+		a_Chunk->GetBlockTypeMeta(a_RelX, a_RelY + 1, a_RelZ, a_Neighbors.m_BlockType[nbYP], a_Neighbors.m_BlockMeta[nbYP]);
+	}
+	
+	// Horizontal neighbors; the chunk lookup is needed only on the chunk border:
+	bool IsInterior = (a_RelX > 0) && (a_RelX < cChunkDef::Width - 1) && (a_RelZ > 0) && (a_RelZ < cChunkDef::Width - 1);
+	for (int i = 0; i < nbNumHorizontal; i++)
+	{
+		int x = a_RelX + Coords[i].x;
+		int z = a_RelZ + Coords[i].z;
+		if (IsInterior)
+		{
+			a_Chunk->GetBlockTypeMeta(x, a_RelY, z, a_Neighbors.m_BlockType[i], a_Neighbors.m_BlockMeta[i]);
+			a_Neighbors.m_IsValid[i] = true;
+		}
+		else
+		{
+			a_Neighbors.m_IsValid[i] = a_Chunk->UnboundedRelGetBlock(x, a_RelY, z, a_Neighbors.m_BlockType[i], a_Neighbors.m_BlockMeta[i]);
+		}
+	}
+}
+
+
+
+
+
 void cFloodyFluidSimulator::Spread(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_NewMeta)
 {
 	SpreadToNeighbor(a_Chunk, a_RelX - 1, a_RelY, a_RelZ,     a_NewMeta);
@@ -141,12 +205,12 @@ void cFloodyFluidSimulator::Spread(cChunk * a_Chunk, int a_RelX, int a_RelY, int
 
 
 
-bool cFloodyFluidSimulator::CheckTributaries(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta)
+bool cFloodyFluidSimulator::CheckTributaries(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta, const sNeighbors & a_Neighbors)
 {
 	// If we have a section above, check if there's fluid above this block that would feed it:
-	if (a_RelY < cChunkDef::Height - 1)
+	if (a_Neighbors.m_IsValid[nbYP])
 	{
-		if (IsAnyFluidBlock(a_Chunk->GetBlock(a_RelX, a_RelY + 1, a_RelZ)))
+		if (IsAnyFluidBlock(a_Neighbors.m_BlockType[nbYP]))
 		{
 			// This block is fed from above, no more processing needed
 			FLOG("  Fed from above");
@@ -157,33 +221,21 @@ bool cFloodyFluidSimulator::CheckTributaries(cChunk * a_Chunk, int a_RelX, int a
 	// Not fed from above, check if there's a feed from the side (but not if it's a downward-flowing block):
 	if (a_MyMeta != 8)
 	{
-		BLOCKTYPE BlockType;
-		NIBBLETYPE BlockMeta;
-		static const Vector3i Coords[] =
-		{
-			Vector3i( 1, 0,  0),
-			Vector3i(-1, 0,  0),
-			Vector3i( 0, 0,  1),
-			Vector3i( 0, 0, -1),
-		} ;
-		for (size_t i = 0; i < ARRAYCOUNT(Coords); i++)
+		for (int i = 0; i < nbNumHorizontal; i++)
 		{
-			if (!a_Chunk->UnboundedRelGetBlock(a_RelX + Coords[i].x, a_RelY, a_RelZ + Coords[i].z, BlockType, BlockMeta))
+			if (!a_Neighbors.m_IsValid[i])
 			{
 				continue;
 			}
+			BLOCKTYPE BlockType = a_Neighbors.m_BlockType[i];
+			NIBBLETYPE BlockMeta = a_Neighbors.m_BlockMeta[i];
 			if (IsAllowedBlock(BlockType) && IsHigherMeta(BlockMeta, a_MyMeta))
 			{
 				// This block is fed, no more processing needed
-				FLOG("  Fed from {%d, %d, %d}, type %d, meta %d",
-					a_Chunk->GetPosX() * cChunkDef::Width + a_RelX + Coords[i].x,
-					a_RelY,
-					a_Chunk->GetPosZ() * cChunkDef::Width + a_RelZ + Coords[i].z,
-					BlockType, BlockMeta
-				);
+				FLOG("  Fed from neighbor %d, type %d, meta %d", i, BlockType, BlockMeta);
 				return false;
 			}
-		}  // for i - Coords[]
+		}  // for i - a_Neighbors[]
 	}  // if not fed from above
 	
 	// Block is not fed, decrease by m_Falloff levels:
@@ -326,36 +378,23 @@ void cFloodyFluidSimulator::SpreadToNeighbor(cChunk * a_NearChunk, int a_RelX, i
 
 
 
-bool cFloodyFluidSimulator::CheckNeighborsForSource(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ)
+bool cFloodyFluidSimulator::CheckNeighborsForSource(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, const sNeighbors & a_Neighbors)
 {
 	FLOG("  Checking neighbors for source creation");
 	
-	static const Vector3i NeighborCoords[] =
-	{
-		Vector3i(-1, 0,  0),
-		Vector3i( 1, 0,  0),
-		Vector3i( 0, 0, -1),
-		Vector3i( 0, 0,  1),
-	} ;
-	
 	int NumNeeded = m_NumNeighborsForSource;
-	for (size_t i = 0; i < ARRAYCOUNT(NeighborCoords); i++)
+	for (int i = 0; i < nbNumHorizontal; i++)
 	{
-		int x = a_RelX + NeighborCoords[i].x;
-		int y = a_RelY + NeighborCoords[i].y;
-		int z = a_RelZ + NeighborCoords[i].z;
-		BLOCKTYPE BlockType;
-		NIBBLETYPE BlockMeta;
-		if (!a_Chunk->UnboundedRelGetBlock(x, y, z, BlockType, BlockMeta))
+		if (!a_Neighbors.m_IsValid[i])
 		{
 			// Neighbor not available, skip it
 			continue;
 		}
-		// FLOG("   Neighbor at {%d, %d, %d}: %s", x, y, z, ItemToFullString(cItem(BlockType, 1, BlockMeta)).c_str());
-		if ((BlockMeta == 0) && IsAnyFluidBlock(BlockType))
+		// FLOG("   Neighbor %d: %s", i, ItemToFullString(cItem(a_Neighbors.m_BlockType[i], 1, a_Neighbors.m_BlockMeta[i])).c_str());
+		if ((a_Neighbors.m_BlockMeta[i] == 0) && IsAnyFluidBlock(a_Neighbors.m_BlockType[i]))
 		{
 			NumNeeded--;
-			// FLOG("    Found a neighbor source at {%d, %d, %d}, NumNeeded := %d", x, y, z, NumNeeded);
+			// FLOG("    Found a neighbor source %d, NumNeeded := %d", i, NumNeeded);
 			if (NumNeeded == 0)
 			{
 				// Found enough, turn into a source and bail out
@@ -375,34 +414,38 @@ bool cFloodyFluidSimulator::CheckNeighborsForSource(cChunk * a_Chunk, int a_RelX
 
 bool cFloodyFluidSimulator::HardenBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta)
 {
-	// Only lava blocks can harden
+	// Only lava blocks can harden; don't bother reading the neighbors for anything else
 	if (!IsBlockLava(a_BlockType))
 	{
 		return false;
 	}
 
-	bool ShouldHarden = false;
+	sNeighbors Neighbors;
+	GetNeighbors(a_Chunk, a_RelX, a_RelY, a_RelZ, Neighbors);
+	return HardenBlock(a_Chunk, a_RelX, a_RelY, a_RelZ, a_BlockType, a_Meta, Neighbors);
+}
 
-	BLOCKTYPE BlockType;
-	NIBBLETYPE BlockMeta;
-	static const Vector3i Coords[] =
+
+
+
+
+bool cFloodyFluidSimulator::HardenBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const sNeighbors & a_Neighbors)
+{
+	// Only lava blocks can harden
+	if (!IsBlockLava(a_BlockType))
 	{
-		Vector3i( 1, 0,  0),
-		Vector3i(-1, 0,  0),
-		Vector3i( 0, 0,  1),
-		Vector3i( 0, 0, -1),
-	};
-	for (size_t i = 0; i < ARRAYCOUNT(Coords); i++)
+		return false;
+	}
+
+	bool ShouldHarden = false;
+	for (int i = 0; i < nbNumHorizontal; i++)
 	{
-		if (!a_Chunk->UnboundedRelGetBlock(a_RelX + Coords[i].x, a_RelY, a_RelZ + Coords[i].z, BlockType, BlockMeta))
-		{
-			continue;
-		}
-		if (IsBlockWater(BlockType))
+		if (a_Neighbors.m_IsValid[i] && IsBlockWater(a_Neighbors.m_BlockType[i]))
 		{
 			ShouldHarden = true;
+			break;
 		}
-	}  // for i - Coords[]
+	}  // for i - a_Neighbors[]
 
 	if (ShouldHarden)
 	{
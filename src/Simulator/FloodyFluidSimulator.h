@@ -32,25 +32,53 @@ public:
 	cFloodyFluidSimulator(cWorld & a_World, BLOCKTYPE a_Fluid, BLOCKTYPE a_StationaryFluid, NIBBLETYPE a_Falloff, int a_TickDelay, int a_NumNeighborsForSource);
 	
 protected:
+	/** Indices into sNeighbors; the horizontal neighbors come first */
+	enum
+	{
+		nbXM,
+		nbXP,
+		nbZM,
+		nbZP,
+		nbYM,
+		nbYP,
+		nbCount,
+		nbNumHorizontal = 4,
+	} ;
+	
+	/** The six neighbors of a simulated block, fetched all at once */
+	struct sNeighbors
+	{
+		BLOCKTYPE  m_BlockType[nbCount];
+		NIBBLETYPE m_BlockMeta[nbCount];
+		bool       m_IsValid[nbCount];  ///< False if the neighbor is outside the world or its chunk is not available
+	} ;
+	
 	NIBBLETYPE m_Falloff;
 	int        m_NumNeighborsForSource;
 	
 	// cDelayedFluidSimulator overrides:
 	virtual void SimulateBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ) override;
 	
+	/** Reads all six neighbors of the block. Blocks inside a_Chunk are read directly, only the ones across the chunk border
+	need the neighbor chunk lookup. */
+	void GetNeighbors(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, sNeighbors & a_Neighbors);
+	
 	/** Checks tributaries, if not fed, decreases the block's level and returns true. */
-	bool CheckTributaries(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta);
+	bool CheckTributaries(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_MyMeta, const sNeighbors & a_Neighbors);
 
 	/** Spreads into the specified block, if the blocktype there allows. a_Area is for checking. */
 	void SpreadToNeighbor(cChunk * a_NearChunk, int a_RelX, int a_RelY, int a_RelZ, NIBBLETYPE a_NewMeta);
 	
 	/** Checks if there are enough neighbors to create a source at the coords specified; turns into source and returns true if so. */
-	bool CheckNeighborsForSource(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ);
+	bool CheckNeighborsForSource(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, const sNeighbors & a_Neighbors);
 
 	/** Checks if the specified block should harden (Water/Lava interaction) and if so, converts it to a suitable block.
 	 *
 	 * Returns whether the block was changed or not.
 	 */
+	bool HardenBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta, const sNeighbors & a_Neighbors);
+
+	/** Same as above, but reads the neighbors itself. */
 	bool HardenBlock(cChunk * a_Chunk, int a_RelX, int a_RelY, int a_RelZ, BLOCKTYPE a_BlockType, NIBBLETYPE a_Meta);
 
 	/** Spread water to neighbors.
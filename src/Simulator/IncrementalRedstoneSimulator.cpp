@@ -68,101 +68,73 @@ void cIncrementalRedstoneSimulator::RedstoneAddBlock(int a_BlockX, int a_BlockY,
 	// Every time a block is changed (AddBlock called), we want to go through all lists and check to see if the coordiantes stored within are still valid
 	// Checking only when a block is changed, as opposed to every tick, also improves performance
 
+	Vector3i ChangedPos(a_BlockX, a_BlockY, a_BlockZ);
+	UInt64 ChangedKey = cRedstonePowerTable::MakeKey(ChangedPos);
+
 	PoweredBlocksList * PoweredBlocks = a_Chunk->GetRedstoneSimulatorPoweredBlocksList();
-	for (PoweredBlocksList::iterator itr = PoweredBlocks->begin(); itr != PoweredBlocks->end(); ++itr)
+	if (!IsPotentialSource(Block))
 	{
-		if (!itr->a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			continue;
-		}
-
-		if (!IsPotentialSource(Block))
+		if (PoweredBlocks->EraseBySource(ChangedPos) > 0)
 		{
-			LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from powered blocks list as it no longer connected to a source", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-			PoweredBlocks->erase(itr);
-			break;
+			LOGD("cIncrementalRedstoneSimulator: Erased blocks powered by {%i, %i, %i} from powered blocks list as it is no longer a source", a_BlockX, a_BlockY, a_BlockZ);
 		}
-		else if (
-			// Changeable sources
-			((Block == E_BLOCK_REDSTONE_WIRE) && (Meta == 0)) ||
-			((Block == E_BLOCK_LEVER) && !IsLeverOn(Meta)) ||
-			((Block == E_BLOCK_DETECTOR_RAIL) && (Meta & 0x08) == 0) ||
-			(((Block == E_BLOCK_STONE_BUTTON) || (Block == E_BLOCK_WOODEN_BUTTON)) && (!IsButtonOn(Meta))) ||
-			(((Block == E_BLOCK_STONE_PRESSURE_PLATE) || (Block == E_BLOCK_WOODEN_PRESSURE_PLATE)) && (Meta == 0)) ||
-			(((Block == E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE) || (Block == E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE)) && (Meta == 0))
-			)
+	}
+	else if (
+		// Changeable sources
+		((Block == E_BLOCK_REDSTONE_WIRE) && (Meta == 0)) ||
+		((Block == E_BLOCK_LEVER) && !IsLeverOn(Meta)) ||
+		((Block == E_BLOCK_DETECTOR_RAIL) && (Meta & 0x08) == 0) ||
+		(((Block == E_BLOCK_STONE_BUTTON) || (Block == E_BLOCK_WOODEN_BUTTON)) && (!IsButtonOn(Meta))) ||
+		(((Block == E_BLOCK_STONE_PRESSURE_PLATE) || (Block == E_BLOCK_WOODEN_PRESSURE_PLATE)) && (Meta == 0)) ||
+		(((Block == E_BLOCK_LIGHT_WEIGHTED_PRESSURE_PLATE) || (Block == E_BLOCK_HEAVY_WEIGHTED_PRESSURE_PLATE)) && (Meta == 0))
+		)
+	{
+		if (PoweredBlocks->EraseBySource(ChangedPos) > 0)
 		{
-			LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from powered blocks list due to present/past metadata mismatch", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-			PoweredBlocks->erase(itr);
-			break;
+			LOGD("cIncrementalRedstoneSimulator: Erased blocks powered by {%i, %i, %i} from powered blocks list due to present/past metadata mismatch", a_BlockX, a_BlockY, a_BlockZ);
 		}
 	}
 
 	LinkedBlocksList * LinkedPoweredBlocks = a_Chunk->GetRedstoneSimulatorLinkedBlocksList();
-	// We loop through all values (insteading of breaking out at the first) to make sure everything is gone, as there can be multiple SourceBlock entries for one AddBlock coordinate
-	for (LinkedBlocksList::iterator itr = LinkedPoweredBlocks->begin(); itr != LinkedPoweredBlocks->end();)
+	if (!IsPotentialSource(Block))
 	{
-		if (itr->a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		if (LinkedPoweredBlocks->EraseBySource(ChangedPos) > 0)
 		{
-			if (!IsPotentialSource(Block))
-			{
-				LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from linked powered blocks list as it is no longer connected to a source", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-				itr = LinkedPoweredBlocks->erase(itr);
-				continue;
-			}
-			else if (
-				// Things that can send power through a block but which depends on meta
-				((Block == E_BLOCK_REDSTONE_WIRE) && (Meta == 0)) ||
-				((Block == E_BLOCK_LEVER) && !IsLeverOn(Meta)) ||
-				(((Block == E_BLOCK_STONE_BUTTON) || (Block == E_BLOCK_WOODEN_BUTTON)) && (!IsButtonOn(Meta)))
-				)
-			{
-				LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from linked powered blocks list due to present/past metadata mismatch", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-				itr = LinkedPoweredBlocks->erase(itr);
-				continue;
-			}
-		}
-		else if (itr->a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			if (!IsViableMiddleBlock(Block))
-			{
-				LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from linked powered blocks list as it is no longer powered through a valid middle block", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-				itr = LinkedPoweredBlocks->erase(itr);
-				continue;
-			}
+			LOGD("cIncrementalRedstoneSimulator: Erased blocks powered by {%i, %i, %i} from linked powered blocks list as it is no longer a source", a_BlockX, a_BlockY, a_BlockZ);
 		}
-		++itr;
 	}
-
-	SimulatedPlayerToggleableList * SimulatedPlayerToggleableBlocks = a_Chunk->GetRedstoneSimulatorSimulatedPlayerToggleableList();
-	for (SimulatedPlayerToggleableList::iterator itr = SimulatedPlayerToggleableBlocks->begin(); itr != SimulatedPlayerToggleableBlocks->end(); ++itr)
+	else if (
+		// Things that can send power through a block but which depends on meta
+		((Block == E_BLOCK_REDSTONE_WIRE) && (Meta == 0)) ||
+		((Block == E_BLOCK_LEVER) && !IsLeverOn(Meta)) ||
+		(((Block == E_BLOCK_STONE_BUTTON) || (Block == E_BLOCK_WOODEN_BUTTON)) && (!IsButtonOn(Meta)))
+		)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		if (LinkedPoweredBlocks->EraseBySource(ChangedPos) > 0)
 		{
-			continue;
+			LOGD("cIncrementalRedstoneSimulator: Erased blocks powered by {%i, %i, %i} from linked powered blocks list due to present/past metadata mismatch", a_BlockX, a_BlockY, a_BlockZ);
 		}
-
-		if (!IsAllowedBlock(Block))
+	}
+	if (!IsViableMiddleBlock(Block))
+	{
+		if (LinkedPoweredBlocks->EraseByMiddle(ChangedPos) > 0)
 		{
-			LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from toggleable simulated list as it is no longer redstone", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z);
-			SimulatedPlayerToggleableBlocks->erase(itr);
-			break;
+			LOGD("cIncrementalRedstoneSimulator: Erased blocks powered through {%i, %i, %i} from linked powered blocks list as it is no longer a valid middle block", a_BlockX, a_BlockY, a_BlockZ);
 		}
 	}
 
-	RepeatersDelayList * RepeatersDelayList = a_Chunk->GetRedstoneSimulatorRepeatersDelayList();
-	for (RepeatersDelayList::iterator itr = RepeatersDelayList->begin(); itr != RepeatersDelayList->end(); ++itr)
+	if (!IsAllowedBlock(Block))
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		SimulatedPlayerToggleableList * SimulatedPlayerToggleableBlocks = a_Chunk->GetRedstoneSimulatorSimulatedPlayerToggleableList();
+		if (SimulatedPlayerToggleableBlocks->erase(ChangedKey) > 0)
 		{
-			continue;
+			LOGD("cIncrementalRedstoneSimulator: Erased block @ {%i, %i, %i} from toggleable simulated list as it is no longer redstone", a_BlockX, a_BlockY, a_BlockZ);
 		}
+	}
 
-		if ((Block != E_BLOCK_REDSTONE_REPEATER_ON) && (Block != E_BLOCK_REDSTONE_REPEATER_OFF))
-		{
-			RepeatersDelayList->erase(itr);
-			break;
-		}
+	if ((Block != E_BLOCK_REDSTONE_REPEATER_ON) && (Block != E_BLOCK_REDSTONE_REPEATER_OFF))
+	{
+		a_Chunk->GetRedstoneSimulatorRepeatersDelayList()->erase(ChangedKey);
 	}
 
 	if (a_OtherChunk != NULL)
@@ -702,16 +674,13 @@ void cIncrementalRedstoneSimulator::HandleRedstoneRepeater(int a_BlockX, int a_B
 		}
 	}
 
-	for (RepeatersDelayList::iterator itr = m_RepeatersDelayList->begin(); itr != m_RepeatersDelayList->end(); ++itr)
+	RepeatersDelayList::iterator itr = m_RepeatersDelayList->find(cRedstonePowerTable::MakeKey(a_BlockX, a_BlockY, a_BlockZ));
+	if (itr != m_RepeatersDelayList->end())
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			continue;
-		}
-
-		if (itr->a_ElapsedTicks >= itr->a_DelayTicks) // Has the elapsed ticks reached the target ticks?
+		sRepeatersDelayList & Repeater = itr->second;
+		if (Repeater.a_ElapsedTicks >= Repeater.a_DelayTicks) // Has the elapsed ticks reached the target ticks?
 		{
-			if (itr->ShouldPowerOn)
+			if (Repeater.ShouldPowerOn)
 			{
 				if (!IsOn)
 				{
@@ -765,8 +734,8 @@ void cIncrementalRedstoneSimulator::HandleRedstoneRepeater(int a_BlockX, int a_B
 			// Apparently, incrementing ticks only works reliably here, and not in SimChunk;
 			// With a world with lots of redstone, the repeaters simply do not delay
 			// I am confounded to say why. Perhaps optimisation failure.
-			LOGD("Incremented a repeater @ {%i %i %i} | Elapsed ticks: %i | Target delay: %i", itr->a_BlockPos.x, itr->a_BlockPos.y, itr->a_BlockPos.z, itr->a_ElapsedTicks, itr->a_DelayTicks);
-			itr->a_ElapsedTicks++;
+			LOGD("Incremented a repeater @ {%i %i %i} | Elapsed ticks: %i | Target delay: %i", Repeater.a_BlockPos.x, Repeater.a_BlockPos.y, Repeater.a_BlockPos.z, Repeater.a_ElapsedTicks, Repeater.a_DelayTicks);
+			Repeater.a_ElapsedTicks++;
 		}
 	}
 }
@@ -1091,7 +1060,7 @@ void cIncrementalRedstoneSimulator::HandlePressurePlate(int a_BlockX, int a_Bloc
 			} ;
 
 			cPressurePlateCallback PressurePlateCallback(a_BlockX, a_BlockY, a_BlockZ, &m_World);
-			m_World.ForEachEntity(PressurePlateCallback);
+			m_World.ForEachEntityInRadius(Vector3d(a_BlockX + 0.5, a_BlockY, a_BlockZ + 0.5), 0.7, PressurePlateCallback);
 
 			NIBBLETYPE Meta = m_World.GetBlockMeta(a_BlockX, a_BlockY, a_BlockZ);
 			if (PressurePlateCallback.FoundEntity())
@@ -1126,14 +1095,7 @@ void cIncrementalRedstoneSimulator::HandlePressurePlate(int a_BlockX, int a_Bloc
 
 bool cIncrementalRedstoneSimulator::AreCoordsDirectlyPowered(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	for (PoweredBlocksList::const_iterator itr = m_PoweredBlocks->begin(); itr != m_PoweredBlocks->end(); ++itr) // Check powered list
-	{
-		if (itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			return true;
-		}
-	}
-	return false;	
+	return m_PoweredBlocks->HasBlock(a_BlockX, a_BlockY, a_BlockZ);
 }
 
 
@@ -1142,14 +1104,7 @@ bool cIncrementalRedstoneSimulator::AreCoordsDirectlyPowered(int a_BlockX, int a
 
 bool cIncrementalRedstoneSimulator::AreCoordsLinkedPowered(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	for (LinkedBlocksList::const_iterator itr = m_LinkedPoweredBlocks->begin(); itr != m_LinkedPoweredBlocks->end(); ++itr) // Check linked powered list
-	{
-		if (itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			return true;
-		}
-	}
-	return false;
+	return m_LinkedPoweredBlocks->HasBlock(a_BlockX, a_BlockY, a_BlockZ);
 }
 
 
@@ -1161,60 +1116,58 @@ bool cIncrementalRedstoneSimulator::IsRepeaterPowered(int a_BlockX, int a_BlockY
 {
 	// Repeaters cannot be powered by any face except their back; verify that this is true for a source
 
-	for (PoweredBlocksList::const_iterator itr = m_PoweredBlocks->begin(); itr != m_PoweredBlocks->end(); ++itr)
+	std::pair<PoweredBlocksList::const_iterator, PoweredBlocksList::const_iterator> Powered = m_PoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (PoweredBlocksList::const_iterator itr = Powered.first; itr != Powered.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
 		switch (a_Meta & 0x3)
 		{
 			case 0x0:
 			{
 				// Flip the coords to check the back of the repeater
-				if (itr->a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ + 1))) { return true; }
+				if (itr->second.a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ + 1))) { return true; }
 				break;
 			}
 			case 0x1:
 			{
-				if (itr->a_SourcePos.Equals(Vector3i(a_BlockX - 1, a_BlockY, a_BlockZ))) { return true; }
+				if (itr->second.a_SourcePos.Equals(Vector3i(a_BlockX - 1, a_BlockY, a_BlockZ))) { return true; }
 				break;
 			}
 			case 0x2:
 			{
-				if (itr->a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ - 1))) { return true; }
+				if (itr->second.a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ - 1))) { return true; }
 				break;
 			}
 			case 0x3:
 			{
-				if (itr->a_SourcePos.Equals(Vector3i(a_BlockX + 1, a_BlockY, a_BlockZ))) { return true; }
+				if (itr->second.a_SourcePos.Equals(Vector3i(a_BlockX + 1, a_BlockY, a_BlockZ))) { return true; }
 				break;
 			}
 		}
 	}
 
-	for (LinkedBlocksList::const_iterator itr = m_LinkedPoweredBlocks->begin(); itr != m_LinkedPoweredBlocks->end(); ++itr)
+	std::pair<LinkedBlocksList::const_iterator, LinkedBlocksList::const_iterator> Linked = m_LinkedPoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (LinkedBlocksList::const_iterator itr = Linked.first; itr != Linked.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
 		switch (a_Meta & 0x3)
 		{
 			case 0x0:
 			{
-				if (itr->a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ + 1))) { return true; }
+				if (itr->second.a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ + 1))) { return true; }
 				break;
 			}
 			case 0x1:
 			{
-				if (itr->a_MiddlePos.Equals(Vector3i(a_BlockX - 1, a_BlockY, a_BlockZ))) { return true; }
+				if (itr->second.a_MiddlePos.Equals(Vector3i(a_BlockX - 1, a_BlockY, a_BlockZ))) { return true; }
 				break;
 			}
 			case 0x2:
 			{
-				if (itr->a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ - 1))) { return true; }
+				if (itr->second.a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ - 1))) { return true; }
 				break;
 			}
 			case 0x3:
 			{
-				if (itr->a_MiddlePos.Equals(Vector3i(a_BlockX + 1, a_BlockY, a_BlockZ))) { return true; }
+				if (itr->second.a_MiddlePos.Equals(Vector3i(a_BlockX + 1, a_BlockY, a_BlockZ))) { return true; }
 				break;
 			}
 		}
@@ -1286,13 +1239,12 @@ bool cIncrementalRedstoneSimulator::IsPistonPowered(int a_BlockX, int a_BlockY,
 	int OldX = a_BlockX, OldY = a_BlockY, OldZ = a_BlockZ;
 	eBlockFace Face = cPiston::MetaDataToDirection(a_Meta);
 
-	for (PoweredBlocksList::const_iterator itr = m_PoweredBlocks->begin(); itr != m_PoweredBlocks->end(); ++itr)
+	std::pair<PoweredBlocksList::const_iterator, PoweredBlocksList::const_iterator> Powered = m_PoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (PoweredBlocksList::const_iterator itr = Powered.first; itr != Powered.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
 		AddFaceDirection(a_BlockX, a_BlockY, a_BlockZ, Face);
 
-		if (!itr->a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		if (!itr->second.a_SourcePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
 		{
 			return true;
 		}
@@ -1302,13 +1254,12 @@ bool cIncrementalRedstoneSimulator::IsPistonPowered(int a_BlockX, int a_BlockY,
 		a_BlockZ = OldZ;
 	}
 
-	for (LinkedBlocksList::const_iterator itr = m_LinkedPoweredBlocks->begin(); itr != m_LinkedPoweredBlocks->end(); ++itr)
+	std::pair<LinkedBlocksList::const_iterator, LinkedBlocksList::const_iterator> Linked = m_LinkedPoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (LinkedBlocksList::const_iterator itr = Linked.first; itr != Linked.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
 		AddFaceDirection(a_BlockX, a_BlockY, a_BlockZ, Face);
 
-		if (!itr->a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		if (!itr->second.a_MiddlePos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
 		{
 			return true;
 		}
@@ -1325,21 +1276,19 @@ bool cIncrementalRedstoneSimulator::IsPistonPowered(int a_BlockX, int a_BlockY,
 
 bool cIncrementalRedstoneSimulator::IsWirePowered(int a_BlockX, int a_BlockY, int a_BlockZ)
 {
-	for (PoweredBlocksList::const_iterator itr = m_PoweredBlocks->begin(); itr != m_PoweredBlocks->end(); ++itr)
+	std::pair<PoweredBlocksList::const_iterator, PoweredBlocksList::const_iterator> Powered = m_PoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (PoweredBlocksList::const_iterator itr = Powered.first; itr != Powered.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
-		if (m_World.GetBlock(itr->a_SourcePos) != E_BLOCK_REDSTONE_WIRE)
+		if (m_World.GetBlock(itr->second.a_SourcePos) != E_BLOCK_REDSTONE_WIRE)
 		{
 			return true;
 		}
 	}
 
-	for (LinkedBlocksList::const_iterator itr = m_LinkedPoweredBlocks->begin(); itr != m_LinkedPoweredBlocks->end(); ++itr)
+	std::pair<LinkedBlocksList::const_iterator, LinkedBlocksList::const_iterator> Linked = m_LinkedPoweredBlocks->GetBlockEntries(a_BlockX, a_BlockY, a_BlockZ);
+	for (LinkedBlocksList::const_iterator itr = Linked.first; itr != Linked.second; ++itr)
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ))) { continue; }
-
-		if (m_World.GetBlock(itr->a_SourcePos) != E_BLOCK_REDSTONE_WIRE)
+		if (m_World.GetBlock(itr->second.a_SourcePos) != E_BLOCK_REDSTONE_WIRE)
 		{
 			return true;
 		}
@@ -1353,21 +1302,15 @@ bool cIncrementalRedstoneSimulator::IsWirePowered(int a_BlockX, int a_BlockY, in
 
 bool cIncrementalRedstoneSimulator::AreCoordsSimulated(int a_BlockX, int a_BlockY, int a_BlockZ, bool IsCurrentStatePowered)
 {
-	for (SimulatedPlayerToggleableList::const_iterator itr = m_SimulatedPlayerToggleableBlocks->begin(); itr != m_SimulatedPlayerToggleableBlocks->end(); ++itr)
+	SimulatedPlayerToggleableList::const_iterator itr = m_SimulatedPlayerToggleableBlocks->find(cRedstonePowerTable::MakeKey(a_BlockX, a_BlockY, a_BlockZ));
+	if (itr == m_SimulatedPlayerToggleableBlocks->end())
 	{
-		if (itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			if (itr->WasLastStatePowered != IsCurrentStatePowered) // Was the last power state different to the current?
-			{
-				return false; // It was, coordinates are no longer simulated
-			}
-			else
-			{
-				return true; // It wasn't, don't resimulate block, and allow players to toggle
-			}
-		}
+		return false; // Block wasn't even in the list, not simulated
 	}
-	return false; // Block wasn't even in the list, not simulated
+	
+	// If the last power state was different to the current, the coordinates are no longer simulated;
+	// otherwise don't resimulate block, and allow players to toggle
+	return (itr->second.WasLastStatePowered == IsCurrentStatePowered);
 }
 
 
@@ -1497,23 +1440,8 @@ void cIncrementalRedstoneSimulator::SetBlockPowered(int a_BlockX, int a_BlockY,
 	}
 
 	PoweredBlocksList * Powered = m_Chunk->GetNeighborChunk(a_BlockX, a_BlockZ)->GetRedstoneSimulatorPoweredBlocksList();
-
-	for (PoweredBlocksList::const_iterator itr = Powered->begin(); itr != Powered->end(); ++itr) // Check powered list
-	{
-		if (
-			itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)) &&
-			itr->a_SourcePos.Equals(Vector3i(a_SourceX, a_SourceY, a_SourceZ))
-			)
-		{
-			// Check for duplicates
-			return;
-		}
-	}
-
-	sPoweredBlocks RC;
-	RC.a_BlockPos = Vector3i(a_BlockX, a_BlockY, a_BlockZ);
-	RC.a_SourcePos = Vector3i(a_SourceX, a_SourceY, a_SourceZ);
-	Powered->push_back(RC);
+	Vector3i SourcePos(a_SourceX, a_SourceY, a_SourceZ);
+	Powered->Add(Vector3i(a_BlockX, a_BlockY, a_BlockZ), SourcePos, SourcePos);  // Ignores duplicates
 }
 
 
@@ -1539,25 +1467,7 @@ void cIncrementalRedstoneSimulator::SetBlockLinkedPowered(
 	}
 
 	LinkedBlocksList * Linked = m_Chunk->GetNeighborChunk(a_BlockX, a_BlockZ)->GetRedstoneSimulatorLinkedBlocksList();
-
-	for (LinkedBlocksList::const_iterator itr = Linked->begin(); itr != Linked->end(); ++itr) // Check linked powered list
-	{
-		if (
-			itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)) &&
-			itr->a_MiddlePos.Equals(Vector3i(a_MiddleX, a_MiddleY, a_MiddleZ)) &&
-			itr->a_SourcePos.Equals(Vector3i(a_SourceX, a_SourceY, a_SourceZ))
-			)
-		{
-			// Check for duplicates
-			return;
-		}
-	}
-
-	sLinkedPoweredBlocks RC;
-	RC.a_BlockPos = Vector3i(a_BlockX, a_BlockY, a_BlockZ);
-	RC.a_MiddlePos = Vector3i(a_MiddleX, a_MiddleY, a_MiddleZ);
-	RC.a_SourcePos = Vector3i(a_SourceX, a_SourceY, a_SourceZ);
-	Linked->push_back(RC);
+	Linked->Add(Vector3i(a_BlockX, a_BlockY, a_BlockZ), Vector3i(a_MiddleX, a_MiddleY, a_MiddleZ), Vector3i(a_SourceX, a_SourceY, a_SourceZ));  // Ignores duplicates
 }
 
 
@@ -1566,31 +1476,20 @@ void cIncrementalRedstoneSimulator::SetBlockLinkedPowered(
 
 void cIncrementalRedstoneSimulator::SetPlayerToggleableBlockAsSimulated(int a_BlockX, int a_BlockY, int a_BlockZ, bool WasLastStatePowered)
 {
-	for (SimulatedPlayerToggleableList::iterator itr = m_SimulatedPlayerToggleableBlocks->begin(); itr != m_SimulatedPlayerToggleableBlocks->end(); ++itr)
+	UInt64 Key = cRedstonePowerTable::MakeKey(a_BlockX, a_BlockY, a_BlockZ);
+	SimulatedPlayerToggleableList::iterator itr = m_SimulatedPlayerToggleableBlocks->find(Key);
+	if (itr != m_SimulatedPlayerToggleableBlocks->end())
 	{
-		if (!itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
-		{
-			continue;
-		}
-
-		if (itr->WasLastStatePowered != WasLastStatePowered)
-		{
-			// If power states different, update listing
-			itr->WasLastStatePowered = WasLastStatePowered;
-			return;
-		}
-		else
-		{
-			// If states the same, just ignore
-			return;
-		}
+		// If power states different, update listing; if the same, just ignore
+		itr->second.WasLastStatePowered = WasLastStatePowered;
+		return;
 	}
 
-	// We have arrive here; no block must be in list - add one
+	// No block in the list yet - add one
 	sSimulatedPlayerToggleableList RC;
 	RC.a_BlockPos = Vector3i(a_BlockX, a_BlockY, a_BlockZ);
 	RC.WasLastStatePowered = WasLastStatePowered;
-	m_SimulatedPlayerToggleableBlocks->push_back(RC);
+	m_SimulatedPlayerToggleableBlocks->insert(SimulatedPlayerToggleableList::value_type(Key, RC));
 }
 
 
@@ -1599,21 +1498,20 @@ void cIncrementalRedstoneSimulator::SetPlayerToggleableBlockAsSimulated(int a_Bl
 
 void cIncrementalRedstoneSimulator::QueueRepeaterPowerChange(int a_BlockX, int a_BlockY, int a_BlockZ, NIBBLETYPE a_Meta, bool ShouldPowerOn)
 {
-	for (RepeatersDelayList::iterator itr = m_RepeatersDelayList->begin(); itr != m_RepeatersDelayList->end(); ++itr)
+	UInt64 Key = cRedstonePowerTable::MakeKey(a_BlockX, a_BlockY, a_BlockZ);
+	RepeatersDelayList::iterator itr = m_RepeatersDelayList->find(Key);
+	if (itr != m_RepeatersDelayList->end())
 	{
-		if (itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+		if (ShouldPowerOn == itr->second.ShouldPowerOn) // We are queued already for the same thing, don't replace entry
 		{
-			if (ShouldPowerOn == itr->ShouldPowerOn) // We are queued already for the same thing, don't replace entry
-			{
-				return;
-			}
-
-			// Already in here (normal to allow repeater to continue on powering and updating blocks in front) - just update info and quit
-			itr->a_DelayTicks = (((a_Meta & 0xC) >> 0x2) + 1) * 2; // See below for description
-			itr->a_ElapsedTicks = 0;
-			itr->ShouldPowerOn = ShouldPowerOn;
 			return;
 		}
+
+		// Already in here (normal to allow repeater to continue on powering and updating blocks in front) - just update info and quit
+		itr->second.a_DelayTicks = (((a_Meta & 0xC) >> 0x2) + 1) * 2; // See below for description
+		itr->second.a_ElapsedTicks = 0;
+		itr->second.ShouldPowerOn = ShouldPowerOn;
+		return;
 	}
 
 	// Self not in list, add self to list
@@ -1626,7 +1524,7 @@ void cIncrementalRedstoneSimulator::QueueRepeaterPowerChange(int a_BlockX, int a
 
 	RC.a_ElapsedTicks = 0;
 	RC.ShouldPowerOn = ShouldPowerOn;
-	m_RepeatersDelayList->push_back(RC);
+	m_RepeatersDelayList->insert(RepeatersDelayList::value_type(Key, RC));
 	return;
 }
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "RedstoneSimulator.h"
+#include "RedstonePowerTable.h"
 
 /// Per-chunk data for the simulator, specified individual chunks to simulate
 typedef cCoordWithBlockAndBoolVector cRedstoneSimulatorChunkData;
@@ -36,19 +37,6 @@ public:
 
 private:
 
-	struct sPoweredBlocks // Define structure of the directly powered blocks list
-	{
-		Vector3i a_BlockPos; // Position of powered block
-		Vector3i a_SourcePos; // Position of source powering the block at a_BlockPos
-	};
-
-	struct sLinkedPoweredBlocks // Define structure of the indirectly powered blocks list (i.e. repeaters powering through a block to the block at the other side)
-	{
-		Vector3i a_BlockPos;
-		Vector3i a_MiddlePos;
-		Vector3i a_SourcePos;
-	};
-
 	struct sSimulatedPlayerToggleableList
 	{
 		Vector3i a_BlockPos;
@@ -65,10 +53,11 @@ private:
 
 public:
 
-	typedef std::vector <sPoweredBlocks> PoweredBlocksList;
-	typedef std::vector <sLinkedPoweredBlocks> LinkedBlocksList;
-	typedef std::vector <sSimulatedPlayerToggleableList> SimulatedPlayerToggleableList;
-	typedef std::vector <sRepeatersDelayList> RepeatersDelayList;
+	// The per-chunk tables, all keyed by cRedstonePowerTable::MakeKey() of the block coords:
+	typedef cRedstonePowerTable PoweredBlocksList;  // Directly powered blocks; the middle pos is the same as the source pos
+	typedef cRedstonePowerTable LinkedBlocksList;  // Indirectly powered blocks (i.e. repeaters powering through a block to the block at the other side)
+	typedef std::map<UInt64, sSimulatedPlayerToggleableList> SimulatedPlayerToggleableList;
+	typedef std::map<UInt64, sRepeatersDelayList> RepeatersDelayList;
 
 private:
 
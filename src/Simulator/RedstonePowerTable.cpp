@@ -0,0 +1,123 @@
+// RedstonePowerTable.cpp
+
+// Implements the cRedstonePowerTable class representing the per-chunk list of blocks powered by the incremental redstone simulator
+
+#include "Globals.h"
+#include "RedstonePowerTable.h"
+
+
+
+
+
+bool cRedstonePowerTable::Add(const Vector3i & a_BlockPos, const Vector3i & a_MiddlePos, const Vector3i & a_SourcePos)
+{
+	UInt64 BlockKey = MakeKey(a_BlockPos);
+	std::pair<cEntries::iterator, cEntries::iterator> Range = m_Entries.equal_range(BlockKey);
+	for (cEntries::iterator itr = Range.first; itr != Range.second; ++itr)
+	{
+		if (itr->second.a_SourcePos.Equals(a_SourcePos) && itr->second.a_MiddlePos.Equals(a_MiddlePos))
+		{
+			// Check for duplicates
+			return false;
+		}
+	}
+	
+	sEntry Entry;
+	Entry.a_BlockPos = a_BlockPos;
+	Entry.a_MiddlePos = a_MiddlePos;
+	Entry.a_SourcePos = a_SourcePos;
+	m_Entries.insert(Range.second, cEntries::value_type(BlockKey, Entry));
+	m_BySource.insert(cReverseIndex::value_type(MakeKey(a_SourcePos), BlockKey));
+	m_ByMiddle.insert(cReverseIndex::value_type(MakeKey(a_MiddlePos), BlockKey));
+	return true;
+}
+
+
+
+
+
+int cRedstonePowerTable::EraseBySource(const Vector3i & a_SourcePos)
+{
+	return EraseByIndex(m_BySource, a_SourcePos, true);
+}
+
+
+
+
+
+int cRedstonePowerTable::EraseByMiddle(const Vector3i & a_MiddlePos)
+{
+	return EraseByIndex(m_ByMiddle, a_MiddlePos, false);
+}
+
+
+
+
+
+void cRedstonePowerTable::EraseEntry(cEntries::iterator a_Entry)
+{
+	EraseFromIndex(m_BySource, MakeKey(a_Entry->second.a_SourcePos), a_Entry->first);
+	EraseFromIndex(m_ByMiddle, MakeKey(a_Entry->second.a_MiddlePos), a_Entry->first);
+	m_Entries.erase(a_Entry);
+}
+
+
+
+
+
+void cRedstonePowerTable::EraseFromIndex(cReverseIndex & a_Index, UInt64 a_Key, UInt64 a_BlockKey)
+{
+	std::pair<cReverseIndex::iterator, cReverseIndex::iterator> Range = a_Index.equal_range(a_Key);
+	for (cReverseIndex::iterator itr = Range.first; itr != Range.second; ++itr)
+	{
+		if (itr->second == a_BlockKey)
+		{
+			a_Index.erase(itr);
+			return;
+		}
+	}
+	ASSERT(!"Redstone power table index out of sync");
+}
+
+
+
+
+
+int cRedstonePowerTable::EraseByIndex(cReverseIndex & a_Index, const Vector3i & a_Pos, bool a_IsSource)
+{
+	UInt64 Key = MakeKey(a_Pos);
+	int NumErased = 0;
+	for (;;)
+	{
+		cReverseIndex::iterator Reverse = a_Index.find(Key);
+		if (Reverse == a_Index.end())
+		{
+			return NumErased;
+		}
+		
+		// Find the entry in the block's range that has the matching source / middle:
+		std::pair<cEntries::iterator, cEntries::iterator> Range = m_Entries.equal_range(Reverse->second);
+		cEntries::iterator Entry = Range.second;
+		for (cEntries::iterator itr = Range.first; itr != Range.second; ++itr)
+		{
+			if ((a_IsSource ? itr->second.a_SourcePos : itr->second.a_MiddlePos).Equals(a_Pos))
+			{
+				Entry = itr;
+				break;
+			}
+		}
+		if (Entry == Range.second)
+		{
+			// Should not happen, but make sure the loop terminates
+			ASSERT(!"Redstone power table index out of sync");
+			a_Index.erase(Reverse);
+			continue;
+		}
+		EraseEntry(Entry);  // Also erases the Reverse item (or an equivalent one)
+		NumErased += 1;
+	}
+}
+
+
+
+
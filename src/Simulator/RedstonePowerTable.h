@@ -0,0 +1,104 @@
+// RedstonePowerTable.h
+
+// Declares the cRedstonePowerTable class representing the per-chunk list of blocks powered by the incremental redstone simulator
+
+/*
+The redstone simulator asks "is this block powered, and by what" many times for each redstone block in each tick, and
+"what did this block power" each time a block changes. The table is therefore indexed by the powered block, and has
+secondary indices by the source block and by the middle block (the block through which a linked power goes).
+The positions are absolute, because the sources and middle blocks may lie in the neighboring chunks.
+*/
+
+
+
+
+
+#pragma once
+
+#include "../Vector3.h"
+
+
+
+
+
+class cRedstonePowerTable
+{
+public:
+	/** One powered block, together with its source of power and, for the linked power, the block it is powered through */
+	struct sEntry
+	{
+		Vector3i a_BlockPos;
+		Vector3i a_MiddlePos;  // Same as a_SourcePos for the directly powered blocks
+		Vector3i a_SourcePos;
+	} ;
+
+	typedef std::multimap<UInt64, sEntry> cEntries;
+	typedef cEntries::const_iterator const_iterator;
+	
+	
+	/** Packs the block coords into a key usable for the lookups */
+	static UInt64 MakeKey(int a_BlockX, int a_BlockY, int a_BlockZ)
+	{
+		// 26 bits for X and Z covers the entire world (+- 32M blocks), 12 bits for Y are plenty
+		return (
+			((UInt64)((a_BlockX + 0x2000000) & 0x3ffffff) << 38) |
+			((UInt64)((a_BlockZ + 0x2000000) & 0x3ffffff) << 12) |
+			(UInt64)((a_BlockY + 0x800) & 0xfff)
+		);
+	}
+	
+	static UInt64 MakeKey(const Vector3i & a_Pos) { return MakeKey(a_Pos.x, a_Pos.y, a_Pos.z); }
+	
+	/** Adds the entry, unless an identical one is already present. Returns true if added. */
+	bool Add(const Vector3i & a_BlockPos, const Vector3i & a_MiddlePos, const Vector3i & a_SourcePos);
+	
+	/** Returns true if there is any entry for the specified block */
+	bool HasBlock(int a_BlockX, int a_BlockY, int a_BlockZ) const
+	{
+		return (m_Entries.find(MakeKey(a_BlockX, a_BlockY, a_BlockZ)) != m_Entries.end());
+	}
+	
+	/** Returns the range of all the entries for the specified block */
+	std::pair<const_iterator, const_iterator> GetBlockEntries(int a_BlockX, int a_BlockY, int a_BlockZ) const
+	{
+		return m_Entries.equal_range(MakeKey(a_BlockX, a_BlockY, a_BlockZ));
+	}
+	
+	/** Removes all the entries powered by the specified source. Returns the number of entries removed. */
+	int EraseBySource(const Vector3i & a_SourcePos);
+	
+	/** Removes all the entries powered through the specified middle block. Returns the number of entries removed. */
+	int EraseByMiddle(const Vector3i & a_MiddlePos);
+	
+	size_t size(void) const { return m_Entries.size(); }
+	bool empty(void) const { return m_Entries.empty(); }
+	const_iterator begin(void) const { return m_Entries.begin(); }
+	const_iterator end(void) const { return m_Entries.end(); }
+	
+protected:
+	/** Maps the key of a source or middle block to the keys of the blocks it powers; one item for each entry */
+	typedef std::multimap<UInt64, UInt64> cReverseIndex;
+	
+	/** All the entries, keyed by the powered block */
+	cEntries m_Entries;
+	
+	/** Index of m_Entries by the source block */
+	cReverseIndex m_BySource;
+	
+	/** Index of m_Entries by the middle block */
+	cReverseIndex m_ByMiddle;
+	
+	
+	/** Removes the specified entry from m_Entries and both the reverse indices */
+	void EraseEntry(cEntries::iterator a_Entry);
+	
+	/** Removes one item mapping a_Key to a_BlockKey from the reverse index */
+	static void EraseFromIndex(cReverseIndex & a_Index, UInt64 a_Key, UInt64 a_BlockKey);
+	
+	/** Removes all the entries whose source (a_IsSource == true) or middle block is at the specified position */
+	int EraseByIndex(cReverseIndex & a_Index, const Vector3i & a_Pos, bool a_IsSource);
+} ;
+
+
+
+
@@ -14,4 +14,7 @@ class cRedstoneSimulator :
 public:
 	cRedstoneSimulator(cWorld & a_World);
 
+	/** Called when a chunk is unloaded or its data replaced; the simulator should forget any state it keeps for the blocks in it */
+	virtual void DropChunk(int a_ChunkX, int a_ChunkZ) { UNUSED(a_ChunkX); UNUSED(a_ChunkZ); }
+
 } ;
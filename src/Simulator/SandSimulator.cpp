@@ -13,8 +13,7 @@
 
 
 cSandSimulator::cSandSimulator(cWorld & a_World, cIniFile & a_IniFile) :
-	cSimulator(a_World),
-	m_TotalBlocks(0)
+	cSimulator(a_World)
 {
 	m_IsInstantFall = a_IniFile.GetValueSetB("Physics", "SandInstantFall", false);
 }
@@ -64,7 +63,6 @@ void cSandSimulator::SimulateChunk(float a_Dt, int a_ChunkX, int a_ChunkZ, cChun
 			a_Chunk->SetBlock(itr->x, itr->y, itr->z, E_BLOCK_AIR, 0);
 		}
 	}
-	m_TotalBlocks -= ChunkData.size();
 	ChunkData.clear();
 }
 
@@ -114,7 +112,6 @@ void cSandSimulator::AddBlock(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk *
 		}
 	}
 
-	m_TotalBlocks += 1;
 	ChunkData.push_back(cCoordWithInt(RelX, a_BlockY, RelZ));
 }
 
@@ -44,8 +44,6 @@ public:
 protected:
 	bool m_IsInstantFall;  // If set to true, blocks don't fall using cFallingBlock entity, but instantly instead
 	
-	int  m_TotalBlocks;    // Total number of blocks currently in the queue for simulating
-	
 	virtual void AddBlock(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk) override;
 	
 	/// Performs the instant fall of the block - removes it from top, Finishes it at the bottom
@@ -29,11 +29,13 @@ cSimulatorManager::~cSimulatorManager()
 void cSimulatorManager::Simulate(float a_Dt)
 {
 	m_Ticks++;
+	cTickProfiler & Profiler = m_World.GetTickProfiler();
 	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr )
 	{
-		if ((m_Ticks % itr->second) == 0)
+		if ((m_Ticks % itr->m_Rate) == 0)
 		{
-			itr->first->Simulate(a_Dt);
+			cTickProfiler::cScope Scope(Profiler, itr->m_ProfilerSection);
+			itr->m_Simulator->Simulate(a_Dt);
 		}
 	}
 }
@@ -45,11 +47,13 @@ void cSimulatorManager::Simulate(float a_Dt)
 void cSimulatorManager::SimulateChunk(float a_Dt, int a_ChunkX, int a_ChunkZ, cChunk * a_Chunk)
 {
 	// m_Ticks has already been increased in Simulate()
+	cTickProfiler & Profiler = m_World.GetTickProfiler();
 	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr )
 	{
-		if ((m_Ticks % itr->second) == 0)
+		if ((m_Ticks % itr->m_Rate) == 0)
 		{
-			itr->first->SimulateChunk(a_Dt, a_ChunkX, a_ChunkZ, a_Chunk);
+			cTickProfiler::cScope Scope(Profiler, itr->m_ChunkProfilerSection);
+			itr->m_Simulator->SimulateChunk(a_Dt, a_ChunkX, a_ChunkZ, a_Chunk);
 		}
 	}
 }
@@ -62,7 +66,7 @@ void cSimulatorManager::WakeUp(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk
 {
 	for (cSimulators::iterator itr = m_Simulators.begin(); itr != m_Simulators.end(); ++itr )
 	{
-		itr->first->WakeUp(a_BlockX, a_BlockY, a_BlockZ, a_Chunk);
+		itr->m_Simulator->WakeUp(a_BlockX, a_BlockY, a_BlockZ, a_Chunk);
 	}
 }
 
@@ -70,9 +74,14 @@ void cSimulatorManager::WakeUp(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk
 
 
 
-void cSimulatorManager::RegisterSimulator(cSimulator * a_Simulator, int a_Rate)
+void cSimulatorManager::RegisterSimulator(cSimulator * a_Simulator, int a_Rate, const AString & a_Name)
 {
-	m_Simulators.push_back(std::make_pair(a_Simulator, a_Rate));
+	sSimulator Simulator;
+	Simulator.m_Simulator = a_Simulator;
+	Simulator.m_Rate = a_Rate;
+	Simulator.m_ProfilerSection = m_World.GetTickProfiler().RegisterSection("Simulator: " + a_Name);
+	Simulator.m_ChunkProfilerSection = m_World.GetTickProfiler().RegisterSection("Chunk: simulator: " + a_Name);
+	m_Simulators.push_back(Simulator);
 }
 
 
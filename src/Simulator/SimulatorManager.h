@@ -37,10 +37,20 @@ public:
 	
 	void WakeUp(int a_BlockX, int a_BlockY, int a_BlockZ, cChunk * a_Chunk);
 
-	void RegisterSimulator(cSimulator * a_Simulator, int a_Rate);  // Takes ownership of the simulator object!
+	/** Adds the simulator to be called every a_Rate ticks. a_Name is used for the simulator's sections in the world's tick profiler */
+	void RegisterSimulator(cSimulator * a_Simulator, int a_Rate, const AString & a_Name);  // Takes ownership of the simulator object!
 
 protected:
-	typedef std::vector <std::pair<cSimulator *, int> > cSimulators;
+	/** A registered simulator, with its tick profiler sections */
+	struct sSimulator
+	{
+		cSimulator * m_Simulator;
+		int m_Rate;
+		int m_ProfilerSection;       ///< Section for the Simulate() calls
+		int m_ChunkProfilerSection;  ///< Section for the SimulateChunk() calls, summed over all chunks
+	} ;
+	
+	typedef std::vector<sSimulator> cSimulators;
 	
 	cWorld & m_World;
 	cSimulators m_Simulators;
@@ -0,0 +1,299 @@
+
+// TickProfiler.cpp
+
+// Implements the cTickProfiler class representing the per-subsystem timings of a tick loop
+
+#include "Globals.h"
+
+#include "TickProfiler.h"
+#include "CommandOutput.h"
+#include "WebAdmin.h"
+#include "OSSupport/IsThread.h"
+
+
+
+
+
+/** Names of the predefined sections, in the order of cTickProfiler::eSection */
+static const char * g_PredefinedSectionNames[] =
+{
+	"Tick",
+	"Chunks",
+	"Clients",
+	"Queued blocks",
+	"Tasks",
+	"Simulators",
+	"Weather",
+	"Saving and unloading",
+	"Mobs",
+	"Chunk: simulators",
+	"Chunk: blocks",
+	"Chunk: block entities",
+	"Chunk: entities",
+	"Plugins",
+	"Commands",
+	"Clients not in a world",
+} ;
+
+
+
+
+
+/** Returns the value at the specified percentile of the sorted values */
+static Int64 GetPercentile(const std::vector<Int64> & a_Sorted, int a_Percentile)
+{
+	ASSERT(!a_Sorted.empty());
+	size_t Idx = (a_Sorted.size() * a_Percentile) / 100;
+	return a_Sorted[std::min(Idx, a_Sorted.size() - 1)];
+}
+
+
+
+
+
+cTickProfiler::cTickProfiler(const AString & a_Name) :
+	m_Name(a_Name),
+	m_HistoryPos(0),
+	m_NumTicks(0)
+{
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		m_Stripes[i] = new sStripe;
+	}
+	ASSERT(ARRAYCOUNT(g_PredefinedSectionNames) == psNumPredefined);
+	for (int i = 0; i < psNumPredefined; i++)
+	{
+		RegisterSection(g_PredefinedSectionNames[i]);
+	}
+}
+
+
+
+
+
+cTickProfiler::~cTickProfiler()
+{
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		delete m_Stripes[i];
+	}
+}
+
+
+
+
+
+int cTickProfiler::RegisterSection(const AString & a_Name)
+{
+	cCSLock Lock(m_CS);
+	for (size_t i = 0; i < m_Sections.size(); i++)
+	{
+		if (m_Sections[i].m_Name == a_Name)
+		{
+			return (int)i;
+		}
+	}
+	sSection Section;
+	Section.m_Name = a_Name;
+	Section.m_History.resize(HISTORY_SIZE, 0);
+	Section.m_HistoryCalls.resize(HISTORY_SIZE, 0);
+	m_Sections.push_back(Section);
+
+	// The stripes must have room for the section before its ID is handed out:
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		cCSLock StripeLock(m_Stripes[i]->m_CS);
+		m_Stripes[i]->m_Current.push_back(0);
+		m_Stripes[i]->m_CurrentCalls.push_back(0);
+	}
+	return (int)m_Sections.size() - 1;
+}
+
+
+
+
+
+void cTickProfiler::AddTime(int a_SectionID, Int64 a_Usec)
+{
+	sStripe & Stripe = GetThreadStripe();
+	cCSLock Lock(Stripe.m_CS);
+	ASSERT((a_SectionID >= 0) && (a_SectionID < (int)Stripe.m_Current.size()));
+	Stripe.m_Current[a_SectionID] += a_Usec;
+	Stripe.m_CurrentCalls[a_SectionID] += 1;
+}
+
+
+
+
+
+void cTickProfiler::EndTick(void)
+{
+	cCSLock Lock(m_CS);
+	for (cSections::iterator itr = m_Sections.begin(), end = m_Sections.end(); itr != end; ++itr)
+	{
+		itr->m_History[m_HistoryPos] = 0;
+		itr->m_HistoryCalls[m_HistoryPos] = 0;
+	}
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		sStripe & Stripe = *m_Stripes[i];
+		cCSLock StripeLock(Stripe.m_CS);
+		for (size_t j = 0; j < m_Sections.size(); j++)
+		{
+			m_Sections[j].m_History[m_HistoryPos] += Stripe.m_Current[j];
+			m_Sections[j].m_HistoryCalls[m_HistoryPos] += Stripe.m_CurrentCalls[j];
+		}
+		std::fill(Stripe.m_Current.begin(), Stripe.m_Current.end(), 0);
+		std::fill(Stripe.m_CurrentCalls.begin(), Stripe.m_CurrentCalls.end(), 0);
+	}
+	m_HistoryPos = (m_HistoryPos + 1) % HISTORY_SIZE;
+	m_NumTicks = std::min(m_NumTicks + 1, (int)HISTORY_SIZE);
+}
+
+
+
+
+
+void cTickProfiler::Reset(void)
+{
+	cCSLock Lock(m_CS);
+	for (cSections::iterator itr = m_Sections.begin(), end = m_Sections.end(); itr != end; ++itr)
+	{
+		std::fill(itr->m_History.begin(), itr->m_History.end(), 0);
+		std::fill(itr->m_HistoryCalls.begin(), itr->m_HistoryCalls.end(), 0);
+	}
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		cCSLock StripeLock(m_Stripes[i]->m_CS);
+		std::fill(m_Stripes[i]->m_Current.begin(), m_Stripes[i]->m_Current.end(), 0);
+		std::fill(m_Stripes[i]->m_CurrentCalls.begin(), m_Stripes[i]->m_CurrentCalls.end(), 0);
+	}
+	m_HistoryPos = 0;
+	m_NumTicks = 0;
+}
+
+
+
+
+
+void cTickProfiler::GetStats(cSectionStatsList & a_Stats)
+{
+	a_Stats.clear();
+	std::vector<Int64> Sorted;
+	cCSLock Lock(m_CS);
+	if (m_NumTicks == 0)
+	{
+		return;
+	}
+	for (cSections::const_iterator itr = m_Sections.begin(), end = m_Sections.end(); itr != end; ++itr)
+	{
+		// The history is a ring; while it isn't full, the valid items are at its beginning:
+		Sorted.assign(itr->m_History.begin(), itr->m_History.begin() + m_NumTicks);
+		Int64 NumCalls = 0;
+		for (int i = 0; i < m_NumTicks; i++)
+		{
+			NumCalls += itr->m_HistoryCalls[i];
+		}
+		if (NumCalls == 0)
+		{
+			// Not measured at all in this loop (world sections in the server's profiler etc.)
+			continue;
+		}
+		std::sort(Sorted.begin(), Sorted.end());
+		Int64 Sum = 0;
+		for (std::vector<Int64>::const_iterator itrS = Sorted.begin(), endS = Sorted.end(); itrS != endS; ++itrS)
+		{
+			Sum += *itrS;
+		}
+		sSectionStats Stats;
+		Stats.m_Name = itr->m_Name;
+		Stats.m_Average = (double)Sum / m_NumTicks;
+		Stats.m_Median = GetPercentile(Sorted, 50);
+		Stats.m_Percentile95 = GetPercentile(Sorted, 95);
+		Stats.m_Percentile99 = GetPercentile(Sorted, 99);
+		Stats.m_Max = Sorted.back();
+		Stats.m_NumCalls = (int)((NumCalls + m_NumTicks - 1) / m_NumTicks);
+		a_Stats.push_back(Stats);
+	}
+}
+
+
+
+
+
+void cTickProfiler::WriteReport(cCommandOutputCallback & a_Output)
+{
+	cSectionStatsList Stats;
+	GetStats(Stats);
+	int NumTicks;
+	{
+		cCSLock Lock(m_CS);
+		NumTicks = m_NumTicks;
+	}
+	a_Output.Out("%s, last %d ticks (times in msec):", m_Name.c_str(), NumTicks);
+	if (Stats.empty())
+	{
+		a_Output.Out("  No ticks measured yet");
+		return;
+	}
+	a_Output.Out("  %-40s %8s %8s %8s %8s %8s %6s", "Section", "avg", "median", "95%", "99%", "max", "calls");
+	for (cSectionStatsList::const_iterator itr = Stats.begin(), end = Stats.end(); itr != end; ++itr)
+	{
+		a_Output.Out("  %-40s %8.2f %8.2f %8.2f %8.2f %8.2f %6d",
+			itr->m_Name.c_str(),
+			itr->m_Average / 1000,
+			(double)itr->m_Median / 1000,
+			(double)itr->m_Percentile95 / 1000,
+			(double)itr->m_Percentile99 / 1000,
+			(double)itr->m_Max / 1000,
+			itr->m_NumCalls
+		);
+	}
+}
+
+
+
+
+
+AString cTickProfiler::GetHTMLReport(void)
+{
+	cSectionStatsList Stats;
+	GetStats(Stats);
+	AString res;
+	Printf(res, "<h4>%s</h4>", cWebAdmin::GetHTMLEscapedString(m_Name).c_str());
+	if (Stats.empty())
+	{
+		res.append("<p>No ticks measured yet</p>");
+		return res;
+	}
+	res.append("<table><tr><th>Section</th><th>avg [msec]</th><th>median</th><th>95%</th><th>99%</th><th>max</th><th>calls per tick</th></tr>");
+	for (cSectionStatsList::const_iterator itr = Stats.begin(), end = Stats.end(); itr != end; ++itr)
+	{
+		AppendPrintf(res, "<tr><td>%s</td><td>%.2f</td><td>%.2f</td><td>%.2f</td><td>%.2f</td><td>%.2f</td><td>%d</td></tr>",
+			cWebAdmin::GetHTMLEscapedString(itr->m_Name).c_str(),
+			itr->m_Average / 1000,
+			(double)itr->m_Median / 1000,
+			(double)itr->m_Percentile95 / 1000,
+			(double)itr->m_Percentile99 / 1000,
+			(double)itr->m_Max / 1000,
+			itr->m_NumCalls
+		);
+	}
+	res.append("</table>");
+	return res;
+}
+
+
+
+
+
+cTickProfiler::sStripe & cTickProfiler::GetThreadStripe(void)
+{
+	// The thread IDs may be pointers or other values with little entropy in the low bits, mix them up (Fibonacci hashing):
+	UInt64 Hash = (UInt64)cIsThread::GetCurrentID() * 0x9e3779b97f4a7c15ULL;
+	return *m_Stripes[(Hash >> 32) % NUM_STRIPES];
+}
+
+
+
+
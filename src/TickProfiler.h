@@ -0,0 +1,190 @@
+
+// TickProfiler.h
+
+// Declares the cTickProfiler class representing the per-subsystem timings of a tick loop
+
+/*
+Each tick loop (the server and each world) has its own profiler. The code being measured creates a cScope on the stack
+for the section it is running; the time between the scope's creation and destruction is added to the section's
+accumulator. At the end of each tick the owner calls EndTick(), which moves the accumulated time of each section into
+a ring of the last HISTORY_SIZE ticks. Averages and percentiles are computed from the ring only when a report is made.
+
+Sections are identified by numbers. The predefined ones (eSection) are registered in the constructor, so their IDs
+are constant; other sections (simulators, plugin hooks) are registered by name and the caller keeps the ID.
+
+AddTime() may be called from any thread. So that the threads don't fight over a single lock, the current tick's times
+are accumulated in NUM_STRIPES stripes, each with its own lock; a thread always uses the same stripe, picked by its
+thread ID, so the stripe's lock is normally uncontended. EndTick() merges the stripes.
+The chunk sections are measured on the chunk tick workers, so their times are summed over all the workers and may be
+larger than the wall-clock time of the "Chunks" section.
+*/
+
+
+
+
+
+#pragma once
+
+#include "OSSupport/Timer.h"
+
+
+
+
+
+// fwd:
+class cCommandOutputCallback;
+
+
+
+
+
+class cTickProfiler
+{
+public:
+
+	/** The predefined sections; their IDs are the same in all profilers */
+	enum eSection
+	{
+		psTick = 0,                ///< The whole tick
+		psWorldChunks,             ///< cChunkMap::Tick()
+		psWorldClients,            ///< cWorld::TickClients()
+		psWorldQueuedBlocks,       ///< cWorld::TickQueuedBlocks() and cChunkMap::FastSetQueuedBlocks()
+		psWorldTasks,              ///< Queued and scheduled tasks
+		psWorldSimulators,         ///< cSimulatorManager::Simulate()
+		psWorldWeather,            ///< cWorld::TickWeather()
+		psWorldSaveUnload,         ///< Periodic saving and unloading of chunks
+		psWorldMobs,               ///< cWorld::TickMobs()
+		psChunkSimulators,         ///< cSimulatorManager::SimulateChunk(), summed over all chunks
+		psChunkBlocks,             ///< cChunk::CheckBlocks() and cChunk::TickBlocks(), summed over all chunks
+		psChunkBlockEntities,      ///< Block entity ticks, summed over all chunks
+		psChunkEntities,           ///< Entity ticks (except mobs), summed over all chunks
+		psServerPlugins,           ///< cPluginManager::Tick()
+		psServerCommands,          ///< cRoot::TickCommands()
+		psServerClients,           ///< cServer::TickClients()
+		psNumPredefined
+	} ;
+
+	/** Measures the time from its creation to its destruction into the specified section */
+	class cScope
+	{
+	public:
+		cScope(cTickProfiler & a_Profiler, int a_SectionID) :
+			m_Profiler(a_Profiler),
+			m_SectionID(a_SectionID),
+			m_Start(a_Profiler.GetNowUsec())
+		{
+		}
+
+		~cScope()
+		{
+			m_Profiler.AddTime(m_SectionID, m_Profiler.GetNowUsec() - m_Start);
+		}
+
+	protected:
+		cTickProfiler & m_Profiler;
+		int m_SectionID;
+		Int64 m_Start;
+	} ;
+
+	/** Statistics of a single section over the last ticks, in microseconds */
+	struct sSectionStats
+	{
+		AString m_Name;
+		double  m_Average;
+		Int64   m_Median;
+		Int64   m_Percentile95;
+		Int64   m_Percentile99;
+		Int64   m_Max;
+		int     m_NumCalls;  ///< Number of measurements per tick, on average (rounded up)
+	} ;
+
+	typedef std::vector<sSectionStats> cSectionStatsList;
+
+
+	/** Number of ticks that the statistics are computed from */
+	static const int HISTORY_SIZE = 200;
+
+	/** Number of the stripes that the current tick's times are accumulated in */
+	static const int NUM_STRIPES = 16;
+
+
+	cTickProfiler(const AString & a_Name);
+
+	~cTickProfiler();
+
+	/** Returns the ID of the section with the specified name, registering the section if not present yet */
+	int RegisterSection(const AString & a_Name);
+
+	/** Adds the time spent in the section during the current tick */
+	void AddTime(int a_SectionID, Int64 a_Usec);
+
+	/** Closes the current tick: the accumulated times are moved into the history */
+	void EndTick(void);
+
+	/** Clears the history of all the sections */
+	void Reset(void);
+
+	/** Returns the statistics of all the sections that have been measured within the history */
+	void GetStats(cSectionStatsList & a_Stats);
+
+	/** Outputs the statistics as text lines */
+	void WriteReport(cCommandOutputCallback & a_Output);
+
+	/** Returns the statistics as a HTML table */
+	AString GetHTMLReport(void);
+
+	const AString & GetName(void) const { return m_Name; }
+
+	/** Returns the current time used for the measurements */
+	Int64 GetNowUsec(void) { return m_Timer.GetNowTimeUsec(); }
+
+protected:
+
+	struct sSection
+	{
+		AString m_Name;
+
+		/** The time spent in each of the last HISTORY_SIZE ticks; indexed the same way as m_History of all sections */
+		std::vector<Int64> m_History;
+
+		/** The number of measurements within the history */
+		std::vector<int> m_HistoryCalls;
+	} ;
+
+	typedef std::vector<sSection> cSections;
+
+	/** The times accumulated in the current tick by the threads using this stripe; indexed by section ID */
+	struct sStripe
+	{
+		cCriticalSection m_CS;
+		std::vector<Int64> m_Current;
+		std::vector<int> m_CurrentCalls;
+	} ;
+
+
+	AString m_Name;
+
+	cTimer m_Timer;
+
+	/** Protects m_Sections, m_HistoryPos and m_NumTicks */
+	cCriticalSection m_CS;
+
+	cSections m_Sections;
+
+	/** The accumulators of the current tick; each has its own lock. Allocated separately so that they don't share cache lines. */
+	sStripe * m_Stripes[NUM_STRIPES];
+
+	/** Index into each section's m_History where the next tick will be stored */
+	int m_HistoryPos;
+
+	/** Number of valid items in the history (up to HISTORY_SIZE) */
+	int m_NumTicks;
+
+
+	/** Returns the stripe to be used by the calling thread */
+	sStripe & GetThreadStripe(void);
+} ;
+
+
+
+
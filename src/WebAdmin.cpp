@@ -261,6 +261,7 @@ void cWebAdmin::HandleWebadminRequest(cHTTPConnection & a_Connection, cHTTPReque
 	Template = "{CONTENT}";
 	AString FoundPlugin;
 
+	Menu += "<li><a href='" + BaseURL + "tickprofile'>Tick profile</a></li>";
 	for (PluginList::iterator itr = m_Plugins.begin(); itr != m_Plugins.end(); ++itr)
 	{
 		cWebPlugin * WebPlugin = *itr;
@@ -346,6 +347,15 @@ sWebAdminPage cWebAdmin::GetPage(const HTTPRequest & a_Request)
 	sWebAdminPage Page;
 	AStringVector Split = StringSplit(a_Request.Path, "/");
 
+	// The built-in pages:
+	if ((Split.size() > 1) && (Split[1] == "tickprofile"))
+	{
+		Page.Content = cRoot::Get()->GetTickProfileHTML();
+		Page.PluginName = "Server";
+		Page.TabName = "Tick profile";
+		return Page;
+	}
+
 	// Find the plugin that corresponds to the requested path
 	AString FoundPlugin;
 	if (Split.size() > 1)
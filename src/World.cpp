@@ -34,6 +34,7 @@
 #include "Simulator/NoopRedstoneSimulator.h"
 #include "Simulator/SandSimulator.h"
 #include "Simulator/IncrementalRedstoneSimulator.h"
+#include "Simulator/EventRedstoneSimulator.h"
 #include "Simulator/VanillaFluidSimulator.h"
 #include "Simulator/VaporizeFluidSimulator.h"
 
@@ -46,6 +47,8 @@
 #include "Generating/Trees.h"
 #include "Bindings/PluginManager.h"
 #include "Blocks/BlockHandler.h"
+#include "Protocol/PacketBroadcaster.h"
+#include "Protocol/EntityPackets.h"
 
 #include "Tracer.h"
 
@@ -209,7 +212,11 @@ void cWorld::cTickThread::Execute(void)
 	{
 		Int64 NowTime = Timer.GetNowTime();
 		float DeltaTime = (float)(NowTime - LastTime);
-		m_World.Tick(DeltaTime, (int)TickDuration);
+		{
+			cTickProfiler::cScope Scope(m_World.GetTickProfiler(), cTickProfiler::psTick);
+			m_World.Tick(DeltaTime, (int)TickDuration);
+		}
+		m_World.GetTickProfiler().EndTick();
 		TickDuration = Timer.GetNowTime() - NowTime;
 		
 		if (TickDuration < msPerTick)
@@ -238,6 +245,7 @@ cWorld::cWorld(const AString & a_WorldName) :
 #else
 	m_StorageCompressionFactor(6),
 #endif
+	m_StorageNumThreads(2),
 	m_IsSpawnExplicitlySet(false),
 	m_WorldAgeSecs(0),
 	m_TimeOfDaySecs(0),
@@ -250,6 +258,7 @@ cWorld::cWorld(const AString & a_WorldName) :
 	m_Scoreboard(this),
 	m_MapManager(this),
 	m_GeneratorCallbacks(*this),
+	m_TickProfiler("World " + a_WorldName),
 	m_TickThread(*this)
 {
 	LOGD("cWorld::cWorld(\"%s\")", a_WorldName.c_str());
@@ -273,6 +282,7 @@ cWorld::~cWorld()
 	delete m_LavaSimulator;
 	delete m_FireSimulator;
 	delete m_RedstoneSimulator;
+	m_RedstoneSimulator = NULL;  // The chunks being unloaded below check for it
 
 	UnloadUnusedChunks();
 	
@@ -559,6 +569,7 @@ void cWorld::Start(void)
 
 	m_StorageSchema               = IniFile.GetValueSet ("Storage",       "Schema",                      m_StorageSchema);
 	m_StorageCompressionFactor    = IniFile.GetValueSetI("Storage",       "CompressionFactor",           m_StorageCompressionFactor);
+	m_StorageNumThreads           = IniFile.GetValueSetI("Storage",       "NumThreads",                  m_StorageNumThreads);
 	m_MaxCactusHeight             = IniFile.GetValueSetI("Plants",        "MaxCactusHeight",             3);
 	m_MaxSugarcaneHeight          = IniFile.GetValueSetI("Plants",        "MaxSugarcaneHeight",          3);
 	m_IsCactusBonemealable        = IniFile.GetValueSetB("Plants",        "IsCactusBonemealable",        false);
@@ -618,6 +629,14 @@ void cWorld::Start(void)
 
 	m_ChunkMap = new cChunkMap(this);
 	
+	// Ticking independent groups of regions in parallel is opt-in, 0 threads means ticking everything in the tick thread:
+	int NumTickThreads = IniFile.GetValueSetI("General", "ParallelTickThreads", 0);
+	if (NumTickThreads > 0)
+	{
+		LOGD("World \"%s\": Ticking regions in parallel using %d threads", m_WorldName.c_str(), NumTickThreads);
+		m_ChunkMap->SetNumTickThreads(NumTickThreads);
+	}
+	
 	m_LastSave = 0;
 	m_LastUnload = 0;
 
@@ -634,11 +653,11 @@ void cWorld::Start(void)
 	m_RedstoneSimulator = InitializeRedstoneSimulator(IniFile);
 
 	// Water, Lava and Redstone simulators get registered in their initialize function.
-	m_SimulatorManager->RegisterSimulator(m_SandSimulator, 1);
-	m_SimulatorManager->RegisterSimulator(m_FireSimulator, 1);
+	m_SimulatorManager->RegisterSimulator(m_SandSimulator, 1, "Sand");
+	m_SimulatorManager->RegisterSimulator(m_FireSimulator, 1, "Fire");
 
-	m_Lighting.Start(this);
-	m_Storage.Start(this, m_StorageSchema, m_StorageCompressionFactor );
+	m_Lighting.Start(this, cRoot::Get()->GetNumLightingThreads());
+	m_Storage.Start(this, m_StorageSchema, m_StorageCompressionFactor, m_StorageNumThreads);
 	m_Generator.Start(m_GeneratorCallbacks, m_GeneratorCallbacks, IniFile);
 	m_ChunkSender.Start(this);
 	m_TickThread.Start();
@@ -739,30 +758,57 @@ void cWorld::Tick(float a_Dt, int a_LastTickDurationMSec)
 		m_LastTimeUpdate = m_WorldAge;
 	}
 
-	m_ChunkMap->Tick(a_Dt);
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldChunks);
+		m_ChunkMap->Tick(a_Dt);
+	}
 
-	TickClients(a_Dt);
-	TickQueuedBlocks();
-	TickQueuedTasks();
-	TickScheduledTasks();
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldClients);
+		TickClients(a_Dt);
+	}
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldQueuedBlocks);
+		TickQueuedBlocks();
+	}
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldTasks);
+		TickQueuedTasks();
+		TickScheduledTasks();
+	}
 	
-	GetSimulatorManager()->Simulate(a_Dt);
-
-	TickWeather(a_Dt);
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldSimulators);
+		GetSimulatorManager()->Simulate(a_Dt);
+	}
 
-	m_ChunkMap->FastSetQueuedBlocks();
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldWeather);
+		TickWeather(a_Dt);
+	}
 
-	if (m_WorldAge - m_LastSave > 60 * 5 * 20) // Save each 5 minutes
 	{
-		SaveAllChunks();
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldQueuedBlocks);
+		m_ChunkMap->FastSetQueuedBlocks();
 	}
 
-	if (m_WorldAge - m_LastUnload > 10 * 20) // Unload every 10 seconds
 	{
-		UnloadUnusedChunks();
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldSaveUnload);
+		if (m_WorldAge - m_LastSave > 60 * 5 * 20) // Save each 5 minutes
+		{
+			SaveAllChunks();
+		}
+
+		if (m_WorldAge - m_LastUnload > 10 * 20) // Unload every 10 seconds
+		{
+			UnloadUnusedChunks();
+		}
 	}
 
-	TickMobs(a_Dt);
+	{
+		cTickProfiler::cScope Scope(m_TickProfiler, cTickProfiler::psWorldMobs);
+		TickMobs(a_Dt);
+	}
 }
 
 
@@ -830,9 +876,8 @@ void cWorld::TickMobs(float a_Dt)
 	// _X 2013_10_22: This is a quick fix for #283 - the world needs to be locked while ticking mobs
 	cWorld::cLock Lock(*this);
 
-	// before every Mob action, we have to count them depending on the distance to players, on their family ...
-	cMobCensus MobCensus;
-	m_ChunkMap->CollectMobCensus(MobCensus);
+	// The census is kept up to date by the chunks as the mobs and players move around:
+	cMobCensus & MobCensus = m_ChunkMap->GetMobCensus();
 	if (m_bAnimals)
 	{
 		// Spawning is enabled, spawn now:
@@ -868,18 +913,29 @@ void cWorld::TickMobs(float a_Dt)
 		} // for i - AllFamilies[]
 	} // if (Spawning enabled)
 
-	// move close mobs
-	cMobProximityCounter::sIterablePair allCloseEnoughToMoveMobs = MobCensus.GetProximityCounter().getMobWithinThosesDistances(-1, 64 * 16);// MG TODO : deal with this magic number (the 16 is the size of a block)
-	for(cMobProximityCounter::tDistanceToMonster::const_iterator itr = allCloseEnoughToMoveMobs.m_Begin; itr != allCloseEnoughToMoveMobs.m_End; itr++)
-	{
-		itr->second.m_Monster.Tick(a_Dt, itr->second.m_Chunk);
-	}
-
-	// remove too far mobs
-	cMobProximityCounter::sIterablePair allTooFarMobs = MobCensus.GetProximityCounter().getMobWithinThosesDistances(128 * 16, -1);// MG TODO : deal with this magic number (the 16 is the size of a block)
-	for(cMobProximityCounter::tDistanceToMonster::const_iterator itr = allTooFarMobs.m_Begin; itr != allTooFarMobs.m_End; itr++)
+	// Tick the mobs close enough to a player, remove those too far away:
+	const cMobCensus::cMobChunkVector & Mobs = MobCensus.GetCountedMobs();
+	for (cMobCensus::cMobChunkVector::const_iterator itr = Mobs.begin(), end = Mobs.end(); itr != end; ++itr)
 	{
-		itr->second.m_Monster.Destroy(true);
+		// Another mob's tick may have moved this one out of the world or into another chunk:
+		cChunk * Chunk = MobCensus.GetCountedMobChunk(itr->m_Monster);
+		if ((Chunk == NULL) || itr->m_Monster->IsDestroyed())
+		{
+			continue;
+		}
+		double SqrDist = Chunk->GetSqrDistanceToClosestPlayer(itr->m_Monster->GetPosition());
+		if (SqrDist < 0)
+		{
+			continue;
+		}
+		if (SqrDist <= (64 * 16) * (64 * 16))  // MG TODO : deal with this magic number (the 16 is the size of a block)
+		{
+			itr->m_Monster->Tick(a_Dt, *Chunk);
+		}
+		else if (SqrDist > (128 * 16) * (128 * 16))  // MG TODO : deal with this magic number (the 16 is the size of a block)
+		{
+			itr->m_Monster->Destroy(true);
+		}
 	}
 }
 
@@ -2103,6 +2159,8 @@ void cWorld::BroadcastSpawnEntity(cEntity & a_Entity, const cClientHandle * a_Ex
 
 void cWorld::BroadcastTeleportEntity(const cEntity & a_Entity, const cClientHandle * a_Exclude)
 {
+	cEntityTeleportPacket Packet(a_Entity);
+	cPacketBroadcaster Broadcaster(Packet);
 	cCSLock Lock(m_CSPlayers);
 	for (cPlayerList::iterator itr = m_Players.begin(); itr != m_Players.end(); ++itr)
 	{
@@ -2111,7 +2169,11 @@ void cWorld::BroadcastTeleportEntity(const cEntity & a_Entity, const cClientHand
 		{
 			continue;
 		}
-		ch->SendTeleportEntity(a_Entity);
+		cInterestManager & Interest = ch->GetInterestManager();
+		if (Interest.ShouldSendNow(a_Entity, cInterestManager::ufTeleport, 0, 0, 0))
+		{
+			Interest.AddSentBytes(Broadcaster.SendTo(*ch));
+		}
 	}
 }
 
@@ -2521,6 +2583,25 @@ bool cWorld::ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback &
 
 
 
+
+bool cWorld::ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback)
+{
+	return m_ChunkMap->ForEachEntityInBox(a_Box, a_Callback);
+}
+
+
+
+
+
+bool cWorld::ForEachEntityInRadius(const Vector3d & a_Center, double a_Radius, cEntityCallback & a_Callback)
+{
+	return m_ChunkMap->ForEachEntityInRadius(a_Center, a_Radius, a_Callback);
+}
+
+
+
+
+
 bool cWorld::DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback)
 {
 	return m_ChunkMap->DoWithEntityByID(a_UniqueID, a_Callback);
@@ -2530,6 +2611,15 @@ bool cWorld::DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback)
 
 
 
+bool cWorld::DoWithEntityByIDInChunk(int a_ChunkX, int a_ChunkZ, int a_UniqueID, cEntityCallback & a_Callback)
+{
+	return m_ChunkMap->DoWithEntityByIDInChunk(a_ChunkX, a_ChunkZ, a_UniqueID, a_Callback);
+}
+
+
+
+
+
 void cWorld::CompareChunkClients(int a_ChunkX1, int a_ChunkZ1, int a_ChunkX2, int a_ChunkZ2, cClientDiffCallback & a_Callback)
 {
 	m_ChunkMap->CompareChunkClients(a_ChunkX1, a_ChunkZ1, a_ChunkX2, a_ChunkZ2, a_Callback);
@@ -2871,9 +2961,9 @@ int cWorld::GetNumChunks(void) const
 
 
 
-void cWorld::GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue)
+void cWorld::GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue, int & a_NumSections)
 {
-	m_ChunkMap->GetChunkStats(a_NumValid, a_NumDirty);
+	m_ChunkMap->GetChunkStats(a_NumValid, a_NumDirty, a_NumSections);
 	a_NumInLightingQueue = (int) m_Lighting.GetQueueLength();
 }
 
@@ -3000,6 +3090,20 @@ int cWorld::CreateProjectile(double a_PosX, double a_PosY, double a_PosZ, cProje
 
 
 
+int cWorld::GetTickRandomNumber(unsigned a_Range)
+{
+	MTRand * WorkerRand = m_ChunkMap->GetTickWorkerRand();
+	if (WorkerRand != NULL)
+	{
+		return (int)(WorkerRand->randInt(a_Range));
+	}
+	return (int)(m_TickRand.randInt(a_Range));
+}
+
+
+
+
+
 void cWorld::TabCompleteUserName(const AString & a_Text, AStringVector & a_Results)
 {
 	cCSLock Lock(m_CSPlayers);
@@ -3040,12 +3144,21 @@ cRedstoneSimulator * cWorld::InitializeRedstoneSimulator(cIniFile & a_IniFile)
 	{
 		res = new cIncrementalRedstoneSimulator(*this);
 	}
+	else if (NoCaseCompare(SimulatorName, "event") == 0)
+	{
+		res = new cEventRedstoneSimulator(*this);
+	}
 	else if (NoCaseCompare(SimulatorName, "noop") == 0)
 	{
 		res = new cRedstoneNoopSimulator(*this);
 	}
+	else
+	{
+		LOGWARNING("[Physics] RedstoneSimulator \"%s\" in %s is not known, using the default of \"incremental\".", SimulatorName.c_str(), GetIniFileName().c_str());
+		res = new cIncrementalRedstoneSimulator(*this);
+	}
 	
-	m_SimulatorManager->RegisterSimulator(res, 1);
+	m_SimulatorManager->RegisterSimulator(res, 1, "Redstone");
 	
 	return res;
 }
@@ -3108,7 +3221,7 @@ cFluidSimulator * cWorld::InitializeFluidSimulator(cIniFile & a_IniFile, const c
 		}
 	}
 	
-	m_SimulatorManager->RegisterSimulator(res, Rate);
+	m_SimulatorManager->RegisterSimulator(res, Rate, a_FluidName);
 
 	return res;
 }
@@ -3194,6 +3307,29 @@ bool cWorld::cChunkGeneratorCallbacks::HasChunkAnyClients(int a_ChunkX, int a_Ch
 
 
 
+void cWorld::cChunkGeneratorCallbacks::GetPlayerChunks(cChunkCoordsVector & a_Coords)
+{
+	class cCollector :
+		public cPlayerListCallback
+	{
+		virtual bool Item(cPlayer * a_Player) override
+		{
+			m_Coords.push_back(cChunkCoords(a_Player->GetChunkX(), ZERO_CHUNK_Y, a_Player->GetChunkZ()));
+			return false;
+		}
+		
+	public:
+		cChunkCoordsVector & m_Coords;
+		
+		cCollector(cChunkCoordsVector & a_Coords) : m_Coords(a_Coords) {}
+	} Collector(a_Coords);
+	m_World->ForEachPlayer(Collector);
+}
+
+
+
+
+
 void cWorld::cChunkGeneratorCallbacks::CallHookChunkGenerating(cChunkDesc & a_ChunkDesc)
 {
 	cPluginManager::Get()->CallHookChunkGenerating(
@@ -18,6 +18,8 @@
 #include "ChunkSender.h"
 #include "Defines.h"
 #include "LightingThread.h"
+#include "Protocol/ChunkPacketCache.h"
+#include "TickProfiler.h"
 #include "Item.h"
 #include "Mobs/Monster.h"
 #include "Entities/ProjectileEntity.h"
@@ -50,6 +52,7 @@ class cMobHeadEntity;
 class cMobCensus;
 class cCompositeChat;
 class cCuboid;
+class cBoundingBox;
 
 typedef std::list< cPlayer * > cPlayerList;
 
@@ -300,10 +303,19 @@ public:
 	
 	/** Calls the callback for each entity in the specified chunk; returns true if all entities processed, false if the callback aborted by returning true */
 	bool ForEachEntityInChunk(int a_ChunkX, int a_ChunkZ, cEntityCallback & a_Callback);  // Exported in ManualBindings.cpp
+	
+	/** Calls the callback for each entity whose position is inside the specified box; returns true if all entities processed, false if the callback aborted by returning true */
+	bool ForEachEntityInBox(const cBoundingBox & a_Box, cEntityCallback & a_Callback);  // Exported in ManualBindings.cpp
+	
+	/** Calls the callback for each entity whose position is closer than a_Radius to a_Center; returns true if all entities processed, false if the callback aborted by returning true */
+	bool ForEachEntityInRadius(const Vector3d & a_Center, double a_Radius, cEntityCallback & a_Callback);  // Exported in ManualBindings.cpp
 
 	/** Calls the callback if the entity with the specified ID is found, with the entity object as the callback param. Returns true if entity found and callback returned false. */
 	bool DoWithEntityByID(int a_UniqueID, cEntityCallback & a_Callback);  // Exported in ManualBindings.cpp
 
+	/** Same as DoWithEntityByID(), but only searches the specified chunk; much faster when the entity's chunk is known */
+	bool DoWithEntityByIDInChunk(int a_ChunkX, int a_ChunkZ, int a_UniqueID, cEntityCallback & a_Callback);
+
 	/** Compares clients of two chunks, calls the callback accordingly */
 	void CompareChunkClients(int a_ChunkX1, int a_ChunkZ1, int a_ChunkX2, int a_ChunkZ2, cClientDiffCallback & a_Callback);
 	
@@ -464,7 +476,7 @@ public:
 	double GetSpawnZ(void) const { return m_SpawnZ; }
 
 	/** Wakes up the simulators for the specified block */
-	void WakeUpSimulators(int a_BlockX, int a_BlockY, int a_BlockZ);
+	virtual void WakeUpSimulators(int a_BlockX, int a_BlockY, int a_BlockZ) override;
 	
 	/** Wakes up the simulators for the specified area of blocks */
 	void WakeUpSimulatorsInArea(int a_MinBlockX, int a_MaxBlockX, int a_MinBlockY, int a_MaxBlockY, int a_MinBlockZ, int a_MaxBlockZ);
@@ -641,12 +653,15 @@ public:
 	/** Returns the number of chunks loaded	 */
 	int GetNumChunks() const;  // tolua_export
 
-	/** Returns the number of chunks loaded and dirty, and in the lighting queue */
-	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue);
+	/** Returns the number of chunks loaded and dirty, and in the lighting queue, and the number of block data sections allocated */
+	void GetChunkStats(int & a_NumValid, int & a_NumDirty, int & a_NumInLightingQueue, int & a_NumSections);
 
 	// Various queues length queries (cannot be const, they lock their CS):
 	inline int GetGeneratorQueueLength  (void) { return m_Generator.GetQueueLength();   }    // tolua_export
 	inline size_t GetLightingQueueLength   (void) { return m_Lighting.GetQueueLength();    }    // tolua_export
+	
+	/** Returns the number of chunks waiting for neighbors, queued and being lighted, and the number of lighting threads */
+	void GetLightingStats(int & a_NumPending, int & a_NumQueued, int & a_NumInProgress, int & a_NumThreads) { m_Lighting.GetStats(a_NumPending, a_NumQueued, a_NumInProgress, a_NumThreads); }
 	inline size_t GetStorageLoadQueueLength(void) { return m_Storage.GetLoadQueueLength(); }    // tolua_export
 	inline size_t GetStorageSaveQueueLength(void) { return m_Storage.GetSaveQueueLength(); }    // tolua_export
 
@@ -697,6 +712,12 @@ public:
 	cChunkGenerator & GetGenerator(void) { return m_Generator; }
 	cWorldStorage &   GetStorage  (void) { return m_Storage; }
 	cChunkMap *       GetChunkMap (void) { return m_ChunkMap; }
+	
+	/** Returns the cache of serialized chunk data, shared by all the clients in this world */
+	cChunkPacketCache & GetChunkPacketCache(void) { return m_ChunkPacketCache; }
+	
+	/** Returns the timings of this world's tick */
+	cTickProfiler & GetTickProfiler(void) { return m_TickProfiler; }
 		
 	/** Sets the blockticking to start at the specified block. Only one blocktick per chunk may be set, second call overwrites the first call */
 	void SetNextBlockTick(int a_BlockX, int a_BlockY, int a_BlockZ);  // tolua_export
@@ -713,8 +734,9 @@ public:
 	/** Creates a projectile of the specified type. Returns the projectile's EntityID if successful, <0 otherwise */
 	int CreateProjectile(double a_PosX, double a_PosY, double a_PosZ, cProjectileEntity::eKind a_Kind, cEntity * a_Creator, const cItem a_Item, const Vector3d * a_Speed = NULL);  // tolua_export
 	
-	/** Returns a random number from the m_TickRand in range [0 .. a_Range]. To be used only in the tick thread! */
-	int GetTickRandomNumber(unsigned a_Range) { return (int)(m_TickRand.randInt(a_Range)); }
+	/** Returns a random number from the m_TickRand in range [0 .. a_Range]. To be used only in the tick thread!
+	When called from a parallel tick worker, the worker's own random generator is used instead. */
+	int GetTickRandomNumber(unsigned a_Range);
 	
 	/** Appends all usernames starting with a_Text (case-insensitive) into Results */
 	void TabCompleteUserName(const AString & a_Text, AStringVector & a_Results);
@@ -752,6 +774,7 @@ private:
 		virtual void OnChunkGenerated  (cChunkDesc & a_ChunkDesc) override;
 		virtual bool IsChunkValid      (int a_ChunkX, int a_ChunkZ) override;
 		virtual bool HasChunkAnyClients(int a_ChunkX, int a_ChunkZ) override;
+		virtual void GetPlayerChunks   (cChunkCoordsVector & a_Coords) override;
 		
 		// cPluginInterface overrides:
 		virtual void CallHookChunkGenerating(cChunkDesc & a_ChunkDesc) override;
@@ -793,6 +816,9 @@ private:
 	
 	int m_StorageCompressionFactor;
 	
+	/** Number of the threads used for loading and saving the chunks */
+	int m_StorageNumThreads;
+	
 	/** The dimension of the world, used by the client to provide correct lighting scheme */
 	eDimension m_Dimension;
 	
@@ -882,6 +908,13 @@ private:
 	
 	cChunkSender     m_ChunkSender;
 	cLightingThread  m_Lighting;
+	
+	/** Serialized chunk data, shared by all the clients to avoid compressing the same chunk for each of them */
+	cChunkPacketCache m_ChunkPacketCache;
+	
+	/** The timings of the tick phases, for the "tickprofile" console command and the webadmin */
+	cTickProfiler    m_TickProfiler;
+	
 	cTickThread      m_TickThread;
 	
 	/** Guards the m_Tasks */
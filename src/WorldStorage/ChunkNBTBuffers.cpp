@@ -0,0 +1,119 @@
+// ChunkNBTBuffers.cpp
+
+// Implements the cChunkNBTBuffers class holding the reusable buffers for (de)compressing and (de)serializing chunk NBT data
+
+#include "Globals.h"
+#include "ChunkNBTBuffers.h"
+
+
+
+
+
+/// The maximum size of an inflated chunk; raw chunk data is 192 KiB, allow 64 KiB more of entities
+#define CHUNK_INFLATE_MAX 256 KiB
+
+
+
+
+
+cChunkNBTBuffers::cChunkNBTBuffers(int a_CompressionFactor)
+{
+	memset(&m_Inflate, 0, sizeof(m_Inflate));
+	memset(&m_Deflate, 0, sizeof(m_Deflate));
+	m_IsInflateValid = (inflateInit(&m_Inflate) == Z_OK);
+	m_IsDeflateValid = (deflateInit(&m_Deflate, a_CompressionFactor) == Z_OK);
+	m_Uncompressed.resize(CHUNK_INFLATE_MAX);
+}
+
+
+
+
+
+cChunkNBTBuffers::~cChunkNBTBuffers()
+{
+	if (m_IsInflateValid)
+	{
+		inflateEnd(&m_Inflate);
+	}
+	if (m_IsDeflateValid)
+	{
+		deflateEnd(&m_Deflate);
+	}
+}
+
+
+
+
+
+const cParsedNBT * cChunkNBTBuffers::ParseCompressed(void)
+{
+	if (!m_IsInflateValid || (inflateReset(&m_Inflate) != Z_OK))
+	{
+		return NULL;
+	}
+	
+	// HACK: We're assuming that AString returns its internal buffer in its data() call and we're overwriting that buffer!
+	// m_Uncompressed is never resized after construction, so no allocations happen here
+	m_Inflate.next_in   = (Bytef *)m_CompressedIn.data();
+	m_Inflate.avail_in  = (uInt)m_CompressedIn.size();
+	m_Inflate.next_out  = (Bytef *)m_Uncompressed.data();
+	m_Inflate.avail_out = (uInt)m_Uncompressed.size();
+	if (inflate(&m_Inflate, Z_FINISH) != Z_STREAM_END)
+	{
+		return NULL;
+	}
+	
+	if (!m_NBT.Reset(m_Uncompressed.data(), (int)m_Inflate.total_out))
+	{
+		return NULL;
+	}
+	return &m_NBT;
+}
+
+
+
+
+
+cFastNBTWriter & cChunkNBTBuffers::StartWriting(void)
+{
+	m_Writer.Reset();
+	return m_Writer;
+}
+
+
+
+
+
+const AString * cChunkNBTBuffers::FinishWriting(void)
+{
+	m_Writer.Finish();
+	if (!m_IsDeflateValid || (deflateReset(&m_Deflate) != Z_OK))
+	{
+		return NULL;
+	}
+	
+	const AString & Data = m_Writer.GetResult();
+	uLong Bound = deflateBound(&m_Deflate, (uLong)Data.size());
+	if (m_CompressedOut.size() < Bound)
+	{
+		m_CompressedOut.resize(Bound);
+	}
+	
+	// HACK: We're assuming that AString returns its internal buffer in its data() call and we're overwriting that buffer!
+	m_Deflate.next_in   = (Bytef *)Data.data();
+	m_Deflate.avail_in  = (uInt)Data.size();
+	m_Deflate.next_out  = (Bytef *)m_CompressedOut.data();
+	m_Deflate.avail_out = (uInt)m_CompressedOut.size();
+	if (deflate(&m_Deflate, Z_FINISH) != Z_STREAM_END)
+	{
+		return NULL;
+	}
+	
+	// Shrinking keeps the capacity, so the next resize up to Bound doesn't reallocate:
+	m_CompressedOut.resize(m_Deflate.total_out);
+	return &m_CompressedOut;
+}
+
+
+
+
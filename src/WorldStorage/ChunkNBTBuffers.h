@@ -0,0 +1,73 @@
+// ChunkNBTBuffers.h
+
+// Declares the cChunkNBTBuffers class holding the reusable buffers for (de)compressing and (de)serializing chunk NBT data
+
+/*
+Loading a chunk means decompressing its data and parsing the result as NBT; saving a chunk means writing the NBT
+and compressing it. Doing that with fresh buffers and zlib streams for each chunk costs several large allocations
+per chunk. This class keeps all the buffers and both zlib streams alive between the chunks, so that in the steady
+state no memory is allocated at all.
+An instance may be used by only one thread at a time; cWSSAnvil keeps a pool of them for its storage workers.
+*/
+
+
+
+
+
+#pragma once
+
+#include "FastNBT.h"
+#include "zlib/zlib.h"
+
+
+
+
+
+class cChunkNBTBuffers
+{
+public:
+
+	cChunkNBTBuffers(int a_CompressionFactor);
+	~cChunkNBTBuffers();
+	
+	/** The buffer for the compressed data being loaded; fill it and then call ParseCompressed() */
+	AString & GetCompressedIn(void) { return m_CompressedIn; }
+	
+	/** Decompresses the data in GetCompressedIn() and parses it as NBT.
+	Returns the parsed NBT, valid until the next call on this object, or NULL on failure. */
+	const cParsedNBT * ParseCompressed(void);
+	
+	/** Returns the NBT writer, reset for writing a new NBT */
+	cFastNBTWriter & StartWriting(void);
+	
+	/** Finishes the NBT in the writer returned by StartWriting() and compresses it.
+	Returns the compressed data, valid until the next call on this object, or NULL on failure. */
+	const AString * FinishWriting(void);
+	
+protected:
+
+	/** The compressed data being loaded */
+	AString m_CompressedIn;
+	
+	/** The decompressed data being parsed */
+	AString m_Uncompressed;
+	
+	/** The parsed NBT, referencing m_Uncompressed */
+	cParsedNBT m_NBT;
+	
+	/** The NBT being saved */
+	cFastNBTWriter m_Writer;
+	
+	/** The compressed data being saved */
+	AString m_CompressedOut;
+	
+	/** The zlib streams, reset between the chunks instead of re-initializing */
+	z_stream m_Inflate;
+	z_stream m_Deflate;
+	bool m_IsInflateValid;
+	bool m_IsDeflateValid;
+} ;
+
+
+
+
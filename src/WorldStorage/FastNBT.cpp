@@ -50,6 +50,32 @@ cParsedNBT::cParsedNBT(const char * a_Data, int a_Length) :
 
 
 
+cParsedNBT::cParsedNBT(void) :
+	m_Data(NULL),
+	m_Length(0),
+	m_IsValid(false),
+	m_Pos(0)
+{
+}
+
+
+
+
+
+bool cParsedNBT::Reset(const char * a_Data, int a_Length)
+{
+	m_Data = a_Data;
+	m_Length = a_Length;
+	m_Pos = 0;
+	m_Tags.clear();  // Keeps the capacity
+	m_IsValid = Parse();
+	return m_IsValid;
+}
+
+
+
+
+
 bool cParsedNBT::Parse(void)
 {
 	if (m_Length < 3)
@@ -333,8 +359,19 @@ int cParsedNBT::FindTagByPath(int a_Tag, const AString & a_Path) const
 cFastNBTWriter::cFastNBTWriter(const AString & a_RootTagName) :
 	m_CurrentStack(0)
 {
-	m_Stack[0].m_Type = TAG_Compound;
 	m_Result.reserve(100 * 1024);
+	Reset(a_RootTagName);
+}
+
+
+
+
+
+void cFastNBTWriter::Reset(const AString & a_RootTagName)
+{
+	m_CurrentStack = 0;
+	m_Stack[0].m_Type = TAG_Compound;
+	m_Result.clear();  // Keeps the capacity
 	m_Result.push_back(TAG_Compound);
 	WriteString(a_RootTagName.data(), a_RootTagName.size());
 }
@@ -11,6 +11,9 @@ The structures have a minimal constructor, setting all member "pointers" to "inv
 The fast writer doesn't need a NBT tree structure built beforehand, it is commanded to open, append and close tags
 (just like XML); it keeps the internal tag stack and reports errors in usage. 
 It directly outputs a string containing the serialized NBT data.
+
+Both the parser and the writer can be reused for multiple NBTs (cParsedNBT::Reset(), cFastNBTWriter::Reset()),
+keeping their memory allocated, so that loading and saving many chunks doesn't allocate anew for each chunk.
 */
 
 
@@ -116,6 +119,13 @@ class cParsedNBT
 public:
 	cParsedNBT(const char * a_Data, int a_Length);
 	
+	/** Creates an empty (invalid) object, to be filled using Reset() */
+	cParsedNBT(void);
+	
+	/** Parses new data, replacing the previous contents. Reuses the memory allocated for the tags by the previous parsing.
+	Returns true if successful (same as IsValid() afterwards). */
+	bool Reset(const char * a_Data, int a_Length);
+	
 	bool IsValid(void) const {return m_IsValid; }
 	
 	/** Returns the root tag of the hierarchy. */
@@ -274,6 +284,9 @@ class cFastNBTWriter
 public:
 	cFastNBTWriter(const AString & a_RootTagName = "");
 	
+	/** Discards the current contents and starts a new NBT, as if newly constructed; keeps the memory allocated for the result */
+	void Reset(const AString & a_RootTagName = "");
+	
 	void BeginCompound(const AString & a_Name);
 	void EndCompound(void);
 	
@@ -73,11 +73,11 @@ void cNBTChunkSerializer::Finish(void)
 		m_Writer.EndList();
 	}
 	
-	// If light not valid, reset it to all zeroes:
+	// If light not valid, reset it to the defaults, it will get recalculated after loading anyway:
 	if (!m_IsLightValid)
 	{
-		memset(m_BlockLight,    0, sizeof(m_BlockLight));
-		memset(m_BlockSkyLight, 0, sizeof(m_BlockSkyLight));
+		m_Data.SetBlockLight(NULL);
+		m_Data.SetSkyLight(NULL);
 	}
 }
 
@@ -702,6 +702,15 @@ bool cNBTChunkSerializer::LightIsValid(bool a_IsLightValid)
 
 
 
+void cNBTChunkSerializer::ChunkData(const cChunkData & a_ChunkData)
+{
+	m_Data = a_ChunkData;
+}
+
+
+
+
+
 void cNBTChunkSerializer::BiomeData(const cChunkDef::BiomeMap * a_BiomeMap)
 {
 	memcpy(m_Biomes, a_BiomeMap, sizeof(m_Biomes));
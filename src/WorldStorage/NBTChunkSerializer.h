@@ -10,6 +10,7 @@
 #pragma once
 
 #include "../ChunkDef.h"
+#include "../ChunkData.h"
 
 
 
@@ -52,9 +53,10 @@ class cItemFrame;
 
 
 class cNBTChunkSerializer :
-	public cChunkDataSeparateCollector
+	public cChunkDataCallback
 {
 public:
+	cChunkData m_Data;  // Copy of the chunk's block data; only the non-empty sections are present
 	cChunkDef::BiomeMap m_Biomes;
 	unsigned char m_VanillaBiomes[cChunkDef::Width * cChunkDef::Width];
 	bool m_BiomesAreValid;
@@ -69,13 +71,6 @@ public:
 
 protected:
 	
-	/* From cChunkDataSeparateCollector we inherit:
-	- m_BlockTypes[]
-	- m_BlockMetas[]
-	- m_BlockLight[]
-	- m_BlockSkyLight[]
-	*/
-	
 	cFastNBTWriter & m_Writer;
 	
 	bool m_IsTagOpen;  // True if a tag has been opened in the callbacks and not yet closed.
@@ -120,8 +115,9 @@ protected:
 	
 	void AddMinecartChestContents(cMinecartWithChest * a_Minecart);
 	
-	// cChunkDataSeparateCollector overrides:
+	// cChunkDataCallback overrides:
 	virtual bool LightIsValid(bool a_IsLightValid) override;
+	virtual void ChunkData(const cChunkData & a_ChunkData) override;
 	virtual void BiomeData(const cChunkDef::BiomeMap * a_BiomeMap) override;
 	virtual void Entity(cEntity * a_Entity) override;
 	virtual void BlockEntity(cBlockEntity * a_Entity) override;
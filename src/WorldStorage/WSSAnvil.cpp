@@ -6,14 +6,17 @@
 #include "Globals.h"
 #include "WSSAnvil.h"
 #include "NBTChunkSerializer.h"
+#include "ChunkNBTBuffers.h"
 #include "FastNBT.h"
 #include "EnchantmentSerializer.h"
 #include "zlib/zlib.h"
 #include "../World.h"
+#include "../ChunkMap.h"
 #include "../BlockID.h"
 #include "../Item.h"
 #include "../ItemGrid.h"
 #include "../StringCompression.h"
+#include "../OSSupport/Timer.h"
 
 #include "../BlockEntities/ChestEntity.h"
 #include "../BlockEntities/CommandBlockEntity.h"
@@ -56,9 +59,6 @@ Since only the header is actually in the memory, this number can be high, but st
 */
 #define MAX_MCA_FILES 32
 
-/// The maximum size of an inflated chunk; raw chunk data is 192 KiB, allow 64 KiB more of entities
-#define CHUNK_INFLATE_MAX 256 KiB
-
 
 
 
@@ -69,33 +69,69 @@ Since only the header is actually in the memory, this number can be high, but st
 
 cWSSAnvil::cWSSAnvil(cWorld * a_World, int a_CompressionFactor) :
 	super(a_World),
-	m_CompressionFactor(a_CompressionFactor)
+	m_NumChunksRead(0),
+	m_NumBytesRead(0),
+	m_ReadTimeUsec(0),
+	m_NumChunksWritten(0),
+	m_NumBytesWritten(0),
+	m_WriteTimeUsec(0),
+	m_CompressionFactor(a_CompressionFactor),
+	m_WorldFolder(a_World->GetName())
+{
+	WriteLevelDat((int)(a_World->GetSpawnX()), (int)(a_World->GetSpawnY()), (int)(a_World->GetSpawnZ()));
+}
+
+
+
+
+
+cWSSAnvil::cWSSAnvil(const AString & a_WorldFolder, int a_CompressionFactor) :
+	super(NULL),
+	m_NumChunksRead(0),
+	m_NumBytesRead(0),
+	m_ReadTimeUsec(0),
+	m_NumChunksWritten(0),
+	m_NumBytesWritten(0),
+	m_WriteTimeUsec(0),
+	m_CompressionFactor(a_CompressionFactor),
+	m_WorldFolder(a_WorldFolder)
+{
+	// There's no world to ask for the spawn, the server will set it when it first loads the world:
+	WriteLevelDat(0, 128, 0);
+}
+
+
+
+
+
+void cWSSAnvil::WriteLevelDat(int a_SpawnX, int a_SpawnY, int a_SpawnZ)
 {
-	// Create a level.dat file for mapping tools, if it doesn't already exist:
 	AString fnam;
-	Printf(fnam, "%s/level.dat", a_World->GetName().c_str());
-	if (!cFile::Exists(fnam))
-	{
-		cFastNBTWriter Writer;
-		Writer.BeginCompound("");
-		Writer.AddInt("SpawnX", (int)(a_World->GetSpawnX()));
-		Writer.AddInt("SpawnY", (int)(a_World->GetSpawnY()));
-		Writer.AddInt("SpawnZ", (int)(a_World->GetSpawnZ()));
-		Writer.EndCompound();
-		Writer.Finish();
-		
-		#ifdef _DEBUG
-		cParsedNBT TestParse(Writer.GetResult().data(), Writer.GetResult().size());
-		ASSERT(TestParse.IsValid());
-		#endif  // _DEBUG
-		
-		gzFile gz = gzopen((FILE_IO_PREFIX + fnam).c_str(), "wb");
-		if (gz != NULL)
-		{
-			gzwrite(gz, Writer.GetResult().data(), Writer.GetResult().size());
-		}
-		gzclose(gz);
+	Printf(fnam, "%s/level.dat", m_WorldFolder.c_str());
+	if (cFile::Exists(fnam))
+	{
+		return;
+	}
+	
+	cFastNBTWriter Writer;
+	Writer.BeginCompound("");
+	Writer.AddInt("SpawnX", a_SpawnX);
+	Writer.AddInt("SpawnY", a_SpawnY);
+	Writer.AddInt("SpawnZ", a_SpawnZ);
+	Writer.EndCompound();
+	Writer.Finish();
+	
+	#ifdef _DEBUG
+	cParsedNBT TestParse(Writer.GetResult().data(), Writer.GetResult().size());
+	ASSERT(TestParse.IsValid());
+	#endif  // _DEBUG
+	
+	gzFile gz = gzopen((FILE_IO_PREFIX + fnam).c_str(), "wb");
+	if (gz != NULL)
+	{
+		gzwrite(gz, Writer.GetResult().data(), Writer.GetResult().size());
 	}
+	gzclose(gz);
 }
 
 
@@ -104,11 +140,19 @@ cWSSAnvil::cWSSAnvil(cWorld * a_World, int a_CompressionFactor) :
 
 cWSSAnvil::~cWSSAnvil()
 {
-	cCSLock Lock(m_CS);
-	for (cMCAFiles::iterator itr = m_Files.begin(); itr != m_Files.end(); ++itr)
+	{
+		cCSLock Lock(m_CS);
+		for (cMCAFiles::iterator itr = m_Files.begin(); itr != m_Files.end(); ++itr)
+		{
+			delete *itr;
+		}  // for itr - m_Files[]
+	}
+	
+	cCSLock Lock(m_CSFreeBuffers);
+	for (cChunkNBTBuffersList::iterator itr = m_FreeBuffers.begin(), end = m_FreeBuffers.end(); itr != end; ++itr)
 	{
 		delete *itr;
-	}  // for itr - m_Files[]
+	}  // for itr - m_FreeBuffers[]
 }
 
 
@@ -117,14 +161,19 @@ cWSSAnvil::~cWSSAnvil()
 
 bool cWSSAnvil::LoadChunk(const cChunkCoords & a_Chunk)
 {
-	AString ChunkData;
-	if (!GetChunkData(a_Chunk, ChunkData))
+	if (m_World == NULL)
 	{
-		// The reason for failure is already printed in GetChunkData()
+		ASSERT(!"Loading chunks needs a world");
 		return false;
 	}
 	
-	return LoadChunkFromData(a_Chunk, ChunkData);
+	cChunkNBTBuffers * Buffers = AcquireBuffers();
+	bool res = (
+		GetChunkData(a_Chunk, Buffers->GetCompressedIn()) &&  // The reason for failure is already printed in GetChunkData()
+		LoadChunkFromData(a_Chunk, *Buffers)
+	);
+	ReleaseBuffers(Buffers);
+	return res;
 }
 
 
@@ -133,20 +182,106 @@ bool cWSSAnvil::LoadChunk(const cChunkCoords & a_Chunk)
 
 bool cWSSAnvil::SaveChunk(const cChunkCoords & a_Chunk)
 {
-	AString ChunkData;
-	if (!SaveChunkToData(a_Chunk, ChunkData))
+	ASSERT(m_World != NULL);  // World-less storage saves through SaveChunkFromSource() only
+	return SaveChunkFromSource(a_Chunk, *m_World->GetChunkMap());
+}
+
+
+
+
+
+bool cWSSAnvil::SaveChunkFromSource(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source)
+{
+	cChunkNBTBuffers * Buffers = AcquireBuffers();
+	bool res = false;
+	const AString * ChunkData = SaveChunkToData(a_Chunk, a_Source, *Buffers);
+	if (ChunkData == NULL)
 	{
 		LOGWARNING("Cannot serialize chunk [%d, %d] into data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
-		return false;
 	}
-	if (!SetChunkData(a_Chunk, ChunkData))
+	else if (!SetChunkData(a_Chunk, *ChunkData))
 	{
 		LOGWARNING("Cannot store chunk [%d, %d] data", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+	}
+	else
+	{
+		// Everything successful
+		res = true;
+	}
+	ReleaseBuffers(Buffers);
+	return res;
+}
+
+
+
+
+
+bool cWSSAnvil::HasChunk(const cChunkCoords & a_Chunk)
+{
+	cMCAFile * File = LoadMCAFile(a_Chunk);
+	if (File == NULL)
+	{
 		return false;
 	}
+	bool res;
+	{
+		cCSLock Lock(File->m_CS);
+		res = File->HasChunk(a_Chunk);
+	}
+	ReleaseMCAFile(File);
+	return res;
+}
+
+
+
+
+
+bool cWSSAnvil::LoadChunkBlocks(const cChunkCoords & a_Chunk, cChunkDef::BlockTypes & a_BlockTypes, cChunkDef::BlockNibbles & a_BlockMetas)
+{
+	cChunkNBTBuffers * Buffers = AcquireBuffers();
+	bool res = false;
+	if (GetChunkData(a_Chunk, Buffers->GetCompressedIn()))
+	{
+		const cParsedNBT * NBT = Buffers->ParseCompressed();
+		if (NBT != NULL)
+		{
+			// The light is not wanted, but the sections carry it anyway:
+			cChunkDef::BlockNibbles BlockLight, SkyLight;
+			res = LoadSectionsFromNBT(*NBT, NBT->FindChildByName(0, "Level"), a_BlockTypes, a_BlockMetas, BlockLight, SkyLight);
+		}
+	}
+	ReleaseBuffers(Buffers);
+	return res;
+}
+
+
+
+
+
+cChunkNBTBuffers * cWSSAnvil::AcquireBuffers(void)
+{
+	{
+		cCSLock Lock(m_CSFreeBuffers);
+		if (!m_FreeBuffers.empty())
+		{
+			cChunkNBTBuffers * res = m_FreeBuffers.back();
+			m_FreeBuffers.pop_back();
+			return res;
+		}
+	}
 	
-	// Everything successful
-	return true;
+	// No free buffers, all are used by the other threads, create new ones:
+	return new cChunkNBTBuffers(m_CompressionFactor);
+}
+
+
+
+
+
+void cWSSAnvil::ReleaseBuffers(cChunkNBTBuffers * a_Buffers)
+{
+	cCSLock Lock(m_CSFreeBuffers);
+	m_FreeBuffers.push_back(a_Buffers);
 }
 
 
@@ -155,13 +290,30 @@ bool cWSSAnvil::SaveChunk(const cChunkCoords & a_Chunk)
 
 bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
 {
-	cCSLock Lock(m_CS);
 	cMCAFile * File = LoadMCAFile(a_Chunk);
 	if (File == NULL)
 	{
 		return false;
 	}
-	return File->GetChunkData(a_Chunk, a_Data);
+	
+	cTimer Timer;
+	long long StartTime = Timer.GetNowTimeUsec();
+	bool res;
+	{
+		cCSLock Lock(File->m_CS);
+		res = File->GetChunkData(a_Chunk, a_Data);
+	}
+	long long Duration = Timer.GetNowTimeUsec() - StartTime;
+	ReleaseMCAFile(File);
+	
+	if (res)
+	{
+		cCSLock Lock(m_CSStats);
+		m_NumChunksRead += 1;
+		m_NumBytesRead += a_Data.size();
+		m_ReadTimeUsec += Duration;
+	}
+	return res;
 }
 
 
@@ -170,13 +322,30 @@ bool cWSSAnvil::GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
 
 bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Data)
 {
-	cCSLock Lock(m_CS);
 	cMCAFile * File = LoadMCAFile(a_Chunk);
 	if (File == NULL)
 	{
 		return false;
 	}
-	return File->SetChunkData(a_Chunk, a_Data);
+	
+	cTimer Timer;
+	long long StartTime = Timer.GetNowTimeUsec();
+	bool res;
+	{
+		cCSLock Lock(File->m_CS);
+		res = File->SetChunkData(a_Chunk, a_Data);
+	}
+	long long Duration = Timer.GetNowTimeUsec() - StartTime;
+	ReleaseMCAFile(File);
+	
+	if (res)
+	{
+		cCSLock Lock(m_CSStats);
+		m_NumChunksWritten += 1;
+		m_NumBytesWritten += a_Data.size();
+		m_WriteTimeUsec += Duration;
+	}
+	return res;
 }
 
 
@@ -185,9 +354,6 @@ bool cWSSAnvil::SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Dat
 
 cWSSAnvil::cMCAFile * cWSSAnvil::LoadMCAFile(const cChunkCoords & a_Chunk)
 {
-	// ASSUME m_CS is locked
-	ASSERT(m_CS.IsLocked());
-
 	const int RegionX = FAST_FLOOR_DIV(a_Chunk.m_ChunkX, 32);
 	const int RegionZ = FAST_FLOOR_DIV(a_Chunk.m_ChunkZ, 32);
 	ASSERT(a_Chunk.m_ChunkX - RegionX * 32 >= 0);
@@ -195,25 +361,22 @@ cWSSAnvil::cMCAFile * cWSSAnvil::LoadMCAFile(const cChunkCoords & a_Chunk)
 	ASSERT(a_Chunk.m_ChunkX - RegionX * 32 < 32);
 	ASSERT(a_Chunk.m_ChunkZ - RegionZ * 32 < 32);
 	
+	cCSLock Lock(m_CS);
+	
 	// Is it already cached?
-	for (cMCAFiles::iterator itr = m_Files.begin(); itr != m_Files.end(); ++itr)
+	cMCAFileMap::iterator itr = m_FileMap.find(std::make_pair(RegionX, RegionZ));
+	if (itr != m_FileMap.end())
 	{
-		if (((*itr) != NULL) && ((*itr)->GetRegionX() == RegionX) && ((*itr)->GetRegionZ() == RegionZ))
-		{
-			// Move the file to front and return it:
-			cMCAFile * f = *itr;
-			if (itr != m_Files.begin())
-			{
-				m_Files.erase(itr);
-				m_Files.push_front(f);
-			}
-			return f;
-		}
+		// Move the file to front and return it:
+		cMCAFile * f = itr->second;
+		m_Files.splice(m_Files.begin(), m_Files, f->m_LRUPos);
+		f->m_NumUsers += 1;
+		return f;
 	}
 	
 	// Load it anew:
 	AString FileName;
-	Printf(FileName, "%s/region", m_World->GetName().c_str());
+	Printf(FileName, "%s/region", m_WorldFolder.c_str());
 	cFile::CreateFolder(FILE_IO_PREFIX + FileName);
 	AppendPrintf(FileName, "/r.%d.%d.mca", RegionX, RegionZ);
 	cMCAFile * f = new cMCAFile(FileName, RegionX, RegionZ);
@@ -222,68 +385,124 @@ cWSSAnvil::cMCAFile * cWSSAnvil::LoadMCAFile(const cChunkCoords & a_Chunk)
 		return NULL;
 	}
 	m_Files.push_front(f);
+	f->m_LRUPos = m_Files.begin();
+	f->m_NumUsers = 1;
+	m_FileMap[std::make_pair(RegionX, RegionZ)] = f;
 	
-	// If there are too many MCA files cached, delete the last one used:
-	if (m_Files.size() > MAX_MCA_FILES)
+	// If there are too many MCA files cached, delete the ones used least recently:
+	TrimMCAFiles();
+	return f;
+}
+
+
+
+
+
+void cWSSAnvil::ReleaseMCAFile(cMCAFile * a_File)
+{
+	cCSLock Lock(m_CS);
+	ASSERT(a_File->m_NumUsers > 0);
+	a_File->m_NumUsers -= 1;
+	if (a_File->m_NumUsers == 0)
 	{
-		delete m_Files.back();
-		m_Files.pop_back();
+		// The cache may have grown over the limit while this file was in use:
+		TrimMCAFiles();
 	}
-	return f;
 }
 
 
 
 
 
-bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, const AString & a_Data)
+void cWSSAnvil::TrimMCAFiles(void)
 {
-	// Decompress the data:
-	char Uncompressed[CHUNK_INFLATE_MAX];
-	z_stream strm;
-	strm.zalloc = (alloc_func)NULL;
-	strm.zfree = (free_func)NULL;
-	strm.opaque = NULL;
-	inflateInit(&strm);
-	strm.next_out  = (Bytef *)Uncompressed;
-	strm.avail_out = sizeof(Uncompressed);
-	strm.next_in   = (Bytef *)a_Data.data();
-	strm.avail_in  = a_Data.size();
-	int res = inflate(&strm, Z_FINISH);
-	inflateEnd(&strm);
-	if (res != Z_STREAM_END)
+	ASSERT(m_CS.IsLocked());
+	
+	cMCAFiles::iterator itr = m_Files.end();
+	while ((m_Files.size() > MAX_MCA_FILES) && (itr != m_Files.begin()))
 	{
-		return false;
+		--itr;
+		cMCAFile * f = *itr;
+		if (f->m_NumUsers > 0)
+		{
+			// Still in use by another thread, keep it
+			continue;
+		}
+		m_FileMap.erase(std::make_pair(f->GetRegionX(), f->GetRegionZ()));
+		itr = m_Files.erase(itr);
+		delete f;
+	}
+}
+
+
+
+
+
+void cWSSAnvil::LogStats(void)
+{
+	int NumChunksRead, NumChunksWritten;
+	long long NumBytesRead, NumBytesWritten, ReadTimeUsec, WriteTimeUsec;
+	{
+		cCSLock Lock(m_CSStats);
+		NumChunksRead    = m_NumChunksRead;
+		NumBytesRead     = m_NumBytesRead;
+		ReadTimeUsec     = m_ReadTimeUsec;
+		NumChunksWritten = m_NumChunksWritten;
+		NumBytesWritten  = m_NumBytesWritten;
+		WriteTimeUsec    = m_WriteTimeUsec;
+		m_NumChunksRead    = 0;
+		m_NumBytesRead     = 0;
+		m_ReadTimeUsec     = 0;
+		m_NumChunksWritten = 0;
+		m_NumBytesWritten  = 0;
+		m_WriteTimeUsec    = 0;
+	}
+	size_t NumFiles;
+	{
+		cCSLock Lock(m_CS);
+		NumFiles = m_Files.size();
 	}
 	
-	// Parse the NBT data:
-	cParsedNBT NBT(Uncompressed, strm.total_out);
-	if (!NBT.IsValid())
+	// Bytes per microsecond is the same as MB per second:
+	LOGINFO("Anvil storage in world %s: read %d chunks (%.1f KiB) at %.2f MB/s, wrote %d chunks (%.1f KiB) at %.2f MB/s; %u region files open",
+		m_WorldFolder.c_str(),
+		NumChunksRead,    (double)NumBytesRead / 1024,    (ReadTimeUsec  > 0) ? (double)NumBytesRead    / ReadTimeUsec  : 0.0,
+		NumChunksWritten, (double)NumBytesWritten / 1024, (WriteTimeUsec > 0) ? (double)NumBytesWritten / WriteTimeUsec : 0.0,
+		(unsigned)NumFiles
+	);
+}
+
+
+
+
+
+bool cWSSAnvil::LoadChunkFromData(const cChunkCoords & a_Chunk, cChunkNBTBuffers & a_Buffers)
+{
+	// Decompress and parse the NBT data:
+	const cParsedNBT * NBT = a_Buffers.ParseCompressed();
+	if (NBT == NULL)
 	{
-		// NBT Parsing failed
+		// Decompression or NBT parsing failed
 		return false;
 	}
 
 	// Load the data from NBT:
-	return LoadChunkFromNBT(a_Chunk, NBT);
+	return LoadChunkFromNBT(a_Chunk, *NBT);
 }
 
 
 
 
 
-bool cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk, AString & a_Data)
+const AString * cWSSAnvil::SaveChunkToData(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source, cChunkNBTBuffers & a_Buffers)
 {
-	cFastNBTWriter Writer;
-	if (!SaveChunkToNBT(a_Chunk, Writer))
+	cFastNBTWriter & Writer = a_Buffers.StartWriting();
+	if (!SaveChunkToNBT(a_Chunk, a_Source, Writer))
 	{
 		LOGWARNING("Cannot save chunk [%d, %d] to NBT", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
-		return false;
+		return NULL;
 	}
-	Writer.Finish();
-	
-	CompressString(Writer.GetResult().data(), Writer.GetResult().size(), a_Data, m_CompressionFactor);
-	return true;
+	return a_Buffers.FinishWriting();
 }
 
 
@@ -298,40 +517,12 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 	cChunkDef::BlockNibbles BlockLight;
 	cChunkDef::BlockNibbles SkyLight;
 	
-	memset(BlockTypes, E_BLOCK_AIR, sizeof(BlockTypes));
-	memset(MetaData,   0,           sizeof(MetaData));
-	memset(SkyLight,   0xff,        sizeof(SkyLight));  // By default, data not present in the NBT means air, which means full skylight
-	memset(BlockLight, 0x00,        sizeof(BlockLight));
-	
 	// Load the blockdata, blocklight and skylight:
 	int Level = a_NBT.FindChildByName(0, "Level");
-	if (Level < 0)
+	if (!LoadSectionsFromNBT(a_NBT, Level, BlockTypes, MetaData, BlockLight, SkyLight))
 	{
 		return false;
 	}
-	int Sections = a_NBT.FindChildByName(Level, "Sections");
-	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List) || (a_NBT.GetChildrenType(Sections) != TAG_Compound))
-	{
-		return false;
-	}
-	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
-	{
-		int y = 0;
-		int SectionY = a_NBT.FindChildByName(Child, "Y");
-		if ((SectionY < 0) || (a_NBT.GetType(SectionY) != TAG_Byte))
-		{
-			continue;
-		}
-		y = a_NBT.GetByte(SectionY);
-		if ((y < 0) || (y > 15))
-		{
-			continue;
-		}
-		CopyNBTData(a_NBT, Child, "Blocks",     (char *)&(BlockTypes[y * 4096]), 4096);
-		CopyNBTData(a_NBT, Child, "Data",       (char *)&(MetaData[y   * 2048]), 2048);
-		CopyNBTData(a_NBT, Child, "SkyLight",   (char *)&(SkyLight[y   * 2048]), 2048);
-		CopyNBTData(a_NBT, Child, "BlockLight", (char *)&(BlockLight[y * 2048]), 2048);
-	}  // for itr - LevelSections[]
 	
 	// Load the biomes from NBT, if present and valid. First try MCS-style, then Vanilla-style:
 	cChunkDef::BiomeMap BiomeMap;
@@ -401,6 +592,51 @@ bool cWSSAnvil::LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT
 
 
 
+
+bool cWSSAnvil::LoadSectionsFromNBT(
+	const cParsedNBT & a_NBT, int a_LevelTag,
+	cChunkDef::BlockTypes & a_BlockTypes, cChunkDef::BlockNibbles & a_BlockMetas,
+	cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+)
+{
+	memset(a_BlockTypes, E_BLOCK_AIR, sizeof(a_BlockTypes));
+	memset(a_BlockMetas, 0,           sizeof(a_BlockMetas));
+	memset(a_SkyLight,   0xff,        sizeof(a_SkyLight));  // By default, data not present in the NBT means air, which means full skylight
+	memset(a_BlockLight, 0x00,        sizeof(a_BlockLight));
+	
+	if (a_LevelTag < 0)
+	{
+		return false;
+	}
+	int Sections = a_NBT.FindChildByName(a_LevelTag, "Sections");
+	if ((Sections < 0) || (a_NBT.GetType(Sections) != TAG_List) || (a_NBT.GetChildrenType(Sections) != TAG_Compound))
+	{
+		return false;
+	}
+	for (int Child = a_NBT.GetFirstChild(Sections); Child >= 0; Child = a_NBT.GetNextSibling(Child))
+	{
+		int y = 0;
+		int SectionY = a_NBT.FindChildByName(Child, "Y");
+		if ((SectionY < 0) || (a_NBT.GetType(SectionY) != TAG_Byte))
+		{
+			continue;
+		}
+		y = a_NBT.GetByte(SectionY);
+		if ((y < 0) || (y > 15))
+		{
+			continue;
+		}
+		CopyNBTData(a_NBT, Child, "Blocks",     (char *)&(a_BlockTypes[y * 4096]), 4096);
+		CopyNBTData(a_NBT, Child, "Data",       (char *)&(a_BlockMetas[y * 2048]), 2048);
+		CopyNBTData(a_NBT, Child, "SkyLight",   (char *)&(a_SkyLight[y   * 2048]), 2048);
+		CopyNBTData(a_NBT, Child, "BlockLight", (char *)&(a_BlockLight[y * 2048]), 2048);
+	}  // for itr - LevelSections[]
+	return true;
+}
+
+
+
+
 void cWSSAnvil::CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, char * a_Destination, int a_Length)
 {
 	int Child = a_NBT.FindChildByName(a_Tag, a_ChildName);
@@ -414,13 +650,13 @@ void cWSSAnvil::CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString &
 
 
 
-bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_Writer)
+bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source, cFastNBTWriter & a_Writer)
 {
 	a_Writer.BeginCompound("Level");
 	a_Writer.AddInt("xPos", a_Chunk.m_ChunkX);
 	a_Writer.AddInt("zPos", a_Chunk.m_ChunkZ);
 	cNBTChunkSerializer Serializer(a_Writer);
-	if (!m_World->GetChunkData(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Serializer))
+	if (!a_Source.GetChunkData(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, Serializer))
 	{
 		LOGWARNING("Cannot get chunk [%d, %d] data for NBT saving", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
 		return false;
@@ -434,25 +670,27 @@ bool cWSSAnvil::SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_
 		a_Writer.AddIntArray ("MCSBiomes", (const int *)(Serializer.m_Biomes),         ARRAYCOUNT(Serializer.m_Biomes));
 	}
 	
-	// Save blockdata:
+	// Save blockdata; only the non-empty sections are written, the loader treats missing sections as air with full skylight:
 	a_Writer.BeginList("Sections", TAG_Compound);
-	int SliceSizeBlock  = cChunkDef::Width * cChunkDef::Width * 16;
-	int SliceSizeNibble = SliceSizeBlock / 2;
-	const char * BlockTypes    = (const char *)(Serializer.m_BlockTypes);
-	const char * BlockMetas    = (const char *)(Serializer.m_BlockMetas);
-	#ifdef DEBUG_SKYLIGHT
-		const char * BlockLight  = (const char *)(Serializer.m_BlockSkyLight);
-	#else
-		const char * BlockLight  = (const char *)(Serializer.m_BlockLight);
-	#endif 
-	const char * BlockSkyLight = (const char *)(Serializer.m_BlockSkyLight);
-	for (int Y = 0; Y < 16; Y++)
+	const int SliceSizeBlock  = cChunkData::SectionBlockCount;
+	const int SliceSizeNibble = SliceSizeBlock / 2;
+	for (int Y = 0; Y < cChunkData::NumSections; Y++)
 	{
+		const cChunkData::sChunkSection * Section = Serializer.m_Data.GetSection(Y);
+		if (Section == NULL)
+		{
+			continue;
+		}
+		#ifdef DEBUG_SKYLIGHT
+			const char * BlockLight = (const char *)(Section->m_BlockSkyLight);
+		#else
+			const char * BlockLight = (const char *)(Section->m_BlockLight);
+		#endif
 		a_Writer.BeginCompound("");
-		a_Writer.AddByteArray("Blocks",     BlockTypes    + Y * SliceSizeBlock,  SliceSizeBlock);
-		a_Writer.AddByteArray("Data",       BlockMetas    + Y * SliceSizeNibble, SliceSizeNibble);
-		a_Writer.AddByteArray("SkyLight",   BlockSkyLight + Y * SliceSizeNibble, SliceSizeNibble);
-		a_Writer.AddByteArray("BlockLight", BlockLight    + Y * SliceSizeNibble, SliceSizeNibble);
+		a_Writer.AddByteArray("Blocks",     (const char *)(Section->m_BlockTypes),    SliceSizeBlock);
+		a_Writer.AddByteArray("Data",       (const char *)(Section->m_BlockMetas),    SliceSizeNibble);
+		a_Writer.AddByteArray("SkyLight",   (const char *)(Section->m_BlockSkyLight), SliceSizeNibble);
+		a_Writer.AddByteArray("BlockLight", BlockLight,                               SliceSizeNibble);
 		a_Writer.AddByte("Y", (unsigned char)Y);
 		a_Writer.EndCompound();
 	}
@@ -2524,7 +2762,8 @@ bool cWSSAnvil::GetBlockEntityNBTPos(const cParsedNBT & a_NBT, int a_TagIdx, int
 cWSSAnvil::cMCAFile::cMCAFile(const AString & a_FileName, int a_RegionX, int a_RegionZ) :
 	m_RegionX(a_RegionX),
 	m_RegionZ(a_RegionZ),
-	m_FileName(a_FileName)
+	m_FileName(a_FileName),
+	m_NumUsers(0)
 {
 }
 
@@ -2578,6 +2817,31 @@ bool cWSSAnvil::cMCAFile::OpenFile(bool a_IsForReading)
 
 
 
+bool cWSSAnvil::cMCAFile::HasChunk(const cChunkCoords & a_Chunk)
+{
+	if (!OpenFile(true))
+	{
+		// No file, no chunk
+		return false;
+	}
+	
+	int LocalX = a_Chunk.m_ChunkX % 32;
+	if (LocalX < 0)
+	{
+		LocalX = 32 + LocalX;
+	}
+	int LocalZ = a_Chunk.m_ChunkZ % 32;
+	if (LocalZ < 0)
+	{
+		LocalZ = 32 + LocalZ;
+	}
+	return (m_Header[LocalX + 32 * LocalZ] != 0);
+}
+
+
+
+
+
 bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data)
 {
 	if (!OpenFile(true))
@@ -2596,9 +2860,61 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a
 		LocalZ = 32 + LocalZ;
 	}
 	unsigned ChunkLocation = ntohl(m_Header[LocalX + 32 * LocalZ]);
-	unsigned ChunkOffset = ChunkLocation >> 8;
+	unsigned ChunkOffset = (ChunkLocation >> 8) * 4096;
+	
+	if (!EnsureMapped(ChunkOffset + MCA_CHUNK_HEADER_LENGTH))
+	{
+		// The file cannot be mapped (or the chunk is past its end), try reading it the old way:
+		return ReadChunkDataFromFile(ChunkOffset, a_Data);
+	}
+	
+	const unsigned char * ChunkHeader = (const unsigned char *)m_Map.GetData() + ChunkOffset;
+	int ChunkSize = (ChunkHeader[0] << 24) | (ChunkHeader[1] << 16) | (ChunkHeader[2] << 8) | ChunkHeader[3];
+	char CompressionType = (char)ChunkHeader[4];
+	if (CompressionType != 2)
+	{
+		// Chunk is in an unknown compression
+		return false;
+	}
+	ChunkSize--;
+	if ((ChunkSize <= 0) || !EnsureMapped(ChunkOffset + MCA_CHUNK_HEADER_LENGTH + ChunkSize))
+	{
+		return false;
+	}
 	
-	m_File.Seek(ChunkOffset * 4096);
+	a_Data.assign(m_Map.GetData() + ChunkOffset + MCA_CHUNK_HEADER_LENGTH, ChunkSize);
+	return true;
+}
+
+
+
+
+
+bool cWSSAnvil::cMCAFile::EnsureMapped(size_t a_End)
+{
+	if (m_Map.GetSize() >= a_End)
+	{
+		return true;
+	}
+	
+	// The file may have grown since it was mapped, re-map:
+	if (!m_Map.Open(m_FileName))
+	{
+		return false;
+	}
+	return (m_Map.GetSize() >= a_End);
+}
+
+
+
+
+
+bool cWSSAnvil::cMCAFile::ReadChunkDataFromFile(unsigned a_Offset, AString & a_Data)
+{
+	if (m_File.Seek(a_Offset) < 0)
+	{
+		return false;
+	}
 	
 	int ChunkSize = 0;
 	if (m_File.Read(&ChunkSize, 4) != 4)
@@ -2617,6 +2933,10 @@ bool cWSSAnvil::cMCAFile::GetChunkData(const cChunkCoords & a_Chunk, AString & a
 		return false;
 	}
 	ChunkSize--;
+	if (ChunkSize <= 0)
+	{
+		return false;
+	}
 	
 	// HACK: This depends on the internal knowledge that AString's data() function returns the internal buffer directly
 	a_Data.assign(ChunkSize, '\0');
@@ -2668,21 +2988,25 @@ bool cWSSAnvil::cMCAFile::SetChunkData(const cChunkCoords & a_Chunk, const AStri
 		return false;
 	}
 	
-	// Store the header:
+	// Store the header; only the one changed entry needs writing:
 	ChunkSize = (a_Data.size() + MCA_CHUNK_HEADER_LENGTH + 4095) / 4096;  // Round data size *up* to nearest 4KB sector, make it a sector number
 	ASSERT(ChunkSize < 256);
-	m_Header[LocalX + 32 * LocalZ] = htonl((ChunkSector << 8) | ChunkSize);
-	if (m_File.Seek(0) < 0)
+	int HeaderIdx = LocalX + 32 * LocalZ;
+	m_Header[HeaderIdx] = htonl((ChunkSector << 8) | ChunkSize);
+	if (m_File.Seek(HeaderIdx * (int)sizeof(m_Header[0])) < 0)
 	{
 		LOGWARNING("Cannot save chunk [%d, %d], seeking in file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
 		return false;
 	}
-	if (m_File.Write(m_Header, sizeof(m_Header)) != sizeof(m_Header))
+	if (m_File.Write(&m_Header[HeaderIdx], sizeof(m_Header[0])) != sizeof(m_Header[0]))
 	{
 		LOGWARNING("Cannot save chunk [%d, %d], writing header to file \"%s\" failed", a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ, GetFileName().c_str());
 		return false;
 	}
 	
+	// Push the data to the OS, so that it is visible through the memory mapping used for reading:
+	m_File.Flush();
+	
 	return true;
 }
 
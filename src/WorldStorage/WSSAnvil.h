@@ -10,6 +10,7 @@
 
 #include "WorldStorage.h"
 #include "FastNBT.h"
+#include "../OSSupport/MemoryMappedFile.h"
 #include "../Mobs/Monster.h"
 
 
@@ -21,6 +22,7 @@ class cItemGrid;
 
 class cProjectileEntity;
 class cHangingEntity;
+class cChunkNBTBuffers;
 
 
 
@@ -50,16 +52,35 @@ class cWSSAnvil :
 public:
 
 	cWSSAnvil(cWorld * a_World, int a_CompressionFactor);
+	
+	/** Creates the storage for the world in the specified folder, without any cWorld.
+	Such a storage can only save chunks through SaveChunkFromSource() and read them through HasChunk() and LoadChunkBlocks();
+	used by tools such as the pregenerator. */
+	cWSSAnvil(const AString & a_WorldFolder, int a_CompressionFactor);
+	
 	virtual ~cWSSAnvil();
 	
+	/** Saves the chunk, taking its data from a_Source instead of the world. Thread-safe, same as SaveChunk(). */
+	bool SaveChunkFromSource(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source);
+	
+	/** Returns true if the chunk is stored, based on the region file's header only; the chunk data is not read. Thread-safe. */
+	bool HasChunk(const cChunkCoords & a_Chunk);
+	
+	/** Reads the block types and metas of the stored chunk, without creating its entities and block entities; doesn't need a world.
+	Returns false if the chunk is not stored or cannot be read. Thread-safe. */
+	bool LoadChunkBlocks(const cChunkCoords & a_Chunk, cChunkDef::BlockTypes & a_BlockTypes, cChunkDef::BlockNibbles & a_BlockMetas);
+	
 protected:
 
 	class cMCAFile
 	{
+		friend class cWSSAnvil;
+		
 	public:
 	
 		cMCAFile(const AString & a_FileName, int a_RegionX, int a_RegionZ);
 		
+		bool HasChunk      (const cChunkCoords & a_Chunk);
 		bool GetChunkData  (const cChunkCoords & a_Chunk, AString & a_Data);
 		bool SetChunkData  (const cChunkCoords & a_Chunk, const AString & a_Data);
 		bool EraseChunkData(const cChunkCoords & a_Chunk);
@@ -75,6 +96,19 @@ protected:
 		cFile   m_File;
 		AString m_FileName;
 		
+		/** Read-only memory mapping of the file, used for reading the chunk data. Re-mapped when the file grows. */
+		cMemoryMappedFile m_Map;
+		
+		/** Serializes the operations on this file; operations on different files may run in parallel */
+		cCriticalSection m_CS;
+		
+		/** Number of threads currently using this file; the file is not evicted from the cache while in use.
+		Protected by cWSSAnvil::m_CS, not by this object's m_CS. */
+		int m_NumUsers;
+		
+		/** Position of this file in cWSSAnvil::m_Files, for quick moving to the front. Protected by cWSSAnvil::m_CS. */
+		std::list<cMCAFile *>::iterator m_LRUPos;
+		
 		// The header, copied from the file so we don't have to seek to it all the time
 		// First 1024 entries are chunk locations - the 3 + 1 byte sector-offset and sector-count
 		unsigned m_Header[MCA_MAX_CHUNKS];
@@ -86,13 +120,45 @@ protected:
 		
 		/// Opens a MCA file either for a Read operation (fails if doesn't exist) or for a Write operation (creates new if not found)
 		bool OpenFile(bool a_IsForReading);
+		
+		/** Makes sure that the memory mapping covers the file up to a_End bytes, re-mapping the file if needed.
+		Returns false if the file is shorter than that or cannot be mapped. */
+		bool EnsureMapped(size_t a_End);
+		
+		/** Reads the chunk data at the specified offset using regular file reads; used when the file cannot be mapped */
+		bool ReadChunkDataFromFile(unsigned a_Offset, AString & a_Data);
 	} ;
 	typedef std::list<cMCAFile *> cMCAFiles;
 	
+	/** Region coords (X, Z) -> the MCA file */
+	typedef std::map<std::pair<int, int>, cMCAFile *> cMCAFileMap;
+	
+	/** Protects m_Files and m_FileMap, but not the files themselves; each file has its own CS */
 	cCriticalSection m_CS;
-	cMCAFiles        m_Files;  // a MRU cache of MCA files
+	cMCAFiles        m_Files;    // a MRU cache of MCA files, the most recently used is at the front
+	cMCAFileMap      m_FileMap;  // the same files as in m_Files, indexed by their region coords
+	
+	/** Protects the I/O statistics below */
+	cCriticalSection m_CSStats;
+	
+	/** I/O statistics since the last LogStats() call: number of chunks, bytes, and total time spent, separately for reads and writes */
+	int       m_NumChunksRead;
+	long long m_NumBytesRead;
+	long long m_ReadTimeUsec;
+	int       m_NumChunksWritten;
+	long long m_NumBytesWritten;
+	long long m_WriteTimeUsec;
 	
 	int m_CompressionFactor;
+	
+	/** The folder where the world is stored, its region files are in its "region" subfolder */
+	AString m_WorldFolder;
+	
+	typedef std::vector<cChunkNBTBuffers *> cChunkNBTBuffersList;
+	
+	/** The buffers not used by any thread right now; there's one set of buffers for each thread that has loaded or saved a chunk */
+	cChunkNBTBuffersList m_FreeBuffers;
+	cCriticalSection     m_CSFreeBuffers;
 
 	/// Gets chunk data from the correct file; locks file CS as needed
 	bool GetChunkData(const cChunkCoords & a_Chunk, AString & a_Data);
@@ -100,17 +166,35 @@ protected:
 	/// Sets chunk data into the correct file; locks file CS as needed
 	bool SetChunkData(const cChunkCoords & a_Chunk, const AString & a_Data);
 
-	/// Loads the chunk from the data (no locking needed)
-	bool LoadChunkFromData(const cChunkCoords & a_Chunk, const AString & a_Data);
+	/** Loads the chunk from the compressed data in a_Buffers.GetCompressedIn() (no locking needed) */
+	bool LoadChunkFromData(const cChunkCoords & a_Chunk, cChunkNBTBuffers & a_Buffers);
 	
-	/// Saves the chunk into datastream (no locking needed)
-	bool SaveChunkToData(const cChunkCoords & a_Chunk, AString & a_Data);
+	/** Saves the chunk, taken from a_Source, into compressed data using a_Buffers (no locking needed).
+	Returns the data, owned by a_Buffers, or NULL on failure. */
+	const AString * SaveChunkToData(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source, cChunkNBTBuffers & a_Buffers);
+	
+	/** Creates the level.dat file in the world folder for mapping tools, if it doesn't already exist */
+	void WriteLevelDat(int a_SpawnX, int a_SpawnY, int a_SpawnZ);
+	
+	/** Returns a free set of buffers from the pool, or new buffers if there are none free. Locks m_CSFreeBuffers. */
+	cChunkNBTBuffers * AcquireBuffers(void);
+	
+	/** Returns the buffers back to the pool. Locks m_CSFreeBuffers. */
+	void ReleaseBuffers(cChunkNBTBuffers * a_Buffers);
 	
 	/// Loads the chunk from NBT data (no locking needed)
 	bool LoadChunkFromNBT(const cChunkCoords & a_Chunk, const cParsedNBT & a_NBT);
 	
-	/// Saves the chunk into NBT data using a_Writer; returns true on success
-	bool SaveChunkToNBT(const cChunkCoords & a_Chunk, cFastNBTWriter & a_Writer);
+	/** Loads the blocks and the light from the Level\\Sections list tag of the NBT data (no locking needed).
+	The data not present in the NBT is air with full skylight. Returns false if the sections are missing. */
+	bool LoadSectionsFromNBT(
+		const cParsedNBT & a_NBT, int a_LevelTag,
+		cChunkDef::BlockTypes & a_BlockTypes, cChunkDef::BlockNibbles & a_BlockMetas,
+		cChunkDef::BlockNibbles & a_BlockLight, cChunkDef::BlockNibbles & a_SkyLight
+	);
+	
+	/// Saves the chunk, taken from a_Source, into NBT data using a_Writer; returns true on success
+	bool SaveChunkToNBT(const cChunkCoords & a_Chunk, cChunkDataSource & a_Source, cFastNBTWriter & a_Writer);
 	
 	/// Loads the chunk's biome map from vanilla-format; returns a_BiomeMap if biomes present and valid, NULL otherwise
 	cChunkDef::BiomeMap * LoadVanillaBiomeMapFromNBT(cChunkDef::BiomeMap * a_BiomeMap, const cParsedNBT & a_NBT, int a_TagIdx);
@@ -217,9 +301,16 @@ protected:
 	/// Helper function for extracting the X, Y, and Z int subtags of a NBT compound; returns true if successful
 	bool GetBlockEntityNBTPos(const cParsedNBT & a_NBT, int a_TagIdx, int & a_X, int & a_Y, int & a_Z);
 	
-	/// Gets the correct MCA file either from cache or from disk, manages the m_MCAFiles cache; assumes m_CS is locked
+	/** Gets the correct MCA file either from cache or from disk, manages the m_Files cache.
+	Marks the file as being in use, the caller needs to call ReleaseMCAFile() when done with it. Locks m_CS. */
 	cMCAFile * LoadMCAFile(const cChunkCoords & a_Chunk);
 	
+	/** Marks the file as no longer used by the caller, so that it can be evicted from the cache. Locks m_CS. */
+	void ReleaseMCAFile(cMCAFile * a_File);
+	
+	/** Drops the least recently used files from the cache until there's at most MAX_MCA_FILES of them; files in use are kept. Assumes m_CS is locked. */
+	void TrimMCAFiles(void);
+	
 	/// Copies a_Length bytes of data from the specified NBT Tag's Child into the a_Destination buffer
 	void CopyNBTData(const cParsedNBT & a_NBT, int a_Tag, const AString & a_ChildName, char * a_Destination, int a_Length);
 		
@@ -227,6 +318,7 @@ protected:
 	virtual bool LoadChunk(const cChunkCoords & a_Chunk) override;
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) override;
 	virtual const AString GetName(void) const override {return "anvil"; }
+	virtual void LogStats(void) override;
 } ;
 
 
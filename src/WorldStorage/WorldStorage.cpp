@@ -1,7 +1,7 @@
 
 // WorldStorage.cpp
 
-// Implements the cWorldStorage class representing the chunk loading / saving thread
+// Implements the cWorldStorage class representing the chunk loading / saving threads
 
 // To add a new storage schema, implement a cWSSchema descendant and add it to cWorldStorage::InitSchemas()
 
@@ -46,8 +46,11 @@ protected:
 // cWorldStorage:
 
 cWorldStorage::cWorldStorage(void) :
-	super("cWorldStorage"),
 	m_World(NULL),
+	m_NumLoadsInProgress(0),
+	m_NumSavesInProgress(0),
+	m_MaxSavesInProgress(1),
+	m_ShouldTerminate(false),
 	m_SaveSchema(NULL)
 {
 }
@@ -58,6 +61,7 @@ cWorldStorage::cWorldStorage(void) :
 
 cWorldStorage::~cWorldStorage()
 {
+	ASSERT(m_Workers.empty());  // Stop() should have been called
 	for (cWSSchemaList::iterator itr = m_Schemas.begin(); itr != m_Schemas.end(); ++itr)
 	{
 		delete *itr;
@@ -68,13 +72,30 @@ cWorldStorage::~cWorldStorage()
 
 
 
-bool cWorldStorage::Start(cWorld * a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor )
+bool cWorldStorage::Start(cWorld * a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, int a_NumThreads)
 {
+	ASSERT(m_Workers.empty());  // Not started yet
 	m_World = a_World;
 	m_StorageSchemaName = a_StorageSchemaName;
+	m_ShouldTerminate = false;
 	InitSchemas(a_StorageCompressionFactor);
 	
-	return super::Start();
+	if (a_NumThreads < 1)
+	{
+		a_NumThreads = 1;
+	}
+	m_MaxSavesInProgress = std::max(a_NumThreads - 1, 1);
+	for (int i = 0; i < a_NumThreads; i++)
+	{
+		cWorker * Worker = new cWorker(*this);
+		if (!Worker->Start())
+		{
+			delete Worker;
+			return !m_Workers.empty();
+		}
+		m_Workers.push_back(Worker);
+	}
+	return true;
 }
 
 
@@ -92,20 +113,35 @@ void cWorldStorage::Stop(void)
 
 void cWorldStorage::WaitForFinish(void)
 {
+	if (m_Workers.empty())
+	{
+		// Already finished
+		return;
+	}
+	
 	LOG("Waiting for the world storage to finish saving");
 	
 	{
-		m_LoadQueue.Clear();
+		cCSLock Lock(m_CS);
+		m_LoadQueue.clear();
 	}
 	
 	// Wait for the saving to finish:
 	WaitForSaveQueueEmpty();
 	
-	// Wait for the thread to finish:
-	m_ShouldTerminate = true;
-	m_Event.Set(); // Wake up the thread if waiting
-	super::Wait();
-	LOG("World storage thread finished");
+	// Wait for the workers to finish:
+	{
+		cCSLock Lock(m_CS);
+		m_ShouldTerminate = true;
+	}
+	m_Event.Set();  // Wake up the workers if waiting
+	for (cWorkers::iterator itr = m_Workers.begin(), end = m_Workers.end(); itr != end; ++itr)
+	{
+		(*itr)->Wait();
+		delete *itr;
+	}
+	m_Workers.clear();
+	LOG("World storage threads finished");
 }
 
 
@@ -114,7 +150,12 @@ void cWorldStorage::WaitForFinish(void)
 
 void cWorldStorage::WaitForLoadQueueEmpty(void)
 {
-	m_LoadQueue.BlockTillEmpty();
+	cCSLock Lock(m_CS);
+	while (!m_ShouldTerminate && (!m_LoadQueue.empty() || (m_NumLoadsInProgress > 0)))
+	{
+		cCSUnlock Unlock(Lock);
+		m_evtRemoved.Wait();
+	}
 }
 
 
@@ -123,7 +164,12 @@ void cWorldStorage::WaitForLoadQueueEmpty(void)
 
 void cWorldStorage::WaitForSaveQueueEmpty(void)
 {
-	m_SaveQueue.BlockTillEmpty();
+	cCSLock Lock(m_CS);
+	while (!m_ShouldTerminate && (!m_SaveQueue.empty() || (m_NumSavesInProgress > 0)))
+	{
+		cCSUnlock Unlock(Lock);
+		m_evtRemoved.Wait();
+	}
 }
 
 
@@ -132,7 +178,8 @@ void cWorldStorage::WaitForSaveQueueEmpty(void)
 
 size_t cWorldStorage::GetLoadQueueLength(void)
 {
-	return m_LoadQueue.Size();
+	cCSLock Lock(m_CS);
+	return m_LoadQueue.size() + (size_t)m_NumLoadsInProgress;
 }
 
 
@@ -141,7 +188,8 @@ size_t cWorldStorage::GetLoadQueueLength(void)
 
 size_t cWorldStorage::GetSaveQueueLength(void)
 {
-	return m_SaveQueue.Size();
+	cCSLock Lock(m_CS);
+	return m_SaveQueue.size() + (size_t)m_NumSavesInProgress;
 }
 
 
@@ -150,7 +198,20 @@ size_t cWorldStorage::GetSaveQueueLength(void)
 
 void cWorldStorage::QueueLoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, bool a_Generate)
 {
-	m_LoadQueue.EnqueueItem(sChunkLoad(a_ChunkX, a_ChunkY, a_ChunkZ, a_Generate));
+	{
+		cCSLock Lock(m_CS);
+		sChunkLoad Load(a_ChunkX, a_ChunkY, a_ChunkZ, a_Generate);
+		for (sChunkLoadList::iterator itr = m_LoadQueue.begin(), end = m_LoadQueue.end(); itr != end; ++itr)
+		{
+			if (*itr == Load)
+			{
+				// Already queued, just combine the requests:
+				itr->m_Generate |= a_Generate;
+				return;
+			}
+		}
+		m_LoadQueue.push_back(Load);
+	}
 	m_Event.Set();
 }
 
@@ -160,7 +221,16 @@ void cWorldStorage::QueueLoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ, boo
 
 void cWorldStorage::QueueSaveChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
-	m_SaveQueue.EnqueueItemIfNotPresent(cChunkCoords(a_ChunkX, a_ChunkY, a_ChunkZ));
+	{
+		cCSLock Lock(m_CS);
+		cChunkCoords Coords(a_ChunkX, a_ChunkY, a_ChunkZ);
+		if (std::find(m_SaveQueue.begin(), m_SaveQueue.end(), Coords) != m_SaveQueue.end())
+		{
+			// Already queued
+			return;
+		}
+		m_SaveQueue.push_back(Coords);
+	}
 	m_Event.Set();
 }
 
@@ -171,7 +241,10 @@ void cWorldStorage::QueueSaveChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 void cWorldStorage::QueueSavedMessage(void)
 {
 	// Pushes a special coord pair into the queue, signalizing a message instead
-	m_SaveQueue.EnqueueItem(cChunkCoords(0, CHUNK_Y_MESSAGE, 0));
+	{
+		cCSLock Lock(m_CS);
+		m_SaveQueue.push_back(cChunkCoords(0, CHUNK_Y_MESSAGE, 0));
+	}
 	m_Event.Set();
 }
 
@@ -181,7 +254,16 @@ void cWorldStorage::QueueSavedMessage(void)
 
 void cWorldStorage::UnqueueLoad(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 {
-	m_LoadQueue.Remove(sChunkLoad(a_ChunkX, a_ChunkY, a_ChunkZ,true));
+	{
+		cCSLock Lock(m_CS);
+		sChunkLoadList::iterator itr = std::find(m_LoadQueue.begin(), m_LoadQueue.end(), sChunkLoad(a_ChunkX, a_ChunkY, a_ChunkZ, true));
+		if (itr == m_LoadQueue.end())
+		{
+			return;
+		}
+		m_LoadQueue.erase(itr);
+	}
+	m_evtRemoved.Set();
 }
 
 
@@ -190,7 +272,16 @@ void cWorldStorage::UnqueueLoad(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 
 void cWorldStorage::UnqueueSave(const cChunkCoords & a_Chunk)
 {
-	m_SaveQueue.Remove(a_Chunk);
+	{
+		cCSLock Lock(m_CS);
+		cChunkCoordsList::iterator itr = std::find(m_SaveQueue.begin(), m_SaveQueue.end(), a_Chunk);
+		if (itr == m_SaveQueue.end())
+		{
+			return;
+		}
+		m_SaveQueue.erase(itr);
+	}
+	m_evtRemoved.Set();
 }
 
 
@@ -234,24 +325,31 @@ void cWorldStorage::InitSchemas(int a_StorageCompressionFactor)
 
 
 
-void cWorldStorage::Execute(void)
+bool cWorldStorage::GetNextJob(sJob & a_Job)
 {
-	while (!m_ShouldTerminate)
+	cCSLock Lock(m_CS);
+	for (;;)
 	{
-		m_Event.Wait();
-		// Process both queues until they are empty again:
-		bool Success;
-		do
+		if (m_ShouldTerminate)
 		{
-			Success = false;
-			if (m_ShouldTerminate)
+			// Pass the termination request on to the next worker:
+			m_Event.Set();
+			return false;
+		}
+		
+		if (TakeNextJob(a_Job))
+		{
+			if (!m_LoadQueue.empty() || !m_SaveQueue.empty())
 			{
-				return;
+				// There are more jobs, wake up another worker to try them:
+				m_Event.Set();
 			}
-			
-			Success = LoadOneChunk();
-			Success |= SaveOneChunk();
-		} while (Success);
+			return true;
+		}
+		
+		// Nothing that could be processed now, wait for more jobs or for a conflicting job to finish:
+		cCSUnlock Unlock(Lock);
+		m_Event.Wait();
 	}
 }
 
@@ -259,50 +357,158 @@ void cWorldStorage::Execute(void)
 
 
 
-bool cWorldStorage::LoadOneChunk(void)
+bool cWorldStorage::TakeNextJob(sJob & a_Job)
 {
-	sChunkLoad ToLoad(0, 0, 0, false);
-	bool ShouldLoad = m_LoadQueue.TryDequeueItem(ToLoad);
-	if (ShouldLoad && !LoadChunk(ToLoad.m_ChunkX, ToLoad.m_ChunkY, ToLoad.m_ChunkZ))
+	ASSERT(m_CS.IsLocked());
+	
+	// Loads go first, a player may be waiting for them:
+	for (sChunkLoadList::iterator itr = m_LoadQueue.begin(), end = m_LoadQueue.end(); itr != end; ++itr)
 	{
-		if (ToLoad.m_Generate)
+		cChunkCoords Coords(itr->m_ChunkX, ZERO_CHUNK_Y, itr->m_ChunkZ);
+		if (m_InProgress.find(Coords) != m_InProgress.end())
 		{
-			// The chunk couldn't be loaded, generate it:
-			m_World->GetGenerator().QueueGenerateChunk(ToLoad.m_ChunkX, ToLoad.m_ChunkY, ToLoad.m_ChunkZ);
+			continue;
 		}
-		else
+		a_Job.m_Type = sJob::jobLoad;
+		a_Job.m_ChunkX = itr->m_ChunkX;
+		a_Job.m_ChunkY = itr->m_ChunkY;
+		a_Job.m_ChunkZ = itr->m_ChunkZ;
+		a_Job.m_Generate = itr->m_Generate;
+		m_LoadQueue.erase(itr);
+		m_InProgress.insert(Coords);
+		m_NumLoadsInProgress += 1;
+		return true;
+	}
+	
+	// Saves, only if there aren't too many in flight already:
+	if (m_NumSavesInProgress >= m_MaxSavesInProgress)
+	{
+		return false;
+	}
+	for (cChunkCoordsList::iterator itr = m_SaveQueue.begin(), end = m_SaveQueue.end(); itr != end; ++itr)
+	{
+		if (itr->m_ChunkY == CHUNK_Y_MESSAGE)
 		{
-			// TODO: Notify the world that the load has failed:
-			// m_World->ChunkLoadFailed(ToLoad.m_ChunkX, ToLoad.m_ChunkY, ToLoad.m_ChunkZ);
+			// The message may only be output once all the saves queued before it have finished;
+			// the saves queued after it need to wait for the message, too:
+			if (m_NumSavesInProgress > 0)
+			{
+				return false;
+			}
+			a_Job.m_Type = sJob::jobSavedMessage;
+			m_SaveQueue.erase(itr);
+			m_NumSavesInProgress += 1;
+			return true;
+		}
+		cChunkCoords Coords(itr->m_ChunkX, ZERO_CHUNK_Y, itr->m_ChunkZ);
+		if (m_InProgress.find(Coords) != m_InProgress.end())
+		{
+			continue;
 		}
+		a_Job.m_Type = sJob::jobSave;
+		a_Job.m_ChunkX = itr->m_ChunkX;
+		a_Job.m_ChunkY = itr->m_ChunkY;
+		a_Job.m_ChunkZ = itr->m_ChunkZ;
+		a_Job.m_Generate = false;
+		m_SaveQueue.erase(itr);
+		m_InProgress.insert(Coords);
+		m_NumSavesInProgress += 1;
+		return true;
 	}
-	return ShouldLoad;
+	return false;
 }
 
 
 
 
 
-bool cWorldStorage::SaveOneChunk(void)
+void cWorldStorage::ProcessJob(const sJob & a_Job)
 {
-	cChunkCoords ToSave(0, 0, 0);
-	bool ShouldSave = m_SaveQueue.TryDequeueItem(ToSave);
-	if(ShouldSave) {
-		if (ToSave.m_ChunkY == CHUNK_Y_MESSAGE)
+	switch (a_Job.m_Type)
+	{
+		case sJob::jobLoad:
+		{
+			if (!LoadChunk(a_Job.m_ChunkX, a_Job.m_ChunkY, a_Job.m_ChunkZ))
+			{
+				if (a_Job.m_Generate)
+				{
+					// The chunk couldn't be loaded, generate it:
+					m_World->GetGenerator().QueueGenerateChunk(a_Job.m_ChunkX, a_Job.m_ChunkY, a_Job.m_ChunkZ);
+				}
+				else
+				{
+					// TODO: Notify the world that the load has failed:
+					// m_World->ChunkLoadFailed(a_Job.m_ChunkX, a_Job.m_ChunkY, a_Job.m_ChunkZ);
+				}
+			}
+			break;
+		}
+		
+		case sJob::jobSave:
+		{
+			SaveChunk(cChunkCoords(a_Job.m_ChunkX, a_Job.m_ChunkY, a_Job.m_ChunkZ));
+			break;
+		}
+		
+		case sJob::jobSavedMessage:
 		{
 			LOGINFO("Saved all chunks in world %s", m_World->GetName().c_str());
-			return ShouldSave;
+			m_SaveSchema->LogStats();
+			break;
 		}
-		if (ShouldSave && m_World->IsChunkValid(ToSave.m_ChunkX, ToSave.m_ChunkZ))
+	}
+}
+
+
+
+
+
+void cWorldStorage::JobFinished(const sJob & a_Job)
+{
+	{
+		cCSLock Lock(m_CS);
+		switch (a_Job.m_Type)
 		{
-			m_World->MarkChunkSaving(ToSave.m_ChunkX, ToSave.m_ChunkZ);
-			if (m_SaveSchema->SaveChunk(ToSave))
+			case sJob::jobLoad:
 			{
-				m_World->MarkChunkSaved(ToSave.m_ChunkX, ToSave.m_ChunkZ);
+				m_InProgress.erase(cChunkCoords(a_Job.m_ChunkX, ZERO_CHUNK_Y, a_Job.m_ChunkZ));
+				m_NumLoadsInProgress -= 1;
+				break;
+			}
+			case sJob::jobSave:
+			{
+				m_InProgress.erase(cChunkCoords(a_Job.m_ChunkX, ZERO_CHUNK_Y, a_Job.m_ChunkZ));
+				m_NumSavesInProgress -= 1;
+				break;
+			}
+			case sJob::jobSavedMessage:
+			{
+				m_NumSavesInProgress -= 1;
+				break;
 			}
 		}
 	}
-	return ShouldSave;
+	m_evtRemoved.Set();
+	
+	// Some of the queued jobs may have been waiting for this one to finish:
+	m_Event.Set();
+}
+
+
+
+
+
+void cWorldStorage::SaveChunk(const cChunkCoords & a_Chunk)
+{
+	if (!m_World->IsChunkValid(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ))
+	{
+		return;
+	}
+	m_World->MarkChunkSaving(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+	if (m_SaveSchema->SaveChunk(a_Chunk))
+	{
+		m_World->MarkChunkSaved(a_Chunk.m_ChunkX, a_Chunk.m_ChunkZ);
+	}
 }
 
 
@@ -344,3 +550,29 @@ bool cWorldStorage::LoadChunk(int a_ChunkX, int a_ChunkY, int a_ChunkZ)
 
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cWorldStorage::cWorker:
+
+cWorldStorage::cWorker::cWorker(cWorldStorage & a_Parent) :
+	super("cWorldStorage::cWorker"),
+	m_Parent(a_Parent)
+{
+}
+
+
+
+
+
+void cWorldStorage::cWorker::Execute(void)
+{
+	sJob Job;
+	while (m_Parent.GetNextJob(Job))
+	{
+		m_Parent.ProcessJob(Job);
+		m_Parent.JobFinished(Job);
+	}
+}
+
+
+
+
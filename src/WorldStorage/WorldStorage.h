@@ -1,7 +1,7 @@
 
 // WorldStorage.h
 
-// Interfaces to the cWorldStorage class representing the chunk loading / saving thread
+// Interfaces to the cWorldStorage class representing the chunk loading / saving threads
 // This class decides which storage schema to use for saving; it queries all available schemas for loading
 // Also declares the base class for all storage schemas, cWSSchema
 // Helper serialization class cJsonChunkSerializer is declared as well
@@ -16,7 +16,6 @@
 
 #include "../ChunkDef.h"
 #include "../OSSupport/IsThread.h"
-#include "../OSSupport/Queue.h"
 
 
 
@@ -25,8 +24,6 @@
 // fwd:
 class cWorld;
 
-typedef cQueue<cChunkCoords> cChunkCoordsQueue;
-
 
 
 
@@ -42,6 +39,9 @@ public:
 	virtual bool SaveChunk(const cChunkCoords & a_Chunk) = 0;
 	virtual const AString GetName(void) const = 0;
 	
+	/** Logs the schema's I/O statistics gathered since the last call, if any. Called after all chunks have been saved. */
+	virtual void LogStats(void) {}
+	
 protected:
 
 	cWorld * m_World;
@@ -53,12 +53,13 @@ typedef std::list<cWSSchema *> cWSSchemaList;
 
 
 
-/// The actual world storage class
-class cWorldStorage :
-	public cIsThread
+/** The actual world storage class.
+Loads and saves the chunks on a pool of worker threads. Loads have priority over saves, and only a limited number
+of workers may be saving at any time, so that a long save (such as SaveAllChunks()) doesn't hold up loading
+chunks for the players. Each chunk is processed by at most one worker at a time.
+*/
+class cWorldStorage
 {
-	typedef cIsThread super;
-	
 public:
 
 	cWorldStorage(void);
@@ -76,15 +77,30 @@ public:
 	void UnqueueLoad(int a_ChunkX, int a_ChunkY, int a_ChunkZ);
 	void UnqueueSave(const cChunkCoords & a_Chunk);
 	
-	bool Start(cWorld * a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor);  // Hide the cIsThread's Start() method, we need to provide args
-	void Stop(void);  // Hide the cIsThread's Stop() method, we need to signal the event
+	/** Initializes the schemas and starts the worker threads.
+	a_NumThreads is the number of the workers; all but one of them may be saving at the same time (but at least one). */
+	bool Start(cWorld * a_World, const AString & a_StorageSchemaName, int a_StorageCompressionFactor, int a_NumThreads);
+	
+	void Stop(void);  // Same as WaitForFinish()
+	
+	/** Drops the queued loads, waits for the queued saves to finish and then stops the workers */
 	void WaitForFinish(void);
+	
+	/** Waits until all the queued loads have finished (including those being processed right now) */
 	void WaitForLoadQueueEmpty(void);
+	
+	/** Waits until all the queued saves have finished (including those being processed right now) */
 	void WaitForSaveQueueEmpty(void);
 	
+	/** Returns the number of chunks queued for loading, including those being loaded right now */
 	size_t GetLoadQueueLength(void);
+	
+	/** Returns the number of chunks queued for saving, including those being saved right now */
 	size_t GetSaveQueueLength(void);
 	
+	/** Returns the number of the worker threads */
+	int GetNumThreads(void) const { return (int)m_Workers.size(); }
+	
 protected:
 
 	struct sChunkLoad
@@ -103,22 +119,71 @@ protected:
 				this->m_ChunkZ == other.m_ChunkZ;
 		}
 	} ;
-
-	struct FuncTable {
-		static void Delete(sChunkLoad) {};
-		static void Combine(sChunkLoad& a_orig, const sChunkLoad a_new) 
+	
+	typedef std::list<sChunkLoad> sChunkLoadList;
+	
+	/** A single piece of work for a worker thread */
+	struct sJob
+	{
+		enum eType
 		{
-			a_orig.m_Generate |= a_new.m_Generate;
-		};
-	};
-
-	typedef cQueue<sChunkLoad,FuncTable> sChunkLoadQueue;
+			jobLoad,
+			jobSave,
+			jobSavedMessage,  // Output the "saved all chunks" message
+		} ;
+		
+		eType m_Type;
+		int   m_ChunkX;
+		int   m_ChunkY;
+		int   m_ChunkZ;
+		bool  m_Generate;  // For jobLoad only: the chunk will be generated if it cannot be loaded
+	} ;
+	
+	/** A single worker thread, processing the jobs from the parent's queues */
+	class cWorker :
+		public cIsThread
+	{
+		typedef cIsThread super;
+		
+	public:
+		cWorker(cWorldStorage & a_Parent);
+		
+	protected:
+		cWorldStorage & m_Parent;
+		
+		// cIsThread override:
+		virtual void Execute(void) override;
+	} ;
+	
+	typedef std::vector<cWorker *> cWorkers;
+	
 	
 	cWorld * m_World;
 	AString  m_StorageSchemaName;
-
-	sChunkLoadQueue  m_LoadQueue;
-	cChunkCoordsQueue m_SaveQueue;
+	
+	/** Protects the queues and the in-progress bookkeeping below */
+	cCriticalSection m_CS;
+	
+	sChunkLoadList   m_LoadQueue;
+	cChunkCoordsList m_SaveQueue;
+	
+	/** Coords of the chunks being loaded or saved by the workers right now. Protected by m_CS */
+	cChunkCoordsSet m_InProgress;
+	
+	/** Number of loads / saves being processed by the workers right now. Protected by m_CS */
+	int m_NumLoadsInProgress;
+	int m_NumSavesInProgress;
+	
+	/** Maximum number of saves that may be processed at the same time, so that there are always workers left for loading */
+	int m_MaxSavesInProgress;
+	
+	/** Set when the workers should terminate. Protected by m_CS */
+	bool m_ShouldTerminate;
+	
+	cEvent m_Event;       ///< Set when there's any addition to the queues, a job finishes, or the workers should terminate
+	cEvent m_evtRemoved;  ///< Set when a job finishes or is removed from the queues
+	
+	cWorkers m_Workers;
 	
 	/// All the storage schemas (all used for loading)
 	cWSSchemaList m_Schemas;
@@ -128,15 +193,22 @@ protected:
 	
 	void InitSchemas(int a_StorageCompressionFactor);
 	
-	virtual void Execute(void) override;
+	/** Waits for the next job and returns it in a_Job; loads are preferred to saves.
+	Returns false if the workers should terminate. Called from within the worker threads. */
+	bool GetNextJob(sJob & a_Job);
 	
-	cEvent m_Event;       // Set when there's any addition to the queues
-
-	/// Loads one chunk from the queue (if any queued); returns true if there are more chunks in the load queue
-	bool LoadOneChunk(void);
+	/** Takes the next job that can be processed right now out of the queues and marks it as in progress.
+	Returns false if there's no such job. Assumes m_CS is locked. */
+	bool TakeNextJob(sJob & a_Job);
+	
+	/** Processes the specified job. Called from within the worker threads. */
+	void ProcessJob(const sJob & a_Job);
+	
+	/** Marks the job as no longer in progress. Called from within the worker threads. */
+	void JobFinished(const sJob & a_Job);
 	
-	/// Saves one chunk from the queue (if any queued); returns true if there are more chunks in the save queue
-	bool SaveOneChunk(void);
+	/** Saves the specified chunk, if it is still loaded */
+	void SaveChunk(const cChunkCoords & a_Chunk);
 } ;
 
 
@@ -0,0 +1,254 @@
+
+// AESBenchmark.cpp
+
+// Implements the main app entrypoint of the AES-CFB8 benchmark
+
+/*
+Compares the protocol encryption implementations in cAESCFB8 against the original code, which called PolarSSL's
+aes_crypt_ecb() once per byte and shifted the IV by a scalar loop:
+	- first checks that each implementation produces ciphertext identical to the original code's, and that it
+	decrypts it back, with the data split into chunks of various sizes (as the protocol does)
+	- then measures the encryption and decryption throughput of the original code and of each implementation
+	supported by the CPU, processing the data in 8 KiB chunks like cProtocol172::SendData()
+
+Usage:
+	AESBenchmark [NumMiB]
+*/
+
+#include "Globals.h"
+#include <time.h>
+#include "AESCFB8.h"
+#include "polarssl/aes.h"
+
+
+
+
+
+/** Size of the chunks the data is processed in, same as the buffer in cProtocol172::SendData() */
+static const size_t CHUNK_SIZE = 8192;
+
+
+
+
+
+/** The original code from cAESCFBEncryptor / cAESCFBDecryptor::ProcessData(), for reference */
+class cReferenceCFB8
+{
+public:
+	void Init(const Byte a_Key[16], const Byte a_IV[16])
+	{
+		memcpy(m_IV, a_IV, 16);
+		aes_setkey_enc(&m_Aes, a_Key, 128);
+	}
+
+	void Encrypt(Byte * a_EncryptedOut, const Byte * a_PlainIn, size_t a_Length)
+	{
+		for (size_t i = 0; i < a_Length; i++)
+		{
+			Byte Buffer[sizeof(m_IV)];
+			aes_crypt_ecb(&m_Aes, AES_ENCRYPT, m_IV, Buffer);
+			for (size_t idx = 0; idx < sizeof(m_IV) - 1; idx++)
+			{
+				m_IV[idx] = m_IV[idx + 1];
+			}
+			a_EncryptedOut[i] = a_PlainIn[i] ^ Buffer[0];
+			m_IV[sizeof(m_IV) - 1] = a_EncryptedOut[i];
+		}
+	}
+
+	void Decrypt(Byte * a_DecryptedOut, const Byte * a_EncryptedIn, size_t a_Length)
+	{
+		for (size_t i = 0; i < a_Length; i++)
+		{
+			Byte Buffer[sizeof(m_IV)];
+			aes_crypt_ecb(&m_Aes, AES_ENCRYPT, m_IV, Buffer);
+			for (size_t idx = 0; idx < sizeof(m_IV) - 1; idx++)
+			{
+				m_IV[idx] = m_IV[idx + 1];
+			}
+			m_IV[sizeof(m_IV) - 1] = a_EncryptedIn[i];
+			a_DecryptedOut[i] = a_EncryptedIn[i] ^ Buffer[0];
+		}
+	}
+
+protected:
+	aes_context m_Aes;
+	Byte m_IV[16];
+} ;
+
+
+
+
+
+static const Byte g_Key[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+
+
+
+
+
+/** Fills the buffer with pseudo-random data */
+static void FillRandom(std::vector<Byte> & a_Data)
+{
+	UInt32 Seed = 0x12345678;
+	for (size_t i = 0; i < a_Data.size(); i++)
+	{
+		Seed = Seed * 1103515245 + 12345;
+		a_Data[i] = (Byte)(Seed >> 16);
+	}
+}
+
+
+
+
+
+/** Processes the data by the cipher in chunks of varying sizes, to exercise the IV carry-over between the calls */
+template <class Cipher>
+static void ProcessVarying(Cipher & a_Cipher, bool a_Encrypt, const std::vector<Byte> & a_In, std::vector<Byte> & a_Out)
+{
+	static const size_t ChunkSizes[] = {1, 2, 3, 15, 16, 17, 31, 100, 512, 4096, 5};
+	a_Out.resize(a_In.size());
+	size_t Pos = 0;
+	for (int i = 0; Pos < a_In.size(); i++)
+	{
+		size_t Size = std::min(ChunkSizes[i % ARRAYCOUNT(ChunkSizes)], a_In.size() - Pos);
+		if (a_Encrypt)
+		{
+			a_Cipher.Encrypt(&a_Out[Pos], &a_In[Pos], Size);
+		}
+		else
+		{
+			a_Cipher.Decrypt(&a_Out[Pos], &a_In[Pos], Size);
+		}
+		Pos += Size;
+	}
+}
+
+
+
+
+
+/** Processes the data by the cipher in CHUNK_SIZE chunks; returns the time it took, in seconds */
+template <class Cipher>
+static double Measure(Cipher & a_Cipher, bool a_Encrypt, const std::vector<Byte> & a_In, std::vector<Byte> & a_Out)
+{
+	a_Out.resize(a_In.size());
+	clock_t Begin = clock();
+	for (size_t Pos = 0; Pos < a_In.size(); Pos += CHUNK_SIZE)
+	{
+		size_t Size = std::min(CHUNK_SIZE, a_In.size() - Pos);
+		if (a_Encrypt)
+		{
+			a_Cipher.Encrypt(&a_Out[Pos], &a_In[Pos], Size);
+		}
+		else
+		{
+			a_Cipher.Decrypt(&a_Out[Pos], &a_In[Pos], Size);
+		}
+	}
+	return (double)(clock() - Begin) / CLOCKS_PER_SEC;
+}
+
+
+
+
+
+/** Checks that the implementation produces the same ciphertext as the reference and decrypts it back.
+Returns true if OK. */
+static bool VerifyImpl(cAESCFB8::eImpl a_Impl, const std::vector<Byte> & a_Plain, const std::vector<Byte> & a_RefEncrypted)
+{
+	cAESCFB8::SetImpl(a_Impl);
+	std::vector<Byte> Encrypted, Decrypted;
+	cAESCFB8 Encryptor, Decryptor;
+	Encryptor.Init(g_Key, g_Key);
+	Decryptor.Init(g_Key, g_Key);
+	ProcessVarying(Encryptor, true, a_Plain, Encrypted);
+	ProcessVarying(Decryptor, false, Encrypted, Decrypted);
+	if (Encrypted != a_RefEncrypted)
+	{
+		size_t Idx = std::mismatch(Encrypted.begin(), Encrypted.end(), a_RefEncrypted.begin()).first - Encrypted.begin();
+		printf("FAILED: %s encryption differs from the original code at byte %u\n", cAESCFB8::GetImplName(a_Impl), (unsigned)Idx);
+		return false;
+	}
+	if (Decrypted != a_Plain)
+	{
+		printf("FAILED: %s decryption doesn't produce the original data\n", cAESCFB8::GetImplName(a_Impl));
+		return false;
+	}
+	printf("%s: output identical to the original code\n", cAESCFB8::GetImplName(a_Impl));
+	return true;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	int NumMiB = (argc > 1) ? atoi(argv[1]) : 4;
+	if (NumMiB <= 0)
+	{
+		NumMiB = 4;
+	}
+
+	// Verify the implementations against the original code, on a smaller buffer:
+	std::vector<Byte> Plain(256 * 1024 + 7);
+	FillRandom(Plain);
+	std::vector<Byte> RefEncrypted;
+	{
+		cReferenceCFB8 Ref;
+		Ref.Init(g_Key, g_Key);
+		ProcessVarying(Ref, true, Plain, RefEncrypted);
+	}
+	bool IsOK = true;
+	for (int i = cAESCFB8::implPortable; i <= cAESCFB8::implAESNI; i++)
+	{
+		cAESCFB8::eImpl Impl = (cAESCFB8::eImpl)i;
+		if (!cAESCFB8::IsImplSupported(Impl))
+		{
+			printf("%s: not supported on this CPU / compiler, skipped\n", cAESCFB8::GetImplName(Impl));
+			continue;
+		}
+		IsOK = VerifyImpl(Impl, Plain, RefEncrypted) && IsOK;
+	}
+	if (!IsOK)
+	{
+		return 1;
+	}
+
+	// Measure the throughput:
+	Plain.resize((size_t)NumMiB * 1024 * 1024);
+	FillRandom(Plain);
+	std::vector<Byte> Encrypted, Decrypted;
+	printf("\nProcessing %d MiB in %u-byte chunks:\n", NumMiB, (unsigned)CHUNK_SIZE);
+	printf("  %-20s %12s %12s\n", "Implementation", "Encrypt", "Decrypt");
+	double RefEncTime, RefDecTime;
+	{
+		cReferenceCFB8 Encryptor, Decryptor;
+		Encryptor.Init(g_Key, g_Key);
+		Decryptor.Init(g_Key, g_Key);
+		RefEncTime = Measure(Encryptor, true, Plain, Encrypted);
+		RefDecTime = Measure(Decryptor, false, Encrypted, Decrypted);
+		printf("  %-20s %7.1f MiB/s %7.1f MiB/s\n", "original (PolarSSL)", NumMiB / RefEncTime, NumMiB / RefDecTime);
+	}
+	for (int i = cAESCFB8::implPortable; i <= cAESCFB8::implAESNI; i++)
+	{
+		cAESCFB8::eImpl Impl = (cAESCFB8::eImpl)i;
+		if (!cAESCFB8::SetImpl(Impl))
+		{
+			continue;
+		}
+		cAESCFB8 Encryptor, Decryptor;
+		Encryptor.Init(g_Key, g_Key);
+		Decryptor.Init(g_Key, g_Key);
+		double EncTime = Measure(Encryptor, true, Plain, Encrypted);
+		double DecTime = Measure(Decryptor, false, Encrypted, Decrypted);
+		printf("  %-20s %7.1f MiB/s %7.1f MiB/s   (%.1fx / %.1fx the original)\n",
+			cAESCFB8::GetImplName(Impl), NumMiB / EncTime, NumMiB / DecTime, RefEncTime / EncTime, RefDecTime / DecTime
+		);
+	}
+	return 0;
+}
+
+
+
+
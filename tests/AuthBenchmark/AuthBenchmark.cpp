@@ -0,0 +1,434 @@
+// AuthBenchmark.cpp
+
+// Implements the main app entrypoint of the authentication latency benchmark
+
+/*
+Runs a local stand-in for the auth server and measures how long the logins take to get authenticated by cAuthenticator
+when a burst of users connects at once (such as after a server restart):
+	- the stand-in answers "YES" to each checkserver request after a random delay; the delays have a long tail, like the
+	real auth server's, a base time plus an exponentially distributed part
+	- the burst is authenticated with different numbers of authenticator threads, the latency of each login (from the
+	Authenticate() call until the result) is measured and its distribution printed
+
+Usage:
+	AuthBenchmark [NumUsers] [BaseDelayMSec] [MeanExtraDelayMSec]
+	AuthBenchmark serve [Port] [BaseDelayMSec] [MeanExtraDelayMSec]
+The "serve" variant only runs the stand-in endpoint, so that a server can be tested against it by setting
+[Authentication] Server=127.0.0.1:<Port> in its settings.ini
+*/
+
+#include "Globals.h"
+#include <math.h>
+#include "Authenticator.h"
+#include "Root.h"
+#include "OSSupport/Socket.h"
+#include "OSSupport/Sleep.h"
+#include "OSSupport/Timer.h"
+#include "inifile/iniFile.h"
+
+
+
+
+
+/// The port the stand-in auth server listens on, unless specified on the command line
+static const unsigned short DEFAULT_PORT = 25590;
+
+/// Number of threads answering the requests in the stand-in auth server; limits the number of concurrent requests
+static const int NUM_RESPONDERS = 128;
+
+/// The numbers of authenticator threads to measure
+static const int g_NumThreadsToTest[] = {1, 4, 16, 64};
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Stubs for the cRoot functions referenced by cAuthenticator's default result handlers, which the benchmark overrides:
+
+cRoot * cRoot::s_Root = NULL;
+
+void cRoot::AuthenticateUser(int a_ClientID)
+{
+	UNUSED(a_ClientID);
+	ASSERT(!"Not used by the benchmark");
+}
+
+void cRoot::KickUser(int a_ClientID, const AString & a_Reason)
+{
+	UNUSED(a_ClientID);
+	UNUSED(a_Reason);
+	ASSERT(!"Not used by the benchmark");
+}
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cStandInServer:
+
+/** A minimal HTTP server that answers the auth server's checkserver requests with "YES" after a random delay */
+class cStandInServer
+{
+public:
+	cStandInServer(int a_BaseDelayMSec, int a_MeanExtraDelayMSec) :
+		m_BaseDelayMSec(a_BaseDelayMSec),
+		m_MeanExtraDelayMSec(a_MeanExtraDelayMSec),
+		m_ShouldTerminate(false),
+		m_Seed(12345),
+		m_Acceptor(*this)
+	{
+	}
+
+
+	bool Start(unsigned short a_Port)
+	{
+		m_ListenSocket = cSocket::CreateSocket(cSocket::IPv4);
+		if (!m_ListenSocket.IsValid())
+		{
+			LOGERROR("Cannot create the listening socket");
+			return false;
+		}
+		m_ListenSocket.SetReuseAddress();
+		if (!m_ListenSocket.BindToLocalhostIPv4(a_Port) || !m_ListenSocket.Listen(NUM_RESPONDERS))
+		{
+			LOGERROR("Cannot listen on port %u: %s", a_Port, cSocket::GetLastErrorString().c_str());
+			return false;
+		}
+		for (int i = 0; i < NUM_RESPONDERS; i++)
+		{
+			cResponder * Responder = new cResponder(*this);
+			Responder->Start();
+			m_Responders.push_back(Responder);
+		}
+		m_Acceptor.Start();
+		return true;
+	}
+
+
+	void Stop(void)
+	{
+		{
+			cCSLock Lock(m_CS);
+			m_ShouldTerminate = true;
+		}
+		m_ListenSocket.ShutdownReadWrite();
+		m_ListenSocket.CloseSocket();
+		m_Acceptor.Wait();
+		m_evtQueued.Set();
+		for (std::vector<cResponder *>::iterator itr = m_Responders.begin(), end = m_Responders.end(); itr != end; ++itr)
+		{
+			(*itr)->Wait();
+			delete *itr;
+		}
+		m_Responders.clear();
+	}
+
+protected:
+
+	/** Accepts the incoming connections and queues them for the responders */
+	class cAcceptor :
+		public cIsThread
+	{
+	public:
+		cAcceptor(cStandInServer & a_Parent) :
+			cIsThread("cStandInServer::cAcceptor"),
+			m_Parent(a_Parent)
+		{
+		}
+
+	protected:
+		cStandInServer & m_Parent;
+
+		virtual void Execute(void) override
+		{
+			for (;;)
+			{
+				cSocket Client = m_Parent.m_ListenSocket.AcceptIPv4();
+				cCSLock Lock(m_Parent.m_CS);
+				if (m_Parent.m_ShouldTerminate)
+				{
+					return;
+				}
+				if (!Client.IsValid())
+				{
+					continue;
+				}
+				m_Parent.m_Queue.push_back(Client.GetSocket());
+				m_Parent.m_evtQueued.Set();
+			}
+		}
+	} ;
+
+
+	/** Reads a request from a queued connection, waits for the random delay and sends the reply */
+	class cResponder :
+		public cIsThread
+	{
+	public:
+		cResponder(cStandInServer & a_Parent) :
+			cIsThread("cStandInServer::cResponder"),
+			m_Parent(a_Parent)
+		{
+		}
+
+	protected:
+		cStandInServer & m_Parent;
+
+		virtual void Execute(void) override
+		{
+			cSocket::xSocket Socket;
+			int DelayMSec;
+			while (m_Parent.GetNextConnection(Socket, DelayMSec))
+			{
+				cSocket Client(Socket);
+				AString Request;
+				char Buffer[1024];
+				while (Request.find("\r\n\r\n") == AString::npos)
+				{
+					int NumBytes = Client.Receive(Buffer, sizeof(Buffer), 0);
+					if (NumBytes <= 0)
+					{
+						break;
+					}
+					Request.append(Buffer, NumBytes);
+				}
+				cSleep::MilliSleep(DelayMSec);
+				AString Reply = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 3\r\nConnection: close\r\n\r\nYES";
+				Client.Send(Reply.data(), (unsigned int)Reply.size());
+				Client.ShutdownReadWrite();
+				Client.CloseSocket();
+			}
+		}
+	} ;
+
+
+	int m_BaseDelayMSec;
+	int m_MeanExtraDelayMSec;
+
+	cSocket m_ListenSocket;
+
+	/** Protects m_Queue, m_ShouldTerminate and m_Seed */
+	cCriticalSection m_CS;
+	std::deque<cSocket::xSocket> m_Queue;
+	cEvent m_evtQueued;
+	bool m_ShouldTerminate;
+
+	/** The state of the random generator for the delays */
+	unsigned int m_Seed;
+
+	cAcceptor m_Acceptor;
+	std::vector<cResponder *> m_Responders;
+
+
+	/** Waits for a queued connection and picks the delay for its reply. Returns false if the responders are to terminate. */
+	bool GetNextConnection(cSocket::xSocket & a_Socket, int & a_DelayMSec)
+	{
+		cCSLock Lock(m_CS);
+		for (;;)
+		{
+			if (m_ShouldTerminate)
+			{
+				m_evtQueued.Set();
+				return false;
+			}
+			if (!m_Queue.empty())
+			{
+				a_Socket = m_Queue.front();
+				m_Queue.pop_front();
+				if (!m_Queue.empty())
+				{
+					m_evtQueued.Set();
+				}
+				m_Seed = m_Seed * 1103515245 + 12345;
+				double Uniform = ((m_Seed >> 8) + 1) / 16777217.0;
+				a_DelayMSec = m_BaseDelayMSec + (int)(-log(Uniform) * m_MeanExtraDelayMSec);
+				return true;
+			}
+			cCSUnlock Unlock(Lock);
+			m_evtQueued.Wait();
+		}
+	}
+} ;
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// cBenchAuthenticator:
+
+/** The authenticator that records the time of each result instead of passing it on to cRoot */
+class cBenchAuthenticator :
+	public cAuthenticator
+{
+public:
+	cBenchAuthenticator(int a_NumUsers) :
+		m_FinishTimes(a_NumUsers, 0),
+		m_NumFinished(0),
+		m_NumFailed(0)
+	{
+	}
+
+
+	/** Clears the results of the previous burst */
+	void Reset(void)
+	{
+		cCSLock Lock(m_CS);
+		std::fill(m_FinishTimes.begin(), m_FinishTimes.end(), 0);
+		m_NumFinished = 0;
+		m_NumFailed = 0;
+	}
+
+
+	/** Waits until all the users have a result */
+	void WaitForAll(void)
+	{
+		cCSLock Lock(m_CS);
+		while (m_NumFinished < (int)m_FinishTimes.size())
+		{
+			cCSUnlock Unlock(Lock);
+			m_evtFinished.Wait();
+		}
+	}
+
+
+	Int64 GetFinishTime(int a_ClientID) const { return m_FinishTimes[a_ClientID]; }
+
+	int GetNumFailed(void) const { return m_NumFailed; }
+
+	Int64 GetNowUsec(void) { return m_Timer.GetNowTimeUsec(); }
+
+protected:
+	cCriticalSection m_CS;
+	cEvent m_evtFinished;
+	cTimer m_Timer;
+	std::vector<Int64> m_FinishTimes;
+	int m_NumFinished;
+	int m_NumFailed;
+
+
+	void Finished(int a_ClientID, bool a_IsOK)
+	{
+		cCSLock Lock(m_CS);
+		m_FinishTimes[a_ClientID] = m_Timer.GetNowTimeUsec();
+		m_NumFinished += 1;
+		if (!a_IsOK)
+		{
+			m_NumFailed += 1;
+		}
+		if (m_NumFinished == (int)m_FinishTimes.size())
+		{
+			m_evtFinished.Set();
+		}
+	}
+
+
+	virtual void OnAuthSucceeded(int a_ClientID) override
+	{
+		Finished(a_ClientID, true);
+	}
+
+
+	virtual void OnAuthFailed(int a_ClientID) override
+	{
+		Finished(a_ClientID, false);
+	}
+} ;
+
+
+
+
+
+/** Authenticates the burst of users and prints the latency distribution */
+static void MeasureBurst(cBenchAuthenticator & a_Auth, int a_NumUsers, const char * a_Label)
+{
+	a_Auth.Reset();
+	Int64 Start = a_Auth.GetNowUsec();
+	for (int i = 0; i < a_NumUsers; i++)
+	{
+		a_Auth.Authenticate(i, Printf("Player%d", i), Printf("%x", i * 7919 + 1));
+	}
+	a_Auth.WaitForAll();
+	Int64 End = a_Auth.GetNowUsec();
+
+	std::vector<Int64> Latencies;
+	Latencies.reserve(a_NumUsers);
+	for (int i = 0; i < a_NumUsers; i++)
+	{
+		Latencies.push_back(a_Auth.GetFinishTime(i) - Start);
+	}
+	std::sort(Latencies.begin(), Latencies.end());
+	double Avg = 0;
+	for (std::vector<Int64>::const_iterator itr = Latencies.begin(), end = Latencies.end(); itr != end; ++itr)
+	{
+		Avg += (double)*itr;
+	}
+	Avg /= a_NumUsers;
+	printf("%-28s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %7d\n",
+		a_Label,
+		Avg / 1000,
+		(double)Latencies[a_NumUsers / 2] / 1000,
+		(double)Latencies[a_NumUsers * 95 / 100] / 1000,
+		(double)Latencies[a_NumUsers * 99 / 100] / 1000,
+		(double)Latencies.back() / 1000,
+		(double)(End - Start) / 1000,
+		a_Auth.GetNumFailed()
+	);
+}
+
+
+
+
+
+int main(int argc, char ** argv)
+{
+	new cMCLogger();  // Create a logger (will set itself as the main instance)
+
+	bool IsServeOnly = ((argc > 1) && (strcmp(argv[1], "serve") == 0));
+	int ArgOfs = IsServeOnly ? 2 : 1;
+	unsigned short Port = DEFAULT_PORT;
+	if (IsServeOnly && (argc > ArgOfs))
+	{
+		Port = (unsigned short)atoi(argv[ArgOfs++]);
+	}
+	int NumUsers           = (!IsServeOnly && (argc > ArgOfs)) ? std::max(1, atoi(argv[ArgOfs++])) : 200;
+	int BaseDelayMSec      = (argc > ArgOfs) ? atoi(argv[ArgOfs++]) : 50;
+	int MeanExtraDelayMSec = (argc > ArgOfs) ? atoi(argv[ArgOfs++]) : 100;
+
+	cStandInServer Server(BaseDelayMSec, MeanExtraDelayMSec);
+	if (!Server.Start(Port))
+	{
+		return 1;
+	}
+	if (IsServeOnly)
+	{
+		printf("Stand-in auth server listening on 127.0.0.1:%u, reply delay %d msec + exp(%d msec); press Enter to stop\n",
+			Port, BaseDelayMSec, MeanExtraDelayMSec
+		);
+		getchar();
+		Server.Stop();
+		return 0;
+	}
+
+	printf("Authenticating %d users at once, auth server delay %d msec + exp(%d msec)\n", NumUsers, BaseDelayMSec, MeanExtraDelayMSec);
+	printf("%-28s %9s %9s %9s %9s %9s %9s %7s\n", "Latency [msec]", "avg", "median", "95%", "99%", "max", "total", "failed");
+	for (size_t i = 0; i < ARRAYCOUNT(g_NumThreadsToTest); i++)
+	{
+		cIniFile Ini;
+		Ini.SetValue("Authentication", "Server", Printf("127.0.0.1:%u", Port));
+		Ini.SetValueI("Authentication", "NumThreads", g_NumThreadsToTest[i]);
+		cBenchAuthenticator Auth(NumUsers);
+		Auth.Start(Ini);
+		MeasureBurst(Auth, NumUsers, Printf("%d threads", g_NumThreadsToTest[i]).c_str());
+		Auth.Stop();
+	}
+
+	Server.Stop();
+	return 0;
+}
+
+
+
+
@@ -0,0 +1,300 @@
+// NBTBenchmark.cpp
+
+// Implements the main app entrypoint of the chunk load / save microbenchmark
+
+/*
+Measures the decompression + NBT parsing (load) and the NBT writing + compression (save) of chunk data, comparing
+fresh buffers for each chunk (the way cWSSAnvil used to work) with the reusable cChunkNBTBuffers.
+The chunks are read from the .mca file given on the commandline; if none is given, synthetic chunks are used.
+*/
+
+#include "Globals.h"
+#include <time.h>
+#include "WorldStorage/FastNBT.h"
+#include "WorldStorage/ChunkNBTBuffers.h"
+#include "StringCompression.h"
+
+
+
+
+
+/// Number of times the whole set of chunks is loaded / saved in each test
+static const int NUM_ROUNDS = 20;
+
+/// The maximum size of an inflated chunk, same as in cChunkNBTBuffers
+static const int CHUNK_INFLATE_MAX = 256 KiB;
+
+
+
+
+
+/** Writes a chunk resembling the real Anvil chunks: 16 sections of terrain-like blocks and light, biomes, empty entity lists */
+void WriteSyntheticChunk(cFastNBTWriter & a_Writer, int a_ChunkX, int a_ChunkZ)
+{
+	char Blocks[4096], Nibbles[2048], Biomes[256];
+	a_Writer.BeginCompound("Level");
+	a_Writer.AddInt("xPos", a_ChunkX);
+	a_Writer.AddInt("zPos", a_ChunkZ);
+	a_Writer.BeginList("Sections", TAG_Compound);
+	for (int Section = 0; Section < 16; Section++)
+	{
+		for (int i = 0; i < 4096; i++)
+		{
+			int y = Section * 16 + i / 256;
+			int Height = 60 + ((i * 7 + a_ChunkX * 13 + a_ChunkZ * 17) % 11);
+			Blocks[i] = (y < Height - 4) ? 1 : ((y < Height) ? 3 : 0);
+			if ((Blocks[i] == 1) && (((i * 31 + Section * 7) % 97) == 0))
+			{
+				Blocks[i] = 16;  // Some ore, to make the data less uniform
+			}
+		}
+		memset(Nibbles, (Section < 4) ? 0 : 0xff, sizeof(Nibbles));
+		a_Writer.BeginCompound("");
+		a_Writer.AddByte("Y", (unsigned char)Section);
+		a_Writer.AddByteArray("Blocks", Blocks, sizeof(Blocks));
+		a_Writer.AddByteArray("Data", Nibbles, sizeof(Nibbles));
+		a_Writer.AddByteArray("SkyLight", Nibbles, sizeof(Nibbles));
+		a_Writer.AddByteArray("BlockLight", Nibbles, sizeof(Nibbles));
+		a_Writer.EndCompound();
+	}
+	a_Writer.EndList();
+	for (int i = 0; i < 256; i++)
+	{
+		Biomes[i] = (char)((i / 37 + a_ChunkX) % 5);
+	}
+	a_Writer.AddByteArray("Biomes", Biomes, sizeof(Biomes));
+	a_Writer.BeginList("Entities", TAG_Compound);
+	a_Writer.EndList();
+	a_Writer.BeginList("TileEntities", TAG_Compound);
+	a_Writer.EndList();
+	a_Writer.EndCompound();
+}
+
+
+
+
+
+/** Fills a_Chunks with synthetic compressed chunk data */
+void CreateSyntheticChunks(AStringVector & a_Chunks)
+{
+	for (int z = 0; z < 16; z++)
+	{
+		for (int x = 0; x < 16; x++)
+		{
+			cFastNBTWriter Writer;
+			WriteSyntheticChunk(Writer, x, z);
+			Writer.Finish();
+			AString Compressed;
+			CompressString(Writer.GetResult().data(), Writer.GetResult().size(), Compressed, 6);
+			a_Chunks.push_back(Compressed);
+		}
+	}
+}
+
+
+
+
+
+/** Reads all the chunks' compressed data from the specified MCA file into a_Chunks. Returns false on failure. */
+bool ReadMCAChunks(const AString & a_FileName, AStringVector & a_Chunks)
+{
+	AString Data = cFile::ReadWholeFile(a_FileName);
+	if (Data.size() < 8192)
+	{
+		LOGWARNING("Cannot read MCA file %s", a_FileName.c_str());
+		return false;
+	}
+	for (int i = 0; i < 1024; i++)
+	{
+		size_t Offset = ((size_t)GetBEInt(Data.data() + 4 * i) >> 8) * 4096;
+		if ((Offset == 0) || (Offset + 5 > Data.size()))
+		{
+			continue;
+		}
+		int Size = GetBEInt(Data.data() + Offset) - 1;
+		if ((Size <= 0) || (Data[Offset + 4] != 2) || (Offset + 5 + (size_t)Size > Data.size()))
+		{
+			continue;
+		}
+		a_Chunks.push_back(Data.substr(Offset + 5, (size_t)Size));
+	}
+	return !a_Chunks.empty();
+}
+
+
+
+
+
+/** Loads the chunks using fresh buffers and zlib stream for each chunk. Returns the number of tags parsed. */
+int LoadFresh(const AStringVector & a_Chunks)
+{
+	int NumTags = 0;
+	for (AStringVector::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		AString Compressed(*itr);  // The storage used to read each chunk into a new string
+		std::vector<char> Uncompressed(CHUNK_INFLATE_MAX);
+		z_stream strm;
+		memset(&strm, 0, sizeof(strm));
+		inflateInit(&strm);
+		strm.next_out  = (Bytef *)&Uncompressed[0];
+		strm.avail_out = (uInt)Uncompressed.size();
+		strm.next_in   = (Bytef *)Compressed.data();
+		strm.avail_in  = (uInt)Compressed.size();
+		int res = inflate(&strm, Z_FINISH);
+		inflateEnd(&strm);
+		if (res != Z_STREAM_END)
+		{
+			continue;
+		}
+		cParsedNBT NBT(&Uncompressed[0], (int)strm.total_out);
+		if (NBT.IsValid())
+		{
+			NumTags += NBT.FindChildByName(0, "Level");
+		}
+	}
+	return NumTags;
+}
+
+
+
+
+
+/** Loads the chunks using the reusable buffers. Returns the number of tags parsed. */
+int LoadPooled(const AStringVector & a_Chunks, cChunkNBTBuffers & a_Buffers)
+{
+	int NumTags = 0;
+	for (AStringVector::const_iterator itr = a_Chunks.begin(), end = a_Chunks.end(); itr != end; ++itr)
+	{
+		a_Buffers.GetCompressedIn().assign(itr->data(), itr->size());
+		const cParsedNBT * NBT = a_Buffers.ParseCompressed();
+		if (NBT != NULL)
+		{
+			NumTags += NBT->FindChildByName(0, "Level");
+		}
+	}
+	return NumTags;
+}
+
+
+
+
+
+/** Saves a_NumChunks synthetic chunks using a fresh writer and compression for each chunk. Returns the total compressed size. */
+size_t SaveFresh(int a_NumChunks)
+{
+	size_t Total = 0;
+	for (int i = 0; i < a_NumChunks; i++)
+	{
+		cFastNBTWriter Writer;
+		WriteSyntheticChunk(Writer, i % 16, i / 16);
+		Writer.Finish();
+		AString Compressed;
+		CompressString(Writer.GetResult().data(), Writer.GetResult().size(), Compressed, 6);
+		Total += Compressed.size();
+	}
+	return Total;
+}
+
+
+
+
+
+/** Saves a_NumChunks synthetic chunks using the reusable buffers. Returns the total compressed size. */
+size_t SavePooled(int a_NumChunks, cChunkNBTBuffers & a_Buffers)
+{
+	size_t Total = 0;
+	for (int i = 0; i < a_NumChunks; i++)
+	{
+		WriteSyntheticChunk(a_Buffers.StartWriting(), i % 16, i / 16);
+		const AString * Compressed = a_Buffers.FinishWriting();
+		if (Compressed != NULL)
+		{
+			Total += Compressed->size();
+		}
+	}
+	return Total;
+}
+
+
+
+
+
+/** Returns the time per chunk, in microseconds, for the specified number of ticks spent on the specified number of chunks */
+double UsecPerChunk(clock_t a_Ticks, size_t a_NumChunks)
+{
+	return (double)a_Ticks * 1000000 / CLOCKS_PER_SEC / (double)a_NumChunks;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	new cMCLogger;  // Create a logger (will set itself as the main instance)
+	
+	AStringVector Chunks;
+	if (argc > 1)
+	{
+		if (!ReadMCAChunks(argv[1], Chunks))
+		{
+			return 1;
+		}
+		LOG("Read %u chunks from %s", (unsigned)Chunks.size(), argv[1]);
+	}
+	else
+	{
+		CreateSyntheticChunks(Chunks);
+		LOG("Created %u synthetic chunks", (unsigned)Chunks.size());
+	}
+	size_t NumLoads = Chunks.size() * NUM_ROUNDS;
+	cChunkNBTBuffers Buffers(6);
+	
+	// Loading:
+	clock_t Begin = clock();
+	int TagsFresh = 0;
+	for (int i = 0; i < NUM_ROUNDS; i++)
+	{
+		TagsFresh += LoadFresh(Chunks);
+	}
+	clock_t TicksFresh = clock() - Begin;
+	
+	Begin = clock();
+	int TagsPooled = 0;
+	for (int i = 0; i < NUM_ROUNDS; i++)
+	{
+		TagsPooled += LoadPooled(Chunks, Buffers);
+	}
+	clock_t TicksPooled = clock() - Begin;
+	
+	if (TagsFresh != TagsPooled)
+	{
+		LOGERROR("Loading with fresh and pooled buffers produced different results!");
+		return 1;
+	}
+	LOG("Load, fresh buffers:  %.1f usec per chunk", UsecPerChunk(TicksFresh, NumLoads));
+	LOG("Load, pooled buffers: %.1f usec per chunk", UsecPerChunk(TicksPooled, NumLoads));
+	
+	// Saving:
+	int NumSaves = 256 * NUM_ROUNDS;
+	Begin = clock();
+	size_t SizeFresh = SaveFresh(NumSaves);
+	TicksFresh = clock() - Begin;
+	Begin = clock();
+	size_t SizePooled = SavePooled(NumSaves, Buffers);
+	TicksPooled = clock() - Begin;
+	
+	if (SizeFresh != SizePooled)
+	{
+		LOGERROR("Saving with fresh and pooled buffers produced different results!");
+		return 1;
+	}
+	LOG("Save, fresh buffers:  %.1f usec per chunk", UsecPerChunk(TicksFresh, (size_t)NumSaves));
+	LOG("Save, pooled buffers: %.1f usec per chunk", UsecPerChunk(TicksPooled, (size_t)NumSaves));
+	
+	return 0;
+}
+
+
+
+
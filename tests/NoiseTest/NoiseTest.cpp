@@ -6,6 +6,7 @@
 #include "Globals.h"
 #include <time.h>
 #include "Noise.h"
+#include "NoiseKernels.h"
 
 
 
@@ -89,13 +90,115 @@ clock_t TestOldNoise(void)
 
 
 
+/// Generates a set of noise arrays into a_Values using the currently selected cNoiseKernels implementation
+void GenerateKernelTestValues(std::vector<NOISE_DATATYPE> & a_Values)
+{
+	const int SIZE = 33;
+	NOISE_DATATYPE Values[SIZE * SIZE * SIZE];
+	
+	// Various seeds, coord ranges (including negative ones) and frequencies, so that the cells get all kinds of sizes and moves:
+	const int Seeds[] = {0, 1, -5, 123456789};
+	const NOISE_DATATYPE Ranges[][2] =
+	{
+		{0, 1},
+		{-3.5f, 2.25f},
+		{-100.1f, -60},
+		{1000, 1040},
+		{-4, 28},
+	} ;
+	for (size_t s = 0; s < ARRAYCOUNT(Seeds); s++)
+	{
+		cCubicNoise Cubic(Seeds[s]);
+		cPerlinNoise Perlin(Seeds[s]);
+		Perlin.AddOctave(1, 1);
+		Perlin.AddOctave((NOISE_DATATYPE)2.1, (NOISE_DATATYPE)0.5);
+		Perlin.AddOctave((NOISE_DATATYPE)4.3, (NOISE_DATATYPE)0.27);
+		for (size_t r = 0; r < ARRAYCOUNT(Ranges); r++)
+		{
+			NOISE_DATATYPE Start = Ranges[r][0], End = Ranges[r][1];
+			
+			Cubic.Generate2D(Values, SIZE, 17, Start, End, End, End + 3);
+			a_Values.insert(a_Values.end(), Values, Values + SIZE * 17);
+			Cubic.Generate3D(Values, 17, SIZE, 5, Start, End, Start / 2, End, -End, -Start);
+			a_Values.insert(a_Values.end(), Values, Values + 17 * SIZE * 5);
+			
+			// cPerlinNoise::Generate2D() scales the previous contents of the output array, initialize it:
+			std::fill(Values, Values + SIZE * SIZE, (NOISE_DATATYPE)0.5);
+			Perlin.Generate2D(Values, SIZE, SIZE, Start, End, -End, -Start);
+			a_Values.insert(a_Values.end(), Values, Values + SIZE * SIZE);
+			Perlin.Generate3D(Values, SIZE, SIZE, SIZE, Start, End, Start * 2, End * 2, End, End + 7);
+			a_Values.insert(a_Values.end(), Values, Values + SIZE * SIZE * SIZE);
+		}  // for r - Ranges[]
+	}  // for s - Seeds[]
+}
+
+
+
+
+
+/// Checks that all the supported cNoiseKernels implementations produce output bit-identical to the scalar one. Returns the number of failed implementations.
+int TestKernelsIdentical(void)
+{
+	cNoiseKernels::eImpl OrigImpl = cNoiseKernels::GetImpl();
+	cNoiseKernels::SetImpl(cNoiseKernels::implScalar);
+	std::vector<NOISE_DATATYPE> Reference;
+	GenerateKernelTestValues(Reference);
+	
+	int NumFailed = 0;
+	const cNoiseKernels::eImpl Impls[] = {cNoiseKernels::implSSE2, cNoiseKernels::implAVX2};
+	for (size_t i = 0; i < ARRAYCOUNT(Impls); i++)
+	{
+		const char * Name = cNoiseKernels::GetImplName(Impls[i]);
+		if (!cNoiseKernels::SetImpl(Impls[i]))
+		{
+			LOG("Noise kernels %s: not supported, skipped", Name);
+			continue;
+		}
+		std::vector<NOISE_DATATYPE> Values;
+		GenerateKernelTestValues(Values);
+		if ((Values.size() != Reference.size()) || (memcmp(&Values[0], &Reference[0], Values.size() * sizeof(NOISE_DATATYPE)) != 0))
+		{
+			LOGERROR("Noise kernels %s: output differs from the scalar implementation!", Name);
+			NumFailed += 1;
+			continue;
+		}
+		LOG("Noise kernels %s: " SIZE_T_FMT " values identical to the scalar implementation", Name, Values.size());
+	}
+	
+	// Speed test of each supported implementation:
+	const cNoiseKernels::eImpl AllImpls[] = {cNoiseKernels::implScalar, cNoiseKernels::implSSE2, cNoiseKernels::implAVX2};
+	for (size_t i = 0; i < ARRAYCOUNT(AllImpls); i++)
+	{
+		if (!cNoiseKernels::SetImpl(AllImpls[i]))
+		{
+			continue;
+		}
+		LOG("Using the %s noise kernels:", cNoiseKernels::GetImplName(AllImpls[i]));
+		TestCubicNoise();
+	}
+	
+	cNoiseKernels::SetImpl(OrigImpl);
+	return NumFailed;
+}
+
+
+
+
+
 int main(int argc, char * argv[])
 {
 	new cMCLogger();  // Create a logger (will set itself as the main instance
 	
+	int NumKernelsFailed = TestKernelsIdentical();
+	
 	clock_t NewTicks = TestCubicNoise();
 	clock_t OldTicks = TestOldNoise();
 	LOG("New method is %.02fx faster", (double)OldTicks / NewTicks);
+	if (NumKernelsFailed > 0)
+	{
+		LOGERROR("%d noise kernel implementation(s) FAILED the bit-identity test", NumKernelsFailed);
+	}
 	LOG("Press Enter to quit program");
 	getchar();
+	return (NumKernelsFailed > 0) ? 1 : 0;
 }
@@ -0,0 +1,250 @@
+// RedstoneBenchmark.cpp
+
+// Implements the main app entrypoint of the redstone power table stress benchmark
+
+/*
+Replays the power-table operations that cIncrementalRedstoneSimulator performs for two stress scenarios, and measures
+the time per tick, both for the linear vectors the simulator used to use and for the indexed cRedstonePowerTable:
+	- long wires: every wire block is queried for power and powers its neighbors in each tick
+	- clocks: short wire segments driven by clocks that toggle every few ticks, unpowering and repowering the segment
+The contraption size is doubled in each step, so that the scaling is visible.
+*/
+
+#include "Globals.h"
+#include <time.h>
+#include "Simulator/RedstonePowerTable.h"
+
+
+
+
+
+/// Number of ticks simulated in each measurement
+static const int NUM_TICKS = 20;
+
+/// Length of each clocked wire segment
+static const int CLOCK_SEGMENT_LENGTH = 15;
+
+/// Number of ticks between the clock toggles
+static const int CLOCK_PERIOD = 4;
+
+
+
+
+
+/** The power list as used by the simulator before the indexing: a vector scanned linearly for every operation */
+class cVectorPowerTable
+{
+public:
+	bool HasBlock(int a_BlockX, int a_BlockY, int a_BlockZ) const
+	{
+		for (cEntries::const_iterator itr = m_Entries.begin(); itr != m_Entries.end(); ++itr)
+		{
+			if (itr->a_BlockPos.Equals(Vector3i(a_BlockX, a_BlockY, a_BlockZ)))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	
+	bool Add(const Vector3i & a_BlockPos, const Vector3i & a_MiddlePos, const Vector3i & a_SourcePos)
+	{
+		for (cEntries::const_iterator itr = m_Entries.begin(); itr != m_Entries.end(); ++itr)
+		{
+			if (itr->a_BlockPos.Equals(a_BlockPos) && itr->a_MiddlePos.Equals(a_MiddlePos) && itr->a_SourcePos.Equals(a_SourcePos))
+			{
+				return false;
+			}
+		}
+		cRedstonePowerTable::sEntry Entry;
+		Entry.a_BlockPos = a_BlockPos;
+		Entry.a_MiddlePos = a_MiddlePos;
+		Entry.a_SourcePos = a_SourcePos;
+		m_Entries.push_back(Entry);
+		return true;
+	}
+	
+	int EraseBySource(const Vector3i & a_SourcePos)
+	{
+		int NumErased = 0;
+		for (cEntries::iterator itr = m_Entries.begin(); itr != m_Entries.end();)
+		{
+			if (itr->a_SourcePos.Equals(a_SourcePos))
+			{
+				itr = m_Entries.erase(itr);
+				NumErased += 1;
+				continue;
+			}
+			++itr;
+		}
+		return NumErased;
+	}
+	
+	size_t size(void) const { return m_Entries.size(); }
+	
+protected:
+	typedef std::vector<cRedstonePowerTable::sEntry> cEntries;
+	cEntries m_Entries;
+} ;
+
+
+
+
+
+/** Returns the position of the specified block of a wire; the wires snake through the chunk, 16 blocks per row, 16 rows per layer */
+static Vector3i WirePos(int a_Index)
+{
+	return Vector3i(a_Index % 16, 10 + a_Index / 256, (a_Index / 16) % 16);
+}
+
+
+
+
+
+/** Powers the block after the specified wire block, the way HandleRedstoneWire() does for a powered wire */
+template <class TABLE>
+static void PowerNext(TABLE & a_Table, int a_Index, int a_Length)
+{
+	Vector3i Pos = WirePos(a_Index);
+	if (a_Index + 1 < a_Length)
+	{
+		a_Table.Add(WirePos(a_Index + 1), Pos, Pos);
+	}
+	// The wire also powers the block below it:
+	a_Table.Add(Vector3i(Pos.x, Pos.y - 1, Pos.z), Pos, Pos);
+}
+
+
+
+
+
+/** Simulates a_NumTicks ticks of a single long wire of a_Length blocks; returns the number of powered blocks found */
+template <class TABLE>
+static int TickLongWire(TABLE & a_Table, int a_Length, int a_NumTicks)
+{
+	int NumPowered = 0;
+	for (int Tick = 0; Tick < a_NumTicks; Tick++)
+	{
+		for (int i = 0; i < a_Length; i++)
+		{
+			Vector3i Pos = WirePos(i);
+			if ((i == 0) || a_Table.HasBlock(Pos.x, Pos.y, Pos.z))
+			{
+				NumPowered += 1;
+				PowerNext(a_Table, i, a_Length);
+			}
+		}
+	}
+	return NumPowered;
+}
+
+
+
+
+
+/** Simulates a_NumTicks ticks of a_Length blocks of wire split into clocked segments; returns the number of powered blocks found */
+template <class TABLE>
+static int TickClocks(TABLE & a_Table, int a_Length, int a_NumTicks)
+{
+	int NumPowered = 0;
+	for (int Tick = 0; Tick < a_NumTicks; Tick++)
+	{
+		bool IsClockOn = (((Tick / CLOCK_PERIOD) % 2) == 0);
+		bool HasToggled = ((Tick % CLOCK_PERIOD) == 0);
+		for (int i = 0; i < a_Length; i++)
+		{
+			bool IsClock = ((i % CLOCK_SEGMENT_LENGTH) == 0);
+			if (HasToggled && !IsClockOn)
+			{
+				// The clock and the whole segment goes off, the simulator's AddBlock() removes everything they powered:
+				a_Table.EraseBySource(WirePos(i));
+				continue;
+			}
+			Vector3i Pos = WirePos(i);
+			if ((IsClock && IsClockOn) || (!IsClock && a_Table.HasBlock(Pos.x, Pos.y, Pos.z)))
+			{
+				NumPowered += 1;
+				if ((i + 1) % CLOCK_SEGMENT_LENGTH != 0)
+				{
+					PowerNext(a_Table, i, a_Length);
+				}
+			}
+		}
+	}
+	return NumPowered;
+}
+
+
+
+
+
+/** Returns the current time, in microseconds */
+static double GetTimeUsec(void)
+{
+	return (double)clock() * 1000000.0 / CLOCKS_PER_SEC;
+}
+
+
+
+
+
+template <class TABLE>
+static double MeasureLongWire(int a_Length, int & a_NumPowered)
+{
+	TABLE Table;
+	double Start = GetTimeUsec();
+	a_NumPowered = TickLongWire(Table, a_Length, NUM_TICKS);
+	return (GetTimeUsec() - Start) / NUM_TICKS;
+}
+
+
+
+
+
+template <class TABLE>
+static double MeasureClocks(int a_Length, int & a_NumPowered)
+{
+	TABLE Table;
+	double Start = GetTimeUsec();
+	a_NumPowered = TickClocks(Table, a_Length, NUM_TICKS);
+	return (GetTimeUsec() - Start) / NUM_TICKS;
+}
+
+
+
+
+
+int main(int argc, char * argv[])
+{
+	printf("Redstone power table benchmark, time per tick in microseconds\n");
+	printf("%-12s %8s %12s %12s %12s %12s\n", "scenario", "blocks", "vector", "indexed", "speedup", "powered");
+	for (int Length = 64; Length <= 4096; Length *= 2)
+	{
+		int NumPoweredVector, NumPoweredIndexed;
+		double Vector = MeasureLongWire<cVectorPowerTable>(Length, NumPoweredVector);
+		double Indexed = MeasureLongWire<cRedstonePowerTable>(Length, NumPoweredIndexed);
+		if (NumPoweredVector != NumPoweredIndexed)
+		{
+			printf("Long wire of %d blocks: MISMATCH, vector powered %d, indexed powered %d\n", Length, NumPoweredVector, NumPoweredIndexed);
+			return 1;
+		}
+		printf("%-12s %8d %12.1f %12.1f %11.1fx %12d\n", "long wire", Length, Vector, Indexed, Vector / std::max(Indexed, 0.1), NumPoweredIndexed);
+	}
+	for (int Length = 64; Length <= 4096; Length *= 2)
+	{
+		int NumPoweredVector, NumPoweredIndexed;
+		double Vector = MeasureClocks<cVectorPowerTable>(Length, NumPoweredVector);
+		double Indexed = MeasureClocks<cRedstonePowerTable>(Length, NumPoweredIndexed);
+		if (NumPoweredVector != NumPoweredIndexed)
+		{
+			printf("Clocks on %d blocks: MISMATCH, vector powered %d, indexed powered %d\n", Length, NumPoweredVector, NumPoweredIndexed);
+			return 1;
+		}
+		printf("%-12s %8d %12.1f %12.1f %11.1fx %12d\n", "clocks", Length, Vector, Indexed, Vector / std::max(Indexed, 0.1), NumPoweredIndexed);
+	}
+	return 0;
+}
+
+
+
+